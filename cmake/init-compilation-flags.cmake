@@ -32,6 +32,15 @@ cmake_print_variables(ADDRESS_SANITIZER UNDEFINED_SANITIZER)
 option(KPHP_TESTS "Build the tests" ON)
 cmake_print_variables(KPHP_TESTS)
 
+option(KPHP_BENCHMARKS "Build the runtime benchmarks" OFF)
+cmake_print_variables(KPHP_BENCHMARKS)
+
+option(KPHP_ARRAY_COMPACT_MAP "Store array maps as dense entries with a separate open-addressed index" OFF)
+if(KPHP_ARRAY_COMPACT_MAP)
+    add_definitions(-DKPHP_ARRAY_COMPACT_MAP)
+endif()
+cmake_print_variables(KPHP_ARRAY_COMPACT_MAP)
+
 if(NOT CMAKE_BUILD_TYPE AND NOT CMAKE_CONFIGURATION_TYPES)
     message(STATUS "Setting build type to `${DEFAULT_BUILD_TYPE}` as none was specified.")
     set(CMAKE_BUILD_TYPE ${DEFAULT_BUILD_TYPE} CACHE STRING "Build type (default ${DEFAULT_BUILD_TYPE})" FORCE)
@@ -16,9 +16,15 @@ prepend(POPULAR_COMMON_SOURCES ${COMMON_DIR}/
         crc32c.cpp
         options.cpp
         kernel-version.cpp
+        numa.cpp
+        huge-pages.cpp
         secure-bzero.cpp
         crc32_${HOST}.cpp
         crc32c_${HOST}.cpp
+        string-kernels.cpp
+        string-kernels_${HOST}.cpp
+        vector-kernels.cpp
+        vector-kernels_${HOST}.cpp
         parallel/counter.cpp
         parallel/maximum.cpp
         parallel/thread-id.cpp
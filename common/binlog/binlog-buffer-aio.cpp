@@ -8,7 +8,11 @@
 #include <fcntl.h>
 #include <float.h>
 #include <malloc.h>
+#include <string.h>
 #include <unistd.h>
+#include <deque>
+#include <future>
+#include <memory>
 
 #include "common/kprintf.h"
 #include "common/precise-time.h"
@@ -21,6 +25,88 @@ DECLARE_VERBOSITY(binlog_buffers);
 
 /******************** reading local replica ********************/
 
+/* the kernel reads that much of the binlog in the background, while the read part is decrypted and replayed */
+#define BINLOG_READ_AHEAD_BYTES (32 << 20)
+
+static void local_replica_advise_sequential (kfs_file_handle_t Binlog) {
+  if (!(Binlog->info->flags & KFS_FILE_ZIPPED)) {
+    posix_fadvise (Binlog->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+}
+
+static void local_replica_read_ahead (kfs_file_handle_t Binlog, long long file_offset) {
+  int err = posix_fadvise (Binlog->fd, file_offset, BINLOG_READ_AHEAD_BYTES, POSIX_FADV_WILLNEED);
+  if (err) {
+    tvkprintf (binlog_buffers, 3, "posix_fadvise for binlog '%s' failed: %s\n", Binlog->info->filename, strerror (err));
+  }
+}
+
+/* the next chunks of a zipped binlog are decoded by other threads, while the current one is replayed */
+#define BINLOG_ZIP_PREFETCH_CHUNKS 2
+
+struct bz_prefetched_chunk {
+  kfs_file_handle_t binlog;
+  int chunk_no;
+  int res;
+  int len;
+  std::unique_ptr<char[]> data;
+  std::future<void> decoded;
+};
+
+static std::deque<std::unique_ptr<bz_prefetched_chunk>> bz_prefetch_queue;
+
+static void bz_prefetch_schedule (kfs_file_handle_t Binlog, int chunk_no) {
+  auto chunk = std::make_unique<bz_prefetched_chunk>();
+  chunk->binlog = Binlog;
+  chunk->chunk_no = chunk_no;
+  chunk->res = -1;
+  chunk->len = KFS_BINLOG_ZIP_CHUNK_SIZE;
+  chunk->data.reset(new char[KFS_BINLOG_ZIP_CHUNK_SIZE]);
+  bz_prefetched_chunk *C = chunk.get();
+  chunk->decoded = std::async (std::launch::async, [C] {
+    C->res = kfs_bz_decode_chunk (C->binlog, C->chunk_no, C->data.get(), &C->len);
+  });
+  bz_prefetch_queue.emplace_back (std::move (chunk));
+}
+
+/* returns the decoded chunk, the chunks before it and the chunks of the other binlogs are dropped */
+static std::unique_ptr<bz_prefetched_chunk> bz_prefetch_take (kfs_file_handle_t Binlog, int chunk_no) {
+  std::unique_ptr<bz_prefetched_chunk> chunk;
+  while (!bz_prefetch_queue.empty()) {
+    chunk = std::move (bz_prefetch_queue.front());
+    bz_prefetch_queue.pop_front();
+    chunk->decoded.wait();
+    if (chunk->binlog == Binlog && chunk->chunk_no == chunk_no) {
+      break;
+    }
+    chunk.reset();
+  }
+  if (!chunk) {
+    bz_prefetch_schedule (Binlog, chunk_no);
+    chunk = std::move (bz_prefetch_queue.back());
+    bz_prefetch_queue.pop_back();
+    chunk->decoded.wait();
+  }
+
+  const int chunks = kfs_bz_get_chunks_no (kfs_get_binlog_zip_header (Binlog->info)->orig_file_size);
+  int next_chunk_no = bz_prefetch_queue.empty() ? chunk_no + 1 : bz_prefetch_queue.back()->chunk_no + 1;
+  while (bz_prefetch_queue.size() < BINLOG_ZIP_PREFETCH_CHUNKS && next_chunk_no < chunks) {
+    bz_prefetch_schedule (Binlog, next_chunk_no++);
+  }
+  return chunk;
+}
+
+void bb_local_replica_forget_binlog (kfs_file_handle_t Binlog) {
+  for (auto it = bz_prefetch_queue.begin(); it != bz_prefetch_queue.end();) {
+    if ((*it)->binlog == Binlog) {
+      (*it)->decoded.wait();
+      it = bz_prefetch_queue.erase (it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 static void bbw_local_replica_seek (bb_writer_t *W, bb_rotation_point_t *P) {
   struct kfs_replica *R = W->buffer->replica;
   assert (R);
@@ -33,6 +119,7 @@ static void bbw_local_replica_seek (bb_writer_t *W, bb_rotation_point_t *P) {
   tvkprintf (binlog_buffers, 2, "%s: binlog '%s' was opened from position %lld.\n", __func__, P->Binlog->info->filename, P->log_pos);
   bb_buffer_set_current_binlog (W->buffer, P);
   P->log_slice_start_pos = P->Binlog->info->log_pos;
+  local_replica_advise_sequential (P->Binlog);
   if (P->Binlog->info->file_hash) {
     W->buffer->cur_binlog_file_hash = P->Binlog->info->file_hash;
   }
@@ -76,6 +163,7 @@ static int bbw_local_replica_rotate (bb_writer_t *W, bb_rotation_point_t *P) {
 
   bb_buffer_set_current_binlog (W->buffer, P);
   P->log_slice_start_pos = P->Binlog->info->log_pos;
+  local_replica_advise_sequential (P->Binlog);
 
   if (verbosity > 0) {
     kprintf ("switched from binlog file %s to %s at position %lld\n", Binlog->info->filename, P->Binlog->info->filename, P->log_pos);
@@ -128,16 +216,30 @@ static int bbw_local_replica_try_read (bb_writer_t *W, int len) {
   int r;
   const long long offset = B->log_last_wpos - P->log_slice_start_pos;
   if (P->Binlog->info->flags & KFS_FILE_ZIPPED) {
-    r = 0x1000000;
-    auto a = static_cast<char*>(malloc (r));
-    assert (a);
-    if (kfs_bz_decode (P->Binlog, offset, a, &r, NULL) < 0) {
-      print_backtrace();
-      exit (1);
+    const kfs_binlog_zip_header_t *H = kfs_get_binlog_zip_header (P->Binlog->info);
+    if (offset < 0 || offset >= H->orig_file_size) {
+      r = KFS_BINLOG_ZIP_CHUNK_SIZE;
+      auto a = static_cast<char*>(malloc (r));
+      assert (a);
+      if (kfs_bz_decode (P->Binlog, offset, a, &r, NULL) < 0) {
+        print_backtrace();
+        exit (1);
+      }
+      rwm_trunc (&B->raw, B->log_last_wpos - B->log_last_rpos);
+      bb_buffer_push_data (B, a, r);
+      free (a);
+    } else {
+      std::unique_ptr<bz_prefetched_chunk> chunk = bz_prefetch_take (P->Binlog, static_cast<int>(offset >> KFS_BINLOG_ZIP_CHUNK_SIZE_EXP));
+      if (chunk->res < 0) {
+        print_backtrace();
+        exit (1);
+      }
+      const int o = static_cast<int>(offset & (KFS_BINLOG_ZIP_CHUNK_SIZE - 1));
+      assert (o < chunk->len);
+      r = chunk->len - o;
+      rwm_trunc (&B->raw, B->log_last_wpos - B->log_last_rpos);
+      bb_buffer_push_data (B, chunk->data.get() + o, r);
     }
-    rwm_trunc (&B->raw, B->log_last_wpos - B->log_last_rpos);
-    bb_buffer_push_data (B, a, r);
-    free (a);
   } else {
     int alloc_bytes = bb_buffer_get_max_alloc_bytes (B);
     bb_buffer_push_data (B, 0, alloc_bytes);
@@ -150,6 +252,9 @@ static int bbw_local_replica_try_read (bb_writer_t *W, int len) {
       assert(0);
     }
     r = t;
+    if (r > 0) {
+      local_replica_read_ahead (P->Binlog, offset + P->Binlog->offset + r);
+    }
     if (verbosity >= 1) {
       int lvl = (r > 0) ? 1 : 3;
       vkprintf (lvl, "read %d bytes from binlog %s\n", r, P->Binlog->info->filename);
@@ -21,6 +21,7 @@ void bb_rotation_point_close_binlog (bb_rotation_point_t *p) {
     if (fsync(p->Binlog->fd) < 0) {
       kprintf ("error syncing binlog: %m\n");
     }
+    bb_local_replica_forget_binlog (p->Binlog);
     close_binlog (p->Binlog, true);
     p->Binlog = NULL;
   }
@@ -141,6 +141,7 @@ struct bb_buffer {
 
 void bb_buffer_set_writer(bb_buffer_t *B, bb_writer_t *W);
 int bb_buffer_set_reader(bb_buffer_t *B, bb_reader_t *R);
+/* log_pos, timestamp and log_crc32 are the state saved with the snapshot, the reading starts right at log_pos */
 void bb_buffer_seek(bb_buffer_t *B, long long log_pos, int timestamp, unsigned log_crc32);
 int bb_buffer_replay_log(bb_buffer_t *B, int set_now);
 int bb_buffer_work(bb_buffer_t *B);
@@ -157,6 +158,8 @@ int bb_reader_init(bb_reader_t *R, bb_reader_type_t *type);
 int bb_writer_init(bb_writer_t *W, bb_writer_type_t *type);
 
 extern bb_writer_type_t bbw_local_replica_functions;
+/* waits for the prefetched chunks of the zipped binlog, must be called before the binlog is closed */
+void bb_local_replica_forget_binlog (kfs_file_handle_t Binlog);
 
 void bb_buffer_push_data (bb_buffer_t *B, void *data, int size) ;
 void bb_buffer_set_current_binlog (bb_buffer_t *B, bb_rotation_point_t *P) ;
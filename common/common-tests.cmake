@@ -12,8 +12,11 @@ prepend(COMMON_TESTS_SOURCES ${COMMON_DIR}/
         parallel/counter-test.cpp
         parallel/limit-counter-test.cpp
         parallel/maximum-test.cpp
+        precise-time-test.cpp
         smart_iterators/smart-iterators-test.cpp
         smart_ptrs/tagged-ptr-test.cpp
+        string-kernels-test.cpp
+        vector-kernels-test.cpp
         type_traits/list_of_types_test.cpp
         wrappers/span-test.cpp
         wrappers/string_view-test.cpp)
@@ -17,6 +17,7 @@ prepend(COMMON_MAIN_SOURCES ${COMMON_DIR}/
         crypto/aes256-${HOST}.cpp
 
         fast-backtrace.cpp
+        fiber-context.cpp
         string-processing.cpp
         kphp-tasks-lease/lease-worker-mode.cpp)
 
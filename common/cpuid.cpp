@@ -14,8 +14,22 @@ const kdb_cpuid_t *kdb_cpuid() {
     assert(cached.type == KDB_CPUID_X86_64);
     return &cached;
   }
-  int a;
+  int a, b, c, d;
+  asm volatile("cpuid\n\t" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(0));
+  const int max_leaf = a;
   asm volatile("cpuid\n\t" : "=a"(a), "=b"(cached.x86_64.ebx), "=c"(cached.x86_64.ecx), "=d"(cached.x86_64.edx) : "0"(1));
+  cached.x86_64.ext_ebx = 0;
+  if (max_leaf >= 7) {
+    asm volatile("cpuid\n\t" : "=a"(a), "=b"(cached.x86_64.ext_ebx), "=c"(c), "=d"(d) : "0"(7), "2"(0));
+  }
+  cached.x86_64.os_ymm_enabled = false;
+  // osxsave
+  if (cached.x86_64.ecx & (1 << 27)) {
+    unsigned int xcr0_lo, xcr0_hi;
+    asm volatile("xgetbv\n\t" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    // both xmm and ymm states
+    cached.x86_64.os_ymm_enabled = (xcr0_lo & 6) == 6;
+  }
   cached.type = KDB_CPUID_X86_64;
 #elif defined(__aarch64__)
   if (cached.type) {
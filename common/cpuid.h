@@ -13,6 +13,10 @@ typedef struct {
   union {
     struct {
       int ebx, ecx, edx;
+      // ebx of the structured extended feature flags leaf (eax = 7, ecx = 0), zero if the leaf isn't supported
+      int ext_ebx;
+      // ymm registers state is enabled by os (checked via xgetbv)
+      bool os_ymm_enabled;
     } x86_64;
   };
 } kdb_cpuid_t;
@@ -305,6 +305,33 @@ TEST(crypto_x86_64_aesni256_set_decrypt_key, basic) {
   }
 }
 
+TEST(crypto_x86_64_aesni256_cbc_decrypt, in_place_matches_generic) {
+  if (crypto_x86_64_has_aesni_extension()) {
+    std::array<std::uint8_t, 32> key;
+    std::iota(key.begin(), key.end(), 0);
+    // 4-block batches and a tail
+    std::array<std::uint8_t, 16 * 23> payload;
+    std::iota(payload.begin(), payload.end(), 7);
+    std::array<std::uint8_t, 16> iv;
+    std::iota(iv.begin(), iv.end(), 42);
+
+    vk_aes_ctx_t ctx;
+    crypto_generic_aes256_set_encrypt_key(&ctx, key.data());
+    std::array<std::uint8_t, 16> encrypt_iv = iv;
+    std::array<std::uint8_t, payload.size()> ciphertext;
+    crypto_generic_aes256_cbc_encrypt(&ctx, payload.data(), ciphertext.data(), ciphertext.size(), encrypt_iv.data());
+
+    crypto_x86_64_aesni256_set_decrypt_key(&ctx, key.data());
+    std::array<std::uint8_t, 16> decrypt_iv = iv;
+    std::array<std::uint8_t, payload.size()> plaintext = ciphertext;
+    // in two calls, to check that the iv is carried over
+    crypto_x86_64_aesni256_cbc_decrypt(&ctx, plaintext.data(), plaintext.data(), 16 * 9, decrypt_iv.data());
+    crypto_x86_64_aesni256_cbc_decrypt(&ctx, plaintext.data() + 16 * 9, plaintext.data() + 16 * 9, plaintext.size() - 16 * 9, decrypt_iv.data());
+    EXPECT_EQ(plaintext, payload);
+    EXPECT_EQ(decrypt_iv, encrypt_iv);
+  }
+}
+
 #endif // __x86_64__
 
 #ifdef __aarch64__
@@ -158,40 +158,117 @@ void crypto_x86_64_aesni256_cbc_encrypt(vk_aes_ctx_t *vk_ctx, const uint8_t *in,
 
 void crypto_x86_64_aesni256_cbc_decrypt(vk_aes_ctx_t *vk_ctx, const uint8_t *in, uint8_t *out, int size, uint8_t iv[16]) {
   aes256_ctx_t *ctx = &vk_ctx->u.ctx;
-  void *p1, *p2;
   if (size < 16) {
     return;
   }
-  asm volatile("movdqu (%5), %%xmm1\n\t"          // move IV in %xmm1
-               "1:\n\t"                           // start of block processing
-               "subl $0x10, %3\n\t"               // decrease plaintext size on block size
-               "movdqu (%4), %%xmm2\n\t"          // move block of cyphertext to %xmm2
-               "pxor 0xe0(%6), %%xmm2\n\t"        // AddRoundKey
-               "aesdec 0xd0(%6), %%xmm2\n\t"      // 1 round
-               "aesdec 0xc0(%6), %%xmm2\n\t"      // 2 round
-               "aesdec 0xb0(%6), %%xmm2\n\t"      // 3 round
-               "aesdec 0xa0(%6), %%xmm2\n\t"      // ...
-               "aesdec 0x90(%6), %%xmm2\n\t"      // ...
-               "aesdec 0x80(%6), %%xmm2\n\t"      // ...
-               "aesdec 0x70(%6), %%xmm2\n\t"      // ..
-               "aesdec 0x60(%6), %%xmm2\n\t"      // ..
-               "aesdec 0x50(%6), %%xmm2\n\t"      // ..
-               "aesdec 0x40(%6), %%xmm2\n\t"      // ..
-               "aesdec 0x30(%6), %%xmm2\n\t"      // ...
-               "aesdec 0x20(%6), %%xmm2\n\t"      // ...
-               "aesdec 0x10(%6), %%xmm2\n\t"      // ...
-               "aesdeclast 0x00(%6), %%xmm2\n\t"  // 14 round is last for 256 bits key
-               "pxor %%xmm1, %%xmm2\n\t"          // CBC xor
-               "movdqu (%4), %%xmm1\n\t"          // move next block of cyphertext to %xmm1
-               "movdqu %%xmm2, (%7)\n\t"          // move block on plaintext to out
-               "addq $0x10, %4\n\t"               // advance in pointer on block size
-               "addq $0x10, %7\n\t"               // advance out pointer on block size
-               "cmpl $0x0f, %3\n\t"               // do we have more blocks of cyphertext?
-               "jg 1b\n\t"                        // if yes - jump to start of block processing
-               "movdqu %%xmm1, (%5)\n\t"          // move block of cyphertext to IV
-               : "=r"(size), "=r"(p1), "=r"(p2)
-               : "0"(size), "1r"(in), "r"(iv), "r"(align16(ctx)), "2r"(out)
-               : "%xmm1", "%xmm2", "memory");
+  const char *a = static_cast<const char *>(align16(ctx));
+  v16qi X = loaddqu((const char *)iv);
+  // unlike encryption, the blocks are decrypted independently, so four of them are pipelined through the AES unit;
+  // all the four blocks of cyphertext are loaded before the plaintext is stored, as in and out may be the same
+  while (size >= 64) {
+    const v16qi I0 = loaddqu((const char *)in);
+    const v16qi I1 = loaddqu((const char *)in + 16);
+    const v16qi I2 = loaddqu((const char *)in + 32);
+    const v16qi I3 = loaddqu((const char *)in + 48);
+    v16qi O0 = I0, O1 = I1, O2 = I2, O3 = I3;
+    asm("pxor 0xe0(%4), %0\n\t"
+        "pxor 0xe0(%4), %1\n\t"
+        "pxor 0xe0(%4), %2\n\t"
+        "pxor 0xe0(%4), %3\n\t"
+        "aesdec 0xd0(%4), %0\n\t"
+        "aesdec 0xd0(%4), %1\n\t"
+        "aesdec 0xd0(%4), %2\n\t"
+        "aesdec 0xd0(%4), %3\n\t"
+        "aesdec 0xc0(%4), %0\n\t"
+        "aesdec 0xc0(%4), %1\n\t"
+        "aesdec 0xc0(%4), %2\n\t"
+        "aesdec 0xc0(%4), %3\n\t"
+        "aesdec 0xb0(%4), %0\n\t"
+        "aesdec 0xb0(%4), %1\n\t"
+        "aesdec 0xb0(%4), %2\n\t"
+        "aesdec 0xb0(%4), %3\n\t"
+        "aesdec 0xa0(%4), %0\n\t"
+        "aesdec 0xa0(%4), %1\n\t"
+        "aesdec 0xa0(%4), %2\n\t"
+        "aesdec 0xa0(%4), %3\n\t"
+        "aesdec 0x90(%4), %0\n\t"
+        "aesdec 0x90(%4), %1\n\t"
+        "aesdec 0x90(%4), %2\n\t"
+        "aesdec 0x90(%4), %3\n\t"
+        "aesdec 0x80(%4), %0\n\t"
+        "aesdec 0x80(%4), %1\n\t"
+        "aesdec 0x80(%4), %2\n\t"
+        "aesdec 0x80(%4), %3\n\t"
+        "aesdec 0x70(%4), %0\n\t"
+        "aesdec 0x70(%4), %1\n\t"
+        "aesdec 0x70(%4), %2\n\t"
+        "aesdec 0x70(%4), %3\n\t"
+        "aesdec 0x60(%4), %0\n\t"
+        "aesdec 0x60(%4), %1\n\t"
+        "aesdec 0x60(%4), %2\n\t"
+        "aesdec 0x60(%4), %3\n\t"
+        "aesdec 0x50(%4), %0\n\t"
+        "aesdec 0x50(%4), %1\n\t"
+        "aesdec 0x50(%4), %2\n\t"
+        "aesdec 0x50(%4), %3\n\t"
+        "aesdec 0x40(%4), %0\n\t"
+        "aesdec 0x40(%4), %1\n\t"
+        "aesdec 0x40(%4), %2\n\t"
+        "aesdec 0x40(%4), %3\n\t"
+        "aesdec 0x30(%4), %0\n\t"
+        "aesdec 0x30(%4), %1\n\t"
+        "aesdec 0x30(%4), %2\n\t"
+        "aesdec 0x30(%4), %3\n\t"
+        "aesdec 0x20(%4), %0\n\t"
+        "aesdec 0x20(%4), %1\n\t"
+        "aesdec 0x20(%4), %2\n\t"
+        "aesdec 0x20(%4), %3\n\t"
+        "aesdec 0x10(%4), %0\n\t"
+        "aesdec 0x10(%4), %1\n\t"
+        "aesdec 0x10(%4), %2\n\t"
+        "aesdec 0x10(%4), %3\n\t"
+        "aesdeclast 0x00(%4), %0\n\t"
+        "aesdeclast 0x00(%4), %1\n\t"
+        "aesdeclast 0x00(%4), %2\n\t"
+        "aesdeclast 0x00(%4), %3\n\t"
+        : "+x"(O0), "+x"(O1), "+x"(O2), "+x"(O3)
+        : "r"(a));
+    storedqu((char *)out, O0 ^ X);
+    storedqu((char *)out + 16, O1 ^ I0);
+    storedqu((char *)out + 32, O2 ^ I1);
+    storedqu((char *)out + 48, O3 ^ I2);
+    X = I3;
+    in += 64;
+    out += 64;
+    size -= 64;
+  }
+  while (size >= 16) {
+    const v16qi I = loaddqu((const char *)in);
+    v16qi O = I;
+    asm("pxor 0xe0(%1), %0\n\t"
+        "aesdec 0xd0(%1), %0\n\t"
+        "aesdec 0xc0(%1), %0\n\t"
+        "aesdec 0xb0(%1), %0\n\t"
+        "aesdec 0xa0(%1), %0\n\t"
+        "aesdec 0x90(%1), %0\n\t"
+        "aesdec 0x80(%1), %0\n\t"
+        "aesdec 0x70(%1), %0\n\t"
+        "aesdec 0x60(%1), %0\n\t"
+        "aesdec 0x50(%1), %0\n\t"
+        "aesdec 0x40(%1), %0\n\t"
+        "aesdec 0x30(%1), %0\n\t"
+        "aesdec 0x20(%1), %0\n\t"
+        "aesdec 0x10(%1), %0\n\t"
+        "aesdeclast 0x00(%1), %0\n\t"
+        : "+x"(O)
+        : "r"(a));
+    storedqu((char *)out, O ^ X);
+    X = I;
+    in += 16;
+    out += 16;
+    size -= 16;
+  }
+  storedqu((char *)iv, X);
 }
 
 void crypto_x86_64_aesni256_ige_encrypt(vk_aes_ctx_t *vk_ctx, const uint8_t *in, uint8_t *out, int size, uint8_t iv[32]) {
@@ -183,6 +183,24 @@ char *dl_pstr (char const *msg, ...) {
 }
 
 /** Memory and cpu stats **/
+static unsigned long long get_anon_huge_pages (pid_t pid) {
+  char path[64];
+  snprintf (path, sizeof (path), "/proc/%lu/smaps_rollup", (unsigned long)pid);
+  FILE *f = fopen (path, "r");
+  if (f == NULL) {
+    return 0;
+  }
+  char line[256];
+  unsigned long long anon_huge = 0;
+  while (fgets (line, sizeof (line), f)) {
+    if (sscanf (line, "AnonHugePages: %llu", &anon_huge) == 1) {
+      break;
+    }
+  }
+  fclose (f);
+  return anon_huge;
+}
+
 int get_mem_stats (pid_t pid, mem_info_t *info) {
 #define TMEM_SIZE 10000
   static char mem[TMEM_SIZE];
@@ -225,6 +243,9 @@ int get_mem_stats (pid_t pid, mem_info_t *info) {
     if (strncmp (st, "RssShmem", 8) == 0) {
       x = &info->rss_shmem;
     }
+    if (strncmp (st, "HugetlbPages", 12) == 0) {
+      x = &info->hugetlb;
+    }
     if (x != NULL) {
       while (st < s && *st != ' ' && *st != '\t') {
         st++;
@@ -242,6 +263,7 @@ int get_mem_stats (pid_t pid, mem_info_t *info) {
   }
 
   close (fd);
+  info->anon_huge = get_anon_huge_pages (pid);
   return 1;
 #undef TMEM_SIZE
 }
@@ -57,6 +57,8 @@ typedef struct {
   unsigned long long rss;
   unsigned long long rss_file;
   unsigned long long rss_shmem;
+  unsigned long long hugetlb;
+  unsigned long long anon_huge;
 } mem_info_t;
 
 int get_mem_stats (pid_t pid, mem_info_t *info);
@@ -0,0 +1,141 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/fiber-context.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+
+// the saved frame, from the lower address: mxcsr with x87 control word, r15, r14, r13, r12, rbx, rbp, return address
+asm(R"(
+  .text
+  .globl fiber_context_switch
+  .type fiber_context_switch, @function
+  .align 16
+fiber_context_switch:
+  pushq %rbp
+  pushq %rbx
+  pushq %r12
+  pushq %r13
+  pushq %r14
+  pushq %r15
+  subq $8, %rsp
+  stmxcsr (%rsp)
+  fnstcw 4(%rsp)
+  movq %rsp, (%rdi)
+  movq (%rsi), %rsp
+.Lfiber_context_restore:
+  ldmxcsr (%rsp)
+  fldcw 4(%rsp)
+  addq $8, %rsp
+  popq %r15
+  popq %r14
+  popq %r13
+  popq %r12
+  popq %rbx
+  popq %rbp
+  ret
+  .size fiber_context_switch, .-fiber_context_switch
+
+  .globl fiber_context_jump
+  .type fiber_context_jump, @function
+  .align 16
+fiber_context_jump:
+  movq (%rdi), %rsp
+  jmp .Lfiber_context_restore
+  .size fiber_context_jump, .-fiber_context_jump
+)");
+
+namespace {
+
+constexpr size_t FRAME_WORDS = 8;
+constexpr size_t RETURN_ADDRESS_WORD = 7;
+
+void init_frame_control_words(uint64_t *frame) noexcept {
+  uint32_t control_words[2]{0, 0};
+  asm volatile("stmxcsr %0\n\tfnstcw %1" : "=m"(control_words[0]), "=m"(control_words[1]));
+  memcpy(frame, control_words, sizeof(control_words));
+}
+
+} // namespace
+
+#elif defined(__aarch64__)
+
+// the saved frame, from the lower address: d8-d15, x19-x28, x29 (frame pointer), x30 (return address)
+asm(R"(
+  .text
+  .globl fiber_context_switch
+  .type fiber_context_switch, %function
+  .align 4
+fiber_context_switch:
+  sub sp, sp, #0xa0
+  stp d8, d9, [sp, #0x00]
+  stp d10, d11, [sp, #0x10]
+  stp d12, d13, [sp, #0x20]
+  stp d14, d15, [sp, #0x30]
+  stp x19, x20, [sp, #0x40]
+  stp x21, x22, [sp, #0x50]
+  stp x23, x24, [sp, #0x60]
+  stp x25, x26, [sp, #0x70]
+  stp x27, x28, [sp, #0x80]
+  stp x29, x30, [sp, #0x90]
+  mov x9, sp
+  str x9, [x0]
+  ldr x9, [x1]
+.Lfiber_context_restore:
+  mov sp, x9
+  ldp d8, d9, [sp, #0x00]
+  ldp d10, d11, [sp, #0x10]
+  ldp d12, d13, [sp, #0x20]
+  ldp d14, d15, [sp, #0x30]
+  ldp x19, x20, [sp, #0x40]
+  ldp x21, x22, [sp, #0x50]
+  ldp x23, x24, [sp, #0x60]
+  ldp x25, x26, [sp, #0x70]
+  ldp x27, x28, [sp, #0x80]
+  ldp x29, x30, [sp, #0x90]
+  add sp, sp, #0xa0
+  ret
+  .size fiber_context_switch, .-fiber_context_switch
+
+  .globl fiber_context_jump
+  .type fiber_context_jump, %function
+  .align 4
+fiber_context_jump:
+  ldr x9, [x0]
+  b .Lfiber_context_restore
+  .size fiber_context_jump, .-fiber_context_jump
+)");
+
+namespace {
+
+constexpr size_t FRAME_WORDS = 20;
+constexpr size_t RETURN_ADDRESS_WORD = 19;
+
+void init_frame_control_words(uint64_t *) noexcept {
+}
+
+} // namespace
+
+#else
+#error "fiber_context is not implemented for this architecture"
+#endif
+
+void fiber_context_make(fiber_context *ctx, void *stack, size_t stack_size, void (*entry)()) noexcept {
+  auto stack_top = reinterpret_cast<uintptr_t>(stack) + stack_size;
+  stack_top &= ~uintptr_t{15};
+  // entry() starts as if it was called: on x86_64 the stack pointer points to a (fake, zero) return address
+  // right under the aligned top, on aarch64 it is the aligned top itself; the frame pointer is zero in both cases
+#if defined(__x86_64__)
+  stack_top -= sizeof(uint64_t);
+  *reinterpret_cast<uint64_t *>(stack_top) = 0;
+#endif
+  auto *frame = reinterpret_cast<uint64_t *>(stack_top) - FRAME_WORDS;
+  memset(frame, 0, FRAME_WORDS * sizeof(uint64_t));
+  init_frame_control_words(frame);
+  frame[RETURN_ADDRESS_WORD] = reinterpret_cast<uint64_t>(entry);
+  ctx->sp = frame;
+}
@@ -0,0 +1,24 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+
+// A register-only context switch in the spirit of boost.context's fcontext.
+// Unlike swapcontext it saves only the callee-saved registers on the stack being left
+// and doesn't touch the signal mask, so a switch costs no syscalls.
+struct fiber_context {
+  void *sp{nullptr};
+};
+
+// prepares the context that starts entry() on the stack [stack, stack + stack_size); entry() must not return
+void fiber_context_make(fiber_context *ctx, void *stack, size_t stack_size, void (*entry)()) noexcept;
+
+extern "C" {
+// saves the current context into from and continues with to
+void fiber_context_switch(fiber_context *from, const fiber_context *to) noexcept;
+// continues with to, the current context is abandoned
+[[noreturn]] void fiber_context_jump(const fiber_context *to) noexcept;
+}
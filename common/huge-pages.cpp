@@ -0,0 +1,72 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/huge-pages.h"
+
+#include <cstring>
+#include <sys/mman.h>
+
+#include "common/kprintf.h"
+#include "common/numa.h"
+#include "common/wrappers/madvise.h"
+
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+
+namespace {
+
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+huge_pages_mode shared_memory_huge_pages = huge_pages_mode::off;
+
+} // namespace
+
+bool parse_huge_pages_mode(const char *name, huge_pages_mode *mode) noexcept {
+  if (!strcmp(name, "off")) {
+    *mode = huge_pages_mode::off;
+  } else if (!strcmp(name, "transparent")) {
+    *mode = huge_pages_mode::transparent;
+  } else if (!strcmp(name, "hugetlb")) {
+    *mode = huge_pages_mode::hugetlb;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void *mmap_anonymous_memory(size_t *size, int flags, huge_pages_mode mode, bool *is_hugetlb) noexcept {
+  if (is_hugetlb) {
+    *is_hugetlb = false;
+  }
+  if (mode == huge_pages_mode::hugetlb) {
+    const size_t aligned_size = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *memory = mmap(nullptr, aligned_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_HUGETLB | flags, -1, 0);
+    if (memory != MAP_FAILED) {
+      *size = aligned_size;
+      if (is_hugetlb) {
+        *is_hugetlb = true;
+      }
+      return memory;
+    }
+    kprintf("can't mmap %zu bytes of hugetlb pages, fall back to transparent huge pages: %m\n", aligned_size);
+  }
+  void *memory = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | flags, -1, 0);
+  if (memory != MAP_FAILED && mode != huge_pages_mode::off && our_madvise(memory, *size, MADV_HUGEPAGE) != 0) {
+    kprintf("madvise(MADV_HUGEPAGE) for %zu bytes failed: %m\n", *size);
+  }
+  return memory;
+}
+
+void set_shared_memory_huge_pages_mode(huge_pages_mode mode) noexcept {
+  shared_memory_huge_pages = mode;
+}
+
+void *mmap_shared_memory(size_t size) noexcept {
+  void *memory = mmap_anonymous_memory(&size, MAP_SHARED, shared_memory_huge_pages);
+  if (memory != MAP_FAILED) {
+    numa_place_shared_memory(memory, size);
+  }
+  return memory;
+}
@@ -0,0 +1,24 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+
+enum class huge_pages_mode {
+  off,
+  transparent, // madvise(MADV_HUGEPAGE), the kernel may or may not back the memory with huge pages
+  hugetlb,     // explicit pages from the hugetlbfs pool, falls back to transparent ones if the pool is empty
+};
+
+bool parse_huge_pages_mode(const char *name, huge_pages_mode *mode) noexcept;
+
+// mmaps anonymous memory (MAP_PRIVATE or MAP_SHARED in flags) with the huge pages mode;
+// for hugetlb the size is rounded up to the huge page size, it must be passed to munmap as is
+void *mmap_anonymous_memory(size_t *size, int flags, huge_pages_mode mode, bool *is_hugetlb = nullptr) noexcept;
+
+void set_shared_memory_huge_pages_mode(huge_pages_mode mode) noexcept;
+// mmaps a memory segment shared by the master and the workers, such as confdata or instance cache,
+// with the huge pages mode and the numa placement requested by the options
+void *mmap_shared_memory(size_t size) noexcept;
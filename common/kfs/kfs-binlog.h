@@ -9,6 +9,8 @@
 
 #include "common/kfs/kfs-typedefs.h"
 
+/* finds the binlog file by a binary search over the replica and positions the handle right at log_pos:
+   the plain binlogs are lseek'ed, the zipped ones are decoded starting from the chunk which contains log_pos */
 kfs_file_handle_t open_binlog(const kfs_replica_t *Replica, long long log_pos);
 kfs_file_handle_t next_binlog(kfs_file_handle_t log_handle);
 
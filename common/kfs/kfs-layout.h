@@ -38,7 +38,8 @@ enum kfs_file_type {
 typedef enum {
   kfs_bzf_zlib   = 0,
   kfs_bzf_bz2    = 1,
-  kfs_bzf_xz     = 2
+  kfs_bzf_xz     = 2,
+  kfs_bzf_zstd   = 3
 } kfs_bz_format_t;
 
 struct kfs_file_header {
@@ -505,6 +505,98 @@ static void free_decode_buffers() {
   }
 }
 
+/* decodes the whole chunk into dst, which has at least *dest_len bytes; src is the buffer for the encoded chunk;
+   the file position isn't used, so the chunks of the same file may be decoded by several threads */
+static int kfs_bz_decode_chunk_impl(const struct kfs_file *F, int chunk_no, unsigned char *src, void *dst, int *dest_len, int *disk_bytes_read) {
+  const struct kfs_file_info *FI = F->info;
+  const kfs_binlog_zip_header_t *H = kfs_get_binlog_zip_header(FI);
+  const int chunks = kfs_bz_get_chunks_no(H->orig_file_size);
+  assert (0 <= chunk_no && chunk_no < chunks);
+
+  const long long chunk_size = (chunk_no < chunks - 1
+                                ? H->chunk_offset[chunk_no + 1]
+                                : FI->file_size - sizeof(struct kfs_file_header) * FI->kfs_headers) - H->chunk_offset[chunk_no];
+  const long long chunk_offset = H->chunk_offset[chunk_no] + F->offset;
+  if (chunk_size <= 0) {
+    kprintf("not positive chunk size (%lld), broken header(?), file: %s\n, chunk: %d, chunk_offset: %lld\n",
+            chunk_size, FI->filename, chunk_no, chunk_offset);
+    return -1;
+  }
+  if (chunk_size > KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE) {
+    kprintf("chunk size (%lld) > KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE (%d), file: %s, chunk: %d, chunk_offset: %lld\n",
+            chunk_size, KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE, FI->filename, chunk_no, chunk_offset);
+    return -1;
+  }
+
+  const int expected_output_bytes = chunk_no == chunks - 1 ? (H->orig_file_size & (KFS_BINLOG_ZIP_CHUNK_SIZE - 1)) : KFS_BINLOG_ZIP_CHUNK_SIZE;
+  if (*dest_len < expected_output_bytes) {
+    *dest_len = 0;
+    return 0;
+  }
+
+  vkprintf(3, "chunk_no: %d, chunks: %d, chunk_size: %lld, chunk_off: %lld\n", chunk_no, chunks, chunk_size, chunk_offset);
+  ssize_t r = pread(F->fd, src, chunk_size, chunk_offset);
+  if (r < 0) {
+    kprintf("read chunk (%d), offset %lld of file '%s' failed. %m\n", chunk_no, chunk_offset, FI->filename);
+    return -1;
+  }
+  if (disk_bytes_read) {
+    *disk_bytes_read += r;
+  }
+  if (r != chunk_size) {
+    kprintf("read only %lld of expected %lld bytes, chunk (%d), offset %lld, file '%s'.\n",
+            (long long)r, chunk_size, chunk_no, chunk_offset, FI->filename);
+    return -1;
+  }
+  if (FI->iv) {
+    kfs_replica_handle_t R = FI->replica;
+    assert (R && R->ctx_crypto);
+    R->ctx_crypto->ctr_crypt(R->ctx_crypto, src, src, chunk_size, FI->iv, chunk_offset);
+  }
+  vkprintf(2, "read %lld bytes from the file '%s', chunk: %d.\n", (long long)r, FI->filename, chunk_no);
+
+  int m = expected_output_bytes;
+  switch (H->format & 15) {
+    case kfs_bzf_zlib: {
+      uLongf destLen = m;
+      int res = uncompress(static_cast<unsigned char*>(dst), &destLen, src, chunk_size);
+      if (res != Z_OK) {
+        kprintf("uncompress returns error code %d, chunk %d, offset %lld, file '%s'.\n", res, chunk_no, chunk_offset, FI->filename);
+        return -1;
+      }
+      m = (int)destLen;
+      break;
+    }
+    case kfs_bzf_zstd: {
+      size_t res = ZSTD_decompress(dst, m, src, chunk_size);
+      if (ZSTD_isError(res)) {
+        kprintf("ZSTD_decompress returns error '%s', chunk %d, offset %lld, file '%s'.\n", ZSTD_getErrorName(res), chunk_no, chunk_offset, FI->filename);
+        return -1;
+      }
+      m = (int)res;
+      break;
+    }
+    default:
+      kprintf("Unimplemented format '%d' in the file '%s'.\n", H->format & 15, FI->filename);
+      return -1;
+  }
+  if (expected_output_bytes != m) {
+    kprintf("expected chunks size is %d, but decoded bytes number is %d, file: '%s', chunk_no: %d, chunk_offset: %lld\n",
+            expected_output_bytes, m, FI->filename, chunk_no, chunk_offset);
+    return -1;
+  }
+  *dest_len = m;
+  return 0;
+}
+
+int kfs_bz_decode_chunk(const struct kfs_file *F, int chunk_no, void *dst, int *dest_len) {
+  unsigned char *src = static_cast<unsigned char *>(malloc(KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE));
+  assert (src);
+  int res = kfs_bz_decode_chunk_impl(F, chunk_no, src, dst, dest_len, NULL);
+  free(src);
+  return res;
+}
+
 int kfs_bz_decode(const struct kfs_file *F, long long off, void *dst, int *dest_len, int *disk_bytes_read) {
   assert (F->offset == 0 || F->offset == 4096 || F->offset == 8192);
   vkprintf(3, "F.offset = %lld, off = %lld, dst = %p, *dest_len = %d\n", F->offset, off, dst, *dest_len);
@@ -514,7 +606,7 @@ int kfs_bz_decode(const struct kfs_file *F, long long off, void *dst, int *dest_
   const struct kfs_file_info *FI = F->info;
   const kfs_binlog_zip_header_t *H = kfs_get_binlog_zip_header(FI);
   assert (H);
-  const int chunks = kfs_bz_get_chunks_no(H->orig_file_size), fd = F->fd;
+  const int chunks = kfs_bz_get_chunks_no(H->orig_file_size);
 
   if (off < 0) {
     kprintf("negative file offset '%lld', file '%s'.\n", off, FI->filename);
@@ -541,79 +633,19 @@ int kfs_bz_decode(const struct kfs_file *F, long long off, void *dst, int *dest_
   int avail_out = *dest_len, written_bytes = 0;
   int o = off & (KFS_BINLOG_ZIP_CHUNK_SIZE - 1);
 
+  static __thread unsigned char *src;
+  if (src == NULL) {
+    src = alloc_buffer(KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE);
+  }
   while (chunk_no < chunks) {
-    const long long chunk_size = (chunk_no < chunks - 1
-                                  ? H->chunk_offset[chunk_no + 1]
-                                  : FI->file_size - sizeof(struct kfs_file_header) * FI->kfs_headers) - H->chunk_offset[chunk_no];
-    const long long chunk_offset = H->chunk_offset[chunk_no] + F->offset;
-    if (chunk_size <= 0) {
-      kprintf("not positive chunk size (%lld), broken header(?), file: %s\n, chunk: %d, chunk_offset: %lld\n",
-              chunk_size, FI->filename, chunk_no, chunk_offset);
-      return -1;
-    }
-    if (chunk_size > KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE) {
-      kprintf("chunk size (%lld) > KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE (%d), file: %s, chunk: %d, chunk_offset: %lld\n",
-              chunk_size, KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE, FI->filename, chunk_no, chunk_offset);
+    int m = avail_out;
+    if (kfs_bz_decode_chunk_impl(F, chunk_no, src, dst, &m, disk_bytes_read) < 0) {
       return -1;
     }
-
-    int expected_output_bytes = chunk_no == chunks - 1 ? (H->orig_file_size & (KFS_BINLOG_ZIP_CHUNK_SIZE - 1)) : KFS_BINLOG_ZIP_CHUNK_SIZE;
-
-    if (avail_out < expected_output_bytes) {
+    if (!m) {
       break;
     }
 
-    vkprintf(3, "chunk_no: %d, chunks: %d, chunk_size: %lld, chunk_off: %lld\n", chunk_no, chunks, chunk_size, chunk_offset);
-    if (lseek(fd, chunk_offset, SEEK_SET) != chunk_offset) {
-      kprintf("lseek to chunk (%d), offset %lld of file '%s' failed. %m\n", chunk_no, chunk_offset, FI->filename);
-      return -1;
-    }
-    static __thread unsigned char *src;
-    if (src == NULL) {
-      src = alloc_buffer(KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE);
-    }
-    ssize_t r = read(fd, src, chunk_size);
-    if (r < 0) {
-      kprintf("read chunk (%d), offset %lld of file '%s' failed. %m\n", chunk_no, chunk_offset, FI->filename);
-      return -1;
-    }
-    if (disk_bytes_read) {
-      *disk_bytes_read += r;
-    }
-    if (r != chunk_size) {
-      kprintf("read only %lld of expected %lld bytes, chunk (%d), offset %lld, file '%s'.\n",
-              (long long)r, chunk_size, chunk_no, chunk_offset, FI->filename);
-      return -1;
-    }
-    if (FI->iv) {
-      kfs_replica_handle_t R = FI->replica;
-      assert (R && R->ctx_crypto);
-      R->ctx_crypto->ctr_crypt(R->ctx_crypto, src, src, chunk_size, FI->iv, chunk_offset);
-    }
-    vkprintf(2, "read %lld bytes from the file '%s', chunk: %d.\n", (long long)r, FI->filename, chunk_no);
-
-    int m = expected_output_bytes;
-    switch (H->format & 15) {
-      case kfs_bzf_zlib: {
-        uLongf destLen = m;
-        int res = uncompress(static_cast<unsigned char*>(dst), &destLen, src, chunk_size);
-        if (res != Z_OK) {
-          kprintf("uncompress returns error code %d, chunk %d, offset %lld, file '%s'.\n", res, chunk_no, chunk_offset, FI->filename);
-          return -1;
-        }
-        m = (int)destLen;
-        break;
-      }
-      default:
-        kprintf("Unimplemented format '%d' in the file '%s'.\n", H->format & 15, FI->filename);
-        return -1;
-    }
-    if (expected_output_bytes != m) {
-      kprintf("expected chunks size is %d, but decoded bytes number is %d, file: '%s', chunk_no: %d, chunk_offset: %lld\n",
-              expected_output_bytes, m, FI->filename, chunk_no, chunk_offset);
-      return -1;
-    }
-
     int w = -1;
     if (o > 0) {
       w = m - o;
@@ -29,6 +29,8 @@ int kfs_count_headers(const struct kfs_file_header *kfs_Hdr, int r, int strict_c
 int kfs_bz_get_chunks_no(long long orig_file_size);
 int kfs_bz_compute_header_size(long long orig_file_size);
 int kfs_bz_decode(const struct kfs_file *F, long long off, void *dst, int *dest_len, int *disk_bytes_read);
+/* decodes one whole chunk, *dest_len is set to 0 if dst is too small; doesn't use the file position, so it is thread safe */
+int kfs_bz_decode_chunk(const struct kfs_file *F, int chunk_no, void *dst, int *dest_len);
 
 int kfs_file_compute_initialization_vector(struct kfs_file_info *FI);
 
@@ -0,0 +1,128 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/numa.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/kprintf.h"
+
+namespace {
+
+constexpr int MAX_NUMA_NODES = 64;
+// from linux/mempolicy.h
+constexpr int MPOL_INTERLEAVE_MODE = 3;
+
+bool shared_memory_numa_interleave = false;
+
+bool parse_cpu_list(const char *list, cpu_set_t *cpus) noexcept {
+  CPU_ZERO(cpus);
+  while (*list && *list != '\n') {
+    int from = 0;
+    int to = 0;
+    int len = 0;
+    if (sscanf(list, "%d-%d%n", &from, &to, &len) != 2) {
+      if (sscanf(list, "%d%n", &from, &len) != 1) {
+        return false;
+      }
+      to = from;
+    }
+    for (int cpu = from; cpu <= to && cpu < CPU_SETSIZE; cpu++) {
+      CPU_SET(cpu, cpus);
+    }
+    list += len;
+    if (*list == ',') {
+      list++;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int numa_nodes_count() noexcept {
+  static int nodes_count = -1;
+  if (nodes_count == -1) {
+    nodes_count = 0;
+    char path[64];
+    while (nodes_count < MAX_NUMA_NODES) {
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", nodes_count);
+      if (access(path, F_OK) != 0) {
+        break;
+      }
+      nodes_count++;
+    }
+    nodes_count = nodes_count > 0 ? nodes_count : 1;
+  }
+  return nodes_count;
+}
+
+bool numa_node_cpus(int node, cpu_set_t *cpus) noexcept {
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return false;
+  }
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+  FILE *f = fopen(path, "r");
+  if (f == nullptr) {
+    // no NUMA in sysfs, the whole machine is the only node
+    *cpus = allowed;
+    return node == 0;
+  }
+  char buf[4096];
+  const bool ok = fgets(buf, sizeof(buf), f) != nullptr && parse_cpu_list(buf, cpus);
+  fclose(f);
+  if (!ok) {
+    return false;
+  }
+  CPU_AND(cpus, cpus, &allowed);
+  return CPU_COUNT(cpus) > 0;
+}
+
+void set_shared_memory_numa_interleave(bool enabled) noexcept {
+  shared_memory_numa_interleave = enabled;
+}
+
+void numa_place_shared_memory(void *addr, size_t size) noexcept {
+  const int nodes_count = numa_nodes_count();
+  if (!shared_memory_numa_interleave || nodes_count < 2) {
+    return;
+  }
+  unsigned long nodemask = nodes_count >= 64 ? ~0UL : (1UL << nodes_count) - 1;
+  if (syscall(SYS_mbind, addr, size, MPOL_INTERLEAVE_MODE, &nodemask, sizeof(nodemask) * 8, 0) != 0) {
+    kprintf("failed to interleave %zu bytes of shared memory over %d numa nodes: %m\n", size, nodes_count);
+  }
+}
+
+bool read_numa_stats(numa_stats_t *stats) noexcept {
+  *stats = numa_stats_t{};
+  bool found = false;
+  char path[64];
+  char name[64];
+  uint64_t value = 0;
+  for (int node = 0; node < MAX_NUMA_NODES; node++) {
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/numastat", node);
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+      break;
+    }
+    found = true;
+    while (fscanf(f, "%63s %" SCNu64, name, &value) == 2) {
+      if (!strcmp(name, "local_node")) {
+        stats->local_node += value;
+      } else if (!strcmp(name, "other_node")) {
+        stats->other_node += value;
+      } else if (!strcmp(name, "numa_miss")) {
+        stats->numa_miss += value;
+      }
+    }
+    fclose(f);
+  }
+  return found;
+}
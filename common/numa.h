@@ -0,0 +1,28 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sched.h>
+
+// NUMA topology is read from sysfs, memory policies are set with raw syscalls: no libnuma is needed
+
+int numa_nodes_count() noexcept;
+// the cpus of the node which are also in the current affinity mask of the process
+bool numa_node_cpus(int node, cpu_set_t *cpus) noexcept;
+
+void set_shared_memory_numa_interleave(bool enabled) noexcept;
+// spreads the pages of a shared memory segment over all the nodes if it is enabled
+void numa_place_shared_memory(void *addr, size_t size) noexcept;
+
+struct numa_stats_t {
+  uint64_t local_node{0};
+  uint64_t other_node{0};
+  uint64_t numa_miss{0};
+};
+
+// sums /sys/devices/system/node/node*/numastat over the nodes
+bool read_numa_stats(numa_stats_t *stats) noexcept;
@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <charconv>
 #include <climits>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <limits>
 #include <type_traits>
@@ -90,6 +93,41 @@ int64_t string_hash(const char *p, size_t l) {
 }
 
 
+// checks that the 8 bytes are decimal digits and converts them to a number at once (SWAR)
+inline bool php_try_parse_8_digits(const char *s, uint32_t *val) noexcept {
+  uint64_t chunk = 0;
+  memcpy(&chunk, s, sizeof(chunk));
+  if (((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) != 0x3333333333333333ULL) {
+    return false;
+  }
+  chunk -= 0x3030303030303030ULL;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+  *val = static_cast<uint32_t>(chunk);
+  return true;
+}
+
+// appends the decimal digits to val, returns false if there is something else;
+// the caller must ensure that the result fits into uint64_t
+inline bool php_try_accumulate_digits(const char *s, size_t l, uint64_t *val) noexcept {
+  uint64_t res = *val;
+  for (; l >= 8; s += 8, l -= 8) {
+    uint32_t eight_digits = 0;
+    if (!php_try_parse_8_digits(s, &eight_digits)) {
+      return false;
+    }
+    res = res * 100000000 + eight_digits;
+  }
+  for (; l > 0; ++s, --l) {
+    if (*s > '9' || *s < '0') {
+      return false;
+    }
+    res = res * 10 + *s - '0';
+  }
+  *val = res;
+  return true;
+}
+
 inline bool php_is_int(const char *s, size_t l) __attribute__ ((always_inline));
 
 bool php_is_int(const char *s, size_t l) {
@@ -113,23 +151,12 @@ bool php_is_int(const char *s, size_t l) {
   if (l == 0 || l > max_digits) {
     return false;
   }
-  if (l == max_digits) {
-    uint64_t val = s[0] - '0';
-    for (size_t j = 1; j < l; j++) {
-      if (s[j] > '9' || s[j] < '0') {
-        return false;
-      }
-      val = val * 10 + s[j] - '0';
-    }
-    return val <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + has_minus;
-  }
 
-  for (size_t j = 1; j < l; j++) {
-    if (s[j] > '9' || s[j] < '0') {
-      return false;
-    }
+  uint64_t val = 0;
+  if (!php_try_accumulate_digits(s, l, &val)) {
+    return false;
   }
-  return true;
+  return l < max_digits || val <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + has_minus;
 }
 
 
@@ -159,32 +186,39 @@ bool php_try_to_int(const char *s, size_t l, int64_t *val) {
   if (l == 0 || l > max_digits) {
     return false;
   }
-  if (l == max_digits) {
-    *val = s[0] - '0';
-    for (size_t j = 1; j < l; j++) {
-      if (s[j] > '9' || s[j] < '0') {
-        return false;
-      }
-      *val = *val * 10 + s[j] - '0';
-    }
 
-    if (*val > 0 || (*val == std::numeric_limits<int64_t>::min() && mul == -1)) {
-      *val = *val * mul;
-      return true;
-    }
+  uint64_t uval = 0;
+  if (!php_try_accumulate_digits(s, l, &uval)) {
     return false;
   }
+  constexpr uint64_t int_max = std::numeric_limits<int64_t>::max();
+  if (uval <= int_max) {
+    *val = static_cast<int64_t>(uval) * mul;
+    return true;
+  }
+  if (uval == int_max + 1 && mul == -1) {
+    *val = std::numeric_limits<int64_t>::min();
+    return true;
+  }
+  return false;
+}
 
-  *val = s[0] - '0';
-  for (size_t j = 1; j < l; j++) {
-    if (s[j] > '9' || s[j] < '0') {
-      return false;
+// strtod() replacement: the plain decimal numbers are parsed by std::from_chars (fast_float algorithm in libstdc++),
+// the rest (leading spaces and '+', inf/nan, hex, out of range values) is left to strtod()
+inline double php_strtod(const char *s, const char *s_end, char **end_ptr) noexcept {
+#if __cpp_lib_to_chars >= 201611L
+  if (s < s_end && (static_cast<uint8_t>(*s - '0') < 10 || *s == '-' || *s == '.')) {
+    double val = 0;
+    const auto res = std::from_chars(s, s_end, val);
+    if (res.ec == std::errc{} && (*res.ptr | 0x20) != 'x') {
+      *end_ptr = const_cast<char *>(res.ptr);
+      return val;
     }
-    *val = *val * 10 + s[j] - '0';
   }
-
-  *val *= mul;
-  return true;
+#else
+  static_cast<void>(s_end);
+#endif
+  return strtod(s, end_ptr);
 }
 
 //returns len of raw string representation or -1 on error
@@ -0,0 +1,51 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/precise-time.h"
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+uint64_t clock_ns(clockid_t clock_id) {
+  timespec t;
+  clock_gettime(clock_id, &t);
+  return static_cast<uint64_t>(t.tv_sec) * 1000000000LL + t.tv_nsec;
+}
+
+} // namespace
+
+TEST(precise_time, fast_clock_follows_clock_gettime) {
+  uint64_t prev_mono = get_ntime_mono_fast();
+  // goes through the calibration and a couple of resyncs
+  for (int i = 0; i < 300; ++i) {
+    const uint64_t mono_before = clock_ns(CLOCK_MONOTONIC);
+    const uint64_t mono = get_ntime_mono_fast();
+    const uint64_t mono_after = clock_ns(CLOCK_MONOTONIC);
+    ASSERT_GE(mono, prev_mono);
+    // the extrapolation error is far less than a millisecond
+    ASSERT_GT(mono + 1000000, mono_before);
+    ASSERT_LT(mono, mono_after + 1000000);
+    prev_mono = mono;
+
+    const uint64_t real = get_ntime_real_fast();
+    const uint64_t real_after = clock_ns(CLOCK_REALTIME);
+    ASSERT_LT(real, real_after + 1000000);
+    ASSERT_GT(real + 100000000, real_after);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+TEST(precise_time, utime_monotonic_never_goes_back) {
+  double prev = get_utime_monotonic();
+  for (int i = 0; i < 100000; ++i) {
+    const double cur = get_utime_monotonic();
+    ASSERT_GE(cur, prev);
+    prev = cur;
+  }
+  ASSERT_EQ(precise_now, prev);
+}
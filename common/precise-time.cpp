@@ -7,6 +7,8 @@
 #include <algorithm>
 #include <assert.h>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
@@ -20,16 +22,7 @@ long long precise_time;
 long long precise_time_rdtsc;
 
 double get_utime_monotonic () {
-  struct timespec T;
-  double res;
-#if _POSIX_TIMERS
-  assert (clock_gettime (CLOCK_MONOTONIC, &T) >= 0);
-  res = T.tv_sec + (double) T.tv_nsec * 1e-9;
-#else
-#error "No high-precision clock"
-  res = time();
-#endif
-  precise_now = std::max(precise_now, res);
+  precise_now = std::max(precise_now, static_cast<double>(get_ntime_mono_fast()) * 1e-9);
   return precise_now;
 }
 
@@ -46,45 +39,116 @@ uint64_t get_ntime_mono() {
   return res;
 }
 
-template<typename T>
-static inline double get_cached_time(T get_time, int cycles_cache) {
-  thread_local static double last_cached_time = -1;
-  thread_local static uint64_t last_cycleclock;
-  const auto cycleclock = cycleclock_now();
-
-  if (cycleclock - last_cycleclock > cycles_cache) {
-    last_cached_time = get_time(last_cached_time);
-    last_cycleclock = cycleclock;
+static bool detect_tsc_clock_reliable() {
+#if defined(__x86_64__)
+  int a, b, c, d;
+  asm volatile("cpuid\n\t" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(0x80000000));
+  if (static_cast<unsigned>(a) < 0x80000007) {
+    return false;
+  }
+  asm volatile("cpuid\n\t" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(0x80000007));
+  // invariant tsc
+  if (!(d & (1 << 8))) {
+    return false;
   }
+  // the kernel drops the tsc clock source, if the counters of different cpus are not synchronized
+  FILE *f = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+  if (f == nullptr) {
+    return true;
+  }
+  char buf[64] = {0};
+  const bool is_tsc = fgets(buf, sizeof(buf), f) != nullptr && strncmp(buf, "tsc", 3) == 0;
+  fclose(f);
+  return is_tsc;
+#elif defined(__aarch64__)
+  // the generic timer runs at a constant rate and is synchronized between cpus
+  return true;
+#else
+#error "Unsupported arch"
+#endif
+}
 
-  return last_cached_time;
+bool is_tsc_clock_reliable() {
+  static const bool reliable = detect_tsc_clock_reliable();
+  return reliable;
 }
 
-double get_double_time() {
-  auto get_time = [](double last_cached_time) {
-    struct timeval tv;
-    if (!gettimeofday(&tv, NULL)) {
-      return tv.tv_sec + (1e-6) * tv.tv_usec;
-    }
+namespace {
+
+struct tsc_clock_state {
+  uint64_t anchor_cycles{0};
+  uint64_t anchor_mono_ns{0};
+  int64_t real_offset_ns{0};
+  double ns_per_cycle{0};
+  // the first resync comes soon to get the rate, the next ones refine it
+  uint64_t resync_cycles{0};
+  uint64_t last_mono_ns{0};
+};
+
+thread_local tsc_clock_state tsc_clock;
 
-    return last_cached_time;
-  };
+constexpr uint64_t TSC_CLOCK_CALIBRATION_CYCLES = 10000000;
+constexpr double TSC_CLOCK_RESYNC_NS = 1e8;
 
-  return get_cached_time(get_time, 1e6);
+uint64_t timespec_to_ns(const timespec &t) {
+  return static_cast<uint64_t>(t.tv_sec) * 1000000000LL + t.tv_nsec;
 }
 
-double get_network_time() {
-  auto get_time = [](double last_cached_time) {
-    struct timespec tp;
-    if (!clock_gettime(CLOCK_MONOTONIC, &tp)) {
-      return tp.tv_sec + (1e-9) * tp.tv_nsec;
-    }
+void tsc_clock_resync(uint64_t cycles) {
+  timespec mono, real;
+  assert(clock_gettime(CLOCK_MONOTONIC, &mono) >= 0);
+  assert(clock_gettime(CLOCK_REALTIME, &real) >= 0);
+  const uint64_t mono_ns = timespec_to_ns(mono);
+  if (tsc_clock.resync_cycles && cycles > tsc_clock.anchor_cycles && mono_ns > tsc_clock.anchor_mono_ns) {
+    tsc_clock.ns_per_cycle = static_cast<double>(mono_ns - tsc_clock.anchor_mono_ns) / static_cast<double>(cycles - tsc_clock.anchor_cycles);
+  }
+  tsc_clock.anchor_cycles = cycles;
+  tsc_clock.anchor_mono_ns = mono_ns;
+  tsc_clock.real_offset_ns = static_cast<int64_t>(timespec_to_ns(real) - mono_ns);
+  tsc_clock.resync_cycles = tsc_clock.ns_per_cycle > 0
+                            ? static_cast<uint64_t>(TSC_CLOCK_RESYNC_NS / tsc_clock.ns_per_cycle)
+                            : TSC_CLOCK_CALIBRATION_CYCLES;
+}
 
-    return last_cached_time;
-  };
+} // namespace
 
-  precise_now = std::max(precise_now, get_cached_time(get_time, 1e6));
+uint64_t get_ntime_mono_fast() {
+  if (unlikely(!is_tsc_clock_reliable())) {
+    return get_ntime_mono();
+  }
+  const uint64_t cycles = cycleclock_now();
+  // it is huge if the thread moved to a cpu, whose counter is a bit behind
+  const uint64_t elapsed_cycles = cycles - tsc_clock.anchor_cycles;
+  uint64_t res = 0;
+  if (unlikely(elapsed_cycles >= tsc_clock.resync_cycles)) {
+    tsc_clock_resync(cycles);
+    res = tsc_clock.anchor_mono_ns;
+  } else if (unlikely(tsc_clock.ns_per_cycle == 0)) {
+    res = get_ntime_mono();
+  } else {
+    res = tsc_clock.anchor_mono_ns + static_cast<uint64_t>(static_cast<double>(elapsed_cycles) * tsc_clock.ns_per_cycle);
+  }
+  res = std::max(res, tsc_clock.last_mono_ns);
+  tsc_clock.last_mono_ns = res;
+  return res;
+}
 
+uint64_t get_ntime_real_fast() {
+  if (unlikely(!is_tsc_clock_reliable())) {
+    timespec real;
+    assert(clock_gettime(CLOCK_REALTIME, &real) >= 0);
+    return timespec_to_ns(real);
+  }
+  const uint64_t mono_ns = get_ntime_mono_fast();
+  return mono_ns + tsc_clock.real_offset_ns;
+}
+
+double get_double_time() {
+  return static_cast<double>(get_ntime_real_fast()) * 1e-9;
+}
+
+double get_network_time() {
+  precise_now = std::max(precise_now, static_cast<double>(get_ntime_mono_fast()) * 1e-9);
   return precise_now;
 }
 
@@ -16,6 +16,13 @@ double get_utime_monotonic ();
 // get CLOCK_MONOTONIC nanoseconds integer
 uint64_t get_ntime_mono();
 
+// CLOCK_MONOTONIC and CLOCK_REALTIME nanoseconds extrapolated from the cycle counter, which is resynchronized
+// with the clocks every 100ms; they fall back to clock_gettime() if the counter is not reliable
+uint64_t get_ntime_mono_fast();
+uint64_t get_ntime_real_fast();
+// the cycle counter runs at a constant rate and the kernel itself uses it as the clock source
+bool is_tsc_clock_reliable();
+
 /* common/server-functions.h */
 double get_utime (int clock_id);
 extern long long precise_time;  // (long long) (2^16 * precise unixtime)
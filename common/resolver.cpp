@@ -5,18 +5,22 @@
 #include "common/resolver.h"
 
 #include <assert.h>
+#include <atomic>
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "common/kprintf.h"
 #include "common/options.h"
+#include "common/stats/provider.h"
 
 #define	HOSTS_FILE	"/etc/hosts"
 #define	MAX_HOSTS_SIZE	(1L << 24)
@@ -333,6 +337,313 @@ int kdb_load_hosts () {
   return 1;
 }
 
+/*
+ * Cache of the names resolved by the system resolver, it is kept in the memory shared by the master and the workers.
+ * A worker resolves a name by itself only when it meets the name for the first time,
+ * the master resolves the names which are used again before they expire, so the workers keep getting the cached addresses.
+ * An expired entry is still returned during one more ttl, after that the worker resolves the name by itself again.
+ */
+
+#define RESOLVER_CACHE_SIZE 4096
+#define RESOLVER_CACHE_PROBES 32
+#define RESOLVER_CACHE_MAX_ADDRS 8
+#define RESOLVER_CACHE_MAX_REFRESHES 8
+
+enum resolver_cache_entry_state {
+  RCE_EMPTY = 0,
+  RCE_USED = 1,
+  RCE_REMOVED = 2
+};
+
+struct resolver_cache_entry {
+  // odd while the entry is being written
+  std::atomic<unsigned> seq;
+  int state;
+  int naddrs;
+  int expires_at;
+  std::atomic<int> last_used;
+  unsigned addrs[RESOLVER_CACHE_MAX_ADDRS];
+  char name[128];
+};
+
+struct resolver_cache {
+  std::atomic<long long> hits;
+  std::atomic<long long> stale_hits;
+  std::atomic<long long> negative_hits;
+  std::atomic<long long> misses;
+  std::atomic<long long> refreshes;
+  std::atomic<long long> refresh_failures;
+  std::atomic<long long> evictions;
+  std::atomic<long long> overflows;
+  resolver_cache_entry entries[RESOLVER_CACHE_SIZE];
+};
+
+static resolver_cache *RCache;
+static int resolver_cache_ttl = 60;
+static int resolver_cache_negative_ttl = 5;
+
+OPTION_PARSER(OPT_NETWORK, "resolver-cache-ttl", required_argument,
+              "time in seconds for which the resolved addresses of a name are cached and refreshed by the master, 0 disables the cache (default 60)") {
+  resolver_cache_ttl = atoi(optarg);
+  if (resolver_cache_ttl < 0 || resolver_cache_ttl > 86400) {
+    kprintf("--resolver-cache-ttl should be between 0 and 86400 seconds\n");
+    return -1;
+  }
+  return 0;
+}
+
+OPTION_PARSER(OPT_NETWORK, "resolver-cache-negative-ttl", required_argument,
+              "time in seconds for which a name which can't be resolved is cached (default 5)") {
+  resolver_cache_negative_ttl = atoi(optarg);
+  if (resolver_cache_negative_ttl < 0 || resolver_cache_negative_ttl > 86400) {
+    kprintf("--resolver-cache-negative-ttl should be between 0 and 86400 seconds\n");
+    return -1;
+  }
+  return 0;
+}
+
+void kdb_resolver_cache_init () {
+  if (RCache || resolver_cache_ttl <= 0) {
+    return;
+  }
+  void *memory = mmap (nullptr, sizeof (resolver_cache), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    kprintf ("Can't mmap %zu bytes for the resolver cache: %m\n", sizeof (resolver_cache));
+    return;
+  }
+  // the anonymous memory is zeroed, all the counters and the entries are empty
+  RCache = static_cast<resolver_cache *>(memory);
+}
+
+static unsigned resolver_cache_hash (const char *name, int len) {
+  unsigned h = 0;
+  for (int i = 0; i < len; i++) {
+    h = h * 239 + (unsigned char)name[i];
+  }
+  return h;
+}
+
+static bool resolver_cache_lock (resolver_cache_entry *E) {
+  unsigned seq = E->seq.load (std::memory_order_relaxed);
+  return !(seq & 1) && E->seq.compare_exchange_strong (seq, seq + 1, std::memory_order_acquire);
+}
+
+static void resolver_cache_unlock (resolver_cache_entry *E) {
+  E->seq.fetch_add (1, std::memory_order_release);
+}
+
+// copies the entry of the name to *R, returns false if the name is not cached
+static bool resolver_cache_lookup (const char *name, int len, resolver_cache_entry **where, resolver_cache_entry *R) {
+  unsigned h = resolver_cache_hash (name, len);
+  for (int i = 0; i < RESOLVER_CACHE_PROBES; i++) {
+    resolver_cache_entry *E = &RCache->entries[(h + i) % RESOLVER_CACHE_SIZE];
+    unsigned seq = E->seq.load (std::memory_order_acquire);
+    if (seq & 1) {
+      continue;
+    }
+    int state = E->state;
+    if (state == RCE_EMPTY) {
+      return false;
+    }
+    if (state != RCE_USED || strncmp (E->name, name, sizeof (E->name)) != 0) {
+      continue;
+    }
+    R->naddrs = E->naddrs;
+    R->expires_at = E->expires_at;
+    memcpy (R->addrs, E->addrs, sizeof (R->addrs));
+    std::atomic_thread_fence (std::memory_order_acquire);
+    if (E->seq.load (std::memory_order_relaxed) != seq) {
+      // it is being rewritten right now, the caller resolves the name by itself
+      return false;
+    }
+    *where = E;
+    return true;
+  }
+  return false;
+}
+
+static void resolver_cache_fill (resolver_cache_entry *E, const struct hostent *h, int now) {
+  int naddrs = 0;
+  if (h) {
+    assert (h->h_addrtype == AF_INET && h->h_length == 4);
+    for (; naddrs < RESOLVER_CACHE_MAX_ADDRS && h->h_addr_list[naddrs]; naddrs++) {
+      memcpy (&E->addrs[naddrs], h->h_addr_list[naddrs], 4);
+    }
+  }
+  E->naddrs = naddrs;
+  E->expires_at = now + (naddrs ? resolver_cache_ttl : resolver_cache_negative_ttl);
+}
+
+static void resolver_cache_store (const char *name, int len, const struct hostent *h, int now) {
+  unsigned hash = resolver_cache_hash (name, len);
+  resolver_cache_entry *free_entry = nullptr;
+  for (int i = 0; i < RESOLVER_CACHE_PROBES; i++) {
+    resolver_cache_entry *E = &RCache->entries[(hash + i) % RESOLVER_CACHE_SIZE];
+    int state = E->state;
+    if (state == RCE_USED && !strncmp (E->name, name, sizeof (E->name))) {
+      free_entry = E;
+      break;
+    }
+    if (state != RCE_USED && !free_entry) {
+      free_entry = E;
+    }
+    if (state == RCE_EMPTY) {
+      break;
+    }
+  }
+  if (!free_entry) {
+    RCache->overflows++;
+    return;
+  }
+  if (!resolver_cache_lock (free_entry)) {
+    // somebody else writes the entry right now
+    return;
+  }
+  if (free_entry->state != RCE_USED || strncmp (free_entry->name, name, sizeof (free_entry->name)) != 0) {
+    if (free_entry->state == RCE_USED) {
+      // it was taken by another name after the probing
+      resolver_cache_unlock (free_entry);
+      return;
+    }
+    memcpy (free_entry->name, name, len + 1);
+    free_entry->state = RCE_USED;
+  }
+  resolver_cache_fill (free_entry, h, now);
+  free_entry->last_used = now;
+  resolver_cache_unlock (free_entry);
+}
+
+static struct hostent *resolver_cache_hostent (const char *name, const resolver_cache_entry *R) {
+  static unsigned addrs[RESOLVER_CACHE_MAX_ADDRS];
+  static char *h_array[RESOLVER_CACHE_MAX_ADDRS + 1];
+  static hostent hret = {
+    .h_name = nullptr,
+    .h_aliases = nullptr,
+    .h_addrtype = AF_INET,
+    .h_length = 4,
+    .h_addr_list = h_array
+  };
+
+  for (int i = 0; i < R->naddrs; i++) {
+    addrs[i] = R->addrs[i];
+    h_array[i] = (char *)&addrs[i];
+  }
+  h_array[R->naddrs] = nullptr;
+  hret.h_name = (char *)name;
+  return &hret;
+}
+
+static struct hostent *gethostbyname_cached (const char *name, int len) {
+  if (!RCache || len >= 128) {
+    return gethostbyname (name) ?: gethostbyname2 (name, AF_INET6);
+  }
+
+  int now = time (nullptr);
+  resolver_cache_entry *E = nullptr;
+  resolver_cache_entry R;
+  if (resolver_cache_lookup (name, len, &E, &R)) {
+    const int grace = R.naddrs ? resolver_cache_ttl : resolver_cache_negative_ttl;
+    if (now < R.expires_at + grace) {
+      if (E->last_used.load (std::memory_order_relaxed) != now) {
+        E->last_used.store (now, std::memory_order_relaxed);
+      }
+      if (!R.naddrs) {
+        RCache->negative_hits++;
+        return nullptr;
+      }
+      if (now < R.expires_at) {
+        RCache->hits++;
+      } else {
+        RCache->stale_hits++;
+      }
+      return resolver_cache_hostent (name, &R);
+    }
+  }
+
+  RCache->misses++;
+  struct hostent *h = gethostbyname (name);
+  if (h && h->h_addrtype == AF_INET && h->h_length == 4) {
+    resolver_cache_store (name, len, h, now);
+    return h;
+  }
+  if (h) {
+    return h;
+  }
+  int err = h_errno;
+  h = gethostbyname2 (name, AF_INET6);
+  if (!h && (err == HOST_NOT_FOUND || err == NO_DATA)) {
+    resolver_cache_store (name, len, nullptr, now);
+  }
+  // the IPv6 addresses are not cached
+  return h;
+}
+
+void kdb_resolver_cache_refresh () {
+  if (!RCache) {
+    return;
+  }
+  int now = time (nullptr);
+  int refreshed = 0;
+  for (int i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+    resolver_cache_entry *E = &RCache->entries[i];
+    if (E->state != RCE_USED) {
+      continue;
+    }
+    const bool negative = !E->naddrs;
+    const int ttl = negative ? resolver_cache_negative_ttl : resolver_cache_ttl;
+    if (E->last_used.load (std::memory_order_relaxed) + ttl < now) {
+      // the name hasn't been used for the whole ttl, it isn't refreshed anymore
+      if (resolver_cache_lock (E)) {
+        E->state = RCE_REMOVED;
+        resolver_cache_unlock (E);
+        RCache->evictions++;
+      }
+      continue;
+    }
+    // the names are refreshed a little before they expire, so that the workers don't get the stale addresses
+    if (E->expires_at - (ttl >> 3) > now || refreshed >= RESOLVER_CACHE_MAX_REFRESHES) {
+      continue;
+    }
+    refreshed++;
+
+    char name[sizeof (E->name)];
+    memcpy (name, E->name, sizeof (name));
+    struct hostent *h = gethostbyname (name);
+    const bool failed = !h && h_errno != HOST_NOT_FOUND && h_errno != NO_DATA;
+    if (h && (h->h_addrtype != AF_INET || h->h_length != 4)) {
+      h = nullptr;
+    }
+    if (!resolver_cache_lock (E)) {
+      continue;
+    }
+    if (E->state == RCE_USED && !strcmp (E->name, name)) {
+      if (failed && !negative) {
+        // the stale addresses are kept, it is tried again later
+        E->expires_at = now + resolver_cache_negative_ttl;
+        RCache->refresh_failures++;
+      } else {
+        resolver_cache_fill (E, h, now);
+        RCache->refreshes++;
+      }
+    }
+    resolver_cache_unlock (E);
+  }
+}
+
+STATS_PROVIDER(resolver, 2000) {
+  if (!RCache) {
+    return;
+  }
+  add_general_stat(stats, "resolver_cache_hits", "%lld", RCache->hits.load());
+  add_general_stat(stats, "resolver_cache_stale_hits", "%lld", RCache->stale_hits.load());
+  add_general_stat(stats, "resolver_cache_negative_hits", "%lld", RCache->negative_hits.load());
+  add_general_stat(stats, "resolver_cache_misses", "%lld", RCache->misses.load());
+  add_general_stat(stats, "resolver_cache_refreshes", "%lld", RCache->refreshes.load());
+  add_general_stat(stats, "resolver_cache_refresh_failures", "%lld", RCache->refresh_failures.load());
+  add_general_stat(stats, "resolver_cache_evictions", "%lld", RCache->evictions.load());
+  add_general_stat(stats, "resolver_cache_overflows", "%lld", RCache->overflows.load());
+}
+
 struct hostent *kdb_gethostbyname (const char *name) {
   if (!kdb_hosts_loaded) {
     kdb_load_hosts ();
@@ -355,19 +666,15 @@ struct hostent *kdb_gethostbyname (const char *name) {
   }
 
 
-  if (kdb_hosts_loaded <= 0) {
-    return gethostbyname (name) ?: gethostbyname2 (name, AF_INET6);
-  }
-
-  if (len >= 128) {
-    return gethostbyname (name) ?: gethostbyname2 (name, AF_INET6);
+  if (kdb_hosts_loaded <= 0 || len >= 128) {
+    return gethostbyname_cached (name, len);
   }
 
   struct host *res = getHash (&Hosts, name, len, 0);
 
   if (!res) {
     if (strchr (name, '.') || strchr (name, ':')) {
-      return gethostbyname (name) ?: gethostbyname2 (name, AF_INET6);
+      return gethostbyname_cached (name, len);
     } else {
       return 0;
     }
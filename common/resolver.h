@@ -13,4 +13,9 @@ int kdb_load_hosts ();
 struct hostent *kdb_gethostbyname (const char *name);
 const char *kdb_gethostname();
 
+// creates the cache of the resolved names in the shared memory, it must be called before the workers are forked
+void kdb_resolver_cache_init ();
+// resolves again the cached names which are going to expire and removes the unused ones, called by the master once a second
+void kdb_resolver_cache_refresh ();
+
 #endif
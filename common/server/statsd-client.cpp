@@ -117,8 +117,9 @@ void send_data_to_statsd_with_prefix(const char *stats_prefix, unsigned int tag_
       connected_to_targets[i] = 1;
     }
 
-    char *result = engine_default_prepare_stats_with_tag_mask(STATS_TYPE_STATSD, NULL, stats_prefix, tag_mask);
-    write_out(&c->Out, result, (int)strlen(result));
+    int len = 0;
+    char *result = engine_default_prepare_stats_with_tag_mask(STATS_TYPE_STATSD, &len, stats_prefix, tag_mask);
+    write_out(&c->Out, result, len);
     flush_later(c);
     vkprintf(4, "statsd flush!\n");
     break;
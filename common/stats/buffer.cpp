@@ -56,3 +56,16 @@ void sb_append(stats_buffer_t *sb, char c) {
   }
   sb->buff[sb->pos] = 0;
 }
+
+void sb_append_bytes(stats_buffer_t *sb, const char *data, int len) {
+  if (sb->overflowed) {
+    return;
+  }
+  if (sb->pos + len >= sb->size) {
+    sb_truncate(sb);
+    return;
+  }
+  memcpy(sb->buff + sb->pos, data, len);
+  sb->pos += len;
+  sb->buff[sb->pos] = 0;
+}
@@ -19,3 +19,4 @@ void sb_init(stats_buffer_t *sb, char *buff, int size);
 void sb_printf(stats_buffer_t *sb, const char *format, ...) __attribute__ ((format (printf, 2, 3)));
 void vsb_printf(stats_buffer_t *sb, const char *format, va_list __arg_list);
 void sb_append(stats_buffer_t *sb, char c);
+void sb_append_bytes(stats_buffer_t *sb, const char *data, int len);
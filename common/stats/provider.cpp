@@ -33,6 +33,21 @@ char *statsd_normalize_key(const char *key) {
   return result_start;
 }
 
+// writes "prefix.normalized_key:" straight into the buffer, without formatting the key through a temporary copy
+static void sb_append_statsd_key(stats_buffer_t *sb, const char *prefix, const char *key) {
+  char normalized[1 << 10];
+  int len = 0;
+  for (; *key && len < static_cast<int>(sizeof(normalized)) - 1; key++) {
+    const char c = *key;
+    const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    normalized[len++] = ok ? c : '_';
+  }
+  normalized[len++] = ':';
+  sb_append_bytes(sb, prefix, static_cast<int>(strlen(prefix)));
+  sb_append_bytes(sb, ".", 1);
+  sb_append_bytes(sb, normalized, len);
+}
+
 static void add_stat(const char type, stats_t *stats, const char *key, const char *value_format, ...) {
   stats_buffer_t *sb = &stats->sb;
   va_list ap;
@@ -44,9 +59,11 @@ static void add_stat(const char type, stats_t *stats, const char *key, const cha
       sb_printf(sb, "\n");
       break;
     case STATS_TYPE_STATSD:
-      sb_printf(sb, "%s.%s:", stats->statsd_prefix, statsd_normalize_key(key));
+      sb_append_statsd_key(sb, stats->statsd_prefix, key);
       vsb_printf(sb, value_format, ap);
-      sb_printf(sb, "|%c\n", type);
+      sb_append(sb, '|');
+      sb_append(sb, type);
+      sb_append(sb, '\n');
       break;
     default:
       assert(0);
@@ -0,0 +1,236 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/string-kernels.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string random_text(std::mt19937 &gen, size_t len) {
+  std::string text(len, ' ');
+  for (auto &c : text) {
+    const auto kind = gen() % 10;
+    if (kind < 3) {
+      c = "&<>\"'\\"[gen() % 6];
+    } else if (kind < 4) {
+      c = static_cast<char>(gen() % 256);
+    } else {
+      c = static_cast<char>('A' + gen() % 58);
+    }
+  }
+  return text;
+}
+
+} // namespace
+
+TEST(string_kernels, find_first_of_chars) {
+  std::mt19937 gen{17};
+  const char chars[] = {'&', '<', '>', '"', '\'', '\0'};
+  for (size_t len = 0; len < 200; ++len) {
+    for (size_t chars_count = 0; chars_count <= sizeof(chars); ++chars_count) {
+      const std::string text = random_text(gen, len);
+      ASSERT_EQ(find_first_of_chars(text.data(), len, chars, chars_count),
+                find_first_of_chars_generic(text.data(), len, chars, chars_count));
+    }
+  }
+
+  const std::string plain(100, 'a');
+  ASSERT_EQ(find_first_of_chars(plain.data(), plain.size(), chars, sizeof(chars)), plain.size());
+  ASSERT_EQ(find_first_of_chars(plain.data(), plain.size(), "a", 1), 0);
+}
+
+TEST(string_kernels, ascii_convert_case) {
+  std::mt19937 gen{42};
+  for (size_t len = 0; len < 200; ++len) {
+    const std::string text = random_text(gen, len);
+    for (auto kernels : {std::make_pair(ascii_to_lower, ascii_to_lower_generic), std::make_pair(ascii_to_upper, ascii_to_upper_generic)}) {
+      std::string actual(len, '\0');
+      std::string expected(len, '\0');
+      const size_t actual_pos = kernels.first(&actual[0], text.data(), len);
+      const size_t expected_pos = kernels.second(&expected[0], text.data(), len);
+      ASSERT_EQ(actual_pos, expected_pos);
+      ASSERT_EQ(actual.substr(0, actual_pos), expected.substr(0, expected_pos));
+    }
+  }
+
+  std::string converted(40, '\0');
+  ASSERT_EQ(ascii_to_lower(&converted[0], "Hello, World! 0123456789 [ABC-XYZ]@`{}", 38), 38);
+  ASSERT_EQ(converted.substr(0, 38), "hello, world! 0123456789 [abc-xyz]@`{}");
+  ASSERT_EQ(ascii_to_upper(&converted[0], "Hello, World! 0123456789 [abc-xyz]@`{}", 38), 38);
+  ASSERT_EQ(converted.substr(0, 38), "HELLO, WORLD! 0123456789 [ABC-XYZ]@`{}");
+}
+
+TEST(string_kernels, json_unescaped_prefix_length) {
+  std::mt19937 gen{5};
+  for (size_t len = 0; len < 200; ++len) {
+    // a single char that may need escaping, so that the long unescaped runs are tested too
+    std::string text(len, ' ');
+    for (auto &c : text) {
+      c = "ab7 \xd0\xbf~"[gen() % 7];
+    }
+    if (len) {
+      text[gen() % len] = "\"\\/\n\x1f\x7f\x80 "[gen() % 8];
+    }
+    ASSERT_EQ(json_unescaped_prefix_length(text.data(), len), json_unescaped_prefix_length_generic(text.data(), len));
+  }
+
+  const std::string plain = std::string(40, 'a') + "\xd0\xbf\x7f";
+  ASSERT_EQ(json_unescaped_prefix_length(plain.data(), plain.size()), plain.size());
+  ASSERT_EQ(json_unescaped_prefix_length((plain + "/").data(), plain.size() + 1), plain.size());
+  ASSERT_EQ(json_unescaped_prefix_length((plain + std::string(1, '\0')).data(), plain.size() + 1), plain.size());
+}
+
+TEST(string_kernels, http_token_length) {
+  std::mt19937 gen{11};
+  for (size_t len = 0; len < 200; ++len) {
+    std::string text(len, ' ');
+    for (auto &c : text) {
+      c = "az/?=%\xd0\xbf\x7f"[gen() % 9];
+    }
+    if (len) {
+      text[gen() % len] = " \t\r\n\x01\x20\x21\xff"[gen() % 8];
+    }
+    ASSERT_EQ(http_token_length(text.data(), len), http_token_length_generic(text.data(), len));
+  }
+
+  const std::string uri = "/index.php?q=" + std::string(40, 'a') + "\xd0\xbf";
+  ASSERT_EQ(http_token_length(uri.data(), uri.size()), uri.size());
+  ASSERT_EQ(http_token_length((uri + " HTTP/1.1").data(), uri.size() + 9), uri.size());
+  ASSERT_EQ(http_token_length((uri + "\r\n").data(), uri.size() + 2), uri.size());
+}
+
+TEST(string_kernels, url_unreserved_prefix_length) {
+  std::mt19937 gen{13};
+  for (size_t len = 0; len < 200; ++len) {
+    std::string text(len, ' ');
+    for (auto &c : text) {
+      c = "aZ09-_.mQ"[gen() % 9];
+    }
+    if (len) {
+      text[gen() % len] = static_cast<char>(gen() % 256);
+    }
+    ASSERT_EQ(url_unreserved_prefix_length(text.data(), len), url_unreserved_prefix_length_generic(text.data(), len));
+  }
+
+  ASSERT_EQ(url_unreserved_prefix_length("abcdefghijklmnopqrstuvwxyz-ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789.", 65), 65);
+  ASSERT_EQ(url_unreserved_prefix_length("abcdefghijklmnopqrstuvwxyz@", 27), 26);
+  ASSERT_EQ(url_unreserved_prefix_length("abcdefghijklmnopqrstuvwxyz[", 27), 26);
+  ASSERT_EQ(url_unreserved_prefix_length("abcdefghijklmnopqrstuvwxyz/", 27), 26);
+}
+
+TEST(string_kernels, hex_encode) {
+  std::mt19937 gen{19};
+  for (size_t len = 0; len < 100; ++len) {
+    const std::string text = random_text(gen, len);
+    std::string actual(2 * len, '\0');
+    std::string expected(2 * len, '\0');
+    hex_encode(text.data(), len, &actual[0]);
+    hex_encode_generic(text.data(), len, &expected[0]);
+    ASSERT_EQ(actual, expected);
+  }
+
+  std::string hex(40, '\0');
+  hex_encode("\x00\x01\x7f\x80\xab\xffhello, world!!!!!", 20, &hex[0]);
+  ASSERT_EQ(hex, "00017f80abff68656c6c6f2c20776f726c642121");
+}
+
+TEST(string_kernels, base64) {
+  std::mt19937 gen{23};
+  for (size_t len = 0; len < 200; ++len) {
+    const std::string text = random_text(gen, len);
+    const size_t encoded_len = len / 3 * 4;
+    std::string actual(encoded_len, '\0');
+    std::string expected(encoded_len, '\0');
+    ASSERT_EQ(base64_encode_groups(text.data(), len, &actual[0]), len / 3 * 3);
+    ASSERT_EQ(base64_encode_groups_generic(text.data(), len, &expected[0]), len / 3 * 3);
+    ASSERT_EQ(actual, expected);
+
+    std::string decoded(len / 3 * 3, '\0');
+    ASSERT_EQ(base64_decode_groups(actual.data(), encoded_len, &decoded[0]), encoded_len);
+    ASSERT_EQ(decoded, text.substr(0, len / 3 * 3));
+
+    // a char out of the alphabet stops the decoding at its group
+    if (encoded_len) {
+      const size_t bad_pos = gen() % encoded_len;
+      actual[bad_pos] = "=\n -\x80"[gen() % 5];
+      ASSERT_EQ(base64_decode_groups(actual.data(), encoded_len, &decoded[0]), bad_pos / 4 * 4);
+      ASSERT_EQ(decoded.substr(0, bad_pos / 4 * 3), text.substr(0, bad_pos / 4 * 3));
+    }
+  }
+
+  std::string encoded(20, '\0');
+  base64_encode_groups("Many hands make light", 15, &encoded[0]);
+  ASSERT_EQ(encoded, "TWFueSBoYW5kcyBtYWtl");
+}
+
+TEST(string_kernels, utf8_validate) {
+  ASSERT_TRUE(utf8_validate("", 0));
+  const std::string valid[] = {
+    "hello", "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\x9f\xbf", "\xef\xbf\xbf", "\xf4\x8f\xbf\xbf",
+    std::string(100, 'a') + "\xe2\x82\xac" + std::string(13, 'b') + "\xf0\x9f\x98\x80",
+  };
+  for (const auto &text : valid) {
+    ASSERT_TRUE(utf8_validate(text.data(), text.size())) << text;
+  }
+
+  const std::string invalid[] = {
+    "\x80", "\xff", "\xc3", "\xe2\x82", "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xed\xa0\x80", "\xf0\x80\x80\x80", "\xf4\x90\x80\x80",
+    "\xf8\x88\x80\x80\x80", std::string(15, 'a') + "\xf0\x9f\x98", std::string(31, 'a') + "\xd0", std::string(64, 'a') + "\x80",
+  };
+  for (const auto &text : invalid) {
+    ASSERT_FALSE(utf8_validate(text.data(), text.size())) << text;
+  }
+}
+
+TEST(string_kernels, utf8_validate_random) {
+  const std::string pieces[] = {
+    "a", "Z", " ", "\xd0\xbf", "\xe2\x82\xac", "\xf0\x9f\x98\x80", std::string(1, '\0'),
+    "\xc0\x80", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xe0\x80\x80", "\x80", "\xff", "\xc3", "\xe2\x82",
+  };
+  std::mt19937 gen{7};
+  for (size_t iteration = 0; iteration < 20000; ++iteration) {
+    std::string text;
+    const size_t pieces_count = gen() % 100;
+    for (size_t i = 0; i < pieces_count; ++i) {
+      // mostly valid text with rare broken sequences
+      text += pieces[gen() % 100 < 95 ? gen() % 7 : gen() % 15];
+    }
+    ASSERT_EQ(utf8_validate(text.data(), text.size()), utf8_validate_generic(text.data(), text.size()));
+    ASSERT_EQ(utf8_code_points_count(text.data(), text.size()), utf8_code_points_count_generic(text.data(), text.size()));
+    ASSERT_EQ(ascii_prefix_length(text.data(), text.size()), ascii_prefix_length_generic(text.data(), text.size()));
+  }
+}
+
+TEST(string_kernels, json_find_tokens) {
+  const std::string json = R"({"a\"b": [1, -2.5e3,true], "c":"\\", "d" :null})";
+  std::vector<uint32_t> positions(json.size());
+  const size_t count = json_find_tokens(json.data(), json.size(), positions.data());
+  std::string tokens;
+  for (size_t i = 0; i < count; ++i) {
+    tokens += json[positions[i]];
+  }
+  ASSERT_EQ(tokens, R"({":[1,-,t],":",":n})");
+}
+
+TEST(string_kernels, json_find_tokens_random) {
+  const char *pieces[] = {"{", "}", "[", "]", ":", ",", " ", "\n", "\"", "\\", "\\\\", "\\\"", "1", "-0.5", "true", "ab", "\xd0\xbf"};
+  std::mt19937 gen{3};
+  for (size_t iteration = 0; iteration < 20000; ++iteration) {
+    std::string text;
+    const size_t pieces_count = gen() % 150;
+    for (size_t i = 0; i < pieces_count; ++i) {
+      text += pieces[gen() % (sizeof(pieces) / sizeof(pieces[0]))];
+    }
+    std::vector<uint32_t> actual(text.size());
+    std::vector<uint32_t> expected(text.size());
+    actual.resize(json_find_tokens(text.data(), text.size(), actual.data()));
+    expected.resize(json_find_tokens_generic(text.data(), text.size(), expected.data()));
+    ASSERT_EQ(actual, expected) << text;
+  }
+}
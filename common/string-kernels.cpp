@@ -0,0 +1,237 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/string-kernels.h"
+
+find_first_of_chars_func_t find_first_of_chars;
+ascii_convert_case_func_t ascii_to_lower;
+ascii_convert_case_func_t ascii_to_upper;
+ascii_prefix_length_func_t ascii_prefix_length;
+http_token_length_func_t http_token_length;
+url_unreserved_prefix_length_func_t url_unreserved_prefix_length;
+hex_encode_func_t hex_encode;
+base64_encode_groups_func_t base64_encode_groups;
+base64_decode_groups_func_t base64_decode_groups;
+json_unescaped_prefix_length_func_t json_unescaped_prefix_length;
+utf8_code_points_count_func_t utf8_code_points_count;
+utf8_validate_func_t utf8_validate;
+json_find_tokens_func_t json_find_tokens;
+
+size_t find_first_of_chars_generic(const char *s, size_t len, const char *chars, size_t chars_count) {
+  for (size_t i = 0; i < len; ++i) {
+    for (size_t j = 0; j < chars_count; ++j) {
+      if (s[i] == chars[j]) {
+        return i;
+      }
+    }
+  }
+  return len;
+}
+
+size_t ascii_to_lower_generic(char *dst, const char *src, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    const unsigned char c = src[i];
+    if (c & 0x80) {
+      return i;
+    }
+    dst[i] = static_cast<char>(static_cast<unsigned>(c - 'A') < 26u ? c + ('a' - 'A') : c);
+  }
+  return len;
+}
+
+size_t ascii_to_upper_generic(char *dst, const char *src, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    const unsigned char c = src[i];
+    if (c & 0x80) {
+      return i;
+    }
+    dst[i] = static_cast<char>(static_cast<unsigned>(c - 'a') < 26u ? c - ('a' - 'A') : c);
+  }
+  return len;
+}
+
+size_t ascii_prefix_length_generic(const char *s, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (static_cast<signed char>(s[i]) <= 0) {
+      return i;
+    }
+  }
+  return len;
+}
+
+size_t http_token_length_generic(const char *s, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (static_cast<unsigned char>(s[i]) <= ' ') {
+      return i;
+    }
+  }
+  return len;
+}
+
+size_t url_unreserved_prefix_length_generic(const char *s, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    const unsigned char c = s[i];
+    if (!(static_cast<unsigned>(c - '0') < 10u || static_cast<unsigned>((c | 0x20) - 'a') < 26u || c == '-' || c == '_' || c == '.')) {
+      return i;
+    }
+  }
+  return len;
+}
+
+void hex_encode_generic(const char *src, size_t len, char *dst) {
+  static const char digits[] = "0123456789abcdef";
+  for (size_t i = 0; i < len; ++i) {
+    const unsigned char c = src[i];
+    dst[2 * i] = digits[c >> 4];
+    dst[2 * i + 1] = digits[c & 15];
+  }
+}
+
+static const char base64_symbols[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+size_t base64_encode_groups_generic(const char *src, size_t len, char *dst) {
+  const size_t groups_len = len / 3 * 3;
+  for (size_t i = 0; i < groups_len; i += 3, dst += 4) {
+    const uint32_t group = (static_cast<unsigned char>(src[i]) << 16) | (static_cast<unsigned char>(src[i + 1]) << 8) | static_cast<unsigned char>(src[i + 2]);
+    dst[0] = base64_symbols[group >> 18];
+    dst[1] = base64_symbols[(group >> 12) & 63];
+    dst[2] = base64_symbols[(group >> 6) & 63];
+    dst[3] = base64_symbols[group & 63];
+  }
+  return groups_len;
+}
+
+static int base64_symbol_value(unsigned char c) {
+  if (static_cast<unsigned>(c - 'A') < 26u) {
+    return c - 'A';
+  }
+  if (static_cast<unsigned>(c - 'a') < 26u) {
+    return c - 'a' + 26;
+  }
+  if (static_cast<unsigned>(c - '0') < 10u) {
+    return c - '0' + 52;
+  }
+  return c == '+' ? 62 : (c == '/' ? 63 : -1);
+}
+
+size_t base64_decode_groups_generic(const char *src, size_t len, char *dst) {
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4, dst += 3) {
+    const int a = base64_symbol_value(src[i]);
+    const int b = base64_symbol_value(src[i + 1]);
+    const int c = base64_symbol_value(src[i + 2]);
+    const int d = base64_symbol_value(src[i + 3]);
+    if ((a | b | c | d) < 0) {
+      break;
+    }
+    const uint32_t group = (a << 18) | (b << 12) | (c << 6) | d;
+    dst[0] = static_cast<char>(group >> 16);
+    dst[1] = static_cast<char>(group >> 8);
+    dst[2] = static_cast<char>(group);
+  }
+  return i;
+}
+
+size_t json_unescaped_prefix_length_generic(const char *s, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    const unsigned char c = s[i];
+    if (c < 0x20 || c == '"' || c == '\\' || c == '/') {
+      return i;
+    }
+  }
+  return len;
+}
+
+size_t utf8_code_points_count_generic(const char *s, size_t len) {
+  size_t res = 0;
+  for (size_t i = 0; i < len; ++i) {
+    if ((static_cast<unsigned char>(s[i]) & 0xc0) != 0x80) {
+      ++res;
+    }
+  }
+  return res;
+}
+
+size_t utf8_valid_code_point_length(const char *s, size_t len) {
+#define CHECK(condition) if (!(condition)) {return 0;}
+  CHECK(len > 0);
+  unsigned int a = static_cast<unsigned char>(s[0]);
+  if ((a & 0x80) == 0) {
+    return 1;
+  }
+
+  CHECK((a & 0x40) != 0);
+
+  CHECK(len > 1);
+  unsigned int b = static_cast<unsigned char>(s[1]);
+  CHECK((b & 0xc0) == 0x80);
+  if ((a & 0x20) == 0) {
+    CHECK((a & 0x1e) > 0);
+    return 2;
+  }
+
+  CHECK(len > 2);
+  unsigned int c = static_cast<unsigned char>(s[2]);
+  CHECK((c & 0xc0) == 0x80);
+  if ((a & 0x10) == 0) {
+    int x = (((a & 0x0f) << 6) | (b & 0x20));
+    CHECK(x != 0 && x != 0x360);//surrogates
+    return 3;
+  }
+
+  CHECK(len > 3);
+  unsigned int d = static_cast<unsigned char>(s[3]);
+  CHECK((d & 0xc0) == 0x80);
+  if ((a & 0x08) == 0) {
+    int t = (((a & 0x07) << 6) | (b & 0x30));
+    CHECK(0 < t && t < 0x110);//end of unicode
+    return 4;
+  }
+#undef CHECK
+  return 0;
+}
+
+bool utf8_validate_generic(const char *s, size_t len) {
+  for (size_t i = 0; i < len;) {
+    const size_t code_point_length = utf8_valid_code_point_length(s + i, len - i);
+    if (code_point_length == 0) {
+      return false;
+    }
+    i += code_point_length;
+  }
+  return true;
+}
+
+// a backslash escapes the next byte even outside of strings, the vectorized versions do the same
+size_t json_find_tokens_generic(const char *s, size_t len, uint32_t *positions) {
+  size_t count = 0;
+  bool in_string = false;
+  bool escaped = false;
+  bool prev_scalar = false;
+  for (size_t i = 0; i < len; ++i) {
+    const char c = s[i];
+    const bool is_escaped = escaped;
+    escaped = c == '\\' && !is_escaped;
+    if (c == '"' && !is_escaped) {
+      in_string = !in_string;
+      if (in_string) {
+        positions[count++] = static_cast<uint32_t>(i);
+      }
+      prev_scalar = false;
+    } else if (in_string) {
+      prev_scalar = false;
+    } else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') {
+      positions[count++] = static_cast<uint32_t>(i);
+      prev_scalar = false;
+    } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      prev_scalar = false;
+    } else {
+      if (!prev_scalar) {
+        positions[count++] = static_cast<uint32_t>(i);
+      }
+      prev_scalar = true;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,76 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#ifndef __STRING_KERNELS_H__
+#define __STRING_KERNELS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// at most that many chars can be passed to the find_first_of_chars
+constexpr size_t FIND_FIRST_OF_MAX_CHARS = 16;
+
+// returns the position of the first byte of s that is one of chars[0..chars_count), or len if there is no such byte
+typedef size_t (*find_first_of_chars_func_t)(const char *s, size_t len, const char *chars, size_t chars_count);
+// converts ascii letters from src into dst until the first non ascii byte, returns its position or len;
+// dst bytes after the returned position may be overwritten and must be rewritten by the caller
+typedef size_t (*ascii_convert_case_func_t)(char *dst, const char *src, size_t len);
+// returns the length of the longest prefix of s that consists of non zero ascii bytes
+typedef size_t (*ascii_prefix_length_func_t)(const char *s, size_t len);
+// returns the length of the longest prefix of s without spaces and control characters, i.e. of bytes above ' ' as unsigned;
+// it is a token of the http request line or a header
+typedef size_t (*http_token_length_func_t)(const char *s, size_t len);
+// returns the length of the longest prefix of s that is not changed by the url encoding, i.e. of [0-9A-Za-z._-] bytes
+typedef size_t (*url_unreserved_prefix_length_func_t)(const char *s, size_t len);
+// writes 2 * len lowercase hex digits of src bytes into dst
+typedef void (*hex_encode_func_t)(const char *src, size_t len, char *dst);
+// encodes the whole 3 byte groups of src into base64, returns the number of encoded bytes, i.e. len / 3 * 3
+typedef size_t (*base64_encode_groups_func_t)(const char *src, size_t len, char *dst);
+// decodes the longest prefix of the whole 4 char groups of src that consist of base64 alphabet chars only,
+// i.e. without paddings and whitespaces, returns the number of decoded chars; dst must have room for len / 4 * 3 bytes
+typedef size_t (*base64_decode_groups_func_t)(const char *src, size_t len, char *dst);
+// returns the length of the longest prefix of s that is copied into a json string as is:
+// it has no control characters, quotes, backslashes and slashes, non ascii bytes are not escaped
+typedef size_t (*json_unescaped_prefix_length_func_t)(const char *s, size_t len);
+// counts utf-8 code points in s, i.e. bytes that are not continuation bytes
+typedef size_t (*utf8_code_points_count_func_t)(const char *s, size_t len);
+// checks that s is well-formed utf-8: no overlong encodings, surrogates and code points above U+10FFFF
+typedef bool (*utf8_validate_func_t)(const char *s, size_t len);
+// the first stage of json parsing: writes into positions the offsets of all json tokens of s, i.e.
+// structural characters {}[]:, and opening quotes outside of strings and the first bytes of literals and numbers,
+// returns the number of written offsets; positions must have room for len offsets
+typedef size_t (*json_find_tokens_func_t)(const char *s, size_t len, uint32_t *positions);
+
+extern find_first_of_chars_func_t find_first_of_chars;
+extern ascii_convert_case_func_t ascii_to_lower;
+extern ascii_convert_case_func_t ascii_to_upper;
+extern ascii_prefix_length_func_t ascii_prefix_length;
+extern http_token_length_func_t http_token_length;
+extern url_unreserved_prefix_length_func_t url_unreserved_prefix_length;
+extern hex_encode_func_t hex_encode;
+extern base64_encode_groups_func_t base64_encode_groups;
+extern base64_decode_groups_func_t base64_decode_groups;
+extern json_unescaped_prefix_length_func_t json_unescaped_prefix_length;
+extern utf8_code_points_count_func_t utf8_code_points_count;
+extern utf8_validate_func_t utf8_validate;
+extern json_find_tokens_func_t json_find_tokens;
+
+size_t find_first_of_chars_generic(const char *s, size_t len, const char *chars, size_t chars_count);
+size_t ascii_to_lower_generic(char *dst, const char *src, size_t len);
+size_t ascii_to_upper_generic(char *dst, const char *src, size_t len);
+// returns the length of a well-formed utf-8 code point at the beginning of s, or 0 if there is none
+size_t utf8_valid_code_point_length(const char *s, size_t len);
+
+size_t ascii_prefix_length_generic(const char *s, size_t len);
+size_t http_token_length_generic(const char *s, size_t len);
+size_t url_unreserved_prefix_length_generic(const char *s, size_t len);
+void hex_encode_generic(const char *src, size_t len, char *dst);
+size_t base64_encode_groups_generic(const char *src, size_t len, char *dst);
+size_t base64_decode_groups_generic(const char *src, size_t len, char *dst);
+size_t json_unescaped_prefix_length_generic(const char *s, size_t len);
+size_t utf8_code_points_count_generic(const char *s, size_t len);
+bool utf8_validate_generic(const char *s, size_t len);
+size_t json_find_tokens_generic(const char *s, size_t len, uint32_t *positions);
+
+#endif
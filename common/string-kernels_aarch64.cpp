@@ -0,0 +1,183 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include <assert.h>
+
+#include <arm_neon.h>
+
+#include "common/cpuid.h"
+#include "common/string-kernels.h"
+
+static size_t find_first_of_chars_neon(const char *s, size_t len, const char *chars, size_t chars_count) {
+  assert(chars_count <= FIND_FIRST_OF_MAX_CHARS);
+  if (chars_count == 0) {
+    return len;
+  }
+
+  uint8x16_t chars_vectors[FIND_FIRST_OF_MAX_CHARS];
+  for (size_t j = 0; j < chars_count; ++j) {
+    chars_vectors[j] = vdupq_n_u8(static_cast<uint8_t>(chars[j]));
+  }
+
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t *>(s + i));
+    uint8x16_t eq = vceqq_u8(block, chars_vectors[0]);
+    for (size_t j = 1; j < chars_count; ++j) {
+      eq = vorrq_u8(eq, vceqq_u8(block, chars_vectors[j]));
+    }
+    if (vmaxvq_u8(eq)) {
+      return i + find_first_of_chars_generic(s + i, 16, chars, chars_count);
+    }
+  }
+  return i + find_first_of_chars_generic(s + i, len - i, chars, chars_count);
+}
+
+// xor with 0x20 switches the case of an ascii letter in both directions
+template<char first>
+static size_t ascii_convert_case_neon(char *dst, const char *src, size_t len, ascii_convert_case_func_t generic_tail) {
+  const uint8x16_t first_vector = vdupq_n_u8(static_cast<uint8_t>(first));
+  const uint8x16_t letters_count = vdupq_n_u8(26);
+  const uint8x16_t case_bit = vdupq_n_u8(0x20);
+
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t *>(src + i));
+    const uint8x16_t in_range = vcltq_u8(vsubq_u8(block, first_vector), letters_count);
+    vst1q_u8(reinterpret_cast<uint8_t *>(dst + i), veorq_u8(block, vandq_u8(in_range, case_bit)));
+    if (vmaxvq_u8(block) & 0x80) {
+      return i + generic_tail(dst + i, src + i, 16);
+    }
+  }
+  return i + generic_tail(dst + i, src + i, len - i);
+}
+
+static size_t ascii_to_lower_neon(char *dst, const char *src, size_t len) {
+  return ascii_convert_case_neon<'A'>(dst, src, len, ascii_to_lower_generic);
+}
+
+static size_t ascii_to_upper_neon(char *dst, const char *src, size_t len) {
+  return ascii_convert_case_neon<'a'>(dst, src, len, ascii_to_upper_generic);
+}
+
+static size_t ascii_prefix_length_neon(const char *s, size_t len) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const int8x16_t block = vld1q_s8(reinterpret_cast<const int8_t *>(s + i));
+    // non ascii bytes are negative
+    if (vminvq_s8(block) <= 0) {
+      return i + ascii_prefix_length_generic(s + i, 16);
+    }
+  }
+  return i + ascii_prefix_length_generic(s + i, len - i);
+}
+
+static size_t http_token_length_neon(const char *s, size_t len) {
+  const uint8x16_t space = vdupq_n_u8(' ');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t *>(s + i));
+    if (vmaxvq_u8(vcleq_u8(block, space))) {
+      return i + http_token_length_generic(s + i, 16);
+    }
+  }
+  return i + http_token_length_generic(s + i, len - i);
+}
+
+static size_t url_unreserved_prefix_length_neon(const char *s, size_t len) {
+  const uint8x16_t case_bit = vdupq_n_u8(0x20);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t *>(s + i));
+    const uint8x16_t letter = vcleq_u8(vsubq_u8(vorrq_u8(block, case_bit), vdupq_n_u8('a')), vdupq_n_u8('z' - 'a'));
+    const uint8x16_t digit = vcleq_u8(vsubq_u8(block, vdupq_n_u8('0')), vdupq_n_u8('9' - '0'));
+    const uint8x16_t special = vorrq_u8(vceqq_u8(block, vdupq_n_u8('-')), vorrq_u8(vceqq_u8(block, vdupq_n_u8('_')), vceqq_u8(block, vdupq_n_u8('.'))));
+    if (vminvq_u8(vorrq_u8(letter, vorrq_u8(digit, special))) == 0) {
+      return i + url_unreserved_prefix_length_generic(s + i, 16);
+    }
+  }
+  return i + url_unreserved_prefix_length_generic(s + i, len - i);
+}
+
+static void hex_encode_neon(const char *src, size_t len, char *dst) {
+  const uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t *>("0123456789abcdef"));
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t *>(src + i));
+    uint8x16x2_t hex;
+    hex.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(block, 4));
+    hex.val[1] = vqtbl1q_u8(digits, vandq_u8(block, vdupq_n_u8(0x0f)));
+    vst2q_u8(reinterpret_cast<uint8_t *>(dst + 2 * i), hex);
+  }
+  hex_encode_generic(src + i, len - i, dst + 2 * i);
+}
+
+static size_t json_unescaped_prefix_length_neon(const char *s, size_t len) {
+  const uint8x16_t space = vdupq_n_u8(' ');
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  const uint8x16_t slash = vdupq_n_u8('/');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t *>(s + i));
+    const uint8x16_t special = vorrq_u8(vorrq_u8(vcltq_u8(block, space), vceqq_u8(block, quote)),
+                                        vorrq_u8(vceqq_u8(block, backslash), vceqq_u8(block, slash)));
+    if (vmaxvq_u8(special)) {
+      return i + json_unescaped_prefix_length_generic(s + i, 16);
+    }
+  }
+  return i + json_unescaped_prefix_length_generic(s + i, len - i);
+}
+
+// continuation bytes 10xxxxxx are the only ones less than -64 as signed
+static size_t utf8_code_points_count_neon(const char *s, size_t len) {
+  const int8x16_t last_continuation = vdupq_n_s8(static_cast<int8_t>(0xbf));
+  const uint8x16_t one = vdupq_n_u8(1);
+  size_t res = 0;
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const int8x16_t block = vld1q_s8(reinterpret_cast<const int8_t *>(s + i));
+    res += vaddvq_u8(vandq_u8(vcgtq_s8(block, last_continuation), one));
+  }
+  return res + utf8_code_points_count_generic(s + i, len - i);
+}
+
+// ascii blocks are skipped with simd, code points around non ascii bytes are checked one by one
+static bool utf8_validate_neon(const char *s, size_t len) {
+  size_t i = 0;
+  while (i < len) {
+    if (i + 16 <= len && vmaxvq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(s + i))) < 0x80) {
+      i += 16;
+      continue;
+    }
+    const size_t block_end = i + 16 < len ? i + 16 : len;
+    while (i < block_end) {
+      const size_t code_point_length = utf8_valid_code_point_length(s + i, len - i);
+      if (code_point_length == 0) {
+        return false;
+      }
+      i += code_point_length;
+    }
+  }
+  return true;
+}
+
+void __attribute__((constructor(101))) string_kernels_init() {
+  const kdb_cpuid_t *p = kdb_cpuid();
+  assert(p->type == KDB_CPUID_AARCH64);
+
+  find_first_of_chars = find_first_of_chars_neon;
+  ascii_to_lower = ascii_to_lower_neon;
+  ascii_to_upper = ascii_to_upper_neon;
+  ascii_prefix_length = ascii_prefix_length_neon;
+  http_token_length = http_token_length_neon;
+  json_unescaped_prefix_length = json_unescaped_prefix_length_neon;
+  utf8_code_points_count = utf8_code_points_count_neon;
+  utf8_validate = utf8_validate_neon;
+  json_find_tokens = json_find_tokens_generic;
+  url_unreserved_prefix_length = url_unreserved_prefix_length_neon;
+  hex_encode = hex_encode_neon;
+  base64_encode_groups = base64_encode_groups_generic;
+  base64_decode_groups = base64_decode_groups_generic;
+}
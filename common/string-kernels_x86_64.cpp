@@ -0,0 +1,651 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#include "common/cpuid.h"
+#include "common/string-kernels.h"
+
+// the tail shorter than a vector is copied into a local buffer, so we never read past the end of the string
+__attribute__((target("sse4.2")))
+static size_t find_first_of_chars_sse42(const char *s, size_t len, const char *chars, size_t chars_count) {
+  assert(chars_count <= FIND_FIRST_OF_MAX_CHARS);
+  constexpr int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT;
+
+  char chars_buf[16] = {0};
+  memcpy(chars_buf, chars, chars_count);
+  const __m128i chars_vector = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chars_buf));
+  const int chars_len = static_cast<int>(chars_count);
+
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    const int pos = _mm_cmpestri(chars_vector, chars_len, block, 16, mode);
+    if (pos != 16) {
+      return i + pos;
+    }
+  }
+  if (i < len) {
+    char tail_buf[16];
+    memcpy(tail_buf, s + i, len - i);
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tail_buf));
+    const int pos = _mm_cmpestri(chars_vector, chars_len, block, static_cast<int>(len - i), mode);
+    if (pos != 16) {
+      return i + pos;
+    }
+  }
+  return len;
+}
+
+__attribute__((target("avx2,sse4.2")))
+static size_t find_first_of_chars_avx2(const char *s, size_t len, const char *chars, size_t chars_count) {
+  assert(chars_count <= FIND_FIRST_OF_MAX_CHARS);
+  if (len < 32 || chars_count == 0) {
+    return find_first_of_chars_sse42(s, len, chars, chars_count);
+  }
+
+  __m256i chars_vectors[FIND_FIRST_OF_MAX_CHARS];
+  for (size_t j = 0; j < chars_count; ++j) {
+    chars_vectors[j] = _mm256_set1_epi8(chars[j]);
+  }
+
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+    __m256i eq = _mm256_cmpeq_epi8(block, chars_vectors[0]);
+    for (size_t j = 1; j < chars_count; ++j) {
+      eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(block, chars_vectors[j]));
+    }
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + find_first_of_chars_sse42(s + i, len - i, chars, chars_count);
+}
+
+// xor with 0x20 switches the case of an ascii letter in both directions
+template<char first, char last>
+static size_t ascii_convert_case_sse2(char *dst, const char *src, size_t len, ascii_convert_case_func_t generic_tail) {
+  const __m128i before_first = _mm_set1_epi8(first - 1);
+  const __m128i after_last = _mm_set1_epi8(last + 1);
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    // non ascii bytes are negative, so they are never in range
+    const __m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(block, before_first), _mm_cmplt_epi8(block, after_last));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(block, _mm_and_si128(in_range, case_bit)));
+    const int non_ascii_mask = _mm_movemask_epi8(block);
+    if (non_ascii_mask) {
+      return i + __builtin_ctz(non_ascii_mask);
+    }
+  }
+  return i + generic_tail(dst + i, src + i, len - i);
+}
+
+template<char first, char last>
+__attribute__((target("avx2")))
+static size_t ascii_convert_case_avx2(char *dst, const char *src, size_t len, ascii_convert_case_func_t generic_tail) {
+  const __m256i before_first = _mm256_set1_epi8(first - 1);
+  const __m256i after_last = _mm256_set1_epi8(last + 1);
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    const __m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi8(block, before_first), _mm256_cmpgt_epi8(after_last, block));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(block, _mm256_and_si256(in_range, case_bit)));
+    const unsigned non_ascii_mask = static_cast<unsigned>(_mm256_movemask_epi8(block));
+    if (non_ascii_mask) {
+      return i + __builtin_ctz(non_ascii_mask);
+    }
+  }
+  return i + ascii_convert_case_sse2<first, last>(dst + i, src + i, len - i, generic_tail);
+}
+
+static size_t ascii_to_lower_sse2(char *dst, const char *src, size_t len) {
+  return ascii_convert_case_sse2<'A', 'Z'>(dst, src, len, ascii_to_lower_generic);
+}
+
+static size_t ascii_to_upper_sse2(char *dst, const char *src, size_t len) {
+  return ascii_convert_case_sse2<'a', 'z'>(dst, src, len, ascii_to_upper_generic);
+}
+
+__attribute__((target("avx2")))
+static size_t ascii_to_lower_avx2(char *dst, const char *src, size_t len) {
+  return ascii_convert_case_avx2<'A', 'Z'>(dst, src, len, ascii_to_lower_generic);
+}
+
+__attribute__((target("avx2")))
+static size_t ascii_to_upper_avx2(char *dst, const char *src, size_t len) {
+  return ascii_convert_case_avx2<'a', 'z'>(dst, src, len, ascii_to_upper_generic);
+}
+
+static size_t ascii_prefix_length_sse2(const char *s, size_t len) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    // non ascii bytes are negative
+    const unsigned bad_mask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(block, zero))) & 0xffff;
+    if (bad_mask) {
+      return i + __builtin_ctz(bad_mask);
+    }
+  }
+  return i + ascii_prefix_length_generic(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t ascii_prefix_length_avx2(const char *s, size_t len) {
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+    const unsigned bad_mask = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(block, zero)));
+    if (bad_mask) {
+      return i + __builtin_ctz(bad_mask);
+    }
+  }
+  return i + ascii_prefix_length_sse2(s + i, len - i);
+}
+
+// the unsigned maximum with ' ' is ' ' only for the spaces and the control characters
+static size_t http_token_length_sse2(const char *s, size_t len) {
+  const __m128i space = _mm_set1_epi8(' ');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    const int bad_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(block, space), space));
+    if (bad_mask) {
+      return i + __builtin_ctz(bad_mask);
+    }
+  }
+  return i + http_token_length_generic(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t http_token_length_avx2(const char *s, size_t len) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+    const unsigned bad_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(block, space), space));
+    if (bad_mask) {
+      return i + __builtin_ctz(bad_mask);
+    }
+  }
+  return i + http_token_length_sse2(s + i, len - i);
+}
+
+// non ascii bytes are negative, so they are never in range
+static inline __m128i bytes_in_range_sse2(__m128i block, char first, char last) {
+  return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(first - 1))), _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(last + 1))));
+}
+
+static size_t url_unreserved_prefix_length_sse2(const char *s, size_t len) {
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    const __m128i letter = bytes_in_range_sse2(_mm_or_si128(block, case_bit), 'a', 'z');
+    const __m128i digit = bytes_in_range_sse2(block, '0', '9');
+    const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('-')),
+                                         _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('_')), _mm_cmpeq_epi8(block, _mm_set1_epi8('.'))));
+    const unsigned bad_mask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(letter, _mm_or_si128(digit, special)))) & 0xffff;
+    if (bad_mask) {
+      return i + __builtin_ctz(bad_mask);
+    }
+  }
+  return i + url_unreserved_prefix_length_generic(s + i, len - i);
+}
+
+__attribute__((target("ssse3")))
+static void hex_encode_ssse3(const char *src, size_t len, char *dst) {
+  const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m128i low_nibble = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    const __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(block, 4), low_nibble));
+    const __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(block, low_nibble));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+  }
+  hex_encode_generic(src + i, len - i, dst + 2 * i);
+}
+
+// W. Muła's approach: the 3 byte groups are spread over the 4 byte lanes, the 6 bit indices are cut out by multiplications,
+// and the offset from the index to the ascii symbol is taken from a 16 entry table by the index range
+__attribute__((target("ssse3")))
+static size_t base64_encode_groups_ssse3(const char *src, size_t len, char *dst) {
+  const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  size_t i = 0;
+  // 16 bytes are loaded for 12 encoded ones
+  for (; i + 16 <= len; i += 12, dst += 16) {
+    const __m128i block = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), spread);
+    const __m128i high = _mm_mulhi_epu16(_mm_and_si128(block, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    const __m128i low = _mm_mullo_epi16(_mm_and_si128(block, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(high, low);
+    __m128i ranges = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    ranges = _mm_or_si128(ranges, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, ranges)));
+  }
+  return i + base64_encode_groups_generic(src + i, len - i, dst);
+}
+
+__attribute__((target("ssse3")))
+static size_t base64_decode_groups_ssse3(const char *src, size_t len, char *dst) {
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  size_t i = 0;
+  // 16 bytes are stored for 12 decoded ones, so there must be room for them
+  for (; i + 24 <= len; i += 16, dst += 12) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    const __m128i upper = bytes_in_range_sse2(block, 'A', 'Z');
+    const __m128i lower = bytes_in_range_sse2(block, 'a', 'z');
+    const __m128i digit = bytes_in_range_sse2(block, '0', '9');
+    const __m128i plus = _mm_cmpeq_epi8(block, _mm_set1_epi8('+'));
+    const __m128i slash = _mm_cmpeq_epi8(block, _mm_set1_epi8('/'));
+    const __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+    if (_mm_movemask_epi8(valid) != 0xffff) {
+      break;
+    }
+    __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    shift = _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+    shift = _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+    const __m128i values = _mm_add_epi8(block, shift);
+    // the 6 bit values are merged into 12 bit pairs and then into the 24 bit groups
+    const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_shuffle_epi8(groups, pack));
+  }
+  return i + base64_decode_groups_generic(src + i, len - i, dst);
+}
+
+// as signed, the control characters are the only bytes in [0, 0x20), non ascii bytes are negative and pass as is
+static size_t json_unescaped_prefix_length_sse2(const char *s, size_t len) {
+  const __m128i minus_one = _mm_set1_epi8(-1);
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i slash = _mm_set1_epi8('/');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    const __m128i control = _mm_and_si128(_mm_cmpgt_epi8(block, minus_one), _mm_cmplt_epi8(block, space));
+    const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_or_si128(_mm_cmpeq_epi8(block, backslash), _mm_cmpeq_epi8(block, slash)));
+    const int bad_mask = _mm_movemask_epi8(_mm_or_si128(control, special));
+    if (bad_mask) {
+      return i + __builtin_ctz(bad_mask);
+    }
+  }
+  return i + json_unescaped_prefix_length_generic(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t json_unescaped_prefix_length_avx2(const char *s, size_t len) {
+  const __m256i minus_one = _mm256_set1_epi8(-1);
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i slash = _mm256_set1_epi8('/');
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+    const __m256i control = _mm256_and_si256(_mm256_cmpgt_epi8(block, minus_one), _mm256_cmpgt_epi8(space, block));
+    const __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(block, quote),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(block, backslash), _mm256_cmpeq_epi8(block, slash)));
+    const unsigned bad_mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(control, special)));
+    if (bad_mask) {
+      return i + __builtin_ctz(bad_mask);
+    }
+  }
+  return i + json_unescaped_prefix_length_sse2(s + i, len - i);
+}
+
+// continuation bytes 10xxxxxx are the only ones less than -64 as signed
+__attribute__((target("popcnt")))
+static size_t utf8_code_points_count_sse2(const char *s, size_t len) {
+  const __m128i last_continuation = _mm_set1_epi8(static_cast<char>(0xbf));
+  size_t res = 0;
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    res += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(block, last_continuation)));
+  }
+  return res + utf8_code_points_count_generic(s + i, len - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t utf8_code_points_count_avx2(const char *s, size_t len) {
+  const __m256i last_continuation = _mm256_set1_epi8(static_cast<char>(0xbf));
+  size_t res = 0;
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+    res += __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(block, last_continuation))));
+  }
+  return res + utf8_code_points_count_sse2(s + i, len - i);
+}
+
+// utf-8 validation by the lookup algorithm from
+// J. Keiser, D. Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte" (simdjson, simdutf):
+// every error is recognized by looking at the high and low nibbles of the previous byte and the high nibble of the current one
+namespace {
+
+enum : uint8_t {
+  UTF8_TOO_SHORT = 1 << 0,  // 11______ 0_______ or 11______ 11______
+  UTF8_TOO_LONG = 1 << 1,   // 0_______ 10______
+  UTF8_OVERLONG_3 = 1 << 2, // 11100000 100_____
+  UTF8_TOO_LARGE = 1 << 3,  // 11110100 1001____ or 11110100 101_____ or 11110101+ 10______
+  UTF8_SURROGATE = 1 << 4,  // 11101101 101_____
+  UTF8_OVERLONG_2 = 1 << 5, // 1100000_ 10______
+  UTF8_TOO_LARGE_1000 = 1 << 6, // 11110101+ 1000____
+  UTF8_OVERLONG_4 = 1 << 6, // 11110000 1000____
+  UTF8_TWO_CONTS = 1 << 7,  // 10______ 10______
+  UTF8_CARRY = UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS,
+};
+
+struct Utf8CheckerSsse3 {
+  __m128i error = _mm_setzero_si128();
+  __m128i prev_input = _mm_setzero_si128();
+  __m128i prev_incomplete = _mm_setzero_si128();
+
+  __attribute__((target("ssse3")))
+  static __m128i high_nibbles(__m128i v) {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+  }
+
+  __attribute__((target("ssse3")))
+  static __m128i special_cases(__m128i input, __m128i prev1) {
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+      UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+      UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+      UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+      UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+      UTF8_TOO_SHORT,
+      UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+      UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4);
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+      UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+      UTF8_CARRY | UTF8_OVERLONG_2,
+      UTF8_CARRY,
+      UTF8_CARRY,
+      UTF8_CARRY | UTF8_TOO_LARGE,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+      UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000);
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+      UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+      UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+      UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+      UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+      UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+      UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+      UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+
+    const __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table, high_nibbles(prev1));
+    const __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, _mm_set1_epi8(0x0f)));
+    const __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table, high_nibbles(input));
+    return _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+  }
+
+  __attribute__((target("ssse3")))
+  void check_block(__m128i input) {
+    // the whole block is ascii: only a sequence started in the previous block may be broken
+    if (_mm_movemask_epi8(input) == 0) {
+      error = _mm_or_si128(error, prev_incomplete);
+      prev_input = input;
+      prev_incomplete = _mm_setzero_si128();
+      return;
+    }
+
+    const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    const __m128i sc = special_cases(input, prev1);
+
+    // the third and the fourth bytes of 3 and 4 bytes sequences must be continuations
+    const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    const __m128i is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+    const __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+    const __m128i must23_80 = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8(static_cast<char>(0x80)));
+    error = _mm_or_si128(error, _mm_xor_si128(must23_80, sc));
+
+    // a lead byte in the last three positions may expect continuations from the next block
+    const __m128i max_complete = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                               static_cast<char>(0xf0 - 1), static_cast<char>(0xe0 - 1), static_cast<char>(0xc0 - 1));
+    prev_incomplete = _mm_subs_epu8(input, max_complete);
+    prev_input = input;
+  }
+
+  __attribute__((target("sse4.1")))
+  bool has_error() const {
+    const __m128i all_errors = _mm_or_si128(error, prev_incomplete);
+    return !_mm_testz_si128(all_errors, all_errors);
+  }
+};
+
+} // namespace
+
+__attribute__((target("ssse3,sse4.1")))
+static bool utf8_validate_ssse3(const char *s, size_t len) {
+  Utf8CheckerSsse3 checker;
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    checker.check_block(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i)));
+    // bail out on bad input early once in a while
+    if ((i & 1023) == 1008 && checker.has_error()) {
+      return false;
+    }
+  }
+  if (i < len) {
+    // zero bytes are valid ascii, so the padding breaks any sequence that is incomplete in the tail
+    char tail_buf[16] = {0};
+    memcpy(tail_buf, s + i, len - i);
+    checker.check_block(_mm_loadu_si128(reinterpret_cast<const __m128i *>(tail_buf)));
+  }
+  return !checker.has_error();
+}
+
+// the json tokenizer handles 64 bytes at once, so every class of bytes becomes a 64-bit mask
+struct JsonBlockMasks {
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t op;
+  uint64_t whitespace;
+};
+
+static inline uint64_t json_block_mask_sse2(const __m128i (&v)[4], char c) {
+  const __m128i pattern = _mm_set1_epi8(c);
+  uint64_t res = 0;
+  for (int j = 0; j < 4; ++j) {
+    res |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v[j], pattern)))) << (16 * j);
+  }
+  return res;
+}
+
+static inline JsonBlockMasks json_classify_block_sse2(const char *block) {
+  __m128i v[4];
+  __m128i lowered[4];
+  for (int j = 0; j < 4; ++j) {
+    v[j] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * j));
+    // '[' and ']' become '{' and '}', no other bytes are mapped on them
+    lowered[j] = _mm_or_si128(v[j], _mm_set1_epi8(0x20));
+  }
+  JsonBlockMasks res;
+  res.quote = json_block_mask_sse2(v, '"');
+  res.backslash = json_block_mask_sse2(v, '\\');
+  res.op = json_block_mask_sse2(lowered, '{') | json_block_mask_sse2(lowered, '}') |
+           json_block_mask_sse2(v, ':') | json_block_mask_sse2(v, ',');
+  res.whitespace = json_block_mask_sse2(v, ' ') | json_block_mask_sse2(v, '\t') |
+                   json_block_mask_sse2(v, '\n') | json_block_mask_sse2(v, '\r');
+  return res;
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t json_block_mask_avx2(__m256i low, __m256i high, char c) {
+  const __m256i pattern = _mm256_set1_epi8(c);
+  const uint32_t low_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, pattern)));
+  const uint32_t high_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, pattern)));
+  return (static_cast<uint64_t>(high_mask) << 32) | low_mask;
+}
+
+__attribute__((target("avx2")))
+static inline JsonBlockMasks json_classify_block_avx2(const char *block) {
+  const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+  const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+  const __m256i low_lowered = _mm256_or_si256(low, _mm256_set1_epi8(0x20));
+  const __m256i high_lowered = _mm256_or_si256(high, _mm256_set1_epi8(0x20));
+  JsonBlockMasks res;
+  res.quote = json_block_mask_avx2(low, high, '"');
+  res.backslash = json_block_mask_avx2(low, high, '\\');
+  res.op = json_block_mask_avx2(low_lowered, high_lowered, '{') | json_block_mask_avx2(low_lowered, high_lowered, '}') |
+           json_block_mask_avx2(low, high, ':') | json_block_mask_avx2(low, high, ',');
+  res.whitespace = json_block_mask_avx2(low, high, ' ') | json_block_mask_avx2(low, high, '\t') |
+                   json_block_mask_avx2(low, high, '\n') | json_block_mask_avx2(low, high, '\r');
+  return res;
+}
+
+// the state carried between 64-byte blocks, the masks algebra follows simdjson
+class JsonTokensScanner {
+public:
+  uint64_t next_tokens(const JsonBlockMasks &masks) {
+    const uint64_t escaped = find_escaped(masks.backslash);
+    const uint64_t quote = masks.quote & ~escaped;
+    // bits are set from an opening quote (inclusive) till a closing quote (exclusive)
+    const uint64_t in_string = prefix_xor(quote) ^ prev_in_string_;
+    prev_in_string_ = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+    const uint64_t outside_string = ~in_string;
+    const uint64_t scalar = ~(masks.op | masks.whitespace | quote) & outside_string;
+    const uint64_t follows_scalar = (scalar << 1) | prev_scalar_;
+    prev_scalar_ = scalar >> 63;
+
+    return (masks.op & outside_string) | (quote & in_string) | (scalar & ~follows_scalar);
+  }
+
+private:
+  static uint64_t prefix_xor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+  }
+
+  // returns the bytes that follow an odd sequence of backslashes
+  uint64_t find_escaped(uint64_t backslash) {
+    if (backslash == 0) {
+      const uint64_t escaped = prev_escaped_;
+      prev_escaped_ = 0;
+      return escaped;
+    }
+    constexpr uint64_t even_bits = 0x5555555555555555ULL;
+    backslash &= ~prev_escaped_;
+    const uint64_t follows_escape = (backslash << 1) | prev_escaped_;
+    const uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+    unsigned long long sequences_starting_on_even_bits = 0;
+    prev_escaped_ = __builtin_uaddll_overflow(odd_sequence_starts, backslash, &sequences_starting_on_even_bits);
+    const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
+  }
+
+  uint64_t prev_in_string_{0};
+  uint64_t prev_escaped_{0};
+  uint64_t prev_scalar_{0};
+};
+
+static inline size_t json_write_positions(uint64_t tokens, size_t offset, uint32_t *positions) {
+  size_t count = 0;
+  while (tokens) {
+    positions[count++] = static_cast<uint32_t>(offset + __builtin_ctzll(tokens));
+    tokens &= tokens - 1;
+  }
+  return count;
+}
+
+template<JsonBlockMasks (*classify_block)(const char *)>
+static inline size_t json_find_tokens_impl(const char *s, size_t len, uint32_t *positions) {
+  JsonTokensScanner scanner;
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 64 <= len; i += 64) {
+    count += json_write_positions(scanner.next_tokens(classify_block(s + i)), i, positions + count);
+  }
+  if (i < len) {
+    // whitespaces in the padding never produce tokens
+    char tail_buf[64];
+    memset(tail_buf, ' ', sizeof(tail_buf));
+    memcpy(tail_buf, s + i, len - i);
+    count += json_write_positions(scanner.next_tokens(classify_block(tail_buf)), i, positions + count);
+  }
+  return count;
+}
+
+static size_t json_find_tokens_sse2(const char *s, size_t len, uint32_t *positions) {
+  return json_find_tokens_impl<json_classify_block_sse2>(s, len, positions);
+}
+
+__attribute__((target("avx2")))
+static size_t json_find_tokens_avx2(const char *s, size_t len, uint32_t *positions) {
+  return json_find_tokens_impl<json_classify_block_avx2>(s, len, positions);
+}
+
+void __attribute__((constructor(101))) string_kernels_init() {
+  const kdb_cpuid_t *p = kdb_cpuid();
+  assert(p->type == KDB_CPUID_X86_64);
+
+  const bool has_ssse3 = p->x86_64.ecx & (1 << 9);
+  const bool has_sse41 = p->x86_64.ecx & (1 << 19);
+  const bool has_sse42 = p->x86_64.ecx & (1 << 20);
+  const bool has_popcnt = p->x86_64.ecx & (1 << 23);
+  const bool has_avx2 = p->x86_64.os_ymm_enabled && (p->x86_64.ext_ebx & (1 << 5));
+
+  if (has_avx2 && has_sse42) {
+    find_first_of_chars = find_first_of_chars_avx2;
+    ascii_to_lower = ascii_to_lower_avx2;
+    ascii_to_upper = ascii_to_upper_avx2;
+    ascii_prefix_length = ascii_prefix_length_avx2;
+    http_token_length = http_token_length_avx2;
+    json_unescaped_prefix_length = json_unescaped_prefix_length_avx2;
+  } else {
+    find_first_of_chars = has_sse42 ? find_first_of_chars_sse42 : find_first_of_chars_generic;
+    ascii_to_lower = ascii_to_lower_sse2;
+    ascii_to_upper = ascii_to_upper_sse2;
+    ascii_prefix_length = ascii_prefix_length_sse2;
+    http_token_length = http_token_length_sse2;
+    json_unescaped_prefix_length = json_unescaped_prefix_length_sse2;
+  }
+
+  if (has_popcnt) {
+    utf8_code_points_count = has_avx2 ? utf8_code_points_count_avx2 : utf8_code_points_count_sse2;
+  } else {
+    utf8_code_points_count = utf8_code_points_count_generic;
+  }
+  utf8_validate = has_ssse3 && has_sse41 ? utf8_validate_ssse3 : utf8_validate_generic;
+  url_unreserved_prefix_length = url_unreserved_prefix_length_sse2;
+  hex_encode = has_ssse3 ? hex_encode_ssse3 : hex_encode_generic;
+  base64_encode_groups = has_ssse3 ? base64_encode_groups_ssse3 : base64_encode_groups_generic;
+  base64_decode_groups = has_ssse3 ? base64_decode_groups_ssse3 : base64_decode_groups_generic;
+  json_find_tokens = has_avx2 ? json_find_tokens_avx2 : json_find_tokens_sse2;
+}
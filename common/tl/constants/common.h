@@ -53,7 +53,9 @@ constexpr static uint32_t                                        int_forward = 1
 constexpr static uint32_t                                  custom_timeout_ms = 1U << 23U;
 constexpr static uint32_t                      supported_compression_version = 1U << 25U;
 constexpr static uint32_t                                       random_delay = 1U << 26U;
-constexpr static uint32_t                                                ALL = 0x06bd005f;
+constexpr static uint32_t                                           trace_id = 1U << 27U;
+constexpr static uint32_t                                     parent_span_id = 1U << 27U;
+constexpr static uint32_t                                                ALL = 0x0ebd005f;
 } // namespace rpc_invoke_req_extra_flags
 
 namespace rpc_req_result_extra_flags {
@@ -95,29 +95,41 @@ static int tl_fetch_query_flags(tl_query_header_t *header) {
       return -1;
     }
   }
+  if (flags & flag::trace_id) {
+    header->trace_id = tl_fetch_long();
+    header->parent_span_id = tl_fetch_long();
+    if (tl_fetch_error()) {
+      return -1;
+    }
+  }
   return 0;
 }
 
+bool tl_fetch_query_extra_header(tl_query_header_t *header) {
+  while (!tl_fetch_error() && tl_fetch_unread()) {
+    uint32_t op = tl_fetch_lookup_int();
+    if (op == TL_RPC_DEST_ACTOR) {
+      assert (tl_fetch_int() == (int)TL_RPC_DEST_ACTOR);
+      header->actor_id = tl_fetch_long();
+    } else if (op == TL_RPC_DEST_ACTOR_FLAGS) {
+      assert (tl_fetch_int() == (int)TL_RPC_DEST_ACTOR_FLAGS);
+      header->actor_id = tl_fetch_long();
+      tl_fetch_query_flags(header);
+    } else if (op == TL_RPC_DEST_FLAGS) {
+      assert (tl_fetch_int() == (int)TL_RPC_DEST_FLAGS);
+      tl_fetch_query_flags(header);
+    } else {
+      break;
+    }
+  }
+  return !tl_fetch_error();
+}
+
 bool tl_fetch_query_header(tl_query_header_t *header) {
   assert (header);
   if (vk::tl::fetch_magic(TL_RPC_INVOKE_REQ)) {
     header->qid = tl_fetch_long();
-    while (!tl_fetch_error() && tl_fetch_unread()) {
-      uint32_t op = tl_fetch_lookup_int();
-      if (op == TL_RPC_DEST_ACTOR) {
-        assert (tl_fetch_int() == (int)TL_RPC_DEST_ACTOR);
-        header->actor_id = tl_fetch_long();
-      } else if (op == TL_RPC_DEST_ACTOR_FLAGS) {
-        assert (tl_fetch_int() == (int)TL_RPC_DEST_ACTOR_FLAGS);
-        header->actor_id = tl_fetch_long();
-        tl_fetch_query_flags(header);
-      } else if (op == TL_RPC_DEST_FLAGS) {
-        assert (tl_fetch_int() == (int)TL_RPC_DEST_FLAGS);
-        tl_fetch_query_flags(header);
-      } else {
-        break;
-      }
-    }
+    tl_fetch_query_extra_header(header);
   } else {
     tl_fetch_reset_error();
     tl_fetch_set_error(TL_ERROR_HEADER, "Expected RPC_INVOKE_REQ");
@@ -325,6 +337,10 @@ void tl_store_header(const tl_query_header_t *header) {
       if (flags & flag::random_delay) {
         tl_store_double(header->random_delay);
       }
+      if (flags & flag::trace_id) {
+        tl_store_long(header->trace_id);
+        tl_store_long(header->parent_span_id);
+      }
     } else if (header->actor_id) {
       tl_store_int(TL_RPC_DEST_ACTOR);
       tl_store_long(header->actor_id);
@@ -33,6 +33,8 @@ struct tl_query_header_t {
   std::vector<std::string> string_forward_keys;
   int supported_compression_version{};
   double random_delay{};
+  long long trace_id{};
+  long long parent_span_id{};
 };
 
 struct tl_query_answer_header_t {
@@ -55,6 +57,8 @@ struct tl_query_answer_header_t {
 };
 
 bool tl_fetch_query_header(tl_query_header_t *header);
+// fetches the actor and the extra flags blocks, which precede the query body
+bool tl_fetch_query_extra_header(tl_query_header_t *header);
 bool tl_fetch_query_answer_header(tl_query_answer_header_t *header);
 void tl_store_header(const tl_query_header_t *header);
 void tl_store_answer_header(const tl_query_answer_header_t *header);
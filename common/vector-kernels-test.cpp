@@ -0,0 +1,67 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/vector-kernels.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::vector<double> random_vector(std::mt19937 &gen, size_t len) {
+  std::uniform_real_distribution<double> distribution{-10.0, 10.0};
+  std::vector<double> v(len);
+  for (auto &x : v) {
+    x = distribution(gen);
+  }
+  return v;
+}
+
+void expect_close(double actual, double expected) {
+  EXPECT_NEAR(actual, expected, 1e-9 * std::max(1.0, std::fabs(expected)));
+}
+
+} // namespace
+
+TEST(vector_kernels, dot_product_f64) {
+  std::mt19937 gen{7};
+  for (size_t len = 0; len < 100; ++len) {
+    const auto x = random_vector(gen, len);
+    const auto y = random_vector(gen, len);
+    expect_close(dot_product_f64(x.data(), y.data(), len), dot_product_f64_generic(x.data(), y.data(), len));
+  }
+
+  const std::vector<double> x{1.0, 2.0, 3.0, 4.0, 5.0};
+  ASSERT_EQ(dot_product_f64(x.data(), x.data(), x.size()), 55.0);
+}
+
+TEST(vector_kernels, squared_l2_distance_f64) {
+  std::mt19937 gen{11};
+  for (size_t len = 0; len < 100; ++len) {
+    const auto x = random_vector(gen, len);
+    const auto y = random_vector(gen, len);
+    expect_close(squared_l2_distance_f64(x.data(), y.data(), len), squared_l2_distance_f64_generic(x.data(), y.data(), len));
+  }
+
+  const std::vector<double> x{1.0, 2.0, 3.0};
+  const std::vector<double> y{4.0, 6.0, 3.0};
+  ASSERT_EQ(squared_l2_distance_f64(x.data(), y.data(), x.size()), 25.0);
+}
+
+TEST(vector_kernels, axpy_f64) {
+  std::mt19937 gen{13};
+  for (size_t len = 0; len < 100; ++len) {
+    const auto x = random_vector(gen, len);
+    auto y = random_vector(gen, len);
+    auto expected = y;
+    axpy_f64(-1.5, x.data(), y.data(), len);
+    axpy_f64_generic(-1.5, x.data(), expected.data(), len);
+    for (size_t i = 0; i < len; ++i) {
+      expect_close(y[i], expected[i]);
+    }
+  }
+}
@@ -0,0 +1,46 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/vector-kernels.h"
+
+dot_product_f64_func_t dot_product_f64;
+squared_l2_distance_f64_func_t squared_l2_distance_f64;
+axpy_f64_func_t axpy_f64;
+
+double dot_product_f64_generic(const double *x, const double *y, size_t len) {
+  double sum[4] = {0.0, 0.0, 0.0, 0.0};
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    sum[0] += x[i] * y[i];
+    sum[1] += x[i + 1] * y[i + 1];
+    sum[2] += x[i + 2] * y[i + 2];
+    sum[3] += x[i + 3] * y[i + 3];
+  }
+  for (; i < len; ++i) {
+    sum[0] += x[i] * y[i];
+  }
+  return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+double squared_l2_distance_f64_generic(const double *x, const double *y, size_t len) {
+  double sum[4] = {0.0, 0.0, 0.0, 0.0};
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    for (size_t j = 0; j < 4; ++j) {
+      const double d = x[i + j] - y[i + j];
+      sum[j] += d * d;
+    }
+  }
+  for (; i < len; ++i) {
+    const double d = x[i] - y[i];
+    sum[0] += d * d;
+  }
+  return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+void axpy_f64_generic(double alpha, const double *x, double *y, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    y[i] += alpha * x[i];
+  }
+}
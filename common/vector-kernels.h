@@ -0,0 +1,27 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#ifndef __VECTOR_KERNELS_H__
+#define __VECTOR_KERNELS_H__
+
+#include <stddef.h>
+
+// the kernels sum in several independent accumulators, so their results may differ from a sequential loop in the last bits
+
+// returns the sum of x[i] * y[i]
+typedef double (*dot_product_f64_func_t)(const double *x, const double *y, size_t len);
+// returns the sum of (x[i] - y[i])^2
+typedef double (*squared_l2_distance_f64_func_t)(const double *x, const double *y, size_t len);
+// y[i] += alpha * x[i]
+typedef void (*axpy_f64_func_t)(double alpha, const double *x, double *y, size_t len);
+
+extern dot_product_f64_func_t dot_product_f64;
+extern squared_l2_distance_f64_func_t squared_l2_distance_f64;
+extern axpy_f64_func_t axpy_f64;
+
+double dot_product_f64_generic(const double *x, const double *y, size_t len);
+double squared_l2_distance_f64_generic(const double *x, const double *y, size_t len);
+void axpy_f64_generic(double alpha, const double *x, double *y, size_t len);
+
+#endif
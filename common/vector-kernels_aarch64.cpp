@@ -0,0 +1,65 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include <assert.h>
+
+#include <arm_neon.h>
+
+#include "common/cpuid.h"
+#include "common/vector-kernels.h"
+
+static double dot_product_f64_neon(const double *x, const double *y, size_t len) {
+  float64x2_t sum0 = vdupq_n_f64(0.0);
+  float64x2_t sum1 = vdupq_n_f64(0.0);
+  float64x2_t sum2 = vdupq_n_f64(0.0);
+  float64x2_t sum3 = vdupq_n_f64(0.0);
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    sum0 = vfmaq_f64(sum0, vld1q_f64(x + i), vld1q_f64(y + i));
+    sum1 = vfmaq_f64(sum1, vld1q_f64(x + i + 2), vld1q_f64(y + i + 2));
+    sum2 = vfmaq_f64(sum2, vld1q_f64(x + i + 4), vld1q_f64(y + i + 4));
+    sum3 = vfmaq_f64(sum3, vld1q_f64(x + i + 6), vld1q_f64(y + i + 6));
+  }
+  double result = vaddvq_f64(vaddq_f64(vaddq_f64(sum0, sum1), vaddq_f64(sum2, sum3)));
+  for (; i < len; ++i) {
+    result += x[i] * y[i];
+  }
+  return result;
+}
+
+static double squared_l2_distance_f64_neon(const double *x, const double *y, size_t len) {
+  float64x2_t sum0 = vdupq_n_f64(0.0);
+  float64x2_t sum1 = vdupq_n_f64(0.0);
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    const float64x2_t d0 = vsubq_f64(vld1q_f64(x + i), vld1q_f64(y + i));
+    const float64x2_t d1 = vsubq_f64(vld1q_f64(x + i + 2), vld1q_f64(y + i + 2));
+    sum0 = vfmaq_f64(sum0, d0, d0);
+    sum1 = vfmaq_f64(sum1, d1, d1);
+  }
+  double result = vaddvq_f64(vaddq_f64(sum0, sum1));
+  for (; i < len; ++i) {
+    const double d = x[i] - y[i];
+    result += d * d;
+  }
+  return result;
+}
+
+static void axpy_f64_neon(double alpha, const double *x, double *y, size_t len) {
+  const float64x2_t alpha_vector = vdupq_n_f64(alpha);
+  size_t i = 0;
+  for (; i + 2 <= len; i += 2) {
+    vst1q_f64(y + i, vfmaq_f64(vld1q_f64(y + i), alpha_vector, vld1q_f64(x + i)));
+  }
+  axpy_f64_generic(alpha, x + i, y + i, len - i);
+}
+
+void __attribute__((constructor(101))) vector_kernels_init() {
+  const kdb_cpuid_t *p = kdb_cpuid();
+  assert(p->type == KDB_CPUID_AARCH64);
+
+  dot_product_f64 = dot_product_f64_neon;
+  squared_l2_distance_f64 = squared_l2_distance_f64_neon;
+  axpy_f64 = axpy_f64_neon;
+}
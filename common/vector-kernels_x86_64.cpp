@@ -0,0 +1,124 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include <assert.h>
+
+#include <immintrin.h>
+
+#include "common/cpuid.h"
+#include "common/vector-kernels.h"
+
+__attribute__((target("avx")))
+static double horizontal_sum_avx(__m256d v) {
+  const __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+static double horizontal_sum_sse2(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+// four accumulators hide the latency of the fused multiply-add
+__attribute__((target("avx2,fma")))
+static double dot_product_f64_avx2(const double *x, const double *y, size_t len) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  __m256d sum2 = _mm256_setzero_pd();
+  __m256d sum3 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), sum0);
+    sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), sum1);
+    sum2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), sum2);
+    sum3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), sum3);
+  }
+  for (; i + 4 <= len; i += 4) {
+    sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), sum0);
+  }
+  double result = horizontal_sum_avx(_mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+  for (; i < len; ++i) {
+    result += x[i] * y[i];
+  }
+  return result;
+}
+
+__attribute__((target("avx2,fma")))
+static double squared_l2_distance_f64_avx2(const double *x, const double *y, size_t len) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    const __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i));
+    const __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4));
+    sum0 = _mm256_fmadd_pd(d0, d0, sum0);
+    sum1 = _mm256_fmadd_pd(d1, d1, sum1);
+  }
+  double result = horizontal_sum_avx(_mm256_add_pd(sum0, sum1));
+  for (; i < len; ++i) {
+    const double d = x[i] - y[i];
+    result += d * d;
+  }
+  return result;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy_f64_avx2(double alpha, const double *x, double *y, size_t len) {
+  const __m256d alpha_vector = _mm256_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    _mm256_storeu_pd(y + i, _mm256_fmadd_pd(alpha_vector, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+  }
+  axpy_f64_generic(alpha, x + i, y + i, len - i);
+}
+
+static double dot_product_f64_sse2(const double *x, const double *y, size_t len) {
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+  }
+  double result = horizontal_sum_sse2(_mm_add_pd(sum0, sum1));
+  for (; i < len; ++i) {
+    result += x[i] * y[i];
+  }
+  return result;
+}
+
+static double squared_l2_distance_f64_sse2(const double *x, const double *y, size_t len) {
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    const __m128d d0 = _mm_sub_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i));
+    const __m128d d1 = _mm_sub_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2));
+    sum0 = _mm_add_pd(sum0, _mm_mul_pd(d0, d0));
+    sum1 = _mm_add_pd(sum1, _mm_mul_pd(d1, d1));
+  }
+  double result = horizontal_sum_sse2(_mm_add_pd(sum0, sum1));
+  for (; i < len; ++i) {
+    const double d = x[i] - y[i];
+    result += d * d;
+  }
+  return result;
+}
+
+void __attribute__((constructor(101))) vector_kernels_init() {
+  const kdb_cpuid_t *p = kdb_cpuid();
+  assert(p->type == KDB_CPUID_X86_64);
+
+  const bool has_fma = p->x86_64.ecx & (1 << 12);
+  const bool has_avx2 = p->x86_64.os_ymm_enabled && (p->x86_64.ext_ebx & (1 << 5));
+
+  if (has_avx2 && has_fma) {
+    dot_product_f64 = dot_product_f64_avx2;
+    squared_l2_distance_f64 = squared_l2_distance_f64_avx2;
+    axpy_f64 = axpy_f64_avx2;
+  } else {
+    dot_product_f64 = dot_product_f64_sse2;
+    squared_l2_distance_f64 = squared_l2_distance_f64_sse2;
+    axpy_f64 = axpy_f64_generic;
+  }
+}
@@ -29,7 +29,7 @@ static inline double __dot_product(const double *x, const double *y, const int s
   _mm_storeu_pd(temp, result);
   temp[0] += temp[1] + (i < size ? x[size - 1] * y[size - 1] : 0.0);
   return __fpclassify(temp[0]) == FP_SUBNORMAL ? 0.0 : temp[0];
-#elif defined(__arch64__)
+#elif defined(__aarch64__)
   float64x2_t xf, yf, result;
   double temp[2] = {0.0, 0.0};
   result = vld1q_f64(temp);
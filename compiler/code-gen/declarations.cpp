@@ -531,14 +531,36 @@ void ClassDeclaration::compile_get_hash(CodeGenerator &W, ClassPtr klass) {
   compile_class_method(FunctionSignatureGenerator(W).set_const_this(), klass, "int get_hash()", klass->get_hash());
 }
 
-void ClassDeclaration::compile_accept_visitor(CodeGenerator &W, ClassPtr klass, const char *visitor_type) {
-  compile_class_method(FunctionSignatureGenerator(W), klass, fmt_format("void accept({} &visitor)", visitor_type), "generic_accept(visitor)");
+void ClassDeclaration::compile_accept_visitor(CodeGenerator &W, ClassPtr klass, const char *visitor_type, const char *generic_accept) {
+  compile_class_method(FunctionSignatureGenerator(W), klass, fmt_format("void accept({} &visitor)", visitor_type), fmt_format("{}(visitor)", generic_accept));
+}
+
+// the instance cache visitors do nothing with ints, floats and bools, so only the members owning memory are visited;
+// the class with only such members gets an empty accept, and it's copied to the cache by its copy constructor alone
+void ClassDeclaration::compile_generic_accept_owned_memory(CodeGenerator &W, ClassPtr klass) {
+  std::vector<std::string> fields;
+  for (auto cur_klass = klass; cur_klass; cur_klass = cur_klass->parent_class) {
+    cur_klass->members.for_each([&fields](const ClassMemberInstanceField &f) {
+      if (!tinf::get_type(f.var)->is_primitive_type()) {
+        fields.emplace_back(f.local_name());
+      }
+    });
+  }
+
+  W << NL;
+  FunctionSignatureGenerator(W) << "template<class Visitor>" << NL
+                                << "void generic_accept_owned_memory(Visitor &&" << (fields.empty() ? "" : "visitor") << ") " << BEGIN;
+  for (const auto &field : fields) {
+    W << "visitor(\"" << field << "\", $" << field << ");" << NL;
+  }
+  W << END << NL;
 }
 
 void ClassDeclaration::compile_accept_visitor_methods(CodeGenerator &W, ClassPtr klass) {
   if (!klass->need_instance_to_array_visitor &&
       !klass->need_instance_cache_visitors &&
-      !klass->need_instance_memory_estimate_visitor) {
+      !klass->need_instance_memory_estimate_visitor &&
+      !klass->need_json_decode_visitor) {
     return;
   }
 
@@ -564,9 +586,15 @@ void ClassDeclaration::compile_accept_visitor_methods(CodeGenerator &W, ClassPtr
   }
 
   if (klass->need_instance_cache_visitors) {
+    compile_generic_accept_owned_memory(W, klass);
+    W << NL;
+    compile_accept_visitor(W, klass, "DeepMoveFromScriptToCacheVisitor", "generic_accept_owned_memory");
+    compile_accept_visitor(W, klass, "DeepDestroyFromCacheVisitor", "generic_accept_owned_memory");
+  }
+
+  if (klass->need_json_decode_visitor) {
     W << NL;
-    compile_accept_visitor(W, klass, "DeepMoveFromScriptToCacheVisitor");
-    compile_accept_visitor(W, klass, "DeepDestroyFromCacheVisitor");
+    compile_accept_visitor(W, klass, "JsonDecodeVisitor");
   }
 }
 
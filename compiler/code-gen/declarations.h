@@ -119,7 +119,8 @@ private:
   template<class ReturnValueT>
   static void compile_class_method(FunctionSignatureGenerator &&W, ClassPtr klass, vk::string_view method_signature, const ReturnValueT &return_value);
 
-  static void compile_accept_visitor(CodeGenerator &W, ClassPtr klass, const char *visitor_type);
+  static void compile_accept_visitor(CodeGenerator &W, ClassPtr klass, const char *visitor_type, const char *generic_accept = "generic_accept");
+  static void compile_generic_accept_owned_memory(CodeGenerator &W, ClassPtr klass);
   IncludesCollector compile_front_includes(CodeGenerator &W) const;
   void compile_back_includes(CodeGenerator &W, IncludesCollector &&front_includes) const;
   void declare_all_variables(VertexPtr v, CodeGenerator &W) const;
@@ -19,6 +19,33 @@ inline std::vector<std::string> get_not_optional_fields_masks(const vk::tl::comb
   return res;
 }
 
+// the words taken by a field of the fixed size, which is stored as is; 0 for the other fields
+static int get_fixed_size_words(const vk::tl::arg *arg) {
+  if (arg->is_optional() || arg->is_fields_mask_optional() || arg->is_forwarded_function() || arg->is_named_fields_mask_bit()) {
+    return 0;
+  }
+  const auto *type_expr = arg->type_expr->as<vk::tl::type_expr>();
+  if (!type_expr || !type_expr->children.empty() || is_magic_processing_needed(type_expr)) {
+    return 0;
+  }
+  const auto *type = type_of(type_expr);
+  if (type->is_integer_variable() || type->id == TL_INT) {
+    return 1;
+  }
+  if (type->id == TL_DOUBLE || (type->id == TL_LONG && TlClasses::new_tl_long)) {
+    return 2;
+  }
+  return 0;
+}
+
+static const char *get_fixed_size_cpp_type(const vk::tl::arg *arg) {
+  const auto *type = type_of(arg->type_expr);
+  if (type->id == TL_DOUBLE) {
+    return "double";
+  }
+  return type->id == TL_LONG ? "int64_t" : "int32_t";
+}
+
 CombinatorGen::CombinatorGen(const vk::tl::combinator *combinator, CombinatorPart part, bool typed_mode) :
   combinator(combinator),
   part(part),
@@ -28,6 +55,7 @@ CombinatorGen::CombinatorGen(const vk::tl::combinator *combinator, CombinatorPar
 }
 
 void CombinatorGen::compile(CodeGenerator &W) const {
+  tl2cpp::cur_combinator = combinator;
   switch (part) {
     case CombinatorPart::LEFT:
       compile_left(W);
@@ -40,7 +68,6 @@ void CombinatorGen::compile(CodeGenerator &W) const {
 }
 
 void CombinatorGen::compile_left(CodeGenerator &W) const {
-  tl2cpp::cur_combinator = combinator;
   // create local variables to hold the field mask values
   if (combinator->is_constructor()) {
     auto fields_masks = tl2cpp::get_not_optional_fields_masks(combinator);
@@ -49,15 +76,36 @@ void CombinatorGen::compile_left(CodeGenerator &W) const {
     }
   }
   gen_before_args_processing(W);
-  for (const auto &arg : combinator->args) {
-    if (arg->is_optional()) {
+  const auto &args = combinator->args;
+  for (auto it = args.begin(); it != args.end();) {
+    if ((*it)->is_optional()) {
+      ++it;
       continue;
     }
-    gen_arg_processing(W, arg);
+    std::vector<const vk::tl::arg *> fixed_size_args;
+    for (auto next = it; typed_mode && next != args.end() && get_fixed_size_words(next->get()); ++next) {
+      fixed_size_args.emplace_back(next->get());
+    }
+    if (fixed_size_args.size() > 1) {
+      gen_fixed_size_args_processing(W, fixed_size_args);
+      it += fixed_size_args.size();
+    } else {
+      gen_arg_processing(W, *it);
+      ++it;
+    }
   }
   gen_after_args_processing(W);
 }
 
+void CombinatorGen::gen_fields_masks_saving(CodeGenerator &W, const std::vector<const vk::tl::arg *> &args) const {
+  kphp_assert(typed_mode);
+  for (const auto *arg : args) {
+    if (arg->var_num != -1 && tl2cpp::type_of(arg->type_expr)->is_integer_variable()) {
+      W << var_num_access << combinator->get_var_num_arg(arg->var_num)->name << " = tl_object->$" << arg->name << ";" << NL;
+    }
+  }
+}
+
 void CombinatorGen::compile_right(CodeGenerator &W) const {
   gen_result_expr_processing(W);
 }
@@ -139,6 +187,27 @@ void CombinatorStore::gen_arg_processing(CodeGenerator &W, const std::unique_ptr
   }
 }
 
+void CombinatorStore::gen_fixed_size_args_processing(CodeGenerator &W, const std::vector<const vk::tl::arg *> &args) const {
+  int words = 0;
+  for (const auto *arg : args) {
+    words += get_fixed_size_words(arg);
+  }
+  W << BEGIN;
+  W << "int32_t tl_packed[" << words << "];" << NL;
+  int word = 0;
+  for (const auto *arg : args) {
+    const int arg_words = get_fixed_size_words(arg);
+    const std::string field = "tl_object->$" + arg->name;
+    // ints are checked for the overflow the same way as t_Int does
+    const std::string value = arg_words == 1 ? "t_Int::prepare_int_for_storing(" + field + ")" : field;
+    W << fmt_format("tl_packed_set<{}>(tl_packed, {}, {});", get_fixed_size_cpp_type(arg), word, value) << NL;
+    word += arg_words;
+  }
+  W << "store_raw_words(tl_packed, " << words << ");" << NL;
+  W << END << NL;
+  gen_fields_masks_saving(W, args);
+}
+
 void CombinatorStore::gen_result_expr_processing(CodeGenerator &W) const {
   kphp_assert(typed_mode);
   if (!combinator->original_result_constructor_id) {
@@ -207,6 +276,21 @@ void CombinatorFetch::gen_arg_processing(CodeGenerator &W, const std::unique_ptr
   }
 }
 
+void CombinatorFetch::gen_fixed_size_args_processing(CodeGenerator &W, const std::vector<const vk::tl::arg *> &args) const {
+  int words = 0;
+  for (const auto *arg : args) {
+    words += get_fixed_size_words(arg);
+  }
+  W << "if (const int32_t *tl_packed = rpc_fetch_raw_words(" << words << ")) " << BEGIN;
+  int word = 0;
+  for (const auto *arg : args) {
+    W << fmt_format("tl_object->${} = tl_packed_get<{}>(tl_packed, {});", arg->name, get_fixed_size_cpp_type(arg), word) << NL;
+    word += get_fixed_size_words(arg);
+  }
+  W << END << NL;
+  gen_fields_masks_saving(W, args);
+}
+
 void CombinatorFetch::gen_after_args_processing(CodeGenerator &W) const {
   if (!typed_mode) {
     W << "return result;" << NL;
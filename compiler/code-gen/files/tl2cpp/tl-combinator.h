@@ -30,8 +30,12 @@ struct CombinatorGen {
 
   virtual void gen_before_args_processing(CodeGenerator &W __attribute__ ((unused))) const {};
   virtual void gen_arg_processing(CodeGenerator &W, const std::unique_ptr<vk::tl::arg> &arg) const = 0;
+  // in the typed mode, two or more consecutive fields of the fixed size (bare int, #, long, double) are stored/fetched at once
+  virtual void gen_fixed_size_args_processing(CodeGenerator &W, const std::vector<const vk::tl::arg *> &args) const = 0;
   virtual void gen_after_args_processing(CodeGenerator &W __attribute__ ((unused))) const {};
 
+  void gen_fields_masks_saving(CodeGenerator &W, const std::vector<const vk::tl::arg *> &args) const;
+
   virtual void gen_result_expr_processing(CodeGenerator &W) const = 0;
 };
 
@@ -66,7 +70,15 @@ struct CombinatorGen {
       tl_func_state->X.fetcher = storer_kv(_cur_arg);
       return std::move(tl_func_state);
     }
- * 3) Handling of the main part of the type expression in TypeExprStore/Fetch
+ * 3) Fixed size fields in the typed mode:
+    {
+      int32_t tl_packed[5];
+      tl_packed_set<int32_t>(tl_packed, 0, t_Int::prepare_int_for_storing(tl_object->$peer_id));
+      tl_packed_set<int64_t>(tl_packed, 1, tl_object->$message_id);
+      tl_packed_set<double>(tl_packed, 3, tl_object->$date);
+      store_raw_words(tl_packed, 5);
+    }
+ * 4) Handling of the main part of the type expression in TypeExprStore/Fetch
 */
 struct CombinatorStore : CombinatorGen {
   CombinatorStore(const vk::tl::combinator *combinator, CombinatorPart part, bool typed_mode) :
@@ -76,6 +88,8 @@ struct CombinatorStore : CombinatorGen {
 
   void gen_arg_processing(CodeGenerator &W, const std::unique_ptr<vk::tl::arg> &arg) const final;
 
+  void gen_fixed_size_args_processing(CodeGenerator &W, const std::vector<const vk::tl::arg *> &args) const final;
+
   void gen_result_expr_processing(CodeGenerator &W) const final;
 
 private:
@@ -101,7 +115,13 @@ private:
       fetch_magic_if_not_bare(0x1cb5c415, "Incorrect magic in result of function: rpcProxy.diagonalTargets");
       return t_Vector<t_Vector<t_Maybe<tl_exclamation_fetch_wrapper, 0>, 0>, 0>(t_Vector<t_Maybe<tl_exclamation_fetch_wrapper, 0>, 0>(t_Maybe<tl_exclamation_fetch_wrapper, 0>(std::move(X)))).fetch();
     }
- * 3) Handling of the main part of the type expression in TypeExprStore/Fetch
+ * 3) Fixed size fields in the typed mode:
+    if (const int32_t *tl_packed = rpc_fetch_raw_words(5)) {
+      tl_object->$peer_id = tl_packed_get<int32_t>(tl_packed, 0);
+      tl_object->$message_id = tl_packed_get<int64_t>(tl_packed, 1);
+      tl_object->$date = tl_packed_get<double>(tl_packed, 3);
+    }
+ * 4) Handling of the main part of the type expression in TypeExprStore/Fetch
 */
 struct CombinatorFetch : CombinatorGen {
   CombinatorFetch(const vk::tl::combinator *combinator, CombinatorPart part, bool typed_mode) :
@@ -111,6 +131,8 @@ struct CombinatorFetch : CombinatorGen {
 
   void gen_arg_processing(CodeGenerator &W, const std::unique_ptr<vk::tl::arg> &arg) const final;
 
+  void gen_fixed_size_args_processing(CodeGenerator &W, const std::vector<const vk::tl::arg *> &args) const final;
+
   void gen_after_args_processing(CodeGenerator &W) const final;
 
   void gen_result_expr_processing(CodeGenerator &W) const final;
@@ -56,6 +56,10 @@ public:
     ensure_existence(get_module_name(c->name)).add_obj(c);
   }
 
+  static void add_empty_module(const std::string &module_name) {
+    ensure_existence(module_name);
+  }
+
   bool is_empty() const;
 
 private:
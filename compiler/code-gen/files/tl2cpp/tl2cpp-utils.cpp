@@ -16,7 +16,7 @@ const std::unordered_set<std::string> CUSTOM_IMPL_TYPES
 
 static const std::string VK_name_prefix = "VK\\";
 vk::tl::tl_scheme *tl;
-const vk::tl::combinator *cur_combinator;
+thread_local const vk::tl::combinator *cur_combinator;
 
 std::set<std::string> tl_const_vars;
 
@@ -26,7 +26,8 @@ std::string cpp_tl_const_str(std::string tl_name) {
 }
 
 std::string register_tl_const_str(const std::string &tl_name) {
-  tl_const_vars.insert(tl_name);
+  // the modules are generated in parallel, so the strings are collected before, see collect_tl_const_vars()
+  kphp_assert_msg(tl_const_vars.count(tl_name), fmt_format("TL const string '{}' was not collected", tl_name));
   return cpp_tl_const_str(tl_name);
 }
 
@@ -17,7 +17,8 @@ class CodeGenerator;
 namespace tl2cpp {
 extern const std::unordered_set<std::string> CUSTOM_IMPL_TYPES;    // from tl_builtins.h
 extern vk::tl::tl_scheme *tl;
-extern const vk::tl::combinator *cur_combinator;
+// the modules are generated in parallel, each thread has its own current combinator
+extern thread_local const vk::tl::combinator *cur_combinator;
 extern const std::string T_TYPE;
 extern std::set<std::string> tl_const_vars;
 
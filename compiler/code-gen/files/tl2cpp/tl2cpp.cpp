@@ -4,11 +4,17 @@
 
 #include "compiler/code-gen/files/tl2cpp/tl2cpp.h"
 
+#include <unordered_set>
+
+#include "compiler/code-gen/code-gen-task.h"
+
 #include "common/tlo-parsing/flat-optimization.h"
 #include "common/tlo-parsing/replace-anonymous-args.h"
 #include "common/tlo-parsing/tl-scheme-final-check.h"
 
+#include "compiler/code-gen/files/tl2cpp/tl-function.h"
 #include "compiler/code-gen/files/tl2cpp/tl-module.h"
+#include "compiler/code-gen/files/tl2cpp/tl-type.h"
 #include "compiler/code-gen/files/tl2cpp/tl2cpp-utils.h"
 #include "compiler/code-gen/naming.h"
 #include "compiler/code-gen/raw-data.h"
@@ -45,6 +51,56 @@
  */
 namespace tl2cpp {
 
+/* Without the untyped rpc any function may be called only through its PHP class, so only the functions
+ * with the reachable classes are the roots, and the types are taken if their PHP classes are reachable
+ * or if the roots depend on them. The untyped rpc may call any function by its name, then all of them are roots.
+ * */
+class TlReachabilityCollector {
+public:
+  void add_function(const vk::tl::combinator *f) {
+    if (functions_.insert(f->id).second) {
+      add_combinator(f);
+    }
+  }
+
+  void add_type(const vk::tl::type *t) {
+    if (types_.insert(t->id).second) {
+      for (const auto &c : t->constructors) {
+        add_combinator(c.get());
+      }
+    }
+  }
+
+  bool has_function(const vk::tl::combinator *f) const { return functions_.count(f->id) != 0; }
+  bool has_type(const vk::tl::type *t) const { return types_.count(t->id) != 0; }
+
+private:
+  void add_combinator(const vk::tl::combinator *c) {
+    for (const auto &arg : c->args) {
+      add_type_tree(arg->type_expr.get());
+    }
+    if (c->is_function()) {
+      add_type_tree(c->result.get());
+    }
+  }
+
+  void add_type_tree(vk::tl::expr_base *expr) {
+    if (auto as_type_expr = expr->as<vk::tl::type_expr>()) {
+      add_type(tl->get_type_by_magic(as_type_expr->type_id));
+      for (const auto &child : as_type_expr->children) {
+        add_type_tree(child.get());
+      }
+    } else if (auto as_type_array = expr->as<vk::tl::type_array>()) {
+      for (const auto &arg : as_type_array->args) {
+        add_type_tree(arg->type_expr.get());
+      }
+    }
+  }
+
+  std::unordered_set<int> functions_;
+  std::unordered_set<int> types_;
+};
+
 /* Bundle all combinators and types by modules while collecting all their dependencies along the way.
  * */
 static void collect_target_objects() {
@@ -56,21 +112,63 @@ static void collect_target_objects() {
     return !G->settings().gen_tl_internals.get() && f->is_internal_function();
   };
 
+  const bool is_untyped_rpc_used = G->get_untyped_rpc_tl_used();
+  TlReachabilityCollector reachable;
+  for (const auto &e : tl->functions) {
+    const std::unique_ptr<vk::tl::combinator> &f = e.second;
+    if (!should_exclude_tl_function(f) && (is_untyped_rpc_used || TlFunctionDecl::does_tl_function_need_typed_fetch_store(f.get()))) {
+      reachable.add_function(f.get());
+    }
+  }
   for (const auto &e : tl->types) {
     const std::unique_ptr<vk::tl::type> &t = e.second;
-    if (!should_exclude_tl_type(t)) {
+    if (is_untyped_rpc_used || TlTypeDeclaration::does_tl_type_need_typed_fetch_store(t.get())) {
+      reachable.add_type(t.get());
+    }
+  }
+
+  // tl/common.h is included by the typed rpc functions and the rpc server even if nothing is taken from the common module
+  Module::add_empty_module("common");
+  for (const auto &e : tl->types) {
+    const std::unique_ptr<vk::tl::type> &t = e.second;
+    if (!should_exclude_tl_type(t) && reachable.has_type(t.get())) {
       Module::add_to_module(t);
     }
   }
 
   for (const auto &e : tl->functions) {
     const std::unique_ptr<vk::tl::combinator> &f = e.second;
-    if (!should_exclude_tl_function(f)) {
+    if (reachable.has_function(f.get())) {
       Module::add_to_module(f);
     }
   }
 }
 
+/* All the const strings the modules may register: the names of the functions and constructors and of their args.
+ * They are collected beforehand, as the modules are generated in parallel after tl_const_vars.h is written.
+ * */
+static void collect_tl_const_vars() {
+  auto collect_combinator = [](const vk::tl::combinator *c) {
+    tl_const_vars.insert(c->name);
+    for (const auto &arg : c->args) {
+      tl_const_vars.insert(arg->name);
+    }
+  };
+
+  tl_const_vars.insert("_");
+  for (const auto &e : modules) {
+    const Module &module = e.second;
+    for (const auto *t : module.target_types) {
+      for (const auto &c : t->constructors) {
+        collect_combinator(c.get());
+      }
+    }
+    for (const auto *f : module.target_functions) {
+      collect_combinator(f);
+    }
+  }
+}
+
 void write_rpc_server_functions(CodeGenerator &W) {
   W << OpenFile("rpc_server_fetch_request.cpp", "tl", false);
   std::vector<vk::tl::combinator *> kphp_functions;
@@ -118,7 +216,10 @@ void write_tl_query_handlers(CodeGenerator &W) {
   kphp_error_return(tl_ptr.has_value(),
                     fmt_format("Error while reading tlo: {}", tl_ptr.error()));
 
-  tl = tl_ptr.value().get();
+  // the modules are generated by the async tasks, which outlive this function
+  static std::unique_ptr<vk::tl::tl_scheme> tl_scheme;
+  tl_scheme = std::move(tl_ptr.value());
+  tl = tl_scheme.get();
   try {
     vk::tl::replace_anonymous_args(*tl);
     vk::tl::perform_flat_optimization(*tl);
@@ -127,9 +228,10 @@ void write_tl_query_handlers(CodeGenerator &W) {
     kphp_error_return(false, ex.what());
   }
   collect_target_objects();
+  collect_tl_const_vars();
   for (const auto &e : modules) {
     const Module &module = e.second;
-    W << module;
+    W << Async(module);
   }
 
   if (G->get_untyped_rpc_tl_used()) {
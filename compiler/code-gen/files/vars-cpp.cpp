@@ -42,6 +42,19 @@ struct InitVar {
 };
 
 
+// the global const is allocated in the read-only segment and marked with ExtraRefCnt::for_global_const,
+// see begin_global_const_init() in the runtime
+struct InitGlobalConstVar {
+  VarPtr var;
+  explicit InitGlobalConstVar(VarPtr var) : var(var) {}
+
+  void compile(CodeGenerator &W) const {
+    W << "begin_global_const_init(" << VarName(var) << ");" << NL;
+    W << InitVar(var);
+    W << "end_global_const_init(" << VarName(var) << ");" << NL;
+  }
+};
+
 static void add_dependent_declarations(VertexPtr vertex, std::set<VarPtr> &dependent_vars) {
   if (!vertex) {
     return;
@@ -56,8 +69,7 @@ static void add_dependent_declarations(VertexPtr vertex, std::set<VarPtr> &depen
 
 void compile_raw_array(CodeGenerator &W, const VarPtr &var, int shift) {
   if (shift == -1) {
-    W << InitVar(var);
-    W << VarName(var) << ".set_reference_counter_to(ExtraRefCnt::for_global_const);" << NL << NL;
+    W << InitGlobalConstVar(var) << NL;
     return;
   }
 
@@ -161,16 +173,7 @@ static std::vector<bool> compile_vars_part(CodeGenerator &W, const std::vector<V
 
     for (const auto &var: other_const_vars) {
       if (var->dependency_level == dep_level) {
-        W << InitVar(var);
-        auto type_data = var->tinf_node.get_type();
-        PrimitiveType ptype = type_data->ptype();
-        if (vk::any_of_equal(ptype, tp_array, tp_mixed, tp_string)) {
-          W << VarName(var);
-          if (type_data->use_optional()) {
-            W << ".val()";
-          }
-          W << ".set_reference_counter_to(ExtraRefCnt::for_global_const);" << NL;
-        }
+        W << InitGlobalConstVar(var);
       }
     }
     W << END << NL;
@@ -220,6 +223,7 @@ void VarsCpp::compile(CodeGenerator &W) const {
       }
     }
   }
+  W << "dl::seal_global_const_memory();" << NL;
   W << END;
   W << CloseNamespace();
   W << CloseFile();
@@ -14,6 +14,18 @@
 #include "compiler/data/vars-collector.h"
 #include "compiler/vertex.h"
 
+namespace {
+
+// the value doesn't use the script memory, so it can outlive a request
+bool is_persistent_init_val(VertexPtr init_val) {
+  if (auto var_vertex = init_val.try_as<op_var>()) {
+    return var_vertex->extra_type == op_ex_var_const;
+  }
+  return vk::any_of_equal(init_val->type(), op_int_const, op_float_const, op_true, op_false, op_null);
+}
+
+} // namespace
+
 GlobalVarsReset::GlobalVarsReset(SrcFilePtr main_file) :
   main_file_(main_file) {
 }
@@ -48,10 +60,19 @@ void GlobalVarsReset::compile_part(FunctionPtr func, const std::set<VarPtr> &use
   }
 
   FunctionSignatureGenerator(W) << "void " << GlobalVarsResetFuncName(func, part_i) << " " << BEGIN;
+  std::vector<VarPtr> set_once_vars;
   for (auto var : used_vars) {
     if (G->settings().is_static_lib_mode() && var->is_builtin_global()) {
       continue;
     }
+    // a variable that is never written keeps its value between the requests:
+    // the default one is never reset, a persistent initial one is set by the first request only
+    if (var->is_read_only && !var->is_builtin_global() && (!var->init_val || is_persistent_init_val(var->init_val))) {
+      if (var->init_val) {
+        set_once_vars.emplace_back(var);
+      }
+      continue;
+    }
 
     W << "hard_reset_var(" << VarName(var);
     //FIXME: brk and comments
@@ -63,6 +84,18 @@ void GlobalVarsReset::compile_part(FunctionPtr func, const std::set<VarPtr> &use
     W << ");" << NL;
   }
 
+  if (!set_once_vars.empty()) {
+    W << "static bool vars_are_set = false;" << NL;
+    W << "if (!vars_are_set) " << BEGIN;
+    for (auto var : set_once_vars) {
+      W << "hard_reset_var(" << VarName(var) << ", ";
+      W << UnlockComments() << var->init_val << LockComments();
+      W << ");" << NL;
+    }
+    W << "vars_are_set = true;" << NL;
+    W << END << NL;
+  }
+
   W << END;
   W << NL;
   W << CloseNamespace();
@@ -75,6 +75,24 @@ static inline int array_len() {
 }
 
 
+// a vector of strings keeps the pointers to the chars of its elements, the strings are put into a separate raw data
+static std::vector<const std::string *> get_raw_array_strings(VertexAdaptor<op_array> vertex) {
+  std::vector<const std::string *> strings;
+  strings.reserve(vertex->size());
+  for (auto item : vertex->args()) {
+    VertexPtr actual_vertex = GenTree::get_actual_value(item);
+    if (auto double_arrow = actual_vertex.try_as<op_double_arrow>()) {
+      actual_vertex = GenTree::get_actual_value(double_arrow->value());
+    }
+    auto string_vertex = actual_vertex.try_as<op_string>();
+    if (!string_vertex) {
+      return {};
+    }
+    strings.emplace_back(&string_vertex->get_string());
+  }
+  return strings;
+}
+
 std::vector<int> compile_arrays_raw_representation(const std::vector<VarPtr> &const_raw_array_vars, CodeGenerator &W) {
   if (const_raw_array_vars.empty()) {
     return std::vector<int>();
@@ -83,24 +101,41 @@ std::vector<int> compile_arrays_raw_representation(const std::vector<VarPtr> &co
   std::vector<int> shifts;
   shifts.reserve(const_raw_array_vars.size());
 
+  std::vector<int> array_len_in_doubles(const_raw_array_vars.size(), -1);
+  std::vector<std::vector<const std::string *>> array_strings(const_raw_array_vars.size());
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < const_raw_array_vars.size(); ++i) {
+    VertexAdaptor<op_array> vertex = const_raw_array_vars[i]->init_val.as<op_array>();
+    const TypeData *vertex_inner_type = vertex->tinf_node.get_type()->lookup_at(Key::any_key());
+    int array_size = vertex->size();
+    if (array_size < 0 || array_size > (1 << 30) - array_len() || !CanGenerateRawArray::is_raw(vertex)) {
+      continue;
+    }
+    if (vk::any_of_equal(vertex_inner_type->ptype(), tp_int, tp_float)) {
+      array_len_in_doubles[i] = array_len() + array_size;
+    } else if (vertex_inner_type->ptype() == tp_string && !vertex_inner_type->use_optional() && array_size > 0) {
+      array_strings[i] = get_raw_array_strings(vertex);
+      if (!array_strings[i].empty()) {
+        array_len_in_doubles[i] = array_len() + array_size;
+        for (const std::string *s : array_strings[i]) {
+          strings.emplace_back(*s);
+        }
+      }
+    }
+  }
+  const std::vector<int> string_shifts = compile_raw_data(W, strings, "raw_array_strings");
+  auto string_shift_it = string_shifts.begin();
+
   int shift = 0;
 
-  for (auto var_it : const_raw_array_vars) {
-    VertexAdaptor<op_array> vertex = var_it->init_val.as<op_array>();
+  for (size_t i = 0; i < const_raw_array_vars.size(); ++i) {
+    VertexAdaptor<op_array> vertex = const_raw_array_vars[i]->init_val.as<op_array>();
 
     TypeData *vertex_inner_type = vertex->tinf_node.get_type()->lookup_at(Key::any_key());
 
-
     int array_size = vertex->size();
-    int array_len_in_doubles = -1;
-
-    if (0 <= array_size && array_size <= (1 << 30) - array_len()) {
-      if (vk::any_of_equal(vertex_inner_type->ptype(), tp_int, tp_float)) {
-        array_len_in_doubles = array_len() + array_size;
-      }
-    }
 
-    if (array_len_in_doubles == -1 || !CanGenerateRawArray::is_raw(vertex)) {
+    if (array_len_in_doubles[i] == -1) {
       shifts.push_back(-1);
       continue;
     }
@@ -109,16 +144,20 @@ std::vector<int> compile_arrays_raw_representation(const std::vector<VarPtr> &co
       W << ",";
     } else {
       W << "static_assert(sizeof(array<Unknown>::iterator::inner_type) == " << array_len() * sizeof(double) << ", \"size of array_len should be compatible with runtime array_inner\");" << NL;
+      if (!strings.empty()) {
+        W << "static_assert(sizeof(string) == sizeof(char *), \"a string in the raw arrays is the pointer to its chars\");" << NL;
+      }
       W << "static const union " << BEGIN
         << "struct { uint32_t a; uint32_t b; } is;" << NL
         << "double d;" << NL
         << "int64_t i64;" << NL
+        << "const char *p;" << NL
         << END
         << " raw_arrays[] = { ";
     }
 
     shifts.push_back(shift);
-    shift += array_len_in_doubles;
+    shift += array_len_in_doubles[i];
 
     // stub, ref_cnt
     W << "{ .is = { .a = 0, .b = " << ExtraRefCnt::for_global_const << "}},";
@@ -133,6 +172,14 @@ std::vector<int> compile_arrays_raw_representation(const std::vector<VarPtr> &co
     // string_size, string_buf_size
     W << "{ .is = { .a = 0 , .b = " << std::numeric_limits<uint32_t>::max() << " }}";
 
+    if (!array_strings[i].empty()) {
+      // the chars follow the 3 ints of the string header, see string_raw()
+      for (size_t j = 0; j < array_strings[i].size(); ++j) {
+        W << ", { .p = raw_array_strings + " << *string_shift_it++ + 3 * sizeof(int) << " }";
+      }
+      continue;
+    }
+
     auto args_end = vertex->args().end();
     for (auto it = vertex->args().begin(); it != args_end; ++it) {
       VertexPtr actual_vertex = GenTree::get_actual_value(*it);
@@ -155,4 +202,3 @@ std::vector<int> compile_arrays_raw_representation(const std::vector<VarPtr> &co
 
   return shifts;
 }
-
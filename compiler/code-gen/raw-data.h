@@ -29,7 +29,7 @@ std::vector<int> compile_arrays_raw_representation(const std::vector<VarPtr> &co
 template <typename Container,
   typename = decltype(std::declval<Container>().begin()),
   typename = decltype(std::declval<Container>().end())>
-std::vector<int> compile_raw_data(CodeGenerator &W, const Container &values) {
+std::vector<int> compile_raw_data(CodeGenerator &W, const Container &values, const char *raw_name = "raw") {
   std::string raw_data;
   std::vector<int> const_string_shifts(values.size());
   int ii = 0;
@@ -47,7 +47,7 @@ std::vector<int> compile_raw_data(CodeGenerator &W, const Container &values) {
     ii++;
   }
   if (!raw_data.empty()) {
-    W << "alignas(8) static const char raw[] = " << RawString(raw_data) << ";" << NL;
+    W << "alignas(8) static const char " << raw_name << "[] = " << RawString(raw_data) << ";" << NL;
   }
   return const_string_shifts;
 }
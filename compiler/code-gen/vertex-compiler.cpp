@@ -4,6 +4,7 @@
 
 #include "compiler/code-gen/vertex-compiler.h"
 
+#include <algorithm>
 #include <iterator>
 #include <unordered_map>
 
@@ -478,7 +479,102 @@ enum class func_call_mode {
   fork_call // call using fork
 };
 
+// in_array($s, CONST_LIST) of a string $s and a constant list of strings is compiled as the switch by strings:
+// the hashes of the strings are computed at the compile time, a matched hash is checked with one comparison;
+// a not strict comparison is replaced only if the strings can't be numeric, e.g. start with a letter
+static bool try_compile_in_const_string_list(VertexAdaptor<op_func_call> root, CodeGenerator &W) {
+  if (root->str_val != "in_array" || !root->func_id || !root->func_id->is_extern() || root->args().size() < 2) {
+    return false;
+  }
+  auto args = root->args();
+  const TypeData *needle_type = tinf::get_type(args[0]);
+  if (needle_type->ptype() != tp_string || needle_type->use_optional()) {
+    return false;
+  }
+  bool strict = false;
+  if (args.size() == 3) {
+    const auto strict_v = GenTree::get_actual_value(args[2]);
+    if (vk::none_of_equal(strict_v->type(), op_true, op_false)) {
+      return false;
+    }
+    strict = strict_v->type() == op_true;
+  }
+  auto list = GenTree::get_actual_value(args[1]).try_as<op_array>();
+  if (!list || list->args().empty()) {
+    return false;
+  }
+
+  std::map<int64_t, std::vector<const std::string *>> hash_to_strings;
+  for (auto item : list->args()) {
+    if (auto arrow = item.try_as<op_double_arrow>()) {
+      item = arrow->value();
+    }
+    const std::string *s = GenTree::get_constexpr_string(item);
+    if (!s || (!strict && (s->empty() || !(isalpha(static_cast<unsigned char>((*s)[0])) || (*s)[0] == '_')))) {
+      return false;
+    }
+    hash_to_strings[string_hash(s->c_str(), s->size())].emplace_back(s);
+  }
+
+  W << "[](const string &needle) noexcept " << BEGIN;
+  W << "switch (needle.hash()) " << BEGIN;
+  for (const auto &hash_and_strings : hash_to_strings) {
+    W << "case " << std::to_string(static_cast<long long>(hash_and_strings.first)) << ":" << NL;
+    W << Indent(2) << "return ";
+    for (const std::string *s : hash_and_strings.second) {
+      if (s != hash_and_strings.second.front()) {
+        W << " || ";
+      }
+      W << "(needle.size() == " << s->size() << " && !memcmp(needle.c_str(), " << RawString(*s) << ", " << s->size() << "))";
+    }
+    W << ";" << NL << Indent(-2);
+  }
+  W << "default:" << NL;
+  W << Indent(2) << "return false;" << NL << Indent(-2);
+  W << END << NL;
+  W << END << "(" << args[0] << ")";
+  return true;
+}
+
+// count(), array_sum(), array_values() and array_keys() of the array_filter() or array_map() result
+// are compiled as one loop of array_pipeline::<consumer>_<producer>(), the intermediate array isn't built;
+// the chains of several callbacks aren't fused, since it would change the order of the callback calls
+static bool try_compile_array_pipeline(VertexAdaptor<op_func_call> root, CodeGenerator &W) {
+  static const std::map<std::string, std::string> consumers = {
+    {"count", "count"}, {"array_sum", "sum"}, {"array_values", "values"}, {"array_keys", "keys"}
+  };
+  static const std::map<std::string, std::string> producers = {
+    {"array_filter", "filter"}, {"array_filter_by_key", "filter_by_key"}, {"array_map", "map"}
+  };
+  if (!root->func_id || !root->func_id->is_extern() || root->func_id->can_throw || root->args().size() != 1) {
+    return false;
+  }
+  auto inner = root->args()[0].try_as<op_func_call>();
+  if (!inner || !inner->func_id || !inner->func_id->is_extern() || inner->func_id->can_throw) {
+    return false;
+  }
+  auto consumer = consumers.find(root->func_id->name);
+  auto producer = producers.find(inner->func_id->name);
+  if (consumer == consumers.end() || producer == producers.end()) {
+    return false;
+  }
+  // array_map() can't drop the elements, but its callback must be called anyway
+  if (producer->second == "map" && vk::none_of_equal(consumer->second, "sum", "values")) {
+    return false;
+  }
+
+  W << "array_pipeline::" << consumer->second << "_" << producer->second << "(";
+  W << JoinValues(vk::make_iterator_range(inner->args().begin(), inner->args().end()), ", ") << ")";
+  return true;
+}
+
 void compile_func_call(VertexAdaptor<op_func_call> root, CodeGenerator &W, func_call_mode mode = func_call_mode::simple) {
+  if (mode == func_call_mode::simple && try_compile_in_const_string_list(root, W)) {
+    return;
+  }
+  if (mode == func_call_mode::simple && try_compile_array_pipeline(root, W)) {
+    return;
+  }
   if (root->str_val == "make_clone" && tinf::get_type(root->args()[0])->is_primitive_type()) {
     // avoid generating make_clone call for primitive types such that (int, double, bool) just for beauty
     W << root->args()[0];
@@ -1006,6 +1102,11 @@ void compile_function_resumable(VertexAdaptor<op_function> func_root, CodeGenera
 
 }
 
+// a constructor may let $this escape, which is known only after all the functions are analyzed
+static bool is_allocated_on_stack(VarPtr var) {
+  return var && var->stack_allocated_class && var->stack_allocated_class->construct_function->constructor_this_does_not_escape;
+}
+
 void compile_function(VertexAdaptor<op_function> func_root, CodeGenerator &W) {
   FunctionPtr func = func_root->func_id;
 
@@ -1021,6 +1122,17 @@ void compile_function(VertexAdaptor<op_function> func_root, CodeGenerator &W) {
 
   compile_tracing_profiler(func, W);
 
+  // the arena scope is destroyed after all the locals, as they may have the arena memory
+  if (func->is_arena) {
+    W << "ScriptArenaScope script_arena_scope;" << NL;
+  }
+
+  // the storages go first, so they are destroyed after the locals pointing to them
+  for (auto var : func->local_var_ids) {
+    if (is_allocated_on_stack(var)) {
+      W << var->stack_allocated_class->src_name << " " << VarName(var) << "$storage{};" << NL;
+    }
+  }
   for (auto var : func->local_var_ids) {
     if (var->type() != VarData::var_local_inplace_t && !var->is_foreach_reference) {
       W << VarDeclaration(var);
@@ -1063,7 +1175,8 @@ static bool can_save_ref(VertexPtr v) {
   return false;
 }
 
-void compile_string_build_as_string(VertexAdaptor<op_string_build> root, CodeGenerator &W) {
+// if append_to is set, the parts are appended to it in place instead of a new string
+void compile_string_build_as_string(VertexAdaptor<op_string_build> root, CodeGenerator &W, VertexPtr append_to = {}) {
   vector<StrlenInfo> info(root->size());
   bool ok = true;
   bool was_dynamic = false;
@@ -1148,16 +1261,20 @@ void compile_string_build_as_string(VertexAdaptor<op_string_build> root, CodeGen
     }
     W << ";" << NL;
     tmp_string_name = gen_unique_name("tmp_string");
-    W << "string " << tmp_string_name << " = ";
+    W << (append_to ? "string &" : "string ") << tmp_string_name << " = ";
   }
 
-  W << "string (";
+  if (append_to) {
+    W << append_to << ".reserve_at_least (" << append_to << ".size() + ";
+  } else {
+    W << "string (";
+  }
   if (complex_flag) {
     W << len_name;
   } else {
     W << static_length;
   }
-  W << ", true)";
+  W << (append_to ? ")" : ", true)");
   for (const auto &str_info : info) {
     W << ".append_unsafe (";
     if (str_info.str_flag) {
@@ -1248,7 +1365,13 @@ void compile_xset(VertexAdaptor<meta_op_xset> root, CodeGenerator &W) {
       } else {
         kphp_assert (0);
       }
-      W << index->key() << ")";
+      W << index->key();
+      if (root->type() == op_isset) {
+        if (auto precomputed_hash = can_use_precomputed_hash_indexing_array(index->key())) {
+          W << ", " << precomputed_hash << "L";
+        }
+      }
+      W << ")";
       return;
     }
   }
@@ -1274,7 +1397,11 @@ void compile_list(VertexAdaptor<op_list> root, CodeGenerator &W) {
     } else if (ptype == tp_shape) {
       W << "assign (" << kv->var() << ", " << ShapeGetIndex(arr, kv->key()) << ");" << NL;
     } else {
-      W << "assign (" << kv->var() << ", " << arr << ".get_value (" << kv->key() << "));" << NL;
+      W << "assign (" << kv->var() << ", " << arr << ".get_value (" << kv->key();
+      if (auto precomputed_hash = can_use_precomputed_hash_indexing_array(kv->key())) {
+        W << ", " << precomputed_hash << "L";
+      }
+      W << "));" << NL;
     }
   }
 }
@@ -1501,6 +1628,37 @@ void compile_string_build(VertexAdaptor<op_string_build> root, CodeGenerator &W)
   compile_string_build_as_string(root, W);
 }
 
+static bool uses_var(VertexPtr v, VarPtr var) {
+  if (auto v_var = v.try_as<op_var>()) {
+    return v_var->var_id == var;
+  }
+  return std::any_of(v->begin(), v->end(), [var](VertexPtr child) { return uses_var(child, var); });
+}
+
+// $s .= $a . ':' . $b is appended to $s directly, without the temporary string of the right side;
+// the parts may call functions, so $s has to be a local variable that they can't change
+static bool can_append_string_build_in_place(VertexAdaptor<op_set_dot> root) {
+  auto lhs = root->lhs().try_as<op_var>();
+  if (!lhs || root->rhs()->type() != op_string_build) {
+    return false;
+  }
+  VarPtr var = lhs->var_id;
+  if (!var) {
+    return false;
+  }
+  const TypeData *type = tinf::get_type(var);
+  return vk::any_of_equal(var->type(), VarData::var_local_t, VarData::var_param_t) && !var->is_reference &&
+         type->ptype() == tp_string && !type->use_optional() && !uses_var(root->rhs(), var);
+}
+
+void compile_set_dot(VertexAdaptor<op_set_dot> root, CodeGenerator &W) {
+  if (can_append_string_build_in_place(root)) {
+    compile_string_build_as_string(root->rhs().as<op_string_build>(), W, root->lhs());
+  } else {
+    compile_binary_op(root, W);
+  }
+}
+
 void compile_break_continue(VertexAdaptor<meta_op_goto> root, CodeGenerator &W) {
   if (root->int_val != 0) {
     W << "goto " << LabelName{root->int_val};
@@ -1721,6 +1879,11 @@ void compile_common_op(VertexPtr root, CodeGenerator &W) {
     case op_alloc: {
       const TypeData *tp = tinf::get_type(root);
       kphp_assert(tp->ptype() == tp_Class);
+      VarPtr storage_var = root.as<op_alloc>()->stack_storage_var;
+      if (is_allocated_on_stack(storage_var)) {
+        W << TypeName(tp) << "().alloc_on_stack(" << VarName(storage_var) << "$storage)";
+        break;
+      }
       auto alloc_function = tp->class_type()->is_empty_class() ? "().empty_alloc()" : "().alloc()";
       W << TypeName(tp) << alloc_function;
       break;
@@ -1756,9 +1919,15 @@ void compile_vertex(VertexPtr root, CodeGenerator &W) {
         compile_postfix_op(root.as<meta_op_unary>(), W);
         break;
       case binary_op:
-      case binary_func_op:
         compile_binary_op(root.as<meta_op_binary>(), W);
         break;
+      case binary_func_op:
+        if (auto set_dot = root.try_as<op_set_dot>()) {
+          compile_set_dot(set_dot, W);
+        } else {
+          compile_binary_op(root.as<meta_op_binary>(), W);
+        }
+        break;
       case ternary_op:
         compile_ternary_op(root.as<op_ternary>(), W);
         break;
@@ -4,9 +4,12 @@
 
 #include "compiler/compiler-settings.h"
 
+#include <algorithm>
+#include <dirent.h>
 #include <fstream>
 #include <openssl/sha.h>
 #include <sstream>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "common/algorithms/contains.h"
@@ -159,12 +162,39 @@ std::string CompilerSettings::get_version() const {
   return override_kphp_version.get().empty() ? get_version_string() : override_kphp_version.get();
 }
 
+static std::string get_pgo_profiles_signature(const std::string &dir) {
+  std::vector<std::string> names;
+  if (DIR *dp = opendir(dir.c_str())) {
+    while (const auto *entry = readdir(dp)) {
+      if (entry->d_name[0] != '.') {
+        names.emplace_back(entry->d_name);
+      }
+    }
+    closedir(dp);
+  }
+  std::sort(names.begin(), names.end());
+
+  std::string signature;
+  for (const auto &name : names) {
+    struct stat profile_stat;
+    if (stat((dir + name).c_str(), &profile_stat) == 0) {
+      signature += fmt_format("{} {} {}\n", name, profile_stat.st_size, profile_stat.st_mtime);
+    }
+  }
+  return signature;
+}
+
 void CompilerSettings::update_cxx_flags_sha256() {
   SHA256_CTX sha256;
   SHA256_Init(&sha256);
 
   auto cxx_flags_full = cxx.get() + cxx_flags.get() + debug_level.get();
   SHA256_Update(&sha256, cxx_flags_full.c_str(), cxx_flags_full.size());
+  if (!pgo_profile_dir.get().empty()) {
+    // the objects must be rebuilt when the profiles are updated, not only when the flags change
+    const auto profiles_signature = get_pgo_profiles_signature(pgo_profile_dir.get());
+    SHA256_Update(&sha256, profiles_signature.c_str(), profiles_signature.size());
+  }
 
   unsigned char hash[SHA256_DIGEST_LENGTH] = {0};
   SHA256_Final(hash, &sha256);
@@ -211,6 +241,21 @@ void CompilerSettings::init() {
     throw std::runtime_error{"Option " + static_lib_out_dir.get_env_var() + " is allowed only for static lib mode"};
   }
 
+  if (!objs_cache_dir.get().empty()) {
+    option_as_dir(objs_cache_dir);
+  }
+
+  if (!pgo_instrument_dir.get().empty() && !pgo_profile_dir.get().empty()) {
+    throw std::runtime_error{"Options " + pgo_instrument_dir.get_env_var() + " and " + pgo_profile_dir.get_env_var() + " can't be used together"};
+  }
+  if (!pgo_instrument_dir.get().empty()) {
+    mkdir_recursive(pgo_instrument_dir.get().c_str(), 0777);
+    option_as_dir(pgo_instrument_dir);
+  }
+  if (!pgo_profile_dir.get().empty()) {
+    option_as_dir(pgo_profile_dir);
+  }
+
   if (!jobs_count.get()) {
     jobs_count.value_ = get_default_threads_count();
   }
@@ -254,6 +299,14 @@ void CompilerSettings::init() {
   if (vk::contains(cxx.get(), "clang")) {
     ss << " -Wno-invalid-source-encoding";
   }
+  if (!pgo_instrument_dir.get().empty()) {
+    ss << " -fprofile-generate=" << pgo_instrument_dir.get();
+  }
+  if (!pgo_profile_dir.get().empty()) {
+    // the profiles may be collected from an older version of the code, the functions without the profile are optimized as usual
+    ss << " -fprofile-use=" << pgo_profile_dir.get();
+    ss << (vk::contains(cxx.get(), "clang") ? " -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date" : " -fprofile-partial-training -Wno-missing-profile");
+  }
   #if __cplusplus <= 201402L
     ss << " -std=gnu++14";
   #elif __cplusplus <= 201703L
@@ -283,6 +336,9 @@ void CompilerSettings::init() {
   append_if_doesnt_contain(ld_flags.value_, external_static_libs, "-l:lib", ".a");
 
   ld_flags.value_ += " -rdynamic";
+  if (!pgo_instrument_dir.get().empty()) {
+    ld_flags.value_ += " -fprofile-generate";
+  }
 
   for (auto &main_file : main_files.value_) {
     auto full_path = get_full_path(main_file);
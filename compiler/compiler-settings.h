@@ -128,7 +128,9 @@ public:
   KphpOption<std::string> colorize;
 
   KphpOption<std::string> stats_file;
+  KphpOption<std::string> objs_cache_dir;
   KphpOption<std::string> compilation_metrics_file;
+  KphpOption<std::string> compilation_trace_file;
   KphpOption<std::string> override_kphp_version;
   KphpOption<std::string> php_code_version;
 
@@ -138,6 +140,8 @@ public:
   KphpOption<std::string> debug_level;
   KphpOption<std::string> archive_creator;
   KphpOption<bool> dynamic_incremental_linkage;
+  KphpOption<std::string> pgo_instrument_dir;
+  KphpOption<std::string> pgo_profile_dir;
 
   KphpOption<uint64_t> profiler_level;
   KphpOption<bool> enable_global_vars_memory_stats;
@@ -146,6 +150,7 @@ public:
   KphpOption<bool> no_pch;
   KphpOption<bool> no_index_file;
   KphpOption<bool> show_progress;
+  KphpOption<bool> watch;
 
   KphpImplicitOption cxx_flags;
   KphpImplicitOption ld_flags;
@@ -97,6 +97,7 @@ prepend(KPHP_COMPILER_PIPES_SOURCES pipes/
         calc-empty-functions.cpp
         calc-func-dep.cpp
         calc-locations.cpp
+        calc-non-escaping-instances.cpp
         calc-real-defines-values.cpp
         calc-rl.cpp
         calc-val-ref.cpp
@@ -126,9 +127,11 @@ prepend(KPHP_COMPILER_PIPES_SOURCES pipes/
         fix-returns.cpp
         gen-tree-postprocess.cpp
         generate-virtual-methods.cpp
+        hoist-loop-invariants.cpp
         inline-defines-usages.cpp
         inline-simple-functions.cpp
         load-files.cpp
+        move-last-reads.cpp
         optimization.cpp
         parse.cpp
         prepare-function.cpp
@@ -169,7 +172,8 @@ prepend(KPHP_COMPILER_SOURCES ${KPHP_COMPILER_DIR}/
         stage.cpp
         stats.cpp
         tl-classes.cpp
-        vertex.cpp)
+        vertex.cpp
+        watch-mode.cpp)
 
 list(APPEND KPHP_COMPILER_SOURCES
      ${KPHP_COMPILER_COMMON}
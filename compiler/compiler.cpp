@@ -32,6 +32,7 @@
 #include "compiler/pipes/calc-const-types.h"
 #include "compiler/pipes/calc-empty-functions.h"
 #include "compiler/pipes/calc-locations.h"
+#include "compiler/pipes/calc-non-escaping-instances.h"
 #include "compiler/pipes/calc-real-defines-values.h"
 #include "compiler/pipes/calc-rl.h"
 #include "compiler/pipes/calc-val-ref.h"
@@ -62,10 +63,12 @@
 #include "compiler/pipes/final-check.h"
 #include "compiler/pipes/fix-returns.h"
 #include "compiler/pipes/gen-tree-postprocess.h"
+#include "compiler/pipes/hoist-loop-invariants.h"
 #include "compiler/pipes/generate-virtual-methods.h"
 #include "compiler/pipes/inline-simple-functions.h"
 #include "compiler/pipes/inline-defines-usages.h"
 #include "compiler/pipes/load-files.h"
+#include "compiler/pipes/move-last-reads.h"
 #include "compiler/pipes/optimization.h"
 #include "compiler/pipes/parse.h"
 #include "compiler/pipes/prepare-function.h"
@@ -177,6 +180,9 @@ bool compiler_execute(CompilerSettings *settings) {
   G = new CompilerCore();
   G->register_settings(settings);
   G->start();
+  if (!settings->compilation_trace_file.get().empty()) {
+    profiler_enable_trace();
+  }
   if (!settings->warnings_file.get().empty()) {
     FILE *f = fopen(settings->warnings_file.get().c_str(), "w");
     if (!f) {
@@ -265,6 +271,7 @@ bool compiler_execute(CompilerSettings *settings) {
     >> PassC<CheckClassesPass>{}
     >> PassC<CheckConversionsPass>{}
     >> PassC<OptimizationPass>{}
+    >> PassC<HoistLoopInvariantsPass>{}
     >> PassC<FixReturnsPass>{}
     >> PassC<CalcValRefPass>{}
     >> PassC<CalcFuncDepPass>{}
@@ -272,12 +279,14 @@ bool compiler_execute(CompilerSettings *settings) {
     >> PipeC<CheckUBF>{}
     >> PassC<ExtractResumableCallsPass>{}
     >> PassC<ExtractAsyncPass>{}
+    >> PassC<CalcNonEscapingInstancesPass>{}
     >> PassC<CheckNestedForeachPass>{}
     >> PassC<InlineSimpleFunctions>{}
     >> PassC<CommonAnalyzerPass>{}
     >> PassC<CheckTlClasses>{}
     >> PassC<CheckAccessModifiersPass>{}
     >> PassC<FinalCheckPass>{}
+    >> PassC<MoveLastReadsPass>{}
     >> PassC<RegisterKphpConfiguration>{}
     >> SyncC<CodeGenF>{}
     >> PipeC<WriteFilesF, false>{};
@@ -333,6 +342,7 @@ bool compiler_execute(CompilerSettings *settings) {
   }
 
   const std::string compilation_metrics_file = G->settings().compilation_metrics_file.get();
+  const std::string compilation_trace_file = G->settings().compilation_trace_file.get();
   G->finish();
   auto profiler_stats = collect_profiler_stats();
   G->stats.update_memory_stats();
@@ -340,9 +350,15 @@ bool compiler_execute(CompilerSettings *settings) {
   if (verbosity >= 1) {
     profiler_print_all(profiler_stats);
     std::cerr << std::endl;
+    profiler_print_scheduler_stages();
+    std::cerr << std::endl;
     std::cerr << "Compile stats:" << std::endl;
     G->stats.write_to(std::cerr);
   }
+  if (!compilation_trace_file.empty()) {
+    std::ofstream compilation_trace{compilation_trace_file};
+    profiler_write_trace(compilation_trace, profiler_stats);
+  }
   if (!compilation_metrics_file.empty()) {
     G->stats.profiler_stats = std::move(profiler_stats);
     std::ofstream compilation_metrics{compilation_metrics_file};
@@ -464,7 +464,7 @@ public:
 
 protected:
   bool on_trivial(VertexPtr v) override {
-    return vk::any_of_equal(v->type(), op_int_const, op_float_const);
+    return vk::any_of_equal(v->type(), op_int_const, op_float_const, op_string);
   }
 
   bool on_unary(VertexAdaptor<meta_op_unary> v) override {
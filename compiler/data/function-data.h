@@ -117,6 +117,10 @@ public:
   bool is_no_return = false;
   bool warn_unused_result = false;
   bool is_flatten = false;
+  bool is_arena = false;
+  // a built-in function, which keeps the script memory allocated by it till the end of the request
+  bool keeps_script_memory = false;
+  bool constructor_this_does_not_escape = false;
   enum class profiler_status : uint8_t {
     disable,
     // A function that is being profiled that starts and ends the profiling
@@ -5,6 +5,7 @@
 #include "compiler/data/src-file.h"
 
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -31,17 +32,30 @@ bool SrcFile::load() {
 
   kphp_assert_msg(buf.st_size < 100000000, fmt_format("file [{}] is too big [{}]\n", file_name, buf.st_size));
   int file_size = (int)buf.st_size;
-  text = string(file_size, ' ');
-  err = (int)read(fid, &text[0], file_size);
-  kphp_assert_msg(err >= 0, fmt_format("Can't read file [{}]: {}", file_name, strerror(errno)));
+  // the files are kept until the end of the compilation, so they are mapped without copying;
+  // the lexer expects a trailing zero, which the mapping has only if the file doesn't end on a page boundary
+  char *data = nullptr;
+  if (file_size % getpagesize() != 0) {
+    void *mapped = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fid, 0);
+    if (mapped != MAP_FAILED) {
+      data = static_cast<char *>(mapped);
+    }
+  }
+  if (data == nullptr) {
+    text_storage.resize(file_size);
+    err = (int)read(fid, &text_storage[0], file_size);
+    kphp_assert_msg(err >= 0, fmt_format("Can't read file [{}]: {}", file_name, strerror(errno)));
+    data = &text_storage[0];
+  }
+  text = vk::string_view{data, static_cast<size_t>(file_size)};
 
   for (int i = 0, prev_i = 0; i < file_size; i++) {
-    if (unlikely (text[i] == 0)) {
+    if (unlikely (data[i] == 0)) {
       kphp_warning(fmt_format("symbol with code zero was replaced by space in file [{}] at [{}]", file_name, i));
-      text[i] = ' ';
+      data[i] = ' ';
     }
-    if (text[i] == '\n') {
-      lines.push_back(vk::string_view(&text[prev_i], &text[i]));
+    if (data[i] == '\n') {
+      lines.push_back(vk::string_view(&data[prev_i], &data[i]));
       prev_i = i + 1;
     }
   }
@@ -14,7 +14,10 @@
 class SrcFile {
 public:
   int id{0};
-  std::string text, file_name, short_file_name;
+  // the text is modified in place by the lexer, it's either a private mapping of the file or text_storage
+  vk::string_view text;
+  std::string text_storage;
+  std::string file_name, short_file_name;
   std::string unified_file_name;
   std::string unified_dir_name;
   bool loaded{false};
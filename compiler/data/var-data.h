@@ -41,6 +41,8 @@ public:
   bool marked_as_const = false;
   bool is_read_only = true;
   bool is_foreach_reference = false;
+  // the only instance assigned to the local doesn't outlive the function, see CalcNonEscapingInstancesPass
+  ClassPtr stack_allocated_class;
   int dependency_level = 0;
 
   void set_uninited_flag(bool f);
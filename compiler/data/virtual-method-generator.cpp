@@ -187,6 +187,14 @@ VertexAdaptor<op_case> gen_case_calling_methods_on_derived_class(ClassPtr derive
  *     php_warning("call method(Interface::virtual_function) on empty class
  *     exit(0);
  *   }
+ *
+ * if Derived1 is the only class implementing the method, the switch is omitted:
+ *
+ * function virtual_function($param1, ...) {
+ *   if (is_null($this)) {
+ *     critical_error("call method(Interface::virtual_function) on null object");
+ *   }
+ *   return instance_cast<Derived1>($this)->virtual_function($param1, ...);
  */
 void generate_body_of_virtual_method(FunctionPtr virtual_function) {
   auto klass = virtual_function->class_id;
@@ -240,20 +248,31 @@ void generate_body_of_virtual_method(FunctionPtr virtual_function) {
     }
   }
 
-  if (!cases.empty()) {
-    auto warn_on_default = GenTree::generate_critical_error(fmt_format("call method({}) on null object", virtual_function->get_human_readable_name()));
-
-    auto call_of_exit = VertexAdaptor<op_seq>::create(warn_on_default);
-    cases.emplace_back(VertexAdaptor<op_default>::create(call_of_exit));
-  } else {
+  if (cases.empty()) {
     // just keep empty body, when there is no inheritors for interface method
     return;
   }
 
-  auto get_hash_of_this = VertexAdaptor<op_func_call>::create(ClassData::gen_vertex_this({}));
-  get_hash_of_this->set_string("get_hash_of_class");
+  auto warn_on_default = GenTree::generate_critical_error(fmt_format("call method({}) on null object", virtual_function->get_human_readable_name()));
+  auto call_of_exit = VertexAdaptor<op_seq>::create(warn_on_default);
+
+  VertexAdaptor<op_seq> body_of_virtual_method;
+  if (cases.size() == 1) {
+    // the whole program has the only class implementing the method, so an instance can't be of another class:
+    // the call is done without the virtual get_hash() and the switch
+    auto this_is_null = VertexAdaptor<op_func_call>::create(ClassData::gen_vertex_this({}));
+    this_is_null->set_string("is_null");
+    auto check_this = VertexAdaptor<op_if>::create(this_is_null, call_of_exit);
+    auto call_the_only_method = cases.front().as<op_case>()->cmd();
+    body_of_virtual_method = VertexAdaptor<op_seq>::create(check_this, call_the_only_method->args());
+  } else {
+    cases.emplace_back(VertexAdaptor<op_default>::create(call_of_exit));
 
-  auto body_of_virtual_method = VertexAdaptor<op_seq>::create(GenTree::create_switch_vertex(virtual_function, get_hash_of_this, std::move(cases)));
+    auto get_hash_of_this = VertexAdaptor<op_func_call>::create(ClassData::gen_vertex_this({}));
+    get_hash_of_this->set_string("get_hash_of_class");
+
+    body_of_virtual_method = VertexAdaptor<op_seq>::create(GenTree::create_switch_vertex(virtual_function, get_hash_of_this, std::move(cases)));
+  }
 
   auto &root = virtual_function->root;
   auto declaration_location = root->get_location();
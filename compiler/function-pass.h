@@ -131,6 +131,7 @@ typename FunctionPassTraits<FunctionPassT>::GetDataReturnT run_function_pass(Fun
 
   static CachedProfiler cache(demangle(typeid(FunctionPassT).name()));
   AutoProfiler prof{*cache};
+  TraceProfiler trace{cache.name(), function->name};
   pass->setup(function);
   pass->on_start();
   run_function_pass(function->root, pass);
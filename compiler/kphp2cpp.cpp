@@ -18,6 +18,7 @@
 #include "compiler/compiler-settings.h"
 #include "compiler/threading/tls.h"
 #include "compiler/utils/string-utils.h"
+#include "compiler/watch-mode.h"
 
 namespace {
 
@@ -251,8 +252,12 @@ int main(int argc, char *argv[]) {
              "colorize", "KPHP_COLORS", "auto", {"auto", "yes", "no"});
   parser.add("Save C++ compiler statistics to file", settings->stats_file,
              "stats-file", "KPHP_STATS_FILE");
+  parser.add("Directory of object files shared between builds, e.g. over NFS, keyed by the content of the generated sources and the compiler", settings->objs_cache_dir,
+             "objs-cache-dir", "KPHP_OBJS_CACHE_DIR");
   parser.add("Save transpilation metrics to file", settings->compilation_metrics_file,
              "compilation-metrics-file", "KPHP_COMPILATION_METRICS_FILE");
+  parser.add("Save the trace of the transpilation and the make (the Chrome trace event format) to file", settings->compilation_trace_file,
+             "compilation-trace-file", "KPHP_COMPILATION_TRACE_FILE");
   parser.add("Override kphp version string", settings->override_kphp_version,
              "kphp-version-override", "KPHP_VERSION_OVERRIDE");
   parser.add("Specify the compiled php code version", settings->php_code_version,
@@ -269,6 +274,10 @@ int main(int argc, char *argv[]) {
              "archive-creator", "KPHP_ARCHIVE_CREATOR", "ar");
   parser.add("Use dynamic incremental linkage for building the output binary", settings->dynamic_incremental_linkage,
              "dynamic-incremental-linkage", "KPHP_DYNAMIC_INCREMENTAL_LINKAGE");
+  parser.add("Build the output binary instrumented for profile-guided optimization, its workers write the profiles to this dir", settings->pgo_instrument_dir,
+             "pgo-instrument", "KPHP_PGO_INSTRUMENT");
+  parser.add("Build the output binary with profile-guided optimization, using the profiles from this dir", settings->pgo_profile_dir,
+             "pgo-profile", "KPHP_PGO_PROFILE");
   parser.add("Profile functions: 0 - disabled, 1 - enabled for marked functions, 2 - enabled for all", settings->profiler_level,
              'g', "profiler", "KPHP_PROFILER", "0", {"0", "1", "2"});
   parser.add("Enable an ability to get global vars memory stats", settings->enable_global_vars_memory_stats,
@@ -281,6 +290,8 @@ int main(int argc, char *argv[]) {
              "no-index-file", "KPHP_NO_INDEX_FILE");
   parser.add("Show transpilation progress", settings->show_progress,
              "show-progress", "KPHP_SHOW_PROGRESS");
+  parser.add("Recompile on every change of the php files under the base dir, until killed", settings->watch,
+             "watch", "KPHP_WATCH");
   parser.add("A folder that contains composer.json file", settings->composer_root,
              "composer-root", "KPHP_COMPOSER_ROOT");
   parser.add("Simulate the composer -no-dev flag behavior when handling composer files", settings->composer_no_dev,
@@ -317,6 +328,10 @@ int main(int argc, char *argv[]) {
     parser.dump_options(std::cerr);
   }
 
+  if (settings->watch.get()) {
+    compiler_watch(settings.get());
+  }
+
   if (!compiler_execute(settings.release())) {
     return 1;
   }
@@ -72,7 +72,7 @@ void LexerData::start_str() {
 /**
  * append_char and flush_str are used to modify entities in PHP source code like string literals
  * e.g. we have to tokenize this code: $x = "New\n";
- * but in class-field `std::string SrcFile::text` we have R"($x = \"New\\n\";)"
+ * but in `SrcFile::text` we have R"($x = \"New\\n\";)"
  * we will replace "\\n" with "\n" and get string_view on this representation from text field
  *
  * It's really strange behaviour to modify source text, it's better to have dedicated tokens for them
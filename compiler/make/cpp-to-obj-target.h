@@ -8,6 +8,7 @@
 
 #include "common/algorithms/contains.h"
 
+#include "compiler/make/hardlink-or-copy.h"
 #include "compiler/make/target.h"
 
 class Cpp2ObjTarget : public Target {
@@ -28,6 +29,21 @@ public:
     return ss.str();
   }
 
+  // the hash of everything the object depends on, empty if the object must not be cached
+  void set_cache_key(std::string cache_key) {
+    cache_key_ = std::move(cache_key);
+  }
+
+  bool restore_from_cache() final {
+    return !cache_key_.empty() && copy_file_atomically(cache_path(), target());
+  }
+
+  void store_to_cache() final {
+    if (!cache_key_.empty()) {
+      copy_file_atomically(target(), cache_path());
+    }
+  }
+
   void compute_priority() final {
     priority = 0;
     for (auto dep : deps) {
@@ -36,4 +52,11 @@ public:
       }
     }
   }
+
+private:
+  std::string cache_path() const {
+    return env->objs_cache_dir + cache_key_ + ".o";
+  }
+
+  std::string cache_key_;
 };
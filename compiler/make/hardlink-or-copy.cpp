@@ -7,6 +7,7 @@
 #include <cstring>
 #include <errno.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/sendfile.h>
 #include <sys/stat.h>
 
@@ -59,3 +60,32 @@ void hard_link_or_copy(const std::string &from, const std::string &to, bool repl
   hard_link_or_copy_impl(from, to, replace, true);
   stage::die_if_global_errors();
 }
+
+bool copy_file_atomically(const std::string &from, const std::string &to) noexcept {
+  const int from_fd = open(from.c_str(), O_RDONLY);
+  if (from_fd == -1) {
+    return false;
+  }
+  struct stat file_stat;
+  std::string tmp_file = to + ".XXXXXX";
+  const int tmp_fd = fstat(from_fd, &file_stat) == 0 ? mkstemp(&tmp_file[0]) : -1;
+  if (tmp_fd == -1) {
+    close(from_fd);
+    return false;
+  }
+  off_t copied = 0;
+  while (copied < file_stat.st_size) {
+    const ssize_t s = sendfile(tmp_fd, from_fd, &copied, file_stat.st_size - copied);
+    if (s <= 0) {
+      break;
+    }
+  }
+  const bool ok = copied == file_stat.st_size && fchmod(tmp_fd, 0644) == 0;
+  close(from_fd);
+  close(tmp_fd);
+  if (!ok || rename(tmp_file.c_str(), to.c_str()) != 0) {
+    unlink(tmp_file.c_str());
+    return false;
+  }
+  return true;
+}
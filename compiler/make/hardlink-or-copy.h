@@ -7,3 +7,7 @@
 #include <string>
 
 void hard_link_or_copy(const std::string &from, const std::string &to, bool replace = true);
+
+// copies through a temporary file renamed into the destination, so that concurrent readers never see a partial file;
+// unlike hard_link_or_copy() an error is reported by the result and does not stop the compilation
+bool copy_file_atomically(const std::string &from, const std::string &to) noexcept;
@@ -14,6 +14,7 @@ struct KphpMakeEnv {
   std::string incremental_linker;
   std::string incremental_linker_flags;
   std::string debug_level;
+  std::string objs_cache_dir;
 
   void add_gch_dir(const std::string &gch_dir) {
     cxx_flags.insert(0, "-iquote" + gch_dir + " ");
@@ -10,6 +10,7 @@
 #include "common/server/signals.h"
 
 #include "compiler/compiler-core.h"
+#include "compiler/threading/profiler.h"
 #include "compiler/utils/string-utils.h"
 
 void MakeRunner::run_target(Target *target) {
@@ -23,8 +24,20 @@ void MakeRunner::run_target(Target *target) {
     }
   }
 
+  if (!ready && target->restore_from_cache()) {
+    ready = target->after_run_success();
+    targets_from_cache += ready;
+  }
+
   if (!ready) {
+    // the longest jobs are started first, so that none of them is left alone at the end of the build
     target->compute_priority();
+    const auto it = previous_durations_.find(target->get_name());
+    if (it != previous_durations_.end()) {
+      target->priority = static_cast<long long>(it->second * 1e6);
+    } else if (seconds_per_priority_ > 0) {
+      target->priority = static_cast<long long>(target->priority * seconds_per_priority_ * 1e6);
+    }
     pending_jobs.push(target);
   } else {
     ready_target(target);
@@ -87,6 +100,26 @@ void MakeRunner::require_target(Target *target) {
   }
 }
 
+void MakeRunner::set_previous_durations(std::unordered_map<std::string, double> &&durations) noexcept {
+  previous_durations_ = std::move(durations);
+}
+
+// the priorities of the targets without a previous duration are scaled to seconds
+// by the ratio of the previous durations of the other targets to their priorities
+void MakeRunner::estimate_priorities() {
+  double total_seconds = 0;
+  long double total_priority = 0;
+  for (auto target : all_targets) {
+    const auto it = previous_durations_.find(target->get_name());
+    if (it != previous_durations_.end()) {
+      target->compute_priority();
+      total_seconds += it->second;
+      total_priority += target->priority;
+    }
+  }
+  seconds_per_priority_ = total_priority > 0 ? static_cast<double>(total_seconds / total_priority) : 0;
+}
+
 static int run_cmd(const string &cmd) {
   //fprintf (stdout, "%s\n", cmd.c_str());
   vector<string> args = split(cmd);
@@ -128,10 +161,13 @@ bool MakeRunner::finish_job(int pid, int return_code, int by_signal) {
   auto it = jobs.find(pid);
   assert (it != jobs.end());
   Target *target = it->second;
+  double passed = get_utime(CLOCK_MONOTONIC) - target->start_time;
   if (stats_file_) {
-    double passed = get_utime(CLOCK_MONOTONIC) - target->start_time;
     fmt_fprintf(stats_file_, "{}s {}\n", passed, target->get_name());
   }
+  // steady_clock is CLOCK_MONOTONIC as well
+  profiler_add_make_job_trace(target->get_name(), std::chrono::nanoseconds{static_cast<int64_t>(target->start_time * 1e9)},
+                              std::chrono::nanoseconds{static_cast<int64_t>(passed * 1e9)});
   jobs.erase(it);
   if (return_code != 0) {
     if (!fail_flag) {
@@ -151,6 +187,7 @@ bool MakeRunner::finish_job(int pid, int return_code, int by_signal) {
   if (!target->after_run_success()) {
     return false;
   }
+  target->store_to_cache();
   ready_target(target);
   return true;
 }
@@ -187,6 +224,9 @@ bool MakeRunner::make_target(Target *target, int jobs_count) {
 
   //fprintf (stderr, "make target: %s\n", target->get_name().c_str());
   //TODO: check timeouts
+  if (!previous_durations_.empty()) {
+    estimate_priorities();
+  }
   require_target(target);
 
   int total_jobs = targets_left;
@@ -259,6 +299,10 @@ bool MakeRunner::make_target(Target *target, int jobs_count) {
     }
   }
 
+  if (targets_from_cache) {
+    fmt_fprintf(stderr, "objs restored from the cache = {}\n", targets_from_cache);
+  }
+
   //TODO: use old handlers instead SIG_DFL
   ksignal(SIGINT, SIG_DFL);
   ksignal(SIGTERM, SIG_DFL);
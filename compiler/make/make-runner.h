@@ -6,6 +6,8 @@
 
 #include <map>
 #include <queue>
+#include <string>
+#include <unordered_map>
 
 #include "common/mixin/not_copyable.h"
 
@@ -21,8 +23,12 @@ class MakeRunner : private vk::not_copyable {
 private:
   int targets_waiting = 0;
   int targets_left = 0;
+  int targets_from_cache = 0;
   std::vector<Target *> all_targets;
   FILE *stats_file_{nullptr};
+  // the durations of the jobs in seconds by the target name, from the stats file of the previous build
+  std::unordered_map<std::string, double> previous_durations_;
+  double seconds_per_priority_{0};
 
   std::priority_queue<Target *, std::vector<Target *>, compare_by_priority> pending_jobs;
   std::map<int, Target *> jobs;
@@ -40,10 +46,12 @@ private:
   void one_dep_ready_target(Target *target);
   void wait_target(Target *target);
   void require_target(Target *target);
+  void estimate_priorities();
 
 public:
   void register_target(Target *target, std::vector<Target *> &&deps);
   bool make_target(Target *target, int jobs_count = 32);
+  void set_previous_durations(std::unordered_map<std::string, double> &&durations) noexcept;
   explicit MakeRunner(FILE *stats_file) noexcept;
   ~MakeRunner();
 };
@@ -4,10 +4,17 @@
 
 #include "compiler/make/make.h"
 
+#include <dirent.h>
 #include <forward_list>
+#include <fstream>
+#include <openssl/sha.h>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
+#include <utime.h>
 
+#include "common/algorithms/hashes.h"
+#include "common/smart_ptrs/unique_ptr_with_delete_function.h"
 #include "common/wrappers/mkdir_recursive.h"
 
 #include "compiler/compiler-core.h"
@@ -22,6 +29,10 @@
 #include "compiler/stage.h"
 #include "compiler/threading/profiler.h"
 
+static void close_dir(DIR *dir) {
+  closedir(dir);
+}
+
 class MakeSetup {
 private:
   MakeRunner make;
@@ -64,16 +75,19 @@ private:
   }
 
 public:
-  explicit MakeSetup(FILE *stats_file) noexcept:
+  MakeSetup(FILE *stats_file, std::unordered_map<std::string, double> previous_durations = {}) noexcept:
     make(stats_file) {
+    make.set_previous_durations(std::move(previous_durations));
   }
 
   Target *create_cpp_target(File *cpp) {
     return create_target(new FileTarget(), vector<Target *>(), cpp);
   }
 
-  Target *create_cpp2obj_target(File *cpp, File *obj) {
-    return create_target(new Cpp2ObjTarget(), to_targets(cpp), obj);
+  Target *create_cpp2obj_target(File *cpp, File *obj, std::string cache_key = {}) {
+    auto *target = new Cpp2ObjTarget();
+    target->set_cache_key(std::move(cache_key));
+    return create_target(target, to_targets(cpp), obj);
   }
 
   Target *create_objs2obj_target(vector<File *> objs, File *obj) {
@@ -96,6 +110,7 @@ public:
     env.incremental_linker = settings.incremental_linker.get();
     env.incremental_linker_flags = settings.incremental_linker_flags.get();
     env.debug_level = settings.debug_level.get();
+    env.objs_cache_dir = settings.objs_cache_dir.get();
   }
 
   void add_gch_dir(const std::string &gch_dir) {
@@ -177,15 +192,74 @@ static long long get_imported_header_mtime(const std::string &header_path, const
   return 0;
 }
 
+static std::string get_cxx_version(const std::string &cxx) {
+  std::string version;
+  if (FILE *out = popen((cxx + " --version 2>/dev/null").c_str(), "r")) {
+    char buf[256];
+    if (fgets(buf, sizeof(buf), out)) {
+      version = buf;
+    }
+    pclose(out);
+  }
+  return version;
+}
+
+// removes the least recently used versions of the precompiled header, "<gch_root>/<runtime sha256>/<flags hash>/",
+// so that the headers of several branches are kept, but the directory doesn't grow forever
+static void remove_old_precompiled_headers(const std::string &gch_root, size_t versions_to_keep) {
+  auto list_dir = [](const std::string &dir) {
+    std::vector<std::string> names;
+    vk::unique_ptr_with_delete_function<DIR, close_dir> dp{opendir(dir.c_str())};
+    if (dp == nullptr) {
+      return names;
+    }
+    while (const auto *entry = readdir(dp.get())) {
+      if (entry->d_name[0] != '.') {
+        names.emplace_back(entry->d_name);
+      }
+    }
+    return names;
+  };
+
+  std::vector<std::pair<time_t, std::string>> versions;
+  for (const auto &runtime_dir : list_dir(gch_root)) {
+    for (const auto &flags_dir : list_dir(gch_root + runtime_dir)) {
+      std::string version_dir = gch_root + runtime_dir + '/' + flags_dir + '/';
+      struct stat version_stat;
+      if (stat(version_dir.c_str(), &version_stat) == 0 && S_ISDIR(version_stat.st_mode)) {
+        versions.emplace_back(version_stat.st_mtime, std::move(version_dir));
+      }
+    }
+  }
+  if (versions.size() <= versions_to_keep) {
+    return;
+  }
+  std::sort(versions.begin(), versions.end(), std::greater<>{});
+  for (auto it = versions.begin() + versions_to_keep; it != versions.end(); ++it) {
+    for (const auto &file : list_dir(it->second)) {
+      unlink((it->second + file).c_str());
+    }
+    rmdir(it->second.c_str());
+    // succeeds only when the last version of this runtime was removed
+    rmdir(it->second.substr(0, it->second.rfind('/', it->second.size() - 2)).c_str());
+  }
+}
+
 static std::string kphp_make_precompiled_header(Index *obj_dir, const CompilerSettings &settings, FILE *stats_file) {
-  std::string gch_dir = "/tmp/kphp_gch/";
+  // the header is reused by the content of the runtime and the compiler with its flags, not by the mtimes,
+  // it survives the branch switches and is shared by the builds using the same objs cache dir
+  const std::string gch_root = settings.objs_cache_dir.get().empty() ? "/tmp/kphp_gch/" : settings.objs_cache_dir.get() + "gch/";
+  std::string gch_dir = gch_root;
   gch_dir.append(settings.runtime_sha256.get()).append(1, '/');
-  gch_dir.append(settings.cxx_flags_sha256.get()).append(1, '/');
+  gch_dir.append(settings.cxx_flags_sha256.get());
+  fmt_format_to(std::back_inserter(gch_dir), "-{:016x}/", vk::std_hash(get_cxx_version(settings.cxx.get())));
 
   const std::string header_filename = "runtime-headers.h";
   const std::string gch_filename = header_filename + ".gch";
   const std::string gch_path = gch_dir + gch_filename;
   if (access(gch_path.c_str(), F_OK) != -1) {
+    // the mtime of the version dir is its last use
+    utime(gch_dir.c_str(), nullptr);
     return gch_dir;
   }
 
@@ -215,6 +289,7 @@ static std::string kphp_make_precompiled_header(Index *obj_dir, const CompilerSe
   hard_link_or_copy(php_functions_h.path, gch_dir + header_filename, false);
   hard_link_or_copy(php_functions_h_gch->path, gch_path, false);
   php_functions_h_gch->unlink();
+  remove_old_precompiled_headers(gch_root, 8);
   return gch_dir;
 }
 
@@ -272,15 +347,75 @@ static std::unordered_map<File *, long long> create_dep_mtime(const Index &cpp_d
   return dep_mtime;
 }
 
+// the compiler path stays the same on its upgrade, so the version is a part of the objs cache key
+// the hash of the compiler, its flags, the runtime and the content of the cpp file with all the generated headers it includes;
+// the crc64 of the generated files is already known after writing them, so nothing is preprocessed to compute it
+static std::string create_obj_cache_key(File *cpp_file, const Index &cpp_dir, const std::forward_list<Index> &imported_headers,
+                                        const std::string &common_key) {
+  std::vector<File *> deps{cpp_file};
+  std::unordered_set<File *> visited{cpp_file};
+  for (size_t i = 0; i < deps.size(); ++i) {
+    for (const auto &include : deps[i]->includes) {
+      File *header = cpp_dir.get_file(include);
+      if (header && visited.insert(header).second) {
+        deps.push_back(header);
+      }
+    }
+  }
+  std::sort(deps.begin(), deps.end(), [](File *a, File *b) { return a->path < b->path; });
+
+  SHA256_CTX sha256;
+  SHA256_Init(&sha256);
+  SHA256_Update(&sha256, common_key.c_str(), common_key.size());
+  const char debug_info_flag = cpp_file->compile_with_debug_info_flag ? '1' : '0';
+  SHA256_Update(&sha256, &debug_info_flag, 1);
+  for (File *dep : deps) {
+    if (dep->crc64 == static_cast<unsigned long long>(-1)) {
+      return {};
+    }
+    SHA256_Update(&sha256, dep->name.data(), dep->name.size());
+    SHA256_Update(&sha256, &dep->crc64, sizeof(dep->crc64));
+    for (const auto &lib_include : dep->lib_includes) {
+      const long long mtime = get_imported_header_mtime(lib_include, imported_headers);
+      SHA256_Update(&sha256, lib_include.c_str(), lib_include.size());
+      SHA256_Update(&sha256, &mtime, sizeof(mtime));
+    }
+  }
+
+  unsigned char hash[SHA256_DIGEST_LENGTH] = {0};
+  SHA256_Final(hash, &sha256);
+  std::string hash_str;
+  hash_str.reserve(SHA256_DIGEST_LENGTH * 2);
+  for (auto hash_symb : hash) {
+    fmt_format_to(std::back_inserter(hash_str), "{:02x}", hash_symb);
+  }
+  return hash_str;
+}
+
 static std::vector<File *> create_obj_files(MakeSetup *make, Index &obj_dir, const Index &cpp_dir,
                                             const std::forward_list<Index> &imported_headers) {
   std::unordered_map<File *, long long> dep_mtime = create_dep_mtime(cpp_dir, imported_headers);
+  const auto &settings = G->settings();
+  std::string obj_cache_common_key;
+  if (!settings.objs_cache_dir.get().empty()) {
+    const mode_t old_mask = umask(0);
+    const bool dir_created = mkdir_recursive(settings.objs_cache_dir.get().c_str(), 0777);
+    umask(old_mask);
+    if (!dir_created) {
+      kphp_warning(fmt_format("Can't create objs cache dir '{}': {}", settings.objs_cache_dir.get(), strerror(errno)));
+    }
+    obj_cache_common_key = get_cxx_version(settings.cxx.get()) + settings.cxx_flags_sha256.get() + settings.runtime_sha256.get();
+  }
   std::vector<File *> objs;
   for (const auto &cpp_file : cpp_dir.get_files()) {
     if (cpp_file->ext == ".cpp") {
       File *obj_file = obj_dir.insert_file(static_cast<std::string>(cpp_file->name_without_ext) + ".o");
       obj_file->compile_with_debug_info_flag = cpp_file->compile_with_debug_info_flag;
-      make->create_cpp2obj_target(cpp_file, obj_file);
+      std::string cache_key;
+      if (!obj_cache_common_key.empty()) {
+        cache_key = create_obj_cache_key(cpp_file, cpp_dir, imported_headers, obj_cache_common_key);
+      }
+      make->create_cpp2obj_target(cpp_file, obj_file, std::move(cache_key));
       Target *cpp_target = cpp_file->target;
       cpp_target->force_changed(dep_mtime[cpp_file]);
       objs.push_back(obj_file);
@@ -322,8 +457,8 @@ static std::vector<File *> create_obj_files(MakeSetup *make, Index &obj_dir, con
 
 static bool kphp_make(File &bin, Index &obj_dir, const Index &cpp_dir, std::forward_list<File> imported_libs,
                       const std::forward_list<Index> &imported_headers, const CompilerSettings &settings,
-                      const std::string &gch_dir, FILE *stats_file) {
-  MakeSetup make{stats_file};
+                      const std::string &gch_dir, FILE *stats_file, std::unordered_map<std::string, double> previous_durations) {
+  MakeSetup make{stats_file, std::move(previous_durations)};
   std::vector<File *> lib_objs;
   for (File &link_file: imported_libs) {
     make.create_cpp_target(&link_file);
@@ -341,8 +476,8 @@ static bool kphp_make(File &bin, Index &obj_dir, const Index &cpp_dir, std::forw
 
 static bool kphp_make_static_lib(File &static_lib, Index &obj_dir, const Index &cpp_dir,
                                  const std::forward_list<Index> &imported_headers, const CompilerSettings &settings,
-                                 const std::string &gch_dir, FILE *stats_file) {
-  MakeSetup make{stats_file};
+                                 const std::string &gch_dir, FILE *stats_file, std::unordered_map<std::string, double> previous_durations) {
+  MakeSetup make{stats_file, std::move(previous_durations)};
   std::vector<File *> objs = create_obj_files(&make, obj_dir, cpp_dir, imported_headers);
   make.create_objs2static_lib_target(objs, &static_lib);
   make.init_env(settings);
@@ -363,10 +498,38 @@ static std::forward_list<Index> collect_imported_headers() {
   return imported_headers;
 }
 
+// the "<seconds>s <target>" lines written by MakeRunner for every finished job
+static std::unordered_map<std::string, double> read_make_durations(const std::string &stats_file) {
+  std::unordered_map<std::string, double> durations;
+  std::ifstream in{stats_file};
+  std::string line;
+  while (std::getline(in, line)) {
+    const size_t space_pos = line.find("s ");
+    if (space_pos != std::string::npos) {
+      durations[line.substr(space_pos + 2)] = atof(line.c_str());
+    }
+  }
+  return durations;
+}
+
+// the objects compiled with other flags, e.g. with another pgo profile, can't be reused
+static bool cxx_flags_changed(const std::string &stamp_path, const std::string &cxx_flags_sha256) {
+  std::string prev_sha256;
+  std::ifstream{stamp_path} >> prev_sha256;
+  if (prev_sha256 == cxx_flags_sha256) {
+    return false;
+  }
+  std::ofstream{stamp_path} << cxx_flags_sha256;
+  // a first build with the stamp keeps the objects
+  return !prev_sha256.empty();
+}
+
 void run_make() {
   const auto &settings = G->settings();
   FILE *make_stats_file = nullptr;
+  std::unordered_map<std::string, double> previous_durations;
   if (!settings.stats_file.get().empty()) {
+    previous_durations = read_make_durations(settings.stats_file.get());
     make_stats_file = fopen(settings.stats_file.get().c_str(), "w");
     kphp_error(make_stats_file, fmt_format("Can't open stats-file {}", settings.stats_file.get()));
     stage::die_if_global_errors();
@@ -382,7 +545,7 @@ void run_make() {
   File bin_file(settings.binary_path.get());
   kphp_assert (bin_file.read_stat() >= 0);
 
-  if (settings.force_make.get()) {
+  if (settings.force_make.get() || cxx_flags_changed(settings.dest_dir.get() + "cxx-flags.sha256", settings.cxx_flags_sha256.get())) {
     obj_index.del_extra_files();
     bin_file.unlink();
   }
@@ -398,8 +561,9 @@ void run_make() {
   if (ok) {
     auto lib_header_dirs = collect_imported_headers();
     ok = settings.is_static_lib_mode()
-         ? kphp_make_static_lib(bin_file, obj_index, G->get_index(), lib_header_dirs, settings, gch_dir, make_stats_file)
-         : kphp_make(bin_file, obj_index, G->get_index(), collect_imported_libs(), lib_header_dirs, settings, gch_dir, make_stats_file);
+         ? kphp_make_static_lib(bin_file, obj_index, G->get_index(), lib_header_dirs, settings, gch_dir, make_stats_file, std::move(previous_durations))
+         : kphp_make(bin_file, obj_index, G->get_index(), collect_imported_libs(), lib_header_dirs, settings, gch_dir, make_stats_file,
+                     std::move(previous_durations));
     kphp_error (ok, "Make failed");
   }
 
@@ -44,6 +44,9 @@ public:
   void on_require();
   bool after_run_success() __attribute__ ((warn_unused_result));
   void after_run_fail();
+  // instead of running its command a target may be restored from a cache, where it is put after a successful run
+  virtual bool restore_from_cache() { return false; }
+  virtual void store_to_cache() {}
 
   void force_changed(long long new_mtime);
   bool require();
@@ -49,6 +49,7 @@ const std::map<string, php_doc_tag::doc_type> php_doc_tag::str2doc_type = {
   {"@kphp-serialized-field",     kphp_serialized_field},
   {"@kphp-profile",              kphp_profile},
   {"@kphp-profile-allow-inline", kphp_profile_allow_inline},
+  {"@kphp-arena",                kphp_arena},
 };
 
 vector<php_doc_tag> parse_php_doc(vk::string_view phpdoc) {
@@ -42,7 +42,8 @@ struct php_doc_tag {
     kphp_reserved_fields,
     kphp_serialized_field,
     kphp_profile,
-    kphp_profile_allow_inline
+    kphp_profile_allow_inline,
+    kphp_arena
   };
 
 public:
@@ -4,12 +4,16 @@
 
 #include "compiler/pipes/analyzer.h"
 
+#include <map>
+
 #include "common/algorithms/string-algorithms.h"
 
 #include "compiler/compiler-core.h"
 #include "compiler/data/class-data.h"
 #include "compiler/data/define-data.h"
 #include "compiler/data/var-data.h"
+#include "compiler/inferring/edge.h"
+#include "compiler/inferring/expr-node.h"
 #include "compiler/inferring/public.h"
 #include "compiler/utils/string-utils.h"
 
@@ -65,6 +69,35 @@ void check_var_init_value(const VarPtr &var) {
   }
 }
 
+// a mixed param makes the whole function work through the mixed dispatch, even if almost all the callers pass one type;
+// a function specialized for that type is worth to be written then, as the types are inferred only once
+void check_mixed_param_of_mostly_one_type(FunctionPtr function, VarPtr param) {
+  std::map<PrimitiveType, int> passed_types;
+  int call_sites = 0;
+  for (const tinf::Edge *edge : param->tinf_node.get_next()) {
+    const auto *arg = dynamic_cast<const tinf::ExprNode *>(edge->to);
+    if ((edge->from_at && !edge->from_at->empty()) || !arg || arg->get_expr()->get_location().get_function() == function) {
+      continue;
+    }
+    call_sites++;
+    const TypeData *arg_type = arg->get_type();
+    if (vk::any_of_equal(arg_type->ptype(), tp_bool, tp_int, tp_float, tp_string) && !arg_type->use_optional()) {
+      passed_types[arg_type->ptype()]++;
+    }
+  }
+  if (call_sites < 2) {
+    return;
+  }
+  for (const auto &passed_type : passed_types) {
+    if (passed_type.second * 10 >= call_sites * 9) {
+      kphp_warning(fmt_format("Parameter ${} of {} is inferred as mixed, but {} of {} call sites pass {}: a separate {} function would avoid the mixed dispatch",
+                              param->name, function->get_human_readable_name(), passed_type.second, call_sites,
+                              ptype_name(passed_type.first), ptype_name(passed_type.first)));
+      return;
+    }
+  }
+}
+
 }
 
 void CommonAnalyzerPass::check_set(VertexAdaptor<op_set> to_check) {
@@ -117,6 +150,10 @@ void CommonAnalyzerPass::on_finish() {
   for (VarPtr &var : current_function->param_ids) {
     G->stats.cnt_mixed_params += tinf::get_type(var)->ptype() == tp_mixed;
     G->stats.cnt_const_mixed_params += (tinf::get_type(var)->ptype() == tp_mixed) && var->is_read_only;
+    if (G->settings().warnings_level.get() >= 2 && tinf::get_type(var)->ptype() == tp_mixed) {
+      stage::set_location(current_function->root->get_location());
+      check_mixed_param_of_mostly_one_type(current_function, var);
+    }
   }
 
   if (current_function->type == FunctionData::func_class_holder) {
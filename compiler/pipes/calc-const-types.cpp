@@ -29,8 +29,22 @@ void CalcConstTypePass::calc_const_type_of_class_fields(ClassPtr klass) {
   });
 }
 
+VertexAdaptor<op_string> CalcConstTypePass::get_strlen_of_literal_arg(VertexAdaptor<op_func_call> call) {
+  if (!call->func_id || !call->func_id->is_extern() || call->func_id->name != "strlen" || call->args().size() != 1) {
+    return {};
+  }
+  return call->args()[0].try_as<op_string>();
+}
+
 VertexPtr CalcConstTypePass::on_exit_vertex(VertexPtr v) {
   if (auto as_func_call = v.try_as<op_func_call>()) {
+    // the other pure functions of constants are calculated once on the start, see CollectConstVarsPass
+    if (auto strlen_arg = get_strlen_of_literal_arg(as_func_call)) {
+      auto len = VertexAdaptor<op_int_const>::create().set_location(v);
+      len->str_val = std::to_string(strlen_arg->str_val.size());
+      len->const_type = cnst_const_val;
+      return len;
+    }
     auto root = as_func_call->func_id ? as_func_call->func_id->root : VertexAdaptor<op_function>{};
     if (!root || !root->type_rule || root->type_rule->rule()->extra_type != op_ex_rule_const) {
       v->const_type = cnst_nonconst_val;
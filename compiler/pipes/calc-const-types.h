@@ -9,6 +9,7 @@
 /*** Calculate const_type for all nodes ***/
 class CalcConstTypePass final : public FunctionPassBase {
   void calc_const_type_of_class_fields(ClassPtr klass);
+  static VertexAdaptor<op_string> get_strlen_of_literal_arg(VertexAdaptor<op_func_call> call);
 
 public:
 
@@ -0,0 +1,122 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "compiler/pipes/calc-non-escaping-instances.h"
+
+#include "common/algorithms/find.h"
+
+#include "compiler/data/class-data.h"
+#include "compiler/data/var-data.h"
+#include "compiler/inferring/public.h"
+
+namespace {
+
+bool is_loop(Operation op) {
+  return vk::any_of_equal(op, op_for, op_while, op_do, op_foreach);
+}
+
+// the uses of the instance, which neither copy it anywhere nor keep it after the expression
+bool is_local_use(VertexPtr parent, VertexPtr var) {
+  switch (parent->type()) {
+    case op_instance_prop:
+    case op_isset:
+    case op_eq3:
+    case op_neq3:
+    case op_conv_bool:
+    case op_log_not:
+    case op_clone:
+      return true;
+    case op_instanceof:
+      return parent.as<op_instanceof>()->lhs() == var;
+    default:
+      return false;
+  }
+}
+
+} // namespace
+
+VertexAdaptor<op_alloc> CalcNonEscapingInstancesPass::get_stack_allocatable(VertexAdaptor<op_set> set) {
+  auto call = set->rhs().try_as<op_func_call>();
+  if (!call || call->args().empty()) {
+    return {};
+  }
+  auto alloc = call->args()[0].try_as<op_alloc>();
+  if (!alloc) {
+    return {};
+  }
+  ClassPtr klass = alloc->allocated_class;
+  if (!klass || klass->construct_function != call->func_id || klass->is_empty_class() || klass->is_lambda() ||
+      klass->is_builtin() || klass->is_tl_class) {
+    return {};
+  }
+  VarPtr var = set->lhs().as<op_var>()->var_id;
+  const TypeData *type = tinf::get_type(var);
+  if (type->ptype() != tp_Class || type->use_optional() || type->class_type() != klass) {
+    return {};
+  }
+  return alloc;
+}
+
+void CalcNonEscapingInstancesPass::on_var_use(VertexAdaptor<op_var> var) {
+  VarPtr var_id = var->var_id;
+  VertexPtr parent = parents_.back();
+
+  if (current_function->is_constructor() && !current_function->param_ids.empty() && var_id == current_function->param_ids.front()) {
+    this_escapes_ |= !vk::any_of_equal(parent->type(), op_instance_prop, op_return);
+    return;
+  }
+  if (var_id->type() != VarData::var_local_t || var_id->is_reference || escaped_vars_.count(var_id)) {
+    return;
+  }
+  if (is_local_use(parent, var)) {
+    return;
+  }
+
+  auto set = parent.try_as<op_set>();
+  const bool is_assignment = set && set->lhs() == var;
+  VertexAdaptor<op_alloc> alloc;
+  if (is_assignment && !loops_depth_ && parents_.size() >= 2 && parents_[parents_.size() - 2]->type() == op_seq &&
+      !allocations_.count(var_id)) {
+    alloc = get_stack_allocatable(set);
+  }
+  if (alloc) {
+    allocations_.emplace(var_id, alloc);
+  } else {
+    escaped_vars_.insert(var_id);
+  }
+}
+
+VertexPtr CalcNonEscapingInstancesPass::on_enter_vertex(VertexPtr vertex) {
+  if (auto var = vertex.try_as<op_var>()) {
+    if (var->var_id && !parents_.empty()) {
+      on_var_use(var);
+    }
+  }
+  if (is_loop(vertex->type())) {
+    loops_depth_++;
+  }
+  parents_.emplace_back(vertex);
+  return vertex;
+}
+
+VertexPtr CalcNonEscapingInstancesPass::on_exit_vertex(VertexPtr vertex) {
+  parents_.pop_back();
+  if (is_loop(vertex->type())) {
+    loops_depth_--;
+  }
+  return vertex;
+}
+
+void CalcNonEscapingInstancesPass::on_finish() {
+  if (current_function->is_constructor()) {
+    current_function->constructor_this_does_not_escape = !this_escapes_;
+  }
+  for (const auto &allocation : allocations_) {
+    VarPtr var = allocation.first;
+    if (!escaped_vars_.count(var)) {
+      var->stack_allocated_class = allocation.second->allocated_class;
+      allocation.second->stack_storage_var = var;
+    }
+  }
+}
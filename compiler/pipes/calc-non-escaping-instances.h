@@ -0,0 +1,38 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "compiler/function-pass.h"
+
+// Finds the locals holding the only instance created by `$x = new A(...)`, which can't outlive the function:
+// the local is assigned once outside of the loops, and the other uses only read or write the fields of the instance.
+// Such instances are placed into the function frame instead of the heap, if the constructor doesn't let $this escape too,
+// which is known for all the functions only at the code generation
+class CalcNonEscapingInstancesPass final : public FunctionPassBase {
+  std::vector<VertexPtr> parents_;
+  int loops_depth_{0};
+  std::unordered_map<VarPtr, VertexAdaptor<op_alloc>> allocations_;
+  std::unordered_set<VarPtr> escaped_vars_;
+  bool this_escapes_{false};
+
+  static VertexAdaptor<op_alloc> get_stack_allocatable(VertexAdaptor<op_set> set);
+  void on_var_use(VertexAdaptor<op_var> var);
+
+public:
+  string get_description() override {
+    return "Calc non-escaping instances";
+  }
+
+  bool check_function(FunctionPtr function) const override {
+    return !function->is_extern() && !function->is_resumable;
+  }
+
+  VertexPtr on_enter_vertex(VertexPtr vertex) override;
+  VertexPtr on_exit_vertex(VertexPtr vertex) override;
+  void on_finish() override;
+};
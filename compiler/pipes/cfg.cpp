@@ -4,6 +4,9 @@
 
 #include "compiler/pipes/cfg.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "compiler/data/function-data.h"
 #include "compiler/function-pass.h"
 #include "compiler/gentree.h"
@@ -89,7 +92,10 @@ class CFG {
   IdMap<is_func_id_t> node_checked_type;
   IdMap<UsagePtr> node_mark_dfs;
   IdMap<int> node_mark_dfs_type_hint;
+  IdMap<int> node_mark_live;
+  int cur_live_mark = 0;
   IdMap<VarSplitPtr> var_split_data;
+  bool has_try = false;
 
   std::vector<std::vector<Node>> continue_nodes;
   std::vector<std::vector<Node>> break_nodes;
@@ -125,6 +131,7 @@ class CFG {
   void compress_usages(std::vector<UsagePtr> &usages);
   void dfs_uni_rw_usages(Node v, UsagePtr usage);
   void dfs_apply_type_hint(Node v, UsagePtr usage);
+  void calc_last_reads(VarPtr var);
   void process_var(FunctionPtr function, VarPtr v);
   int register_vertices(VertexPtr v, int N);
   void add_uninited_var(VertexAdaptor<op_var> v);
@@ -869,6 +876,7 @@ void CFG::create_cfg(VertexPtr tree_node, Node *res_start, Node *res_finish, boo
     }
     case op_try: {
       auto try_op = tree_node.as<op_try>();
+      has_try = true;
       Node exception_start, exception_finish;
       create_cfg(try_op->exception(), &exception_start, &exception_finish, true);
 
@@ -1104,10 +1112,60 @@ void CFG::split_var(FunctionPtr function, VarPtr var, vector<std::vector<VertexA
   data.todo_parts.emplace_back(std::move(parts));
 }
 
+// a read is the last one if no other read of the variable is reachable from it without passing a write,
+// so the code generation may move the value out of the variable there instead of copying it
+void CFG::calc_last_reads(VarPtr var) {
+  VarSplitPtr var_split = var_split_data[var];
+
+  cur_live_mark++;
+  std::vector<Node> live_nodes;
+  for (UsagePtr u : var_split->usage_gen) {
+    if (u->type == usage_read_t && node_mark_live[u->node] != cur_live_mark) {
+      node_mark_live[u->node] = cur_live_mark;
+      live_nodes.push_back(u->node);
+    }
+  }
+  // nodes hold usages of the same type only, so a node with a write of the variable can't be live itself
+  auto is_write_node = [&](Node v) {
+    return std::any_of(node_usages[v].begin(), node_usages[v].end(),
+                       [&](UsagePtr u) { return u->type == usage_write_t && u->v->var_id == var; });
+  };
+  while (!live_nodes.empty()) {
+    Node v = live_nodes.back();
+    live_nodes.pop_back();
+    for (Node prev : node_prev[v]) {
+      if (node_mark_live[prev] != cur_live_mark && !is_write_node(prev)) {
+        node_mark_live[prev] = cur_live_mark;
+        live_nodes.push_back(prev);
+      }
+    }
+  }
+
+  // the reads inside one expression share a node, the order of their evaluation is unknown
+  std::unordered_map<int, int> usages_in_node;
+  for (UsagePtr u : var_split->usage_gen) {
+    usages_in_node[get_index(u->node)]++;
+  }
+  for (UsagePtr u : var_split->usage_gen) {
+    if (u->type != usage_read_t || u->weak_write_flag || usages_in_node[get_index(u->node)] != 1) {
+      continue;
+    }
+    const auto &next = node_next[u->node];
+    if (std::none_of(next.begin(), next.end(), [&](Node v) { return node_mark_live[v] == cur_live_mark; })) {
+      u->v->is_last_read = true;
+    }
+  }
+}
+
 void CFG::process_var(FunctionPtr function, VarPtr var) {
   VarSplitPtr var_split = var_split_data[var];
   kphp_assert (var_split);
 
+  // the exceptions edges are not precise before the can_throw flags are calculated
+  if (!has_try) {
+    calc_last_reads(var);
+  }
+
   cur_dfs_mark++;
   std::fill(node_checked_type.begin(), node_checked_type.end(), static_cast<is_func_id_t>(0));
   dfs_checked_types(current_start, var, static_cast<is_func_id_t>(ifi_any_type | ((var->type() == VarData::var_param_t) ? 0 : ifi_unset)));
@@ -1309,9 +1367,11 @@ void CFG::process_function(FunctionPtr function) {
   node_gen.add_id_map(&node_checked_type);
   node_gen.add_id_map(&node_mark_dfs);
   node_gen.add_id_map(&node_mark_dfs_type_hint);
+  node_gen.add_id_map(&node_mark_live);
   node_gen.add_id_map(&node_usages);
   node_gen.add_id_map(&node_subtrees);
   cur_dfs_mark = 0;
+  cur_live_mark = 0;
 
   Node start, finish;
   create_cfg(function->root, &start, &finish);
@@ -179,7 +179,6 @@ void CodeGenF::on_finish(DataStream<WriterData> &os) {
     W << Async(TypeTagger(std::move(forkable_types), std::move(waitable_types)));
   }
 
-  //TODO: use Async for that
   tl2cpp::write_tl_query_handlers(W);
   write_lib_version(W);
   if (!G->settings().is_static_lib_mode()) {
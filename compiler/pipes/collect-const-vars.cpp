@@ -40,6 +40,9 @@ VertexPtr CollectConstVarsPass::on_enter_vertex(VertexPtr root) {
   if (root->const_type == cnst_const_val) {
     if (root->type() == op_conv_regexp) {
       VertexPtr expr = GenTree::get_actual_value(root.as<op_conv_regexp>()->expr());
+      if (auto regexp = expr.try_as<op_string>()) {
+        check_const_regexp(regexp);
+      }
       if (vk::any_of_equal(expr->type(), op_string, op_concat, op_string_build)) {
         return create_const_variable(root, root->location);
       }
@@ -54,6 +57,54 @@ VertexPtr CollectConstVarsPass::on_enter_vertex(VertexPtr root) {
   return root;
 }
 
+// the same checks as regexp::init() does on the worker start, the pattern itself is compiled there
+void CollectConstVarsPass::check_const_regexp(VertexAdaptor<op_string> regexp) {
+  const std::string &pattern = regexp->str_val;
+  stage::set_location(regexp->location);
+  kphp_error_return(!pattern.empty(), "Empty regular expression");
+
+  char end_delimiter = 0;
+  switch (pattern[0]) {
+    case '(':
+      end_delimiter = ')';
+      break;
+    case '[':
+      end_delimiter = ']';
+      break;
+    case '{':
+      end_delimiter = '}';
+      break;
+    case '>':
+      end_delimiter = '>';
+      break;
+    case '!' ... '\'':
+    case '*' ... '/':
+    case ':':
+    case ';':
+    case '=':
+    case '?':
+    case '@':
+    case '^':
+    case '_':
+    case '`':
+    case '|':
+    case '~':
+      end_delimiter = pattern[0];
+      break;
+    default:
+      kphp_error_return(false, fmt_format("Wrong start delimiter in regular expression \"{}\"", pattern));
+  }
+
+  const size_t regexp_end = pattern.find_last_of(end_delimiter);
+  kphp_error_return(regexp_end != 0 && regexp_end != std::string::npos,
+                    fmt_format("No ending matching delimiter '{}' found in regexp: {}", end_delimiter, pattern));
+
+  for (size_t i = regexp_end + 1; i < pattern.size(); ++i) {
+    kphp_error_return(vk::string_view{"imsxADSUXu"}.find(pattern[i]) != vk::string_view::npos,
+                      fmt_format("Unknown modifier '{}' found in regexp: {}", pattern[i], pattern));
+  }
+}
+
 bool CollectConstVarsPass::should_convert_to_const(VertexPtr root) {
   return vk::any_of_equal(root->type(), op_string, op_array, op_concat, op_string_build, op_func_call);
 }
@@ -15,6 +15,7 @@ private:
 
   int get_dependency_level(VertexPtr vertex);
   bool should_convert_to_const(VertexPtr root);
+  void check_const_regexp(VertexAdaptor<op_string> regexp);
   VertexPtr create_const_variable(VertexPtr root, Location loc);
 
 public:
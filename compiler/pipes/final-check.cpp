@@ -4,6 +4,8 @@
 
 #include "compiler/pipes/final-check.h"
 
+#include <unordered_set>
+
 #include "common/termformat/termformat.h"
 
 #include "compiler/compiler-core.h"
@@ -63,6 +65,14 @@ void check_instance_to_array_call(VertexAdaptor<op_func_call> call) {
   type->class_type()->deeply_require_instance_to_array_visitor();
 }
 
+void check_json_decode_to_call(VertexAdaptor<op_func_call> call) {
+  auto klass = tinf::get_type(call)->class_type();
+  kphp_assert(klass);
+  kphp_error_return(!klass->is_polymorphic_or_has_polymorphic_member(),
+                    fmt_format("Can not decode json into class {} with json_decode_to call: it is polymorphic or has polymorphic members", klass->name));
+  klass->deeply_require_json_decode_visitor();
+}
+
 void check_estimate_memory_usage_call(VertexAdaptor<op_func_call> call) {
   auto type = tinf::get_type(call->args()[0]);
   std::unordered_set<ClassPtr> classes_inside;
@@ -229,6 +239,10 @@ void FinalCheckPass::on_start() {
   if (current_function->kphp_lib_export) {
     check_lib_exported_function(current_function);
   }
+
+  if (current_function->is_arena) {
+    check_arena_function(current_function);
+  }
 }
 
 VertexPtr FinalCheckPass::on_enter_vertex(VertexPtr vertex) {
@@ -394,10 +408,12 @@ void FinalCheckPass::check_op_func_call(VertexAdaptor<op_func_call> call) {
     auto &function_name = call->get_string();
     if (function_name == "instance_cache_fetch") {
       check_instance_cache_fetch_call(call);
-    } else if (function_name == "instance_cache_store") {
+    } else if (function_name == "instance_cache_store" || function_name == "instance_cache_store_async") {
       check_instance_cache_store_call(call);
     } else if (function_name == "instance_to_array") {
       check_instance_to_array_call(call);
+    } else if (function_name == "json_decode_to") {
+      check_json_decode_to_call(call);
     } else if (function_name == "estimate_memory_usage") {
       check_estimate_memory_usage_call(call);
     } else if (function_name == "get_global_vars_memory_stats") {
@@ -448,6 +464,53 @@ void FinalCheckPass::check_lib_exported_function(FunctionPtr function) {
   }
 }
 
+// All the script memory allocated by a @kphp-arena function is freed on its exit, so nothing may outlive the call:
+// the data comes in only through the read-only params without instances and goes out only as a primitive result,
+// and neither the function nor the functions it calls keep anything in the globals or in the runtime
+void FinalCheckPass::check_arena_function(FunctionPtr function) {
+  const std::string name = function->get_human_readable_name();
+  kphp_error(!function->modifiers.is_instance(), fmt_format("@kphp-arena function {} can't be an instance method", name));
+  kphp_error(!function->can_throw, fmt_format("@kphp-arena function {} can throw an exception:\n{}", name, function->get_throws_call_chain()));
+
+  const TypeData *ret_type = tinf::get_type(function, -1);
+  kphp_error(vk::any_of_equal(ret_type->ptype(), tp_void, tp_Null, tp_False, tp_bool, tp_int, tp_float),
+             fmt_format("@kphp-arena function {} must return a primitive type, but returns {}", name, colored_type_out(ret_type)));
+
+  for (VarPtr param : function->param_ids) {
+    const TypeData *param_type = tinf::get_type(param);
+    // the modified params are passed by value, and they are destroyed by the caller after the exit
+    const bool is_read_only = param->marked_as_const || (!function->has_variadic_param && param->is_read_only);
+    kphp_error(!param->is_reference && !param_type->has_class_type_inside() && (is_read_only || param_type->is_primitive_type()),
+               fmt_format("@kphp-arena function {} can't modify the param ${} or take it by reference or with instances inside",
+                          name, param->name));
+  }
+
+  std::unordered_set<FunctionPtr> visited{function};
+  std::vector<FunctionPtr> to_visit{function};
+  while (!to_visit.empty()) {
+    FunctionPtr f = to_visit.back();
+    to_visit.pop_back();
+    if (f->is_extern()) {
+      kphp_error(!f->keeps_script_memory,
+                 fmt_format("@kphp-arena function {} calls {}, which keeps the allocated memory till the end of the request",
+                            name, f->get_human_readable_name()));
+      continue;
+    }
+    kphp_error(!f->is_resumable, fmt_format("@kphp-arena function {} calls resumable {}", name, f->get_human_readable_name()));
+    for (VarPtr var : f->global_var_ids) {
+      kphp_error(false, fmt_format("@kphp-arena function {} uses the global ${} in {}", name, var->name, f->get_human_readable_name()));
+    }
+    for (VarPtr var : f->static_var_ids) {
+      kphp_error(false, fmt_format("@kphp-arena function {} uses the static ${} in {}", name, var->name, f->get_human_readable_name()));
+    }
+    for (FunctionPtr callee : f->dep) {
+      if (visited.insert(callee).second) {
+        to_visit.emplace_back(callee);
+      }
+    }
+  }
+}
+
 void FinalCheckPass::check_eq3_neq3(VertexPtr lhs, VertexPtr rhs, Operation op) {
   auto lhs_type = tinf::get_type(lhs);
   auto rhs_type = tinf::get_type(rhs);
@@ -33,6 +33,7 @@ public:
 private:
   void check_op_func_call(VertexAdaptor<op_func_call> call);
   void check_lib_exported_function(FunctionPtr function);
+  void check_arena_function(FunctionPtr function);
   void check_eq3_neq3(VertexPtr lhs, VertexPtr rhs, Operation op);
   void check_comparisons(VertexPtr lhs, VertexPtr rhs, Operation op);
   void raise_error_using_Unknown_type(VertexPtr v);
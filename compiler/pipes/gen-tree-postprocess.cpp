@@ -173,6 +173,16 @@ VertexPtr GenTreePostprocessPass::on_enter_vertex(VertexPtr root) {
       return process_require_lib(call);
     }
 
+    // echo json_encode(...) is replaced with echo_json_encode(...), that writes json right into the output buffer
+    if (name == "echo" && call->size() == 1) {
+      if (auto json_encode_call = call->args()[0].try_as<op_func_call>()) {
+        if (json_encode_call->get_string() == "json_encode" && json_encode_call->size() <= 2) {
+          json_encode_call->set_string("echo_json_encode");
+          return json_encode_call;
+        }
+      }
+    }
+
     if (name == "min" || name == "max") {
       auto args = call->args();
       if (args.size() == 1) {
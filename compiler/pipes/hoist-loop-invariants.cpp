@@ -0,0 +1,110 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "compiler/pipes/hoist-loop-invariants.h"
+
+#include "common/algorithms/compare.h"
+#include "common/algorithms/find.h"
+
+#include "compiler/compiler-core.h"
+#include "compiler/data/var-data.h"
+#include "compiler/inferring/public.h"
+#include "compiler/name-gen.h"
+
+VarPtr HoistLoopInvariantsPass::get_counted_var(VertexPtr v) {
+  auto call = v.try_as<op_func_call>();
+  if (!call || !call->func_id || !call->func_id->is_extern() || vk::none_of_equal(call->func_id->name, "count", "sizeof") ||
+      call->args().size() != 1) {
+    return {};
+  }
+  auto var = call->args()[0].try_as<op_var>();
+  if (!var || !var->var_id) {
+    return {};
+  }
+  VarPtr var_id = var->var_id;
+  if (vk::none_of_equal(var_id->type(), VarData::var_local_t, VarData::var_param_t) || var_id->is_reference || var_id->is_foreach_reference) {
+    return {};
+  }
+  const TypeData *type = tinf::get_type(var_id);
+  return type->ptype() == tp_array && !type->use_optional() ? var_id : VarPtr{};
+}
+
+void HoistLoopInvariantsPass::collect_counted_vars(VertexPtr v, std::map<VarPtr, VertexAdaptor<op_var>> &counted_vars) {
+  if (VarPtr var = get_counted_var(v)) {
+    counted_vars.emplace(var, VertexAdaptor<op_var>{});
+    return;
+  }
+  for (auto child : *v) {
+    collect_counted_vars(child, counted_vars);
+  }
+}
+
+// the array may be counted and its elements may be read, any other usage may change it
+bool HoistLoopInvariantsPass::is_only_read_in(VertexPtr v, VarPtr var) {
+  if (get_counted_var(v) == var) {
+    return true;
+  }
+  if (auto index = v.try_as<op_index>()) {
+    if (index->rl_type == val_r) {
+      auto array = index->array().try_as<op_var>();
+      if (array && array->var_id == var) {
+        return !index->has_key() || is_only_read_in(index->key(), var);
+      }
+    }
+  }
+  if (auto v_var = v.try_as<op_var>()) {
+    return v_var->var_id != var;
+  }
+  return vk::all_of(*v, [var](VertexPtr child) { return is_only_read_in(child, var); });
+}
+
+void HoistLoopInvariantsPass::replace_counts(VertexPtr &v, const std::map<VarPtr, VertexAdaptor<op_var>> &counted_vars) {
+  if (VarPtr var = get_counted_var(v)) {
+    auto it = counted_vars.find(var);
+    if (it != counted_vars.end() && it->second) {
+      v = it->second.clone().set_rl_type(val_r);
+    }
+    return;
+  }
+  for (auto &child : *v) {
+    replace_counts(child, counted_vars);
+  }
+}
+
+VertexPtr HoistLoopInvariantsPass::on_exit_vertex(VertexPtr vertex) {
+  if (vk::none_of_equal(vertex->type(), op_for, op_while)) {
+    return vertex;
+  }
+
+  std::map<VarPtr, VertexAdaptor<op_var>> counted_vars;
+  collect_counted_vars(vertex, counted_vars);
+
+  std::vector<VertexPtr> hoisted;
+  for (auto &counted_var : counted_vars) {
+    if (!is_only_read_in(vertex, counted_var.first)) {
+      continue;
+    }
+    auto array = VertexAdaptor<op_var>::create().set_location(vertex);
+    array->str_val = counted_var.first->name;
+    array->var_id = counted_var.first;
+    auto count_call = VertexAdaptor<op_func_call>::create(array.set_rl_type(val_r)).set_location(vertex);
+    count_call->str_val = "count";
+    count_call->func_id = G->get_function(count_call->str_val);
+
+    auto count_var = VertexAdaptor<op_var>::create().set_location(vertex);
+    count_var->str_val = gen_unique_name("loop_count");
+    count_var->var_id = G->create_local_var(current_function, count_var->str_val, VarData::var_local_t);
+    count_var->var_id->tinf_node.copy_type_from(tinf::get_type(count_call->func_id, -1));
+    counted_var.second = count_var;
+
+    hoisted.emplace_back(VertexAdaptor<op_set>::create(count_var.clone().set_rl_type(val_l), count_call.set_rl_type(val_r)).set_rl_type(val_none));
+  }
+  if (hoisted.empty()) {
+    return vertex;
+  }
+
+  replace_counts(vertex, counted_vars);
+  hoisted.emplace_back(vertex);
+  return VertexAdaptor<op_seq>::create(hoisted).set_location(vertex).set_rl_type(val_none);
+}
@@ -0,0 +1,29 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <map>
+
+#include "compiler/function-pass.h"
+
+// Moves count($a) out of the for and while loops, which only read the local array $a:
+// for ($i = 0; $i < count($a); ++$i) is turned into $loop_count = count($a); for ($i = 0; $i < $loop_count; ++$i)
+class HoistLoopInvariantsPass final : public FunctionPassBase {
+  static VarPtr get_counted_var(VertexPtr v);
+  static void collect_counted_vars(VertexPtr v, std::map<VarPtr, VertexAdaptor<op_var>> &counted_vars);
+  static bool is_only_read_in(VertexPtr v, VarPtr var);
+  static void replace_counts(VertexPtr &v, const std::map<VarPtr, VertexAdaptor<op_var>> &counted_vars);
+
+public:
+  string get_description() override {
+    return "Hoist loop invariants";
+  }
+
+  bool check_function(FunctionPtr function) const override {
+    return !function->is_extern();
+  }
+
+  VertexPtr on_exit_vertex(VertexPtr vertex) override;
+};
@@ -0,0 +1,122 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "compiler/pipes/move-last-reads.h"
+
+#include "common/algorithms/find.h"
+
+#include "compiler/data/var-data.h"
+#include "compiler/inferring/public.h"
+
+// the builtins reusing the array passed as an rvalue instead of building a new one, with the index of that argument
+static int get_consumed_arg_of_extern(FunctionPtr func) {
+  static const std::unordered_map<std::string, int> consumed_args = {
+    {"array_filter", 0},
+    {"array_filter_by_key", 0},
+    {"array_map", 1},
+    {"array_merge", 0},
+  };
+  auto found = consumed_args.find(func->name);
+  return found == consumed_args.end() ? -1 : found->second;
+}
+
+// the nested statements are handled separately, the other parts of the statement are evaluated in an unknown order
+void MoveLastReadsPass::count_statement_vars(VertexPtr v) {
+  if (auto var = v.try_as<op_var>()) {
+    statement_vars_[var->var_id]++;
+  }
+  for (auto child : *v) {
+    if (child->type() != op_seq) {
+      count_statement_vars(child);
+    }
+  }
+}
+
+bool MoveLastReadsPass::is_movable(VertexPtr v) const {
+  auto var = v.try_as<op_var>();
+  if (!var || !var->is_last_read || !var->var_id) {
+    return false;
+  }
+  VarPtr var_id = var->var_id;
+  if (var_id->is_reference || var_id->is_foreach_reference || statement_vars_.at(var_id) != 1) {
+    return false;
+  }
+  // read only params are passed by a const reference
+  if (!(var_id->type() == VarData::var_local_t || (var_id->type() == VarData::var_param_t && !var_id->is_read_only))) {
+    return false;
+  }
+  return vk::any_of_equal(tinf::get_type(var)->ptype(), tp_string, tp_array, tp_mixed, tp_Class);
+}
+
+void MoveLastReadsPass::move_last_reads(VertexPtr v) {
+  auto wrap = [this](VertexPtr &child) {
+    if (is_movable(child)) {
+      auto move = VertexAdaptor<op_move>::create(child).set_rl_type(val_r);
+      move->tinf_node.set_type(tinf::get_type(child));
+      child = move;
+    }
+  };
+
+  switch (v->type()) {
+    case op_set:
+      wrap(v.as<op_set>()->rhs());
+      break;
+    case op_set_value:
+      wrap(v.as<op_set_value>()->value());
+      break;
+    case op_push_back:
+      wrap(v.as<op_push_back>()->value());
+      break;
+    case op_return:
+      if (v.as<op_return>()->has_expr()) {
+        wrap(v.as<op_return>()->expr());
+      }
+      break;
+    case op_func_call: {
+      auto call = v.as<op_func_call>();
+      FunctionPtr func = call->func_id;
+      if (func && !func->is_extern()) {
+        auto params = func->get_params();
+        auto args = call->args();
+        for (int i = 0; i < args.size() && i < params.size(); ++i) {
+          if (!params[i].as<op_func_param>()->var()->ref_flag) {
+            wrap(args[i]);
+          }
+        }
+      } else if (func) {
+        int consumed_arg = get_consumed_arg_of_extern(func);
+        if (consumed_arg >= 0 && consumed_arg < call->args().size()) {
+          wrap(call->args()[consumed_arg]);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  for (auto child : *v) {
+    if (child->type() != op_seq) {
+      move_last_reads(child);
+    }
+  }
+}
+
+VertexPtr MoveLastReadsPass::on_enter_vertex(VertexPtr vertex) {
+  if (vertex->type() == op_seq) {
+    for (auto statement : *vertex) {
+      statement_vars_.clear();
+      count_statement_vars(statement);
+      // in '$a = f($a)' the variable is written only after the call returns, so its read may still be moved
+      if (auto set = statement.try_as<op_set>()) {
+        auto lhs = set->lhs().try_as<op_var>();
+        if (lhs && set->rhs()->type() != op_var) {
+          statement_vars_[lhs->var_id]--;
+        }
+      }
+      move_last_reads(statement);
+    }
+  }
+  return vertex;
+}
@@ -0,0 +1,31 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <unordered_map>
+
+#include "compiler/function-pass.h"
+
+// Wraps the last reads of the local strings, arrays, mixed and instances found by the CFG into op_move,
+// where their values are copied anyway: assignments, returns, array elements and arguments of the php functions.
+// Without the extra reference the copy-on-write of an array moved to a function doesn't copy it
+class MoveLastReadsPass final : public FunctionPassBase {
+  std::unordered_map<VarPtr, int> statement_vars_;
+
+  void count_statement_vars(VertexPtr v);
+  void move_last_reads(VertexPtr v);
+  bool is_movable(VertexPtr v) const;
+
+public:
+  string get_description() override {
+    return "Move last reads of variables";
+  }
+
+  bool check_function(FunctionPtr function) const override {
+    return !function->is_extern() && !function->is_resumable;
+  }
+
+  VertexPtr on_enter_vertex(VertexPtr vertex) override;
+};
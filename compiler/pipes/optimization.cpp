@@ -128,6 +128,64 @@ VertexPtr OptimizationPass::optimize_string_building(VertexPtr root) {
 
   return new_root;
 }
+// sprintf() with a constant format of %s, %d and %% only is turned into a string building of the converted arguments,
+// so the format isn't parsed and the arguments aren't packed into an array of mixed at runtime
+VertexPtr OptimizationPass::optimize_sprintf(VertexAdaptor<op_func_call> call) {
+  if (!call->func_id || !call->func_id->is_extern() || call->func_id->name != "sprintf" || call->args().size() != 2) {
+    return call;
+  }
+  const std::string *format = GenTree::get_constexpr_string(call->args()[0]);
+  auto format_args = call->args()[1].try_as<op_array>();
+  if (!format || !format_args) {
+    return call;
+  }
+
+  std::vector<VertexPtr> parts;
+  std::string literal;
+  auto flush_literal = [&] {
+    if (!literal.empty()) {
+      auto literal_v = VertexAdaptor<op_string>::create().set_location(call).set_rl_type(val_r);
+      literal_v->str_val = std::move(literal);
+      literal_v->tinf_node.set_type(TypeData::get_type(tp_string));
+      parts.emplace_back(literal_v);
+      literal.clear();
+    }
+  };
+  size_t arg_i = 0;
+  for (size_t i = 0; i < format->size(); ++i) {
+    if ((*format)[i] != '%') {
+      literal += (*format)[i];
+      continue;
+    }
+    const char spec = ++i < format->size() ? (*format)[i] : '\0';
+    if (spec == '%') {
+      literal += '%';
+      continue;
+    }
+    if (vk::none_of_equal(spec, 's', 'd') || arg_i == format_args->size() || format_args->args()[arg_i]->type() == op_double_arrow) {
+      return call;
+    }
+    flush_literal();
+    VertexPtr arg = format_args->args()[arg_i++];
+    if (spec == 's') {
+      arg = VertexAdaptor<op_conv_string>::create(arg).set_location(call).set_rl_type(val_r);
+      arg->tinf_node.set_type(TypeData::get_type(tp_string));
+    } else {
+      arg = VertexAdaptor<op_conv_int>::create(arg).set_location(call).set_rl_type(val_r);
+      arg->tinf_node.set_type(TypeData::get_type(tp_int));
+    }
+    parts.emplace_back(arg);
+  }
+  flush_literal();
+  if (arg_i != format_args->size() || parts.empty()) {
+    return call;
+  }
+
+  auto string_build = VertexAdaptor<op_string_build>::create(parts).set_location(call).set_rl_type(call->rl_type);
+  string_build->tinf_node.set_type(TypeData::get_type(tp_string));
+  return string_build;
+}
+
 VertexPtr OptimizationPass::optimize_postfix_inc(VertexPtr root) {
   if (root->rl_type == val_none) {
     auto new_root = VertexAdaptor<op_prefix_inc>::create(root.as<op_postfix_inc>()->expr());
@@ -251,6 +309,8 @@ VertexPtr OptimizationPass::on_enter_vertex(VertexPtr root) {
     root = optimize_postfix_dec(root);
   } else if (root->type() == op_index) {
     root = optimize_index(root.as<op_index>());
+  } else if (auto call = root.try_as<op_func_call>()) {
+    root = optimize_sprintf(call);
   } else if (auto param = root.try_as<op_foreach_param>()) {
     if (!param->x()->ref_flag) {
       auto temp_var = root.as<op_foreach_param>()->temp_var().as<op_var>();
@@ -15,6 +15,7 @@ private:
   VertexPtr optimize_postfix_inc(VertexPtr root);
   VertexPtr optimize_postfix_dec(VertexPtr root);
   VertexPtr optimize_index(VertexAdaptor<op_index> index);
+  VertexPtr optimize_sprintf(VertexAdaptor<op_func_call> call);
   template<Operation FromOp, Operation ToOp>
   VertexPtr fix_int_const(VertexPtr from, vk::string_view from_func);
   VertexPtr fix_int_const(VertexPtr root);
@@ -208,6 +208,8 @@ private:
             f_->cpp_variadic_call = true;
           } else if (token == "tl_common_h_dep") {
             f_->tl_common_h_dep = true;
+          } else if (token == "keeps_script_memory") {
+            f_->keeps_script_memory = true;
           } else {
             kphp_error(0, fmt_format("Unknown @kphp-extern-func-info {}", token));
           }
@@ -276,6 +278,12 @@ private:
         break;
       }
 
+      case php_doc_tag::kphp_arena: {
+        kphp_error(!f_->is_extern(), "@kphp-arena is not supported for built-in functions");
+        f_->is_arena = true;
+        break;
+      }
+
       default:
         break;
     }
@@ -29,9 +29,9 @@ private:
   using InputType = typename PipeType::InputType;
   InputType input;
   PipeType *pipe_ptr;
-  static ProfilerRaw& get_task_profiler() {
+  static CachedProfiler &get_task_profiler() {
     static CachedProfiler cache{demangle(typeid(typename PipeType::PipeFunctionType).name())};
-    return *cache;
+    return cache;
   }
 
 public:
@@ -42,7 +42,8 @@ public:
 
   void execute() override {
     if (NeedProfiler<typename PipeType::PipeFunctionType>::value) {
-      AutoProfiler prof{get_task_profiler()};
+      AutoProfiler prof{*get_task_profiler()};
+      TraceProfiler trace{get_task_profiler().name(), {}};
       pipe_ptr->process_input(std::move(input));
     } else {
       pipe_ptr->process_input(std::move(input));
@@ -4,9 +4,14 @@
 
 #include "compiler/scheduler/scheduler.h"
 
+#include <atomic>
+#include <chrono>
 #include <vector>
 
+#include "common/dl-utils-lite.h"
+
 #include "compiler/scheduler/task.h"
+#include "compiler/threading/profiler.h"
 #include "compiler/threading/thread-id.h"
 #include "compiler/threading/tls.h"
 
@@ -19,6 +24,9 @@ public:
 
   Node *node;
   bool run_flag;
+
+  // the time spent executing the tasks, read by the main thread at the end of each stage
+  std::atomic<int64_t> working_time_ns{0};
 };
 
 
@@ -66,6 +74,15 @@ void Scheduler::execute() {
     pthread_create(&threads[i].pthread_id, nullptr, ::scheduler_thread_execute, &threads[i]);
   }
 
+  auto threads_working_time = [&threads] {
+    int64_t working_time_ns = 0;
+    for (const auto &thread : threads) {
+      working_time_ns += thread.working_time_ns.load(std::memory_order_relaxed);
+    }
+    return std::chrono::nanoseconds{working_time_ns};
+  };
+  auto stage_start = std::chrono::steady_clock::now();
+  auto stage_start_working_time = threads_working_time();
   while (true) {
     if (tasks_before_sync_node > 0) {
       usleep(250);
@@ -74,8 +91,20 @@ void Scheduler::execute() {
     if (sync_nodes.empty()) {
       break;
     }
+    const auto on_finish_start = std::chrono::steady_clock::now();
     sync_nodes.front()->on_finish();
     sync_nodes.pop();
+
+    // on_finish runs on the main thread only, it is a serial part of the stage
+    const auto now = std::chrono::steady_clock::now();
+    const auto working_time = threads_working_time();
+    mem_info_t mem_info;
+    get_mem_stats(getpid(), &mem_info);
+    profiler_add_scheduler_stage({stage_start.time_since_epoch(), now - stage_start,
+                                  working_time - stage_start_working_time + (now - on_finish_start), threads_count,
+                                  mem_info.rss * 1024, mem_info.rss_peak * 1024});
+    stage_start = now;
+    stage_start_working_time = working_time;
   }
 
   for (int i = 1; i <= threads_count; i++) {
@@ -94,13 +123,16 @@ void Scheduler::set_threads_count(int new_threads_count) {
   threads_count = new_threads_count;
 }
 
-bool Scheduler::thread_process_node(Node *node) {
+bool Scheduler::thread_process_node(ThreadContext *tls, Node *node) {
   Task *task = node->get_task();
   if (task == nullptr) {
     return false;
   }
+  const auto start = std::chrono::steady_clock::now();
   task->execute();
   delete task;
+  const std::chrono::nanoseconds working_time = std::chrono::steady_clock::now() - start;
+  tls->working_time_ns.fetch_add(working_time.count(), std::memory_order_relaxed);
   __sync_fetch_and_sub(&tasks_before_sync_node, 1);
   return true;
 }
@@ -108,9 +140,9 @@ bool Scheduler::thread_process_node(Node *node) {
 void Scheduler::thread_execute(ThreadContext *tls) {
   set_thread_id(tls->thread_id);
 
-  auto process_node = [this](Node *node) {
+  auto process_node = [this, tls](Node *node) {
     bool at_least_one_task_executed = false;
-    while (thread_process_node(node)) {
+    while (thread_process_node(tls, node)) {
       at_least_one_task_executed = true;
     }
     return at_least_one_task_executed;
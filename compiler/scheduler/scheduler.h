@@ -20,7 +20,7 @@ private:
   int threads_count;
   TaskPull *task_pull;
 
-  bool thread_process_node(Node *node);
+  bool thread_process_node(ThreadContext *tls, Node *node);
   void thread_execute(ThreadContext *tls);
   friend void *scheduler_thread_execute(void *arg);
 
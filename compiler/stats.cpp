@@ -4,9 +4,31 @@
 
 #include "compiler/stats.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "common/dl-utils-lite.h"
 
 #include "compiler/data/function-data.h"
+#include "compiler/vertex.h"
+
+namespace {
+
+std::uint64_t count_tinf_recalcs(VertexPtr root) {
+  std::uint64_t recalcs = std::max(root->tinf_node.get_recalc_cnt(), 0);
+  for (auto child : *root) {
+    recalcs += count_tinf_recalcs(child);
+  }
+  return recalcs;
+}
+
+void sort_by_recalcs(std::vector<std::pair<std::uint64_t, std::string>> &functions, size_t limit) {
+  limit = std::min(limit, functions.size());
+  std::partial_sort(functions.begin(), functions.begin() + limit, functions.end(), std::greater<>{});
+  functions.resize(limit);
+}
+
+} // namespace
 
 void Stats::on_var_inserting(VarData::Type type) {
   switch (type) {
@@ -47,6 +69,20 @@ void Stats::on_function_processed(FunctionPtr function) {
   if (function->is_inline) {
     ++total_inline_functions_;
   }
+
+  std::uint64_t recalcs = count_tinf_recalcs(function->root);
+  for (const auto *vars : {&function->param_ids, &function->local_var_ids}) {
+    for (VarPtr var : *vars) {
+      recalcs += std::max(var->tinf_node.get_recalc_cnt(), 0);
+    }
+  }
+  tinf_node_recalcs_ += recalcs;
+
+  std::lock_guard<std::mutex> lock{top_tinf_recalc_functions_mutex_};
+  top_tinf_recalc_functions_.emplace_back(recalcs, function->get_human_readable_name());
+  if (top_tinf_recalc_functions_.size() >= 2 * TOP_TINF_RECALC_FUNCTIONS) {
+    sort_by_recalcs(top_tinf_recalc_functions_, TOP_TINF_RECALC_FUNCTIONS);
+  }
 }
 
 void Stats::update_memory_stats() {
@@ -81,6 +117,17 @@ void Stats::write_to(std::ostream &out, bool with_indent) const {
   out << indent << "functions.total_throwing: " << total_throwing_functions_ << std::endl;
   out << indent << "functions.total_resumable: " << total_resumable_functions_ << std::endl;
   out << block_sep;
+  out << indent << "tinf.node_recalcs: " << tinf_node_recalcs_ << std::endl;
+  {
+    std::lock_guard<std::mutex> lock{top_tinf_recalc_functions_mutex_};
+    auto top_functions = top_tinf_recalc_functions_;
+    sort_by_recalcs(top_functions, TOP_TINF_RECALC_FUNCTIONS);
+    for (auto &function : top_functions) {
+      std::replace_if(function.second.begin(), function.second.end(), [](char c) { return !std::isalnum(c); }, '_');
+      out << indent << "tinf.node_recalcs." << function.second << ": " << function.first << std::endl;
+    }
+  }
+  out << block_sep;
   out << indent << "memory.rss: " << memory_rss_ * 1024 << std::endl;
   out << indent << "memory.rss_peak: " << memory_rss_peak_ * 1024 << std::endl;
   out << block_sep;
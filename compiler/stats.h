@@ -5,7 +5,10 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>
 #include <ostream>
+#include <string>
+#include <vector>
 
 #include "compiler/data/var-data.h"
 #include "compiler/threading/profiler.h"
@@ -47,6 +50,12 @@ private:
 
   std::atomic<std::uint64_t> memory_rss_{0};
   std::atomic<std::uint64_t> memory_rss_peak_{0};
+
+  // the type inferring is a fixed point iteration, the functions with the most node recalculations are the slowest to infer
+  static constexpr size_t TOP_TINF_RECALC_FUNCTIONS = 20;
+  std::atomic<std::uint64_t> tinf_node_recalcs_{0u};
+  mutable std::mutex top_tinf_recalc_functions_mutex_;
+  std::vector<std::pair<std::uint64_t, std::string>> top_tinf_recalc_functions_;
 };
 
 
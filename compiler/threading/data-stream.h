@@ -3,6 +3,8 @@
 // Distributed under the GPL v3 License, see LICENSE.notice.txt
 
 #pragma once
+#include <array>
+#include <atomic>
 #include <forward_list>
 #include <mutex>
 #include <vector>
@@ -11,6 +13,8 @@
 
 #include "compiler/scheduler/scheduler-base.h"
 #include "compiler/stage.h"
+#include "compiler/threading/thread-id.h"
+#include "compiler/threading/tls.h"
 
 template<class DataT>
 class DataStream {
@@ -27,11 +31,24 @@ public:
   }
 
   bool get(DataType &result) {
-    std::lock_guard<std::mutex> lock{mutex_};
-    if (!queue_.empty()) {
-      result = std::move(queue_.front());
-      queue_.pop_front();
-      return true;
+    if (size_.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+    // the own queue of the thread first, then the work is stolen from the queues of the other threads
+    const int thread_id = get_thread_id();
+    for (int i = 0; i < static_cast<int>(shards_.size()); ++i) {
+      Shard &shard = shards_[(thread_id + i) % shards_.size()];
+      if (shard.size.load(std::memory_order_relaxed) == 0) {
+        continue;
+      }
+      std::lock_guard<std::mutex> lock{shard.mutex};
+      if (!shard.queue.empty()) {
+        result = std::move(shard.queue.front());
+        shard.queue.pop_front();
+        shard.size.fetch_sub(1, std::memory_order_relaxed);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
     }
     return false;
   }
@@ -40,13 +57,21 @@ public:
     if (!is_sink_mode_) {
       __sync_fetch_and_add(&tasks_before_sync_node, 1);
     }
-    std::lock_guard<std::mutex> lock{mutex_};
-    queue_.push_front(std::move(input));
+    Shard &shard = shards_[get_thread_id()];
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    shard.queue.push_front(std::move(input));
+    shard.size.fetch_add(1, std::memory_order_relaxed);
+    size_.fetch_add(1, std::memory_order_release);
   }
 
   std::forward_list<DataType> flush() {
-    std::lock_guard<std::mutex> lock{mutex_};
-    return std::move(queue_);
+    std::forward_list<DataType> result;
+    for (Shard &shard : shards_) {
+      std::lock_guard<std::mutex> lock{shard.mutex};
+      size_.fetch_sub(shard.size.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+      result.splice_after(result.before_begin(), shard.queue);
+    }
+    return result;
   }
 
   std::vector<DataType> flush_as_vector() {
@@ -55,8 +80,16 @@ public:
   }
 
 private:
-  std::mutex mutex_;
-  std::forward_list<DataT> queue_;
+  // a queue per thread: the producing thread pushes to its own queue, so the threads rarely contend for a lock,
+  // while an idle thread takes the work from the queues of the others
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::forward_list<DataT> queue;
+    std::atomic<int> size{0};
+  };
+
+  std::array<Shard, MAX_THREADS_COUNT + 1> shards_;
+  std::atomic<int> size_{0};
   const bool is_sink_mode_;
 };
 
@@ -4,85 +4,125 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <vector>
 
 #include "compiler/threading/locks.h"
 
+// A lock-free hash trie by the 64-bit hash: the lower bits of the hash select a slot of the root,
+// the next ones select a slot in the nested levels, which are created by CAS when two hashes meet in a slot.
+// The nodes are never moved, so the pointers returned by at() stay valid, and the table grows without a limit
 template<class T>
 class TSHashTable {
-  static const int N = 1000000;
 public:
-  struct HTNode : Lockable {
+  // the nodes are padded to a cache line, as the threads lock and fill the nodes just inserted next to each other
+  struct alignas(64) HTNode : Lockable {
     unsigned long long hash;
     T data;
 
-    HTNode() :
-      hash(0),
+    explicit HTNode(unsigned long long hash = 0) :
+      hash(hash),
       data() {
     }
   };
 
 private:
-  HTNode *nodes;
-  int used_size;
-  int nodes_size;
+  static constexpr int ROOT_BITS = 16;
+  static constexpr int LEVEL_BITS = 4;
+  // a slot holds either nullptr, or a HTNode, or a Level marked by the lowest bit
+  static constexpr uintptr_t LEVEL_TAG = 1;
+
+  struct Level {
+    std::atomic<uintptr_t> slots[1 << LEVEL_BITS]{};
+  };
+
+  std::atomic<uintptr_t> *root;
+
+  template<class F>
+  static void for_each_node(uintptr_t slot, const F &callback) {
+    if (slot & LEVEL_TAG) {
+      for (const auto &nested : reinterpret_cast<Level *>(slot & ~LEVEL_TAG)->slots) {
+        for_each_node(nested.load(std::memory_order_acquire), callback);
+      }
+    } else if (slot != 0) {
+      callback(*reinterpret_cast<HTNode *>(slot));
+    }
+  }
+
+  template<class F>
+  void for_each_node(const F &callback) {
+    for (int i = 0; i < (1 << ROOT_BITS); i++) {
+      for_each_node(root[i].load(std::memory_order_acquire), callback);
+    }
+  }
+
 public:
   TSHashTable() :
-    nodes(new HTNode[N]),
-    used_size(0),
-    nodes_size(N) {
+    root(new std::atomic<uintptr_t>[1 << ROOT_BITS]{}) {
   }
 
   HTNode *at(unsigned long long hash) {
-    int i = (unsigned)hash % (unsigned)nodes_size;
+    std::atomic<uintptr_t> *slot = &root[hash & ((1 << ROOT_BITS) - 1)];
+    int shift = ROOT_BITS;
+    HTNode *new_node = nullptr;
     while (true) {
-      while (nodes[i].hash != 0 && nodes[i].hash != hash) {
-        i++;
-        if (i == nodes_size) {
-          i = 0;
+      uintptr_t cur = slot->load(std::memory_order_acquire);
+      if (cur == 0) {
+        if (new_node == nullptr) {
+          new_node = new HTNode(hash);
+        }
+        if (slot->compare_exchange_strong(cur, reinterpret_cast<uintptr_t>(new_node), std::memory_order_acq_rel)) {
+          return new_node;
         }
+        continue;
       }
-      if (nodes[i].hash == 0 && !__sync_bool_compare_and_swap(&nodes[i].hash, 0, hash)) {
-        int id = __sync_fetch_and_add(&used_size, 1);
-        assert(id * 2 < N);
+      if (cur & LEVEL_TAG) {
+        assert(shift < 64);
+        slot = &reinterpret_cast<Level *>(cur & ~LEVEL_TAG)->slots[(hash >> shift) & ((1 << LEVEL_BITS) - 1)];
+        shift += LEVEL_BITS;
         continue;
       }
-      break;
+      auto *node = reinterpret_cast<HTNode *>(cur);
+      if (node->hash == hash) {
+        delete new_node;
+        return node;
+      }
+      // another hash takes the slot: move its node one level down and retry there
+      auto *level = new Level();
+      level->slots[(node->hash >> shift) & ((1 << LEVEL_BITS) - 1)].store(cur, std::memory_order_relaxed);
+      if (!slot->compare_exchange_strong(cur, reinterpret_cast<uintptr_t>(level) | LEVEL_TAG, std::memory_order_acq_rel)) {
+        delete level;
+      }
     }
-    return &nodes[i];
   }
 
   const T *find(unsigned long long hash) {
-    int i = (unsigned)hash % (unsigned)nodes_size;
-    while (nodes[i].hash != 0 && nodes[i].hash != hash) {
-      i++;
-      if (i == nodes_size) {
-        i = 0;
-      }
+    uintptr_t cur = root[hash & ((1 << ROOT_BITS) - 1)].load(std::memory_order_acquire);
+    for (int shift = ROOT_BITS; cur & LEVEL_TAG; shift += LEVEL_BITS) {
+      cur = reinterpret_cast<Level *>(cur & ~LEVEL_TAG)->slots[(hash >> shift) & ((1 << LEVEL_BITS) - 1)].load(std::memory_order_acquire);
     }
-
-    return nodes[i].hash == hash ? &nodes[i].data : nullptr;
+    auto *node = reinterpret_cast<HTNode *>(cur);
+    return node != nullptr && node->hash == hash ? &node->data : nullptr;
   }
 
   std::vector<T> get_all() {
     std::vector<T> res;
-    for (int i = 0; i < N; i++) {
-      if (nodes[i].hash != 0) {
-        res.push_back(nodes[i].data);
-      }
-    }
+    for_each_node([&res](HTNode &node) {
+      res.push_back(node.data);
+    });
     return res;
   }
 
   template<class CondF>
   std::vector<T> get_all_if(const CondF &callbackF) {
     std::vector<T> res;
-    for (int i = 0; i < N; i++) {
-      if (nodes[i].hash != 0 && callbackF(nodes[i].data)) {
-        res.push_back(nodes[i].data);
+    for_each_node([&res, &callbackF](HTNode &node) {
+      if (callbackF(node.data)) {
+        res.push_back(node.data);
       }
-    }
+    });
     return res;
   }
 };
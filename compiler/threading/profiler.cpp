@@ -6,11 +6,15 @@
 
 #include <algorithm>
 #include <cxxabi.h>
+#include <map>
+#include <time.h>
 #include <vector>
 
 #include "common/termformat/termformat.h"
 #include "common/wrappers/fmt_format.h"
 
+#include "compiler/threading/thread-id.h"
+
 static TLS<std::unordered_map<std::string, ProfilerRaw>> profiler;
 
 std::unordered_map<std::string, ProfilerRaw> collect_profiler_stats() {
@@ -94,6 +98,222 @@ void profiler_print_all(const std::unordered_map<std::string, ProfilerRaw> &coll
   fmt_fprintf(stderr, "-{0:-^{1}}-\n", "", name_width + table_fixed_size);
 }
 
+// the stages are finished by the main thread only
+static std::vector<SchedulerStageStats> scheduler_stages;
+
+void profiler_add_scheduler_stage(const SchedulerStageStats &stage) {
+  scheduler_stages.emplace_back(stage);
+}
+
+namespace {
+
+struct TraceEvent {
+  const std::string *category;
+  std::string name;
+  std::chrono::nanoseconds start;
+  std::chrono::nanoseconds duration;
+  std::chrono::nanoseconds cpu_time;
+  size_t allocated;
+};
+
+// it is set before the scheduler threads are started
+bool trace_enabled = false;
+TLS<std::vector<TraceEvent>> trace_events;
+// the make jobs are started and finished by the main thread only
+std::vector<TraceEvent> make_job_events;
+const std::string make_job_category{"make"};
+
+std::chrono::nanoseconds thread_cpu_time() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+}
+
+std::string json_escape(const std::string &s) {
+  std::string res;
+  res.reserve(s.size());
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      res += '\\';
+      res += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      res += fmt_format("\\u{:04x}", static_cast<int>(c));
+    } else {
+      res += c;
+    }
+  }
+  return res;
+}
+
+int64_t to_us(std::chrono::nanoseconds t) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(t).count();
+}
+
+} // namespace
+
+void profiler_enable_trace() {
+  trace_enabled = true;
+}
+
+bool profiler_trace_enabled() {
+  return trace_enabled;
+}
+
+TraceProfiler::TraceProfiler(const std::string &category, const std::string &name) {
+  if (!trace_enabled) {
+    return;
+  }
+  category_ = &category;
+  name_ = name;
+  cpu_start_ = thread_cpu_time();
+  allocated_start_ = get_thread_memory_total_allocated();
+  start_ = std::chrono::steady_clock::now().time_since_epoch();
+}
+
+TraceProfiler::~TraceProfiler() {
+  if (category_ == nullptr) {
+    return;
+  }
+  const auto duration = std::chrono::steady_clock::now().time_since_epoch() - start_;
+  trace_events->push_back(TraceEvent{category_, std::move(name_), start_, duration, thread_cpu_time() - cpu_start_,
+                                     get_thread_memory_total_allocated() - allocated_start_});
+}
+
+void profiler_add_make_job_trace(const std::string &name, std::chrono::nanoseconds start, std::chrono::nanoseconds duration) {
+  if (trace_enabled) {
+    make_job_events.push_back(TraceEvent{&make_job_category, name, start, duration, std::chrono::nanoseconds{0}, 0});
+  }
+}
+
+// pid 1 holds the scheduler stages, pid 2 the compiler threads and pid 3 the make jobs;
+// the pipes totals and the longest functions of each pass are written next to the events
+void profiler_write_trace(std::ostream &out, const std::unordered_map<std::string, ProfilerRaw> &collected) {
+  std::chrono::nanoseconds trace_start = std::chrono::nanoseconds::max();
+  for (const auto &stage : scheduler_stages) {
+    trace_start = std::min(trace_start, stage.start);
+  }
+  for (int i = 0; i <= MAX_THREADS_COUNT; i++) {
+    for (const auto &event : trace_events.get(i)) {
+      trace_start = std::min(trace_start, event.start);
+    }
+  }
+  for (const auto &event : make_job_events) {
+    trace_start = std::min(trace_start, event.start);
+  }
+
+  const char *sep = "\n";
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  out << sep << R"({"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "stages"}})";
+  sep = ",\n";
+  out << sep << R"({"name": "process_name", "ph": "M", "pid": 2, "args": {"name": "compiler threads"}})";
+  out << sep << R"({"name": "process_name", "ph": "M", "pid": 3, "args": {"name": "make"}})";
+
+  for (size_t i = 0; i < scheduler_stages.size(); ++i) {
+    const auto &stage = scheduler_stages[i];
+    out << sep << fmt_format(R"({{"name": "stage {}", "ph": "X", "pid": 1, "tid": 0, "ts": {}, "dur": {}, )"
+                             R"("args": {{"working_time_us": {}, "threads": {}, "rss": {}, "rss_peak": {}}}}})",
+                             i + 1, to_us(stage.start - trace_start), to_us(stage.duration), to_us(stage.threads_working_time),
+                             stage.threads_count, stage.memory_rss, stage.memory_rss_peak);
+    out << sep << fmt_format(R"({{"name": "memory", "ph": "C", "pid": 1, "ts": {}, "args": {{"rss": {}, "rss_peak": {}}}}})",
+                             to_us(stage.start + stage.duration - trace_start), stage.memory_rss, stage.memory_rss_peak);
+  }
+
+  // the longest functions of each pass, the categories are compared by the pointers
+  constexpr size_t longest_functions_count = 10;
+  std::map<const std::string *, std::vector<const TraceEvent *>> longest;
+  for (int i = 0; i <= MAX_THREADS_COUNT; i++) {
+    for (const auto &event : trace_events.get(i)) {
+      out << sep << fmt_format(R"({{"name": "{}", "cat": "{}", "ph": "X", "pid": 2, "tid": {}, "ts": {}, "dur": {}, )"
+                               R"("args": {{"cpu_us": {}, "allocated": {}}}}})",
+                               json_escape(event.name.empty() ? *event.category : event.name), json_escape(*event.category), i, to_us(event.start - trace_start),
+                               to_us(event.duration), to_us(event.cpu_time), event.allocated);
+      if (!event.name.empty()) {
+        longest[event.category].emplace_back(&event);
+      }
+    }
+  }
+
+  // the jobs are laid out to the lanes greedily, so that the lanes show how many jobs ran at once
+  std::vector<const TraceEvent *> jobs;
+  for (const auto &event : make_job_events) {
+    jobs.emplace_back(&event);
+  }
+  std::sort(jobs.begin(), jobs.end(), [](const TraceEvent *a, const TraceEvent *b) { return a->start < b->start; });
+  std::vector<std::chrono::nanoseconds> lanes_end;
+  for (const TraceEvent *job : jobs) {
+    auto lane = std::find_if(lanes_end.begin(), lanes_end.end(), [job](std::chrono::nanoseconds end) { return end <= job->start; });
+    if (lane == lanes_end.end()) {
+      lane = lanes_end.insert(lane, std::chrono::nanoseconds{0});
+    }
+    *lane = job->start + job->duration;
+    out << sep << fmt_format(R"({{"name": "{}", "cat": "{}", "ph": "X", "pid": 3, "tid": {}, "ts": {}, "dur": {}}})",
+                             json_escape(job->name), make_job_category, lane - lanes_end.begin(),
+                             to_us(job->start - trace_start), to_us(job->duration));
+  }
+  out << "\n],\n";
+
+  std::vector<std::pair<std::string, ProfilerRaw>> all{collected.begin(), collected.end()};
+  std::sort(all.begin(), all.end(), [](const auto &a, const auto &b) {
+    return a.second.print_id < b.second.print_id;
+  });
+  out << "\"pipes\": [";
+  sep = "\n";
+  for (const auto &prof : all) {
+    out << sep << fmt_format(R"({{"name": "{}", "calls": {}, "working_time_us": {}, "duration_us": {}, "memory": {}, "allocated": {}}})",
+                             json_escape(prof.first), prof.second.get_calls(), to_us(prof.second.get_working_time()),
+                             to_us(prof.second.get_duration()), prof.second.get_memory_usage(), prof.second.get_memory_total_allocated());
+    sep = ",\n";
+  }
+  out << "\n],\n";
+
+  out << "\"longest_functions\": {";
+  sep = "\n";
+  for (auto &pass : longest) {
+    auto &events = pass.second;
+    const size_t count = std::min(events.size(), longest_functions_count);
+    std::partial_sort(events.begin(), events.begin() + count, events.end(),
+                      [](const TraceEvent *a, const TraceEvent *b) { return a->duration > b->duration; });
+    out << sep << "\"" << json_escape(*pass.first) << "\": [";
+    for (size_t i = 0; i < count; ++i) {
+      out << (i ? ", " : "") << fmt_format(R"({{"function": "{}", "wall_us": {}, "cpu_us": {}, "allocated": {}}})",
+                                           json_escape(events[i]->name), to_us(events[i]->duration),
+                                           to_us(events[i]->cpu_time), events[i]->allocated);
+    }
+    out << "]";
+    sep = ",\n";
+  }
+  out << "\n}\n}\n";
+}
+
+void profiler_print_scheduler_stages() {
+  if (scheduler_stages.empty()) {
+    return;
+  }
+  // Stage (7) | Start (14) | Duration (14) | Working time (14) | Utilisation (13)
+  constexpr size_t table_size = 7 + 1 + 14 + 1 + 14 + 1 + 14 + 1 + 13;
+  fmt_fprintf(stderr,
+              "-{1:-^{0}}-\n"
+              "|{2: ^7}|{3: ^14}|{4: ^14}|{5: ^14}|{6: ^13}|\n"
+              "-{1:-^{0}}-\n",
+              table_size, "", "Stage", "Start", "Duration", "Working time", "Utilisation");
+  std::chrono::nanoseconds start{0};
+  for (size_t i = 0; i < scheduler_stages.size(); ++i) {
+    const auto &stage = scheduler_stages[i];
+    const double capacity = std::chrono::duration<double>(stage.duration).count() * stage.threads_count;
+    const double utilisation = capacity > 0 ? std::chrono::duration<double>(stage.threads_working_time).count() / capacity : 0;
+    const auto color = utilisation > 0.75 ? TermStringFormat::green : utilisation > 0.25 ? TermStringFormat::yellow : TermStringFormat::red;
+    fmt_fprintf(stderr,
+                "|{0: >6} | {1: >12} | {2: >12} | {3: >12} | {4: >11} |\n",
+                i + 1,
+                pretty_time(start),
+                pretty_time(stage.duration),
+                pretty_time(stage.threads_working_time),
+                TermStringFormat::paint(fmt_format("{: >10.1f}%", utilisation * 100), color));
+    start += stage.duration;
+  }
+  fmt_fprintf(stderr, "-{0:-^{1}}-\n", "", table_size);
+}
+
 ProfilerRaw &get_profiler(const std::string &name) {
   return (*profiler)[name];
 }
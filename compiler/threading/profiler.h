@@ -6,6 +6,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <ostream>
 #include <string>
 #include <unordered_map>
 
@@ -95,6 +96,29 @@ void profiler_print_all(const std::unordered_map<std::string, ProfilerRaw> &coll
 
 std::string demangle(const char *name);
 
+// the parallel run of the pipes until the next sync node is finished, its on_finish included
+struct SchedulerStageStats {
+  std::chrono::nanoseconds start{0};
+  std::chrono::nanoseconds duration{0};
+  std::chrono::nanoseconds threads_working_time{0};
+  int threads_count{0};
+  // the process memory at the end of the stage, in bytes
+  size_t memory_rss{0};
+  size_t memory_rss_peak{0};
+};
+
+void profiler_add_scheduler_stage(const SchedulerStageStats &stage);
+void profiler_print_scheduler_stages();
+
+// The trace of the compilation: a span for every function processed by every pass, for every pipe task and
+// for every make job, written along with the scheduler stages in the Chrome trace event format (chrome://tracing, Perfetto).
+// It is off by default, as it keeps an event for each function and each pass in memory until the end
+void profiler_enable_trace();
+bool profiler_trace_enabled();
+// the start is the time since the epoch of std::chrono::steady_clock, the make jobs go to the lanes of their own
+void profiler_add_make_job_trace(const std::string &name, std::chrono::nanoseconds start, std::chrono::nanoseconds duration);
+void profiler_write_trace(std::ostream &out, const std::unordered_map<std::string, ProfilerRaw> &collected);
+
 
 class CachedProfiler : vk::not_copyable {
   TLS<ProfilerRaw *> raws_;
@@ -105,6 +129,10 @@ public:
     name_(std::move(name)) {
   }
 
+  const std::string &name() const noexcept {
+    return name_;
+  }
+
   ProfilerRaw &operator*() {
     return *operator->();
   }
@@ -134,3 +162,17 @@ public:
   }
 };
 
+// a span of the trace on the current thread, the category is a pass or a pipe name, which outlives the trace
+class TraceProfiler : vk::not_copyable {
+private:
+  const std::string *category_{nullptr};
+  std::string name_;
+  std::chrono::nanoseconds start_{0};
+  std::chrono::nanoseconds cpu_start_{0};
+  size_t allocated_start_{0};
+
+public:
+  TraceProfiler(const std::string &category, const std::string &name);
+  ~TraceProfiler();
+};
+
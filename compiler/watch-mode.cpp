@@ -0,0 +1,144 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "compiler/watch-mode.h"
+
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "common/smart_ptrs/unique_ptr_with_delete_function.h"
+#include "common/precise-time.h"
+#include "common/wrappers/string_view.h"
+
+#include "compiler/compiler.h"
+
+namespace {
+
+void close_dir(DIR *d) {
+  closedir(d);
+}
+
+class SourcesWatcher {
+public:
+  explicit SourcesWatcher(std::string skip_dir) :
+    inotify_fd_(inotify_init1(IN_CLOEXEC)),
+    skip_dir_(std::move(skip_dir)) {
+    if (inotify_fd_ == -1) {
+      std::cerr << "inotify_init1 failed: " << strerror(errno) << std::endl;
+      exit(1);
+    }
+  }
+
+  void watch_recursive(const std::string &dir) {
+    if (dir == skip_dir_) {
+      return;
+    }
+    const int wd = inotify_add_watch(inotify_fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE);
+    if (wd == -1) {
+      std::cerr << "Can't watch '" << dir << "': " << strerror(errno) << std::endl;
+      return;
+    }
+    watched_dirs_[wd] = dir;
+
+    vk::unique_ptr_with_delete_function<DIR, close_dir> dp{opendir(dir.c_str())};
+    if (dp == nullptr) {
+      return;
+    }
+    while (const auto *entry = readdir(dp.get())) {
+      // hidden dirs are vcs and ide data
+      if (entry->d_name[0] != '.' && entry->d_type == DT_DIR) {
+        watch_recursive(dir + entry->d_name + '/');
+      }
+    }
+  }
+
+  // blocks until a php file is changed, then waits for the burst of the changes made by a checkout or an editor to end
+  void wait_for_changes() {
+    bool php_changed = false;
+    int timeout_ms = -1;
+    while (true) {
+      pollfd pfd{inotify_fd_, POLLIN, 0};
+      const int ready = poll(&pfd, 1, timeout_ms);
+      if (ready == 0) {
+        return;
+      }
+      if (ready == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        std::cerr << "poll failed: " << strerror(errno) << std::endl;
+        exit(1);
+      }
+      if (read_events()) {
+        php_changed = true;
+      }
+      if (php_changed) {
+        timeout_ms = 200;
+      }
+    }
+  }
+
+private:
+  bool read_events() {
+    alignas(inotify_event) char buf[16 * 1024];
+    const ssize_t len = read(inotify_fd_, buf, sizeof(buf));
+    bool php_changed = false;
+    for (ssize_t pos = 0; pos < len;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(buf + pos);
+      pos += sizeof(inotify_event) + event->len;
+      auto it = watched_dirs_.find(event->wd);
+      if (it == watched_dirs_.end() || event->len == 0) {
+        continue;
+      }
+      if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)) && event->name[0] != '.') {
+        watch_recursive(it->second + event->name + '/');
+        php_changed = true;
+      } else if (vk::string_view{event->name}.ends_with(".php")) {
+        php_changed = true;
+      }
+    }
+    return php_changed;
+  }
+
+  int inotify_fd_;
+  std::string skip_dir_;
+  std::unordered_map<int, std::string> watched_dirs_;
+};
+
+bool compile_in_child(CompilerSettings *settings) {
+  const pid_t pid = fork();
+  if (pid == -1) {
+    std::cerr << "fork failed: " << strerror(errno) << std::endl;
+    exit(1);
+  }
+  if (pid == 0) {
+    // the settings are owned by the parent, the child just leaks them on exit
+    _exit(compiler_execute(settings) ? 0 : 1);
+  }
+  int status = 0;
+  while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace
+
+void compiler_watch(CompilerSettings *settings) {
+  SourcesWatcher watcher{settings->dest_dir.get()};
+  watcher.watch_recursive(settings->base_dir.get());
+
+  while (true) {
+    const double start = get_utime(CLOCK_MONOTONIC);
+    const bool ok = compile_in_child(settings);
+    std::cerr << (ok ? "\nCompilation succeeded" : "\nCompilation failed") << " in " << get_utime(CLOCK_MONOTONIC) - start << "s, "
+              << "waiting for changes in " << settings->base_dir.get() << std::endl;
+    watcher.wait_for_changes();
+  }
+}
@@ -0,0 +1,12 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "compiler/compiler-settings.h"
+
+// Compiles the project and then recompiles it on every change of the php files under the base dir, until killed.
+// Each compilation runs in a forked child, as the compiler keeps its state in globals and exits on the first errors;
+// the generated files that are not changed are not rewritten, so make rebuilds the objects of the changed functions only
+[[noreturn]] void compiler_watch(CompilerSettings *settings);
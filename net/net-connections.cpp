@@ -67,6 +67,8 @@ const char *unix_socket_directory = "/var/run/engine";
 SAVE_STRING_OPTION_PARSER(OPT_NETWORK, "unix-socket-directory", unix_socket_directory, "path to directory with UNIX sockets");
 
 long long netw_queries, netw_update_queries, total_failed_connections, total_connect_failures, unused_connections_closed;
+long long direct_writes, direct_written_bytes;
+long long coalesced_flushes;
 
 static void connections_constructor() __attribute__((constructor));
 static void connections_constructor() {
@@ -111,6 +113,11 @@ STATS_PROVIDER(net, 1000) {
   add_general_stat(stats, "tot_idle_time", "%.3f", epoll_total_idle_time());
   add_general_stat(stats, "average_idle_percent", "%.3f", uptime > 0 ? epoll_total_idle_time() / uptime * 100 : 0);
   add_histogram_stat_double(stats, "recent_idle_percent", get_recent_idle_percent());
+  if (net_reactor_busy_poll_time()) {
+    add_general_stat(stats, "tot_spin_time", "%.3f", epoll_total_spin_time());
+    add_general_stat(stats, "spin_wakeups", "%lld", epoll_spin_wakeups());
+    add_general_stat(stats, "spin_sleeps", "%lld", epoll_spin_sleeps());
+  }
 
   add_general_stat(stats, "network_connections", "%d", active_connections);
   add_general_stat(stats, "encrypted_connections", "%d", allocated_aes_crypto);
@@ -137,6 +144,9 @@ STATS_PROVIDER(net, 1000) {
   add_general_stat(stats, "qps", "%.3f", safe_div(netw_queries, uptime));
   add_general_stat(stats, "update_queries_total", "%lld", netw_update_queries);
   add_general_stat(stats, "update_qps", "%.3f", safe_div(netw_update_queries, uptime));
+  add_general_stat(stats, "direct_writes", "%lld", direct_writes);
+  add_general_stat(stats, "direct_written_bytes", "%lld", direct_written_bytes);
+  add_general_stat(stats, "coalesced_flushes", "%lld", coalesced_flushes);
 
   add_general_stat(stats, "PID", "%s", pid_to_print(&PID));
 }
@@ -904,6 +914,16 @@ int conn_write_timer_wakeup_gateway(event_timer_t *et) {
   return 0;
 }
 
+static int conn_coalesce_timer_wakeup_gateway(event_timer_t *et) {
+  struct connection *c = container_of(et, struct connection, write_timer);
+  vkprintf(2, "coalesced flush: awakening connection %d at %p, status=%d\n", c->fd, c, c->status);
+  if (out_total_processed_bytes(c) + out_total_unprocessed_bytes(c) > 0) {
+    c->flags |= C_DFLUSH;
+  }
+  put_event_into_heap(c->ev);
+  return 0;
+}
+
 int set_connection_timeout(struct connection *c, double timeout) {
   c->timer.wakeup = conn_timer_wakeup_gateway;
   c->flags &= ~C_ALARM;
@@ -987,6 +1007,27 @@ int flush_later(struct connection *c) {
   return 0;
 }
 
+int flush_coalesced(struct connection *c, double window, int max_bytes) {
+  const int bytes = out_total_processed_bytes(c) + out_total_unprocessed_bytes(c);
+  if (!bytes) {
+    return 0;
+  }
+  if (window <= 0 || bytes >= max_bytes) {
+    if (event_timer_active(&c->write_timer) && c->write_timer.wakeup == conn_coalesce_timer_wakeup_gateway) {
+      clear_connection_write_timeout(c);
+    }
+    return flush_later(c);
+  }
+  // the output is flushed when the window of the first packet is over, or earlier with the output of other packets
+  const double flush_time = precise_now + window;
+  if (!event_timer_active(&c->write_timer) || c->write_timer.wakeup_time > flush_time) {
+    set_timer_params(&c->write_timer, conn_coalesce_timer_wakeup_gateway, flush_time, "coalesce");
+    insert_event_timer(&c->write_timer);
+    coalesced_flushes++;
+  }
+  return 1;
+}
+
 void init_connection_buffers(struct connection *c) {
   if (c->flags & C_RAWMSG) {
     c->In.state = c->Out.state = 0;
@@ -2113,6 +2154,49 @@ int write_out_chk(struct connection *c, const void *data, int len) {
   }
 }
 
+int write_out_direct(struct connection *c, const struct iovec *iov, int iovcnt) {
+  int total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    total += static_cast<int>(iov[i].iov_len);
+  }
+
+  int r = 0;
+  if (total >= DIRECT_WRITE_MIN_BYTES && c->fd >= 0 && !c->crypto && !c->limit_per_sec && !c->limit_per_write
+      && !(c->flags & (C_RAWMSG | C_FAILED | C_NOWR)) && !c->error && !c->Out.total_bytes && !c->Out.unprocessed_bytes) {
+    r = static_cast<int>(writev(c->fd, iov, iovcnt));
+    vkprintf(3, "direct writev() to %d: %d written out of %d in %d chunks\n", c->fd, r, total, iovcnt);
+    if (r < 0) {
+      if (errno == EAGAIN) {
+        c->flags |= C_NOWR;
+      }
+      // a broken socket is found out by the writer
+      r = 0;
+    } else if (r < total) {
+      c->flags |= C_NOWR;
+    }
+    if (r > 0) {
+      direct_writes++;
+      direct_written_bytes += r;
+      if (c->type->data_sent) {
+        c->type->data_sent(c, r);
+      }
+    }
+  }
+
+  // the rest is buffered as usual
+  int res = r;
+  for (int i = 0; i < iovcnt; i++) {
+    const int len = static_cast<int>(iov[i].iov_len);
+    if (r >= len) {
+      r -= len;
+      continue;
+    }
+    res += write_out(&c->Out, static_cast<const char *>(iov[i].iov_base) + r, len - r);
+    r = 0;
+  }
+  return res;
+}
+
 void dump_connection_buffers(struct connection *c) {
   fprintf(stderr, "Dumping buffers of connection %d\nINPUT buffers of %d:\n", c->fd, c->fd);
   dump_buffers(&c->In);
@@ -278,6 +278,9 @@ int check_conn_functions(conn_type_t *type);
 int fail_connection(struct connection *c, int err);
 int flush_connection_output(struct connection *c);
 int flush_later(struct connection *c);
+/* as flush_later, but the output is flushed after window seconds, unless it gets max_bytes or more earlier,
+   so that the packets written during the window go out together */
+int flush_coalesced(struct connection *c, double window, int max_bytes);
 
 int set_connection_timeout(struct connection *c, double timeout);
 int clear_connection_timeout(struct connection *c);
@@ -320,6 +323,12 @@ extern long long netw_queries, netw_update_queries;
 int free_tmp_buffers(struct connection *c);
 
 int write_out_chk(struct connection *c, const void *data, int len);
+
+#define DIRECT_WRITE_MIN_BYTES (64 << 10)
+extern long long direct_writes, direct_written_bytes;
+/* for a large output and an idle writer the data is written into the socket right from the memory of the caller,
+   only what the socket has not accepted is copied into c->Out; returns the number of bytes written or buffered */
+int write_out_direct(struct connection *c, const struct iovec *iov, int iovcnt);
 void cond_dump_connection_buffers_stats();
 void dump_connection_buffers_stats();
 
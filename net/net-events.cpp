@@ -19,6 +19,7 @@ net_reactor_ctx_t main_thread_reactor = {.epoll_fd = -1,
                                          .timers = NULL,
                                          .event_heap = NULL,
                                          .timer_heap = NULL,
+                                         .timer_wheel = NULL,
                                          .pre_runqueue = NULL,
                                          .post_runqueue = NULL,
                                          .pre_event = NULL,
@@ -26,7 +27,12 @@ net_reactor_ctx_t main_thread_reactor = {.epoll_fd = -1,
                                          .last_wait = 0,
                                          .total_idle_time = 0,
                                          .average_idle_time = 0,
-                                         .average_idle_quotient = 0};
+                                         .average_idle_quotient = 0,
+                                         .uring = NULL,
+                                         .busy_poll = false,
+                                         .total_spin_time = 0,
+                                         .spin_wakeups = 0,
+                                         .spin_sleeps = 0};
 
 static void main_thread_reactor_alloc() __attribute__((constructor));
 
@@ -58,6 +58,22 @@ static inline double epoll_average_idle_quotient() {
   return main_thread_reactor.average_idle_quotient;
 }
 
+static inline double epoll_total_spin_time() {
+  return main_thread_reactor.total_spin_time;
+}
+
+static inline long long epoll_spin_wakeups() {
+  return main_thread_reactor.spin_wakeups;
+}
+
+static inline long long epoll_spin_sleeps() {
+  return main_thread_reactor.spin_sleeps;
+}
+
+static inline void epoll_set_busy_poll(bool busy_poll) {
+  main_thread_reactor.busy_poll = busy_poll;
+}
+
 static inline void init_epoll() {
   if (main_thread_reactor.epoll_fd == -1) {
     const bool ok = net_reactor_init(&main_thread_reactor);
@@ -8,15 +8,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "common/crc32.h"
 #include "common/kprintf.h"
 #include "common/precise-time.h"
+#include "common/string-kernels.h"
 
 #include "net/net-buffers.h"
 #include "net/net-connections.h"
 #include "net/net-events.h"
+#include "net/net-http2-server.h"
 
 /*
  *
@@ -138,6 +141,9 @@ int hts_close_connection (struct connection *c, int who) {
   if (HTS_FUNC(c)->ht_close != NULL) {
     HTS_FUNC(c)->ht_close (c, who);
   } 
+  if (HTS_DATA(c)->http2) {
+    http2_free (c);
+  }
 
   return server_close_connection (c, who);
 }
@@ -202,7 +208,72 @@ int write_http_error (struct connection *c, int code) {
     static char buff[1024];
     int len = format_http_error_page(code, buff);
     write_basic_http_header (c, code, 0, len, 0, 0);
-    return write_out (&c->Out, buff, len);
+    return write_http_body (c, buff, len);
+  }
+}
+
+int write_http_chunk (struct connection *c, const char *data, int len) {
+  if (len <= 0) {
+    return 0;
+  }
+  if (HTS_DATA(c)->http2) {
+    return http2_write_data (c, data, len, false);
+  }
+  char size_line[16];
+  int size_line_len = sprintf (size_line, "%x\r\n", len);
+  struct iovec iov[3] = {{size_line, static_cast<size_t>(size_line_len)}, {const_cast<char *>(data), static_cast<size_t>(len)}, {const_cast<char *>("\r\n"), 2}};
+  return write_out_direct (c, iov, 3);
+}
+
+int write_http_last_chunk (struct connection *c) {
+  if (HTS_DATA(c)->http2) {
+    return http2_write_data (c, NULL, 0, true);
+  }
+  return write_out (&c->Out, "0\r\n\r\n", 5);
+}
+
+int hts_read_query (struct connection *c, void *data, int len) {
+  if (HTS_DATA(c)->http2) {
+    return http2_read_query (c, data, len);
+  }
+  return read_in (&c->In, data, len);
+}
+
+int hts_query_ready_bytes (struct connection *c) {
+  if (HTS_DATA(c)->http2) {
+    return http2_query_ready_bytes (c);
+  }
+  return get_total_ready_bytes (&c->In);
+}
+
+int write_http_response (struct connection *c, const char *headers, int headers_len, const char *body, int body_len) {
+  if (HTS_DATA(c)->http2) {
+    http2_write_headers (c, headers, headers_len, body_len <= 0);
+    return http2_write_data (c, body, body_len, true);
+  }
+  struct iovec iov[2] = {{const_cast<char *>(headers), static_cast<size_t>(headers_len)}, {const_cast<char *>(body), static_cast<size_t>(body_len > 0 ? body_len : 0)}};
+  return write_out_direct (c, iov, 2) - headers_len;
+}
+
+int write_http_response_headers (struct connection *c, const char *headers, int headers_len) {
+  if (HTS_DATA(c)->http2) {
+    return http2_write_headers (c, headers, headers_len, false);
+  }
+  return write_out (&c->Out, headers, headers_len);
+}
+
+int write_http_body (struct connection *c, const char *data, int len) {
+  if (HTS_DATA(c)->http2) {
+    return http2_write_data (c, data, len, true);
+  }
+  return write_out (&c->Out, data, len);
+}
+
+void hts_abort_response (struct connection *c) {
+  if (HTS_DATA(c)->http2) {
+    http2_reset_stream (c);
+  } else {
+    HTS_DATA(c)->query_flags &= ~QF_KEEPALIVE;
   }
 }
 
@@ -212,6 +283,10 @@ int hts_parse_execute (struct connection *c) {
   int len;
   long long tt;
 
+  if (D->http2) {
+    return http2_parse_execute (c);
+  }
+
   while (c->status == conn_expect_query || c->status == conn_reading_query) {
     len = nbit_ready_bytes (&c->Q);
     ptr = ptr_s = static_cast<char*>(nbit_get_ptr (&c->Q));
@@ -226,6 +301,18 @@ int hts_parse_execute (struct connection *c) {
         case htqp_start:
           //fprintf (stderr, "htqp_start: ptr=%p (%.8s), hsize=%d, qf=%d, words=%d\n", ptr, ptr, D->header_size, D->query_flags, D->query_words);
           memset (D, 0, sizeof (*D));
+          if (HTS_FUNC(c)->allow_http2) {
+            int preface = http2_check_preface (c);
+            if (preface < 0) {
+              /* the reader waits for the rest of the preface */
+              c->status = conn_expect_query;
+              return HTTP2_PREFACE_SIZE - get_total_ready_bytes (&c->In);
+            }
+            if (preface > 0) {
+              http2_start (c);
+              return http2_parse_execute (c);
+            }
+          }
           D->query_type = htqt_none;
           D->data_size = -1;
           c->parse_state = htqp_readtospace;
@@ -233,12 +320,13 @@ int hts_parse_execute (struct connection *c) {
 
         case htqp_readtospace:
           //fprintf (stderr, "htqp_readtospace: ptr=%p (%.8s), hsize=%d, qf=%d, words=%d\n", ptr, ptr, D->header_size, D->query_flags, D->query_words);
-          while (ptr < ptr_e && ((unsigned) *ptr > ' ')) {
+          {
+            const int token_len = static_cast<int>(http_token_length(ptr, ptr_e - ptr));
             if (D->wlen < 15) {
-              D->word[D->wlen] = *ptr;
+              memcpy (D->word + D->wlen, ptr, token_len < 15 - D->wlen ? token_len : 15 - D->wlen);
             }
-            D->wlen++;
-            ptr++;
+            D->wlen += token_len;
+            ptr += token_len;
           }
           if (D->wlen > 4096) {
             if (D->query_words == 1) {
@@ -424,9 +512,11 @@ int hts_parse_execute (struct connection *c) {
         case htqp_skiptoeoln:
           //fprintf (stderr, "htqp_skiptoeoln: ptr=%p (%.8s), hsize=%d, qf=%d, words=%d\n", ptr, ptr, D->header_size, D->query_flags, D->query_words);
 
-          while (D->header_size < MAX_HTTP_HEADER_SIZE && ptr < ptr_e && (*ptr != '\r' && *ptr != '\n')) {
-            D->header_size++;
-            ptr++;
+          if (D->header_size < MAX_HTTP_HEADER_SIZE) {
+            const int max_len = ptr_e - ptr < MAX_HTTP_HEADER_SIZE - D->header_size ? ptr_e - ptr : MAX_HTTP_HEADER_SIZE - D->header_size;
+            const int skipped = static_cast<int>(find_first_of_chars(ptr, max_len, "\r\n", 2));
+            D->header_size += skipped;
+            ptr += skipped;
           }
           if (D->header_size >= MAX_HTTP_HEADER_SIZE) {
             c->parse_state = htqp_fatal;
@@ -855,6 +945,9 @@ int write_basic_http_header (struct connection *c, int code, int date, int len,
 
     ptr += sprintf (ptr, "\r\n");
 
+    if (D->http2) {
+      return http2_write_headers (c, buff, ptr - buff, len <= 0);
+    }
     return write_out (&c->Out, buff, ptr - buff);
   }
 
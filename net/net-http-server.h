@@ -17,13 +17,15 @@ struct http_server_functions {
   int (*ht_wakeup)(struct connection *c);
   int (*ht_alarm)(struct connection *c);
   int (*ht_close)(struct connection *c, int who);
+  int allow_http2;  /* a connection may start with the http/2 preface */
 };
 
 #define	HTTP_V09	9
 #define	HTTP_V10	0x100
 #define	HTTP_V11	0x101
+#define	HTTP_V20	0x200
 
-/* in conn->custom_data, 104 bytes */
+/* in conn->custom_data, 112 bytes */
 struct hts_data {
   int query_type;
   int query_flags;
@@ -44,6 +46,7 @@ struct hts_data {
   int extra_int3;
   int extra_int4;
   double extra_double, extra_double2;
+  void *http2;  /* the state of an http/2 connection, kept between its queries */
 };
 
 /* for hts_data.query_type */
@@ -88,6 +91,21 @@ int gen_http_time (char *date_buffer, int *time);
 char *cur_http_date ();
 int write_basic_http_header (struct connection *c, int code, int date, int len, const char *add_header, const char *content_type);
 int write_http_error (struct connection *c, int code);
+/* writes a chunk of a response with Transfer-Encoding: chunked, an empty chunk is skipped */
+int write_http_chunk (struct connection *c, const char *data, int len);
+/* writes the terminating zero-length chunk */
+int write_http_last_chunk (struct connection *c);
+/* the query and the response of http/2 streams go through these instead of the connection buffers */
+int hts_read_query (struct connection *c, void *data, int len);
+int hts_query_ready_bytes (struct connection *c);
+/* writes a whole response, the headers are the status line and the header lines ending with an empty line */
+int write_http_response (struct connection *c, const char *headers, int headers_len, const char *body, int body_len);
+/* writes the headers of a response which body follows as chunks */
+int write_http_response_headers (struct connection *c, const char *headers, int headers_len);
+/* writes the body after write_basic_http_header () */
+int write_http_body (struct connection *c, const char *data, int len);
+/* the response can't be completed: the http/1 connection is closed after it, the http/2 stream is reset */
+void hts_abort_response (struct connection *c);
 int format_http_error_page(int code, char *buff);
 
 /* END */
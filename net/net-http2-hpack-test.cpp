@@ -0,0 +1,125 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "net/net-http2-hpack.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace vk::net;
+
+namespace {
+
+using headers_t = std::vector<std::pair<std::string, std::string>>;
+
+std::string from_hex(const char *hex) {
+  std::string result;
+  for (; hex[0] && hex[1]; hex += 2) {
+    result.push_back(static_cast<char>(std::stoi(std::string(hex, 2), nullptr, 16)));
+  }
+  return result;
+}
+
+bool decode(HpackDecoder &decoder, const std::string &block, headers_t &headers) {
+  headers.clear();
+  return decoder.decode(reinterpret_cast<const uint8_t *>(block.data()), block.size(),
+                        [&headers](const std::string &name, const std::string &value) { headers.emplace_back(name, value); });
+}
+
+} // namespace
+
+TEST(net_http2_hpack, integer) {
+  std::string out;
+  hpack_encode_integer(out, 0x00, 5, 10);
+  EXPECT_EQ(out, from_hex("0a"));
+  out.clear();
+  hpack_encode_integer(out, 0x00, 5, 1337);
+  EXPECT_EQ(out, from_hex("1f9a0a"));
+
+  uint64_t value = 0;
+  const auto *ptr = reinterpret_cast<const uint8_t *>(out.data());
+  ASSERT_TRUE(hpack_decode_integer(ptr, ptr + out.size(), 5, value));
+  EXPECT_EQ(value, 1337);
+
+  const std::string endless = from_hex("1fffffffffffff");
+  ptr = reinterpret_cast<const uint8_t *>(endless.data());
+  EXPECT_FALSE(hpack_decode_integer(ptr, ptr + endless.size(), 5, value));
+}
+
+TEST(net_http2_hpack, requests_without_huffman) {
+  HpackDecoder decoder;
+  headers_t headers;
+
+  ASSERT_TRUE(decode(decoder, from_hex("828684410f7777772e6578616d706c652e636f6d"), headers));
+  EXPECT_EQ(headers, (headers_t{{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}}));
+  EXPECT_EQ(decoder.table_size(), 57);
+
+  ASSERT_TRUE(decode(decoder, from_hex("828684be58086e6f2d6361636865"), headers));
+  EXPECT_EQ(headers.back(), std::make_pair(std::string("cache-control"), std::string("no-cache")));
+  EXPECT_EQ(headers[3], std::make_pair(std::string(":authority"), std::string("www.example.com")));
+  EXPECT_EQ(decoder.table_size(), 110);
+
+  ASSERT_TRUE(decode(decoder, from_hex("828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565"), headers));
+  EXPECT_EQ(headers, (headers_t{{":method", "GET"}, {":scheme", "https"}, {":path", "/index.html"},
+                                {":authority", "www.example.com"}, {"custom-key", "custom-value"}}));
+  EXPECT_EQ(decoder.table_size(), 164);
+  EXPECT_EQ(decoder.table_entries(), 3);
+}
+
+TEST(net_http2_hpack, requests_with_huffman) {
+  HpackDecoder decoder;
+  headers_t headers;
+
+  ASSERT_TRUE(decode(decoder, from_hex("828684418cf1e3c2e5f23a6ba0ab90f4ff"), headers));
+  EXPECT_EQ(headers.back(), std::make_pair(std::string(":authority"), std::string("www.example.com")));
+
+  ASSERT_TRUE(decode(decoder, from_hex("828684be5886a8eb10649cbf"), headers));
+  EXPECT_EQ(headers.back(), std::make_pair(std::string("cache-control"), std::string("no-cache")));
+
+  ASSERT_TRUE(decode(decoder, from_hex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"), headers));
+  EXPECT_EQ(headers.back(), std::make_pair(std::string("custom-key"), std::string("custom-value")));
+  EXPECT_EQ(decoder.table_size(), 164);
+}
+
+TEST(net_http2_hpack, table_size_update_evicts) {
+  HpackDecoder decoder;
+  headers_t headers;
+  ASSERT_TRUE(decode(decoder, from_hex("400a637573746f6d2d6b65790c637573746f6d2d76616c7565"), headers));
+  EXPECT_EQ(decoder.table_entries(), 1);
+
+  ASSERT_TRUE(decode(decoder, from_hex("20"), headers));
+  EXPECT_EQ(decoder.table_entries(), 0);
+  EXPECT_EQ(decoder.table_size(), 0);
+
+  // the size above the one of the settings is a compression error
+  EXPECT_FALSE(decode(decoder, from_hex("3fe21f"), headers));
+}
+
+TEST(net_http2_hpack, errors) {
+  HpackDecoder decoder;
+  headers_t headers;
+  // index 0 and missing entries
+  EXPECT_FALSE(decode(decoder, from_hex("80"), headers));
+  EXPECT_FALSE(decode(decoder, from_hex("be"), headers));
+  // truncated string
+  EXPECT_FALSE(decode(decoder, from_hex("400a6375"), headers));
+  // huffman padding is longer than 7 bits
+  std::string out;
+  const std::string padding = from_hex("1fff");
+  EXPECT_FALSE(hpack_huffman_decode(reinterpret_cast<const uint8_t *>(padding.data()), padding.size(), out));
+}
+
+TEST(net_http2_hpack, encode_response) {
+  std::string block;
+  hpack_encode_status(block, 200);
+  hpack_encode_status(block, 302);
+  hpack_encode_header(block, "content-type", 12, "text/html", 9);
+
+  HpackDecoder decoder;
+  headers_t headers;
+  ASSERT_TRUE(decode(decoder, block, headers));
+  EXPECT_EQ(headers, (headers_t{{":status", "200"}, {":status", "302"}, {"content-type", "text/html"}}));
+  EXPECT_EQ(decoder.table_entries(), 0);
+}
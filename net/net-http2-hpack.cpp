@@ -0,0 +1,371 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "net/net-http2-hpack.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+namespace vk {
+namespace net {
+
+namespace {
+
+struct static_table_entry {
+  const char *name;
+  const char *value;
+};
+
+constexpr static_table_entry static_table[] = {
+  {":authority", ""},
+  {":method", "GET"},
+  {":method", "POST"},
+  {":path", "/"},
+  {":path", "/index.html"},
+  {":scheme", "http"},
+  {":scheme", "https"},
+  {":status", "200"},
+  {":status", "204"},
+  {":status", "206"},
+  {":status", "304"},
+  {":status", "400"},
+  {":status", "404"},
+  {":status", "500"},
+  {"accept-charset", ""},
+  {"accept-encoding", "gzip, deflate"},
+  {"accept-language", ""},
+  {"accept-ranges", ""},
+  {"accept", ""},
+  {"access-control-allow-origin", ""},
+  {"age", ""},
+  {"allow", ""},
+  {"authorization", ""},
+  {"cache-control", ""},
+  {"content-disposition", ""},
+  {"content-encoding", ""},
+  {"content-language", ""},
+  {"content-length", ""},
+  {"content-location", ""},
+  {"content-range", ""},
+  {"content-type", ""},
+  {"cookie", ""},
+  {"date", ""},
+  {"etag", ""},
+  {"expect", ""},
+  {"expires", ""},
+  {"from", ""},
+  {"host", ""},
+  {"if-match", ""},
+  {"if-modified-since", ""},
+  {"if-none-match", ""},
+  {"if-range", ""},
+  {"if-unmodified-since", ""},
+  {"last-modified", ""},
+  {"link", ""},
+  {"location", ""},
+  {"max-forwards", ""},
+  {"proxy-authenticate", ""},
+  {"proxy-authorization", ""},
+  {"range", ""},
+  {"referer", ""},
+  {"refresh", ""},
+  {"retry-after", ""},
+  {"server", ""},
+  {"set-cookie", ""},
+  {"strict-transport-security", ""},
+  {"transfer-encoding", ""},
+  {"user-agent", ""},
+  {"vary", ""},
+  {"via", ""},
+  {"www-authenticate", ""},
+};
+
+constexpr uint64_t static_table_size = sizeof(static_table) / sizeof(static_table[0]);
+
+struct huffman_code {
+  uint32_t code;
+  uint8_t bits;
+};
+
+// RFC 7541, Appendix B, indexed by the symbol, 256 is EOS
+constexpr huffman_code huffman_codes[257] = {
+  {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28}, {0xfffffe4, 28}, {0xfffffe5, 28},
+  {0xfffffe6, 28}, {0xfffffe7, 28}, {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+  {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28}, {0xfffffed, 28}, {0xfffffee, 28},
+  {0xfffffef, 28}, {0xffffff0, 28}, {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+  {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28}, {0xffffff8, 28}, {0xffffff9, 28},
+  {0xffffffa, 28}, {0xffffffb, 28}, {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+  {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11}, {0x3fa, 10}, {0x3fb, 10},
+  {0xf9, 8}, {0x7fb, 11}, {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+  {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6}, {0x1a, 6}, {0x1b, 6},
+  {0x1c, 6}, {0x1d, 6}, {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+  {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10}, {0x1ffa, 13}, {0x21, 6},
+  {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+  {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7}, {0x68, 7},
+  {0x69, 7}, {0x6a, 7}, {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+  {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7}, {0xfc, 8}, {0x73, 7},
+  {0xfd, 8}, {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+  {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5},
+  {0x25, 6}, {0x26, 6}, {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+  {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5}, {0x2b, 6}, {0x76, 7},
+  {0x2c, 6}, {0x8, 5}, {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+  {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14},
+  {0x1ffd, 13}, {0xffffffc, 28}, {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+  {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23}, {0x3fffd6, 22}, {0x7fffda, 23},
+  {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+  {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24}, {0x7fffe1, 23},
+  {0x7fffe2, 23}, {0x7fffe3, 23}, {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+  {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24}, {0x3fffda, 22}, {0x1fffdd, 21},
+  {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+  {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21}, {0x3fffdf, 22},
+  {0x7fffeb, 23}, {0x7fffec, 23}, {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+  {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23}, {0xfffea, 20}, {0x3fffe2, 22},
+  {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+  {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22}, {0x7ffff2, 23},
+  {0x3fffe8, 22}, {0x1ffffec, 25}, {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+  {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25}, {0x7fff2, 19}, {0x1fffe3, 21},
+  {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+  {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28}, {0x7ffffe3, 27},
+  {0x7ffffe4, 27}, {0x7ffffe5, 27}, {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+  {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23}, {0x3fffea, 22}, {0x3fffeb, 22},
+  {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+  {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27}, {0x7ffffe8, 27},
+  {0x7ffffe9, 27}, {0x7ffffea, 27}, {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+  {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26}, {0x3fffffff, 30},
+};
+
+constexpr int HUFFMAN_MAX_BITS = 30;
+
+// the code is canonical: the codes of one length are consecutive in the order of the symbols,
+// so a code of given length is decoded by its offset from the first code of that length
+class HuffmanDecodingTable {
+public:
+  HuffmanDecodingTable() {
+    int symbols_n = 0;
+    for (int bits = 1; bits <= HUFFMAN_MAX_BITS; ++bits) {
+      first_symbol_[bits] = symbols_n;
+      for (int symbol = 0; symbol < 257; ++symbol) {
+        if (huffman_codes[symbol].bits == bits) {
+          if (count_[bits] == 0) {
+            first_code_[bits] = huffman_codes[symbol].code;
+          }
+          ++count_[bits];
+          symbols_[symbols_n++] = static_cast<uint16_t>(symbol);
+        }
+      }
+    }
+  }
+
+  // returns the symbol or -1 if the code of this length doesn't exist
+  int find(uint32_t code, int bits) const {
+    if (code < first_code_[bits] || code - first_code_[bits] >= count_[bits]) {
+      return -1;
+    }
+    return symbols_[first_symbol_[bits] + code - first_code_[bits]];
+  }
+
+private:
+  std::array<uint32_t, HUFFMAN_MAX_BITS + 1> first_code_{};
+  std::array<uint32_t, HUFFMAN_MAX_BITS + 1> count_{};
+  std::array<int, HUFFMAN_MAX_BITS + 1> first_symbol_{};
+  std::array<uint16_t, 257> symbols_{};
+};
+
+bool decode_string(const uint8_t *&ptr, const uint8_t *end, std::string &out) {
+  if (ptr == end) {
+    return false;
+  }
+  const bool huffman = *ptr & 0x80;
+  uint64_t len = 0;
+  if (!hpack_decode_integer(ptr, end, 7, len) || len > static_cast<uint64_t>(end - ptr)) {
+    return false;
+  }
+  const uint8_t *data = ptr;
+  ptr += len;
+  if (huffman) {
+    out.clear();
+    return hpack_huffman_decode(data, len, out);
+  }
+  out.assign(reinterpret_cast<const char *>(data), len);
+  return true;
+}
+
+void encode_string(std::string &out, const char *str, size_t len) {
+  hpack_encode_integer(out, 0, 7, len);
+  out.append(str, len);
+}
+
+} // namespace
+
+bool hpack_decode_integer(const uint8_t *&ptr, const uint8_t *end, int prefix_bits, uint64_t &value) {
+  if (ptr == end) {
+    return false;
+  }
+  const uint64_t prefix_max = (1u << prefix_bits) - 1;
+  value = *ptr++ & prefix_max;
+  if (value < prefix_max) {
+    return true;
+  }
+  for (int shift = 0; ptr != end; shift += 7) {
+    // larger values are never legitimate: they exceed any size or index limit
+    if (shift > 28) {
+      return false;
+    }
+    const uint8_t byte = *ptr++;
+    value += static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void hpack_encode_integer(std::string &out, uint8_t first_byte, int prefix_bits, uint64_t value) {
+  const uint64_t prefix_max = (1u << prefix_bits) - 1;
+  if (value < prefix_max) {
+    out.push_back(static_cast<char>(first_byte | value));
+    return;
+  }
+  out.push_back(static_cast<char>(first_byte | prefix_max));
+  value -= prefix_max;
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+bool hpack_huffman_decode(const uint8_t *data, size_t len, std::string &out) {
+  static const HuffmanDecodingTable table;
+
+  uint32_t code = 0;
+  int bits = 0;
+  for (size_t i = 0; i < len; ++i) {
+    for (int bit = 7; bit >= 0; --bit) {
+      code = (code << 1) | ((data[i] >> bit) & 1);
+      if (++bits > HUFFMAN_MAX_BITS) {
+        return false;
+      }
+      const int symbol = table.find(code, bits);
+      if (symbol == 256) {
+        return false;
+      }
+      if (symbol >= 0) {
+        out.push_back(static_cast<char>(symbol));
+        code = 0;
+        bits = 0;
+      }
+    }
+  }
+  // the padding is the most significant bits of EOS, i.e. all ones and shorter than a byte
+  return bits < 8 && code == (1u << bits) - 1;
+}
+
+void hpack_encode_status(std::string &out, int status) {
+  constexpr int indexed_statuses[] = {200, 204, 206, 304, 400, 404, 500};
+  const auto *it = std::find(std::begin(indexed_statuses), std::end(indexed_statuses), status);
+  if (it != std::end(indexed_statuses)) {
+    hpack_encode_integer(out, 0x80, 7, 8 + (it - std::begin(indexed_statuses)));
+    return;
+  }
+  char value[16];
+  const int value_len = snprintf(value, sizeof(value), "%03d", status);
+  // literal without indexing, the name is ':status' of the static table
+  hpack_encode_integer(out, 0x00, 4, 8);
+  encode_string(out, value, value_len);
+}
+
+void hpack_encode_header(std::string &out, const char *name, size_t name_len, const char *value, size_t value_len) {
+  out.push_back(0x00);
+  encode_string(out, name, name_len);
+  encode_string(out, value, value_len);
+}
+
+bool HpackDecoder::lookup(uint64_t index, std::string &name, std::string &value) const {
+  if (index == 0) {
+    return false;
+  }
+  if (index <= static_table_size) {
+    name = static_table[index - 1].name;
+    value = static_table[index - 1].value;
+    return true;
+  }
+  index -= static_table_size + 1;
+  if (index >= dynamic_table_.size()) {
+    return false;
+  }
+  name = dynamic_table_[index].first;
+  value = dynamic_table_[index].second;
+  return true;
+}
+
+void HpackDecoder::evict(size_t max_size) {
+  while (table_size_ > max_size) {
+    const auto &oldest = dynamic_table_.back();
+    table_size_ -= oldest.first.size() + oldest.second.size() + 32;
+    dynamic_table_.pop_back();
+  }
+}
+
+void HpackDecoder::add(std::string name, std::string value) {
+  const size_t entry_size = name.size() + value.size() + 32;
+  evict(entry_size > max_table_size_ ? 0 : max_table_size_ - entry_size);
+  // an entry larger than the table just empties it
+  if (entry_size <= max_table_size_) {
+    table_size_ += entry_size;
+    dynamic_table_.emplace_front(std::move(name), std::move(value));
+  }
+}
+
+bool HpackDecoder::decode(const uint8_t *data, size_t len, const header_callback &on_header) {
+  const uint8_t *ptr = data;
+  const uint8_t *end = data + len;
+  std::string name, value;
+  while (ptr != end) {
+    const uint8_t first_byte = *ptr;
+    if (first_byte & 0x80) {
+      uint64_t index = 0;
+      if (!hpack_decode_integer(ptr, end, 7, index) || !lookup(index, name, value)) {
+        return false;
+      }
+      on_header(name, value);
+      continue;
+    }
+    if ((first_byte & 0xe0) == 0x20) {
+      uint64_t new_size = 0;
+      if (!hpack_decode_integer(ptr, end, 5, new_size) || new_size > table_size_limit_) {
+        return false;
+      }
+      max_table_size_ = new_size;
+      evict(max_table_size_);
+      continue;
+    }
+
+    // literals: with incremental indexing (01), without indexing (0000) and never indexed (0001)
+    const bool with_indexing = (first_byte & 0xc0) == 0x40;
+    uint64_t index = 0;
+    if (!hpack_decode_integer(ptr, end, with_indexing ? 6 : 4, index)) {
+      return false;
+    }
+    if (index != 0) {
+      if (!lookup(index, name, value)) {
+        return false;
+      }
+    } else if (!decode_string(ptr, end, name)) {
+      return false;
+    }
+    if (!decode_string(ptr, end, value)) {
+      return false;
+    }
+    on_header(name, value);
+    if (with_indexing) {
+      add(name, value);
+    }
+  }
+  return true;
+}
+
+} // namespace net
+} // namespace vk
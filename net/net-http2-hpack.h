@@ -0,0 +1,63 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#ifndef KDB_NET_NET_HTTP2_HPACK_H
+#define KDB_NET_NET_HTTP2_HPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace vk {
+namespace net {
+
+// HPACK (RFC 7541) header compression of HTTP/2
+
+constexpr size_t HPACK_DEFAULT_TABLE_SIZE = 4096;
+
+bool hpack_decode_integer(const uint8_t *&ptr, const uint8_t *end, int prefix_bits, uint64_t &value);
+void hpack_encode_integer(std::string &out, uint8_t first_byte, int prefix_bits, uint64_t value);
+bool hpack_huffman_decode(const uint8_t *data, size_t len, std::string &out);
+
+// the encoder never indexes: response headers of scripts are mostly unique, and the literals keep it stateless
+void hpack_encode_status(std::string &out, int status);
+void hpack_encode_header(std::string &out, const char *name, size_t name_len, const char *value, size_t value_len);
+
+class HpackDecoder {
+public:
+  using header_callback = std::function<void(const std::string &name, const std::string &value)>;
+
+  explicit HpackDecoder(size_t max_table_size = HPACK_DEFAULT_TABLE_SIZE)
+    : max_table_size_(max_table_size)
+    , table_size_limit_(max_table_size) {}
+
+  // decodes a complete header block, returns false on a compression error which is fatal for the connection
+  bool decode(const uint8_t *data, size_t len, const header_callback &on_header);
+
+  size_t table_size() const {
+    return table_size_;
+  }
+
+  size_t table_entries() const {
+    return dynamic_table_.size();
+  }
+
+private:
+  bool lookup(uint64_t index, std::string &name, std::string &value) const;
+  void add(std::string name, std::string value);
+  void evict(size_t max_size);
+
+  std::deque<std::pair<std::string, std::string>> dynamic_table_;
+  size_t table_size_{0};
+  size_t max_table_size_;
+  const size_t table_size_limit_;
+};
+
+} // namespace net
+} // namespace vk
+
+#endif // KDB_NET_NET_HTTP2_HPACK_H
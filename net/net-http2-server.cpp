@@ -0,0 +1,898 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "net/net-http2-server.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cctype>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+#include <vector>
+
+#include "common/kprintf.h"
+
+#include "net/net-buffers.h"
+#include "net/net-http-server.h"
+#include "net/net-http2-hpack.h"
+
+long long http2_connections_total, http2_streams_total, http2_streams_refused;
+
+namespace {
+
+const char http2_preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+static_assert(sizeof(http2_preface) - 1 == HTTP2_PREFACE_SIZE, "preface size");
+
+constexpr int FRAME_HEADER_SIZE = 9;
+constexpr uint32_t MAX_FRAME_SIZE = 16384;
+constexpr uint32_t MAX_CONCURRENT_STREAMS = 128;
+constexpr int64_t DEFAULT_WINDOW = 65535;
+constexpr int64_t MAX_WINDOW = 0x7fffffff;
+constexpr int64_t CONNECTION_RECEIVE_WINDOW = 1 << 24;
+// the header block is decoded even for the refused streams to keep the hpack state, but it has to fit into memory
+constexpr size_t MAX_HEADER_BLOCK_SIZE = 4 * MAX_HTTP_HEADER_SIZE;
+
+enum frame_type : uint8_t {
+  FRAME_DATA = 0,
+  FRAME_HEADERS = 1,
+  FRAME_PRIORITY = 2,
+  FRAME_RST_STREAM = 3,
+  FRAME_SETTINGS = 4,
+  FRAME_PUSH_PROMISE = 5,
+  FRAME_PING = 6,
+  FRAME_GOAWAY = 7,
+  FRAME_WINDOW_UPDATE = 8,
+  FRAME_CONTINUATION = 9
+};
+
+enum frame_flags : uint8_t {
+  FLAG_END_STREAM = 0x1,
+  FLAG_ACK = 0x1,
+  FLAG_END_HEADERS = 0x4,
+  FLAG_PADDED = 0x8,
+  FLAG_PRIORITY = 0x20
+};
+
+enum error_code : uint32_t {
+  ERROR_NO_ERROR = 0,
+  ERROR_PROTOCOL = 1,
+  ERROR_INTERNAL = 2,
+  ERROR_FLOW_CONTROL = 3,
+  ERROR_STREAM_CLOSED = 5,
+  ERROR_FRAME_SIZE = 6,
+  ERROR_REFUSED_STREAM = 7,
+  ERROR_COMPRESSION = 9,
+  ERROR_ENHANCE_YOUR_CALM = 11
+};
+
+enum settings_id : uint16_t {
+  SETTINGS_ENABLE_PUSH = 2,
+  SETTINGS_MAX_CONCURRENT_STREAMS = 3,
+  SETTINGS_INITIAL_WINDOW_SIZE = 4,
+  SETTINGS_MAX_FRAME_SIZE = 5,
+  SETTINGS_MAX_HEADER_LIST_SIZE = 6
+};
+
+struct http2_stream {
+  std::string header_block;
+  // the request as HTTP/1.1 text, the body is appended right before the execution
+  std::string query;
+  std::string body;
+  int query_type{htqt_none};
+  int first_line_size{0};
+  int uri_offset{0};
+  int uri_size{0};
+  int host_offset{0};
+  int host_size{0};
+  bool has_content_length{false};
+  bool end_stream_with_headers{false};
+  bool headers_received{false};
+  bool refused{false};
+  bool request_done{false};
+
+  // DATA waiting for the flow control window of the client
+  std::string pending;
+  size_t pending_offset{0};
+  bool pending_end_stream{false};
+  bool response_done{false};
+  int64_t send_window{DEFAULT_WINDOW};
+};
+
+struct http2_connection {
+  vk::net::HpackDecoder decoder;
+  std::map<uint32_t, http2_stream> streams;
+  // streams are executed one at a time, the ready one is executed before the next frame is read
+  uint32_t ready_stream_id{0};
+  uint32_t active_stream_id{0};
+  size_t active_read_offset{0};
+  uint32_t last_stream_id{0};
+  uint32_t continuation_stream_id{0};
+  int64_t send_window{DEFAULT_WINDOW};
+  int64_t initial_window{DEFAULT_WINDOW};
+  uint32_t peer_max_frame_size{MAX_FRAME_SIZE};
+  bool goaway{false};
+};
+
+inline http2_connection *get_http2(struct connection *c) {
+  return static_cast<http2_connection *>(HTS_DATA(c)->http2);
+}
+
+inline uint32_t read_uint32(const uint8_t *ptr) {
+  return (static_cast<uint32_t>(ptr[0]) << 24) | (static_cast<uint32_t>(ptr[1]) << 16) | (static_cast<uint32_t>(ptr[2]) << 8) | ptr[3];
+}
+
+inline void put_uint32(uint8_t *ptr, uint32_t value) {
+  ptr[0] = static_cast<uint8_t>(value >> 24);
+  ptr[1] = static_cast<uint8_t>(value >> 16);
+  ptr[2] = static_cast<uint8_t>(value >> 8);
+  ptr[3] = static_cast<uint8_t>(value);
+}
+
+void write_frame(struct connection *c, uint8_t type, uint8_t flags, uint32_t stream_id, const void *payload, uint32_t len) {
+  uint8_t header[FRAME_HEADER_SIZE];
+  header[0] = static_cast<uint8_t>(len >> 16);
+  header[1] = static_cast<uint8_t>(len >> 8);
+  header[2] = static_cast<uint8_t>(len);
+  header[3] = type;
+  header[4] = flags;
+  put_uint32(header + 5, stream_id & 0x7fffffff);
+  write_out(&c->Out, header, FRAME_HEADER_SIZE);
+  if (len) {
+    write_out(&c->Out, payload, len);
+  }
+}
+
+void send_rst_stream(struct connection *c, uint32_t stream_id, uint32_t error) {
+  uint8_t payload[4];
+  put_uint32(payload, error);
+  write_frame(c, FRAME_RST_STREAM, 0, stream_id, payload, sizeof(payload));
+}
+
+void send_window_update(struct connection *c, uint32_t stream_id, uint32_t increment) {
+  uint8_t payload[4];
+  put_uint32(payload, increment);
+  write_frame(c, FRAME_WINDOW_UPDATE, 0, stream_id, payload, sizeof(payload));
+}
+
+void connection_error(struct connection *c, http2_connection *h2, uint32_t error) {
+  vkprintf(1, "http2: connection #%d error %u, last stream %u\n", c->fd, error, h2->last_stream_id);
+  uint8_t payload[8];
+  put_uint32(payload, h2->last_stream_id);
+  put_uint32(payload + 4, error);
+  write_frame(c, FRAME_GOAWAY, 0, 0, payload, sizeof(payload));
+  h2->goaway = true;
+  c->status = conn_write_close;
+  c->parse_state = -1;
+}
+
+void send_header_block(struct connection *c, http2_connection *h2, uint32_t stream_id, const std::string &block, bool end_stream) {
+  size_t offset = 0;
+  uint8_t type = FRAME_HEADERS;
+  do {
+    const size_t len = std::min<size_t>(block.size() - offset, h2->peer_max_frame_size);
+    uint8_t flags = offset + len == block.size() ? FLAG_END_HEADERS : 0;
+    if (type == FRAME_HEADERS && end_stream) {
+      flags |= FLAG_END_STREAM;
+    }
+    write_frame(c, type, flags, stream_id, block.data() + offset, static_cast<uint32_t>(len));
+    offset += len;
+    type = FRAME_CONTINUATION;
+  } while (offset < block.size());
+}
+
+bool is_connection_specific_header(const char *name, size_t len) {
+  static const char *names[] = {"connection", "keep-alive", "proxy-connection", "transfer-encoding", "upgrade"};
+  for (const char *header : names) {
+    if (strlen(header) == len && !strncasecmp(header, name, len)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the response headers are the status line and header lines of HTTP/1.1
+void encode_response_headers(const char *headers, int len, std::string &block) {
+  const char *ptr = headers;
+  const char *end = headers + len;
+  int status = 200;
+  std::string name;
+  bool first_line = true;
+  while (ptr < end) {
+    const char *eol = static_cast<const char *>(memchr(ptr, '\n', end - ptr));
+    const char *line_end = eol ? eol : end;
+    const char *line = ptr;
+    ptr = eol ? eol + 1 : end;
+    if (line_end > line && line_end[-1] == '\r') {
+      line_end--;
+    }
+    if (line == line_end) {
+      break;
+    }
+
+    if (first_line) {
+      first_line = false;
+      if (line_end - line > 5 && !strncmp(line, "HTTP/", 5)) {
+        const char *code = static_cast<const char *>(memchr(line, ' ', line_end - line));
+        if (code && sscanf(code, "%d", &status) != 1) {
+          status = 200;
+        }
+        continue;
+      }
+    }
+
+    const char *colon = static_cast<const char *>(memchr(line, ':', line_end - line));
+    if (!colon || colon == line || is_connection_specific_header(line, colon - line)) {
+      continue;
+    }
+    name.assign(line, colon - line);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    const char *value = colon + 1;
+    while (value < line_end && (*value == ' ' || *value == '\t')) {
+      value++;
+    }
+    vk::net::hpack_encode_header(block, name.data(), name.size(), value, line_end - value);
+  }
+
+  std::string status_block;
+  vk::net::hpack_encode_status(status_block, status);
+  block.insert(0, status_block);
+}
+
+bool has_forbidden_chars(const std::string &str, bool allow_spaces) {
+  return std::any_of(str.begin(), str.end(), [allow_spaces](char ch) {
+    return ch == '\r' || ch == '\n' || ch == '\0' || (!allow_spaces && (ch == ' ' || ch == '\t'));
+  });
+}
+
+// builds the HTTP/1.1 text of the request, returns 0 or the http error code to answer with
+int build_query(http2_stream &stream, const std::vector<std::pair<std::string, std::string>> &headers) {
+  std::string method, path, authority, cookie, header_lines;
+  bool regular_headers_started = false;
+  for (const auto &header : headers) {
+    const std::string &name = header.first;
+    const std::string &value = header.second;
+    if (has_forbidden_chars(value, true)) {
+      return 400;
+    }
+    if (!name.empty() && name[0] == ':') {
+      if (regular_headers_started) {
+        return 400;
+      }
+      if (name == ":method") {
+        method = value;
+      } else if (name == ":path") {
+        path = value;
+      } else if (name == ":authority") {
+        authority = value;
+      } else if (name != ":scheme") {
+        return 400;
+      }
+      continue;
+    }
+
+    regular_headers_started = true;
+    if (name.empty() || has_forbidden_chars(name, false) || name.find(':') != std::string::npos
+        || std::any_of(name.begin(), name.end(), ::isupper) || is_connection_specific_header(name.data(), name.size())) {
+      return 400;
+    }
+    if (name == "cookie") {
+      // cookies may be split into several fields, see RFC 7540, 8.1.2.5
+      if (!cookie.empty()) {
+        cookie.append("; ");
+      }
+      cookie.append(value);
+    } else if (name == "host") {
+      if (authority.empty()) {
+        authority = value;
+      }
+    } else {
+      if (name == "content-length") {
+        stream.has_content_length = true;
+        if (atoll(value.c_str()) > HTTP2_MAX_REQUEST_BODY) {
+          return 413;
+        }
+      }
+      header_lines.append(name).append(": ").append(value).append("\r\n");
+    }
+  }
+  if (method.empty() || path.empty() || has_forbidden_chars(method, false) || has_forbidden_chars(path, false) || has_forbidden_chars(authority, false)) {
+    return 400;
+  }
+
+  if (method == "GET") {
+    stream.query_type = htqt_get;
+  } else if (method == "POST") {
+    stream.query_type = htqt_post;
+  } else if (method == "HEAD") {
+    stream.query_type = htqt_head;
+  } else if (method == "OPTIONS") {
+    stream.query_type = htqt_options;
+  } else {
+    stream.query_type = htqt_error;
+  }
+
+  std::string &query = stream.query;
+  query.append(method).append(" ");
+  stream.uri_offset = static_cast<int>(query.size());
+  stream.uri_size = static_cast<int>(path.size());
+  query.append(path).append(" HTTP/1.1\r\n");
+  stream.first_line_size = static_cast<int>(query.size());
+  query.append("Host: ");
+  stream.host_offset = static_cast<int>(query.size());
+  stream.host_size = static_cast<int>(authority.size());
+  query.append(authority).append("\r\n");
+  if (!cookie.empty()) {
+    query.append("Cookie: ").append(cookie).append("\r\n");
+  }
+  query.append(header_lines);
+  // keep the room for Content-Length and the final empty line
+  if (query.size() + 32 > MAX_HTTP_HEADER_SIZE) {
+    return 431;
+  }
+  return 0;
+}
+
+// answers a stream without executing it, the reason is only in the status
+void answer_stream(struct connection *c, http2_connection *h2, uint32_t stream_id, int code) {
+  auto it = h2->streams.find(stream_id);
+  assert (it != h2->streams.end());
+  std::string block;
+  vk::net::hpack_encode_status(block, code);
+  send_header_block(c, h2, stream_id, block, true);
+  if (!it->second.request_done) {
+    send_rst_stream(c, stream_id, ERROR_NO_ERROR);
+  }
+  h2->streams.erase(it);
+}
+
+void flush_stream(struct connection *c, http2_connection *h2, uint32_t stream_id, http2_stream &stream) {
+  while (stream.pending_offset < stream.pending.size()) {
+    const int64_t window = std::min(h2->send_window, stream.send_window);
+    if (window <= 0) {
+      return;
+    }
+    const size_t len = std::min({stream.pending.size() - stream.pending_offset, static_cast<size_t>(window), static_cast<size_t>(h2->peer_max_frame_size)});
+    const bool last = stream.pending_offset + len == stream.pending.size() && stream.pending_end_stream;
+    write_frame(c, FRAME_DATA, last ? FLAG_END_STREAM : 0, stream_id, stream.pending.data() + stream.pending_offset, static_cast<uint32_t>(len));
+    stream.pending_offset += len;
+    h2->send_window -= len;
+    stream.send_window -= len;
+    stream.response_done |= last;
+  }
+  stream.pending.clear();
+  stream.pending_offset = 0;
+  if (stream.pending_end_stream && !stream.response_done) {
+    write_frame(c, FRAME_DATA, FLAG_END_STREAM, stream_id, nullptr, 0);
+    stream.response_done = true;
+  }
+}
+
+void flush_streams(struct connection *c, http2_connection *h2) {
+  for (auto it = h2->streams.begin(); it != h2->streams.end();) {
+    flush_stream(c, h2, it->first, it->second);
+    if (it->second.response_done && it->first != h2->active_stream_id) {
+      it = h2->streams.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+http2_stream *get_active_stream(struct connection *c) {
+  http2_connection *h2 = get_http2(c);
+  if (!h2 || !h2->active_stream_id) {
+    return nullptr;
+  }
+  auto it = h2->streams.find(h2->active_stream_id);
+  return it == h2->streams.end() ? nullptr : &it->second;
+}
+
+void execute_stream(struct connection *c, http2_connection *h2, uint32_t stream_id) {
+  http2_stream &stream = h2->streams.at(stream_id);
+  if (!stream.body.empty() && !stream.has_content_length) {
+    stream.query.append("Content-Length: ").append(std::to_string(stream.body.size())).append("\r\n");
+  }
+  stream.query.append("\r\n");
+
+  struct hts_data *D = HTS_DATA(c);
+  void *state = D->http2;
+  memset (D, 0, sizeof(*D));
+  D->http2 = state;
+  D->query_type = stream.query_type;
+  D->query_flags = QF_KEEPALIVE;
+  D->http_ver = HTTP_V20;
+  D->first_line_size = stream.first_line_size;
+  D->header_size = static_cast<int>(stream.query.size());
+  D->uri_offset = stream.uri_offset;
+  D->uri_size = stream.uri_size;
+  D->host_offset = stream.host_offset;
+  D->host_size = stream.host_size;
+  D->data_size = stream.body.empty() && stream.query_type != htqt_post ? -1 : static_cast<int>(stream.body.size());
+  stream.query.append(stream.body);
+  std::string().swap(stream.body);
+
+  h2->active_stream_id = stream_id;
+  h2->active_read_offset = 0;
+  http2_streams_total++;
+  http_queries++;
+  http_queries_size += D->header_size + std::max(D->data_size, 0);
+
+  c->status = conn_running;
+  assert (HTS_FUNC(c)->execute);
+  const int res = HTS_FUNC(c)->execute(c, D->query_type);
+  if (res > 0) {
+    // the whole query is already there, the execute function can't need more bytes
+    write_http_error(c, 500);
+  } else if (res < 0 && res != SKIP_ALL_BYTES) {
+    write_http_error(c, -res);
+  }
+  if (c->status == conn_running) {
+    c->status = conn_expect_query;
+  }
+  if (c->status != conn_wait_net && c->status != conn_wait_aio) {
+    http2_finish_query(c);
+  }
+}
+
+void on_header_block_end(struct connection *c, http2_connection *h2, uint32_t stream_id) {
+  http2_stream &stream = h2->streams.at(stream_id);
+  std::vector<std::pair<std::string, std::string>> headers;
+  const bool decoded = h2->decoder.decode(reinterpret_cast<const uint8_t *>(stream.header_block.data()), stream.header_block.size(),
+                                          [&headers](const std::string &name, const std::string &value) { headers.emplace_back(name, value); });
+  std::string().swap(stream.header_block);
+  if (!decoded) {
+    connection_error(c, h2, ERROR_COMPRESSION);
+    return;
+  }
+
+  if (stream.refused) {
+    http2_streams_refused++;
+    send_rst_stream(c, stream_id, ERROR_REFUSED_STREAM);
+    h2->streams.erase(stream_id);
+    return;
+  }
+  if (!stream.headers_received) {
+    // trailers are allowed but ignored
+    stream.headers_received = true;
+    if (const int error = build_query(stream, headers)) {
+      stream.request_done = stream.end_stream_with_headers;
+      answer_stream(c, h2, stream_id, error);
+      return;
+    }
+  }
+  if (stream.end_stream_with_headers) {
+    stream.request_done = true;
+    h2->ready_stream_id = stream_id;
+  }
+}
+
+bool on_headers(struct connection *c, http2_connection *h2, uint8_t flags, uint32_t stream_id, const uint8_t *payload, uint32_t len) {
+  if (stream_id == 0 || !(stream_id & 1)) {
+    connection_error(c, h2, ERROR_PROTOCOL);
+    return false;
+  }
+  const uint8_t *ptr = payload;
+  const uint8_t *end = payload + len;
+  if (flags & FLAG_PADDED) {
+    if (ptr == end || *ptr >= end - ptr) {
+      connection_error(c, h2, ERROR_PROTOCOL);
+      return false;
+    }
+    end -= *ptr++;
+  }
+  if (flags & FLAG_PRIORITY) {
+    if (end - ptr < 5) {
+      connection_error(c, h2, ERROR_PROTOCOL);
+      return false;
+    }
+    ptr += 5;
+  }
+
+  auto it = h2->streams.find(stream_id);
+  if (it == h2->streams.end()) {
+    if (stream_id <= h2->last_stream_id) {
+      connection_error(c, h2, ERROR_STREAM_CLOSED);
+      return false;
+    }
+    h2->last_stream_id = stream_id;
+    it = h2->streams.emplace(stream_id, http2_stream()).first;
+    it->second.send_window = h2->initial_window;
+    it->second.refused = h2->goaway || h2->streams.size() > MAX_CONCURRENT_STREAMS;
+  } else if (it->second.request_done || !(flags & FLAG_END_STREAM)) {
+    // the only headers of an open stream are trailers, they end the stream
+    connection_error(c, h2, ERROR_PROTOCOL);
+    return false;
+  }
+
+  http2_stream &stream = it->second;
+  stream.end_stream_with_headers = flags & FLAG_END_STREAM;
+  stream.header_block.assign(reinterpret_cast<const char *>(ptr), end - ptr);
+  if (!(flags & FLAG_END_HEADERS)) {
+    h2->continuation_stream_id = stream_id;
+    return true;
+  }
+  on_header_block_end(c, h2, stream_id);
+  return c->status != conn_write_close;
+}
+
+bool on_continuation(struct connection *c, http2_connection *h2, uint8_t flags, uint32_t stream_id, const uint8_t *payload, uint32_t len) {
+  http2_stream &stream = h2->streams.at(stream_id);
+  if (stream.header_block.size() + len > MAX_HEADER_BLOCK_SIZE) {
+    connection_error(c, h2, ERROR_ENHANCE_YOUR_CALM);
+    return false;
+  }
+  stream.header_block.append(reinterpret_cast<const char *>(payload), len);
+  if (flags & FLAG_END_HEADERS) {
+    h2->continuation_stream_id = 0;
+    on_header_block_end(c, h2, stream_id);
+  }
+  return c->status != conn_write_close;
+}
+
+bool on_data(struct connection *c, http2_connection *h2, uint8_t flags, uint32_t stream_id, const uint8_t *payload, uint32_t len) {
+  if (stream_id == 0) {
+    connection_error(c, h2, ERROR_PROTOCOL);
+    return false;
+  }
+  const uint8_t *ptr = payload;
+  const uint8_t *end = payload + len;
+  if (flags & FLAG_PADDED) {
+    if (ptr == end || *ptr >= end - ptr) {
+      connection_error(c, h2, ERROR_PROTOCOL);
+      return false;
+    }
+    end -= *ptr++;
+  }
+  // the whole frame counts in flow control, the connection window is given back at once
+  if (len) {
+    send_window_update(c, 0, len);
+  }
+
+  auto it = h2->streams.find(stream_id);
+  if (it == h2->streams.end() || it->second.request_done) {
+    if (stream_id > h2->last_stream_id) {
+      connection_error(c, h2, ERROR_PROTOCOL);
+      return false;
+    }
+    // the stream is already answered and reset
+    return true;
+  }
+  http2_stream &stream = it->second;
+  if (stream.body.size() + (end - ptr) > HTTP2_MAX_REQUEST_BODY) {
+    answer_stream(c, h2, stream_id, 413);
+    return true;
+  }
+  stream.body.append(reinterpret_cast<const char *>(ptr), end - ptr);
+  if (flags & FLAG_END_STREAM) {
+    stream.request_done = true;
+    h2->ready_stream_id = stream_id;
+  }
+  return true;
+}
+
+bool on_settings(struct connection *c, http2_connection *h2, uint8_t flags, uint32_t stream_id, const uint8_t *payload, uint32_t len) {
+  if (stream_id != 0) {
+    connection_error(c, h2, ERROR_PROTOCOL);
+    return false;
+  }
+  if (flags & FLAG_ACK) {
+    if (len) {
+      connection_error(c, h2, ERROR_FRAME_SIZE);
+      return false;
+    }
+    return true;
+  }
+  if (len % 6) {
+    connection_error(c, h2, ERROR_FRAME_SIZE);
+    return false;
+  }
+  for (const uint8_t *ptr = payload; ptr < payload + len; ptr += 6) {
+    const uint16_t id = static_cast<uint16_t>((ptr[0] << 8) | ptr[1]);
+    const uint32_t value = read_uint32(ptr + 2);
+    switch (id) {
+      case SETTINGS_ENABLE_PUSH:
+        if (value > 1) {
+          connection_error(c, h2, ERROR_PROTOCOL);
+          return false;
+        }
+        break;
+      case SETTINGS_INITIAL_WINDOW_SIZE: {
+        if (value > MAX_WINDOW) {
+          connection_error(c, h2, ERROR_FLOW_CONTROL);
+          return false;
+        }
+        const int64_t delta = static_cast<int64_t>(value) - h2->initial_window;
+        for (auto &stream : h2->streams) {
+          stream.second.send_window += delta;
+        }
+        h2->initial_window = value;
+        break;
+      }
+      case SETTINGS_MAX_FRAME_SIZE:
+        if (value < MAX_FRAME_SIZE || value > 0xffffff) {
+          connection_error(c, h2, ERROR_PROTOCOL);
+          return false;
+        }
+        h2->peer_max_frame_size = value;
+        break;
+      default:
+        break;
+    }
+  }
+  write_frame(c, FRAME_SETTINGS, FLAG_ACK, 0, nullptr, 0);
+  flush_streams(c, h2);
+  return true;
+}
+
+bool on_window_update(struct connection *c, http2_connection *h2, uint32_t stream_id, const uint8_t *payload, uint32_t len) {
+  if (len != 4) {
+    connection_error(c, h2, ERROR_FRAME_SIZE);
+    return false;
+  }
+  const uint32_t increment = read_uint32(payload) & 0x7fffffff;
+  if (stream_id == 0) {
+    h2->send_window += increment;
+    if (increment == 0 || h2->send_window > MAX_WINDOW) {
+      connection_error(c, h2, increment ? ERROR_FLOW_CONTROL : ERROR_PROTOCOL);
+      return false;
+    }
+    flush_streams(c, h2);
+    return true;
+  }
+
+  auto it = h2->streams.find(stream_id);
+  if (it == h2->streams.end()) {
+    return true;
+  }
+  http2_stream &stream = it->second;
+  stream.send_window += increment;
+  if (increment == 0 || stream.send_window > MAX_WINDOW) {
+    send_rst_stream(c, stream_id, increment ? ERROR_FLOW_CONTROL : ERROR_PROTOCOL);
+    stream.response_done = true;
+    stream.pending.clear();
+  } else {
+    flush_stream(c, h2, stream_id, stream);
+  }
+  if (stream.response_done && stream.request_done) {
+    h2->streams.erase(it);
+  }
+  return true;
+}
+
+bool process_frame(struct connection *c, http2_connection *h2, uint8_t type, uint8_t flags, uint32_t stream_id, const uint8_t *payload, uint32_t len) {
+  if (h2->continuation_stream_id && (type != FRAME_CONTINUATION || stream_id != h2->continuation_stream_id)) {
+    connection_error(c, h2, ERROR_PROTOCOL);
+    return false;
+  }
+
+  switch (type) {
+    case FRAME_DATA:
+      return on_data(c, h2, flags, stream_id, payload, len);
+    case FRAME_HEADERS:
+      return on_headers(c, h2, flags, stream_id, payload, len);
+    case FRAME_CONTINUATION:
+      if (!h2->continuation_stream_id) {
+        connection_error(c, h2, ERROR_PROTOCOL);
+        return false;
+      }
+      return on_continuation(c, h2, flags, stream_id, payload, len);
+    case FRAME_PRIORITY:
+      if (len != 5) {
+        connection_error(c, h2, ERROR_FRAME_SIZE);
+        return false;
+      }
+      return true;
+    case FRAME_RST_STREAM: {
+      if (stream_id == 0 || len != 4) {
+        connection_error(c, h2, stream_id ? ERROR_FRAME_SIZE : ERROR_PROTOCOL);
+        return false;
+      }
+      h2->streams.erase(stream_id);
+      return true;
+    }
+    case FRAME_SETTINGS:
+      return on_settings(c, h2, flags, stream_id, payload, len);
+    case FRAME_PUSH_PROMISE:
+      // clients can't push
+      connection_error(c, h2, ERROR_PROTOCOL);
+      return false;
+    case FRAME_PING:
+      if (stream_id != 0 || len != 8) {
+        connection_error(c, h2, stream_id ? ERROR_PROTOCOL : ERROR_FRAME_SIZE);
+        return false;
+      }
+      if (!(flags & FLAG_ACK)) {
+        write_frame(c, FRAME_PING, FLAG_ACK, 0, payload, len);
+      }
+      return true;
+    case FRAME_GOAWAY:
+      if (stream_id != 0) {
+        connection_error(c, h2, ERROR_PROTOCOL);
+        return false;
+      }
+      vkprintf(1, "http2: connection #%d goaway from the client\n", c->fd);
+      h2->goaway = true;
+      return true;
+    case FRAME_WINDOW_UPDATE:
+      return on_window_update(c, h2, stream_id, payload, len);
+    default:
+      // unknown frames are ignored
+      return true;
+  }
+}
+
+} // namespace
+
+int http2_check_preface (struct connection *c) {
+  char buff[HTTP2_PREFACE_SIZE];
+  nb_iterator_t it;
+  nbit_set (&it, &c->In);
+  const int len = nbit_read_in (&it, buff, HTTP2_PREFACE_SIZE);
+  if (memcmp (buff, http2_preface, len)) {
+    return 0;
+  }
+  return len == HTTP2_PREFACE_SIZE ? 1 : -1;
+}
+
+void http2_start (struct connection *c) {
+  assert (advance_skip_read_ptr (&c->In, HTTP2_PREFACE_SIZE) == HTTP2_PREFACE_SIZE);
+  struct hts_data *D = HTS_DATA(c);
+  auto *h2 = new http2_connection();
+  D->http2 = h2;
+  D->http_ver = HTTP_V20;
+  http2_connections_total++;
+  vkprintf(1, "http2: connection #%d started\n", c->fd);
+
+  const std::pair<uint16_t, uint32_t> settings[] = {
+    {SETTINGS_ENABLE_PUSH, 0},
+    {SETTINGS_MAX_CONCURRENT_STREAMS, MAX_CONCURRENT_STREAMS},
+    // a request body fits into the stream window, so stream windows are never updated
+    {SETTINGS_INITIAL_WINDOW_SIZE, HTTP2_MAX_REQUEST_BODY + 1},
+    {SETTINGS_MAX_HEADER_LIST_SIZE, MAX_HTTP_HEADER_SIZE},
+  };
+  uint8_t payload[sizeof(settings) / sizeof(settings[0]) * 6];
+  uint8_t *ptr = payload;
+  for (const auto &setting : settings) {
+    ptr[0] = static_cast<uint8_t>(setting.first >> 8);
+    ptr[1] = static_cast<uint8_t>(setting.first);
+    put_uint32(ptr + 2, setting.second);
+    ptr += 6;
+  }
+  write_frame(c, FRAME_SETTINGS, 0, 0, payload, sizeof(payload));
+  send_window_update(c, 0, CONNECTION_RECEIVE_WINDOW - DEFAULT_WINDOW);
+}
+
+int http2_parse_execute (struct connection *c) {
+  http2_connection *h2 = get_http2(c);
+  assert (h2);
+
+  while (c->status == conn_expect_query || c->status == conn_reading_query) {
+    if (h2->ready_stream_id) {
+      const uint32_t stream_id = h2->ready_stream_id;
+      h2->ready_stream_id = 0;
+      execute_stream(c, h2, stream_id);
+      continue;
+    }
+    if (h2->goaway && h2->streams.empty()) {
+      c->status = conn_write_close;
+      c->parse_state = -1;
+      break;
+    }
+
+    const int ready_bytes = get_total_ready_bytes (&c->In);
+    int need_bytes = FRAME_HEADER_SIZE;
+    uint8_t header[FRAME_HEADER_SIZE];
+    if (ready_bytes >= FRAME_HEADER_SIZE) {
+      nb_iterator_t it;
+      nbit_set (&it, &c->In);
+      assert (nbit_read_in (&it, header, FRAME_HEADER_SIZE) == FRAME_HEADER_SIZE);
+      const uint32_t len = (header[0] << 16) | (header[1] << 8) | header[2];
+      if (len > MAX_FRAME_SIZE) {
+        connection_error(c, h2, ERROR_FRAME_SIZE);
+        break;
+      }
+      need_bytes += len;
+    }
+    if (ready_bytes < need_bytes) {
+      if (!ready_bytes) {
+        return 0;
+      }
+      // the reader waits for the rest of the frame, the parsing restarts from the connection buffer
+      c->status = conn_expect_query;
+      return need_bytes - ready_bytes;
+    }
+
+    static uint8_t frame[FRAME_HEADER_SIZE + MAX_FRAME_SIZE];
+    assert (read_in (&c->In, frame, need_bytes) == need_bytes);
+    const uint32_t stream_id = read_uint32(frame + 5) & 0x7fffffff;
+    if (!process_frame(c, h2, frame[3], frame[4], stream_id, frame + FRAME_HEADER_SIZE, need_bytes - FRAME_HEADER_SIZE)) {
+      break;
+    }
+  }
+  return 0;
+}
+
+void http2_free (struct connection *c) {
+  struct hts_data *D = HTS_DATA(c);
+  delete static_cast<http2_connection *>(D->http2);
+  D->http2 = nullptr;
+}
+
+int http2_read_query (struct connection *c, void *data, int len) {
+  http2_connection *h2 = get_http2(c);
+  http2_stream *stream = get_active_stream(c);
+  assert (stream);
+  len = std::min(len, static_cast<int>(stream->query.size() - h2->active_read_offset));
+  memcpy (data, stream->query.data() + h2->active_read_offset, len);
+  h2->active_read_offset += len;
+  return len;
+}
+
+int http2_query_ready_bytes (struct connection *c) {
+  http2_stream *stream = get_active_stream(c);
+  return stream ? static_cast<int>(stream->query.size() - get_http2(c)->active_read_offset) : 0;
+}
+
+void http2_finish_query (struct connection *c) {
+  http2_connection *h2 = get_http2(c);
+  if (!h2 || !h2->active_stream_id) {
+    return;
+  }
+  const uint32_t stream_id = h2->active_stream_id;
+  h2->active_stream_id = 0;
+  h2->active_read_offset = 0;
+  auto it = h2->streams.find(stream_id);
+  if (it == h2->streams.end()) {
+    return;
+  }
+  http2_stream &stream = it->second;
+  if (!stream.response_done && !stream.pending_end_stream) {
+    send_rst_stream(c, stream_id, ERROR_INTERNAL);
+    stream.response_done = true;
+  }
+  // otherwise the rest of the response waits for the window updates
+  if (stream.response_done) {
+    h2->streams.erase(it);
+  } else {
+    std::string().swap(stream.query);
+  }
+}
+
+int http2_write_headers (struct connection *c, const char *headers, int len, bool end_stream) {
+  http2_stream *stream = get_active_stream(c);
+  if (!stream || stream->response_done || stream->pending_end_stream) {
+    return 0;
+  }
+  std::string block;
+  encode_response_headers(headers, len, block);
+  send_header_block(c, get_http2(c), get_http2(c)->active_stream_id, block, end_stream);
+  stream->response_done = end_stream;
+  return static_cast<int>(block.size());
+}
+
+int http2_write_data (struct connection *c, const char *data, int len, bool end_stream) {
+  http2_stream *stream = get_active_stream(c);
+  if (!stream || stream->response_done || stream->pending_end_stream) {
+    return 0;
+  }
+  stream->pending.append(data, len);
+  stream->pending_end_stream = end_stream;
+  flush_stream(c, get_http2(c), get_http2(c)->active_stream_id, *stream);
+  return len;
+}
+
+void http2_reset_stream (struct connection *c) {
+  http2_stream *stream = get_active_stream(c);
+  if (!stream || stream->response_done) {
+    return;
+  }
+  send_rst_stream(c, get_http2(c)->active_stream_id, ERROR_INTERNAL);
+  stream->response_done = true;
+  stream->pending.clear();
+  stream->pending_offset = 0;
+}
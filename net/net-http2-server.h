@@ -0,0 +1,42 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#ifndef KDB_NET_NET_HTTP2_SERVER_H
+#define KDB_NET_NET_HTTP2_SERVER_H
+
+#include "net/net-connections.h"
+
+/*
+ *	HTTP/2 without TLS (h2c) with prior knowledge: a client starts the connection with the preface
+ *	instead of a request line. Streams of a connection are served one after another by the worker
+ *	which owns the connection, each stream is given to the execute function as an HTTP/1.1 query,
+ *	and the responses written as HTTP/1.1 text are converted to frames.
+ */
+
+/* a request body of a stream is kept in memory, larger ones are answered with 413 */
+#define HTTP2_MAX_REQUEST_BODY ((1 << 18) - 1)
+
+#define HTTP2_PREFACE_SIZE 24
+
+/* 1 if the connection starts with the preface, 0 if it doesn't, -1 if there are not enough bytes yet */
+int http2_check_preface (struct connection *c);
+/* consumes the preface and switches the connection to http/2 */
+void http2_start (struct connection *c);
+int http2_parse_execute (struct connection *c);
+void http2_free (struct connection *c);
+
+/* the query being executed: its HTTP/1.1 text followed by the body */
+int http2_read_query (struct connection *c, void *data, int len);
+int http2_query_ready_bytes (struct connection *c);
+/* called when the execution of the query is over, resets the stream if the response is incomplete */
+void http2_finish_query (struct connection *c);
+
+/* the response of the query being executed, headers are HTTP/1.1 status line and header lines */
+int http2_write_headers (struct connection *c, const char *headers, int len, bool end_stream);
+int http2_write_data (struct connection *c, const char *data, int len, bool end_stream);
+void http2_reset_stream (struct connection *c);
+
+extern long long http2_connections_total, http2_streams_total, http2_streams_refused;
+
+#endif // KDB_NET_NET_HTTP2_SERVER_H
@@ -0,0 +1,252 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "net/net-io-thread.h"
+
+#include <assert.h>
+#include <atomic>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "common/kprintf.h"
+#include "common/options.h"
+#include "common/stats/provider.h"
+
+#include "net/net-connections.h"
+#include "net/net-events.h"
+#include "net/net-msg-buffers.h"
+#include "net/net-tcp-connections.h"
+
+#define NET_IO_THREAD_MAX_CONNECTIONS 256
+#define NET_IO_THREAD_READ_BUFFER (64 << 10)
+/* the io thread stops reading a connection after that much bytes during one wakeup, to get to the other connections */
+#define NET_IO_THREAD_READ_LIMIT (256 << 10)
+
+static int net_io_thread_flag;
+FLAG_OPTION_PARSER(OPT_NETWORK, "net-io-thread", net_io_thread_flag,
+                   "send and receive the data of the rpc connections of a worker by another thread while the worker runs the script");
+
+struct net_io_thread_conn {
+  struct connection *c;
+  bool write;
+  bool got_input;
+};
+
+static struct {
+  bool started;
+  bool failed;
+  pthread_t thread;
+  int wakeup_fd;
+  /* the connections belong to the io thread while the phase is odd */
+  std::atomic<unsigned> phase;
+  /* the io thread is using the connections right now */
+  std::atomic<bool> busy;
+  /* the io thread is blocked and needs to be woken up to notice the next phase */
+  std::atomic<bool> waiting;
+  int conns_num;
+  net_io_thread_conn conns[NET_IO_THREAD_MAX_CONNECTIONS];
+} IOT;
+
+static std::atomic<long long> net_io_thread_phases, net_io_thread_wakeups, net_io_thread_read_bytes, net_io_thread_written_bytes;
+
+static void net_io_thread_wait_wakeup() {
+  uint64_t value = 0;
+  while (read(IOT.wakeup_fd, &value, sizeof(value)) < 0 && errno == EINTR) {
+  }
+}
+
+static void net_io_thread_process(const struct pollfd *pfd, net_io_thread_conn *C, char *buffer, short *events) {
+  struct connection *c = C->c;
+  if (pfd->revents & (POLLERR | POLLHUP | POLLNVAL)) {
+    // the main thread closes it
+    *events = 0;
+    return;
+  }
+
+  if (pfd->revents & POLLOUT) {
+    net_io_thread_written_bytes.fetch_add(tcp_server_offload_write(c), std::memory_order_relaxed);
+    if (!(c->crypto ? c->out_p.total_bytes : c->out.total_bytes)) {
+      *events &= ~POLLOUT;
+    }
+  }
+
+  if (pfd->revents & POLLIN) {
+    int total = 0;
+    while (total < NET_IO_THREAD_READ_LIMIT) {
+      const long long quota = msg_buffers_connection_quota();
+      if (quota > 0 && static_cast<long long>(c->in.total_bytes) + c->in_u.total_bytes >= quota) {
+        // the main thread fails the connection when it reads it next time
+        *events &= ~POLLIN;
+        break;
+      }
+      int r = tcp_server_offload_read(c, buffer, NET_IO_THREAD_READ_BUFFER);
+      if (r <= 0) {
+        if (!r) {
+          // the end of the stream is noticed by the main thread
+          *events &= ~POLLIN;
+        }
+        break;
+      }
+      total += r;
+      C->got_input = true;
+    }
+    net_io_thread_read_bytes.fetch_add(total, std::memory_order_relaxed);
+  }
+}
+
+static void *net_io_thread_main(void *arg __attribute__((unused))) {
+  msg_buffers_register_thread();
+  char *buffer = static_cast<char *>(malloc(NET_IO_THREAD_READ_BUFFER));
+  assert(buffer);
+
+  static struct pollfd pfds[NET_IO_THREAD_MAX_CONNECTIONS + 1];
+  while (true) {
+    IOT.waiting = true;
+    unsigned phase = IOT.phase.load();
+    if (!(phase & 1)) {
+      net_io_thread_wait_wakeup();
+      IOT.waiting = false;
+      continue;
+    }
+    IOT.waiting = false;
+
+    IOT.busy = true;
+    if (IOT.phase.load() != phase) {
+      IOT.busy = false;
+      continue;
+    }
+    const int n = IOT.conns_num;
+    pfds[0] = {.fd = IOT.wakeup_fd, .events = POLLIN, .revents = 0};
+    for (int i = 0; i < n; i++) {
+      pfds[i + 1] = {.fd = IOT.conns[i].c->fd, .events = static_cast<short>(POLLIN | (IOT.conns[i].write ? POLLOUT : 0)), .revents = 0};
+    }
+    IOT.busy = false;
+    net_io_thread_wakeups.fetch_add(1, std::memory_order_relaxed);
+
+    while (true) {
+      // the main thread wakes the io thread only at the beginning of the next phase
+      IOT.waiting = true;
+      if (IOT.phase.load() != phase) {
+        IOT.waiting = false;
+        break;
+      }
+      int r = poll(pfds, n + 1, -1);
+      IOT.waiting = false;
+      if (pfds[0].revents & POLLIN) {
+        uint64_t value = 0;
+        assert(read(IOT.wakeup_fd, &value, sizeof(value)) == sizeof(value));
+      }
+
+      IOT.busy = true;
+      if (IOT.phase.load() != phase) {
+        IOT.busy = false;
+        break;
+      }
+      for (int i = 1; r > 0 && i <= n; i++) {
+        if (pfds[i].revents) {
+          net_io_thread_process(&pfds[i], &IOT.conns[i - 1], buffer, &pfds[i].events);
+          if (!pfds[i].events) {
+            pfds[i].fd = -1;
+          }
+        }
+      }
+      IOT.busy = false;
+    }
+  }
+  return nullptr;
+}
+
+static bool net_io_thread_start() {
+  IOT.started = true;
+  IOT.wakeup_fd = eventfd(0, EFD_CLOEXEC);
+  if (IOT.wakeup_fd < 0) {
+    kprintf("can't create eventfd for the io thread: %m\n");
+    IOT.failed = true;
+    return false;
+  }
+
+  // the signals are handled by the main thread only
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  const int err = pthread_create(&IOT.thread, nullptr, net_io_thread_main, nullptr);
+  pthread_sigmask(SIG_SETMASK, &old, nullptr);
+  if (err) {
+    kprintf("can't create the io thread: %s\n", strerror(err));
+    IOT.failed = true;
+    return false;
+  }
+  pthread_detach(IOT.thread);
+  return true;
+}
+
+void net_io_thread_begin() {
+  if (!net_io_thread_flag || IOT.failed || (!IOT.started && !net_io_thread_start())) {
+    return;
+  }
+  assert(!(IOT.phase.load(std::memory_order_relaxed) & 1));
+
+  int n = 0;
+  for (int fd = 0; fd <= max_connection && n < NET_IO_THREAD_MAX_CONNECTIONS; fd++) {
+    struct connection *c = &Connections[fd];
+    if (c->fd != fd || c->basic_type == ct_none || !tcp_server_can_offload(c)) {
+      continue;
+    }
+    net_io_thread_conn *C = &IOT.conns[n++];
+    C->c = c;
+    C->write = !c->limit_per_write && (c->out.total_bytes + c->out_p.total_bytes > 0);
+    C->got_input = false;
+  }
+  IOT.conns_num = n;
+  if (!n) {
+    return;
+  }
+
+  IOT.phase++;
+  net_io_thread_phases.fetch_add(1, std::memory_order_relaxed);
+  if (IOT.waiting.load()) {
+    uint64_t value = 1;
+    assert(write(IOT.wakeup_fd, &value, sizeof(value)) == sizeof(value));
+  }
+}
+
+void net_io_thread_end() {
+  if (!(IOT.phase.load(std::memory_order_relaxed) & 1)) {
+    return;
+  }
+  IOT.phase++;
+  while (IOT.busy.load()) {
+    // the io thread finishes the work with the current connection
+#if defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+  }
+
+  for (int i = 0; i < IOT.conns_num; i++) {
+    net_io_thread_conn *C = &IOT.conns[i];
+    if (C->got_input) {
+      // the socket may be drained already, so the reader has to be run without waiting for epoll
+      struct connection *c = C->c;
+      c->flags &= ~C_NORD;
+      put_event_into_heap(c->ev);
+    }
+  }
+}
+
+STATS_PROVIDER(net_io_thread, 1000) {
+  if (!net_io_thread_flag) {
+    return;
+  }
+  add_general_stat(stats, "net_io_thread_phases", "%lld", net_io_thread_phases.load());
+  add_general_stat(stats, "net_io_thread_wakeups", "%lld", net_io_thread_wakeups.load());
+  add_general_stat(stats, "net_io_thread_read_bytes", "%lld", net_io_thread_read_bytes.load());
+  add_general_stat(stats, "net_io_thread_written_bytes", "%lld", net_io_thread_written_bytes.load());
+}
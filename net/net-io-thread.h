@@ -0,0 +1,21 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#ifndef KDB_NET_NET_IO_THREAD_H
+#define KDB_NET_NET_IO_THREAD_H
+
+/*
+ *	Optional network thread of a worker. While the main thread runs the script code between the queries,
+ *	it doesn't touch the connections, so the tcp rpc connections are handed over to the io thread for that time:
+ *	the io thread sends the queued output (encrypting it) and reads and decrypts the input, which arrives meanwhile.
+ *	The input is parsed by the main thread, the connections which got some input are put into the event heap
+ *	when the main thread takes them back.
+ */
+
+/* hands the connections over to the io thread, the main thread mustn't touch them until net_io_thread_end() */
+void net_io_thread_begin();
+/* waits till the io thread leaves the connections */
+void net_io_thread_end();
+
+#endif // KDB_NET_NET_IO_THREAD_H
@@ -30,10 +30,28 @@ PARALLEL_COUNTER(total_used_buffers_size);
 PARALLEL_MAXIMUM(max_total_used_buffers_size);
 PARALLEL_LIMIT_COUNTER(allocated_buffer_bytes);
 
+PARALLEL_COUNTER(buffer_alloc_failures);
+PARALLEL_COUNTER(buffer_pressure_events);
+PARALLEL_COUNTER(connection_quota_exceeded);
+
 static long long allocated_buffer_bytes_limit = MSG_DEFAULT_MAX_ALLOCATED_BYTES;
+static long long connection_buffers_quota;
 
 static int buffer_size_values;
 
+#define BUFFER_SIZE_NUM 5
+static const int default_buffer_sizes[BUFFER_SIZE_NUM] = {48, 512, 2048, 16384, 262144};
+static lockfree_slab_cache_t slab_caches[BUFFER_SIZE_NUM];
+static __thread lockfree_slab_cache_tls_t slab_caches_tls[BUFFER_SIZE_NUM];
+
+// per size class: allocations, allocations which needed a new slab block and buffers in use
+static parallel_counter_t size_class_allocs[BUFFER_SIZE_NUM];
+static __thread parallel_counter_tls_t size_class_allocs_tls[BUFFER_SIZE_NUM];
+static parallel_counter_t size_class_misses[BUFFER_SIZE_NUM];
+static __thread parallel_counter_tls_t size_class_misses_tls[BUFFER_SIZE_NUM];
+static parallel_counter_t size_class_used[BUFFER_SIZE_NUM];
+static __thread parallel_counter_tls_t size_class_used_tls[BUFFER_SIZE_NUM];
+
 OPTION_PARSER(OPT_NETWORK, "msg-buffers-size", required_argument, "memory for udp/new tcp/binlog buffers (default %lld megabytes)",
               allocated_buffer_bytes_limit >> 20) {
   allocated_buffer_bytes_limit = parse_memory_limit(optarg);
@@ -41,6 +59,12 @@ OPTION_PARSER(OPT_NETWORK, "msg-buffers-size", required_argument, "memory for ud
   return 0;
 }
 
+OPTION_PARSER(OPT_NETWORK, "msg-buffers-connection-quota", required_argument,
+              "maximal size of the data buffered for one tcp connection, the connection is closed when it is exceeded (default: unlimited)") {
+  connection_buffers_quota = parse_memory_limit(optarg);
+  return connection_buffers_quota >= 0 ? 0 : -1;
+}
+
 STATS_PROVIDER(msg_buffers, 1000) {
   add_histogram_stat_long(stats, "allocated_buffer_bytes", PARALLEL_LIMIT_COUNTER_READ(allocated_buffer_bytes));
   add_histogram_stat_long(stats, "buffer_chunk_allocations", PARALLEL_COUNTER_READ(buffer_slab_alloc_ops));
@@ -48,9 +72,27 @@ STATS_PROVIDER(msg_buffers, 1000) {
   add_histogram_stat_long(stats, "max_total_used_buffers_size", PARALLEL_MAXIMUM_READ(max_total_used_buffers_size));
   add_histogram_stat_long(stats, "total_used_buffers", PARALLEL_COUNTER_READ(total_used_buffers));
   add_histogram_stat_long(stats, "total_used_buffers_size", PARALLEL_COUNTER_READ(total_used_buffers_size));
+  add_histogram_stat_long(stats, "buffer_alloc_failures", PARALLEL_COUNTER_READ(buffer_alloc_failures));
+  add_histogram_stat_long(stats, "buffer_pressure_events", PARALLEL_COUNTER_READ(buffer_pressure_events));
+  add_histogram_stat_long(stats, "connection_buffers_quota", connection_buffers_quota);
+  add_histogram_stat_long(stats, "connection_quota_exceeded", PARALLEL_COUNTER_READ(connection_quota_exceeded));
+  for (int i = 0; i < BUFFER_SIZE_NUM; ++i) {
+    const uint64_t allocs = parallel_counter_read(&size_class_allocs[i]);
+    const uint64_t misses = parallel_counter_read(&size_class_misses[i]);
+    char key[64];
+    snprintf(key, sizeof(key), "buffers_%d.allocs", default_buffer_sizes[i]);
+    add_histogram_stat_long(stats, key, allocs);
+    snprintf(key, sizeof(key), "buffers_%d.slab_hits", default_buffer_sizes[i]);
+    add_histogram_stat_long(stats, key, allocs - misses);
+    snprintf(key, sizeof(key), "buffers_%d.slab_misses", default_buffer_sizes[i]);
+    add_histogram_stat_long(stats, key, misses);
+    snprintf(key, sizeof(key), "buffers_%d.used", default_buffer_sizes[i]);
+    add_histogram_stat_long(stats, key, parallel_counter_read(&size_class_used[i]));
+  }
 }
 
 void decrease_msg_buffers_size(int factor) {
+  PARALLEL_COUNTER_INC(buffer_pressure_events);
   allocated_buffer_bytes_limit = (allocated_buffer_bytes_limit + factor - 1) / factor;
 }
 
@@ -62,14 +104,22 @@ int is_under_network_pressure() {
   return PARALLEL_LIMIT_COUNTER_READ_APPROX(allocated_buffer_bytes) * 4LL > allocated_buffer_bytes_limit * 3LL;
 }
 
+long long msg_buffers_connection_quota() {
+  return connection_buffers_quota;
+}
+
+bool msg_buffers_check_connection_quota(long long buffered_bytes) {
+  if (connection_buffers_quota <= 0 || buffered_bytes <= connection_buffers_quota) {
+    return true;
+  }
+  PARALLEL_COUNTER_INC(connection_quota_exceeded);
+  return false;
+}
+
 bool is_allocated_buffers_overflow() {
   return PARALLEL_LIMIT_COUNTER_READ_APPROX(allocated_buffer_bytes) * 3LL > allocated_buffer_bytes_limit * 2LL;
 }
 
-#define BUFFER_SIZE_NUM 5
-static const int default_buffer_sizes[BUFFER_SIZE_NUM] = {48, 512, 2048, 16384, 262144};
-static lockfree_slab_cache_t slab_caches[BUFFER_SIZE_NUM];
-static __thread lockfree_slab_cache_tls_t slab_caches_tls[BUFFER_SIZE_NUM];
 
 static void msg_buffers_constructor() __attribute__((constructor));
 static void msg_buffers_constructor() {
@@ -94,6 +144,14 @@ void msg_buffers_register_thread() {
   PARALLEL_COUNTER_REGISTER_THREAD(buffer_slab_alloc_ops);
   PARALLEL_COUNTER_REGISTER_THREAD(total_used_buffers);
   PARALLEL_COUNTER_REGISTER_THREAD(total_used_buffers_size);
+  PARALLEL_COUNTER_REGISTER_THREAD(buffer_alloc_failures);
+  PARALLEL_COUNTER_REGISTER_THREAD(buffer_pressure_events);
+  PARALLEL_COUNTER_REGISTER_THREAD(connection_quota_exceeded);
+  for (int i = 0; i < BUFFER_SIZE_NUM; ++i) {
+    parallel_counter_register_thread(&size_class_allocs[i], &size_class_allocs_tls[i]);
+    parallel_counter_register_thread(&size_class_misses[i], &size_class_misses_tls[i]);
+    parallel_counter_register_thread(&size_class_used[i], &size_class_used_tls[i]);
+  }
   PARALLEL_MAXIMUM_REGISTER_THREAD(max_total_used_buffers_size);
   PARALLEL_LIMIT_COUNTER_REGISTER_THREAD(allocated_buffer_bytes);
   init_msg();
@@ -108,6 +166,14 @@ void preallocate_msg_buffers() {
   }
 }
 
+int msg_buffer_fit_size(int bytes) {
+  int si = BUFFER_SIZE_NUM - 1;
+  while (si > 0 && default_buffer_sizes[si] > bytes) {
+    si--;
+  }
+  return default_buffer_sizes[si];
+}
+
 /* allocates buffer of at least given size, -1 = maximal */
 msg_buffer_t *alloc_msg_buffer(int size_hint) {
   preallocate_msg_buffers();
@@ -122,6 +188,7 @@ msg_buffer_t *alloc_msg_buffer(int size_hint) {
   lockfree_slab_cache_tls_t *cache_tls = &slab_caches_tls[si];
 
   if (!PARALLEL_LIMIT_COUNTER_ADD(allocated_buffer_bytes, cache->object_size)) {
+    PARALLEL_COUNTER_INC(buffer_alloc_failures);
     return NULL;
   }
 
@@ -129,6 +196,11 @@ msg_buffer_t *alloc_msg_buffer(int size_hint) {
   msg_buffer_t *buffer = static_cast<msg_buffer_t *>(lockfree_slab_cache_alloc(cache_tls));
   const unsigned delta = lockfree_slab_cache_count_used_blocks(cache_tls) - blocks_before;
   PARALLEL_COUNTER_ADD(buffer_slab_alloc_ops, delta);
+  parallel_counter_inc(&size_class_allocs_tls[si]);
+  parallel_counter_inc(&size_class_used_tls[si]);
+  if (delta) {
+    parallel_counter_inc(&size_class_misses_tls[si]);
+  }
 
   buffer->cache_tls = cache_tls;
   buffer->refcnt = 1;
@@ -150,6 +222,7 @@ void free_msg_buffer(msg_buffer_t *buffer) {
   PARALLEL_COUNTER_SUB(total_used_buffers_size, cache->object_size);
   PARALLEL_MAXIMUM_SUB(max_total_used_buffers_size, cache->object_size);
   PARALLEL_LIMIT_COUNTER_SUB(allocated_buffer_bytes, cache->object_size);
+  parallel_counter_dec(&size_class_used_tls[cache - slab_caches]);
 
   const unsigned blocks_before = lockfree_slab_cache_count_used_blocks(cache_tls);
   lockfree_slab_cache_free(cache_tls, buffer);
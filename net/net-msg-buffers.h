@@ -35,6 +35,8 @@ void msg_buffers_register_thread();
 void preallocate_msg_buffers();
 
 msg_buffer_t *alloc_msg_buffer(int size_hint);
+/* the largest buffer size which is not greater than bytes, or the smallest one */
+int msg_buffer_fit_size(int bytes);
 
 void free_msg_buffer(msg_buffer_t *buffer);
 
@@ -43,6 +45,11 @@ long long max_allocated_buffer_bytes();
 int is_under_network_pressure();
 bool is_allocated_buffers_overflow();
 
+/* 0 = unlimited */
+long long msg_buffers_connection_quota();
+/* returns false and counts the event if a connection which buffers so much bytes exceeds the quota */
+bool msg_buffers_check_connection_quota(long long buffered_bytes);
+
 static inline void msg_buffer_inc_ref(msg_buffer_t *buffer) {
   ++buffer->refcnt;
 }
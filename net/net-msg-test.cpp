@@ -8,6 +8,7 @@
 #include <cstring>
 #include <gtest/gtest.h>
 #include <numeric>
+#include <vector>
 
 #include "net/net-msg.h"
 
@@ -656,3 +657,26 @@ TEST(net_msg, rwm_union_large) {
 
   rwm_free(&rwms[0]);
 }
+
+TEST(net_msg, rwm_push_data_large) {
+  raw_message_t rwm;
+  rwm_init(&rwm, 0);
+
+  std::vector<std::uint8_t> payload(100000);
+  std::iota(payload.begin(), payload.end(), 0);
+  rwm_push_data(&rwm, payload.data(), payload.size());
+  EXPECT_EQ(rwm.total_bytes, payload.size());
+
+  int parts = 0;
+  for (const msg_part_t *mp = rwm.first; mp; mp = mp->next) {
+    parts++;
+  }
+  // not 49 parts of 2048 bytes
+  EXPECT_LE(parts, 10);
+
+  std::vector<std::uint8_t> fetched(payload.size());
+  rwm_fetch_data(&rwm, fetched.data(), fetched.size());
+  EXPECT_EQ(payload, fetched);
+
+  rwm_free(&rwm);
+}
@@ -150,7 +150,8 @@ int rwm_push_data_ext(raw_message_t *raw, const void *data, int alloc_bytes, int
   msg_part_t *mp, *mpl;
   int res = 0;
   if (!raw->first) {
-    msg_buffer_t *buffer = alloc_msg_buffer(alloc_bytes >= small_buffer - prepend ? std_buffer : small_buffer);
+    // a long message is placed into the buffers as large as possible, so that it is not split into many parts
+    msg_buffer_t *buffer = alloc_msg_buffer(alloc_bytes >= small_buffer - prepend ? std::max(std_buffer, msg_buffer_fit_size(alloc_bytes + prepend)) : small_buffer);
     if (!buffer) {
       return 0;
     }
@@ -205,7 +206,7 @@ int rwm_push_data_ext(raw_message_t *raw, const void *data, int alloc_bytes, int
   }
   while (alloc_bytes > 0) {
     mpl = mp;
-    msg_buffer_t *buffer = alloc_msg_buffer(raw->total_bytes + alloc_bytes >= std_buffer ? std_buffer : small_buffer);
+    msg_buffer_t *buffer = alloc_msg_buffer(raw->total_bytes + alloc_bytes >= std_buffer ? std::max(std_buffer, msg_buffer_fit_size(alloc_bytes)) : small_buffer);
     if (!buffer) {
       return res;
     }
@@ -1004,7 +1005,7 @@ static int rwm_process_encrypt_decrypt(void *extra, const void *data, int len) {
   rwm_encrypt_decrypt_tmp *x = static_cast<rwm_encrypt_decrypt_tmp*>(extra);
   raw_message_t *res = x->raw;
   if (!x->buf_left) {
-    msg_buffer_t *X = alloc_msg_buffer(x->left >= MSG_STD_BUFFER ? MSG_STD_BUFFER : x->left);
+    msg_buffer_t *X = alloc_msg_buffer(x->left >= MSG_STD_BUFFER ? msg_buffer_fit_size(x->left) : x->left);
     assert(X);
     msg_part_t *mp = new_msg_part(X);
     res->last->next = mp;
@@ -1038,7 +1039,7 @@ static int rwm_process_encrypt_decrypt(void *extra, const void *data, int len) {
   }
   while (true) {
     if (!x->buf_left) {
-      msg_buffer_t *X = alloc_msg_buffer(x->left + len >= MSG_STD_BUFFER ? MSG_STD_BUFFER : x->left + len);
+      msg_buffer_t *X = alloc_msg_buffer(x->left + len >= MSG_STD_BUFFER ? msg_buffer_fit_size(x->left + len) : x->left + len);
       assert(X);
       msg_part_t *mp = new_msg_part(X);
       res->last->next = mp;
@@ -1082,7 +1083,7 @@ int rwm_encrypt_decrypt_to(raw_message_t *raw, raw_message_t *res, int bytes, st
   }
   if (!res->last || msg_buffer_use_count(res->last->buffer) != 1) {
     int l = res->last ? bytes : bytes + RM_PREPEND_RESERVE;
-    msg_buffer_t *X = alloc_msg_buffer(l >= MSG_STD_BUFFER ? MSG_STD_BUFFER : l);
+    msg_buffer_t *X = alloc_msg_buffer(l >= MSG_STD_BUFFER ? msg_buffer_fit_size(l) : l);
     assert(X);
     msg_part_t *mp = new_msg_part(X);
     if (res->last) {
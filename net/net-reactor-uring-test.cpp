@@ -0,0 +1,46 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "net/net-reactor-uring.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+// the kernel or the sandbox of the tests may have no io_uring, there is nothing to check then
+TEST(net_reactor_uring, poll) {
+  net_reactor_uring_t *uring = net_reactor_uring_create(1024);
+  if (uring == nullptr) {
+    return;
+  }
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  epoll_event events[16];
+
+  net_reactor_uring_update(uring, sv[0], EPOLLIN | EPOLLERR | EPOLLET, false);
+  EXPECT_EQ(net_reactor_uring_wait(uring, events, 16, 10), 0);
+
+  ASSERT_EQ(write(sv[1], "a", 1), 1);
+  ASSERT_EQ(net_reactor_uring_wait(uring, events, 16, 1000), 1);
+  EXPECT_EQ(events[0].data.fd, sv[0]);
+  EXPECT_TRUE(events[0].events & EPOLLIN);
+  // edge triggered: the data which is still there is reported once
+  EXPECT_EQ(net_reactor_uring_wait(uring, events, 16, 10), 0);
+
+  // level triggered: the readiness is reported by each wait
+  net_reactor_uring_update(uring, sv[0], EPOLLIN | EPOLLERR, true);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(net_reactor_uring_wait(uring, events, 16, 1000), 1);
+    EXPECT_EQ(events[0].data.fd, sv[0]);
+  }
+
+  net_reactor_uring_update(uring, sv[0], 0, false);
+  ASSERT_EQ(write(sv[1], "b", 1), 1);
+  EXPECT_EQ(net_reactor_uring_wait(uring, events, 16, 10), 0);
+
+  close(sv[0]);
+  close(sv[1]);
+  net_reactor_uring_destroy(uring);
+}
@@ -0,0 +1,281 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "net/net-reactor-uring.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common/kprintf.h"
+
+#include "net/net-events.h"
+
+/* the queue is flushed when it is full, so its size only limits the batch */
+static const unsigned URING_SQ_ENTRIES = 4096;
+static const unsigned URING_CQ_ENTRIES = 4 * URING_SQ_ENTRIES;
+
+/* user_data of the removal requests, their completions are not interesting */
+static const uint64_t URING_REMOVE_TAG = ~0ULL;
+
+struct net_reactor_uring {
+  int fd;
+  int max_events;
+
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned sq_mask;
+  unsigned *sq_array;
+  struct io_uring_sqe *sqes;
+  unsigned sq_local_tail;
+  unsigned to_submit;
+
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned cq_mask;
+  struct io_uring_cqe *cqes;
+
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  size_t sqes_size;
+
+  /* the poll of a descriptor is identified by the descriptor and the generation, */
+  /* completions of the polls which are already replaced are skipped */
+  unsigned *generations;
+  unsigned *armed_events;
+  bool *armed_level;
+};
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t arg_size) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+static uint64_t uring_user_data(int fd, unsigned generation) {
+  return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+static void uring_unmap(net_reactor_uring_t *uring) {
+  if (uring->sqes != nullptr && uring->sqes != MAP_FAILED) {
+    munmap(uring->sqes, uring->sqes_size);
+  }
+  if (uring->cq_ring != nullptr && uring->cq_ring != MAP_FAILED && uring->cq_ring != uring->sq_ring) {
+    munmap(uring->cq_ring, uring->cq_ring_size);
+  }
+  if (uring->sq_ring != nullptr && uring->sq_ring != MAP_FAILED) {
+    munmap(uring->sq_ring, uring->sq_ring_size);
+  }
+}
+
+net_reactor_uring_t *net_reactor_uring_create(int max_events) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = URING_CQ_ENTRIES;
+
+  const int fd = sys_io_uring_setup(URING_SQ_ENTRIES, &params);
+  if (fd < 0) {
+    tvkprintf(net_events, 0, "io_uring_setup(): %m\n");
+    return nullptr;
+  }
+  // the timeout of the wait, the lost completions and the multishot polls are essential
+  const unsigned required_features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+  if ((params.features & required_features) != required_features) {
+    tvkprintf(net_events, 0, "io_uring of the kernel misses features 0x%08x\n", required_features & ~params.features);
+    close(fd);
+    return nullptr;
+  }
+
+  auto *uring = static_cast<net_reactor_uring_t *>(calloc(1, sizeof(net_reactor_uring_t)));
+  assert(uring);
+  uring->fd = fd;
+  uring->max_events = max_events;
+
+  uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (uring->cq_ring_size > uring->sq_ring_size) {
+    uring->sq_ring_size = uring->cq_ring_size;
+  }
+  uring->sq_ring = mmap(nullptr, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  uring->cq_ring = uring->sq_ring;
+  uring->cq_ring_size = uring->sq_ring_size;
+  uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  uring->sqes = static_cast<struct io_uring_sqe *>(mmap(nullptr, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+  if (uring->sq_ring == MAP_FAILED || uring->sqes == MAP_FAILED) {
+    tvkprintf(net_events, 0, "mmap() of io_uring: %m\n");
+    uring_unmap(uring);
+    close(fd);
+    free(uring);
+    return nullptr;
+  }
+
+  auto *sq = static_cast<char *>(uring->sq_ring);
+  uring->sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  uring->sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  uring->sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  uring->sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  uring->sq_local_tail = *uring->sq_tail;
+
+  auto *cq = static_cast<char *>(uring->cq_ring);
+  uring->cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  uring->cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  uring->cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  uring->cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+  uring->generations = static_cast<unsigned *>(calloc(max_events, sizeof(uring->generations[0])));
+  uring->armed_events = static_cast<unsigned *>(calloc(max_events, sizeof(uring->armed_events[0])));
+  uring->armed_level = static_cast<bool *>(calloc(max_events, sizeof(uring->armed_level[0])));
+  assert(uring->generations && uring->armed_events && uring->armed_level);
+
+  tvkprintf(net_events, 1, "io_uring reactor is created: %u submission entries, %u completion entries\n", params.sq_entries, params.cq_entries);
+  return uring;
+}
+
+void net_reactor_uring_destroy(net_reactor_uring_t *uring) {
+  if (uring == nullptr) {
+    return;
+  }
+  uring_unmap(uring);
+  close(uring->fd);
+  free(uring->generations);
+  free(uring->armed_events);
+  free(uring->armed_level);
+  free(uring);
+}
+
+int net_reactor_uring_fd(const net_reactor_uring_t *uring) {
+  return uring->fd;
+}
+
+static int uring_submit(net_reactor_uring_t *uring, unsigned min_complete, unsigned flags, void *arg, size_t arg_size) {
+  __atomic_store_n(uring->sq_tail, uring->sq_local_tail, __ATOMIC_RELEASE);
+  int r = sys_io_uring_enter(uring->fd, uring->to_submit, min_complete, flags, arg, arg_size);
+  if (r >= 0) {
+    assert(static_cast<unsigned>(r) <= uring->to_submit);
+    uring->to_submit -= r;
+  }
+  return r;
+}
+
+static struct io_uring_sqe *uring_get_sqe(net_reactor_uring_t *uring) {
+  unsigned head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+  while (uring->sq_local_tail - head > uring->sq_mask) {
+    // the queue is full, the batch is submitted earlier than the wait
+    if (uring_submit(uring, 0, 0, nullptr, 0) < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+      tvkprintf(net_events, 0, "io_uring_enter(): %m\n");
+      assert(0);
+    }
+    head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+  }
+  const unsigned index = uring->sq_local_tail & uring->sq_mask;
+  struct io_uring_sqe *sqe = &uring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  uring->sq_array[index] = index;
+  uring->sq_local_tail++;
+  uring->to_submit++;
+  return sqe;
+}
+
+static void uring_arm(net_reactor_uring_t *uring, int fd, unsigned events, bool level) {
+  struct io_uring_sqe *sqe = uring_get_sqe(uring);
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = events;
+  // a level triggered descriptor is polled once per completion: a new poll reports the readiness which is still there
+  sqe->len = level ? 0 : IORING_POLL_ADD_MULTI;
+  sqe->user_data = uring_user_data(fd, ++uring->generations[fd]);
+  uring->armed_events[fd] = events;
+  uring->armed_level[fd] = level;
+}
+
+static void uring_disarm(net_reactor_uring_t *uring, int fd) {
+  struct io_uring_sqe *sqe = uring_get_sqe(uring);
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = uring_user_data(fd, uring->generations[fd]);
+  sqe->user_data = URING_REMOVE_TAG;
+  // the completions of the removed poll which are already in the ring are skipped by the generation
+  ++uring->generations[fd];
+  uring->armed_events[fd] = 0;
+}
+
+void net_reactor_uring_update(net_reactor_uring_t *uring, int fd, unsigned events, bool level) {
+  assert(0 <= fd && fd < uring->max_events);
+  // the flags of epoll which mean nothing for poll
+  events &= ~(EPOLLET | EPOLLEXCLUSIVE | EPOLLONESHOT);
+  if (uring->armed_events[fd] == events && uring->armed_level[fd] == level) {
+    return;
+  }
+  if (uring->armed_events[fd]) {
+    uring_disarm(uring, fd);
+  }
+  if (events) {
+    uring_arm(uring, fd, events, level);
+  }
+}
+
+int net_reactor_uring_wait(net_reactor_uring_t *uring, struct epoll_event *events, int max_events, int timeout) {
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  if (timeout >= 0) {
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000LL;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+  }
+
+  unsigned cq_head = *uring->cq_head;
+  const bool has_completions = cq_head != __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+  if (has_completions || timeout == 0) {
+    // only the submission, GETEVENTS flushes the completions which have overflown the ring
+    if (uring_submit(uring, 0, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)) < 0 && errno != ETIME && errno != EBUSY) {
+      return -1;
+    }
+  } else if (uring_submit(uring, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)) < 0 && errno != ETIME && errno != EBUSY) {
+    return -1;
+  }
+
+  int result = 0;
+  const unsigned cq_tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+  for (; cq_head != cq_tail && result < max_events; ++cq_head) {
+    const struct io_uring_cqe *cqe = &uring->cqes[cq_head & uring->cq_mask];
+    if (cqe->user_data == URING_REMOVE_TAG) {
+      continue;
+    }
+    const int fd = static_cast<int>(cqe->user_data & 0xffffffff);
+    const auto generation = static_cast<unsigned>(cqe->user_data >> 32);
+    assert(0 <= fd && fd < uring->max_events);
+    if (generation != uring->generations[fd]) {
+      continue;
+    }
+    const bool is_over = !(cqe->flags & IORING_CQE_F_MORE);
+    if (cqe->res < 0) {
+      if (cqe->res != -ECANCELED) {
+        tvkprintf(net_events, 1, "io_uring poll of %d: %s\n", fd, strerror(-cqe->res));
+      }
+      uring->armed_events[fd] = 0;
+      continue;
+    }
+    events[result].events = static_cast<unsigned>(cqe->res);
+    events[result].data.fd = fd;
+    ++result;
+    if (is_over) {
+      // the poll is over (it is a level triggered one or the kernel has stopped the multishot poll), the interest is still there
+      uring_arm(uring, fd, uring->armed_events[fd], uring->armed_level[fd]);
+    }
+  }
+  __atomic_store_n(uring->cq_head, cq_head, __ATOMIC_RELEASE);
+  return result;
+}
@@ -0,0 +1,30 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#ifndef KDB_NET_NET_REACTOR_URING_H
+#define KDB_NET_NET_REACTOR_URING_H
+
+#include <sys/epoll.h>
+
+/*
+ *	io_uring backend of the reactor: the interest of a descriptor is a multishot poll request,
+ *	the changes of the interest are queued in the submission ring during the iteration of the loop
+ *	and are submitted together with the wait for the completions by one io_uring_enter call,
+ *	while epoll needs an epoll_ctl call for each change and epoll_wait for the wait.
+ *	The completions are returned in the same form as epoll_wait returns them.
+ */
+
+typedef struct net_reactor_uring net_reactor_uring_t;
+
+/* returns NULL if io_uring or a feature which is needed is not supported by the kernel */
+net_reactor_uring_t *net_reactor_uring_create(int max_events);
+void net_reactor_uring_destroy(net_reactor_uring_t *uring);
+int net_reactor_uring_fd(const net_reactor_uring_t *uring);
+
+/* events are epoll flags, 0 removes the descriptor, level is EVT_LEVEL */
+void net_reactor_uring_update(net_reactor_uring_t *uring, int fd, unsigned events, bool level);
+/* submits the queued changes and waits for the completions, timeout in ms, as epoll_wait */
+int net_reactor_uring_wait(net_reactor_uring_t *uring, struct epoll_event *events, int max_events, int timeout);
+
+#endif // KDB_NET_NET_REACTOR_URING_H
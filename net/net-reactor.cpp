@@ -19,12 +19,16 @@
 #include "common/server/signals.h"
 
 #include "net/net-msg-buffers.h"
+#include "net/net-reactor-uring.h"
 #include "net/time-slice.h"
+#include "net/timer-wheel.h"
 
 DEFINE_VERBOSITY(net_events);
 
 static int epoll_sleep_time;
 static const double max_time_slice = 0.05;
+// the timers which expire sooner are kept in the heap, the wheel would be late for them for up to its tick
+static const double EXACT_TIMER_TIMEOUT = 0.001;
 
 OPTION_PARSER(OPT_NETWORK, "epoll-sleep-time", required_argument, "sleep time in main cycle, set in microseconds (between 1mcs and 0.5s), experimental") {
   epoll_sleep_time = atoi(optarg);
@@ -32,6 +36,25 @@ OPTION_PARSER(OPT_NETWORK, "epoll-sleep-time", required_argument, "sleep time in
   return 0;
 }
 
+static int busy_poll_time;
+
+OPTION_PARSER(OPT_NETWORK, "busy-poll", required_argument, "spin on network events for the given time in microseconds (up to 1000) before sleeping while a script waits for a network answer, experimental") {
+  busy_poll_time = atoi(optarg);
+  assert(0 < busy_poll_time && busy_poll_time <= 1000);
+  return 0;
+}
+
+int net_reactor_busy_poll_time() {
+  return busy_poll_time;
+}
+
+static bool use_io_uring;
+
+OPTION_PARSER(OPT_NETWORK, "io-uring", no_argument, "wait for network events with io_uring instead of epoll, epoll is used if the kernel doesn't support it, experimental") {
+  use_io_uring = true;
+  return 0;
+}
+
 void net_reactor_alloc(net_reactor_ctx_t *ctx, int max_events, int max_timers) {
   ctx->max_events = max_events;
   ctx->max_timers = max_timers;
@@ -43,6 +66,7 @@ void net_reactor_alloc(net_reactor_ctx_t *ctx, int max_events, int max_timers) {
   ctx->events = static_cast<event_t*>(calloc(max_events, sizeof(ctx->events[0])));
   ctx->event_heap = static_cast<event_t**>(calloc(max_events + 1, sizeof(ctx->event_heap[0])));
   ctx->timer_heap = static_cast<event_timer_t**>(calloc(max_timers + 1, sizeof(ctx->timer_heap[0])));
+  ctx->timer_wheel = new vk::net::TimerWheel();
   ctx->epoll_events = static_cast<epoll_event*>(calloc(max_events, sizeof(ctx->epoll_events[0])));
   ctx->pre_runqueue = ctx->post_runqueue = ctx->pre_event = NULL;
   ctx->wait_start = 0;
@@ -50,16 +74,32 @@ void net_reactor_alloc(net_reactor_ctx_t *ctx, int max_events, int max_timers) {
   ctx->total_idle_time = 0;
   ctx->average_idle_time = 0;
   ctx->average_idle_quotient = 0;
+  ctx->uring = NULL;
+  ctx->busy_poll = false;
+  ctx->total_spin_time = 0;
+  ctx->spin_wakeups = 0;
+  ctx->spin_sleeps = 0;
 }
 
 void net_reactor_free(net_reactor_ctx_t *ctx) {
   free(ctx->events);
   free(ctx->event_heap);
   free(ctx->timer_heap);
+  delete ctx->timer_wheel;
+  ctx->timer_wheel = NULL;
   free(ctx->epoll_events);
 }
 
 bool net_reactor_init(net_reactor_ctx_t *ctx) {
+  if (use_io_uring) {
+    ctx->uring = net_reactor_uring_create(ctx->max_events);
+    if (ctx->uring) {
+      ctx->epoll_fd = net_reactor_uring_fd(ctx->uring);
+      return true;
+    }
+    tvkprintf(net_events, 0, "io_uring is not available, epoll is used\n");
+  }
+
   ctx->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
   if (ctx->epoll_fd >= 0) {
     return true;
@@ -82,6 +122,11 @@ bool net_reactor_create(net_reactor_ctx_t *ctx, int max_events, int max_timers)
 }
 
 void net_reactor_destroy(net_reactor_ctx_t *ctx) {
+  if (ctx->uring) {
+    net_reactor_uring_destroy(ctx->uring);
+    ctx->uring = NULL;
+    return;
+  }
   close(ctx->epoll_fd);
 }
 
@@ -181,6 +226,10 @@ void net_reactor_clear_event(net_reactor_ctx_t *ctx, int fd) {
   if (event->in_queue) {
     net_reactor_remove_event_from_heap(ctx, event, false);
   }
+  if (ctx->uring && event->fd == fd && (event->state & EVT_IN_EPOLL)) {
+    // a poll request holds the file, it is not closed while the request is there
+    net_reactor_uring_update(ctx->uring, fd, 0, false);
+  }
   memset(event, 0, sizeof(*event));
 }
 
@@ -262,10 +311,32 @@ static int epoll_unconv_flags(int f) {
   return r;
 }
 
-int net_reactor_wait(net_reactor_ctx_t *ctx, int timeout) {
+static int net_reactor_poll(net_reactor_ctx_t *ctx, int timeout) {
+  if (ctx->uring) {
+    return net_reactor_uring_wait(ctx->uring, ctx->epoll_events, ctx->max_events, timeout);
+  }
   return epoll_wait(ctx->epoll_fd, ctx->epoll_events, ctx->max_events, timeout);
 }
 
+int net_reactor_wait(net_reactor_ctx_t *ctx, int timeout) {
+  if (busy_poll_time && ctx->busy_poll && timeout != 0) {
+    // an answer which comes during the spin is handled without the wakeup latency of the sleep
+    const double spin_start = get_network_time();
+    const vk::net::TimeSlice spin_slice(busy_poll_time * 1e-6);
+    int events = 0;
+    do {
+      events = net_reactor_poll(ctx, 0);
+    } while (events == 0 && !spin_slice.expired() && !pending_signals);
+    ctx->total_spin_time += get_network_time() - spin_start;
+    if (events != 0) {
+      ctx->spin_wakeups++;
+      return events;
+    }
+    ctx->spin_sleeps++;
+  }
+  return net_reactor_poll(ctx, timeout);
+}
+
 void net_reactor_fetch_events(net_reactor_ctx_t *ctx, int num_events) {
   for (int i = 0; i < num_events; ++i) {
     const int fd = ctx->epoll_events[i].data.fd;
@@ -340,7 +411,9 @@ int net_reactor_insert(net_reactor_ctx_t *ctx, int fd, int flags) {
     tvkprintf(net_events, 3, "epoll_ctl(%d,%d,%d,%d,%08x)\n", ctx->epoll_fd, (ev->state & EVT_IN_EPOLL) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, ee.data.fd,
               ee.events);
 
-    if (epoll_ctl(ctx->epoll_fd, (ev->state & EVT_IN_EPOLL) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ee) < 0) {
+    if (ctx->uring) {
+      net_reactor_uring_update(ctx->uring, fd, ee.events, flags & EVT_LEVEL);
+    } else if (epoll_ctl(ctx->epoll_fd, (ev->state & EVT_IN_EPOLL) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ee) < 0) {
       tvkprintf(net_events, 0, "epoll_ctl(): %m\n");
     }
     ev->state |= EVT_IN_EPOLL;
@@ -358,7 +431,9 @@ int net_reactor_remove(net_reactor_ctx_t *ctx, int fd) {
 
   if (!(ev->state & EVT_FAKE) && (ev->state & EVT_IN_EPOLL)) {
     ev->state &= ~EVT_IN_EPOLL;
-    if (epoll_ctl(ctx->epoll_fd, EPOLL_CTL_DEL, fd, 0) < 0) {
+    if (ctx->uring) {
+      net_reactor_uring_update(ctx->uring, fd, 0, false);
+    } else if (epoll_ctl(ctx->epoll_fd, EPOLL_CTL_DEL, fd, 0) < 0) {
       tvkprintf(net_events, 0, "epoll_ctl(): %m\n");
     }
   }
@@ -436,11 +511,24 @@ static void dump_too_many_event_timers(net_reactor_ctx_t *ctx) {
   }
 }
 
+int net_reactor_timers(const net_reactor_ctx_t *ctx) {
+  return ctx->timer_heap_size + ctx->timer_wheel->size();
+}
+
 bool net_reactor_has_too_many_timers(net_reactor_ctx_t *ctx) {
-  return ctx->timer_heap_size * 2 >= ctx->max_timers;
+  return net_reactor_timers(ctx) * 2 >= ctx->max_timers;
 }
 
 int net_reactor_insert_event_timer(net_reactor_ctx_t *ctx, event_timer_t *et) {
+  if (vk::net::TimerWheel::contains(et)) {
+    ctx->timer_wheel->remove(et);
+  }
+  if (et->wakeup_time - precise_now >= EXACT_TIMER_TIMEOUT) {
+    net_reactor_remove_event_timer(ctx, et);
+    ctx->timer_wheel->insert(et, precise_now);
+    return 1;
+  }
+
   int i;
   if (et->h_idx) {
     i = et->h_idx;
@@ -457,6 +545,10 @@ int net_reactor_insert_event_timer(net_reactor_ctx_t *ctx, event_timer_t *et) {
 }
 
 int net_reactor_remove_event_timer(net_reactor_ctx_t *ctx, event_timer_t *et) {
+  if (vk::net::TimerWheel::contains(et)) {
+    ctx->timer_wheel->remove(et);
+    return 1;
+  }
   int i = et->h_idx;
   if (!i) {
     return 0;
@@ -475,21 +567,29 @@ int net_reactor_remove_event_timer(net_reactor_ctx_t *ctx, event_timer_t *et) {
 int net_reactor_run_timers(net_reactor_ctx_t *ctx) {
   double wait_time;
   event_timer_t *et;
-  if (!ctx->timer_heap_size) {
+  if (!net_reactor_timers(ctx)) {
     return 100000;
   }
-  wait_time = ctx->timer_heap[1]->wakeup_time - precise_now;
+  ctx->timer_wheel->advance(precise_now);
+  wait_time = ctx->timer_wheel->next_expiration() - precise_now;
+  if (ctx->timer_heap_size) {
+    wait_time = std::min(wait_time, ctx->timer_heap[1]->wakeup_time - precise_now);
+  }
   if (wait_time > 0) {
     // do not remove this useful debug!
-    tvkprintf(net_events, 3, "%d event timers, next in %.3f seconds\n", ctx->timer_heap_size, wait_time);
+    tvkprintf(net_events, 3, "%d event timers, next in %.3f seconds\n", net_reactor_timers(ctx), wait_time);
     return (int)(std::min(100.0, wait_time) * 1000) + 1; // min to prevent integer overflow
   }
 
   const vk::net::TimeSlice time_slice(max_time_slice);
-  while (ctx->timer_heap_size > 0 && ctx->timer_heap[1]->wakeup_time <= precise_now && !pending_signals && !time_slice.expired()) {
-    et = ctx->timer_heap[1];
-    assert(et->h_idx == 1);
-    net_reactor_remove_event_timer(ctx, et);
+  while (!pending_signals && !time_slice.expired()) {
+    if (ctx->timer_heap_size > 0 && ctx->timer_heap[1]->wakeup_time <= precise_now) {
+      et = ctx->timer_heap[1];
+      assert(et->h_idx == 1);
+      net_reactor_remove_event_timer(ctx, et);
+    } else if (!(et = ctx->timer_wheel->pop_due())) {
+      break;
+    }
     et->wakeup(et);
   }
   return 0;
@@ -551,7 +651,7 @@ int net_reactor_runqueue(net_reactor_ctx_t *ctx) {
 }
 
 int net_reactor_work_timers(net_reactor_ctx_t *ctx, int timeout) {
-  if (ctx->event_heap_size || ctx->timer_heap_size) {
+  if (ctx->event_heap_size || net_reactor_timers(ctx)) {
     ctx->now = time(0);
     get_utime_monotonic();
     const vk::net::TimeSlice time_slice(max_time_slice);
@@ -51,17 +51,26 @@ struct event_descr {
 };
 
 typedef struct event_timer event_timer_t;
+typedef struct net_reactor_uring net_reactor_uring_t;
+
+namespace vk {
+namespace net {
+class TimerWheel;
+} // namespace net
+} // namespace vk
 
 typedef int (*event_timer_wakeup_t)(event_timer_t *et);
 struct event_timer {
-  int h_idx;
+  int h_idx; // position in the heap, or a negative slot of the timer wheel, 0 if the timer is not active
   event_timer_wakeup_t wakeup;
   double wakeup_time;
   const char *operation;
+  event_timer_t *wheel_prev;
+  event_timer_t *wheel_next;
 };
 
 struct net_reactor_ctx {
-  int epoll_fd;
+  int epoll_fd; // the descriptor of the io_uring instance if it is used instead of epoll
   int max_events;
   int max_timers;
   int event_heap_size;
@@ -73,7 +82,8 @@ struct net_reactor_ctx {
   event_t *events;
   event_t *timers;
   event_t **event_heap;
-  event_timer_t **timer_heap;
+  event_timer_t **timer_heap; // the timers which expire sooner than in EXACT_TIMER_TIMEOUT
+  vk::net::TimerWheel *timer_wheel; // the rest of the timers
   epoll_func_vector_t pre_runqueue;
   epoll_func_vector_t post_runqueue;
   epoll_func_vector_t pre_event;
@@ -82,6 +92,11 @@ struct net_reactor_ctx {
   double total_idle_time;
   double average_idle_time;
   double average_idle_quotient;
+  net_reactor_uring_t *uring;
+  bool busy_poll; // the next waits spin on the events for the busy poll time before the sleep
+  double total_spin_time;
+  long long spin_wakeups;
+  long long spin_sleeps;
 };
 typedef struct net_reactor_ctx net_reactor_ctx_t;
 
@@ -89,9 +104,7 @@ static inline int net_reactor_events(const net_reactor_ctx_t *reactor_ctx) {
   return reactor_ctx->event_heap_size;
 }
 
-static inline int net_reactor_timers(const net_reactor_ctx_t *reactor_ctx) {
-  return reactor_ctx->timer_heap_size;
-}
+int net_reactor_timers(const net_reactor_ctx_t *reactor_ctx);
 
 void net_reactor_alloc(net_reactor_ctx_t *ctx, int max_events, int max_timers);
 void net_reactor_free(net_reactor_ctx_t *ctx);
@@ -120,4 +133,7 @@ void net_reactor_update_timer_counters(net_reactor_ctx_t *ctx, int timeout);
 
 int net_reactor_work(net_reactor_ctx_t *ctx, int timeout);
 
+/* microseconds, 0 if the busy poll is off */
+int net_reactor_busy_poll_time();
+
 #endif // KDB_NET_NET_REACTOR_H
@@ -5,6 +5,7 @@
 #include "net/net-socket-options.h"
 
 #include <errno.h>
+#include <linux/filter.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <stdio.h>
@@ -81,6 +82,31 @@ bool socket_enable_reuseport(int socket) {
 #endif
 }
 
+// steers a new connection of a SO_REUSEPORT group to the socket number (cpu % sockets_n + first_socket);
+// if there is no such socket in the group, the kernel falls back to the usual hash
+bool socket_attach_reuseport_cpu_steering(int socket, int first_socket, int sockets_n) {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  if (sockets_n <= 0) {
+    return false;
+  }
+  sock_filter code[] = {
+    {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<__u32>(SKF_AD_OFF + SKF_AD_CPU)},
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<__u32>(sockets_n)},
+    {BPF_ALU | BPF_ADD | BPF_K, 0, 0, static_cast<__u32>(first_socket)},
+    {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  sock_fprog prog{};
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+  return !setsockopt(socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+#else
+  (void) socket;
+  (void) first_socket;
+  (void) sockets_n;
+  return false;
+#endif
+}
+
 bool socket_enable_tcp_nodelay(int socket) {
   int enable = 1;
   return !setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
@@ -95,6 +121,10 @@ bool socket_set_tcp_window_clamp(int socket, int size) {
   return !setsockopt(socket, IPPROTO_TCP, TCP_WINDOW_CLAMP, &size, sizeof(size));
 }
 
+bool socket_set_busy_poll(int socket, int usec) {
+  return !setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+}
+
 void socket_maximize_sndbuf(int socket, int max) {
   socklen_t intsize = sizeof(int);
   int last_good = 0;
@@ -21,9 +21,11 @@ bool socket_enable_ip_v6_only(int socket);
 bool socket_enable_keepalive(int socket);
 bool socket_enable_reuseaddr(int socket);
 bool socket_enable_reuseport(int socket);
+bool socket_attach_reuseport_cpu_steering(int socket, int first_socket, int sockets_n);
 bool socket_enable_tcp_nodelay(int socket);
 bool socket_enable_unix_passcred(int socket);
 bool socket_set_tcp_window_clamp(int socket, int size);
+bool socket_set_busy_poll(int socket, int usec);
 void socket_maximize_rcvbuf(int socket, int max);
 void socket_maximize_sndbuf(int socket, int max);
 bool socket_get_domain(int socket, int *domain);
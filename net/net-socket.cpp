@@ -19,6 +19,7 @@
 
 #include "common/kprintf.h"
 #include "common/options.h"
+#include "net/net-reactor.h"
 #include "net/net-socket-options.h"
 
 #define DEFAULT_BACKLOG 8192
@@ -335,6 +336,10 @@ int client_socket(const struct sockaddr_in *addr, int mode) {
     socket_maximize_rcvbuf(sfd, 0);
     socket_enable_keepalive(sfd);
     socket_enable_tcp_nodelay(sfd);
+    if (net_reactor_busy_poll_time()) {
+      // busy reading of the device queue by the kernel, it is refused without CAP_NET_ADMIN above net.core.busy_read
+      socket_set_busy_poll(sfd, net_reactor_busy_poll_time());
+    }
   }
 
   if (bind_to_my_ipv4) {
@@ -379,6 +384,9 @@ int client_socket_ipv6(const struct sockaddr_in6 *addr, int mode) {
     socket_maximize_rcvbuf(sfd, 0);
     socket_enable_keepalive(sfd);
     socket_enable_tcp_nodelay(sfd);
+    if (net_reactor_busy_poll_time()) {
+      socket_set_busy_poll(sfd, net_reactor_busy_poll_time());
+    }
   }
 
   if (connect(sfd, (struct sockaddr *) addr, sizeof(*addr)) == -1 && errno != EINPROGRESS) {
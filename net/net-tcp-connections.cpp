@@ -9,6 +9,7 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/socket.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
@@ -327,6 +328,13 @@ static int tcp_server_reader_inner(struct connection *c, bool once) {
           tcp_recv_iovec[i + 1].iov_len = msg_buffer_size(X);
         }
 
+        if (!msg_buffers_check_connection_quota(static_cast<long long>(c->in.total_bytes) + c->in_u.total_bytes + c->out.total_bytes + c->out_p.total_bytes)) {
+          vkprintf(1, "connection %d buffers %d + %d bytes, more than the quota of %lld bytes, closing it\n", c->fd, c->in.total_bytes + c->in_u.total_bytes,
+                   c->out.total_bytes + c->out_p.total_bytes, msg_buffers_connection_quota());
+          fail_connection(c, -1);
+          return -1;
+        }
+
         s = c->skip_bytes;
 
         if (s && c->crypto) {
@@ -430,6 +438,74 @@ int tcp_server_reader_till_end(struct connection *c) {
 }
 
 
+bool tcp_server_can_offload(const struct connection *c) {
+  if (c->type->reader != tcp_server_reader && c->type->reader != tcp_server_reader_till_end) {
+    return false;
+  }
+  if ((c->basic_type != ct_inbound && c->basic_type != ct_outbound) || c->type->ancillary_data_received) {
+    return false;
+  }
+  if ((c->flags & (C_FAILED | C_STOPREAD)) || !(c->flags & C_WANTRD) || c->error) {
+    return false;
+  }
+  if (c->status != conn_expect_query && c->status != conn_reading_query && c->status != conn_wait_answer && c->status != conn_reading_answer) {
+    return false;
+  }
+  return !c->crypto || (c->type->crypto_decrypt_input == tcp_aes_crypto_decrypt_input && c->type->crypto_encrypt_output == tcp_aes_crypto_encrypt_output);
+}
+
+/* the bytes are accounted the same way as by the reader, they are parsed later by the reader itself */
+int tcp_server_offload_read(struct connection *c, char *buffer, int size) {
+  raw_message_t *in = c->crypto ? &c->in_u : &c->in;
+
+  int r = recv(c->fd, buffer, size, MSG_DONTWAIT);
+  if (r <= 0) {
+    return r;
+  }
+  assert(rwm_push_data(in, buffer, r) == r);
+
+  if (c->crypto) {
+    assert(c->type->crypto_decrypt_input(c) >= 0);
+  }
+
+  int s = c->skip_bytes;
+  int r1 = c->in.total_bytes;
+  if (s < 0) {
+    if (r1 > -s) {
+      r1 = -s;
+    }
+    rwm_fetch_data(&c->in, 0, r1);
+    c->skip_bytes = s + r1;
+  } else if (s > 0 && r1 >= s) {
+    c->skip_bytes = 0;
+  }
+  return r;
+}
+
+int tcp_server_offload_write(struct connection *c) {
+  if (c->crypto) {
+    assert(c->type->crypto_encrypt_output(c) >= 0);
+  }
+
+  raw_message_t *out = c->crypto ? &c->out_p : &c->out;
+  int t = 0;
+  while (out->total_bytes > 0) {
+    struct iovec iov[64];
+    int iovcnt = -1;
+    int s = tcp_prepare_iovec(iov, &iovcnt, 64, out);
+
+    int r = writev(c->fd, iov, iovcnt);
+    if (r > 0) {
+      rwm_fetch_data(out, 0, r);
+      t += r;
+    }
+    if (r < s) {
+      break;
+    }
+  }
+  return t;
+}
+
 
 /* 0 = all ok, >0 = so much more bytes needed to encrypt last block */
 int tcp_aes_crypto_encrypt_output(struct connection *c) {
@@ -20,6 +20,15 @@ int tcp_aes_crypto_decrypt_input (struct connection *c);
 int tcp_aes_crypto_encrypt_output (struct connection *c);
 int tcp_aes_crypto_needed_output_bytes (struct connection *c);
 
+/* the part of the work of the reader and the writer which may be done by another thread
+   while the main thread doesn't process the connection, see net-io-thread.h */
+bool tcp_server_can_offload(const struct connection *c);
+/* reads the socket once, decrypts the input and accounts c->skip_bytes, but doesn't parse anything;
+   returns the result of recv() */
+int tcp_server_offload_read(struct connection *c, char *buffer, int size);
+/* encrypts the output and writes as much of it as possible, returns the number of bytes written */
+int tcp_server_offload_write(struct connection *c);
+
 extern int tcp_buffers;
 
 #endif
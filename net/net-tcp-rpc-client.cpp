@@ -14,6 +14,7 @@
 #include "common/crc32.h"
 #include "common/crc32c.h"
 #include "common/kprintf.h"
+#include "common/options.h"
 #include "common/precise-time.h"
 #include "common/tl/constants/common.h"
 
@@ -444,6 +445,7 @@ int tcp_rpcc_init_outbound (struct connection *c) {
   struct tcp_rpc_data *D = TCP_RPC_DATA(c);
   c->last_query_sent_time = precise_now;
   D->custom_crc_partial = crc32_partial;
+  D->pending_answers = 0;
 
   int checked_perm = tcp_check_perm(c, 1);
   if (checked_perm < 0) {
@@ -455,6 +457,45 @@ int tcp_rpcc_init_outbound (struct connection *c) {
   return 0;
 }
 
+static long long rpc_client_queue_bytes;
+static int rpc_client_queue_packets;
+
+OPTION_PARSER(OPT_RPC, "rpc-client-queue-bytes", required_argument,
+              "maximal size of the data queued for sending to one outbound rpc connection; a connection over it is not used for new queries (default: unlimited)") {
+  rpc_client_queue_bytes = parse_memory_limit(optarg);
+  return rpc_client_queue_bytes >= 0 ? 0 : -1;
+}
+
+OPTION_PARSER(OPT_RPC, "rpc-client-queue-packets", required_argument,
+              "maximal number of not answered queries of one outbound rpc connection; a connection over it is not used for new queries (default: unlimited)") {
+  rpc_client_queue_packets = atoi(optarg);
+  return rpc_client_queue_packets >= 0 ? 0 : -1;
+}
+
+int tcp_rpcc_queued_bytes (const struct connection *c) {
+  return c->out.total_bytes + c->out_p.total_bytes;
+}
+
+int tcp_rpcc_pending_answers (const struct connection *c) {
+  return TCP_RPC_DATA(c)->pending_answers;
+}
+
+bool tcp_rpcc_is_busy (const struct connection *c) {
+  return (rpc_client_queue_bytes > 0 && tcp_rpcc_queued_bytes (c) >= rpc_client_queue_bytes)
+         || (rpc_client_queue_packets > 0 && tcp_rpcc_pending_answers (c) >= rpc_client_queue_packets);
+}
+
+void tcp_rpcc_query_sent (struct connection *c) {
+  TCP_RPC_DATA(c)->pending_answers++;
+}
+
+void tcp_rpcc_answer_received (struct connection *c) {
+  /* the queries which were sent before the connection became ready are not counted */
+  if (TCP_RPC_DATA(c)->pending_answers > 0) {
+    TCP_RPC_DATA(c)->pending_answers--;
+  }
+}
+
 int tcp_rpcc_default_check_perm (struct connection *c) {
   if (aes_initialized <= 0) {
     return (!is_same_data_center(c, 1)) ? 0 : 1;
@@ -553,7 +594,7 @@ int tcp_rpcc_flush_packet (struct connection *c) {
 
 int tcp_rpcc_flush_packet_later (struct connection *c) {
   tcp_rpcc_flush_crypto (c);
-  return flush_later (c);
+  return tcp_rpc_flush_coalesced (c, true);
 }
 
 int tcp_rpcc_flush (struct connection *c) {
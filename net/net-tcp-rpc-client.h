@@ -41,6 +41,13 @@ int tcp_rpcc_init_crypto (struct connection *c);
 int tcp_rpcc_start_crypto (struct connection *c, char *nonce, int key_select);
 int default_tcp_rpc_client_check_ready(struct connection *c);
 
+/* flow control: a connection whose queue is over --rpc-client-queue-bytes or --rpc-client-queue-packets is busy */
+int tcp_rpcc_queued_bytes (const struct connection *c);
+int tcp_rpcc_pending_answers (const struct connection *c);
+bool tcp_rpcc_is_busy (const struct connection *c);
+void tcp_rpcc_query_sent (struct connection *c);
+void tcp_rpcc_answer_received (struct connection *c);
+
 #define TCP_RPCC_FUNC(c) ((struct tcp_rpc_client_functions *) ((c)->extra))
 
 #endif
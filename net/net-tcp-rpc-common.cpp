@@ -6,6 +6,7 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/uio.h>
 
 #include "common/kprintf.h"
@@ -22,6 +23,27 @@ OPTION_PARSER(OPT_RPC, "no-crc32c", no_argument, "Force use of CRC32 instead of
   return 0;
 }
 
+static double rpc_coalesce_window;
+#define RPC_COALESCE_MAX_BYTES (64 << 10)
+
+OPTION_PARSER(OPT_RPC, "rpc-coalesce-window", required_argument,
+              "delay in microseconds (up to 10000) for which the rpc packets of a connection are held to be written together; 0 disables it (default)") {
+  const int window_us = atoi(optarg);
+  if (window_us < 0 || window_us > 10000) {
+    kprintf("--rpc-coalesce-window should be between 0 and 10000 microseconds\n");
+    return -1;
+  }
+  rpc_coalesce_window = window_us * 1e-6;
+  return 0;
+}
+
+int tcp_rpc_flush_coalesced (struct connection *c, bool client) {
+  if (rpc_coalesce_window > 0) {
+    return flush_coalesced (c, rpc_coalesce_window, RPC_COALESCE_MAX_BYTES);
+  }
+  return client ? flush_later (c) : flush_connection_output (c);
+}
+
 // Flags:
 //   Flag 1 - can not edit this message. Need to make copy.
 
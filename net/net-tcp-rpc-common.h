@@ -62,6 +62,7 @@ struct tcp_rpc_data {
   int extra_int4;
   double extra_double, extra_double2;
   crc32_partial_func_t custom_crc_partial;
+  int pending_answers;			/* client: queries sent which are not answered yet */
 };
 
 #define	TCP_RPC_DATA(c)	((struct tcp_rpc_data *) ((c)->custom_data))
@@ -86,4 +87,8 @@ extern int default_rpc_flags;  /* 0 = compatibility mode, RPC_CRYPTO_USE_CRC32C
 
 void net_rpc_send_ping (struct connection *c, long long ping_id);
 
+/* flushes the packets of the connection, coalescing them within --rpc-coalesce-window if it is set;
+   otherwise the client packets are flushed later in the same iteration of the event loop and the server packets at once */
+int tcp_rpc_flush_coalesced (struct connection *c, bool client);
+
 #endif
@@ -627,7 +627,7 @@ int tcp_rpcs_flush_packet (struct connection *c) {
       assert (rwm_push_data (&c->out, pad_str, pad_bytes) == pad_bytes);
     }
   }
-  return flush_connection_output (c);
+  return tcp_rpc_flush_coalesced (c, false);
 }
 
 int tcp_rpcs_flush (struct connection *c) {
@@ -1,8 +1,11 @@
 prepend(NET_TESTS_SOURCES ${BASE_DIR}/net/
         net-aes-keys-test.cpp
+        net-http2-hpack-test.cpp
         net-msg-test.cpp
+        net-reactor-uring-test.cpp
         net-test.cpp
-        time-slice-test.cpp)
+        time-slice-test.cpp
+        timer-wheel-test.cpp)
 
 set(NET_TESTS_LIBS vk::common_src vk::net_src vk::binlog_src vk::unicode -l:libzstd.a rt crypto z)
 vk_add_unittest(net "${NET_TESTS_LIBS}" ${NET_TESTS_SOURCES})
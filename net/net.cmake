@@ -15,11 +15,16 @@ prepend(NET_SOURCES ${BASE_DIR}/net/
         net-aes-keys.cpp
         net-socket.cpp
         net-reactor.cpp
+        net-reactor-uring.cpp
         net-msg-part.cpp
         net-mysql-client.cpp
         net-memcache-client.cpp
         net-http-server.cpp
+        net-http2-hpack.cpp
+        net-http2-server.cpp
+        net-io-thread.cpp
         net-msg-buffers.cpp
+        timer-wheel.cpp
         net-msg.cpp
         net-msg-part.cpp)
 
@@ -0,0 +1,95 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "net/timer-wheel.h"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+event_timer_t make_timer(double wakeup_time) {
+  event_timer_t et{};
+  et.wakeup_time = wakeup_time;
+  return et;
+}
+
+} // namespace
+
+TEST(net_timer_wheel, expiration) {
+  vk::net::TimerWheel wheel;
+  const double now = 1000;
+  auto near = make_timer(now + 0.0105);
+  auto far = make_timer(now + 3700);
+  wheel.insert(&near, now);
+  wheel.insert(&far, now);
+  EXPECT_EQ(wheel.size(), 2);
+  EXPECT_TRUE(vk::net::TimerWheel::contains(&near));
+
+  wheel.advance(now + 0.010);
+  EXPECT_EQ(wheel.pop_due(), nullptr);
+  EXPECT_GE(wheel.next_expiration(), near.wakeup_time);
+  EXPECT_LT(wheel.next_expiration(), near.wakeup_time + vk::net::TimerWheel::TICK);
+
+  wheel.advance(now + 0.011);
+  EXPECT_EQ(wheel.pop_due(), &near);
+  EXPECT_EQ(near.h_idx, 0);
+  EXPECT_EQ(wheel.pop_due(), nullptr);
+
+  wheel.advance(now + 3699.99);
+  EXPECT_EQ(wheel.pop_due(), nullptr);
+  wheel.advance(now + 3700.001);
+  EXPECT_EQ(wheel.pop_due(), &far);
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(net_timer_wheel, remove) {
+  vk::net::TimerWheel wheel;
+  auto first = make_timer(10.5);
+  auto second = make_timer(10.5);
+  wheel.insert(&first, 10);
+  wheel.insert(&second, 10);
+  wheel.remove(&first);
+  EXPECT_EQ(first.h_idx, 0);
+  wheel.advance(11);
+  EXPECT_EQ(wheel.pop_due(), &second);
+  EXPECT_EQ(wheel.pop_due(), nullptr);
+}
+
+// the timers expire neither earlier than their time, nor later than the next tick after it
+TEST(net_timer_wheel, random) {
+  constexpr double tick = vk::net::TimerWheel::TICK;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> short_timeout(0.001, 0.5);
+  std::uniform_real_distribution<double> long_timeout(0.5, 600);
+  std::uniform_int_distribution<int> coin(0, 9);
+
+  vk::net::TimerWheel wheel;
+  std::vector<event_timer_t> timers(2000);
+  double now = 12345.678;
+  for (auto &et : timers) {
+    et = make_timer(now + (coin(gen) < 7 ? short_timeout(gen) : long_timeout(gen)));
+    wheel.insert(&et, now);
+  }
+  for (size_t i = 0; i < timers.size(); i += 10) {
+    wheel.remove(&timers[i]);
+  }
+
+  int expired = 0;
+  while (wheel.size()) {
+    // the loop of the reactor sleeps till the next expiration, or less
+    const double next = wheel.next_expiration();
+    ASSERT_GT(next, now);
+    now = coin(gen) < 5 ? next : now + (next - now) * 0.5 + tick * 0.1;
+    wheel.advance(now);
+    while (event_timer_t *et = wheel.pop_due()) {
+      EXPECT_GE(now, et->wakeup_time);
+      EXPECT_LT(now - et->wakeup_time, 2 * tick);
+      expired++;
+    }
+  }
+  EXPECT_EQ(expired, 1800);
+}
@@ -0,0 +1,199 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "net/timer-wheel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace vk {
+namespace net {
+
+constexpr double TimerWheel::TICK;
+
+void TimerWheel::link(event_timer_t *et, int slot) {
+  et->h_idx = -(slot + 1);
+  size_++;
+  if (slot == DUE_SLOT) {
+    // the due timers are kept in the order of expiration
+    et->wheel_next = nullptr;
+    et->wheel_prev = due_tail_;
+    if (due_tail_) {
+      due_tail_->wheel_next = et;
+    } else {
+      slots_[slot] = et;
+    }
+    due_tail_ = et;
+    return;
+  }
+
+  et->wheel_prev = nullptr;
+  et->wheel_next = slots_[slot];
+  if (et->wheel_next) {
+    et->wheel_next->wheel_prev = et;
+  }
+  slots_[slot] = et;
+  level_sizes_[slot / LEVEL_SLOTS]++;
+  if (slot < LEVEL_SLOTS) {
+    first_level_bitmap_[slot / 64] |= 1ULL << (slot % 64);
+  }
+}
+
+void TimerWheel::unlink(event_timer_t *et) {
+  assert(contains(et));
+  const int slot = -et->h_idx - 1;
+  assert(0 <= slot && slot <= DUE_SLOT);
+  if (et->wheel_prev) {
+    et->wheel_prev->wheel_next = et->wheel_next;
+  } else {
+    assert(slots_[slot] == et);
+    slots_[slot] = et->wheel_next;
+  }
+  if (et->wheel_next) {
+    et->wheel_next->wheel_prev = et->wheel_prev;
+  } else if (slot == DUE_SLOT) {
+    due_tail_ = et->wheel_prev;
+  }
+  et->wheel_prev = et->wheel_next = nullptr;
+  et->h_idx = 0;
+  size_--;
+
+  if (slot != DUE_SLOT) {
+    level_sizes_[slot / LEVEL_SLOTS]--;
+    if (slot < LEVEL_SLOTS && !slots_[slot]) {
+      first_level_bitmap_[slot / 64] &= ~(1ULL << (slot % 64));
+    }
+  }
+}
+
+int64_t TimerWheel::expiration_tick(const event_timer_t *et) const {
+  const double tick = std::ceil(et->wakeup_time / TICK);
+  return tick > current_tick_ ? static_cast<int64_t>(tick) : current_tick_;
+}
+
+void TimerWheel::place(event_timer_t *et) {
+  int64_t tick = expiration_tick(et);
+  const int64_t delta = tick - current_tick_;
+  int level = 0;
+  while (level + 1 < LEVELS && delta >= (int64_t{1} << (LEVEL_BITS * (level + 1)))) {
+    level++;
+  }
+  if (level == LEVELS - 1 && delta >= (int64_t{1} << (LEVEL_BITS * LEVELS))) {
+    // more than 49 days, the timer is placed again when its slot comes
+    tick = current_tick_ + (int64_t{1} << (LEVEL_BITS * LEVELS)) - 1;
+  }
+  const int index = static_cast<int>((tick >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1));
+  link(et, level * LEVEL_SLOTS + index);
+}
+
+void TimerWheel::insert(event_timer_t *et, double now) {
+  assert(!et->h_idx);
+  if (current_tick_ < 0 || level_sizes_[0] + level_sizes_[1] + level_sizes_[2] + level_sizes_[3] == 0) {
+    // the wheel is empty, there is nothing to expire between the last advance and now
+    current_tick_ = std::max(current_tick_, static_cast<int64_t>(now / TICK));
+  }
+  place(et);
+}
+
+void TimerWheel::remove(event_timer_t *et) {
+  unlink(et);
+}
+
+// the timers of the slot of the level which has come are placed into the lower levels
+void TimerWheel::cascade(int level) {
+  const int index = static_cast<int>((current_tick_ >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1));
+  const int slot = level * LEVEL_SLOTS + index;
+  while (event_timer_t *et = slots_[slot]) {
+    unlink(et);
+    place(et);
+  }
+}
+
+void TimerWheel::advance(double now) {
+  if (current_tick_ < 0) {
+    return;
+  }
+  const auto now_tick = static_cast<int64_t>(now / TICK);
+  const auto cascade_all = [this] {
+    for (int level = LEVELS - 1; level > 0; level--) {
+      if ((current_tick_ & ((int64_t{1} << (LEVEL_BITS * level)) - 1)) == 0) {
+        cascade(level);
+      }
+    }
+  };
+
+  while (current_tick_ <= now_tick) {
+    if (level_sizes_[0] + level_sizes_[1] + level_sizes_[2] + level_sizes_[3] == 0) {
+      // only the due timers or nothing at all
+      current_tick_ = now_tick + 1;
+      break;
+    }
+
+    const int slot = static_cast<int>(current_tick_ & (LEVEL_SLOTS - 1));
+    while (event_timer_t *et = slots_[slot]) {
+      unlink(et);
+      link(et, DUE_SLOT);
+    }
+    current_tick_++;
+
+    if (level_sizes_[0] == 0 && (current_tick_ & (LEVEL_SLOTS - 1)) != 0) {
+      // nothing expires before the next cascade
+      const int64_t next_cascade = (current_tick_ | (LEVEL_SLOTS - 1)) + 1;
+      if (next_cascade > now_tick + 1) {
+        current_tick_ = now_tick + 1;
+        break;
+      }
+      current_tick_ = next_cascade;
+    }
+    if ((current_tick_ & (LEVEL_SLOTS - 1)) == 0) {
+      cascade_all();
+    }
+  }
+}
+
+event_timer_t *TimerWheel::pop_due() {
+  event_timer_t *et = slots_[DUE_SLOT];
+  if (et) {
+    unlink(et);
+  }
+  return et;
+}
+
+double TimerWheel::next_expiration() const {
+  if (slots_[DUE_SLOT]) {
+    return 0;
+  }
+  int64_t next_tick = std::numeric_limits<int64_t>::max();
+  if (level_sizes_[1] + level_sizes_[2] + level_sizes_[3]) {
+    next_tick = (current_tick_ | (LEVEL_SLOTS - 1)) + 1;
+  }
+  if (level_sizes_[0]) {
+    // the nearest slot of the first level after the current one, cyclically
+    const int start = static_cast<int>(current_tick_ & (LEVEL_SLOTS - 1));
+    for (int i = 0; i <= LEVEL_SLOTS / 64; i++) {
+      const int word = (start / 64 + i) % (LEVEL_SLOTS / 64);
+      uint64_t bits = first_level_bitmap_[word];
+      if (i == 0) {
+        bits &= ~0ULL << (start % 64);
+      } else if (i == LEVEL_SLOTS / 64) {
+        bits &= (1ULL << (start % 64)) - 1;
+      }
+      if (bits) {
+        const int index = word * 64 + __builtin_ctzll(bits);
+        const int64_t tick = current_tick_ + ((index - start) & (LEVEL_SLOTS - 1));
+        next_tick = std::min(next_tick, tick);
+        break;
+      }
+    }
+  }
+  if (next_tick == std::numeric_limits<int64_t>::max()) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return static_cast<double>(next_tick) * TICK;
+}
+
+} // namespace net
+} // namespace vk
@@ -0,0 +1,68 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#ifndef KDB_NET_TIMER_WHEEL_H
+#define KDB_NET_TIMER_WHEEL_H
+
+#include <array>
+#include <cstdint>
+
+#include "net/net-reactor.h"
+
+namespace vk {
+namespace net {
+
+// Hierarchical timing wheel of event timers: insert and remove are O(1), and the timers expire in batches by ticks.
+// A timer never expires before its wakeup_time, but it may expire up to two ticks later,
+// so the reactor keeps the timers which are closer than a tick in the exact heap.
+class TimerWheel {
+public:
+  static constexpr double TICK = 0.001;
+
+  // the timer must be inactive
+  void insert(event_timer_t *et, double now);
+  // the timer must be in the wheel
+  void remove(event_timer_t *et);
+
+  // moves the timers which have expired by now to the due list
+  void advance(double now);
+  // unlinks the first timer of the due list, nullptr if the list is empty
+  event_timer_t *pop_due();
+
+  // the time when advance() may find expired timers, 0 if the due list is not empty
+  double next_expiration() const;
+
+  int size() const {
+    return size_;
+  }
+
+  static bool contains(const event_timer_t *et) {
+    return et->h_idx < 0;
+  }
+
+private:
+  static constexpr int LEVEL_BITS = 8;
+  static constexpr int LEVEL_SLOTS = 1 << LEVEL_BITS;
+  static constexpr int LEVELS = 4;
+  static constexpr int DUE_SLOT = LEVELS * LEVEL_SLOTS;
+
+  void link(event_timer_t *et, int slot);
+  void unlink(event_timer_t *et);
+  void place(event_timer_t *et);
+  void cascade(int level);
+  int64_t expiration_tick(const event_timer_t *et) const;
+
+  std::array<event_timer_t *, DUE_SLOT + 1> slots_{};
+  event_timer_t *due_tail_{nullptr};
+  std::array<int, LEVELS> level_sizes_{};
+  std::array<uint64_t, LEVEL_SLOTS / 64> first_level_bitmap_{};
+  // the next tick to expire
+  int64_t current_tick_{-1};
+  int size_{0};
+};
+
+} // namespace net
+} // namespace vk
+
+#endif // KDB_NET_TIMER_WHEEL_H
@@ -0,0 +1,231 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/allocations_sampler.h"
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <limits>
+
+#include "common/fast-backtrace.h"
+#include "common/wrappers/string_view.h"
+
+#include "runtime/allocator.h"
+#include "runtime/critical_section.h"
+#include "runtime/kphp-backtrace.h"
+
+namespace dl {
+
+int64_t bytes_until_allocation_sample = std::numeric_limits<int64_t>::max();
+
+namespace {
+
+constexpr int32_t MAX_SAMPLE_FRAMES = 32;
+constexpr size_t CALLSITES_COUNT = 1024;
+
+struct AllocationCallsite {
+  uint64_t hash{0};
+  int32_t frames_count{0};
+  void *frames[MAX_SAMPLE_FRAMES]{};
+  int64_t samples{0};
+  int64_t estimated_bytes{0};
+  long long last_query_num{0};
+  int64_t last_query_estimated_bytes{0};
+};
+
+class AllocationsSampler {
+public:
+  void set_interval(int64_t interval_bytes) noexcept {
+    interval_bytes_ = std::max(interval_bytes, int64_t{0});
+    std::fill(std::begin(callsites_), std::end(callsites_), AllocationCallsite{});
+    lost_samples_ = 0;
+    rng_state_ = static_cast<uint64_t>(time(nullptr)) | 1;
+    bytes_until_allocation_sample = next_countdown();
+  }
+
+  void record(size_t size) noexcept {
+    bytes_until_allocation_sample = next_countdown();
+    if (!interval_bytes_) {
+      return;
+    }
+
+    CriticalSectionGuard critical_section;
+    void *frames[MAX_SAMPLE_FRAMES + 1];
+    // the first frame is the sampler itself
+    const int32_t frames_count = std::max(fast_backtrace(frames, MAX_SAMPLE_FRAMES + 1) - 1, 0);
+    uint64_t hash = frames_count;
+    for (int32_t i = 0; i < frames_count; ++i) {
+      hash = hash * 0x9E3779B97F4A7C15ULL + reinterpret_cast<uintptr_t>(frames[i + 1]);
+    }
+
+    AllocationCallsite *callsite = find_callsite(hash, frames + 1, frames_count);
+    if (!callsite) {
+      ++lost_samples_;
+      return;
+    }
+    // an allocation bigger than the interval is always sampled, so it represents only itself
+    const int64_t estimated_bytes = std::max(static_cast<int64_t>(size), interval_bytes_);
+    ++callsite->samples;
+    callsite->estimated_bytes += estimated_bytes;
+    if (callsite->last_query_num != query_num) {
+      callsite->last_query_num = query_num;
+      callsite->last_query_estimated_bytes = 0;
+    }
+    callsite->last_query_estimated_bytes += estimated_bytes;
+  }
+
+  template<class F>
+  void for_each_callsite(F &&f) const noexcept {
+    for (const auto &callsite : callsites_) {
+      if (callsite.samples) {
+        f(callsite);
+      }
+    }
+  }
+
+  int64_t lost_samples() const noexcept {
+    return lost_samples_;
+  }
+
+private:
+  int64_t next_countdown() noexcept {
+    if (!interval_bytes_) {
+      return std::numeric_limits<int64_t>::max();
+    }
+    // xorshift64*
+    rng_state_ ^= rng_state_ >> 12;
+    rng_state_ ^= rng_state_ << 25;
+    rng_state_ ^= rng_state_ >> 27;
+    const double uniform = static_cast<double>((rng_state_ * 0x2545F4914F6CDD1DULL) >> 11) / static_cast<double>(1ULL << 53);
+    return static_cast<int64_t>(-std::log(1.0 - uniform) * static_cast<double>(interval_bytes_)) + 1;
+  }
+
+  AllocationCallsite *find_callsite(uint64_t hash, void **frames, int32_t frames_count) noexcept {
+    for (size_t i = 0; i < CALLSITES_COUNT; ++i) {
+      AllocationCallsite &callsite = callsites_[(hash + i) % CALLSITES_COUNT];
+      if (!callsite.samples) {
+        callsite.hash = hash;
+        callsite.frames_count = frames_count;
+        std::copy(frames, frames + frames_count, callsite.frames);
+        return &callsite;
+      }
+      if (callsite.hash == hash) {
+        return &callsite;
+      }
+    }
+    return nullptr;
+  }
+
+  int64_t interval_bytes_{0};
+  int64_t lost_samples_{0};
+  uint64_t rng_state_{1};
+  AllocationCallsite callsites_[CALLSITES_COUNT];
+};
+
+AllocationsSampler &get_allocations_sampler() noexcept {
+  static AllocationsSampler sampler;
+  return sampler;
+}
+
+// the php functions of the callsite stack, innermost first: "f <- g <- Class::method"
+template<size_t N>
+vk::string_view make_callsite_name(const AllocationCallsite &callsite, std::array<char, N> &buffer) noexcept {
+  size_t size = 0;
+  auto append = [&buffer, &size](const char *data, size_t len) {
+    len = std::min(len, buffer.size() - size);
+    std::copy(data, data + len, buffer.data() + size);
+    size += len;
+  };
+
+  KphpBacktrace demangler{const_cast<void **>(callsite.frames), callsite.frames_count};
+  for (const char *name : demangler.make_demangled_backtrace_range()) {
+    vk::string_view func_name{name ? name : ""};
+    if (!func_name.starts_with("f$")) {
+      continue;
+    }
+    func_name.remove_prefix(2);
+    // skip the run() function which calls the main file
+    if (func_name.ends_with("$run()")) {
+      continue;
+    }
+    if (size) {
+      append(" <- ", 4);
+    }
+    append_php_function_name(func_name, append);
+  }
+  if (!size) {
+    append("<runtime>", 9);
+  }
+  return vk::string_view{buffer.data(), size};
+}
+
+} // namespace
+
+void record_allocation_sample(size_t size) noexcept {
+  get_allocations_sampler().record(size);
+}
+
+void dump_allocations_samples() noexcept {
+  constexpr size_t TOP_CALLSITES = 10;
+  std::array<const AllocationCallsite *, TOP_CALLSITES> top{};
+  size_t top_size = 0;
+  auto by_query_bytes = [](const AllocationCallsite *lhs, const AllocationCallsite *rhs) {
+    return lhs->last_query_estimated_bytes > rhs->last_query_estimated_bytes;
+  };
+  get_allocations_sampler().for_each_callsite([&](const AllocationCallsite &callsite) {
+    if (callsite.last_query_num != query_num) {
+      return;
+    }
+    if (top_size < top.size()) {
+      top[top_size++] = &callsite;
+      std::push_heap(top.begin(), top.begin() + top_size, by_query_bytes);
+    } else if (by_query_bytes(&callsite, top.front())) {
+      std::pop_heap(top.begin(), top.end(), by_query_bytes);
+      top.back() = &callsite;
+      std::push_heap(top.begin(), top.end(), by_query_bytes);
+    }
+  });
+  if (!top_size) {
+    return;
+  }
+
+  const auto malloc_replacer_rollback = temporary_rollback_malloc_replacement();
+  std::sort(top.begin(), top.begin() + top_size, by_query_bytes);
+  fprintf(stderr, "------- Sampled script allocations of the request -------\n");
+  std::array<char, 1024> buffer{};
+  for (size_t i = 0; i < top_size; ++i) {
+    const vk::string_view name = make_callsite_name(*top[i], buffer);
+    fprintf(stderr, "%" PRIi64 " bytes: %.*s\n", top[i]->last_query_estimated_bytes, static_cast<int>(name.size()), name.data());
+  }
+  fprintf(stderr, "---------------------------------------------------------\n");
+}
+
+} // namespace dl
+
+void f$memory_set_allocations_sampling(int64_t interval_bytes) noexcept {
+  dl::get_allocations_sampler().set_interval(interval_bytes);
+}
+
+array<int64_t> f$memory_get_allocations_samples() noexcept {
+  // the result itself is not sampled
+  const int64_t bytes_until_allocation_sample = dl::bytes_until_allocation_sample;
+  dl::bytes_until_allocation_sample = std::numeric_limits<int64_t>::max();
+
+  array<int64_t> result;
+  std::array<char, 1024> buffer{};
+  dl::get_allocations_sampler().for_each_callsite([&](const dl::AllocationCallsite &callsite) {
+    const vk::string_view name = dl::make_callsite_name(callsite, buffer);
+    result[string{name.data(), static_cast<string::size_type>(name.size())}] += callsite.estimated_bytes;
+  });
+  if (const int64_t lost_samples = dl::get_allocations_sampler().lost_samples()) {
+    result.set_value(string{"<lost samples>"}, lost_samples);
+  }
+
+  dl::bytes_until_allocation_sample = bytes_until_allocation_sample;
+  return result;
+}
@@ -0,0 +1,37 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/wrappers/likely.h"
+
+#include "runtime/kphp_core.h"
+
+namespace dl {
+
+// the countdown of the script allocated bytes till the next sample, it is INT64_MAX while the sampling is disabled
+extern int64_t bytes_until_allocation_sample;
+
+void record_allocation_sample(size_t size) noexcept;
+
+// one allocation per sampling interval (on average, the intervals are exponentially distributed like in tcmalloc)
+// is recorded with the php functions on the stack, so that it's possible to find out which code allocates the script memory
+inline void on_script_allocation(size_t size) noexcept {
+  bytes_until_allocation_sample -= static_cast<int64_t>(size);
+  if (unlikely(bytes_until_allocation_sample <= 0)) {
+    record_allocation_sample(size);
+  }
+}
+
+// writes the callsites which allocated the most of the memory in the current request to stderr, used on the memory limit error
+void dump_allocations_samples() noexcept;
+
+} // namespace dl
+
+void f$memory_set_allocations_sampling(int64_t interval_bytes) noexcept;
+
+array<int64_t> f$memory_get_allocations_samples() noexcept;
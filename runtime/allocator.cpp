@@ -14,6 +14,7 @@
 #include "common/containers/final_action.h"
 #include "common/wrappers/likely.h"
 
+#include "runtime/allocations_sampler.h"
 #include "runtime/critical_section.h"
 #include "runtime/memory_resource/dealer.h"
 #include "runtime/php_assert.h"
@@ -28,6 +29,20 @@ memory_resource::Dealer &get_memory_dealer() noexcept {
 
 volatile bool script_allocator_enabled = false;
 
+void *reallocate_global_const_memory(memory_resource::global_const_memory &const_memory, memory_resource::heap_resource &heap,
+                                     void *mem, size_t new_size, size_t old_size) noexcept {
+  if (void *new_mem = const_memory.reallocate(mem, new_size, old_size)) {
+    return new_mem;
+  }
+  // the segment is exhausted, the piece moves to the heap
+  void *new_mem = heap.allocate(new_size);
+  if (new_mem) {
+    memcpy(new_mem, mem, old_size);
+    const_memory.deallocate(mem, old_size);
+  }
+  return new_mem;
+}
+
 } // namespace
 
 long long query_num = 0;
@@ -56,6 +71,10 @@ size_t get_heap_memory_used() noexcept {
   return get_memory_dealer().get_heap_resource().memory_used();
 }
 
+size_t get_heap_memory_used_max() noexcept {
+  return get_memory_dealer().get_heap_resource().max_memory_used();
+}
+
 void global_init_script_allocator() noexcept {
   auto &dealer = get_memory_dealer();
   php_assert(dealer.heap_script_resource_replacer());
@@ -68,14 +87,17 @@ void global_init_script_allocator() noexcept {
   query_num++;
 }
 
-void init_script_allocator(void *buffer, size_t buffer_size) noexcept {
+void init_script_allocator(void *buffer, size_t buffer_size, size_t growth_step) noexcept {
   auto &dealer = get_memory_dealer();
   php_assert(!dealer.heap_script_resource_replacer());
   php_assert(dealer.is_default_allocator_used());
   php_assert(!is_malloc_replaced());
 
   CriticalSectionGuard lock;
-  dealer.current_script_resource().init(buffer, buffer_size);
+  dealer.current_script_resource().init(buffer, buffer_size, growth_step);
+  // the scopes of the previous script could be left by the timeout or the exit
+  dealer.get_script_arena().reset();
+  dealer.get_heap_resource().reset_max_memory_used();
   script_allocator_enabled = true;
   query_num++;
 }
@@ -93,6 +115,12 @@ void *allocate(size_t size) noexcept {
   php_assert(size);
   auto &dealer = get_memory_dealer();
   if (auto heap_replacer = dealer.heap_script_resource_replacer()) {
+    auto &const_memory = dealer.get_global_const_memory();
+    if (unlikely(const_memory.is_enabled())) {
+      if (void *mem = const_memory.allocate(size)) {
+        return mem;
+      }
+    }
     return heap_replacer->allocate(size);
   }
   if (unlikely(!script_allocator_enabled)) {
@@ -100,6 +128,11 @@ void *allocate(size_t size) noexcept {
     return nullptr;
   }
 
+  on_script_allocation(size);
+  auto &arena = dealer.get_script_arena();
+  if (unlikely(arena.is_enabled())) {
+    return arena.allocate(size);
+  }
   return dealer.current_script_resource().allocate(size);
 }
 
@@ -107,6 +140,12 @@ void *allocate0(size_t size) noexcept {
   php_assert(size);
   auto &dealer = get_memory_dealer();
   if (auto heap_replacer = dealer.heap_script_resource_replacer()) {
+    auto &const_memory = dealer.get_global_const_memory();
+    if (unlikely(const_memory.is_enabled())) {
+      if (void *mem = const_memory.allocate0(size)) {
+        return mem;
+      }
+    }
     return heap_replacer->allocate0(size);
   }
   if (unlikely(!script_allocator_enabled)) {
@@ -114,6 +153,11 @@ void *allocate0(size_t size) noexcept {
     return nullptr;
   }
 
+  on_script_allocation(size);
+  auto &arena = dealer.get_script_arena();
+  if (unlikely(arena.is_enabled())) {
+    return arena.allocate0(size);
+  }
   return dealer.current_script_resource().allocate0(size);
 }
 
@@ -121,6 +165,10 @@ void *reallocate(void *mem, size_t new_size, size_t old_size) noexcept {
   php_assert(new_size > old_size);
   auto &dealer = get_memory_dealer();
   if (auto heap_replacer = dealer.heap_script_resource_replacer()) {
+    auto &const_memory = dealer.get_global_const_memory();
+    if (unlikely(const_memory.owns(mem))) {
+      return reallocate_global_const_memory(const_memory, *heap_replacer, mem, new_size, old_size);
+    }
     return heap_replacer->reallocate(mem, new_size, old_size);
   }
   if (unlikely(!script_allocator_enabled)) {
@@ -128,6 +176,12 @@ void *reallocate(void *mem, size_t new_size, size_t old_size) noexcept {
     return mem;
   }
 
+  on_script_allocation(new_size - old_size);
+  // the memory allocated before the arena scope stays in the script resource, so it can outlive the scope
+  auto &arena = dealer.get_script_arena();
+  if (unlikely(arena.owns(mem))) {
+    return arena.reallocate(mem, new_size, old_size);
+  }
   return dealer.current_script_resource().reallocate(mem, new_size, old_size);
 }
 
@@ -135,14 +189,58 @@ void deallocate(void *mem, size_t size) noexcept {
   php_assert(size);
   auto &dealer = get_memory_dealer();
   if (auto heap_replacer = dealer.heap_script_resource_replacer()) {
+    auto &const_memory = dealer.get_global_const_memory();
+    if (unlikely(const_memory.owns(mem))) {
+      return const_memory.deallocate(mem, size);
+    }
     return heap_replacer->deallocate(mem, size);
   }
 
   if (script_allocator_enabled) {
+    auto &arena = dealer.get_script_arena();
+    if (unlikely(arena.owns(mem))) {
+      arena.deallocate(mem, size);
+      return;
+    }
     dealer.current_script_resource().deallocate(mem, size);
   }
 }
 
+void enter_global_const_memory() noexcept {
+  auto &dealer = get_memory_dealer();
+  php_assert(dealer.heap_script_resource_replacer());
+  dealer.get_global_const_memory().enter();
+}
+
+void leave_global_const_memory() noexcept {
+  get_memory_dealer().get_global_const_memory().leave();
+}
+
+void seal_global_const_memory() noexcept {
+  get_memory_dealer().get_global_const_memory().seal();
+}
+
+size_t get_global_const_memory_size() noexcept {
+  return get_memory_dealer().get_global_const_memory().get_sealed_size();
+}
+
+memory_resource::script_arena::mark enter_script_arena() noexcept {
+  auto &dealer = get_memory_dealer();
+  return dealer.get_script_arena().enter(dealer.current_script_resource());
+}
+
+void leave_script_arena(const memory_resource::script_arena::mark &scope_mark) noexcept {
+  get_memory_dealer().get_script_arena().leave(scope_mark);
+}
+
+void suspend_script_arena() noexcept {
+  get_memory_dealer().get_script_arena().suspend();
+}
+
+void resume_script_arena() noexcept {
+  get_memory_dealer().get_script_arena().resume();
+}
+
 void *heap_allocate(size_t size) noexcept {
   php_assert(!query_num || !is_malloc_replaced());
   return get_memory_dealer().get_heap_resource().allocate(size);
@@ -289,6 +387,20 @@ void rollback_malloc_replacement() noexcept {
   MallocHooksSwitcher::get().switch_hooks(true);
 }
 
+bool is_script_allocator_replaced_with_heap() noexcept {
+  return get_memory_dealer().heap_script_resource_replacer() != nullptr;
+}
+
+void replace_script_allocator_with_heap() noexcept {
+  auto &dealer = get_memory_dealer();
+  php_assert(!is_malloc_replaced());
+  dealer.set_script_resource_replacer(dealer.get_heap_resource());
+}
+
+void rollback_script_allocator_replacement_with_heap() noexcept {
+  get_memory_dealer().drop_replacer();
+}
+
 } // namespace dl
 
 // replace global operators new and delete for linked C++ code
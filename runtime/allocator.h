@@ -9,7 +9,9 @@
 #include <memory>
 
 #include "common/containers/final_action.h"
+#include "common/mixin/not_copyable.h"
 #include "runtime/memory_resource/memory_resource.h"
+#include "runtime/memory_resource/script_arena.h"
 
 namespace memory_resource {
 class unsynchronized_pool_resource;
@@ -24,9 +26,10 @@ void restore_default_script_allocator(bool force_disable) noexcept;
 
 const memory_resource::MemoryStats &get_script_memory_stats() noexcept;
 size_t get_heap_memory_used() noexcept;
+size_t get_heap_memory_used_max() noexcept; // the high-water mark of the heap memory since the script allocator init
 
 void global_init_script_allocator() noexcept;
-void init_script_allocator(void *buffer, size_t buffer_size) noexcept; // init script allocator with arena of n bytes at buf
+void init_script_allocator(void *buffer, size_t buffer_size, size_t growth_step = 0) noexcept; // init script allocator with arena of n bytes at buf
 void free_script_allocator() noexcept;
 
 void *allocate(size_t n) noexcept; // allocate script memory
@@ -38,6 +41,17 @@ void *heap_allocate(size_t n) noexcept; // allocate heap memory (persistent betw
 void *heap_reallocate(void *p, size_t new_size, size_t old_size) noexcept; // reallocate heap memory
 void heap_deallocate(void *p, size_t n) noexcept; // deallocate heap memory
 
+memory_resource::script_arena::mark enter_script_arena() noexcept;
+void leave_script_arena(const memory_resource::script_arena::mark &scope_mark) noexcept;
+void suspend_script_arena() noexcept;
+void resume_script_arena() noexcept;
+
+// the script allocations of the global init go to the read-only segment of the global constants
+void enter_global_const_memory() noexcept;
+void leave_global_const_memory() noexcept;
+void seal_global_const_memory() noexcept;
+size_t get_global_const_memory_size() noexcept;
+
 void *script_allocator_malloc(size_t x) noexcept;
 void *script_allocator_calloc(size_t nmemb, size_t size) noexcept;
 void *script_allocator_realloc(void *p, size_t x) noexcept;
@@ -48,8 +62,24 @@ bool is_malloc_replaced() noexcept;
 void replace_malloc_with_script_allocator() noexcept;
 void rollback_malloc_replacement() noexcept;
 
+bool is_script_allocator_replaced_with_heap() noexcept;
+void replace_script_allocator_with_heap() noexcept;
+void rollback_script_allocator_replacement_with_heap() noexcept;
+
 } // namespace dl
 
+// replace script allocator so it starts to use a heap memory, e.g. for data that should outlive the script
+inline auto make_script_allocator_replacement_with_heap(bool replace = true) noexcept {
+  if (replace) {
+    dl::replace_script_allocator_with_heap();
+  }
+  return vk::finally([replace] {
+    if (replace) {
+      dl::rollback_script_allocator_replacement_with_heap();
+    }
+  });
+}
+
 // replace malloc so it starts to use a script memory
 inline auto make_malloc_replacement_with_script_allocator(bool replace = true) noexcept {
   if (replace) {
@@ -75,6 +105,30 @@ inline auto temporary_rollback_malloc_replacement() noexcept {
   });
 }
 
+// the script allocations made in the scope are bump-allocated and given back at once on the exit,
+// the compiler puts it into the @kphp-arena functions after checking that nothing they allocate escapes
+class ScriptArenaScope : vk::not_copyable {
+public:
+  ScriptArenaScope() noexcept :
+    mark_(dl::enter_script_arena()) {
+  }
+
+  ~ScriptArenaScope() noexcept {
+    dl::leave_script_arena(mark_);
+  }
+
+private:
+  memory_resource::script_arena::mark mark_;
+};
+
+// turn off the arena scope for the runtime state which lives till the end of the request
+inline auto make_script_arena_suspension() noexcept {
+  dl::suspend_script_arena();
+  return vk::finally([] {
+    dl::resume_script_arena();
+  });
+}
+
 class ManagedThroughDlAllocator {
 public:
   static void *operator new(size_t size) noexcept {
@@ -2,6 +2,10 @@
 
 #include "common/algorithms/fastmod.h"
 
+#if defined(KPHP_ARRAY_COMPACT_MAP) && defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
 #ifndef INCLUDED_FROM_KPHP_CORE
   #error "this file must be included only from kphp_core.h"
 #endif
@@ -40,59 +44,279 @@ array_size &array_size::min(const array_size &other) {
 
 namespace dl {
 
+namespace impl_ {
+
+// `compare(lhs, rhs) > 0` means that lhs goes after rhs
+
+constexpr int64_t SORT_INSERTION_THRESHOLD = 24;
+constexpr int64_t SORT_NINTHER_THRESHOLD = 128;
+constexpr int64_t SORT_PARTIAL_INSERTION_LIMIT = 8;
+constexpr int64_t RADIX_SORT_THRESHOLD = 512;
+
+// all loops are bounded by the range itself, so inconsistent user comparators can't make them go out of it
+
 template<class T, class T1>
-void sort(T *begin_init, T *end_init, const T1 &compare) {
-  T *begin_stack[32];
-  T *end_stack[32];
+void insertion_sort(T *begin, T *end, const T1 &compare) {
+  for (T *cur = begin + 1; cur < end; ++cur) {
+    if (compare(cur[-1], *cur) > 0) {
+      T tmp = std::move(*cur);
+      T *hole = cur;
+      do {
+        *hole = std::move(hole[-1]);
+        --hole;
+      } while (hole > begin && compare(hole[-1], tmp) > 0);
+      *hole = std::move(tmp);
+    }
+  }
+}
 
-  begin_stack[0] = begin_init;
-  end_stack[0] = end_init - 1;
+// gives up after several moves, returns whether the range is sorted
+template<class T, class T1>
+bool partial_insertion_sort(T *begin, T *end, const T1 &compare) {
+  int64_t moved = 0;
+  for (T *cur = begin + 1; cur < end; ++cur) {
+    if (compare(cur[-1], *cur) > 0) {
+      T tmp = std::move(*cur);
+      T *hole = cur;
+      do {
+        *hole = std::move(hole[-1]);
+        --hole;
+      } while (hole > begin && compare(hole[-1], tmp) > 0);
+      *hole = std::move(tmp);
+
+      moved += cur - hole;
+      if (moved > SORT_PARTIAL_INSERTION_LIMIT) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
 
-  for (int depth = 0; depth >= 0; --depth) {
-    T *begin = begin_stack[depth];
-    T *end = end_stack[depth];
+template<class T, class T1>
+void sort2(T *a, T *b, const T1 &compare) {
+  if (compare(*a, *b) > 0) {
+    swap(*a, *b);
+  }
+}
 
-    while (begin < end) {
-      const auto offset = (end - begin) >> 1;
-      swap(*begin, begin[offset]);
+template<class T, class T1>
+void sort3(T *a, T *b, T *c, const T1 &compare) {
+  sort2(a, b, compare);
+  sort2(b, c, compare);
+  sort2(a, b, compare);
+}
 
-      T *i = begin + 1, *j = end;
+// the pivot is *begin; returns its final position and whether the range was already partitioned,
+// the elements equal to the pivot go to the right part
+template<class T, class T1>
+std::pair<T *, bool> partition_right(T *begin, T *end, const T1 &compare) {
+  T pivot = std::move(*begin);
+  T *first = begin + 1;
+  T *last = end - 1;
 
-      while (1) {
-        while (i < j && compare(*begin, *i) > 0) {
-          i++;
-        }
+  while (first <= last && compare(pivot, *first) > 0) {
+    ++first;
+  }
+  while (first <= last && !(compare(pivot, *last) > 0)) {
+    --last;
+  }
 
-        while (i <= j && compare(*j, *begin) > 0) {
-          j--;
-        }
+  const bool already_partitioned = first > last;
+  while (first < last) {
+    swap(*first++, *last--);
+    while (first <= last && compare(pivot, *first) > 0) {
+      ++first;
+    }
+    while (first <= last && !(compare(pivot, *last) > 0)) {
+      --last;
+    }
+  }
 
-        if (i >= j) {
-          break;
-        }
+  T *pivot_pos = first - 1;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return {pivot_pos, already_partitioned};
+}
 
-        swap(*i++, *j--);
-      }
+// the same, but the elements equal to the pivot go to the left part;
+// used when the pivot is equal to the element before the range, so they need no more sorting
+template<class T, class T1>
+T *partition_left(T *begin, T *end, const T1 &compare) {
+  T pivot = std::move(*begin);
+  T *first = begin + 1;
+  T *last = end - 1;
+
+  while (first <= last && !(compare(*first, pivot) > 0)) {
+    ++first;
+  }
+  while (first <= last && compare(*last, pivot) > 0) {
+    --last;
+  }
 
-      swap(*begin, *j);
+  while (first < last) {
+    swap(*first++, *last--);
+    while (first <= last && !(compare(*first, pivot) > 0)) {
+      ++first;
+    }
+    while (first <= last && compare(*last, pivot) > 0) {
+      --last;
+    }
+  }
 
-      if (j - begin <= end - j) {
-        if (j + 1 < end) {
-          begin_stack[depth] = j + 1;
-          end_stack[depth++] = end;
-        }
-        end = j - 1;
-      } else {
-        if (begin < j - 1) {
-          begin_stack[depth] = begin;
-          end_stack[depth++] = j - 1;
-        }
-        begin = j + 1;
+  T *pivot_pos = first - 1;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return pivot_pos;
+}
+
+template<class T, class T1>
+void heap_sort(T *begin, T *end, const T1 &compare) {
+  const auto less = [&compare](const T &lhs, const T &rhs) { return compare(rhs, lhs) > 0; };
+  std::make_heap(begin, end, less);
+  std::sort_heap(begin, end, less);
+}
+
+// pattern-defeating quicksort: falls back to the heap sort after too many bad partitions,
+// handles the runs of equal elements and the already sorted ranges in linear time
+template<class T, class T1>
+void pdq_sort(T *begin, T *end, const T1 &compare, int bad_allowed, bool leftmost) {
+  while (true) {
+    const int64_t size = end - begin;
+    if (size < SORT_INSERTION_THRESHOLD) {
+      insertion_sort(begin, end, compare);
+      return;
+    }
+
+    const int64_t half = size / 2;
+    if (size > SORT_NINTHER_THRESHOLD) {
+      sort3(begin, begin + half, end - 1, compare);
+      sort3(begin + 1, begin + (half - 1), end - 2, compare);
+      sort3(begin + 2, begin + (half + 1), end - 3, compare);
+      sort3(begin + (half - 1), begin + half, begin + (half + 1), compare);
+      swap(*begin, begin[half]);
+    } else {
+      sort3(begin + half, begin, end - 1, compare);
+    }
+
+    if (!leftmost && !(compare(*begin, begin[-1]) > 0)) {
+      begin = partition_left(begin, end, compare) + 1;
+      continue;
+    }
+
+    const auto partition = partition_right(begin, end, compare);
+    T *pivot_pos = partition.first;
+    const int64_t left_size = pivot_pos - begin;
+    const int64_t right_size = end - (pivot_pos + 1);
+
+    if (left_size < size / 8 || right_size < size / 8) {
+      if (--bad_allowed == 0) {
+        heap_sort(begin, end, compare);
+        return;
       }
+
+      // break the patterns that made the pivot bad
+      if (left_size >= SORT_INSERTION_THRESHOLD) {
+        swap(begin[0], begin[left_size / 4]);
+        swap(pivot_pos[-1], pivot_pos[-left_size / 4]);
+      }
+      if (right_size >= SORT_INSERTION_THRESHOLD) {
+        swap(pivot_pos[1], pivot_pos[1 + right_size / 4]);
+        swap(end[-1], end[-right_size / 4]);
+      }
+    } else if (partition.second && partial_insertion_sort(begin, pivot_pos, compare) && partial_insertion_sort(pivot_pos + 1, end, compare)) {
+      return;
+    }
+
+    // recurse into the smaller part to keep the stack depth logarithmic
+    if (left_size < right_size) {
+      pdq_sort(begin, pivot_pos, compare, bad_allowed, leftmost);
+      begin = pivot_pos + 1;
+      leftmost = false;
+    } else {
+      pdq_sort(pivot_pos + 1, end, compare, bad_allowed, false);
+      end = pivot_pos;
     }
   }
 }
 
+// LSD radix sort by bytes, the bytes that are the same for all the values are skipped
+inline void radix_sort(int64_t *begin, int64_t *end, bool descending) {
+  const auto size = static_cast<size_t>(end - begin);
+  const auto to_key = [descending](int64_t value) {
+    const uint64_t key = static_cast<uint64_t>(value) ^ (uint64_t{1} << 63);
+    return descending ? ~key : key;
+  };
+
+  uint32_t counts[8][256] = {};
+  for (const int64_t *it = begin; it != end; ++it) {
+    const uint64_t key = to_key(*it);
+    for (int byte = 0; byte < 8; ++byte) {
+      ++counts[byte][(key >> (byte * 8)) & 0xff];
+    }
+  }
+
+  auto *buffer = static_cast<int64_t *>(allocate(size * sizeof(int64_t)));
+  int64_t *from = begin;
+  int64_t *to = buffer;
+  for (int byte = 0; byte < 8; ++byte) {
+    uint32_t *count = counts[byte];
+    if (count[(to_key(*from) >> (byte * 8)) & 0xff] == size) {
+      continue;
+    }
+
+    uint32_t offset = 0;
+    for (uint32_t &c : counts[byte]) {
+      const uint32_t bucket_size = c;
+      c = offset;
+      offset += bucket_size;
+    }
+    for (const int64_t *it = from; it != from + size; ++it) {
+      to[count[(to_key(*it) >> (byte * 8)) & 0xff]++] = *it;
+    }
+    std::swap(from, to);
+  }
+
+  if (from != begin) {
+    memcpy(begin, from, size * sizeof(int64_t));
+  }
+  deallocate(buffer, size * sizeof(int64_t));
+}
+
+// 1 for the comparators that order int64_t values ascending as plain numbers, -1 for the descending ones
+template<class T1>
+struct int64_sort_order : std::integral_constant<int, std::is_base_of<std::greater<int64_t>, T1>::value ? 1 : std::is_base_of<std::less<int64_t>, T1>::value ? -1 : 0> {
+};
+
+template<class T, class T1>
+bool try_radix_sort(T *, T *, const T1 &) {
+  return false;
+}
+
+template<class T1>
+bool try_radix_sort(int64_t *begin, int64_t *end, const T1 &) {
+  if (int64_sort_order<T1>::value == 0 || end - begin < RADIX_SORT_THRESHOLD) {
+    return false;
+  }
+  radix_sort(begin, end, int64_sort_order<T1>::value < 0);
+  return true;
+}
+
+} // namespace impl_
+
+template<class T, class T1>
+void sort(T *begin_init, T *end_init, const T1 &compare) {
+  if (impl_::try_radix_sort(begin_init, end_init, compare)) {
+    return;
+  }
+
+  int bad_allowed = 1;
+  for (auto size = end_init - begin_init; size > 1; size >>= 1) {
+    ++bad_allowed;
+  }
+  impl_::pdq_sort(begin_init, end_init, compare, bad_allowed, true);
+}
+
 } // namespace dl
 
 template<class T>
@@ -126,6 +350,146 @@ typename array<T>::array_inner *array<T>::array_inner::empty_array() {
   return reinterpret_cast<array_inner *>(array<Unknown>::array_inner::empty_array());
 }
 
+#ifdef KPHP_ARRAY_COMPACT_MAP
+
+template<class T>
+uint32_t array<T>::array_inner::index_size(uint32_t buf_size) {
+  // keep the index load factor below 7/8, so every probe sequence meets an empty slot
+  uint32_t size = INDEX_GROUP_SIZE;
+  while (size < buf_size + buf_size / 7 + 1) {
+    size <<= 1;
+  }
+  return size;
+}
+
+template<class T>
+uint64_t array<T>::array_inner::index_hash(int64_t key) {
+  const uint64_t h = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+  return h ^ (h >> 29);
+}
+
+template<class T>
+uint8_t array<T>::array_inner::index_tag(int64_t key) {
+  // the high bit is set only for empty and deleted slots
+  return static_cast<uint8_t>(index_hash(key) >> 57);
+}
+
+template<class T>
+uint32_t array<T>::array_inner::match_index_group(const uint8_t *group, uint8_t control) {
+#ifdef __SSE2__
+  const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(control)))));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < INDEX_GROUP_SIZE; ++i) {
+    mask |= static_cast<uint32_t>(group[i] == control) << i;
+  }
+  return mask;
+#endif
+}
+
+template<class T>
+uint32_t array<T>::array_inner::match_index_group_free(const uint8_t *group) {
+#ifdef __SSE2__
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < INDEX_GROUP_SIZE; ++i) {
+    mask |= static_cast<uint32_t>(group[i] >> 7) << i;
+  }
+  return mask;
+#endif
+}
+
+// the index is placed right after the string entries:
+// int control bytes, string control bytes, int entry numbers, string entry numbers
+template<class T>
+typename array<T>::map_index array<T>::array_inner::get_int_index() const {
+  auto *control = reinterpret_cast<uint8_t *>(const_cast<string_hash_entry *>(get_string_entries() + string_buf_size));
+  const uint32_t int_index_size = fields_for_map().int_index_mask + 1;
+  const uint32_t string_index_size = fields_for_map().string_index_mask + 1;
+  auto *entry_numbers = reinterpret_cast<uint32_t *>(control + int_index_size + string_index_size);
+  return map_index{control, entry_numbers, fields_for_map().int_index_mask};
+}
+
+template<class T>
+typename array<T>::map_index array<T>::array_inner::get_string_index() const {
+  const map_index int_index = get_int_index();
+  const uint32_t int_index_size = int_index.mask + 1;
+  return map_index{int_index.control + int_index_size, int_index.entry_numbers + int_index_size, fields_for_map().string_index_mask};
+}
+
+// returns the slot of the entry with the key or, if there is no such entry, the first free slot of its probe sequence
+template<class T>
+template<class EntryT, class KeyEqualT>
+uint32_t array<T>::array_inner::find_index_slot(const map_index &index, EntryT *entries, int64_t hash_key, const KeyEqualT &key_equal) noexcept {
+  const uint64_t hash = index_hash(hash_key);
+  const auto tag = static_cast<uint8_t>(hash >> 57);
+  uint32_t group = static_cast<uint32_t>(hash) & index.mask & ~(INDEX_GROUP_SIZE - 1);
+  uint32_t free_slot = std::numeric_limits<uint32_t>::max();
+  while (true) {
+    const uint8_t *group_control = index.control + group;
+    for (uint32_t matched = match_index_group(group_control, tag); matched; matched &= matched - 1) {
+      const uint32_t slot = group + __builtin_ctz(matched);
+      if (likely(key_equal(entries[index.entry_numbers[slot]]))) {
+        return slot;
+      }
+    }
+    if (free_slot == std::numeric_limits<uint32_t>::max()) {
+      if (const uint32_t free = match_index_group_free(group_control)) {
+        free_slot = group + __builtin_ctz(free);
+      }
+    }
+    if (match_index_group(group_control, INDEX_EMPTY)) {
+      return free_slot;
+    }
+    group = (group + INDEX_GROUP_SIZE) & index.mask;
+  }
+}
+
+template<class T>
+void array<T>::array_inner::erase_index_slot(const map_index &index, uint32_t slot, uint32_t &used) noexcept {
+  // lookups stop at the first group with an empty slot, so no probe sequence goes through such a group
+  // and the slot can be freed completely; in this case the last entry itself can be reused
+  if (match_index_group(index.control + (slot & ~(INDEX_GROUP_SIZE - 1)), INDEX_EMPTY)) {
+    index.control[slot] = INDEX_EMPTY;
+    if (index.entry_numbers[slot] + 1 == used) {
+      used--;
+    }
+  } else {
+    index.control[slot] = INDEX_DELETED;
+  }
+}
+
+template<class T>
+bool array<T>::array_inner::is_int_map_full() const {
+  return fields_for_map().int_used == int_buf_size;
+}
+
+template<class T>
+bool array<T>::array_inner::is_string_map_full() const {
+  return fields_for_map().string_used == string_buf_size;
+}
+
+template<class T>
+bool array<T>::array_inner::fits_map_size(int64_t new_int_size, int64_t new_string_size) const {
+  // the unset entries are not reused until the map is rebuilt
+  return fields_for_map().int_used - int_size + new_int_size <= int_buf_size &&
+         fields_for_map().string_used - string_size + new_string_size <= string_buf_size;
+}
+
+template<class T>
+int64_t array<T>::array_inner::int_map_capacity() const {
+  return int64_t{int_buf_size} - 2;
+}
+
+template<class T>
+int64_t array<T>::array_inner::string_map_capacity() const {
+  return int64_t{string_buf_size} - 2;
+}
+
+#else
+
 template<class T>
 uint32_t array<T>::array_inner::choose_bucket_int(int64_t key) const {
   return choose_bucket(key, int_buf_size, fields_for_map().modulo_helper_int_buf_size);
@@ -141,6 +505,33 @@ uint32_t array<T>::array_inner::choose_bucket(int64_t key, uint32_t buf_size, ui
   return fastmod::fastmod_u32(static_cast<uint32_t>(key << 2), modulo_helper, buf_size);
 }
 
+template<class T>
+bool array<T>::array_inner::is_int_map_full() const {
+  return int_size * 5 > 3 * int_buf_size;
+}
+
+template<class T>
+bool array<T>::array_inner::is_string_map_full() const {
+  return string_size * 5 > 3 * string_buf_size;
+}
+
+template<class T>
+bool array<T>::array_inner::fits_map_size(int64_t new_int_size, int64_t new_string_size) const {
+  return new_int_size * 5 <= 3 * int64_t{int_buf_size} && new_string_size * 5 <= 3 * int64_t{string_buf_size};
+}
+
+template<class T>
+int64_t array<T>::array_inner::int_map_capacity() const {
+  return int64_t{int_buf_size >> 1} - 1;
+}
+
+template<class T>
+int64_t array<T>::array_inner::string_map_capacity() const {
+  return int64_t{string_buf_size >> 1} - 1;
+}
+
+#endif
+
 template<class T>
 bool array<T>::array_inner::is_vector() const {
   return string_buf_size == std::numeric_limits<uint32_t>::max();
@@ -232,7 +623,11 @@ size_t array<T>::array_inner::sizeof_vector(uint32_t int_size) {
 
 template<class T>
 size_t array<T>::array_inner::sizeof_map(uint32_t int_size, uint32_t string_size) {
-  return sizeof(array_inner_fields_for_map) + sizeof(array_inner) + int_size * sizeof(int_hash_entry) + string_size * sizeof(string_hash_entry);
+  size_t size = sizeof(array_inner_fields_for_map) + sizeof(array_inner) + int_size * sizeof(int_hash_entry) + string_size * sizeof(string_hash_entry);
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  size += size_t{index_size(int_size) + index_size(string_size)} * (sizeof(uint8_t) + sizeof(uint32_t));
+#endif
+  return size;
 }
 
 template<class T>
@@ -250,6 +645,11 @@ size_t array<T>::array_inner::estimate_size(int64_t &new_int_size, int64_t &new_
     return sizeof_vector(static_cast<uint32_t>(new_int_size));
   }
 
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  // the entries are dense, the load factor is controlled by the index
+  new_int_size += 2;
+  new_string_size += 2;
+#else
   new_int_size = 2 * new_int_size + 3;
   if (new_int_size % 5 == 0) {
     new_int_size += 2;
@@ -259,6 +659,7 @@ size_t array<T>::array_inner::estimate_size(int64_t &new_int_size, int64_t &new_
   if (new_string_size % 5 == 0) {
     new_string_size += 2;
   }
+#endif
 
   return sizeof_map(static_cast<uint32_t>(new_int_size), static_cast<uint32_t>(new_string_size));
 }
@@ -288,10 +689,17 @@ typename array<T>::array_inner *array<T>::array_inner::create(int64_t new_int_si
   p->end()->prev = p->get_pointer(p->end());
 
   p->int_buf_size = static_cast<uint32_t>(new_int_size);
-  p->fields_for_map().modulo_helper_int_buf_size = fastmod::computeM_u32(p->int_buf_size);
-
   p->string_buf_size = static_cast<uint32_t>(new_string_size);
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  p->fields_for_map().int_index_mask = index_size(p->int_buf_size) - 1;
+  p->fields_for_map().string_index_mask = index_size(p->string_buf_size) - 1;
+  // entry numbers may stay zeroed, only the control bytes matter
+  const map_index int_index = p->get_int_index();
+  memset(int_index.control, INDEX_EMPTY, size_t{int_index.mask} + 1 + p->fields_for_map().string_index_mask + 1);
+#else
+  p->fields_for_map().modulo_helper_int_buf_size = fastmod::computeM_u32(p->int_buf_size);
   p->fields_for_map().modulo_helper_string_buf_size = fastmod::computeM_u32(p->string_buf_size);
+#endif
 
   p->int_size = 0;
   p->string_size = 0;
@@ -378,23 +786,39 @@ template<class T>
 template<class ...Args>
 T &array<T>::array_inner::emplace_int_key_map_value(overwrite_element policy, int64_t int_key, Args &&... args) noexcept {
   static_assert(std::is_constructible<T, Args...>{}, "should be constructible");
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  const map_index index = get_int_index();
+  const uint32_t slot = find_index_slot(index, int_entries, int_key, [int_key](const int_hash_entry &entry) { return entry.int_key == int_key; });
+  int_hash_entry *entry = nullptr;
+  if (index.control[slot] >= INDEX_EMPTY) {
+    uint32_t &int_used = fields_for_map().int_used;
+    php_assert (int_used < int_buf_size);
+    index.control[slot] = index_tag(int_key);
+    index.entry_numbers[slot] = int_used;
+    entry = &int_entries[int_used++];
+  } else {
+    entry = &int_entries[index.entry_numbers[slot]];
+  }
+#else
   uint32_t bucket = choose_bucket_int(int_key);
   while (int_entries[bucket].next != EMPTY_POINTER && int_entries[bucket].int_key != int_key) {
     if (unlikely (++bucket == int_buf_size)) {
       bucket = 0;
     }
   }
+  int_hash_entry *entry = &int_entries[bucket];
+#endif
 
-  if (int_entries[bucket].next == EMPTY_POINTER) {
-    int_entries[bucket].int_key = int_key;
+  if (entry->next == EMPTY_POINTER) {
+    entry->int_key = int_key;
 
-    int_entries[bucket].prev = end()->prev;
-    get_entry(end()->prev)->next = get_pointer(&int_entries[bucket]);
+    entry->prev = end()->prev;
+    get_entry(end()->prev)->next = get_pointer(entry);
 
-    int_entries[bucket].next = get_pointer(end());
-    end()->prev = get_pointer(&int_entries[bucket]);
+    entry->next = get_pointer(end());
+    end()->prev = get_pointer(entry);
 
-    new(&int_entries[bucket].value) T(std::forward<Args>(args)...);
+    new(&entry->value) T(std::forward<Args>(args)...);
 
     int_size++;
 
@@ -402,10 +826,10 @@ T &array<T>::array_inner::emplace_int_key_map_value(overwrite_element policy, in
       max_key = int_key;
     }
   } else if (policy == overwrite_element::YES) {
-    int_entries[bucket].value = T(std::forward<Args>(args)...);
+    entry->value = T(std::forward<Args>(args)...);
   }
 
-  return int_entries[bucket].value;
+  return entry->value;
 }
 
 template<class T>
@@ -422,6 +846,25 @@ void array<T>::array_inner::unset_vector_value() {
 
 template<class T>
 void array<T>::array_inner::unset_map_value(int64_t int_key) {
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  const map_index index = get_int_index();
+  const uint32_t slot = find_index_slot(index, int_entries, int_key, [int_key](const int_hash_entry &entry) { return entry.int_key == int_key; });
+  if (index.control[slot] < INDEX_EMPTY) {
+    int_hash_entry &entry = int_entries[index.entry_numbers[slot]];
+    entry.int_key = 0;
+
+    get_entry(entry.prev)->next = entry.next;
+    get_entry(entry.next)->prev = entry.prev;
+
+    entry.next = EMPTY_POINTER;
+    entry.prev = EMPTY_POINTER;
+
+    entry.value.~T();
+
+    int_size--;
+    erase_index_slot(index, slot, fields_for_map().int_used);
+  }
+#else
   uint32_t bucket = choose_bucket_int(int_key);
   while (int_entries[bucket].next != EMPTY_POINTER && int_entries[bucket].int_key != int_key) {
     if (unlikely (++bucket == int_buf_size)) {
@@ -469,11 +912,17 @@ void array<T>::array_inner::unset_map_value(int64_t int_key) {
 #undef FIXU
 #undef FIXD
   }
+#endif
 }
 
 template<class T>
 template<class S>
-auto &array<T>::array_inner::find_map_entry(S &self, int64_t int_key) noexcept {
+auto array<T>::array_inner::find_map_entry(S &self, int64_t int_key) noexcept -> decltype(&self.int_entries[0]) {
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  const map_index index = self.get_int_index();
+  const uint32_t slot = find_index_slot(index, self.int_entries, int_key, [int_key](const int_hash_entry &entry) { return entry.int_key == int_key; });
+  return index.control[slot] < INDEX_EMPTY ? &self.int_entries[index.entry_numbers[slot]] : nullptr;
+#else
   uint32_t bucket = self.choose_bucket_int(int_key);
   while (self.int_entries[bucket].next != EMPTY_POINTER && self.int_entries[bucket].int_key != int_key) {
     if (unlikely (++bucket == self.int_buf_size)) {
@@ -481,13 +930,21 @@ auto &array<T>::array_inner::find_map_entry(S &self, int64_t int_key) noexcept {
     }
   }
 
-  return self.int_entries[bucket];
+  return self.int_entries[bucket].next != EMPTY_POINTER ? &self.int_entries[bucket] : nullptr;
+#endif
 }
 
 template<class T>
 template<class S>
-auto &array<T>::array_inner::find_map_entry(S &self, const string &string_key, int64_t precomuted_hash) noexcept {
+auto array<T>::array_inner::find_map_entry(S &self, const string &string_key, int64_t precomuted_hash) noexcept -> decltype(self.get_string_entries()) {
   auto *string_entries = self.get_string_entries();
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  const map_index index = self.get_string_index();
+  const uint32_t slot = find_index_slot(index, string_entries, precomuted_hash, [&string_key, precomuted_hash](const string_hash_entry &entry) {
+    return entry.int_key == precomuted_hash && entry.string_key == string_key;
+  });
+  return index.control[slot] < INDEX_EMPTY ? &string_entries[index.entry_numbers[slot]] : nullptr;
+#else
   uint32_t bucket = self.choose_bucket_string(precomuted_hash);
   while (string_entries[bucket].next != EMPTY_POINTER &&
          (string_entries[bucket].int_key != precomuted_hash || string_entries[bucket].string_key != string_key)) {
@@ -496,14 +953,15 @@ auto &array<T>::array_inner::find_map_entry(S &self, const string &string_key, i
     }
   }
 
-  return string_entries[bucket];
+  return string_entries[bucket].next != EMPTY_POINTER ? &string_entries[bucket] : nullptr;
+#endif
 }
 
 template<class T>
 template<class ...Key>
 const T *array<T>::array_inner::find_map_value(Key &&... key) const noexcept {
-  const auto &entry = find_map_entry(*this, std::forward<Key>(key)...);
-  return entry.next != EMPTY_POINTER ? &entry.value : nullptr;
+  const auto *entry = find_map_entry(*this, std::forward<Key>(key)...);
+  return entry ? &entry->value : nullptr;
 }
 
 template<class T>
@@ -522,31 +980,49 @@ T &array<T>::array_inner::emplace_string_key_map_value(overwrite_element policy,
   static_assert(std::is_same<std::decay_t<STRING>, string>::value, "string_key should be string");
 
   string_hash_entry *string_entries = get_string_entries();
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  const map_index index = get_string_index();
+  const uint32_t slot = find_index_slot(index, string_entries, int_key, [&string_key, int_key](const string_hash_entry &entry) {
+    return entry.int_key == int_key && entry.string_key == string_key;
+  });
+  string_hash_entry *entry = nullptr;
+  if (index.control[slot] >= INDEX_EMPTY) {
+    uint32_t &string_used = fields_for_map().string_used;
+    php_assert (string_used < string_buf_size);
+    index.control[slot] = index_tag(int_key);
+    index.entry_numbers[slot] = string_used;
+    entry = &string_entries[string_used++];
+  } else {
+    entry = &string_entries[index.entry_numbers[slot]];
+  }
+#else
   uint32_t bucket = choose_bucket_string(int_key);
   while (string_entries[bucket].next != EMPTY_POINTER && (string_entries[bucket].int_key != int_key || string_entries[bucket].string_key != string_key)) {
     if (unlikely (++bucket == string_buf_size)) {
       bucket = 0;
     }
   }
+  string_hash_entry *entry = &string_entries[bucket];
+#endif
 
-  if (string_entries[bucket].next == EMPTY_POINTER) {
-    string_entries[bucket].int_key = int_key;
-    new(&string_entries[bucket].string_key) string{std::forward<STRING>(string_key)};
+  if (entry->next == EMPTY_POINTER) {
+    entry->int_key = int_key;
+    new(&entry->string_key) string{std::forward<STRING>(string_key)};
 
-    string_entries[bucket].prev = end()->prev;
-    get_entry(end()->prev)->next = get_pointer(&string_entries[bucket]);
+    entry->prev = end()->prev;
+    get_entry(end()->prev)->next = get_pointer(entry);
 
-    string_entries[bucket].next = get_pointer(end());
-    end()->prev = get_pointer(&string_entries[bucket]);
+    entry->next = get_pointer(end());
+    end()->prev = get_pointer(entry);
 
-    new(&string_entries[bucket].value) T(std::forward<Args>(args)...);
+    new(&entry->value) T(std::forward<Args>(args)...);
 
     string_size++;
   } else if (policy == overwrite_element::YES) {
-    string_entries[bucket].value = T(std::forward<Args>(args)...);
+    entry->value = T(std::forward<Args>(args)...);
   }
 
-  return string_entries[bucket].value;
+  return entry->value;
 }
 
 template<class T>
@@ -557,6 +1033,28 @@ T &array<T>::array_inner::set_map_value(overwrite_element policy, int64_t int_ke
 template<class T>
 void array<T>::array_inner::unset_map_value(const string &string_key, int64_t precomuted_hash) {
   string_hash_entry *string_entries = get_string_entries();
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  const map_index index = get_string_index();
+  const uint32_t slot = find_index_slot(index, string_entries, precomuted_hash, [&string_key, precomuted_hash](const string_hash_entry &entry) {
+    return entry.int_key == precomuted_hash && entry.string_key == string_key;
+  });
+  if (index.control[slot] < INDEX_EMPTY) {
+    string_hash_entry &entry = string_entries[index.entry_numbers[slot]];
+    entry.int_key = 0;
+    entry.string_key.~string();
+
+    get_entry(entry.prev)->next = entry.next;
+    get_entry(entry.next)->prev = entry.prev;
+
+    entry.next = EMPTY_POINTER;
+    entry.prev = EMPTY_POINTER;
+
+    entry.value.~T();
+
+    string_size--;
+    erase_index_slot(index, slot, fields_for_map().string_used);
+  }
+#else
   uint32_t bucket = choose_bucket_string(precomuted_hash);
   while (string_entries[bucket].next != EMPTY_POINTER && (string_entries[bucket].int_key != precomuted_hash || string_entries[bucket].string_key != string_key)) {
     if (unlikely (++bucket == string_buf_size)) {
@@ -605,6 +1103,7 @@ void array<T>::array_inner::unset_map_value(const string &string_key, int64_t pr
 #undef FIXU
 #undef FIXD
   }
+#endif
 }
 
 template<class T>
@@ -670,7 +1169,9 @@ bool array<T>::mutate_if_map_shared(uint32_t mul) {
 
 template<class T>
 void array<T>::mutate_if_vector_needed_int() {
-  if (mutate_if_vector_shared(2)) {
+  // most of the small arrays are filled by several pushes into the shared empty array:
+  // give them room for 4 elements at once (create() reserves 2 more) to avoid the second allocation
+  if (mutate_to_size_if_vector_shared(std::max(int64_t{p->int_size} * 2, int64_t{2}))) {
     return;
   }
 
@@ -699,9 +1200,9 @@ void array<T>::mutate_if_map_needed_int() {
   }
 
   // not shared (ref_cnt == 0)
-  if (p->int_size * 5 > 3 * p->int_buf_size) {
+  if (p->is_int_map_full()) {
     int64_t new_int_size = max(int64_t{p->int_size * 2 + 1}, int64_t{p->string_size});
-    int64_t new_string_size = max(int64_t{p->string_size}, int64_t{p->string_buf_size >> 1} - 1);
+    int64_t new_string_size = max(int64_t{p->string_size}, p->string_map_capacity());
     array_inner *new_array = array_inner::create(new_int_size, new_string_size, false);
 
     for (string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
@@ -726,8 +1227,8 @@ void array<T>::mutate_if_map_needed_string() {
   }
 
   // not shared (ref_cnt == 0)
-  if (p->string_size * 5 > 3 * p->string_buf_size) {
-    int64_t new_int_size = max(int64_t{p->int_size}, int64_t{p->int_buf_size >> 1} - 1);
+  if (p->is_string_map_full()) {
+    int64_t new_int_size = max(int64_t{p->int_size}, p->int_map_capacity());
     int64_t new_string_size = max(int64_t{p->string_size * 2 + 1}, int64_t{p->int_size});
     array_inner *new_array = array_inner::create(new_int_size, new_string_size, false);
 
@@ -1555,9 +2056,8 @@ typename array<T>::iterator array<T>::find_no_mutate(const string &string_key) n
 template<class T>
 template<class ...Key>
 typename array<T>::iterator array<T>::find_iterator_in_map_no_mutate(const Key &... key) noexcept {
-  list_hash_entry &map_entry = array_inner::find_map_entry(*p, key...);
-  if (map_entry.next != array_inner::EMPTY_POINTER) {
-    return iterator{p, &map_entry};
+  if (list_hash_entry *map_entry = array_inner::find_map_entry(*p, key...)) {
+    return iterator{p, map_entry};
   }
   return end_no_mutate();
 }
@@ -1616,6 +2116,12 @@ bool array<T>::isset(const K &key) const {
   return value ? !f$is_null(*value) : false;
 }
 
+template<class T>
+bool array<T>::isset(const string &string_key, int64_t precomuted_hash) const {
+  auto *value = find_value(string_key, precomuted_hash);
+  return value ? !f$is_null(*value) : false;
+}
+
 template<class T>
 void array<T>::unset(int64_t int_key) {
   if (is_vector()) {
@@ -1831,7 +2337,7 @@ array<T> &array<T>::operator+=(const array<T> &other) {
     uint32_t new_int_size = p->int_size + other.p->int_size;
     uint32_t new_string_size = p->string_size + other.p->string_size;
 
-    if (new_int_size * 5 > 3 * p->int_buf_size || new_string_size * 5 > 3 * p->string_buf_size || p->ref_cnt > 0) {
+    if (!p->fits_map_size(new_int_size, new_string_size) || p->ref_cnt > 0) {
       array_inner *new_array = array_inner::create(max(new_int_size, 2 * p->int_size) + 1, max(new_string_size, 2 * p->string_size) + 1, false);
 
       for (const string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
@@ -2024,12 +2530,9 @@ void array<T>::sort(const T1 &compare, bool renumber) {
       mutate_if_vector_shared();
     }
 
-    const auto elements_cmp =
-      [&compare](const T &lhs, const T &rhs) {
-        return compare(lhs, rhs) > 0;
-      };
+    // the comparator is passed as is, so the int64_t vectors can be recognized for the radix sort
     T *begin = reinterpret_cast<T *>(p->int_entries);
-    dl::sort<T, decltype(elements_cmp)>(begin, begin + n, elements_cmp);
+    dl::sort<T, T1>(begin, begin + n, compare);
     return;
   }
 
@@ -2099,25 +2602,10 @@ void array<T>::ksort(const T1 &compare) {
   for (uint32_t j = 0; j < n; j++) {
     list_hash_entry *cur;
     if (is_int_key(keysp[j])) {
-      int64_t int_key = keysp[j].to_int();
-      uint32_t bucket = p->choose_bucket_int(int_key);
-      while (p->int_entries[bucket].int_key != int_key) {
-        if (unlikely (++bucket == p->int_buf_size)) {
-          bucket = 0;
-        }
-      }
-      cur = (list_hash_entry * ) & p->int_entries[bucket];
+      cur = array_inner::find_map_entry(*p, keysp[j].to_int());
     } else {
       string string_key = keysp[j].to_string();
-      int64_t int_key = string_key.hash();
-      string_hash_entry *string_entries = p->get_string_entries();
-      uint32_t bucket = p->choose_bucket_string(int_key);
-      while ((string_entries[bucket].int_key != int_key || string_entries[bucket].string_key != string_key)) {
-        if (unlikely (++bucket == p->string_buf_size)) {
-          bucket = 0;
-        }
-      }
-      cur = (list_hash_entry * ) & string_entries[bucket];
+      cur = array_inner::find_map_entry(*p, string_key, string_key.hash());
     }
 
     cur->prev = p->get_pointer(prev);
@@ -2338,6 +2826,11 @@ bool array<T>::is_equal_inner_pointer(const array &other) const noexcept {
   return p == other.p;
 }
 
+template<class T>
+const void *array<T>::get_inner_pointer() const noexcept {
+  return p;
+}
+
 template<class T>
 void swap(array<T> &lhs, array<T> &rhs) {
   lhs.swap(rhs);
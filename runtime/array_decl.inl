@@ -81,10 +81,28 @@ private:
   // `max_key` and `string_size` could be also be there
   // but sometimes, for simplicity, we use them in vector too
   // to not add extra checks they are left in `array_inner`
+#ifdef KPHP_ARRAY_COMPACT_MAP
+  struct array_inner_fields_for_map {
+    // the number of used entries, including the unset ones
+    uint32_t int_used{0};
+    uint32_t string_used{0};
+    uint32_t int_index_mask{0};
+    uint32_t string_index_mask{0};
+  };
+
+  // the open-addressed index of a compact map: a control byte and an entry number for each slot,
+  // slots are probed by groups of INDEX_GROUP_SIZE control bytes
+  struct map_index {
+    uint8_t *control;
+    uint32_t *entry_numbers;
+    uint32_t mask;
+  };
+#else
   struct array_inner_fields_for_map {
     uint64_t modulo_helper_int_buf_size{0};
     uint64_t modulo_helper_string_buf_size{0};
   };
+#endif
 
   struct array_inner {
     //if key is number, int_key contains this number, there is no string_key.
@@ -130,9 +148,35 @@ private:
     inline array_inner_fields_for_map &fields_for_map() __attribute__((always_inline));
     inline const array_inner_fields_for_map &fields_for_map() const __attribute__((always_inline));
 
+#ifdef KPHP_ARRAY_COMPACT_MAP
+    static constexpr uint8_t INDEX_EMPTY = 0x80;
+    static constexpr uint8_t INDEX_DELETED = 0xfe;
+    static constexpr uint32_t INDEX_GROUP_SIZE = 16;
+
+    inline static uint32_t index_size(uint32_t buf_size) __attribute__((always_inline));
+    inline static uint64_t index_hash(int64_t key) __attribute__((always_inline));
+    inline static uint8_t index_tag(int64_t key) __attribute__((always_inline));
+    inline static uint32_t match_index_group(const uint8_t *group, uint8_t control) __attribute__((always_inline));
+    inline static uint32_t match_index_group_free(const uint8_t *group) __attribute__((always_inline));
+    inline map_index get_int_index() const __attribute__((always_inline));
+    inline map_index get_string_index() const __attribute__((always_inline));
+    template<class EntryT, class KeyEqualT>
+    inline static uint32_t find_index_slot(const map_index &index, EntryT *entries, int64_t hash_key, const KeyEqualT &key_equal) noexcept;
+    inline static void erase_index_slot(const map_index &index, uint32_t slot, uint32_t &used) noexcept;
+#else
     inline uint32_t choose_bucket_int(int64_t key) const __attribute__ ((always_inline));
     inline uint32_t choose_bucket_string(int64_t key) const __attribute__ ((always_inline));
     inline static uint32_t choose_bucket(int64_t key, uint32_t buf_size, uint64_t modulo_helper) __attribute__ ((always_inline));
+#endif
+
+    // whether one more int or string key doesn't fit, so the map should be rebuilt
+    inline bool is_int_map_full() const __attribute__((always_inline));
+    inline bool is_string_map_full() const __attribute__((always_inline));
+    // whether the map can hold that many keys without being rebuilt
+    inline bool fits_map_size(int64_t new_int_size, int64_t new_string_size) const __attribute__((always_inline));
+    // the sizes that create() should be called with to get the same buffers
+    inline int64_t int_map_capacity() const __attribute__((always_inline));
+    inline int64_t string_map_capacity() const __attribute__((always_inline));
 
     inline static size_t sizeof_vector(uint32_t int_size) __attribute__((always_inline));
     inline static size_t sizeof_map(uint32_t int_size, uint32_t string_size) __attribute__((always_inline));
@@ -165,11 +209,12 @@ private:
     inline void unset_vector_value();
     inline void unset_map_value(int64_t int_key);
 
-    // to avoid the const_cast, declare these functions as static with a template self parameter (this)
+    // to avoid the const_cast, declare these functions as static with a template self parameter (this);
+    // they return nullptr if there is no such key
     template<class S>
-    static inline auto &find_map_entry(S &self, int64_t int_key) noexcept;
+    static inline auto find_map_entry(S &self, int64_t int_key) noexcept -> decltype(&self.int_entries[0]);
     template<class S>
-    static inline auto &find_map_entry(S &self, const string &string_key, int64_t precomuted_hash) noexcept;
+    static inline auto find_map_entry(S &self, const string &string_key, int64_t precomuted_hash) noexcept -> decltype(self.get_string_entries());
 
     template<class ...Key>
     inline const T *find_map_value(Key &&... key) const noexcept;
@@ -347,6 +392,7 @@ public:
 
   template<class K>
   bool isset(const K &key) const;
+  bool isset(const string &string_key, int64_t precomuted_hash) const;
 
   void unset(int64_t int_key);
   void unset(int32_t key) { unset(int64_t{key}); }
@@ -409,6 +455,8 @@ public:
   const T *get_const_vector_pointer() const; // unsafe
 
   bool is_equal_inner_pointer(const array &other) const noexcept;
+  // identifies the array data, e.g. to cache something computed from a constant array
+  const void *get_inner_pointer() const noexcept;
 
   void reserve(int64_t int_size, int64_t string_size, bool make_vector_if_possible);
 
@@ -4,39 +4,49 @@
 
 #include "runtime/array_functions.h"
 
-array<string> explode(char delimiter, const string &str, int64_t limit) {
-  array<string> res(array_size(limit < 10 ? limit : 1, 0, true));
+namespace {
 
-  const string::size_type s_len = str.size();
+// the pieces are counted first, so the result array is allocated once;
+// if there is no delimiter, the result shares the string instead of copying it
+template<class FindDelimiter>
+array<string> explode_impl(const string &str, int64_t limit, size_t delimiter_len, const FindDelimiter &find_delimiter) {
   const char *s = str.c_str();
-  string::size_type prev = 0;
+  const char *s_end = s + str.size();
 
-  if (limit > 1) {
-    for (string::size_type i = 0; i < s_len;) {
-      if (delimiter == s[i]) {
-        res.push_back(string(s + prev, i - prev));
-        i++;
-        prev = i;
-        limit--;
-        if (limit == 1) {
-          break;
-        }
-      } else {
-        i++;
-      }
-    }
+  int64_t pieces = 1;
+  for (const char *d = s; pieces < limit && (d = find_delimiter(d, s_end)) != nullptr; d += delimiter_len) {
+    ++pieces;
   }
-  res.push_back(string(s + prev, s_len - prev));
 
+  array<string> res(array_size(pieces, 0, true));
+  if (pieces == 1) {
+    res.push_back(str);
+    return res;
+  }
+  const char *prev = s;
+  for (int64_t i = 1; i < pieces; ++i) {
+    const char *d = find_delimiter(prev, s_end);
+    res.push_back(string(prev, static_cast<string::size_type>(d - prev)));
+    prev = d + delimiter_len;
+  }
+  res.push_back(string(prev, static_cast<string::size_type>(s_end - prev)));
   return res;
 }
 
+} // namespace
+
+array<string> explode(char delimiter, const string &str, int64_t limit) {
+  return explode_impl(str, limit, 1, [delimiter](const char *s, const char *s_end) {
+    return static_cast<const char *>(memchr(s, delimiter, s_end - s));
+  });
+}
+
 array<string> f$explode(const string &delimiter, const string &str, int64_t limit) {
   if (limit < 1) {
     php_warning("Wrong limit %ld specified in function explode", limit);
     limit = 1;
   }
-  int64_t d_len = delimiter.size();
+  const string::size_type d_len = delimiter.size();
   if (d_len == 1) {
     return explode(delimiter[0], str, limit);
   }
@@ -45,34 +55,9 @@ array<string> f$explode(const string &delimiter, const string &str, int64_t limi
     return array<string>();
   }
 
-  array<string> res(array_size(limit < 10 ? limit : 1, 0, true));
-
-  const char *d = delimiter.c_str();
-  const char *s = str.c_str();
-  int64_t s_len = str.size();
-  int64_t prev = 0;
-
-  if (limit > 1) {
-    for (int64_t i = 0; i < s_len;) {
-      int64_t j = 0;
-      for (j = 0; j < d_len && d[j] == s[i + j]; j++) {
-      }
-      if (j == d_len) {
-        res.push_back(string(s + prev, static_cast<string::size_type>(i - prev)));
-        i += d_len;
-        prev = i;
-        limit--;
-        if (limit == 1) {
-          break;
-        }
-      } else {
-        i++;
-      }
-    }
-  }
-  res.push_back(string(s + prev, static_cast<string::size_type>(s_len - prev)));
-
-  return res;
+  return explode_impl(str, limit, d_len, [&delimiter, d_len](const char *s, const char *s_end) {
+    return static_cast<const char *>(memmem(s, s_end - s, delimiter.c_str(), d_len));
+  });
 }
 
 array<mixed> range_int(int64_t from, int64_t to, int64_t step) {
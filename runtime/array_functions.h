@@ -9,6 +9,7 @@
 
 #include "common/type_traits/constexpr_if.h"
 #include "common/type_traits/function_traits.h"
+#include "common/type_traits/list_of_types.h"
 #include "common/vector-product.h"
 
 #include "runtime/kphp_core.h"
@@ -50,12 +51,27 @@ array<T> f$array_filter(const array<T> &a, const T1 &callback) noexcept;
 template<class T, class T1>
 array<T> f$array_filter_by_key(const array<T> &a, const T1 &callback) noexcept;
 
+template<class T>
+array<T> f$array_filter(array<T> &&a) noexcept;
+
+template<class T, class T1>
+array<T> f$array_filter(array<T> &&a, const T1 &callback) noexcept;
+
+template<class T, class T1>
+array<T> f$array_filter_by_key(array<T> &&a, const T1 &callback) noexcept;
+
 template<class T>
 T f$array_merge(const T &a1);
 
 template<class T>
 T f$array_merge(const T &a1, const T &a2);
 
+template<class T, class = std::enable_if_t<!std::is_reference<T>::value>>
+T f$array_merge(T &&a1);
+
+template<class T, class = std::enable_if_t<!std::is_reference<T>::value>>
+T f$array_merge(T &&a1, const T &a2);
+
 template<class T>
 T f$array_merge(const T &a1, const T &a2, const T &a3, const T &a4 = T(), const T &a5 = T(), const T &a6 = T(),
                 const T &a7 = T(), const T &a8 = T(), const T &a9 = T(),
@@ -627,6 +643,30 @@ array<T> array_filter_impl(const array<T> &a, const F &pred) noexcept {
   return result;
 }
 
+// the array is a temporary or the last read of a variable: if nothing is filtered out, it is returned as is,
+// otherwise the elements kept before the first dropped one are copied without calling the predicate again
+template<class T, class F>
+array<T> array_filter_impl(array<T> &&a, const F &pred) noexcept {
+  auto it = a.cbegin();
+  while (it != a.cend() && pred(it)) {
+    ++it;
+  }
+  if (it == a.cend()) {
+    return std::move(a);
+  }
+
+  array<T> result(a.size());
+  for (auto kept = a.cbegin(); kept != it; ++kept) {
+    result.set_value(kept);
+  }
+  for (++it; it != a.cend(); ++it) {
+    if (pred(it)) {
+      result.set_value(it);
+    }
+  }
+  return result;
+}
+
 template<class T>
 array<T> f$array_filter(const array<T> &a) noexcept {
   return array_filter_impl(a, [](const auto &it) {
@@ -648,6 +688,27 @@ array<T> f$array_filter_by_key(const array<T> &a, const T1 &callback) noexcept {
   });
 }
 
+template<class T>
+array<T> f$array_filter(array<T> &&a) noexcept {
+  return array_filter_impl(std::move(a), [](const auto &it) {
+    return f$boolval(it.get_value());
+  });
+}
+
+template<class T, class T1>
+array<T> f$array_filter(array<T> &&a, const T1 &callback) noexcept {
+  return array_filter_impl(std::move(a), [&callback](const auto &it) {
+    return f$boolval(callback(it.get_value()));
+  });
+}
+
+template<class T, class T1>
+array<T> f$array_filter_by_key(array<T> &&a, const T1 &callback) noexcept {
+  return array_filter_impl(std::move(a), [&callback](const auto &it) {
+    return f$boolval(callback(it.get_key()));
+  });
+}
+
 
 template<class T, class CallbackT, class R = typename std::result_of<std::decay_t<CallbackT>(T)>::type>
 array<R> f$array_map(const CallbackT &callback, const array<T> &a) {
@@ -659,6 +720,17 @@ array<R> f$array_map(const CallbackT &callback, const array<T> &a) {
   return result;
 }
 
+// the values of an array that isn't shared are replaced in place, the keys and the order stay the same
+template<class T, class CallbackT, class R = typename std::result_of<std::decay_t<CallbackT>(T)>::type,
+         class = std::enable_if_t<std::is_same<R, T>::value>>
+array<T> f$array_map(const CallbackT &callback, array<T> &&a) {
+  for (auto &it : a) {
+    it.get_value() = callback(it.get_value());
+  }
+
+  return std::move(a);
+}
+
 template<class R, class T, class CallbackT, class InitialT>
 R f$array_reduce(const array<T> &a, const CallbackT &callback, InitialT initial) {
   R result(std::move(initial));
@@ -684,6 +756,24 @@ T f$array_merge(const T &a1, const T &a2) {
   return result;
 }
 
+// the int keys of a vector are already renumbered, so the merged values are appended to it in place
+template<class T, class>
+T f$array_merge(T &&a1) {
+  if (a1.is_vector()) {
+    return std::move(a1);
+  }
+  return f$array_merge(static_cast<const T &>(a1));
+}
+
+template<class T, class>
+T f$array_merge(T &&a1, const T &a2) {
+  if (a1.is_vector()) {
+    a1.merge_with(a2);
+    return std::move(a1);
+  }
+  return f$array_merge(static_cast<const T &>(a1), a2);
+}
+
 template<class T, class T1>
 void f$array_merge_into(T &a, const T1 &another_array) {
   a.merge_with(another_array);
@@ -729,6 +819,23 @@ T f$array_replace(const T &base_array,
            replacements_7), replacements_8),replacements_9), replacements_10), replacements_11);
 }
 
+namespace impl_ {
+// array_intersect(), array_diff() and array_unique() compare the values as strings by putting them into an array as keys;
+// an int is the same key as its decimal string, so it is put as is, without building the string
+template<class T>
+string value_as_key(const T &value) noexcept {
+  return f$strval(value);
+}
+
+inline int64_t value_as_key(int64_t value) noexcept {
+  return value;
+}
+
+inline mixed value_as_key(const mixed &value) noexcept {
+  return value.is_int() || value.is_string() ? value : mixed(f$strval(value));
+}
+} // namespace impl_
+
 template<class T, class T1>
 array<T> f$array_intersect_key(const array<T> &a1, const array<T1> &a2) {
   array<T> result(a1.size().min(a2.size()));
@@ -746,11 +853,11 @@ array<T> f$array_intersect(const array<T> &a1, const array<T1> &a2) {
 
   array<int64_t> values(array_size(0, a2.count(), false));
   for (const auto &it : a2) {
-    values.set_value(f$strval(it.get_value()), 1);
+    values.set_value(impl_::value_as_key(it.get_value()), 1);
   }
 
   for (const auto &it : a1) {
-    if (values.has_key(f$strval(it.get_value()))) {
+    if (values.has_key(impl_::value_as_key(it.get_value()))) {
       result.set_value(it);
     }
   }
@@ -795,11 +902,11 @@ array<T> f$array_diff(const array<T> &a1, const array<T1> &a2) {
 
   array<int64_t> values(array_size(0, a2.count(), false));
   for (const auto &it : a2) {
-    values.set_value(f$strval(it.get_value()), 1);
+    values.set_value(impl_::value_as_key(it.get_value()), 1);
   }
 
   for (const auto &it : a1) {
-    if (!values.has_key(f$strval(it.get_value()))) {
+    if (!values.has_key(impl_::value_as_key(it.get_value()))) {
       result.set_value(it);
     }
   }
@@ -887,8 +994,62 @@ bool f$array_key_exists(K, const array<T> &) {
   return false;
 }
 
+namespace impl_ {
+// the int and float vectors keep their values contiguously, so they are scanned by the index,
+// without the mode checks of the array iterators, and the compiler is free to vectorize the loops
+template<class T>
+using is_numeric_value = vk::is_type_in_list<T, int64_t, double>;
+
+// returns false if the array isn't a numeric vector, otherwise sets index to the position of the value or to the size
+template<class T, class T1>
+bool find_in_numeric_vector(const array<T> &, const T1 &, int64_t &, std::false_type) noexcept {
+  return false;
+}
+
+template<class T>
+bool find_in_numeric_vector(const array<T> &a, const T &value, int64_t &index, std::true_type) noexcept {
+  if (!a.is_vector()) {
+    return false;
+  }
+  const T *values = a.get_const_vector_pointer();
+  const int64_t size = a.count();
+  index = 0;
+  while (index < size && values[index] != value) {
+    ++index;
+  }
+  return true;
+}
+
+template<class T, class T1>
+bool find_in_numeric_vector(const array<T> &a, const T1 &value, int64_t &index) noexcept {
+  return find_in_numeric_vector(a, value, index, std::integral_constant<bool, is_numeric_value<T>{} && std::is_same<T, T1>{}>{});
+}
+
+template<class T, class ReturnT>
+bool sum_numeric_vector(const array<T> &, ReturnT &, std::false_type) noexcept {
+  return false;
+}
+
+template<class T, class ReturnT>
+bool sum_numeric_vector(const array<T> &a, ReturnT &result, std::true_type) noexcept {
+  if (!a.is_vector()) {
+    return false;
+  }
+  const T *values = a.get_const_vector_pointer();
+  const int64_t size = a.count();
+  for (int64_t i = 0; i < size; ++i) {
+    result += values[i];
+  }
+  return true;
+}
+} // namespace impl_
+
 template<class T, class T1>
 typename array<T>::key_type f$array_search(const T1 &val, const array<T> &a, bool strict) {
+  int64_t index = 0;
+  if (impl_::find_in_numeric_vector(a, val, index)) {
+    return index < a.count() ? typename array<T>::key_type(index) : typename array<T>::key_type(false);
+  }
   for (const auto &it : a) {
     if (strict ? equals(it.get_value(), val) : eq2(it.get_value(), val)) {
       return it.get_key();
@@ -983,7 +1144,7 @@ array<T> f$array_unique(const array<T> &a) {
 
   for (const auto &it : a) {
     const T &value = it.get_value();
-    int64_t &cnt = values[f$strval(value)];
+    int64_t &cnt = values[impl_::value_as_key(value)];
     if (!cnt) {
       cnt = 1;
       result.set_value(it);
@@ -1021,6 +1182,10 @@ array<typename array<T>::key_type> f$array_flip(const array<T> &a) {
 
 template<class T, class T1>
 bool f$in_array(const T1 &value, const array<T> &a, bool strict) {
+  int64_t index = 0;
+  if (impl_::find_in_numeric_vector(a, value, index)) {
+    return index < a.count();
+  }
   if (!strict) {
     for (const auto &it : a) {
       if (eq2(it.get_value(), value)) {
@@ -1188,8 +1353,15 @@ void f$shuffle(array<T> &a) {
     result.push_back(it.get_value());
   }
 
+  // the result is not shared, so its vector is swapped in place; the random element of the next step
+  // is chosen one step ahead to be prefetched, the sequence of mt_rand() calls stays the same
+  T *values = const_cast<T *>(result.get_const_vector_pointer());
+  int64_t j = f$mt_rand(0, 1);
   for (int64_t i = 1; i < n; i++) {
-    swap(result[i], result[f$mt_rand(0, i)]);
+    const int64_t next_j = i + 1 < n ? f$mt_rand(0, i + 1) : 0;
+    __builtin_prefetch(values + next_j);
+    swap(values[i], values[j]);
+    j = next_j;
   }
 
   a = std::move(result);
@@ -1215,6 +1387,10 @@ template<>
 struct sort_compare_numeric<int64_t> : std::greater<int64_t> {
 };
 
+template<>
+struct sort_compare<int64_t> : std::greater<int64_t> {
+};
+
 template<class T>
 struct sort_compare_string {
   bool operator()(const T &h1, const T &h2) const {
@@ -1264,6 +1440,10 @@ template<>
 struct rsort_compare_numeric<int64_t> : std::less<int64_t> {
 };
 
+template<>
+struct rsort_compare<int64_t> : std::less<int64_t> {
+};
+
 template<class T>
 struct rsort_compare_string {
   bool operator()(const T &h1, const T &h2) const {
@@ -1369,6 +1549,9 @@ ReturnT f$array_sum(const array<T> &a) {
   static_assert(!std::is_same<T, int>{}, "int is forbidden");
 
   ReturnT result = 0;
+  if (impl_::sum_numeric_vector(a, result, impl_::is_numeric_value<T>{})) {
+    return result;
+  }
   for (const auto &it : a) {
     result += vk::constexpr_if(
       std::is_same<T, int64_t>{},
@@ -1379,6 +1562,148 @@ ReturnT f$array_sum(const array<T> &a) {
 }
 
 
+// count(), array_sum(), array_values() and array_keys() of the array_filter() or array_map() result are compiled as one of these,
+// so the intermediate array isn't built; the callback is called for the same elements in the same order
+namespace array_pipeline {
+
+template<class T, class F, class Consumer>
+void for_each_filtered(const array<T> &a, const F &pred, const Consumer &consume) noexcept {
+  for (const auto &it : a) {
+    if (pred(it)) {
+      consume(it);
+    }
+  }
+}
+
+template<class T>
+auto by_value() noexcept {
+  return [](const typename array<T>::const_iterator &it) { return f$boolval(it.get_value()); };
+}
+
+template<class T, class T1>
+auto by_value(const T1 &callback) noexcept {
+  return [&callback](const typename array<T>::const_iterator &it) { return f$boolval(callback(it.get_value())); };
+}
+
+template<class T, class T1>
+auto by_key(const T1 &callback) noexcept {
+  return [&callback](const typename array<T>::const_iterator &it) { return f$boolval(callback(it.get_key())); };
+}
+
+template<class T, class F>
+int64_t count_of(const array<T> &a, const F &pred) noexcept {
+  int64_t result = 0;
+  for_each_filtered(a, pred, [&result](const auto &) { ++result; });
+  return result;
+}
+
+template<class T, class ReturnT = std::conditional_t<std::is_same<T, int64_t>{}, int64_t, double>>
+ReturnT sum_value(const T &value) noexcept {
+  return vk::constexpr_if(std::is_same<T, int64_t>{}, [&value] { return value; }, [&value] { return f$floatval(value); });
+}
+
+template<class T, class F, class ReturnT = std::conditional_t<std::is_same<T, int64_t>{}, int64_t, double>>
+ReturnT sum_of(const array<T> &a, const F &pred) noexcept {
+  ReturnT result = 0;
+  for_each_filtered(a, pred, [&result](const auto &it) { result += sum_value(it.get_value()); });
+  return result;
+}
+
+template<class T, class F>
+array<T> values_of(const array<T> &a, const F &pred) noexcept {
+  array<T> result(array_size(a.count(), 0, true));
+  for_each_filtered(a, pred, [&result](const auto &it) { result.push_back(it.get_value()); });
+  return result;
+}
+
+template<class T, class F>
+array<typename array<T>::key_type> keys_of(const array<T> &a, const F &pred) noexcept {
+  array<typename array<T>::key_type> result(array_size(a.count(), 0, true));
+  for_each_filtered(a, pred, [&result](const auto &it) { result.push_back(it.get_key()); });
+  return result;
+}
+
+template<class T>
+int64_t count_filter(const array<T> &a) noexcept {
+  return count_of(a, by_value<T>());
+}
+
+template<class T, class T1>
+int64_t count_filter(const array<T> &a, const T1 &callback) noexcept {
+  return count_of(a, by_value<T>(callback));
+}
+
+template<class T, class T1>
+int64_t count_filter_by_key(const array<T> &a, const T1 &callback) noexcept {
+  return count_of(a, by_key<T>(callback));
+}
+
+template<class T>
+auto sum_filter(const array<T> &a) noexcept {
+  return sum_of(a, by_value<T>());
+}
+
+template<class T, class T1>
+auto sum_filter(const array<T> &a, const T1 &callback) noexcept {
+  return sum_of(a, by_value<T>(callback));
+}
+
+template<class T, class T1>
+auto sum_filter_by_key(const array<T> &a, const T1 &callback) noexcept {
+  return sum_of(a, by_key<T>(callback));
+}
+
+template<class T, class CallbackT, class R = typename std::result_of<std::decay_t<CallbackT>(T)>::type,
+         class ReturnT = std::conditional_t<std::is_same<R, int64_t>{}, int64_t, double>>
+ReturnT sum_map(const CallbackT &callback, const array<T> &a) {
+  ReturnT result = 0;
+  for (const auto &it : a) {
+    result += sum_value<R>(callback(it.get_value()));
+  }
+  return result;
+}
+
+template<class T>
+array<T> values_filter(const array<T> &a) noexcept {
+  return values_of(a, by_value<T>());
+}
+
+template<class T, class T1>
+array<T> values_filter(const array<T> &a, const T1 &callback) noexcept {
+  return values_of(a, by_value<T>(callback));
+}
+
+template<class T, class T1>
+array<T> values_filter_by_key(const array<T> &a, const T1 &callback) noexcept {
+  return values_of(a, by_key<T>(callback));
+}
+
+template<class T, class CallbackT, class R = typename std::result_of<std::decay_t<CallbackT>(T)>::type>
+array<R> values_map(const CallbackT &callback, const array<T> &a) {
+  array<R> result(array_size(a.count(), 0, true));
+  for (const auto &it : a) {
+    result.push_back(callback(it.get_value()));
+  }
+  return result;
+}
+
+template<class T>
+array<typename array<T>::key_type> keys_filter(const array<T> &a) noexcept {
+  return keys_of(a, by_value<T>());
+}
+
+template<class T, class T1>
+array<typename array<T>::key_type> keys_filter(const array<T> &a, const T1 &callback) noexcept {
+  return keys_of(a, by_value<T>(callback));
+}
+
+template<class T, class T1>
+array<typename array<T>::key_type> keys_filter_by_key(const array<T> &a, const T1 &callback) noexcept {
+  return keys_of(a, by_key<T>(callback));
+}
+
+} // namespace array_pipeline
+
 template<class T>
 mixed f$getKeyByPos(const array<T> &a, int64_t pos) {
   auto it = a.middle(pos);
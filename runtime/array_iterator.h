@@ -31,7 +31,8 @@ public:
 
   inline array_iterator(inner_type *self, list_hash_type *entry) noexcept __attribute__ ((always_inline)):
     self_(self),
-    entry_(entry) {
+    entry_(entry),
+    is_vector_(self->is_vector()) {
   }
 
   inline operator array_iterator<const value_type>() noexcept __attribute__ ((always_inline)) {
@@ -39,15 +40,15 @@ public:
   }
 
   inline value_type &get_value() noexcept __attribute__ ((always_inline)) {
-    return self_->is_vector() ? *reinterpret_cast<value_type *>(entry_) : static_cast<int_hash_type *>(entry_)->value;
+    return is_vector_ ? *reinterpret_cast<value_type *>(entry_) : static_cast<int_hash_type *>(entry_)->value;
   }
 
   inline const value_type &get_value() const noexcept __attribute__ ((always_inline)) {
-    return self_->is_vector() ? *reinterpret_cast<value_type *>(entry_) : static_cast<int_hash_type *>(entry_)->value;
+    return is_vector_ ? *reinterpret_cast<value_type *>(entry_) : static_cast<int_hash_type *>(entry_)->value;
   }
 
   inline key_type get_key() const noexcept __attribute__ ((always_inline)) {
-    if (self_->is_vector()) {
+    if (is_vector_) {
       return key_type{static_cast<int64_t>(reinterpret_cast<value_type *>(entry_) - reinterpret_cast<value_type *>(self_->int_entries))};
     }
 
@@ -67,7 +68,7 @@ public:
   }
 
   inline bool is_string_key() const noexcept __attribute__ ((always_inline)) ubsan_supp("alignment") {
-    return !self_->is_vector() && self_->is_string_hash_entry(static_cast<const string_hash_type *>(entry_));
+    return !is_vector_ && self_->is_string_hash_entry(static_cast<const string_hash_type *>(entry_));
   }
 
   inline const_conditional_t<string> &get_string_key() noexcept __attribute__ ((always_inline)) {
@@ -79,14 +80,18 @@ public:
   }
 
   inline array_iterator &operator++() noexcept __attribute__ ((always_inline)) ubsan_supp("alignment") {
-    entry_ = self_->is_vector()
-             ? reinterpret_cast<list_hash_type *>(reinterpret_cast<value_type *>(entry_) + 1)
-             : self_->next(static_cast<string_hash_type *>(entry_));
+    if (is_vector_) {
+      entry_ = reinterpret_cast<list_hash_type *>(reinterpret_cast<value_type *>(entry_) + 1);
+    } else {
+      entry_ = self_->next(static_cast<string_hash_type *>(entry_));
+      // the map entries are linked in the insertion order, not in the memory order, so the entry after the next one is fetched in advance
+      __builtin_prefetch(self_->get_entry(entry_->next));
+    }
     return *this;
   }
 
   inline array_iterator &operator--() noexcept __attribute__ ((always_inline)) ubsan_supp("alignment") {
-    entry_ = self_->is_vector()
+    entry_ = is_vector_
              ? reinterpret_cast<list_hash_type *>(reinterpret_cast<value_type *>(entry_) - 1)
              : self_->prev(static_cast<string_hash_type *>(entry_));
     return *this;
@@ -183,4 +188,6 @@ public:
 private:
   inner_type *self_{nullptr};
   list_hash_type *entry_{nullptr};
+  // the mode of an array doesn't change while it is iterated, so it is checked once instead of on every step
+  bool is_vector_{false};
 };
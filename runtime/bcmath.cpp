@@ -4,6 +4,8 @@
 
 #include "runtime/bcmath.h"
 
+#include <array>
+
 static int bc_scale{0};
 
 static const string ONE("1", 1);
@@ -473,6 +475,137 @@ static string bc_add(const char *lhs, int lsign, int lint, int ldot, int lfrac,
   exit(1);
 }
 
+// Most of the operands are money amounts, which fit into 128-bit integers scaled by a power of 10.
+// The fast path computes the exact result natively and formats it the same way as the digit by digit
+// functions above do, the operands with more digits or a big scale are left to them
+namespace {
+
+using bc_uint128 = unsigned __int128;
+
+constexpr int BC_FIXED_MAX_DIGITS = 18;
+
+struct BcFixed {
+  bc_uint128 value;
+  int scale;
+  bool negative;
+};
+
+bc_uint128 bc_pow10(int power) {
+  static const auto table = [] {
+    std::array<bc_uint128, 39> powers{};
+    powers[0] = 1;
+    for (size_t i = 1; i < powers.size(); i++) {
+      powers[i] = powers[i - 1] * 10;
+    }
+    return powers;
+  }();
+  php_assert (0 <= power && power < static_cast<int>(table.size()));
+  return table[power];
+}
+
+// the numbers without the integer part like ".5" are left to the digit by digit functions to keep their results
+bool bc_to_fixed(const char *s, int sign, int lint, int ldot, int lfrac, int lscale, BcFixed &res) {
+  if (lint == ldot || ldot - lint + lscale > BC_FIXED_MAX_DIGITS) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (int i = lint; i < ldot; i++) {
+    value = value * 10 + s[i] - '0';
+  }
+  for (int i = 0; i < lscale; i++) {
+    value = value * 10 + s[lfrac + i] - '0';
+  }
+  res = BcFixed{value, lscale, sign < 0};
+  return true;
+}
+
+// writes the value with scale digits after the dot backwards from end, returns the first written position
+template<class T>
+char *bc_write_fixed(T value, int scale, char *end) {
+  for (int i = 0; i < scale; i++) {
+    *--end = static_cast<char>(value % 10 + '0');
+    value /= 10;
+  }
+  if (scale > 0) {
+    *--end = '.';
+  }
+  do {
+    *--end = static_cast<char>(value % 10 + '0');
+    value /= 10;
+  } while (value > 0);
+  return end;
+}
+
+// value has scale digits after the dot, then zeroes_to_append zeroes are added
+string bc_fixed_to_string(bc_uint128 value, int scale, int zeroes_to_append, bool negative) {
+  char buffer[128];
+  char *end = buffer + sizeof(buffer) - zeroes_to_append;
+  memset(end, '0', zeroes_to_append);
+  if (scale == 0 && zeroes_to_append > 0) {
+    *--end = '.';
+  }
+  // the 128-bit divisions are much slower, while the most of the values fit into 64 bits
+  char *begin = value <= std::numeric_limits<uint64_t>::max()
+                ? bc_write_fixed(static_cast<uint64_t>(value), scale, end)
+                : bc_write_fixed(value, scale, end);
+  if (negative) {
+    *--begin = '-';
+  }
+  return string(begin, static_cast<string::size_type>(buffer + sizeof(buffer) - begin));
+}
+
+// the result is truncated to exactly scale digits, it is negative if the exact sum is
+string bc_add_fixed(const BcFixed &lhs, const BcFixed &rhs, int scale) {
+  const int sum_scale = max(lhs.scale, rhs.scale);
+  const bc_uint128 lvalue = lhs.value * bc_pow10(sum_scale - lhs.scale);
+  const bc_uint128 rvalue = rhs.value * bc_pow10(sum_scale - rhs.scale);
+  bc_uint128 sum = 0;
+  bool negative = false;
+  if (lhs.negative == rhs.negative) {
+    sum = lvalue + rvalue;
+    negative = lhs.negative;
+  } else if (lvalue >= rvalue) {
+    sum = lvalue - rvalue;
+    negative = lhs.negative;
+  } else {
+    sum = rvalue - lvalue;
+    negative = rhs.negative;
+  }
+  negative = negative && sum != 0;
+  if (sum_scale > scale) {
+    return bc_fixed_to_string(sum / bc_pow10(sum_scale - scale), scale, 0, negative);
+  }
+  return bc_fixed_to_string(sum, sum_scale, scale - sum_scale, negative);
+}
+
+// the result keeps min(lhs.scale + rhs.scale, scale) digits, it is negative if the exact product is
+string bc_mul_fixed(const BcFixed &lhs, const BcFixed &rhs, int scale) {
+  const bc_uint128 product = lhs.value * rhs.value;
+  const int product_scale = lhs.scale + rhs.scale;
+  const int result_scale = min(product_scale, scale);
+  const bool negative = lhs.negative != rhs.negative && product != 0;
+  return bc_fixed_to_string(product / bc_pow10(product_scale - result_scale), result_scale, 0, negative);
+}
+
+// the quotient is truncated to exactly scale digits, it is negative if the truncated quotient is
+bool bc_div_fixed(const BcFixed &lhs, const BcFixed &rhs, int scale, string &result) {
+  if (rhs.value == 0) {
+    return false;
+  }
+  // lhs / rhs * 10^scale = lhs.value * 10^(rhs.scale + scale - lhs.scale) / rhs.value
+  const int shift = rhs.scale + scale - lhs.scale;
+  if (shift > 38 - BC_FIXED_MAX_DIGITS) {
+    return false;
+  }
+  const bc_uint128 quotient = shift >= 0
+                              ? lhs.value * bc_pow10(shift) / rhs.value
+                              : lhs.value / (rhs.value * bc_pow10(-shift));
+  result = bc_fixed_to_string(quotient, scale, 0, lhs.negative != rhs.negative && quotient != 0);
+  return true;
+}
+
+} // namespace
+
 
 void f$bcscale(int64_t scale) {
   if (scale < 0) {
@@ -510,6 +643,15 @@ string f$bcdiv(const string &lhs, const string &rhs, int64_t scale) {
     return ZERO;
   }
 
+  BcFixed lfixed, rfixed;
+  string result;
+  if (scale <= BC_FIXED_MAX_DIGITS &&
+      bc_to_fixed(lhs.c_str(), lsign, lint, ldot, lfrac, lscale, lfixed) &&
+      bc_to_fixed(rhs.c_str(), rsign, rint, rdot, rfrac, rscale, rfixed) &&
+      bc_div_fixed(lfixed, rfixed, static_cast<int>(scale), result)) {
+    return result;
+  }
+
   return bc_div_positive(lhs.c_str(), lint, ldot, lfrac, lscale,
                          rhs.c_str(), rint, rdot, rfrac, rscale,
                          static_cast<int>(scale), lsign * rsign);
@@ -647,6 +789,13 @@ string f$bcadd(const string &lhs, const string &rhs, int64_t scale) {
     return bc_zero(static_cast<int>(scale));
   }
 
+  BcFixed lfixed, rfixed;
+  if (scale <= BC_FIXED_MAX_DIGITS &&
+      bc_to_fixed(lhs.c_str(), lsign, lint, ldot, lfrac, lscale, lfixed) &&
+      bc_to_fixed(rhs.c_str(), rsign, rint, rdot, rfrac, rscale, rfixed)) {
+    return bc_add_fixed(lfixed, rfixed, static_cast<int>(scale));
+  }
+
   return bc_add(lhs.c_str(), lsign, lint, ldot, lfrac, lscale,
                 rhs.c_str(), rsign, rint, rdot, rfrac, rscale,
                 static_cast<int>(scale));
@@ -682,6 +831,13 @@ string f$bcsub(const string &lhs, const string &rhs, int64_t scale) {
 
   rsign *= -1;
 
+  BcFixed lfixed, rfixed;
+  if (scale <= BC_FIXED_MAX_DIGITS &&
+      bc_to_fixed(lhs.c_str(), lsign, lint, ldot, lfrac, lscale, lfixed) &&
+      bc_to_fixed(rhs.c_str(), rsign, rint, rdot, rfrac, rscale, rfixed)) {
+    return bc_add_fixed(lfixed, rfixed, static_cast<int>(scale));
+  }
+
   return bc_add(lhs.c_str(), lsign, lint, ldot, lfrac, lscale,
                 rhs.c_str(), rsign, rint, rdot, rfrac, rscale,
                 static_cast<int>(scale));
@@ -715,6 +871,12 @@ string f$bcmul(const string &lhs, const string &rhs, int64_t scale) {
     return ZERO;
   }
 
+  BcFixed lfixed, rfixed;
+  if (bc_to_fixed(lhs.c_str(), lsign, lint, ldot, lfrac, lscale, lfixed) &&
+      bc_to_fixed(rhs.c_str(), rsign, rint, rdot, rfrac, rscale, rfixed)) {
+    return bc_mul_fixed(lfixed, rfixed, static_cast<int>(min(scale, int64_t{2 * BC_FIXED_MAX_DIGITS})));
+  }
+
   return bc_mul_positive(lhs.c_str(), lint, ldot, lfrac, lscale,
                          rhs.c_str(), rint, rdot, rfrac, rscale,
                          static_cast<int>(scale), lsign * rsign);
@@ -40,6 +40,15 @@ class_instance<T> class_instance<T>::alloc(Args &&... args) {
   return *this;
 }
 
+template<class T>
+inline class_instance<T> class_instance<T>::alloc_on_stack(T &storage) {
+  static_assert(!std::is_empty<T>{}, "class T may not be empty");
+  php_assert(!o);
+  storage.set_refcnt(ExtraRefCnt::for_global_const);
+  new (&o) vk::intrusive_ptr<T>(&storage);
+  return *this;
+}
+
 template<class T>
 inline class_instance<T> class_instance<T>::empty_alloc() {
   static_assert(std::is_empty<T>{}, "class T must be empty");
@@ -74,6 +74,8 @@ public:
   template<class... Args>
   inline class_instance<T> alloc(Args &&... args) __attribute__((always_inline));
   inline class_instance<T> empty_alloc() __attribute__((always_inline));
+  // the storage must outlive all the copies of the instance, the refcounting doesn't touch it
+  inline class_instance<T> alloc_on_stack(T &storage) __attribute__((always_inline));
   inline void destroy() { o.reset(); }
   int64_t get_reference_counter() const { return o->get_refcnt(); }
 
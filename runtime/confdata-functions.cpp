@@ -4,9 +4,16 @@
 
 #include "runtime/confdata-functions.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
 #include "common/algorithms/contains.h"
 
 #include "runtime/confdata-global-manager.h"
+#include "runtime/critical_section.h"
 #include "runtime/string_functions.h"
 
 namespace {
@@ -46,6 +53,11 @@ public:
     return global_manager_.get_key_blacklist();
   }
 
+  uint64_t get_sample_generation() const noexcept {
+    php_assert(acquired_sample_);
+    return acquired_sample_->get_generation();
+  }
+
 private:
   ConfdataLocalManager() :
     global_manager_{ConfdataGlobalManager::get()} {};
@@ -54,6 +66,110 @@ private:
   const ConfdataSample *acquired_sample_{nullptr};
 };
 
+// The int keys of a section in the ascending order, with the pointers to their values in the sample.
+// The index of a section is built by the worker on the first range query of it and kept while the sample is the same,
+// the sample is immutable until the master resets it, and the reset changes the generation
+class ConfdataKeyRangeIndex : vk::not_copyable {
+public:
+  using SectionIndex = std::vector<std::pair<int64_t, const mixed *>>;
+
+  static ConfdataKeyRangeIndex &get() noexcept {
+    static ConfdataKeyRangeIndex index;
+    return index;
+  }
+
+  const SectionIndex &get_section_index(const mixed &section, uint64_t generation) noexcept {
+    dl::CriticalSectionGuard critical_section;
+    if (generation != generation_) {
+      sections_.clear();
+      generation_ = generation;
+    }
+    auto it = sections_.find(&section);
+    if (it != sections_.end()) {
+      return it->second;
+    }
+    const auto &section_array = section.as_array();
+    SectionIndex index;
+    index.reserve(section_array.count());
+    for (const auto &element : section_array) {
+      if (!element.is_string_key()) {
+        index.emplace_back(element.get_key().as_int(), &element.get_value());
+      }
+    }
+    std::sort(index.begin(), index.end(), [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+    return sections_.emplace(&section, std::move(index)).first->second;
+  }
+
+private:
+  ConfdataKeyRangeIndex() = default;
+
+  uint64_t generation_{0};
+  std::unordered_map<const mixed *, SectionIndex> sections_;
+};
+
+// A direct mapped table of the recently found keys with the pointers to their values in the acquired sample.
+// An entry is valid only for the sample generation it was filled with, so a new sample invalidates the whole table
+// without touching it. The misses are not cached, a missing key goes through the full lookup and the blacklist check
+class ConfdataHotKeyCache : vk::not_copyable {
+public:
+  static constexpr size_t ENTRIES = 1024;
+  static constexpr size_t MAX_KEY_LEN = 46;
+
+  static ConfdataHotKeyCache &get() noexcept {
+    static ConfdataHotKeyCache cache;
+    return cache;
+  }
+
+  // returns nullptr if the key is not cached, and the value of the found key otherwise
+  const mixed *find(const string &key, uint64_t generation) noexcept {
+    const Entry &entry = entries_[entry_index(key)];
+    if (entry.generation == generation && entry.key_len == key.size() && std::memcmp(entry.key, key.c_str(), key.size()) == 0) {
+      ++stats_.hits;
+      return entry.value;
+    }
+    ++stats_.misses;
+    return nullptr;
+  }
+
+  void store(const string &key, uint64_t generation, const mixed *value) noexcept {
+    Entry &entry = entries_[entry_index(key)];
+    entry.generation = generation;
+    entry.key_len = static_cast<uint16_t>(key.size());
+    std::memcpy(entry.key, key.c_str(), key.size());
+    entry.value = value;
+  }
+
+  static bool is_cacheable(const string &key) noexcept {
+    return key.size() <= MAX_KEY_LEN;
+  }
+
+  const ConfdataWorkerCacheStats &get_stats() const noexcept {
+    return stats_;
+  }
+
+private:
+  struct Entry {
+    // the generations of the samples start from 1, so the zeroed entries are invalid
+    uint64_t generation;
+    const mixed *value;
+    uint16_t key_len;
+    char key[MAX_KEY_LEN];
+  };
+  static_assert(sizeof(Entry) == 64, "an entry is expected to take a cache line");
+
+  ConfdataHotKeyCache() = default;
+
+  static size_t entry_index(const string &key) noexcept {
+    return static_cast<size_t>(key.hash()) & (ENTRIES - 1);
+  }
+
+  std::array<Entry, ENTRIES> entries_{};
+  ConfdataWorkerCacheStats stats_;
+};
+
+constexpr size_t ConfdataHotKeyCache::ENTRIES;
+constexpr size_t ConfdataHotKeyCache::MAX_KEY_LEN;
+
 bool verify_confdata_key_param(const string &param, const char *real_name) noexcept {
   if (unlikely(!ConfdataLocalManager::get().is_initialized())) {
     php_warning("Confdata is not initialized");
@@ -84,15 +200,17 @@ void free_confdata_functions_lib() {
   }
 }
 
+const ConfdataWorkerCacheStats &confdata_get_worker_cache_stats() noexcept {
+  return ConfdataHotKeyCache::get().get_stats();
+}
+
 bool f$is_confdata_loaded() noexcept {
   return ConfdataLocalManager::get().is_initialized();
 }
 
-mixed f$confdata_get_value(const string &key) noexcept {
-  if (unlikely(!verify_confdata_key_param(key, "key"))) {
-    return {};
-  }
+namespace {
 
+const mixed *find_confdata_value_in_sample(const string &key) noexcept {
   const auto &local_manager = ConfdataLocalManager::get();
   ConfdataKeyMaker key_maker;
   key_maker.update(key.c_str(), static_cast<int16_t>(key.size()), local_manager.get_predefined_wildcards());
@@ -101,19 +219,57 @@ mixed f$confdata_get_value(const string &key) noexcept {
   if (it != confdata_storage.end()) {
     // if key doesn't contain prefixes
     if (key_maker.get_first_key_type() == ConfdataFirstKeyType::simple_key) {
-      return it->second;
+      return &it->second;
     }
     // it must be an array (we loaded it this way)
     php_assert(it->second.is_array());
     if (auto *value = it->second.as_array().find_value(key_maker.get_second_key())) {
-      return *value;
+      return value;
     }
   }
 
   if (unlikely(local_manager.get_key_blacklist().is_blacklisted(vk::string_view{key.c_str(), key.size()}))) {
     php_warning("Trying to get blacklisted key '%s'", key.c_str());
   }
-  return {};
+  return nullptr;
+}
+
+// the value lives in the acquired confdata sample till the end of the request
+const mixed *find_confdata_value(const string &key) noexcept {
+  if (unlikely(!verify_confdata_key_param(key, "key"))) {
+    return nullptr;
+  }
+  if (!ConfdataHotKeyCache::is_cacheable(key)) {
+    return find_confdata_value_in_sample(key);
+  }
+
+  auto &cache = ConfdataHotKeyCache::get();
+  const uint64_t generation = ConfdataLocalManager::get().get_sample_generation();
+  if (const mixed *value = cache.find(key, generation)) {
+    return value;
+  }
+  const mixed *value = find_confdata_value_in_sample(key);
+  if (value) {
+    cache.store(key, generation, value);
+  }
+  return value;
+}
+
+} // namespace
+
+mixed f$confdata_get_value(const string &key) noexcept {
+  const mixed *value = find_confdata_value(key);
+  return value ? *value : mixed{};
+}
+
+int64_t f$confdata_get_int(const string &key, int64_t default_value) noexcept {
+  const mixed *value = find_confdata_value(key);
+  return value ? value->to_int() : default_value;
+}
+
+string f$confdata_get_string(const string &key, const string &default_value) noexcept {
+  const mixed *value = find_confdata_value(key);
+  return value ? value->to_string() : default_value;
 }
 
 array<mixed> f$confdata_get_values_by_any_wildcard(const string &wildcard) noexcept {
@@ -145,10 +301,19 @@ array<mixed> f$confdata_get_values_by_any_wildcard(const string &wildcard) noexc
     // if the second key is not an empty string, then we need a prefix matching subset
     array<mixed> result;
     const auto second_key_prefix = key_maker.get_second_key().to_string();
-    for (const auto &second_key_it : second_key_array) {
-      const string key_str = second_key_it.get_key().to_string();
+    const auto prefix_size = second_key_prefix.size();
+    // the int keys are printed only if the prefix can match them at all
+    const bool may_match_int_keys = second_key_prefix[0] == '-' || ('0' <= second_key_prefix[0] && second_key_prefix[0] <= '9');
+    auto add_if_matches = [&](const string &key_str, const mixed &value) {
       if (key_str.starts_with(second_key_prefix)) {
-        result.set_value(f$substr(key_str, second_key_prefix.size()).val(), second_key_it.get_value());
+        result.set_value(string{key_str.c_str() + prefix_size, key_str.size() - prefix_size}, value);
+      }
+    };
+    for (const auto &second_key_it : second_key_array) {
+      if (second_key_it.is_string_key()) {
+        add_if_matches(second_key_it.get_string_key(), second_key_it.get_value());
+      } else if (may_match_int_keys) {
+        add_if_matches(second_key_it.get_key().to_string(), second_key_it.get_value());
       }
     }
     return result;
@@ -217,3 +382,36 @@ array<mixed> f$confdata_get_values_by_predefined_wildcard(const string &wildcard
   }
   return {};
 }
+
+array<mixed> f$confdata_get_values_by_key_range(const string &prefix, int64_t from, int64_t to) noexcept {
+  if (unlikely(!verify_confdata_key_param(prefix, "prefix"))) {
+    return {};
+  }
+  if (unlikely(prefix[prefix.size() - 1] != '.')) {
+    php_warning("Confdata key range prefix '%s' must end with a dot", prefix.c_str());
+    return {};
+  }
+
+  const auto &local_manager = ConfdataLocalManager::get();
+  const auto &confdata_storage = local_manager.get_confdata_storage();
+  const auto section_it = confdata_storage.find(prefix);
+  if (section_it == confdata_storage.end() || from > to) {
+    return {};
+  }
+  // it must be an array (we loaded it this way)
+  php_assert(section_it->second.is_array());
+
+  const auto &index = ConfdataKeyRangeIndex::get().get_section_index(section_it->second, local_manager.get_sample_generation());
+  const auto key_less = [](const std::pair<int64_t, const mixed *> &element, int64_t key) { return element.first < key; };
+  const auto first = std::lower_bound(index.begin(), index.end(), from, key_less);
+  auto last = first;
+  while (last != index.end() && last->first <= to) {
+    ++last;
+  }
+
+  array<mixed> result{array_size{static_cast<int64_t>(last - first), 0, false}};
+  for (auto it = first; it != last; ++it) {
+    result.set_value(it->first, *it->second);
+  }
+  return result;
+}
@@ -8,11 +8,24 @@
 void init_confdata_functions_lib();
 void free_confdata_functions_lib();
 
+// the lookups of the worker local cache of the confdata keys, in front of the shared sample
+struct ConfdataWorkerCacheStats {
+  uint64_t hits{0};
+  uint64_t misses{0};
+};
+const ConfdataWorkerCacheStats &confdata_get_worker_cache_stats() noexcept;
 
 bool f$is_confdata_loaded() noexcept;
 
 mixed f$confdata_get_value(const string &key) noexcept;
 
+// convert the value in place, without copying it into a mixed first
+int64_t f$confdata_get_int(const string &key, int64_t default_value = 0) noexcept;
+string f$confdata_get_string(const string &key, const string &default_value = string{}) noexcept;
+
 array<mixed> f$confdata_get_values_by_any_wildcard(const string &wildcard) noexcept;
 
 array<mixed> f$confdata_get_values_by_predefined_wildcard(const string &wildcard) noexcept;
+
+// the elements of the section 'prefix.' with the int keys from 'from' to 'to' inclusive, in the ascending order of the keys
+array<mixed> f$confdata_get_values_by_key_range(const string &prefix, int64_t from, int64_t to) noexcept;
@@ -4,6 +4,8 @@
 
 #include "runtime/confdata-global-manager.h"
 
+#include "common/huge-pages.h"
+
 #include "runtime/php_assert.h"
 
 namespace {
@@ -38,11 +40,16 @@ void ConfdataSample::init(memory_resource::unsynchronized_pool_resource &resourc
   auto *mem = resource_->allocate(sizeof(*confdata_storage_));
   php_assert(mem);
   confdata_storage_ = new(mem) confdata_sample_storage{confdata_sample_storage::allocator_type{*resource_}};
+  generation_ = static_cast<uint64_t *>(resource_->allocate(sizeof(*generation_)));
+  php_assert(generation_);
+  *generation_ = 0;
 }
 
 void ConfdataSample::reset(confdata_sample_storage &&new_confdata) noexcept {
+  static uint64_t last_generation = 0;
   clear();
   *confdata_storage_ = std::move(new_confdata);
+  *generation_ = ++last_generation;
 }
 
 void ConfdataSample::clear() noexcept {
@@ -73,8 +80,10 @@ void ConfdataSample::destroy() noexcept {
     clear();
     confdata_storage_->~map();
     resource_->deallocate(confdata_storage_, sizeof(*confdata_storage_));
+    resource_->deallocate(generation_, sizeof(*generation_));
 
     confdata_storage_ = nullptr;
+    generation_ = nullptr;
     resource_ = nullptr;
   }
 }
@@ -95,8 +104,7 @@ ConfdataGlobalManager &ConfdataGlobalManager::get() noexcept {
 void ConfdataGlobalManager::init(size_t confdata_memory_limit,
                                  std::unordered_set<vk::string_view> &&predefined_wilrdcards,
                                  std::unique_ptr<re2::RE2> &&blacklist_pattern) noexcept {
-  void *confdata_memory = mmap(nullptr, confdata_memory_limit,
-                               PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, -1, 0);
+  void *confdata_memory = mmap_shared_memory(confdata_memory_limit);
   php_assert(confdata_memory);
   resource_.init(confdata_memory, confdata_memory_limit);
   confdata_samples_.init(resource_);
@@ -104,6 +112,22 @@ void ConfdataGlobalManager::init(size_t confdata_memory_limit,
   key_blacklist_.set_blacklist(std::move(blacklist_pattern));
 }
 
+bool ConfdataGlobalManager::compact_memory_if_fragmented() noexcept {
+  const auto &memory_stats = resource_.get_memory_stats();
+  const size_t free_pieces = memory_stats.small_memory_pieces + memory_stats.huge_memory_pieces;
+  // the defragmentation walks through all the free pieces, don't repeat it until they grow noticeably
+  if (free_pieces < 2 * free_pieces_after_last_compaction_ + 1024) {
+    return false;
+  }
+  const size_t free_memory = memory_stats.memory_limit - memory_stats.memory_used;
+  if (resource_.get_largest_free_piece_size() >= free_memory / 2) {
+    return false;
+  }
+  resource_.perform_defragmentation();
+  free_pieces_after_last_compaction_ = memory_stats.small_memory_pieces + memory_stats.huge_memory_pieces;
+  return true;
+}
+
 ConfdataGlobalManager::~ConfdataGlobalManager() noexcept {
   if (confdata_samples_.is_initial_process() && is_initialized()) {
     confdata_samples_.destroy();
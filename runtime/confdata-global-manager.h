@@ -40,9 +40,16 @@ public:
     return *confdata_storage_;
   }
 
+  // changes on every reset, so the workers can tell the new content of a reused sample from the old one
+  uint64_t get_generation() const noexcept {
+    return *generation_;
+  }
+
 private:
   memory_resource::unsynchronized_pool_resource *resource_{nullptr};
   confdata_sample_storage *confdata_storage_{nullptr};
+  // lives in the shared memory next to the storage, as the samples are reset by the master only
+  uint64_t *generation_{nullptr};
   std::forward_list<ConfdataGarbageNode> *garbage_{nullptr};
 };
 
@@ -84,6 +91,9 @@ public:
     return confdata_samples_.clear_dirty_unused_resources_in_sequence();
   }
 
+  // merges the memory released by the old samples in advance, so the next update doesn't hit a failed huge allocation
+  bool compact_memory_if_fragmented() noexcept;
+
   memory_resource::unsynchronized_pool_resource &get_resource() noexcept {
     return resource_;
   }
@@ -106,6 +116,7 @@ private:
   ConfdataGlobalManager() = default;
   memory_resource::unsynchronized_pool_resource resource_;
   InterProcessResourceManager<ConfdataSample, 30> confdata_samples_;
+  size_t free_pieces_after_last_compaction_{0};
 
   ConfdataPredefinedWildcards predefined_wildcards_;
   ConfdataKeyBlacklist key_blacklist_;
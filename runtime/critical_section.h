@@ -7,14 +7,35 @@
 #include <utility>
 
 #include "common/mixin/not_copyable.h"
+#include "common/wrappers/likely.h"
+
+#include "runtime/php_assert.h"
+
+void check_stack_overflow();
 
 namespace dl {
 
 extern volatile int in_critical_section;
 extern volatile long long pending_signals;
 
-void enter_critical_section() noexcept;
-void leave_critical_section() noexcept;
+void raise_pending_signals() noexcept;
+
+// the critical sections wrap the allocations and the other runtime calls which mustn't be interrupted
+// by the timeout or the memory limit, so entering and leaving them is inlined
+inline void enter_critical_section() noexcept {
+  check_stack_overflow();
+  php_assert (in_critical_section >= 0);
+  in_critical_section = in_critical_section + 1;
+}
+
+inline void leave_critical_section() noexcept {
+  in_critical_section = in_critical_section - 1;
+  php_assert (in_critical_section >= 0);
+  // the signals caught inside are delivered when the outermost critical section is left
+  if (unlikely(pending_signals) && in_critical_section <= 0) {
+    raise_pending_signals();
+  }
+}
 
 struct CriticalSectionGuard : private vk::not_copyable {
   CriticalSectionGuard() noexcept { enter_critical_section(); }
@@ -4,6 +4,7 @@
 
 #include "runtime/curl.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <curl/curl.h>
@@ -14,7 +15,12 @@
 #include "runtime/global_storage.h"
 #include "runtime/integer_types.h"
 #include "runtime/interface.h"
+#include "runtime/net_events.h"
 #include "runtime/openssl.h"
+#include "runtime/resumable.h"
+#include "server/php-queries.h"
+#include "server/php-tracing.h"
+#include "common/precise-time.h"
 #include "common/smart_ptrs/singleton.h"
 #include "common/wrappers/to_array.h"
 
@@ -138,6 +144,18 @@ public:
     error_msg[0] = '\0';
   }
 
+  mixed get_exec_result() const noexcept {
+    if (error_num != CURLE_OK && error_num != CURLE_PARTIAL_FILE) {
+      return false;
+    }
+
+    if (return_transfer) {
+      return result;
+    }
+
+    return true;
+  }
+
   void cleanup_slists_and_posts() noexcept {
     const auto last_slist = slists_to_free.cend();
     for (auto p = slists_to_free.cbegin(); p != last_slist; ++p) {
@@ -167,6 +185,8 @@ public:
   Optional<string> private_data{false};
 
   bool return_transfer{false};
+  // the forked resumable, which is run when the transfer of curl_exec_concurrently() finishes
+  int64_t transfer_resumable_id{0};
 };
 
 class MultiContext : public BaseContext {
@@ -189,6 +209,13 @@ struct CurlContexts_ {
   array<EasyContext *> easy_contexts;
   array<MultiContext *> multi_contexts;
 
+  // the transfers of curl_exec_concurrently() share one multi handle, its sockets are watched by the engine reactor
+  // and its timeouts are the runtime event timers, so the script waits for them like for the rpc answers
+  CURLM *scheduler{nullptr};
+  // the socket -> CURL_POLL_* which curl waits for
+  array<int64_t> scheduler_sockets;
+  event_timer *scheduler_timer{nullptr};
+
   template<typename T>
   T *get_value(int64_t id) const noexcept;
 };
@@ -668,18 +695,177 @@ mixed f$curl_exec(curl_easy easy_id) noexcept {
     return false;
   }
 
+  auto &tracing = Tracing::get();
+  const double start_time = tracing.sampled() ? get_utime_monotonic() : 0;
   easy_context->cleanup_for_next_request();
   easy_context->error_num = dl::critical_section_call(curl_easy_perform, easy_context->easy_handle);
+  if (unlikely(tracing.sampled())) {
+    curl_off_t uploaded = 0;
+    curl_off_t downloaded = 0;
+    dl::critical_section_call([&] {
+      curl_easy_getinfo(easy_context->easy_handle, CURLINFO_SIZE_UPLOAD_T, &uploaded);
+      curl_easy_getinfo(easy_context->easy_handle, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    });
+    tracing.add_span(Tracing::SpanKind::curl, -1, static_cast<uint32_t>(uploaded), static_cast<uint32_t>(downloaded),
+                     easy_context->error_num, start_time, get_utime_monotonic());
+  }
+  return easy_context->get_exec_result();
+}
+
+static int curl_timeout_wakeup_id = -1;
+
+int curl_scheduler_socket(CURL *, curl_socket_t fd, int what, void *, void *) noexcept {
+  auto &sockets = CurlContexts::get()->scheduler_sockets;
+  if (what == CURL_POLL_REMOVE) {
+    sockets.unset(fd);
+    curl_watch_socket(fd, 0);
+  } else {
+    sockets.set_value(fd, what);
+    curl_watch_socket(fd, what);
+  }
+  return 0;
+}
+
+int curl_scheduler_timer(CURLM *, long timeout_ms, void *) noexcept {
+  auto &timer = CurlContexts::get()->scheduler_timer;
+  if (timer) {
+    remove_event_timer(timer);
+    timer = nullptr;
+  }
+  if (timeout_ms >= 0) {
+    // the zero timeout asks to call curl_multi_socket_action() as soon as possible
+    timer = allocate_event_timer(get_precise_now() + static_cast<double>(std::max(timeout_ms, 1L)) * 0.001, curl_timeout_wakeup_id, 0);
+  }
+  return 0;
+}
+
+class curl_transfer_resumable final : public Resumable {
+protected:
+  bool run() final {
+    RETURN_VOID();
+  }
+};
+
+CURLM *get_curl_scheduler() noexcept {
+  CURLM *&scheduler = CurlContexts::get()->scheduler;
+  if (!scheduler) {
+    scheduler = dl::critical_section_call(curl_multi_init);
+    if (scheduler) {
+      dl::critical_section_call([&] {
+        curl_multi_setopt(scheduler, CURLMOPT_SOCKETFUNCTION, curl_scheduler_socket);
+        curl_multi_setopt(scheduler, CURLMOPT_TIMERFUNCTION, curl_scheduler_timer);
+      });
+    }
+  }
+  return scheduler;
+}
+
+void finish_curl_transfer(EasyContext *easy_context, int64_t error_num) noexcept {
+  dl::critical_section_call(curl_multi_remove_handle, CurlContexts::get()->scheduler, easy_context->easy_handle);
+  easy_context->error_num = error_num;
+  const int64_t resumable_id = easy_context->transfer_resumable_id;
+  easy_context->transfer_resumable_id = 0;
+  resumable_run_ready(resumable_id);
+}
+
+void run_curl_scheduler(curl_socket_t fd, int ev_bitmask) noexcept {
+  CURLM *scheduler = CurlContexts::get()->scheduler;
+  int running = 0;
+  dl::critical_section_call(curl_multi_socket_action, scheduler, fd, ev_bitmask, &running);
+
+  int msgs_in_queue = 0;
+  while (CURLMsg *msg = dl::critical_section_call(curl_multi_info_read, scheduler, &msgs_in_queue)) {
+    if (msg->msg != CURLMSG_DONE) {
+      continue;
+    }
+    void *id_as_ptr = nullptr;
+    dl::critical_section_call([&] { curl_easy_getinfo (msg->easy_handle, CURLINFO_PRIVATE, &id_as_ptr); });
+    auto *easy_context = CurlContexts::get()->easy_contexts.get_value(reinterpret_cast<int64_t>(id_as_ptr) - 1);
+    php_assert (easy_context && easy_context->transfer_resumable_id);
+    finish_curl_transfer(easy_context, msg->data.result);
+  }
+}
 
-  if (easy_context->error_num != CURLE_OK && easy_context->error_num != CURLE_PARTIAL_FILE) {
+static void process_curl_timeout(event_timer *timer) {
+  event_timer *&scheduler_timer = CurlContexts::get()->scheduler_timer;
+  php_assert (scheduler_timer == timer);
+  remove_event_timer(timer);
+  scheduler_timer = nullptr;
+  run_curl_scheduler(CURL_SOCKET_TIMEOUT, 0);
+}
+
+void process_curl_socket_event(int fd, int events) noexcept {
+  if (dl::query_num != CurlContexts::get().get_query_tag()) {
+    return;
+  }
+  auto &sockets = CurlContexts::get()->scheduler_sockets;
+  if (!sockets.has_key(fd)) {
+    // curl has stopped waiting for the socket meanwhile
+    return;
+  }
+  run_curl_scheduler(fd, events);
+  // the engine watch fires once, curl reports only the changes of what it waits for
+  if (const auto *what = sockets.find_value(fd)) {
+    curl_watch_socket(fd, static_cast<int>(*what));
+  }
+}
+
+class curl_exec_concurrently_resumable final : public Resumable {
+  using ReturnT = mixed;
+  const curl_easy easy_id;
+  const int64_t transfer_id;
+  bool ready{false};
+
+protected:
+  bool run() final {
+    RESUMABLE_BEGIN
+      ready = wait_without_result(transfer_id);
+      TRY_WAIT(curl_exec_concurrently_resumable_label_0, ready, bool);
+      php_assert (ready);
+      // the handle may be closed by curl_close() during the transfer
+      const auto *easy_context = CurlContexts::get()->get_value<EasyContext>(easy_id);
+      if (!easy_context) {
+        RETURN(false);
+      }
+      RETURN(easy_context->get_exec_result());
+    RESUMABLE_END
+  }
+
+public:
+  curl_exec_concurrently_resumable(curl_easy easy_id, int64_t transfer_id) noexcept:
+    easy_id(easy_id),
+    transfer_id(transfer_id) {
+  }
+};
+
+mixed f$curl_exec_concurrently(curl_easy easy_id) {
+  auto *easy_context = get_context<EasyContext>(easy_id);
+  if (!easy_context) {
+    return false;
+  }
+  if (easy_context->transfer_resumable_id) {
+    php_warning("Curl handle %ld is already used by curl_exec_concurrently", easy_id);
     return false;
   }
 
-  if (easy_context->return_transfer) {
-    return easy_context->result;
+  easy_context->cleanup_for_next_request();
+  CURLM *scheduler = get_curl_scheduler();
+  if (!scheduler) {
+    easy_context->error_num = CURLE_OUT_OF_MEMORY;
+    return false;
+  }
+  const CURLMcode res = dl::critical_section_call(curl_multi_add_handle, scheduler, easy_context->easy_handle);
+  if (res != CURLM_OK) {
+    php_warning("Can't start curl transfer: %s", dl::critical_section_call(curl_multi_strerror, res));
+    easy_context->error_num = CURLE_FAILED_INIT;
+    return false;
   }
 
-  return true;
+  const int64_t transfer_id = register_forked_resumable(new curl_transfer_resumable{});
+  easy_context->transfer_resumable_id = transfer_id;
+  // the connection is started right away, the transfer may even fail here
+  run_curl_scheduler(CURL_SOCKET_TIMEOUT, 0);
+  return start_resumable<mixed>(new curl_exec_concurrently_resumable(easy_id, transfer_id));
 }
 
 mixed f$curl_getinfo(curl_easy easy_id, int64_t option) noexcept {
@@ -783,6 +969,9 @@ int64_t f$curl_errno(curl_easy easy_id) noexcept {
 
 void f$curl_close(curl_easy easy_id) noexcept {
   if (auto *easy_context = get_context<EasyContext>(easy_id)) {
+    if (easy_context->transfer_resumable_id) {
+      finish_curl_transfer(easy_context, CURLE_ABORTED_BY_CALLBACK);
+    }
     CurlContexts::get()->easy_contexts.set_value(easy_id - 1, nullptr);
     easy_close(easy_context);
   }
@@ -932,6 +1121,10 @@ Optional<string> f$curl_multi_strerror(int64_t error_num) noexcept {
   return err_str ? string{err_str} : Optional<string>{};
 }
 
+void global_init_curl_lib() noexcept {
+  curl_timeout_wakeup_id = register_wakeup_callback(&process_curl_timeout);
+}
+
 void init_curl_lib() noexcept {
   if (dl::query_num != CurlContexts::get().get_query_tag()) {
     const CURLcode result = dl::critical_section_call([] {
@@ -955,6 +1148,22 @@ void init_curl_lib() noexcept {
 void free_curl_lib() noexcept {
   dl::CriticalSectionGuard critical_section;
   if (dl::query_num == CurlContexts::get().get_query_tag()) {
+    if (CURLM *scheduler = CurlContexts::get()->scheduler) {
+      for (auto it = CurlContexts::get()->easy_contexts.cbegin(); it != CurlContexts::get()->easy_contexts.cend(); ++it) {
+        auto easy_context = it.get_value();
+        if (easy_context && easy_context->transfer_resumable_id) {
+          curl_multi_remove_handle(scheduler, easy_context->easy_handle);
+        }
+      }
+      // the event timers are dropped with the script memory
+      curl_multi_setopt(scheduler, CURLMOPT_TIMERFUNCTION, nullptr);
+      curl_multi_cleanup(scheduler);
+      const auto &sockets = CurlContexts::get()->scheduler_sockets;
+      for (auto it = sockets.cbegin(); it != sockets.cend(); ++it) {
+        curl_watch_socket(static_cast<int>(it.get_int_key()), 0);
+      }
+    }
+
     for (auto it = CurlContexts::get()->easy_contexts.cbegin(); it != CurlContexts::get()->easy_contexts.cend(); ++it) {
       if (auto easy_context = it.get_value()) {
         easy_close(easy_context);
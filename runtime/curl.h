@@ -26,6 +26,9 @@ int64_t f$curl_errno(curl_easy easy_id) noexcept;
 
 void f$curl_close(curl_easy easy_id) noexcept;
 
+// runs the transfer in the engine event loop, the other forks are run meanwhile
+mixed f$curl_exec_concurrently(curl_easy easy_id);
+
 
 using curl_multi = int64_t;
 
@@ -52,6 +55,9 @@ void f$curl_multi_close(curl_multi multi_id) noexcept;
 
 Optional<string> f$curl_multi_strerror(int64_t error_num) noexcept;
 
+void process_curl_socket_event(int fd, int events) noexcept;
+
+void global_init_curl_lib() noexcept;
 void free_curl_lib() noexcept;
 
 
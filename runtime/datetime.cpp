@@ -8,6 +8,8 @@
 #include <ctime>
 #include <sys/time.h>
 
+#include "common/precise-time.h"
+
 #include "runtime/critical_section.h"
 #include "runtime/string_functions.h"
 
@@ -22,21 +24,82 @@ static const char *month_names_full[] = {"January", "February", "March", "April"
                                          "December"};
 static const int days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 
-static time_t gmmktime(struct tm *tm) {
-  char *tz = getenv("TZ");
-  setenv("TZ", "", 1);
-  tzset();
+// The default timezone is always Etc/GMT-3 without daylight saving time (see init_datetime_lib),
+// so the local time is the utc shifted by a constant. The conversions below do the calendar arithmetic
+// themselves instead of libc localtime_r()/mktime(), which take the timezone lock and check the TZ environment on every call
 
-  time_t result = mktime(tm);
+static inline int64_t floor_div(int64_t a, int64_t b) {
+  return a / b - (a % b < 0);
+}
 
-  if (tz) {
-    setenv("TZ", tz, 1);
-  } else {
-    unsetenv("TZ");
-  }
-  tzset();
+// the days from 1970-01-01 to the given date of the proleptic Gregorian calendar, month is 1..12
+static int64_t days_from_civil(int64_t year, int64_t month, int64_t day) {
+  year -= month <= 2;
+  const int64_t era = floor_div(year, 400);
+  const int64_t year_of_era = year - era * 400;
+  const int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
 
-  return result;
+// normalizes the out of range fields in the same way as mktime() does
+static int64_t tm_to_seconds(const tm &t) {
+  const int64_t month = t.tm_mon;
+  const int64_t year = t.tm_year + 1900LL + floor_div(month, 12);
+  const int64_t days = days_from_civil(year, month - floor_div(month, 12) * 12 + 1, 1) + t.tm_mday - 1;
+  return days * 86400 + t.tm_hour * 3600LL + t.tm_min * 60LL + t.tm_sec;
+}
+
+static void seconds_to_tm(int64_t seconds, tm &t) {
+  const int64_t days = floor_div(seconds, 86400);
+  const int64_t day_seconds = seconds - days * 86400;
+  t.tm_hour = static_cast<int>(day_seconds / 3600);
+  t.tm_min = static_cast<int>(day_seconds / 60 % 60);
+  t.tm_sec = static_cast<int>(day_seconds % 60);
+  // 1970-01-01 is Thursday
+  t.tm_wday = static_cast<int>(days + 4 - floor_div(days + 4, 7) * 7);
+
+  const int64_t shifted_days = days + 719468;
+  const int64_t era = floor_div(shifted_days, 146097);
+  const int64_t day_of_era = shifted_days - era * 146097;
+  const int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+  const int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  const int64_t month_from_march = (5 * day_of_year + 2) / 153;
+  const int64_t month = month_from_march < 10 ? month_from_march + 3 : month_from_march - 9;
+  const int64_t year = year_of_era + era * 400 + (month <= 2);
+
+  t.tm_year = static_cast<int>(year - 1900);
+  t.tm_mon = static_cast<int>(month - 1);
+  t.tm_mday = static_cast<int>(day_of_year - (153 * month_from_march + 2) / 5 + 1);
+  t.tm_yday = static_cast<int>(days - days_from_civil(year, 1, 1));
+  t.tm_isdst = 0;
+}
+
+// the same timestamp is usually converted many times in a row, e.g. by date() calls without a timestamp
+static void local_time(int64_t timestamp, tm &t) {
+  static int64_t cached_timestamp = std::numeric_limits<int64_t>::min();
+  static tm cached_tm;
+  if (timestamp != cached_timestamp) {
+    seconds_to_tm(timestamp - timezone, cached_tm);
+    cached_tm.tm_gmtoff = -timezone;
+    cached_tm.tm_zone = tzname[0];
+    cached_timestamp = timestamp;
+  }
+  t = cached_tm;
+}
+
+static void gm_time(int64_t timestamp, tm &t) {
+  seconds_to_tm(timestamp, t);
+  t.tm_gmtoff = 0;
+  t.tm_zone = "GMT";
+}
+
+static time_t local_mktime(const tm &t) {
+  return tm_to_seconds(t) + timezone;
+}
+
+static time_t gmmktime(const tm &t) {
+  return tm_to_seconds(t);
 }
 
 static inline int32_t is_leap(int32_t year) {
@@ -364,8 +427,7 @@ string f$date(const string &format, int64_t timestamp) {
     timestamp = time(nullptr);
   }
   tm t;
-  time_t timestamp_t = timestamp;
-  localtime_r(&timestamp_t, &t);
+  local_time(timestamp, t);
 
   return date(format, t, timestamp, true);
 }
@@ -390,8 +452,7 @@ array<mixed> f$getdate(int64_t timestamp) {
     timestamp = time(nullptr);
   }
   tm t;
-  time_t timestamp_t = timestamp;
-  localtime_r(&timestamp_t, &t);
+  local_time(timestamp, t);
 
   array<mixed> result(array_size(1, 10, false));
 
@@ -415,16 +476,14 @@ string f$gmdate(const string &format, int64_t timestamp) {
     timestamp = time(nullptr);
   }
   tm t;
-  time_t timestamp_t = timestamp;
-  gmtime_r(&timestamp_t, &t);
+  gm_time(timestamp, t);
 
   return date(format, t, timestamp, false);
 }
 
 int64_t f$gmmktime(int64_t h, int64_t m, int64_t s, int64_t month, int64_t day, int64_t year) {
   tm t;
-  time_t timestamp_t = time(nullptr);
-  gmtime_r(&timestamp_t, &t);
+  gm_time(time(nullptr), t);
 
   if (h != std::numeric_limits<int64_t>::min()) {
     t.tm_hour = static_cast<int32_t>(h);
@@ -451,7 +510,7 @@ int64_t f$gmmktime(int64_t h, int64_t m, int64_t s, int64_t month, int64_t day,
   }
 
   t.tm_isdst = -1;
-  return gmmktime(&t) - 3 * 3600;
+  return gmmktime(t) - 3 * 3600;
 }
 
 array<mixed> f$localtime(int64_t timestamp, bool is_associative) {
@@ -459,8 +518,7 @@ array<mixed> f$localtime(int64_t timestamp, bool is_associative) {
     timestamp = time(nullptr);
   }
   tm t;
-  time_t timestamp_t = timestamp;
-  localtime_r(&timestamp_t, &t);
+  local_time(timestamp, t);
 
   if (!is_associative) {
     return array<mixed>::create(t.tm_sec, t.tm_min, t.tm_hour, t.tm_mday, t.tm_mon, t.tm_year, t.tm_wday, t.tm_yday, t.tm_isdst);
@@ -483,23 +541,18 @@ array<mixed> f$localtime(int64_t timestamp, bool is_associative) {
 
 
 double microtime_monotonic() {
-  struct timespec T;
-  php_assert (clock_gettime(CLOCK_MONOTONIC, &T) >= 0);
-  return static_cast<double>(T.tv_sec) + static_cast<double>(T.tv_nsec) * 1e-9;
+  return static_cast<double>(get_ntime_mono_fast()) * 1e-9;
 }
 
 static string microtime_string() {
-  struct timespec T;
-  php_assert (clock_gettime(CLOCK_REALTIME, &T) >= 0);
+  const uint64_t real_ns = get_ntime_real_fast();
   char buf[45];
-  int len = sprintf(buf, "0.%09d %d", (int)T.tv_nsec, (int)T.tv_sec);
+  int len = sprintf(buf, "0.%09d %d", static_cast<int>(real_ns % 1000000000), static_cast<int>(real_ns / 1000000000));
   return string(buf, len);
 }
 
 double microtime() {
-  struct timespec T;
-  php_assert (clock_gettime(CLOCK_REALTIME, &T) >= 0);
-  return static_cast<double>(T.tv_sec) + static_cast<double>(T.tv_nsec) * 1e-9;
+  return static_cast<double>(get_ntime_real_fast()) * 1e-9;
 }
 
 mixed f$microtime(bool get_as_float) {
@@ -512,8 +565,7 @@ mixed f$microtime(bool get_as_float) {
 
 int64_t f$mktime(int64_t h, int64_t m, int64_t s, int64_t month, int64_t day, int64_t year) {
   tm t;
-  time_t timestamp_t = time(nullptr);
-  localtime_r(&timestamp_t, &t);
+  local_time(time(nullptr), t);
 
   if (h != std::numeric_limits<int64_t>::min()) {
     t.tm_hour = static_cast<int32_t>(h);
@@ -541,7 +593,7 @@ int64_t f$mktime(int64_t h, int64_t m, int64_t s, int64_t month, int64_t day, in
 
   t.tm_isdst = -1;
 
-  return mktime(&t);
+  return local_mktime(t);
 }
 
 string f$strftime(const string &format, int64_t timestamp) {
@@ -549,8 +601,7 @@ string f$strftime(const string &format, int64_t timestamp) {
     timestamp = time(nullptr);
   }
   tm t;
-  time_t timestamp_t = timestamp;
-  localtime_r(&timestamp_t, &t);
+  local_time(timestamp, t);
 
   if (!strftime(php_buf, PHP_BUF_LEN, format.c_str(), &t)) {
     return string();
@@ -564,8 +615,7 @@ Optional<int64_t> f$strtotime(const string &time_str, int64_t timestamp) {
     timestamp = time(nullptr);
   }
   tm t;
-  time_t timestamp_t = timestamp;
-  localtime_r(&timestamp_t, &t);
+  local_time(timestamp, t);
 
   string s = f$trim(time_str);
 
@@ -806,7 +856,7 @@ Optional<int64_t> f$strtotime(const string &time_str, int64_t timestamp) {
 
   if ((int)s.size() == 0) {
     t.tm_isdst = -1;
-    return need_gmt ? gmmktime(&t) : mktime(&t);
+    return need_gmt ? gmmktime(t) : local_mktime(t);
   }
 
   php_critical_error ("strtotime can't parse string \"%s\", unparsed part: \"%s\"", time_str.c_str(), s.c_str());
@@ -819,6 +869,13 @@ int64_t f$time() {
 
 
 void init_datetime_lib() {
+  // the timezone can't be changed by the script, so it's set once per process
+  static bool timezone_is_set = false;
+  if (likely(timezone_is_set)) {
+    return;
+  }
+  timezone_is_set = true;
+
   dl::enter_critical_section();//OK
 
   setenv("TZ", "Etc/GMT-3", 1);
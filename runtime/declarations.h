@@ -25,6 +25,7 @@ template<typename T>
 class Optional;
 
 struct C$RpcConnection;
+struct C$RpcConnectionPool;
 
 template<class LongT>
 class LongNumber;
@@ -9,20 +9,15 @@
 #include "runtime/critical_section.h"
 #include "runtime/string_functions.h"
 
-array<array<string>> f$debug_backtrace() {
-  dl::enter_critical_section();//OK
-  void *buffer[64];
-  int nptrs = fast_backtrace(buffer, 64);
-  dl::leave_critical_section();
-
+static array<array<string>> make_backtrace_array(void *const *addresses, int count) {
   const string function_key("function", 8);
 
-  array<array<string>> res(array_size(nptrs - 4, 0, true));
+  array<array<string>> res(array_size(count, 0, true));
   char buf[20];
-  for (int i = 1; i < nptrs; i++) {
+  for (int i = 0; i < count; i++) {
     array<string> current(array_size(0, 1, false));
     dl::enter_critical_section();//OK
-    snprintf(buf, 19, "%p", buffer[i]);
+    snprintf(buf, 19, "%p", addresses[i]);
     dl::leave_critical_section();
     current.set_value(function_key, string(buf));
     res.push_back(current);
@@ -31,6 +26,23 @@ array<array<string>> f$debug_backtrace() {
   return res;
 }
 
+array<array<string>> f$debug_backtrace() {
+  dl::enter_critical_section();//OK
+  void *buffer[64];
+  int nptrs = fast_backtrace(buffer, 64);
+  dl::leave_critical_section();
+
+  return nptrs > 1 ? make_backtrace_array(buffer + 1, nptrs - 1) : array<array<string>>();
+}
+
+static const array<array<string>> &get_exception_trace(const Exception &e) {
+  if (!e->is_trace_formatted) {
+    e->trace = make_backtrace_array(e->raw_trace, e->raw_trace_size);
+    e->is_trace_formatted = true;
+  }
+  return e->trace;
+}
+
 Exception CurException;
 
 string f$Exception$$getMessage(const Exception &e) {
@@ -50,7 +62,7 @@ int64_t f$Exception$$getLine(const Exception &e) {
 }
 
 array<array<string>> f$Exception$$getTrace(const Exception &e) {
-  return e->trace;
+  return get_exception_trace(e);
 }
 
 Exception f$Exception$$__construct(const Exception &v$this, const string &file, int64_t line, const string &message, int64_t code) {
@@ -58,7 +70,11 @@ Exception f$Exception$$__construct(const Exception &v$this, const string &file,
   v$this->line = line;
   v$this->message = message;
   v$this->code = code;
-  v$this->trace = f$debug_backtrace();
+  dl::enter_critical_section();//OK
+  v$this->raw_trace_size = fast_backtrace(v$this->raw_trace, sizeof(v$this->raw_trace) / sizeof(v$this->raw_trace[0]));
+  dl::leave_critical_section();
+  v$this->is_trace_formatted = false;
+  v$this->trace = array<array<string>>();
   return v$this;
 }
 
@@ -73,9 +89,10 @@ Exception f$err(const string &file, int64_t line, const string &code, const stri
 
 
 string f$Exception$$getTraceAsString(const Exception &e) {
+  const array<array<string>> &trace = get_exception_trace(e);
   static_SB.clean();
-  for (int64_t i = 0; i < e->trace.count(); i++) {
-    array<string> current = e->trace.get_value(i);
+  for (int64_t i = 0; i < trace.count(); i++) {
+    array<string> current = trace.get_value(i);
     static_SB << '#' << i << ' ' << current.get_value(string("file", 4)) << ": " << current.get_value(string("function", 8)) << "\n";
   }
   return static_SB.str();
@@ -16,6 +16,11 @@ struct C$Exception : refcountable_php_classes<C$Exception> {
   int64_t code = 0;
   string file;
   int64_t line = 0;
+  // the return addresses are captured by the constructor, they are formatted on the first getTrace() call,
+  // since the most of exceptions are caught without looking at the trace
+  void *raw_trace[64];
+  int raw_trace_size = 0;
+  bool is_trace_formatted = false;
   array<array<string>> trace;
 
   void accept(InstanceMemoryEstimateVisitor &visitor) {
@@ -31,7 +36,7 @@ extern Exception CurException;
 
 #define THROW_EXCEPTION(e) {Exception x_tmp___ = e; php_assert(CurException.is_null()); CurException = std::move(x_tmp___);}
 
-#define CHECK_EXCEPTION(action) if (!CurException.is_null()) {action;}
+#define CHECK_EXCEPTION(action) if (unlikely(!CurException.is_null())) {action;}
 
 #ifdef __clang__
   #define TRY_CALL_RET_(x) x
@@ -7,13 +7,18 @@
 #include <dirent.h>
 #include <errno.h>
 #include <libgen.h>
+#include <string>
 #include <sys/utsname.h>
 #include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
 #undef basename
 
+#include "common/mixin/not_copyable.h"
 #include "common/wrappers/mkdir_recursive.h"
 
+#include "runtime/allocator.h"
 #include "runtime/critical_section.h"
 #include "runtime/interface.h"
 #include "runtime/streams.h"
@@ -96,6 +101,121 @@ ssize_t write_safe(int32_t fd, const void *buf, size_t len) {
 }
 
 
+namespace {
+
+// The big files read on every request, like templates or models, are kept in the worker heap between the requests:
+// while the file isn't changed, its content is returned as a shared read-only string without reading it again.
+// The content of a changed file is freed after the request, since the script may still use it
+class PersistentFileContentsCache : vk::not_copyable {
+public:
+  static constexpr size_t MIN_FILE_SIZE = 64 * 1024;
+  static constexpr size_t MAX_TOTAL_SIZE = 64 * 1024 * 1024;
+
+  static PersistentFileContentsCache &get() noexcept {
+    static PersistentFileContentsCache cache;
+    return cache;
+  }
+
+  const string *find(const char *path, const struct stat &stat_buf) noexcept {
+    php_assert(!dl::is_malloc_replaced());
+    auto it = files_.find(path);
+    if (it == files_.end()) {
+      return nullptr;
+    }
+    if (is_same_file(it->second, stat_buf)) {
+      return &it->second.contents;
+    }
+    total_size_ -= it->second.contents.size();
+    retired_.emplace_back(std::move(it->second.contents));
+    files_.erase(it);
+    return nullptr;
+  }
+
+  bool can_store(size_t size) const noexcept {
+    return size >= MIN_FILE_SIZE && total_size_ + size <= MAX_TOTAL_SIZE;
+  }
+
+  // the contents must be allocated in the heap
+  void store(const char *path, const struct stat &stat_buf, string &contents) noexcept {
+    php_assert(!dl::is_malloc_replaced());
+    contents.set_reference_counter_to(ExtraRefCnt::for_instance_cache);
+    total_size_ += contents.size();
+    files_[path] = CachedFile{stat_buf.st_dev, stat_buf.st_ino, stat_buf.st_size, stat_buf.st_mtim, contents};
+  }
+
+  void free_retired() noexcept {
+    if (retired_.empty()) {
+      return;
+    }
+    auto heap_replacement_guard = make_script_allocator_replacement_with_heap();
+    for (string &contents : retired_) {
+      contents.force_destroy(ExtraRefCnt::for_instance_cache);
+    }
+    retired_.clear();
+  }
+
+private:
+  struct CachedFile {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    timespec mtime;
+    string contents;
+  };
+
+  PersistentFileContentsCache() = default;
+
+  static bool is_same_file(const CachedFile &file, const struct stat &stat_buf) noexcept {
+    return file.dev == stat_buf.st_dev && file.ino == stat_buf.st_ino && file.size == stat_buf.st_size &&
+           file.mtime.tv_sec == stat_buf.st_mtim.tv_sec && file.mtime.tv_nsec == stat_buf.st_mtim.tv_nsec;
+  }
+
+  std::unordered_map<std::string, CachedFile> files_;
+  std::vector<string> retired_;
+  size_t total_size_{0};
+};
+
+// reads the whole regular file, the descriptor is closed by the caller
+Optional<string> read_regular_file(int32_t file_fd, const char *path, const struct stat &stat_buf) {
+  const auto size = static_cast<string::size_type>(stat_buf.st_size);
+  auto &cache = PersistentFileContentsCache::get();
+
+  dl::enter_critical_section();//OK
+  if (size >= PersistentFileContentsCache::MIN_FILE_SIZE) {
+    if (const string *cached = cache.find(path, stat_buf)) {
+      string res = *cached;
+      dl::leave_critical_section();
+      return res;
+    }
+  }
+  const bool use_heap_memory = cache.can_store(size) && !dl::is_script_allocator_replaced_with_heap();
+  dl::leave_critical_section();
+
+  string res;
+  {
+    auto heap_replacement_guard = make_script_allocator_replacement_with_heap(use_heap_memory);
+    res = string(size, false);
+  }
+
+  dl::enter_critical_section();//OK
+  if (read_safe(file_fd, res.buffer(), size) < static_cast<ssize_t>(size)) {
+    if (use_heap_memory) {
+      auto heap_replacement_guard = make_script_allocator_replacement_with_heap();
+      res = string();
+    }
+    dl::leave_critical_section();
+    return false;
+  }
+  if (use_heap_memory) {
+    cache.store(path, stat_buf, res);
+  }
+  dl::leave_critical_section();
+  return res;
+}
+
+} // namespace
+
+
 #define read read_disabled
 #define write write_disabled
 
@@ -207,19 +327,16 @@ Optional<array<string>> f$file(const string &name) {
   }
   dl::leave_critical_section();
 
-  string res(static_cast<string::size_type>(size), false);
+  Optional<string> contents = read_regular_file(file_fd, name.c_str(), stat_buf);
 
   dl::enter_critical_section();//OK
-  char *s = &res[0];
-  if (read_safe(file_fd, s, size) < (ssize_t)size) {
-    close_safe(file_fd);
-    dl::leave_critical_section();
-    return false;
-  }
-
   close_safe(file_fd);
   dl::leave_critical_section();
+  if (!contents.has_value()) {
+    return false;
+  }
 
+  const char *s = contents.val().c_str();
   array<string> result;
   int prev = -1;
   for (int i = 0; i < (int)size; i++) {
@@ -841,15 +958,9 @@ Optional<string> file_file_get_contents(const string &name) {
   }
   dl::leave_critical_section();
 
-  string res(static_cast<string::size_type>(size), false);
+  Optional<string> res = read_regular_file(file_fd, name.c_str() + offset, stat_buf);
 
   dl::enter_critical_section();//OK
-  if (read_safe(file_fd, &res[0], size) < (ssize_t)size) {
-    close_safe(file_fd);
-    dl::leave_critical_section();
-    return false;
-  }
-
   close_safe(file_fd);
   dl::leave_critical_section();
   return res;
@@ -924,6 +1035,7 @@ void free_files_lib() {
     close_safe(opened_fd);
   }
   opened_fd = -1;
+  PersistentFileContentsCache::get().free_retired();
   dl::leave_critical_section();
 }
 
@@ -0,0 +1,141 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "runtime/allocator.h"
+#include "runtime/kphp_core.h"
+
+// The global constants which can be placed into the read-only segment (see memory_resource::global_const_memory):
+// all the strings and arrays reachable from them are marked with ExtraRefCnt::for_global_const,
+// so nothing writes to their reference counters
+template<class T>
+struct is_global_const_markable : std::is_arithmetic<T> {};
+
+template<>
+struct is_global_const_markable<Unknown> : std::true_type {};
+
+template<>
+struct is_global_const_markable<string> : std::true_type {};
+
+template<>
+struct is_global_const_markable<mixed> : std::true_type {};
+
+template<class T>
+struct is_global_const_markable<array<T>> : is_global_const_markable<T> {};
+
+template<class T>
+struct is_global_const_markable<Optional<T>> : is_global_const_markable<T> {};
+
+template<class ...Args>
+constexpr bool are_global_const_markable() noexcept {
+  const bool markable[] = {true, is_global_const_markable<Args>::value...};
+  for (bool value : markable) {
+    if (!value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template<class ...Args>
+struct is_global_const_markable<std::tuple<Args...>> : std::integral_constant<bool, are_global_const_markable<Args...>()> {};
+
+template<class T>
+void mark_as_global_const(T &) noexcept {
+  static_assert(is_global_const_markable<T>::value, "unexpected type of global const");
+}
+
+inline void mark_as_global_const(string &str) noexcept {
+  str.set_reference_counter_to(ExtraRefCnt::for_global_const);
+}
+
+template<class T>
+void mark_as_global_const(array<T> &arr) noexcept;
+
+inline void mark_as_global_const(mixed &value) noexcept;
+
+template<class T>
+void mark_as_global_const(Optional<T> &value) noexcept {
+  mark_as_global_const(value.val());
+}
+
+template<class ...Args, size_t ...Indexes>
+void mark_tuple_as_global_const(std::tuple<Args...> &value, std::index_sequence<Indexes...>) noexcept {
+  const int unused[] = {0, (mark_as_global_const(std::get<Indexes>(value)), 0)...};
+  (void)unused;
+}
+
+template<class ...Args>
+void mark_as_global_const(std::tuple<Args...> &value) noexcept {
+  mark_tuple_as_global_const(value, std::index_sequence_for<Args...>{});
+}
+
+template<class T>
+void mark_as_global_const(array<T> &arr) noexcept {
+  // the raw arrays and the already marked ones are marked deeply
+  if (arr.is_reference_counter(ExtraRefCnt::for_global_const)) {
+    return;
+  }
+  arr.set_reference_counter_to(ExtraRefCnt::for_global_const);
+  const auto last = arr.end_no_mutate();
+  for (auto it = arr.begin_no_mutate(); it != last; ++it) {
+    if (it.is_string_key()) {
+      mark_as_global_const(it.get_string_key());
+    }
+    mark_as_global_const(it.get_value());
+  }
+}
+
+inline void mark_as_global_const(mixed &value) noexcept {
+  if (value.is_string()) {
+    mark_as_global_const(value.as_string());
+  } else if (value.is_array()) {
+    mark_as_global_const(value.as_array());
+  }
+}
+
+// the init of a global const var: the markable ones are allocated in the read-only segment,
+// the rest (e.g. regexps with their mutable state) stay in the heap
+template<class T>
+void begin_global_const_init(const T &) noexcept {
+  if (is_global_const_markable<T>::value) {
+    dl::enter_global_const_memory();
+  }
+}
+
+template<class T>
+void end_global_const_init(T &var, std::true_type) noexcept {
+  mark_as_global_const(var);
+  dl::leave_global_const_memory();
+}
+
+// only the top level of the rest is marked
+template<class T>
+void mark_as_global_const_shallow(T &) noexcept {
+}
+
+template<class T>
+void mark_as_global_const_shallow(array<T> &arr) noexcept {
+  arr.set_reference_counter_to(ExtraRefCnt::for_global_const);
+}
+
+template<class T>
+void mark_as_global_const_shallow(Optional<T> &value) noexcept {
+  mark_as_global_const_shallow(value.val());
+}
+
+template<class T>
+void end_global_const_init(T &var, std::false_type) noexcept {
+  mark_as_global_const_shallow(var);
+}
+
+template<class T>
+void end_global_const_init(T &var) noexcept {
+  end_global_const_init(var, is_global_const_markable<T>{});
+}
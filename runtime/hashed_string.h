@@ -0,0 +1,46 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "runtime/kphp_core.h"
+
+// A string with its hash computed once.
+// The ordering compares the hashes first: an ordered container keyed by hashed_string
+// compares the string contents only in the nodes with the same hash and doesn't touch them on the way there.
+// The order is not lexicographic, so it doesn't suit the prefix lookups.
+class hashed_string {
+public:
+  hashed_string() = default;
+
+  explicit hashed_string(const string &str) noexcept:
+    hash_(str.hash()),
+    str_(str) {
+  }
+
+  int64_t hash() const noexcept {
+    return hash_;
+  }
+
+  const string &str() const noexcept {
+    return str_;
+  }
+
+  // the contents must not be changed, but the string may be moved into another memory
+  string &str() noexcept {
+    return str_;
+  }
+
+  friend bool operator<(const hashed_string &lhs, const hashed_string &rhs) noexcept {
+    return lhs.hash_ != rhs.hash_ ? lhs.hash_ < rhs.hash_ : lhs.str_.compare(rhs.str_) < 0;
+  }
+
+  friend bool operator==(const hashed_string &lhs, const hashed_string &rhs) noexcept {
+    return lhs.hash_ == rhs.hash_ && lhs.str_ == rhs.str_;
+  }
+
+private:
+  int64_t hash_{0};
+  string str_;
+};
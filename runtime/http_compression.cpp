@@ -0,0 +1,158 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/http_compression.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <zlib.h>
+#include <zstd.h>
+
+#include "runtime/critical_section.h"
+#include "runtime/zlib.h"
+
+namespace {
+
+enum class http_encoding {
+  gzip,
+  zstd,
+};
+
+constexpr int32_t OUTPUT_CHUNK_SIZE = 64 * 1024;
+
+std::array<http_encoding, 2> preferred_encodings;
+size_t preferred_encodings_count = 0;
+int compression_level = -1;
+int64_t compression_min_size = 1024;
+
+// the compressor states live through the whole worker life and are reset before each response
+z_stream *get_gzip_stream() noexcept {
+  static z_stream strm;
+  static bool is_inited = false;
+  if (!is_inited) {
+    memset(&strm, 0, sizeof(strm));
+    // the zlib levels are 1-9, the bigger ones are meant for zstd
+    const int level = compression_level == -1 ? 6 : std::min(compression_level, 9);
+    if (deflateInit2(&strm, level, Z_DEFLATED, ZLIB_ENCODE, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      return nullptr;
+    }
+    is_inited = true;
+  } else if (deflateReset(&strm) != Z_OK) {
+    return nullptr;
+  }
+  return &strm;
+}
+
+ZSTD_CCtx *get_zstd_context() noexcept {
+  static ZSTD_CCtx *ctx = nullptr;
+  if (ctx == nullptr) {
+    ctx = ZSTD_createCCtx();
+    if (ctx == nullptr) {
+      return nullptr;
+    }
+    const int level = compression_level == -1 ? ZSTD_CLEVEL_DEFAULT : compression_level;
+    ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level);
+  } else {
+    ZSTD_CCtx_reset(ctx, ZSTD_reset_session_only);
+  }
+  return ctx;
+}
+
+// the output is produced by chunks, so the memory isn't reserved for the worst case
+bool gzip_compress(const char *body, int32_t body_len) noexcept {
+  z_stream *strm = get_gzip_stream();
+  if (strm == nullptr) {
+    return false;
+  }
+  strm->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(body));
+  strm->avail_in = static_cast<uInt>(body_len);
+  int ret = Z_OK;
+  while (ret == Z_OK) {
+    static_SB.reserve(OUTPUT_CHUNK_SIZE);
+    strm->next_out = reinterpret_cast<Bytef *>(static_SB.buffer() + static_SB.size());
+    strm->avail_out = OUTPUT_CHUNK_SIZE;
+    ret = deflate(strm, Z_FINISH);
+    static_SB.set_pos(static_SB.size() + OUTPUT_CHUNK_SIZE - strm->avail_out);
+  }
+  return ret == Z_STREAM_END;
+}
+
+bool zstd_compress(const char *body, int32_t body_len) noexcept {
+  ZSTD_CCtx *ctx = get_zstd_context();
+  if (ctx == nullptr) {
+    return false;
+  }
+  ZSTD_inBuffer input{body, static_cast<size_t>(body_len), 0};
+  size_t remaining = 1;
+  while (remaining != 0) {
+    static_SB.reserve(OUTPUT_CHUNK_SIZE);
+    ZSTD_outBuffer output{static_SB.buffer() + static_SB.size(), OUTPUT_CHUNK_SIZE, 0};
+    remaining = ZSTD_compressStream2(ctx, &output, &input, ZSTD_e_end);
+    if (ZSTD_isError(remaining)) {
+      return false;
+    }
+    static_SB.set_pos(static_SB.size() + output.pos);
+  }
+  return true;
+}
+
+} // namespace
+
+bool set_http_compression_encodings(const char *encodings) noexcept {
+  preferred_encodings_count = 0;
+  const char *p = encodings;
+  while (*p) {
+    const char *end = strchrnul(p, ',');
+    const size_t len = end - p;
+    http_encoding encoding;
+    if (len == 4 && !strncmp(p, "gzip", 4)) {
+      encoding = http_encoding::gzip;
+    } else if (len == 4 && !strncmp(p, "zstd", 4)) {
+      encoding = http_encoding::zstd;
+    } else {
+      return false;
+    }
+    if (preferred_encodings_count == preferred_encodings.size()) {
+      return false;
+    }
+    preferred_encodings[preferred_encodings_count++] = encoding;
+    p = *end ? end + 1 : end;
+  }
+  return true;
+}
+
+bool set_http_compression_level(int level) noexcept {
+  if (level != -1 && (level < 1 || level > ZSTD_maxCLevel())) {
+    return false;
+  }
+  compression_level = level;
+  return true;
+}
+
+void set_http_compression_min_size(int64_t min_size) noexcept {
+  compression_min_size = min_size;
+}
+
+const string_buffer *http_compress_response(const char *body, int32_t body_len, int accepted_encodings, const char **content_encoding) noexcept {
+  if (body_len < compression_min_size) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < preferred_encodings_count; i++) {
+    const http_encoding encoding = preferred_encodings[i];
+    if (encoding == http_encoding::gzip && (accepted_encodings & HTTP_ACCEPT_ENCODING_GZIP)) {
+      static_SB.clean();
+      dl::CriticalSectionGuard critical_section;
+      *content_encoding = "gzip";
+      return gzip_compress(body, body_len) ? &static_SB : nullptr;
+    }
+    if (encoding == http_encoding::zstd && (accepted_encodings & HTTP_ACCEPT_ENCODING_ZSTD)) {
+      static_SB.clean();
+      dl::CriticalSectionGuard critical_section;
+      *content_encoding = "zstd";
+      return zstd_compress(body, body_len) ? &static_SB : nullptr;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,22 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "runtime/kphp_core.h"
+
+// the bits of the encodings from the Accept-Encoding request header
+constexpr int HTTP_ACCEPT_ENCODING_GZIP = 1;
+constexpr int HTTP_ACCEPT_ENCODING_DEFLATE = 2;
+constexpr int HTTP_ACCEPT_ENCODING_ZSTD = 8;
+
+// a comma separated list of gzip and zstd in the order of preference, an empty list turns the compression off
+bool set_http_compression_encodings(const char *encodings) noexcept;
+// -1 is the default level of each encoding
+bool set_http_compression_level(int level) noexcept;
+void set_http_compression_min_size(int64_t min_size) noexcept;
+
+// compresses the response body with the most preferable encoding accepted by the client,
+// returns nullptr if the body must be sent as is; returns pointer to static_SB
+const string_buffer *http_compress_response(const char *body, int32_t body_len, int accepted_encodings, const char **content_encoding) noexcept;
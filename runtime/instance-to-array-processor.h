@@ -56,7 +56,7 @@ private:
     InstanceToArrayVisitor tuple_processor;
     tuple_processor.result_.reserve(sizeof...(Args), 0, true);
 
-    process_tuple(value, tuple_processor);
+    process_tuple(value, tuple_processor, std::index_sequence_for<Args...>{});
     add_value(field_name, tuple_processor.flush_result());
   }
 
@@ -69,14 +69,9 @@ private:
     add_value(field_name, shape_processor.flush_result());
   }
 
-  template<size_t Index = 0, class ...Args>
-  std::enable_if_t<Index != sizeof...(Args)> process_tuple(const std::tuple<Args...> &value, InstanceToArrayVisitor &tuple_visitor) {
-    tuple_visitor.process_impl("", std::get<Index>(value));
-    process_tuple<Index + 1>(value, tuple_visitor);
-  }
-
-  template<size_t Index = 0, class ...Args>
-  std::enable_if_t<Index == sizeof...(Args)> process_tuple(const std::tuple<Args...> &, InstanceToArrayVisitor &/*tuple_processor*/) {
+  template<class ...Args, size_t ...Is>
+  void process_tuple(const std::tuple<Args...> &value, InstanceToArrayVisitor &tuple_visitor, std::index_sequence<Is...>) {
+    std::initializer_list<int32_t>{((void)tuple_visitor.process_impl("", std::get<Is>(value)), 0)...};
   }
 
   template<size_t ...Is, typename ...T>
@@ -5,15 +5,23 @@
 #include "runtime/instance_cache.h"
 
 #include <chrono>
+#include <cinttypes>
+#include <cstring>
+#include <fcntl.h>
 #include <forward_list>
 #include <map>
 #include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <unordered_set>
 
+#include "common/huge-pages.h"
 #include "common/kprintf.h"
 
 #include "runtime/allocator.h"
 #include "runtime/critical_section.h"
+#include "runtime/hashed_string.h"
 #include "runtime/inter-process-mutex.h"
 #include "runtime/inter-process-resource.h"
 #include "runtime/memory_resource/resource_allocator.h"
@@ -34,6 +42,8 @@ inline void ic_debug(const char *, ...) {}
 static constexpr size_t DEFAULT_MEMORY_LIMIT{256u * 1024u * 1024u};
 // Buffer memory consumption threshold that states at which point we'll swap it
 static constexpr double REAL_MEMORY_USED_THRESHOLD{0.9};
+// Buffer memory consumption threshold that states at which point we'll start evicting the least recently used elements
+static constexpr double EVICTION_MEMORY_USED_THRESHOLD{0.8};
 // Elements that lived less than this ratio to the expected lifetime will not be overwritten
 static constexpr double FRESHNESS_ELEMENT_RATIO{0.2};
 // For the element that lived more than this ratio to the expected lifetime,
@@ -118,12 +128,15 @@ public:
 
   void update_time_points(std::chrono::nanoseconds now, int64_t ttl) noexcept {
     stored_at = std::max(now, stored_at);
+    last_fetched_at = std::max(stored_at, last_fetched_at);
     expiring_at = ttl > 0 ? stored_at + std::chrono::seconds{ttl} : std::chrono::nanoseconds::max();
     early_fetch_performed = false;
   }
 
   std::chrono::nanoseconds stored_at{std::chrono::nanoseconds::min()};
   std::chrono::nanoseconds expiring_at{std::chrono::nanoseconds::max()};
+  // is used for the eviction under the memory pressure, updated under the storage_mutex
+  std::chrono::nanoseconds last_fetched_at{std::chrono::nanoseconds::min()};
   bool early_fetch_performed{false};
   const pid_t inserted_by_process{0};
 
@@ -134,13 +147,18 @@ public:
   std::atomic<ElementHolder *> next_in_garbage_list{nullptr};
 };
 
-using ElementStorage_ = memory_resource::stl::map<string, vk::intrusive_ptr<ElementHolder>, memory_resource::unsynchronized_pool_resource, stl_string_less>;
+// the keys are hashed once per operation; the same hash chooses the shard and orders the keys inside it
+using ElementStorage_ = memory_resource::stl::map<hashed_string, vk::intrusive_ptr<ElementHolder>, memory_resource::unsynchronized_pool_resource>;
 
 struct SharedDataStorages : private vk::not_copyable {
   explicit SharedDataStorages(memory_resource::unsynchronized_pool_resource &resource) :
     storage(ElementStorage_::allocator_type{resource}) {
   }
 
+  std::unique_lock<inter_process_mutex> lock_storage() noexcept {
+    return std::unique_lock<inter_process_mutex>{storage_mutex};
+  }
+
   inter_process_mutex storage_mutex;
   ElementStorage_ storage;
   std::atomic<bool> is_storage_empty{true};
@@ -171,13 +189,30 @@ public:
     php_assert(!data_shards_);
     php_assert(!cache_context_);
     php_assert(!shared_memory_);
-    shared_memory_pool_size_ = pool_size;
-    share_memory_full_size_ = get_context_size() + get_data_size() + shared_memory_pool_size_;
-    shared_memory_ = mmap(nullptr, share_memory_full_size_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, -1, 0);
-    php_assert(shared_memory_);
+    void *memory = mmap_shared_memory(get_full_size(pool_size));
+    php_assert(memory);
+    init_in(memory, pool_size);
+  }
+
+  // the memory is placed by the caller, e.g. to hand it over to the next master
+  void init_in(void *memory, size_t pool_size) noexcept {
+    attach(memory, pool_size);
     construct_data_inplace();
   }
 
+  // the data has been already constructed in the memory by the previous master
+  void attach(void *memory, size_t pool_size) noexcept {
+    shared_memory_pool_size_ = pool_size;
+    share_memory_full_size_ = get_full_size(pool_size);
+    shared_memory_ = memory;
+    cache_context_ = static_cast<CacheContext *>(shared_memory_);
+    data_shards_ = reinterpret_cast<SharedDataStorages *>(static_cast<uint8_t *>(shared_memory_) + get_context_size());
+  }
+
+  static constexpr size_t get_full_size(size_t pool_size) noexcept {
+    return get_context_size() + get_data_size() + pool_size;
+  }
+
   void reset() noexcept {
     destroy_data();
     construct_data_inplace();
@@ -189,7 +224,7 @@ public:
     cache_context_ = nullptr;
   }
 
-  SharedDataStorages &get_data(const string &key) noexcept {
+  SharedDataStorages &get_data(const hashed_string &key) noexcept {
     php_assert(data_shards_);
     return data_shards_[static_cast<uint32_t>(key.hash()) % DATA_SHARDS_COUNT];
   }
@@ -246,8 +281,160 @@ private:
 
 struct {
   size_t total_memory_limit{DEFAULT_MEMORY_LIMIT};
+  // the memory is placed into a memfd, which is handed over to the next master on the graceful restart
+  bool handover{false};
 } static instance_cache_settings;
 
+// The instance cache memory which can be handed over to the next master on the graceful restart.
+// The header, the control block and the buffers are placed into one memfd, which the next master maps at the same address,
+// as the cached data is full of pointers: into the memory itself, to the vtables and to the other static data of the binary.
+// Therefore only the next master of the same binary can attach the memory, the others start with the empty cache.
+class HandoverMemory : vk::not_copyable {
+public:
+  using ControlBlock = InterProcessResourceManager<SharedMemoryData, 2>::ControlBlock;
+
+  bool create(size_t pool_size) noexcept {
+    php_assert(fd_ < 0);
+    const Header header = make_header(pool_size);
+    fd_ = memfd_create("kphp_instance_cache", MFD_CLOEXEC);
+    if (fd_ < 0 || ftruncate(fd_, header.full_size) != 0) {
+      kprintf("can't create %" PRIu64 " bytes of instance cache memory to be handed over: %m\n", header.full_size);
+      release();
+      return false;
+    }
+    void *memory = mmap(nullptr, header.full_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (memory == MAP_FAILED) {
+      kprintf("can't mmap %" PRIu64 " bytes of instance cache memory to be handed over: %m\n", header.full_size);
+      release();
+      return false;
+    }
+    memory_ = static_cast<uint8_t *>(memory);
+    size_ = header.full_size;
+    *reinterpret_cast<Header *>(memory_) = header;
+    reinterpret_cast<Header *>(memory_)->base = reinterpret_cast<uintptr_t>(memory_);
+    return true;
+  }
+
+  // checks the memory handed over by the previous master, before this master releases its own one
+  static bool is_compatible(int fd, size_t pool_size) noexcept {
+    Header header{};
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+      return false;
+    }
+    Header expected_header = make_header(pool_size);
+    expected_header.base = header.base;
+    return std::memcmp(&header, &expected_header, sizeof(header)) == 0;
+  }
+
+  // takes the ownership of fd on success
+  bool attach(int fd) noexcept {
+    php_assert(fd_ < 0);
+    Header header{};
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+      return false;
+    }
+    void *address = reinterpret_cast<void *>(header.base);
+    void *memory = mmap(address, header.full_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory != address) {
+      // the address is busy in this process
+      kprintf("can't mmap the instance cache memory at %p, got %p: %m\n", address, memory);
+      if (memory != MAP_FAILED) {
+        munmap(memory, header.full_size);
+      }
+      return false;
+    }
+    fd_ = fd;
+    memory_ = static_cast<uint8_t *>(memory);
+    size_ = header.full_size;
+    return true;
+  }
+
+  void release() noexcept {
+    if (memory_) {
+      munmap(memory_, size_);
+      memory_ = nullptr;
+      size_ = 0;
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  int get_fd() const noexcept {
+    return fd_;
+  }
+
+  void *get_control_block_memory() const noexcept {
+    return memory_ + get_header_size();
+  }
+
+  void *get_resource_memory(size_t pool_size, uint32_t resource_id) const noexcept {
+    return memory_ + get_header_size() + get_control_block_size() + resource_id * get_resource_size(pool_size);
+  }
+
+private:
+  // all the fields are 64-bit, so the header has no padding to compare
+  struct Header {
+    uint64_t magic;
+    // the binary is identified by its file
+    uint64_t binary_dev;
+    uint64_t binary_ino;
+    uint64_t binary_size;
+    uint64_t binary_mtime_ns;
+    uint64_t base;
+    uint64_t full_size;
+    uint64_t pool_size;
+    uint64_t control_block_size;
+    uint64_t context_size;
+    uint64_t shard_size;
+  };
+
+  static constexpr uint64_t HEADER_MAGIC = 0x6b706870696301ULL;
+  static constexpr size_t PAGE_SIZE = 4096;
+
+  static constexpr size_t align_to_page(size_t size) noexcept {
+    return (size + PAGE_SIZE - 1) & -PAGE_SIZE;
+  }
+
+  static constexpr size_t get_header_size() noexcept {
+    return align_to_page(sizeof(Header));
+  }
+
+  static constexpr size_t get_control_block_size() noexcept {
+    return align_to_page(sizeof(ControlBlock));
+  }
+
+  static constexpr size_t get_resource_size(size_t pool_size) noexcept {
+    return align_to_page(SharedMemoryData::get_full_size(pool_size));
+  }
+
+  static Header make_header(size_t pool_size) noexcept {
+    Header header{};
+    header.magic = HEADER_MAGIC;
+    struct stat binary_stat{};
+    if (stat("/proc/self/exe", &binary_stat) == 0) {
+      header.binary_dev = binary_stat.st_dev;
+      header.binary_ino = binary_stat.st_ino;
+      header.binary_size = static_cast<uint64_t>(binary_stat.st_size);
+      header.binary_mtime_ns = static_cast<uint64_t>(binary_stat.st_mtim.tv_sec) * 1000000000 + binary_stat.st_mtim.tv_nsec;
+    }
+    header.full_size = get_header_size() + get_control_block_size() + 2 * get_resource_size(pool_size);
+    header.pool_size = pool_size;
+    header.control_block_size = sizeof(ControlBlock);
+    header.context_size = sizeof(CacheContext);
+    header.shard_size = sizeof(SharedDataStorages);
+    return header;
+  }
+
+  int fd_{-1};
+  uint8_t *memory_{nullptr};
+  size_t size_{0};
+};
+
+constexpr uint64_t HandoverMemory::HEADER_MAGIC;
+constexpr size_t HandoverMemory::PAGE_SIZE;
+
 class InstanceCache {
 private:
   InstanceCache() :
@@ -262,9 +449,50 @@ public:
 
   void global_init() {
     php_assert(!current_ && !context_);
+    if (instance_cache_settings.handover && handover_memory_.create(instance_cache_settings.total_memory_limit)) {
+      init_in_handover_memory(false);
+      return;
+    }
     data_manager_.init(instance_cache_settings.total_memory_limit);
   }
 
+  // this function should be called only from master
+  int get_handover_fd() const noexcept {
+    return handover_memory_.get_fd();
+  }
+
+  // this function should be called only from master
+  void hand_over() noexcept {
+    php_assert(handover_memory_.get_fd() >= 0);
+    // the next master maintains the cache from now on
+    handed_over_ = true;
+  }
+
+  // this function should be called only from master, before the workers are started
+  bool attach_handed_over(int fd) noexcept {
+    php_assert(handover_memory_.get_fd() >= 0);
+    const size_t pool_size = instance_cache_settings.total_memory_limit;
+    if (!HandoverMemory::is_compatible(fd, pool_size)) {
+      close(fd);
+      return false;
+    }
+    // the own memory is released first, as it may occupy the address
+    handover_memory_.release();
+    const bool attached = handover_memory_.attach(fd);
+    if (!attached) {
+      close(fd);
+      const bool created = handover_memory_.create(pool_size);
+      php_assert(created);
+    }
+    init_in_handover_memory(attached);
+    return attached;
+  }
+
+  // this function should be called only from master
+  void release_resources_of_previous_master() noexcept {
+    data_manager_.force_release_resources_of_other_master();
+  }
+
   void refresh() {
     php_assert(!current_ && !context_);
     update_now();
@@ -279,9 +507,12 @@ public:
   void free() {
     php_assert(current_ && context_);
     sync_delayed();
+    // the response has been already sent, therefore we can afford to wait for the allocator lock here
+    commit_deferred();
 
-    // request_cache_ and storing_delayed_ use a script memory
+    // request_cache_, storing_delayed_ and storing_deferred_ use a script memory
     storing_delayed_.clear();
+    storing_deferred_.clear();
     request_cache_.clear();
     // used_elements use a heap memory
     used_elements_.clear();
@@ -306,16 +537,19 @@ public:
     }
 
     sync_delayed();
+    // storing_deferred_ uses a script memory
+    storing_deferred_.unset(key);
     // various service things that we can do without synchronization
-    auto &data = current_->get_data(key);
+    const hashed_string hashed_key{key};
+    auto &data = current_->get_data(hashed_key);
     update_now();
-    if (is_element_insertion_can_be_skipped(data, key)) {
+    if (is_element_insertion_can_be_skipped(data, hashed_key)) {
       return false;
     }
 
     DeepMoveFromScriptToCacheVisitor detach_processor{context_->memory_resource};
     const ElementHolder *inserted_element = try_insert_element_into_cache(
-      data, key, ttl, instance_wrapper, detach_processor);
+      data, hashed_key, ttl, instance_wrapper, detach_processor);
 
     if (!inserted_element) {
       // failed to insert the element due to some problems (e.g. memory, depth limit)
@@ -338,6 +572,25 @@ public:
     return true;
   }
 
+  bool store_deferred(const string &key, const InstanceWrapperBase &instance_wrapper, int64_t ttl) noexcept {
+    ic_debug("store deferred '%s'\n", key.c_str());
+    php_assert(current_ && context_);
+    if (context_->memory_swap_required) {
+      return false;
+    }
+
+    // the instance is immutable, so we just hold it in the script memory and detach it into the cache after the request
+    class_instance<DelayedInstance> deferred_instance;
+    deferred_instance.alloc().get()->ttl = ttl;
+    deferred_instance.get()->instance_wrapper = instance_wrapper.clone_on_script_memory();
+    // request_cache_, storing_delayed_ and storing_deferred_ use a script memory
+    storing_delayed_.unset(key);
+    request_cache_.unset(key);
+    storing_deferred_.set_value(key, std::move(deferred_instance));
+    context_->stats.elements_storing_deferred.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
   const InstanceWrapperBase *fetch(const string &key, bool even_if_expired) {
     php_assert(current_ && context_);
     sync_delayed();
@@ -346,6 +599,11 @@ public:
       ic_debug("fetch '%s' from delayed cache\n", key.c_str());
       return delayed_instance->get()->instance_wrapper.get();
     }
+    // storing_deferred_ uses a script memory
+    if (const auto *deferred_instance = storing_deferred_.find_value(key)) {
+      ic_debug("fetch '%s' from deferred cache\n", key.c_str());
+      return deferred_instance->get()->instance_wrapper.get();
+    }
     // request_cache_ uses a script memory
     if (const ElementHolder *const *cached_element_ptr = request_cache_.find_value(key)) {
       ic_debug("fetch '%s' from request cache\n", key.c_str());
@@ -355,9 +613,10 @@ public:
     vk::intrusive_ptr<ElementHolder> element;
     bool element_logically_expired = false;
     {
-      auto &data = current_->get_data(key);
-      std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-      auto it = data.storage.find(key);
+      const hashed_string hashed_key{key};
+      auto &data = current_->get_data(hashed_key);
+      auto shared_data_lock = data.lock_storage();
+      auto it = data.storage.find(hashed_key);
       if (it == data.storage.end()) {
         ic_debug("can't fetch '%s' because it is absent\n", key.c_str());
         context_->stats.elements_missed.fetch_add(1, std::memory_order_relaxed);
@@ -390,6 +649,7 @@ public:
         ic_debug("fetch '%s' from inter process cache\n", key.c_str());
       }
 
+      it->second->last_fetched_at = now_;
       element = it->second;
     }
 
@@ -415,11 +675,15 @@ public:
     if (const auto *delayed_instance = storing_delayed_.find_value(key)) {
       delayed_instance->get()->ttl = ttl;
     }
+    if (const auto *deferred_instance = storing_deferred_.find_value(key)) {
+      deferred_instance->get()->ttl = ttl;
+    }
 
-    auto &data = current_->get_data(key);
+    const hashed_string hashed_key{key};
+    auto &data = current_->get_data(hashed_key);
     update_now();
-    std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-    auto it = data.storage.find(key);
+    auto shared_data_lock = data.lock_storage();
+    auto it = data.storage.find(hashed_key);
     if (it == data.storage.end()) {
       return false;
     }
@@ -432,13 +696,15 @@ public:
     php_assert(current_ && context_);
     ic_debug("delete '%s'\n", key.c_str());
     sync_delayed();
-    // request_cache_ and storing_delayed_ use a script memory
+    // request_cache_, storing_delayed_ and storing_deferred_ use a script memory
     storing_delayed_.unset(key);
+    storing_deferred_.unset(key);
     request_cache_.unset(key);
-    auto &data = current_->get_data(key);
+    const hashed_string hashed_key{key};
+    auto &data = current_->get_data(hashed_key);
     update_now();
-    std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-    auto it = data.storage.find(key);
+    auto shared_data_lock = data.lock_storage();
+    auto it = data.storage.find(hashed_key);
     if (it == data.storage.end()) {
       return false;
     }
@@ -458,6 +724,9 @@ public:
 
   // this function should be called only from master
   void purge_expired() {
+    if (handed_over_) {
+      return;
+    }
     update_now();
     const auto now_with_delay = now_ - PHYSICAL_REMOVING_DELAY;
 
@@ -468,6 +737,12 @@ public:
     // we need to explicitly activate and deactivate it
     auto shared_memory_guard = context.memory_replacement_guard(true);
 
+    // under the memory pressure, the least recently fetched element of each visited shard is evicted,
+    // so the cold elements free the memory before the buffer is swapped
+    const auto &memory_stats = context.memory_resource.get_memory_stats();
+    const bool eviction_required = static_cast<double>(memory_stats.real_memory_used) >=
+                                   EVICTION_MEMORY_USED_THRESHOLD * static_cast<double>(memory_stats.memory_limit);
+
     auto *data_shards = current_data.get_data_shards();
     const size_t shards_count = current_data.get_data_shards_count();
     for (size_t shard_id = purge_shard_offset_; shard_id < shards_count; shard_id += SHARDS_PURGE_PERIOD) {
@@ -475,8 +750,8 @@ public:
       if (data_shard.is_storage_empty.load(std::memory_order_relaxed)) {
         continue;
       }
-      {
-        std::lock_guard<inter_process_mutex> shared_data_lock{data_shard.storage_mutex};
+      if (!eviction_required) {
+        auto shared_data_lock = data_shard.lock_storage();
         if (std::none_of(data_shard.storage.begin(), data_shard.storage.end(),
                          [now_with_delay](const auto &stored_element) {
                            return stored_element.second->expiring_at <= now_with_delay;
@@ -487,19 +762,33 @@ public:
 
       // lock in this very order and do not move allocator_lock anywhere below, otherwise it will result in a deadlock!
       std::lock_guard<inter_process_mutex> allocator_lock{context.allocator_mutex};
-      std::lock_guard<inter_process_mutex> shared_data_lock{data_shard.storage_mutex};
+      auto shared_data_lock = data_shard.lock_storage();
+      auto remove_element = [&data_shard, &context](ElementStorage_::iterator it) {
+        string removing_key = it->first.str();
+        it = data_shard.storage.erase(it);
+        DeepDestroyFromCacheVisitor{}.process(removing_key);
+        context.stats.elements_cached.fetch_sub(1, std::memory_order_relaxed);
+        return it;
+      };
+      auto least_recently_fetched = data_shard.storage.end();
       for (auto it = data_shard.storage.begin(); it != data_shard.storage.end();) {
         if (it->second->expiring_at <= now_with_delay) {
-          ic_debug("purge '%s'\n", it->first.c_str());
-          string removing_key = it->first;
-          it = data_shard.storage.erase(it);
-          DeepDestroyFromCacheVisitor{}.process(removing_key);
+          ic_debug("purge '%s'\n", it->first.str().c_str());
+          it = remove_element(it);
           context.stats.elements_expired.fetch_add(1, std::memory_order_relaxed);
-          context.stats.elements_cached.fetch_sub(1, std::memory_order_relaxed);
         } else {
+          if (least_recently_fetched == data_shard.storage.end() ||
+              it->second->last_fetched_at < least_recently_fetched->second->last_fetched_at) {
+            least_recently_fetched = it;
+          }
           ++it;
         }
       }
+      if (eviction_required && least_recently_fetched != data_shard.storage.end()) {
+        ic_debug("evict '%s'\n", least_recently_fetched->first.str().c_str());
+        remove_element(least_recently_fetched);
+        context.stats.elements_evicted.fetch_add(1, std::memory_order_relaxed);
+      }
       data_shard.is_storage_empty.store(data_shard.storage.empty(), std::memory_order_relaxed);
     }
 
@@ -512,6 +801,9 @@ public:
 
   // this function should be called only from master
   InstanceCacheSwapStatus try_swap_memory_resource() {
+    if (handed_over_) {
+      return InstanceCacheSwapStatus::no_need;
+    }
     const auto &memory_stats = get_last_memory_stats();
     const auto threshold = REAL_MEMORY_USED_THRESHOLD * static_cast<double>(memory_stats.memory_limit);
     if (static_cast<double>(memory_stats.real_memory_used) < threshold &&
@@ -528,20 +820,38 @@ public:
     return data_manager_.get_current_resource().get_context().stats;
   }
 
+  // this function should be called only from master
+  InstanceCacheShardsStats get_shards_stats() {
+    InstanceCacheShardsStats result;
+    auto &current_data = data_manager_.get_current_resource();
+    const auto *data_shards = current_data.get_data_shards();
+    result.shards_count = current_data.get_data_shards_count();
+    for (size_t shard_id = 0; shard_id != result.shards_count; ++shard_id) {
+      const auto &lock_stats = data_shards[shard_id].storage_mutex.get_stats();
+      const uint64_t shard_contentions = lock_stats.contentions.load(std::memory_order_relaxed);
+      result.total_lock_acquisitions += lock_stats.acquisitions.load(std::memory_order_relaxed);
+      result.total_lock_wait_time_ns += lock_stats.wait_time_ns.load(std::memory_order_relaxed);
+      result.total_lock_contentions += shard_contentions;
+      result.max_shard_lock_contentions = std::max(result.max_shard_lock_contentions, shard_contentions);
+      result.contended_shards += shard_contentions ? 1 : 0;
+    }
+    return result;
+  }
+
   // this function should be called only from master
   const memory_resource::MemoryStats &get_last_memory_stats() const noexcept {
     return last_memory_stats_;
   }
 
 private:
-  bool is_element_insertion_can_be_skipped(SharedDataStorages &data, const string &key) const {
-    std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
+  bool is_element_insertion_can_be_skipped(SharedDataStorages &data, const hashed_string &key) const {
+    auto shared_data_lock = data.lock_storage();
     auto it = data.storage.find(key);
     // allow to skip the insertion of the element if it was inserted by another process recently enough
     if (it != data.storage.end() &&
         it->second->freshness_ratio(now_) < FRESHNESS_ELEMENT_RATIO &&
         it->second->inserted_by_process != getpid()) {
-      ic_debug("skip '%s' because it was recently updated\n", key.c_str());
+      ic_debug("skip '%s' because it was recently updated\n", key.str().c_str());
       context_->stats.elements_storing_skipped_due_recent_update.fetch_add(1, std::memory_order_relaxed);
       return true;
     }
@@ -559,14 +869,15 @@ private:
       php_assert(it.is_string_key());
       const auto &key = it.get_string_key();
       const auto &delayed_instance = *it.get_value().get();
-      auto &data = current_->get_data(key);
+      const hashed_string hashed_key{key};
+      auto &data = current_->get_data(hashed_key);
       update_now();
-      if (is_element_insertion_can_be_skipped(data, key)) {
+      if (is_element_insertion_can_be_skipped(data, hashed_key)) {
         storing_delayed_.unset(key);
         continue;
       }
       const ElementHolder *inserted_element = try_insert_element_into_cache(
-        data, key, delayed_instance.ttl,
+        data, hashed_key, delayed_instance.ttl,
         *delayed_instance.instance_wrapper, detach_processor);
       if (!inserted_element) {
         if (likely(detach_processor.is_ok())) {
@@ -587,16 +898,48 @@ private:
     }
   }
 
+  // commits the elements which were stored with instance_cache_store_async()
+  void commit_deferred() noexcept {
+    php_assert(current_ && context_);
+    for (auto it = storing_deferred_.cbegin(); it != storing_deferred_.cend(); ++it) {
+      if (context_->memory_swap_required) {
+        return;
+      }
+      php_assert(it.is_string_key());
+      const auto &key = it.get_string_key();
+      const auto &deferred_instance = *it.get_value().get();
+      const hashed_string hashed_key{key};
+      auto &data = current_->get_data(hashed_key);
+      update_now();
+      if (is_element_insertion_can_be_skipped(data, hashed_key)) {
+        continue;
+      }
+      DeepMoveFromScriptToCacheVisitor detach_processor{context_->memory_resource};
+      const ElementHolder *inserted_element = try_insert_element_into_cache(
+        data, hashed_key, deferred_instance.ttl,
+        *deferred_instance.instance_wrapper, detach_processor, true);
+      if (inserted_element) {
+        ic_debug("element '%s' was successfully inserted after the request\n", key.c_str());
+        context_->stats.elements_stored_deferred.fetch_add(1, std::memory_order_relaxed);
+      } else if (unlikely(!detach_processor.is_ok())) {
+        fire_warning(detach_processor, deferred_instance.instance_wrapper->get_class());
+      }
+    }
+  }
+
   ElementHolder *try_insert_element_into_cache(SharedDataStorages &data,
-                                               const string &key_in_script_memory, int64_t ttl,
+                                               const hashed_string &key_in_script_memory, int64_t ttl,
                                                const InstanceWrapperBase &instance_wrapper,
-                                               DeepMoveFromScriptToCacheVisitor &detach_processor) noexcept {
+                                               DeepMoveFromScriptToCacheVisitor &detach_processor,
+                                               bool wait_for_allocator = false) noexcept {
     // swap the allocator
     auto shared_memory_guard = context_->memory_replacement_guard();
 
-    std::unique_lock<inter_process_mutex> allocator_lock{context_->allocator_mutex, std::try_to_lock};
+    std::unique_lock<inter_process_mutex> allocator_lock{context_->allocator_mutex, std::defer_lock};
     // locking strictly before the storage_mutex to avoid a deadlock
-    if (!allocator_lock) {
+    if (wait_for_allocator) {
+      allocator_lock.lock();
+    } else if (!allocator_lock.try_lock()) {
       return nullptr;
     }
 
@@ -607,16 +950,16 @@ private:
     if (auto cached_instance_wrapper = instance_wrapper.clone_and_detach_shared_ref(detach_processor)) {
       if (void *mem = detach_processor.prepare_raw_memory(sizeof(ElementHolder))) {
         vk::intrusive_ptr<ElementHolder> element{new(mem) ElementHolder{now_, ttl, std::move(cached_instance_wrapper), *context_}};
-        std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
+        auto shared_data_lock = data.lock_storage();
         auto it = data.storage.find(key_in_script_memory);
         if (it == data.storage.end()) {
-          string key_in_shared_memory = key_in_script_memory;
-          if (unlikely(!detach_processor.process(key_in_shared_memory))) {
+          hashed_string key_in_shared_memory = key_in_script_memory;
+          if (unlikely(!detach_processor.process(key_in_shared_memory.str()))) {
             return nullptr;
           }
           constexpr auto node_max_size = ElementStorage_::allocator_type::max_value_type_size();
           if (unlikely(!detach_processor.is_enough_memory_for(node_max_size))) {
-            DeepDestroyFromCacheVisitor{}.process(key_in_shared_memory);
+            DeepDestroyFromCacheVisitor{}.process(key_in_shared_memory.str());
             return nullptr;
           }
 
@@ -638,6 +981,19 @@ private:
     return nullptr;
   }
 
+  void init_in_handover_memory(bool attach) noexcept {
+    const size_t pool_size = instance_cache_settings.total_memory_limit;
+    data_manager_.init_in_memory(handover_memory_.get_control_block_memory(), attach,
+                                 [this, attach, pool_size](SharedMemoryData &resource, uint32_t resource_id) {
+                                   void *memory = handover_memory_.get_resource_memory(pool_size, resource_id);
+                                   if (attach) {
+                                     resource.attach(memory, pool_size);
+                                   } else {
+                                     resource.init_in(memory, pool_size);
+                                   }
+                                 });
+  }
+
   void fire_warning(const DeepMoveFromScriptToCacheVisitor &detach_processor, const char *class_name) noexcept {
     if (detach_processor.is_depth_limit_exceeded()) {
       php_warning("Depth limit exceeded on cloning instance of class '%s' into cache", class_name);
@@ -651,6 +1007,8 @@ private:
   SharedMemoryData *current_{nullptr};
   CacheContext *context_{nullptr};
   InterProcessResourceManager<SharedMemoryData, 2> data_manager_;
+  HandoverMemory handover_memory_;
+  bool handed_over_{false};
 
 
   struct IntrusivePtrHash {
@@ -676,6 +1034,9 @@ private:
     int64_t ttl{0};
   };
   array<class_instance<DelayedInstance>> storing_delayed_;
+  // A container for instances which are stored by instance_cache_store_async(), they are committed after the request
+  // Uses script memory
+  array<class_instance<DelayedInstance>> storing_deferred_;
 
   std::chrono::nanoseconds now_{std::chrono::nanoseconds::zero()};
   memory_resource::MemoryStats last_memory_stats_;
@@ -684,6 +1045,7 @@ private:
 
 DeepMoveFromScriptToCacheVisitor::DeepMoveFromScriptToCacheVisitor(memory_resource::unsynchronized_pool_resource &memory_pool) noexcept:
   Basic(*this),
+  copy_global_consts_(instance_cache_settings.handover),
   memory_pool_(memory_pool) {
 }
 
@@ -692,7 +1054,7 @@ DeepDestroyFromCacheVisitor::DeepDestroyFromCacheVisitor() :
 }
 
 bool DeepMoveFromScriptToCacheVisitor::process(string &str) {
-  if (str.is_reference_counter(ExtraRefCnt::for_global_const)) {
+  if (!copy_global_consts_ && str.is_reference_counter(ExtraRefCnt::for_global_const)) {
     return true;
   }
 
@@ -725,6 +1087,10 @@ bool instance_cache_store(const string &key, const InstanceWrapperBase &instance
   return InstanceCache::get().store(key, instance_wrapper, ttl);
 }
 
+bool instance_cache_store_deferred(const string &key, const InstanceWrapperBase &instance_wrapper, int64_t ttl) {
+  return InstanceCache::get().store_deferred(key, instance_wrapper, ttl);
+}
+
 const InstanceWrapperBase *instance_cache_fetch_wrapper(const string &key, bool even_if_expired) {
   return InstanceCache::get().fetch(key, even_if_expired);
 }
@@ -748,6 +1114,31 @@ void set_instance_cache_memory_limit(size_t limit) {
   ic_impl_::instance_cache_settings.total_memory_limit = limit;
 }
 
+// should be called only from master, before global_init_instance_cache_lib()
+void set_instance_cache_handover(bool enabled) {
+  ic_impl_::instance_cache_settings.handover = enabled;
+}
+
+// should be called only from master
+int instance_cache_get_handover_fd() {
+  return ic_impl_::InstanceCache::get().get_handover_fd();
+}
+
+// should be called only from master
+void instance_cache_hand_over() {
+  ic_impl_::InstanceCache::get().hand_over();
+}
+
+// should be called only from master
+bool instance_cache_attach_handed_over(int fd) {
+  return ic_impl_::InstanceCache::get().attach_handed_over(fd);
+}
+
+// should be called only from master
+void instance_cache_release_resources_of_previous_master() {
+  ic_impl_::InstanceCache::get().release_resources_of_previous_master();
+}
+
 // should be called only from master
 InstanceCacheSwapStatus instance_cache_try_swap_memory() {
   return ic_impl_::InstanceCache::get().try_swap_memory_resource();
@@ -758,6 +1149,11 @@ const InstanceCacheStats &instance_cache_get_stats() {
   return ic_impl_::InstanceCache::get().get_stats();
 }
 
+// should be called only from master
+InstanceCacheShardsStats instance_cache_get_shards_stats() {
+  return ic_impl_::InstanceCache::get().get_shards_stats();
+}
+
 // should be called only from master
 const memory_resource::MemoryStats &instance_cache_get_memory_stats() {
   return ic_impl_::InstanceCache::get().get_last_memory_stats();
@@ -12,9 +12,15 @@
 //    therefore the reference counter of cached strings and arrays is ExtraRefCnt::for_instance_cache or ExtraRefCnt::for_global_const;
 //  3) On fetch, all strings and arrays are returned as is;
 //  4) On store, all instances (and sub instances) are deeply cloned into instance cache;
-//  5) On fetch, all instances (and sub instances) are deeply cloned from instance cache;
+//  5) On fetch, all instances (and sub instances) are returned as is, without any copying:
+//    only immutable classes (check @kphp-immutable-class) can be stored and fetched, so the script gets a read-only
+//    handle into the shared memory, the reference counter of which is ExtraRefCnt::for_instance_cache;
 //  6) All instances (with all members) are destroyed strictly before or after request,
-//    and shouldn't be destroyed while request.
+//    and shouldn't be destroyed while request;
+//  7) With the handover on the graceful restart, the constant strings and arrays are deeply copied as well,
+//    as the next master has its own constants, and it attaches the cache memory only if it runs the same binary.
+
+#include <algorithm>
 
 #include "common/mixin/not_copyable.h"
 
@@ -52,7 +58,7 @@ public:
 
   template<typename ...Args>
   bool process(std::tuple<Args...> &value) {
-    return process_tuple(value);
+    return process_tuple(value, std::index_sequence_for<Args...>{});
   }
 
   template<size_t ...Is, typename ...T>
@@ -92,15 +98,11 @@ protected:
   }
 
 private:
-  template<size_t Index = 0, typename ...Args>
-  std::enable_if_t<Index != sizeof...(Args), bool> process_tuple(std::tuple<Args...> &value) {
-    bool res = child_.process(std::get<Index>(value));
-    return process_tuple<Index + 1>(value) && res;
-  }
-
-  template<size_t Index = 0, typename ...Args>
-  std::enable_if_t<Index == sizeof...(Args), bool> process_tuple(std::tuple<Args...> &) {
-    return true;
+  // all the elements are processed, even if some of them fail
+  template<typename ...Args, size_t ...Is>
+  bool process_tuple(std::tuple<Args...> &value, std::index_sequence<Is...>) {
+    const bool child_res[] = {true, child_.process(std::get<Is>(value))...};
+    return std::all_of(std::begin(child_res), std::end(child_res), [](bool r) { return r; });
   }
 
   bool is_ok_{true};
@@ -118,7 +120,7 @@ public:
 
   template<typename T>
   bool process(array<T> &arr) {
-    if (arr.is_reference_counter(ExtraRefCnt::for_global_const)) {
+    if (!copy_global_consts_ && arr.is_reference_counter(ExtraRefCnt::for_global_const)) {
       return true;
     }
     if (unlikely(!is_enough_memory_for(arr.estimate_memory_usage()))) {
@@ -190,6 +192,7 @@ public:
 private:
   bool memory_limit_exceeded_{false};
   bool is_depth_limit_exceeded_{false};
+  const bool copy_global_consts_{false};
   uint8_t instance_depth_level_{0u};
   const uint8_t instance_depth_level_limit_{128u};
   memory_resource::unsynchronized_pool_resource &memory_pool_;
@@ -283,6 +286,7 @@ private:
 };
 
 bool instance_cache_store(const string &key, const InstanceWrapperBase &instance_wrapper, int64_t ttl);
+bool instance_cache_store_deferred(const string &key, const InstanceWrapperBase &instance_wrapper, int64_t ttl);
 const InstanceWrapperBase *instance_cache_fetch_wrapper(const string &key, bool even_if_expired);
 
 } // namespace ic_impl_
@@ -296,18 +300,23 @@ void free_instance_cache_lib();
 
 // these function should be called from master
 void set_instance_cache_memory_limit(size_t limit);
+// these function should be called from master, before global_init_instance_cache_lib()
+void set_instance_cache_handover(bool enabled);
 
 struct InstanceCacheStats : private vk::not_copyable {
   std::atomic<uint64_t> elements_stored{0};
   std::atomic<uint64_t> elements_stored_with_delay{0};
   std::atomic<uint64_t> elements_storing_skipped_due_recent_update{0};
   std::atomic<uint64_t> elements_storing_delayed_due_mutex{0};
+  std::atomic<uint64_t> elements_storing_deferred{0};
+  std::atomic<uint64_t> elements_stored_deferred{0};
 
   std::atomic<uint64_t> elements_fetched{0};
   std::atomic<uint64_t> elements_missed{0};
   std::atomic<uint64_t> elements_missed_earlier{0};
 
   std::atomic<uint64_t> elements_expired{0};
+  std::atomic<uint64_t> elements_evicted{0};
   std::atomic<uint64_t> elements_logically_expired_but_fetched{0};
   std::atomic<uint64_t> elements_logically_expired_and_ignored{0};
   std::atomic<uint64_t> elements_created{0};
@@ -315,6 +324,15 @@ struct InstanceCacheStats : private vk::not_copyable {
   std::atomic<uint64_t> elements_cached{0};
 };
 
+struct InstanceCacheShardsStats {
+  size_t shards_count{0};
+  size_t contended_shards{0};
+  uint64_t total_lock_acquisitions{0};
+  uint64_t total_lock_contentions{0};
+  uint64_t max_shard_lock_contentions{0};
+  uint64_t total_lock_wait_time_ns{0};
+};
+
 enum class InstanceCacheSwapStatus {
   no_need, // no need to do a swap
   swap_is_finished, // swap succeeded
@@ -325,9 +343,19 @@ InstanceCacheSwapStatus instance_cache_try_swap_memory();
 // these function should be called from master
 const InstanceCacheStats &instance_cache_get_stats();
 // these function should be called from master
+InstanceCacheShardsStats instance_cache_get_shards_stats();
+// these function should be called from master
 const memory_resource::MemoryStats &instance_cache_get_memory_stats();
 // these function should be called from master
 void instance_cache_purge_expired_elements();
+// these function should be called from master: the fd of the cache memory to be handed over to the next master, or -1
+int instance_cache_get_handover_fd();
+// these function should be called from master, after the fd is sent: the next master maintains the cache from now on
+void instance_cache_hand_over();
+// these function should be called from master before the workers are started: false if the cache can't be attached
+bool instance_cache_attach_handed_over(int fd);
+// these function should be called from master, after the previous master has exited
+void instance_cache_release_resources_of_previous_master();
 
 void instance_cache_release_all_resources_acquired_by_this_proc();
 
@@ -341,6 +369,17 @@ bool f$instance_cache_store(const string &key, const ClassInstanceType &instance
   return ic_impl_::instance_cache_store(key, instance_wrapper, ttl);
 }
 
+// the instance is detached into the cache after the request, when the response has been already sent
+template<typename ClassInstanceType>
+bool f$instance_cache_store_async(const string &key, const ClassInstanceType &instance, int64_t ttl = 0) {
+  static_assert(is_class_instance<ClassInstanceType>::value, "class_instance<> type expected");
+  if (instance.is_null()) {
+    return false;
+  }
+  ic_impl_::InstanceWrapper<ClassInstanceType> instance_wrapper{instance};
+  return ic_impl_::instance_cache_store_deferred(key, instance_wrapper, ttl);
+}
+
 template<typename ClassInstanceType>
 ClassInstanceType f$instance_cache_fetch(const string &class_name, const string &key, bool even_if_expired = false) {
   static_assert(is_class_instance<ClassInstanceType>::value, "class_instance<> type expected");
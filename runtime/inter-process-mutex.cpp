@@ -4,11 +4,15 @@
 
 #include "runtime/inter-process-mutex.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <linux/futex.h>
 #include <syscall.h>
 
+#include "common/wrappers/likely.h"
+
 #include "runtime/critical_section.h"
 #include "runtime/php_assert.h"
 #include "server/php-engine-vars.h"
@@ -39,34 +43,55 @@ void handle_lock_error(pid_t *lock, const char *what) noexcept {
   }
 }
 
+namespace {
+
+// the lock owners usually hold these locks for a very short time, so a waiter spins with the growing pauses
+// and parks in the kernel only if the lock is still owned after that
+constexpr uint32_t SPIN_ATTEMPTS = 16;
+constexpr uint32_t MAX_PAUSES_PER_ATTEMPT = 64;
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+} // namespace
+
 void inter_process_mutex::lock() noexcept {
   dl::enter_critical_section();
   const pid_t tid = get_main_thread_id();
-  constexpr size_t trylock_period = 512;
-  constexpr size_t lock_period = trylock_period * 4;
-  size_t counter = 0;
-  bool tid_checked = false;
-  while (!__sync_bool_compare_and_swap(&lock_, 0, tid)) {
-    ++counter;
-    if (counter % lock_period == 0) {
-      if (!tid_checked) {
-        check_that_tid_and_cached_pid_same();
-        tid_checked = true;
-      }
-      if (!futex(&lock_, FUTEX_LOCK_PI)) {
-        return;
-      } else {
-        handle_lock_error(&lock_, "lock");
-      }
-    } else if (counter % trylock_period == 0) {
-      if (!futex(&lock_, FUTEX_TRYLOCK_PI)) {
-        return;
-      } else {
-        handle_lock_error(&lock_, "try lock");
-      }
+  if (unlikely(!__sync_bool_compare_and_swap(&lock_, 0, tid))) {
+    lock_contended(tid);
+  }
+  stats_.acquisitions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void inter_process_mutex::lock_contended(pid_t tid) noexcept {
+  const auto wait_start = std::chrono::steady_clock::now();
+  bool locked = false;
+  for (uint32_t attempt = 0, pauses = 1; attempt != SPIN_ATTEMPTS && !locked; ++attempt) {
+    for (uint32_t i = 0; i != pauses; ++i) {
+      cpu_relax();
+    }
+    pauses = std::min(pauses * 2, MAX_PAUSES_PER_ATTEMPT);
+    // don't pull the cacheline in the exclusive state while the lock is owned
+    locked = !__atomic_load_n(&lock_, __ATOMIC_RELAXED) && __sync_bool_compare_and_swap(&lock_, 0, tid);
+  }
+
+  if (!locked) {
+    check_that_tid_and_cached_pid_same();
+    // FUTEX_LOCK_PI sleeps until the lock is released and takes it for us; if the owner is dead, the lock is cleaned up and taken again
+    while (!__sync_bool_compare_and_swap(&lock_, 0, tid) && futex(&lock_, FUTEX_LOCK_PI)) {
+      handle_lock_error(&lock_, "lock");
     }
-    __sync_synchronize();
   }
+
+  const std::chrono::nanoseconds wait_time = std::chrono::steady_clock::now() - wait_start;
+  stats_.contentions.fetch_add(1, std::memory_order_relaxed);
+  stats_.wait_time_ns.fetch_add(static_cast<uint64_t>(wait_time.count()), std::memory_order_relaxed);
 }
 
 bool inter_process_mutex::try_lock() noexcept {
@@ -76,6 +101,7 @@ bool inter_process_mutex::try_lock() noexcept {
   for (size_t attempts = 0; attempts != 2; ++attempts) {
     if (__sync_bool_compare_and_swap(&lock_, 0, tid) ||
         !futex(&lock_, FUTEX_TRYLOCK_PI)) {
+      stats_.acquisitions.fetch_add(1, std::memory_order_relaxed);
       return true;
     }
     handle_lock_error(&lock_, "try lock");
@@ -93,3 +119,13 @@ void inter_process_mutex::unlock() noexcept {
   }
   dl::leave_critical_section();
 }
+
+uint32_t inter_process_seqlock::read_begin() const noexcept {
+  uint32_t seq = seq_.load(std::memory_order_seq_cst);
+  // the odd sequence means that the writer is in progress
+  while (unlikely(seq & 1)) {
+    cpu_relax();
+    seq = seq_.load(std::memory_order_seq_cst);
+  }
+  return seq;
+}
@@ -3,17 +3,71 @@
 // Distributed under the GPL v3 License, see LICENSE.notice.txt
 
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <sys/types.h>
 
 #include "common/mixin/not_copyable.h"
 #include "common/cacheline.h"
 
+// the counters live in the shared memory together with the lock, so they are summed over all processes
+struct inter_process_lock_stats {
+  // successful lock() and try_lock() calls
+  std::atomic<uint64_t> acquisitions{0};
+  // lock() calls which found the lock owned by another process
+  std::atomic<uint64_t> contentions{0};
+  // the total time spent by lock() in the contended calls
+  std::atomic<uint64_t> wait_time_ns{0};
+};
+
 class inter_process_mutex : vk::not_copyable {
 public:
   void lock() noexcept;
   bool try_lock() noexcept;
   void unlock() noexcept;
 
+  const inter_process_lock_stats &get_stats() const noexcept {
+    return stats_;
+  }
+
 private:
+  void lock_contended(pid_t tid) noexcept;
+
   alignas(KDB_CACHELINE_SIZE) pid_t lock_{0};
+  // updated only by the owner, so they share the cacheline with the lock
+  inter_process_lock_stats stats_;
+};
+
+// A sequence lock for a tiny metadata which is read by all workers and rarely written by master.
+// The readers never block the writer, therefore a reader killed in the middle of a read can't hang anybody.
+// The writers must be serialized by the caller.
+class inter_process_seqlock : vk::not_copyable {
+public:
+  void write_begin() noexcept {
+    seq_.fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  void write_end() noexcept {
+    seq_.fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  uint32_t read_begin() const noexcept;
+
+  // returns true, if the data read since read_begin() may be inconsistent and the read must be repeated
+  bool read_retry(uint32_t seq) noexcept {
+    if (seq_.load(std::memory_order_seq_cst) == seq) {
+      return false;
+    }
+    read_retries_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  uint64_t get_read_retries() const noexcept {
+    return read_retries_.load(std::memory_order_relaxed);
+  }
+
+private:
+  alignas(KDB_CACHELINE_SIZE) std::atomic<uint32_t> seq_{0};
+  // the readers don't count their successful reads: a shared counter would make them contend for the cacheline
+  std::atomic<uint64_t> read_retries_{0};
 };
@@ -4,16 +4,23 @@
 
 #pragma once
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <bitset>
 #include <cstring>
 #include <sys/mman.h>
 
-#include "common/parallel/lock_accessible.h"
-
 #include "runtime/inter-process-mutex.h"
 #include "runtime/php_assert.h"
 #include "server/php-engine-vars.h"
 
+// Every worker writes only its own acquired pid slots, and only master switches the active resource,
+// so the workers don't lock anything: a worker publishes its pid in the slot of the active resource
+// and checks that the active resource hasn't been switched meanwhile, while master switches it under the seqlock
+// and checks the slots after the switch. All these accesses are sequentially consistent,
+// therefore either the worker sees the switch and retries, or master sees the worker pid.
+// The workers of the two masters running on the graceful restart have separate slots,
+// as the next master may attach the resources handed over by the previous one.
 template<size_t RESOURCE_AMOUNT>
 class InterProcessResourceControl {
 public:
@@ -21,65 +28,98 @@ public:
 
   InterProcessResourceControl() {
     for (auto &pids: acquired_pids_) {
-      pids.fill(0);
+      for (auto &stored_pid: pids) {
+        stored_pid.store(0, std::memory_order_relaxed);
+      }
     }
   }
 
   uint32_t acquire_active_resource_id() noexcept {
-    const uint32_t resource_id = get_active_resource_id();
-    acquired_pids_[resource_id][get_user_index()] = pid;
-    return resource_id;
+    const size_t user_index = get_user_index();
+    while (true) {
+      const uint32_t seq = active_resource_seqlock_.read_begin();
+      const uint32_t resource_id = active_resource_id_.load(std::memory_order_relaxed);
+      std::atomic<pid_t> &stored_pid = acquired_pids_[resource_id][user_index];
+      stored_pid.store(pid, std::memory_order_seq_cst);
+      if (!active_resource_seqlock_.read_retry(seq)) {
+        return resource_id;
+      }
+      stored_pid.store(0, std::memory_order_seq_cst);
+    }
   }
 
   void release(uint32_t resource_id) noexcept {
     php_assert(resource_id < RESOURCE_AMOUNT);
-    pid_t &stored_pid = acquired_pids_[resource_id][get_user_index()];
-    php_assert(stored_pid == pid);
-    stored_pid = 0;
+    std::atomic<pid_t> &stored_pid = acquired_pids_[resource_id][get_user_index()];
+    php_assert(stored_pid.load(std::memory_order_relaxed) == pid);
+    stored_pid.store(0, std::memory_order_seq_cst);
   }
 
   void force_release_all_resources() noexcept {
     const auto user_index = get_user_index();
     for (size_t resource_id = 0; resource_id != RESOURCE_AMOUNT; ++resource_id) {
-      acquired_pids_[resource_id][user_index] = 0;
+      acquired_pids_[resource_id][user_index].store(0, std::memory_order_seq_cst);
     }
   }
 
   uint32_t get_active_resource_id() const noexcept {
-    return active_resource_id_;
+    return active_resource_id_.load(std::memory_order_relaxed);
   }
 
   uint32_t get_next_inactive_resource_id() const noexcept {
-    return (active_resource_id_ + 1) % RESOURCE_AMOUNT;
+    return (get_active_resource_id() + 1) % RESOURCE_AMOUNT;
   }
 
   bool is_resource_unused(uint32_t resource_id) noexcept {
     php_assert(resource_id < RESOURCE_AMOUNT);
-    constexpr static std::array<pid_t, MAX_WORKERS> zeros = {0};
+    const auto is_unused = [](const std::atomic<pid_t> &stored_pid) { return stored_pid.load(std::memory_order_seq_cst) == 0; };
     const int32_t total_server_workers = std::max(1, workers_n);
-    const auto worker_pid_it = acquired_pids_[resource_id].begin();
-    return std::equal(worker_pid_it, worker_pid_it + total_server_workers, zeros.begin());
+    const auto worker_pid_it = acquired_pids_[resource_id].begin() + get_master_offset(master_slot_id);
+    // the number of workers of the other master is unknown here
+    const auto other_worker_pid_it = acquired_pids_[resource_id].begin() + get_master_offset(1 - master_slot_id);
+    return std::all_of(worker_pid_it, worker_pid_it + total_server_workers, is_unused) &&
+           std::all_of(other_worker_pid_it, other_worker_pid_it + MAX_WORKERS, is_unused);
   }
 
+  // the other master has exited, and its workers can't release the resources anymore
+  void force_release_resources_of_other_master() noexcept {
+    for (auto &pids: acquired_pids_) {
+      const auto other_worker_pid_it = pids.begin() + get_master_offset(1 - master_slot_id);
+      std::for_each(other_worker_pid_it, other_worker_pid_it + MAX_WORKERS,
+                    [](std::atomic<pid_t> &stored_pid) { stored_pid.store(0, std::memory_order_seq_cst); });
+    }
+  }
+
+  // this function should be called only from master
   uint32_t switch_active_to_next() noexcept {
-    const uint32_t prev_active = active_resource_id_;
-    active_resource_id_ = get_next_inactive_resource_id();
+    const uint32_t prev_active = get_active_resource_id();
+    active_resource_seqlock_.write_begin();
+    active_resource_id_.store(get_next_inactive_resource_id(), std::memory_order_relaxed);
+    active_resource_seqlock_.write_end();
     return prev_active;
   }
 
 private:
+  static size_t get_master_offset(int master_slot) noexcept {
+    php_assert(master_slot == 0 || master_slot == 1);
+    return static_cast<size_t>(master_slot) * MAX_WORKERS;
+  }
+
   static size_t get_user_index() noexcept {
     php_assert(logname_id >= 0 && logname_id < MAX_WORKERS);
-    return static_cast<size_t>(logname_id);
+    return get_master_offset(master_slot_id) + static_cast<size_t>(logname_id);
   }
 
-  uint32_t active_resource_id_{0};
-  std::array<std::array<pid_t, MAX_WORKERS>, RESOURCE_AMOUNT> acquired_pids_;
+  inter_process_seqlock active_resource_seqlock_;
+  std::atomic<uint32_t> active_resource_id_{0};
+  std::array<std::array<std::atomic<pid_t>, 2 * MAX_WORKERS>, RESOURCE_AMOUNT> acquired_pids_;
 };
 
 template<typename T, size_t RESOURCE_AMOUNT>
 class InterProcessResourceManager {
 public:
+  using ControlBlock = InterProcessResourceControl<RESOURCE_AMOUNT>;
+
   InterProcessResourceManager() noexcept :
     initiate_process_pid_{pid} {
   }
@@ -95,12 +135,25 @@ public:
     void *mem_for_control_block = mmap(nullptr, sizeof(*control_block_),
                                        PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, -1, 0);
     php_assert(mem_for_control_block);
-    control_block_ = new(mem_for_control_block) std::decay_t<decltype(*control_block_)>{};
+    control_block_ = new(mem_for_control_block) ControlBlock{};
+  }
+
+  // the same as init(), but the memory is placed by the caller, e.g. to hand it over to the next master:
+  // init_resource(resource, resource_id) initializes each resource, and the control block is constructed in the given memory,
+  // unless it's attached, i.e. it has been already constructed by the previous master
+  template<typename F>
+  void init_in_memory(void *mem_for_control_block, bool attach, F &&init_resource) noexcept {
+    php_assert(is_initial_process());
+    for (uint32_t resource_id = 0; resource_id != RESOURCE_AMOUNT; ++resource_id) {
+      init_resource(switchable_resource_[resource_id], resource_id);
+    }
+    control_block_ = attach ? static_cast<ControlBlock *>(mem_for_control_block) : new(mem_for_control_block) ControlBlock{};
+    owns_control_block_memory_ = false;
   }
 
   T *acquire_current_resource() noexcept {
     php_assert(control_block_);
-    const uint32_t resource_id = (*control_block_)->acquire_active_resource_id();
+    const uint32_t resource_id = control_block_->acquire_active_resource_id();
     return &switchable_resource_[resource_id];
   }
 
@@ -110,30 +163,35 @@ public:
                                  [data](const T &res) { return &res == data; });
     php_assert(it != switchable_resource_.end());
     const auto resource_id = static_cast<uint32_t>(it - switchable_resource_.begin());
-    (*control_block_)->release(resource_id);
+    control_block_->release(resource_id);
   }
 
   void force_release_all_resources() noexcept {
-    (*control_block_)->force_release_all_resources();
+    control_block_->force_release_all_resources();
+  }
+
+  // this function should be called only from master
+  void force_release_resources_of_other_master() noexcept {
+    php_assert(is_initial_process());
+    control_block_->force_release_resources_of_other_master();
   }
 
   // this function should be called only from master
   T &get_current_resource() noexcept {
     php_assert(is_initial_process());
     php_assert(control_block_);
-    return switchable_resource_[(*control_block_)->get_active_resource_id()];
+    return switchable_resource_[control_block_->get_active_resource_id()];
   }
 
   // this function should be called only from master
   bool is_next_resource_unused(uint32_t *inactive_resource_id_out = nullptr) noexcept {
     php_assert(is_initial_process());
     php_assert(control_block_);
-    auto locked_block = control_block_->acquire_lock();
-    const uint32_t inactive_resource_id = locked_block->get_next_inactive_resource_id();
+    const uint32_t inactive_resource_id = control_block_->get_next_inactive_resource_id();
     if (inactive_resource_id_out) {
       *inactive_resource_id_out = inactive_resource_id;
     }
-    return locked_block->is_resource_unused(inactive_resource_id);
+    return control_block_->is_resource_unused(inactive_resource_id);
   }
 
   // this function should be called only from master
@@ -143,7 +201,7 @@ public:
     uint32_t inactive_resource_id = 0;
     if (is_next_resource_unused(&inactive_resource_id)) {
       switchable_resource_[inactive_resource_id].reset(std::forward<Args>(args)...);
-      const uint32_t prev_active = (*control_block_)->switch_active_to_next();
+      const uint32_t prev_active = control_block_->switch_active_to_next();
       // previous become dirty
       dirty_inactive_resources_.set(prev_active);
       // new become not dirty
@@ -162,12 +220,12 @@ public:
 
     // resources are cleared strictly in the order they were marked as unused: starting with the oldest, etc.
     // if the oldest can't be cleared, the cleanup is stopped
-    const uint32_t current_resource_id = (*control_block_)->get_active_resource_id();
+    const uint32_t current_resource_id = control_block_->get_active_resource_id();
     for (uint32_t resource_id = (current_resource_id + 1) % RESOURCE_AMOUNT;
          resource_id != current_resource_id && dirty_inactive_resources_.any();
          resource_id = (resource_id + 1) % RESOURCE_AMOUNT) {
       if (dirty_inactive_resources_.test(resource_id)) {
-        if ((*control_block_)->is_resource_unused(resource_id)) {
+        if (control_block_->is_resource_unused(resource_id)) {
           switchable_resource_[resource_id].clear();
           dirty_inactive_resources_.reset(resource_id);
         } else {
@@ -184,8 +242,10 @@ public:
   void destroy() noexcept {
     php_assert(control_block_);
     php_assert(is_initial_process());
-    control_block_->~lock_accessible();
-    munmap(control_block_, sizeof(*control_block_));
+    control_block_->~InterProcessResourceControl();
+    if (owns_control_block_memory_) {
+      munmap(control_block_, sizeof(*control_block_));
+    }
     control_block_ = nullptr;
 
     for (auto &resource: switchable_resource_) {
@@ -203,5 +263,6 @@ private:
   std::bitset<RESOURCE_AMOUNT> dirty_inactive_resources_;
   const pid_t initiate_process_pid_{0};
   std::array<T, RESOURCE_AMOUNT> switchable_resource_;
-  vk::lock_accessible<InterProcessResourceControl<RESOURCE_AMOUNT>, inter_process_mutex> *control_block_{nullptr};
+  ControlBlock *control_block_{nullptr};
+  bool owns_control_block_memory_{true};
 };
@@ -24,6 +24,7 @@
 #include "runtime/datetime.h"
 #include "runtime/exception.h"
 #include "runtime/files.h"
+#include "runtime/http_compression.h"
 #include "runtime/instance_cache.h"
 #include "runtime/kphp-backtrace.h"
 #include "runtime/math_functions.h"
@@ -63,6 +64,8 @@ static string_buffer oub[OB_MAX_BUFFERS];
 string_buffer *coub;
 static int http_need_gzip;
 
+extern int run_once;
+
 void f$ob_clean() {
   coub->clean();
 }
@@ -113,11 +116,17 @@ void f$ob_flush() {
     php_warning("ob_flush with no buffer opented");
     return;
   }
-  --ob_cur_buffer;
-  coub = &oub[ob_cur_buffer];
-  print(oub[ob_cur_buffer + 1]);
-  ++ob_cur_buffer;
-  coub = &oub[ob_cur_buffer];
+  string_buffer &parent = oub[ob_cur_buffer - 1];
+  if (parent.size() == 0 && !(run_once && ob_cur_buffer == 1)) {
+    // the usual case of a buffer flushed into an empty one: the memory is handed over instead of the data being copied
+    parent.swap(*coub);
+  } else {
+    --ob_cur_buffer;
+    coub = &oub[ob_cur_buffer];
+    print(oub[ob_cur_buffer + 1]);
+    ++ob_cur_buffer;
+    coub = &oub[ob_cur_buffer];
+  }
   f$ob_clean();
 }
 
@@ -220,7 +229,14 @@ static bool check_status_line(const char *str, int str_len) {
   return true;
 }
 
+static bool http_streamed;
+static bool http_streaming_unavailable;
+
 static void header(const char *str, int str_len, bool replace = true, int http_response_code = 0) {
+  if (http_streamed) {
+    php_warning("Cannot modify header information - headers already sent by flush()");
+    return;
+  }
   if (dl::query_num != header_last_query_num) {
     new(headers_storage) array<string>();
     header_last_query_num = dl::query_num;
@@ -408,12 +424,13 @@ static inline const char *http_get_error_msg_text(int *code) {
   return "Extension Code";
 }
 
+// content_length < 0 means that the body is streamed with the chunked transfer encoding
 static const string_buffer *get_headers(int content_length) {//can't use static_SB, returns pointer to static_SB_spare
   string date = f$gmdate(HTTP_DATE);
   static_SB_spare.clean() << "Date: " << date;
   header(static_SB_spare.c_str(), (int)static_SB_spare.size());
 
-  if (!is_head_query) {
+  if (!is_head_query && content_length >= 0) {
     static_SB_spare.clean() << "Content-Length: " << content_length;
     header(static_SB_spare.c_str(), (int)static_SB_spare.size());
   }
@@ -432,6 +449,10 @@ static const string_buffer *get_headers(int content_length) {//can't use static_
   for (array<string>::const_iterator p = arr->begin(); p != arr->end(); ++p) {
     static_SB_spare << p.get_value();
   }
+  if (content_length < 0) {
+    // not stored in the headers array: the response may still be sent with Content-Length if the client can't accept chunks
+    static_SB_spare << "Transfer-Encoding: chunked\r\n";
+  }
   static_SB_spare << "\r\n";
 
   return &static_SB_spare;
@@ -444,6 +465,26 @@ char shutdown_function_storage[MAX_SHUTDOWN_FUNCTIONS * sizeof(shutdown_function
 shutdown_function_type *shutdown_functions = reinterpret_cast<shutdown_function_type *>(shutdown_function_storage);
 static bool finished;
 static bool flushed;
+void f$flush() {
+  if (query_type != QUERY_TYPE_HTTP || is_head_query || flushed || http_streaming_unavailable || ob_cur_buffer != 0) {
+    return;
+  }
+  if (http_streamed && oub[0].size() == 0) {
+    return;
+  }
+
+  const string_buffer *headers = http_streamed ? nullptr : get_headers(-1);
+  if (!http_send_chunk(headers ? headers->buffer() : nullptr, headers ? static_cast<int>(headers->size()) : 0,
+                       oub[0].buffer(), static_cast<int>(oub[0].size()))) {
+    // HTTP/1.0 client or the connection is gone, the output stays buffered till the end of the script
+    http_streaming_unavailable = true;
+    return;
+  }
+  http_streamed = true;
+  oub[0].clean();
+}
+
+static void skip_unread_post_data();
 
 void f$fastcgi_finish_request(int64_t exit_code) {
   if (flushed) {
@@ -479,6 +520,13 @@ void f$fastcgi_finish_request(int64_t exit_code) {
       break;
     }
     case QUERY_TYPE_HTTP: {
+      // the next query of the connection follows the body
+      skip_unread_post_data();
+      if (http_streamed) {
+        // headers are already sent, the engine writes the rest as the last chunks
+        http_set_result("", 0, oub[first_not_empty_buffer].buffer(), oub[first_not_empty_buffer].size(), static_cast<int32_t>(exit_code));
+        break;
+      }
       const string_buffer *compressed;
       if (is_head_query) {
         oub[first_not_empty_buffer].clean();
@@ -492,6 +540,16 @@ void f$fastcgi_finish_request(int64_t exit_code) {
           compressed = zlib_encode(oub[first_not_empty_buffer].c_str(), oub[first_not_empty_buffer].size(), 6, ZLIB_COMPRESS);
         } else {
           compressed = &oub[first_not_empty_buffer];
+          // the engine compresses the response itself unless the script has chosen the encoding
+          const char *content_encoding = nullptr;
+          const bool has_content_encoding = dl::query_num == header_last_query_num && headers->has_key(string("content-encoding"));
+          if (!has_content_encoding) {
+            if (const string_buffer *engine_compressed = http_compress_response(compressed->buffer(), compressed->size(), http_need_gzip, &content_encoding)) {
+              static_SB_spare.clean() << "Content-Encoding: " << content_encoding;
+              header(static_SB_spare.c_str(), static_cast<int>(static_SB_spare.size()), true);
+              compressed = engine_compressed;
+            }
+          }
         }
       }
 
@@ -633,8 +691,6 @@ Optional<string> f$inet_pton(const string &address) {
   return string(buffer, size);
 }
 
-extern int run_once;
-
 void print(const char *s, size_t s_len) {
   if (run_once && ob_cur_buffer == 0) {
     dl::CriticalSectionGuard critical_section;
@@ -656,6 +712,10 @@ void print(const string_buffer &sb) {
   print(sb.buffer(), sb.size());
 }
 
+string_buffer *get_current_output_buffer() {
+  return run_once && ob_cur_buffer == 0 ? nullptr : coub;
+}
+
 void dbg_echo(const char *s, size_t s_len) {
   dl::CriticalSectionGuard critical_section;
   write(kstderr, s, s_len);
@@ -722,6 +782,42 @@ static long long uploaded_files_last_query_num = -1;
 static const int MAX_FILES = 100;
 
 static string raw_post_data;
+// the body which is not parsed by init_superglobals is copied to raw_post_data on the first read of php://input:
+// from the buffer of the engine, or right from the connection if the body is too big for the engine to buffer it
+static const char *unread_post;
+static int unread_post_len;
+
+static const string &get_raw_post_data() {
+  if (unread_post_len > 0) {
+    if (unread_post != nullptr) {
+      dl::enter_critical_section();//OK
+      raw_post_data.assign(unread_post, unread_post_len);
+      dl::leave_critical_section();
+    } else {
+      dl::enter_critical_section();//OK
+      raw_post_data = string(unread_post_len, false);
+      dl::leave_critical_section();
+
+      http_load_long_query(raw_post_data.buffer(), unread_post_len, unread_post_len);
+    }
+    unread_post = nullptr;
+    unread_post_len = 0;
+  }
+  return raw_post_data;
+}
+
+static void skip_unread_post_data() {
+  if (unread_post == nullptr) {
+    int loaded = 0;
+    while (loaded < unread_post_len) {
+      int to_load = min(PHP_BUF_LEN, unread_post_len - loaded);
+      http_load_long_query(php_buf, to_load, to_load);
+      loaded += to_load;
+    }
+  }
+  unread_post = nullptr;
+  unread_post_len = 0;
+}
 
 bool f$is_uploaded_file(const string &filename) {
   return (dl::query_num == uploaded_files_last_query_num && uploaded_files->get_value(filename) == 1);
@@ -1375,6 +1471,9 @@ static void init_superglobals(const char *uri, int uri_len, const char *get, int
         if (strstr(header_value.c_str(), "deflate") != nullptr) {
           http_need_gzip |= 2;
         }
+        if (strstr(header_value.c_str(), "zstd") != nullptr) {
+          http_need_gzip |= HTTP_ACCEPT_ENCODING_ZSTD;
+        }
       } else if (!strcmp(header_name.c_str(), "cookie")) {
         array<string> cookie = explode(';', header_value);
         for (int t = 0; t < (int)cookie.count(); t++) {
@@ -1434,11 +1533,14 @@ static void init_superglobals(const char *uri, int uri_len, const char *get, int
     v$_SERVER.set_value(string("SCRIPT_URI", 10), script_uri);
   }
 
+  unread_post = nullptr;
+  unread_post_len = 0;
   if (post_len > 0) {
-    bool is_parsed = (post != nullptr);
+    bool is_parsed = false;
 //    fprintf (stderr, "!!!%.*s!!!\n", post_len, post);
     if (strstr(content_type_lower.c_str(), "application/x-www-form-urlencoded")) {
       if (post != nullptr) {
+        is_parsed = true;
         dl::enter_critical_section();//OK
         raw_post_data.assign(post, post_len);
         dl::leave_critical_section();
@@ -1446,6 +1548,7 @@ static void init_superglobals(const char *uri, int uri_len, const char *get, int
         f$parse_str(raw_post_data, v$_POST);
       }
     } else if (strstr(content_type_lower.c_str(), "multipart/form-data")) {
+      is_parsed = (post != nullptr);
       const char *p = strstr(content_type_lower.c_str(), "boundary");
       if (p) {
         p += 8;
@@ -1462,21 +1565,12 @@ static void init_superglobals(const char *uri, int uri_len, const char *get, int
           is_parsed |= parse_multipart(post, post_len, string(p, static_cast<string::size_type>(end_p - p)));
         }
       }
-    } else {
-      if (post != nullptr) {
-        dl::enter_critical_section();//OK
-        raw_post_data.assign(post, post_len);
-        dl::leave_critical_section();
-      }
     }
 
     if (!is_parsed) {
-      int loaded = 0;
-      while (loaded < post_len) {
-        int to_load = min(PHP_BUF_LEN, post_len - loaded);
-        http_load_long_query(php_buf, to_load, to_load);
-        loaded += to_load;
-      }
+      // loaded by get_raw_post_data or skipped when the script finishes
+      unread_post = post;
+      unread_post_len = post_len;
     }
 
     v$_SERVER.set_value(string("CONTENT_TYPE", 12), content_type);
@@ -1669,6 +1763,10 @@ Optional<string> f$ini_get(const string &s) {
     return string();//TODO
   } else if (!strcmp(s.c_str(), "static-buffers-size")) {
     return f$strval(Long(static_buffer_length_limit));
+  } else if (!strcmp(s.c_str(), "memcache.hash_strategy")) {
+    return string("standard");  } else if (!strcmp(s.c_str(), "memcache.request_cache")) {
+    return string("0");  } else if (!strcmp(s.c_str(), "memcache.noreply")) {
+    return string("0");
   }
 
   php_warning("Unrecognized option %s in ini_get", s.c_str());
@@ -1957,7 +2055,7 @@ static Optional<string> php_file_get_contents(const string &url) {
   }
 
   if (eq2(url, INPUT)) {
-    return raw_post_data;
+    return get_raw_post_data();
   }
 
   if (eq2(url, STDIN)) {
@@ -2039,6 +2137,8 @@ static void reset_global_interface_vars() {
   hard_reset_var(v$d$PHP_SAPI);
 
   hard_reset_var(raw_post_data);
+  unread_post = nullptr;
+  unread_post_len = 0;
 
   dl::leave_critical_section();
 }
@@ -2062,6 +2162,8 @@ static void init_runtime_libs() {
   shutdown_functions_count = 0;
   finished = false;
   flushed = false;
+  http_streamed = false;
+  http_streaming_unavailable = false;
 
   php_warning_level = std::max(2, php_warning_minimum_level);
   php_disable_warnings = 0;
@@ -2075,7 +2177,7 @@ static void init_runtime_libs() {
   ob_cur_buffer = -1;
   f$ob_start();
 
-  setlocale(LC_CTYPE, "ru_RU.CP1251");
+  reset_ctype_locale();
 
   //TODO
   header("HTTP/1.0 200 OK", 15);
@@ -2133,15 +2235,16 @@ void global_init_runtime_libs() {
   global_init_resumable_lib();
   global_init_rpc_lib();
   global_init_udp_lib();
+  global_init_curl_lib();
 }
 
 void global_init_script_allocator() {
   dl::global_init_script_allocator();
 }
 
-void init_runtime_environment(php_query_data *data, void *mem, size_t mem_size) {
+void init_runtime_environment(php_query_data *data, void *mem, size_t mem_size, size_t mem_growth_step) {
   dl::init_critical_section();
-  dl::init_script_allocator(mem, mem_size);
+  dl::init_script_allocator(mem, mem_size, mem_growth_step);
   reset_global_interface_vars();
   init_runtime_libs();
   init_superglobals(data);
@@ -27,6 +27,8 @@ void f$ob_start(const string &callback = string());
 
 void f$ob_flush();
 
+void f$flush();
+
 bool f$ob_end_flush();
 
 Optional<string> f$ob_get_flush();
@@ -78,6 +80,9 @@ void print(const string &s);
 
 void print(const string_buffer &sb);
 
+// returns the buffer that print() appends to, or nullptr if the output is written right into stdout
+string_buffer *get_current_output_buffer();
+
 void dbg_echo(const char *s, size_t s_len);
 
 void dbg_echo(const char *s);
@@ -162,7 +167,7 @@ Optional<array<mixed>> f$getopt(const string &options, array<string> longopts =
 void global_init_runtime_libs();
 void global_init_script_allocator();
 
-void init_runtime_environment(php_query_data *data, void *mem, size_t mem_size);
+void init_runtime_environment(php_query_data *data, void *mem, size_t mem_size, size_t mem_growth_step = 0);
 
 void free_runtime_environment();
 
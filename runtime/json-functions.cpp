@@ -0,0 +1,740 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/json-functions.h"
+
+#include <algorithm>
+
+#include "common/string-kernels.h"
+
+#include "runtime/exception.h"
+#include "runtime/string_functions.h"
+
+namespace impl_ {
+
+JsonEncoder::JsonEncoder(string_buffer &sb, int64_t options, bool simple_encode) noexcept:
+  sb_(sb),
+  options_(options),
+  simple_encode_(simple_encode) {
+}
+
+void JsonEncoder::append_one_char(unsigned int c) noexcept {
+  sb_.append_char('\\');
+  sb_.append_char('u');
+  sb_.append_char("0123456789abcdef"[c >> 12]);
+  sb_.append_char("0123456789abcdef"[(c >> 8) & 15]);
+  sb_.append_char("0123456789abcdef"[(c >> 4) & 15]);
+  sb_.append_char("0123456789abcdef"[c & 15]);
+}
+
+bool JsonEncoder::append_char(unsigned int c) noexcept {
+  if (c < 0x10000) {
+    if (0xD7FF < c && c < 0xE000) {
+      return false;
+    }
+    append_one_char(c);
+    return true;
+  } else if (c <= 0x10ffff) {
+    c -= 0x10000;
+    append_one_char(0xD800 | (c >> 10));
+    append_one_char(0xDC00 | (c & 0x3FF));
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool JsonEncoder::encode_string_php(const char *s, int len) noexcept {
+  const string::size_type begin_pos = sb_.size();
+  if (options_ & JSON_UNESCAPED_UNICODE) {
+    sb_.reserve(2 * len + 2);
+  } else {
+    sb_.reserve(6 * len + 2);
+  }
+  sb_.append_char('"');
+
+#define ERROR {sb_.set_pos (begin_pos); sb_.append ("null", 4); return false;}
+#define CHECK(x) if (!(x)) {php_warning ("Not a valid utf-8 character at pos %d in function json_encode", pos); ERROR}
+#define APPEND_CHAR(x) CHECK(append_char(x))
+
+  int a, b, c, d;
+  for (int pos = 0; pos < len; pos++) {
+    switch (s[pos]) {
+      case '"':
+        sb_.append_char('\\');
+        sb_.append_char('"');
+        break;
+      case '\\':
+        sb_.append_char('\\');
+        sb_.append_char('\\');
+        break;
+      case '/':
+        sb_.append_char('\\');
+        sb_.append_char('/');
+        break;
+      case '\b':
+        sb_.append_char('\\');
+        sb_.append_char('b');
+        break;
+      case '\f':
+        sb_.append_char('\\');
+        sb_.append_char('f');
+        break;
+      case '\n':
+        sb_.append_char('\\');
+        sb_.append_char('n');
+        break;
+      case '\r':
+        sb_.append_char('\\');
+        sb_.append_char('r');
+        break;
+      case '\t':
+        sb_.append_char('\\');
+        sb_.append_char('t');
+        break;
+      case 0 ... 7:
+      case 11:
+      case 14 ... 31:
+        append_one_char(s[pos]);
+        break;
+      case -128 ... -1:
+        a = s[pos];
+        CHECK ((a & 0x40) != 0);
+
+        b = s[++pos];
+        CHECK((b & 0xc0) == 0x80);
+        if ((a & 0x20) == 0) {
+          CHECK((a & 0x1e) > 0);
+          if (options_ & JSON_UNESCAPED_UNICODE) {
+            sb_.append_char(static_cast<char>(a));
+            sb_.append_char(static_cast<char>(b));
+          } else {
+            APPEND_CHAR(((a & 0x1f) << 6) | (b & 0x3f));
+          }
+          break;
+        }
+
+        c = s[++pos];
+        CHECK((c & 0xc0) == 0x80);
+        if ((a & 0x10) == 0) {
+          CHECK(((a & 0x0f) | (b & 0x20)) > 0);
+          if (options_ & JSON_UNESCAPED_UNICODE) {
+            sb_.append_char(static_cast<char>(a));
+            sb_.append_char(static_cast<char>(b));
+            sb_.append_char(static_cast<char>(c));
+          } else {
+            APPEND_CHAR(((a & 0x0f) << 12) | ((b & 0x3f) << 6) | (c & 0x3f));
+          }
+          break;
+        }
+
+        d = s[++pos];
+        CHECK((d & 0xc0) == 0x80);
+        if ((a & 0x08) == 0) {
+          CHECK(((a & 0x07) | (b & 0x30)) > 0);
+          if (options_ & JSON_UNESCAPED_UNICODE) {
+            sb_.append_char(static_cast<char>(a));
+            sb_.append_char(static_cast<char>(b));
+            sb_.append_char(static_cast<char>(c));
+            sb_.append_char(static_cast<char>(d));
+          } else {
+            APPEND_CHAR(((a & 0x07) << 18) | ((b & 0x3f) << 12) | ((c & 0x3f) << 6) | (d & 0x3f));
+          }
+          break;
+        }
+
+        CHECK(0);
+        break;
+      default:
+        sb_.append_char(s[pos]);
+        break;
+    }
+  }
+
+  sb_.append_char('"');
+  return true;
+#undef ERROR
+#undef CHECK
+#undef APPEND_CHAR
+}
+
+bool JsonEncoder::encode_string_vkext(const char *s, int len) noexcept {
+  sb_.reserve(2 * len + 2);
+  if (string_buffer::string_buffer_error_flag == STRING_BUFFER_ERROR_FLAG_FAILED) {
+    return false;
+  }
+
+  sb_.append_char('"');
+
+  for (int pos = 0; pos < len; pos++) {
+    const int unescaped_len = static_cast<int>(json_unescaped_prefix_length(s + pos, len - pos));
+    sb_.append_unsafe(s + pos, unescaped_len);
+    pos += unescaped_len;
+    if (pos == len) {
+      break;
+    }
+    char c = s[pos];
+    if (unlikely ((unsigned int)c < 32u)) {
+      switch (c) {
+        case '\b':
+          sb_.append_char('\\');
+          sb_.append_char('b');
+          break;
+        case '\f':
+          sb_.append_char('\\');
+          sb_.append_char('f');
+          break;
+        case '\n':
+          sb_.append_char('\\');
+          sb_.append_char('n');
+          break;
+        case '\r':
+          sb_.append_char('\\');
+          sb_.append_char('r');
+          break;
+        case '\t':
+          sb_.append_char('\\');
+          sb_.append_char('t');
+          break;
+      }
+    } else {
+      if (c == '"' || c == '\\' || c == '/') {
+        sb_.append_char('\\');
+      }
+      sb_.append_char(c);
+    }
+  }
+
+  sb_.append_char('"');
+
+  return true;
+}
+
+bool JsonEncoder::encode(bool b) noexcept {
+  if (b) {
+    sb_.append("true", 4);
+  } else {
+    sb_.append("false", 5);
+  }
+  return true;
+}
+
+bool JsonEncoder::encode(int64_t i) noexcept {
+  sb_ << i;
+  return true;
+}
+
+bool JsonEncoder::encode(double d) noexcept {
+  if (is_ok_float(d)) {
+    sb_ << (simple_encode_ ? f$number_format(d, 6, DOT, string()) : string(d));
+  } else {
+    php_warning("strange double %lf in function json_encode", d);
+    if (options_ & JSON_PARTIAL_OUTPUT_ON_ERROR) {
+      sb_.append("0", 1);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool JsonEncoder::encode(const string &s) noexcept {
+  return simple_encode_ ? encode_string_vkext(s.c_str(), s.size()) : encode_string_php(s.c_str(), s.size());
+}
+
+bool JsonEncoder::encode(const mixed &v) noexcept {
+  switch (v.get_type()) {
+    case mixed::type::NUL:
+      sb_.append("null", 4);
+      return true;
+    case mixed::type::BOOLEAN:
+      return encode(v.as_bool());
+    case mixed::type::INTEGER:
+      return encode(v.as_int());
+    case mixed::type::FLOAT:
+      return encode(v.as_double());
+    case mixed::type::STRING:
+      return encode(v.as_string());
+    case mixed::type::ARRAY:
+      return encode(v.as_array());
+    default:
+      __builtin_unreachable();
+  }
+}
+
+bool check_json_encode_options(int64_t options) noexcept {
+  const bool has_unsupported_option = static_cast<bool>(options & ~JSON_AVAILABLE_OPTIONS);
+  if (has_unsupported_option) {
+    php_warning("Wrong parameter options = %ld in function json_encode", options);
+    return false;
+  }
+  return true;
+}
+
+} // namespace impl_
+
+string f$vk_json_encode_safe(const mixed &v, bool simple_encode) {
+  static_SB.clean();
+  string_buffer::string_buffer_error_flag = STRING_BUFFER_ERROR_FLAG_ON;
+  impl_::JsonEncoder(static_SB, 0, simple_encode).encode(v);
+  if (string_buffer::string_buffer_error_flag == STRING_BUFFER_ERROR_FLAG_FAILED) {
+    static_SB.clean();
+    string_buffer::string_buffer_error_flag = STRING_BUFFER_ERROR_FLAG_OFF;
+    THROW_EXCEPTION (new_Exception(string(__FILE__), __LINE__, string("json_encode buffer overflow", 27)));
+    return string();
+  }
+  string_buffer::string_buffer_error_flag = STRING_BUFFER_ERROR_FLAG_OFF;
+  return static_SB.str();
+}
+
+static void json_skip_blanks(const char *s, int &i) {
+  while (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n') {
+    i++;
+  }
+}
+
+static bool do_json_decode(const char *s, int s_len, int &i, mixed &v) {
+  if (!v.is_null()) {
+    v.destroy();
+  }
+  json_skip_blanks(s, i);
+  switch (s[i]) {
+    case 'n':
+      if (s[i + 1] == 'u' &&
+          s[i + 2] == 'l' &&
+          s[i + 3] == 'l') {
+        i += 4;
+        return true;
+      }
+      break;
+    case 't':
+      if (s[i + 1] == 'r' &&
+          s[i + 2] == 'u' &&
+          s[i + 3] == 'e') {
+        i += 4;
+        new(&v) mixed(true);
+        return true;
+      }
+      break;
+    case 'f':
+      if (s[i + 1] == 'a' &&
+          s[i + 2] == 'l' &&
+          s[i + 3] == 's' &&
+          s[i + 4] == 'e') {
+        i += 5;
+        new(&v) mixed(false);
+        return true;
+      }
+      break;
+    case '"': {
+      int j = i + 1;
+      int slashes = 0;
+      while (j < s_len && s[j] != '"') {
+        if (s[j] == '\\') {
+          slashes++;
+          j++;
+        }
+        j++;
+      }
+      if (j < s_len) {
+        int len = j - i - 1 - slashes;
+
+        string value(len, false);
+
+        i++;
+        int l;
+        for (l = 0; l < len && i < j; l++) {
+          char c = s[i];
+          if (c == '\\') {
+            i++;
+            switch (s[i]) {
+              case '"':
+              case '\\':
+              case '/':
+                value[l] = s[i];
+                break;
+              case 'b':
+                value[l] = '\b';
+                break;
+              case 'f':
+                value[l] = '\f';
+                break;
+              case 'n':
+                value[l] = '\n';
+                break;
+              case 'r':
+                value[l] = '\r';
+                break;
+              case 't':
+                value[l] = '\t';
+                break;
+              case 'u':
+                if (isxdigit(s[i + 1]) && isxdigit(s[i + 2]) && isxdigit(s[i + 3]) && isxdigit(s[i + 4])) {
+                  int num = 0;
+                  for (int t = 0; t < 4; t++) {
+                    char c = s[++i];
+                    if ('0' <= c && c <= '9') {
+                      num = num * 16 + c - '0';
+                    } else {
+                      c |= 0x20;
+                      if ('a' <= c && c <= 'f') {
+                        num = num * 16 + c - 'a' + 10;
+                      }
+                    }
+                  }
+
+                  if (0xD7FF < num && num < 0xE000) {
+                    if (s[i + 1] == '\\' && s[i + 2] == 'u' &&
+                        isxdigit(s[i + 3]) && isxdigit(s[i + 4]) && isxdigit(s[i + 5]) && isxdigit(s[i + 6])) {
+                      i += 2;
+                      int u = 0;
+                      for (int t = 0; t < 4; t++) {
+                        char c = s[++i];
+                        if ('0' <= c && c <= '9') {
+                          u = u * 16 + c - '0';
+                        } else {
+                          c |= 0x20;
+                          if ('a' <= c && c <= 'f') {
+                            u = u * 16 + c - 'a' + 10;
+                          }
+                        }
+                      }
+
+                      if (0xD7FF < u && u < 0xE000) {
+                        num = (((num & 0x3FF) << 10) | (u & 0x3FF)) + 0x10000;
+                      } else {
+                        i -= 6;
+                        return false;
+                      }
+                    } else {
+                      return false;
+                    }
+                  }
+
+                  if (num < 128) {
+                    value[l] = (char)num;
+                  } else if (num < 0x800) {
+                    value[l++] = (char)(0xc0 + (num >> 6));
+                    value[l] = (char)(0x80 + (num & 63));
+                  } else if (num < 0xffff) {
+                    value[l++] = (char)(0xe0 + (num >> 12));
+                    value[l++] = (char)(0x80 + ((num >> 6) & 63));
+                    value[l] = (char)(0x80 + (num & 63));
+                  } else {
+                    value[l++] = (char)(0xf0 + (num >> 18));
+                    value[l++] = (char)(0x80 + ((num >> 12) & 63));
+                    value[l++] = (char)(0x80 + ((num >> 6) & 63));
+                    value[l] = (char)(0x80 + (num & 63));
+                  }
+                  break;
+                }
+                /* fallthrough */
+              default:
+                return false;
+            }
+            i++;
+          } else {
+            value[l] = s[i++];
+          }
+        }
+        value.shrink(l);
+
+        new(&v) mixed(value);
+        i++;
+        return true;
+      }
+      break;
+    }
+    case '[': {
+      array<mixed> res;
+      i++;
+      json_skip_blanks(s, i);
+      if (s[i] != ']') {
+        do {
+          mixed value;
+          if (!do_json_decode(s, s_len, i, value)) {
+            return false;
+          }
+          res.push_back(value);
+          json_skip_blanks(s, i);
+        } while (s[i++] == ',');
+
+        if (s[i - 1] != ']') {
+          return false;
+        }
+      } else {
+        i++;
+      }
+
+      new(&v) mixed(res);
+      return true;
+    }
+    case '{': {
+      array<mixed> res;
+      i++;
+      json_skip_blanks(s, i);
+      if (s[i] != '}') {
+        do {
+          mixed key;
+          if (!do_json_decode(s, s_len, i, key) || !key.is_string()) {
+            return false;
+          }
+          json_skip_blanks(s, i);
+          if (s[i++] != ':') {
+            return false;
+          }
+
+          if (!do_json_decode(s, s_len, i, res[key])) {
+            return false;
+          }
+          json_skip_blanks(s, i);
+        } while (s[i++] == ',');
+
+        if (s[i - 1] != '}') {
+          return false;
+        }
+      } else {
+        i++;
+      }
+
+      new(&v) mixed(res);
+      return true;
+    }
+    default: {
+      int j = i;
+      while (s[j] == '-' || ('0' <= s[j] && s[j] <= '9') || s[j] == 'e' || s[j] == 'E' || s[j] == '+' || s[j] == '.') {
+        j++;
+      }
+      if (j > i) {
+        int64_t intval = 0;
+        if (php_try_to_int(s + i, j - i, &intval)) {
+          i = j;
+          new(&v) mixed(intval);
+          return true;
+        }
+
+        char *end_ptr;
+        double floatval = php_strtod(s + i, s + j, &end_ptr);
+        if (end_ptr == s + j) {
+          i = j;
+          new(&v) mixed(floatval);
+          return true;
+        }
+      }
+      break;
+    }
+  }
+
+  return false;
+}
+
+mixed f$json_decode(const string &v, bool assoc) {
+  if (!assoc) {
+//    php_warning ("json_decode doesn't support decoding to class, returning array");
+  }
+
+  mixed result;
+  int i = 0;
+  if (do_json_decode(v.c_str(), v.size(), i, result)) {
+    json_skip_blanks(v.c_str(), i);
+    if (i == (int)v.size()) {
+      return result;
+    }
+  }
+
+  return mixed();
+}
+
+namespace impl_ {
+
+JsonTypedDecoder::JsonTypedDecoder(const string &json, const uint32_t *positions, size_t positions_count) noexcept:
+  json_(json),
+  positions_(positions),
+  tokens_count_(positions_count) {}
+
+// scalars are parsed by do_json_decode(), it must stop right before the next token
+bool JsonTypedDecoder::decode_scalar(mixed &v) noexcept {
+  if (token_ == tokens_count_) {
+    return false;
+  }
+  int i = static_cast<int>(positions_[token_]);
+  if (!do_json_decode(json_.c_str(), json_.size(), i, v)) {
+    return false;
+  }
+  json_skip_blanks(json_.c_str(), i);
+  ++token_;
+  if (static_cast<size_t>(i) != current_position()) {
+    --token_;
+    return false;
+  }
+  return true;
+}
+
+bool JsonTypedDecoder::next_is_null() noexcept {
+  if (!at('n')) {
+    return false;
+  }
+  mixed v;
+  return decode_scalar(v);
+}
+
+bool JsonTypedDecoder::decode(bool &b) noexcept {
+  mixed v;
+  if (!decode_scalar(v) || !v.is_bool()) {
+    return false;
+  }
+  b = v.as_bool();
+  return true;
+}
+
+bool JsonTypedDecoder::decode(int64_t &i) noexcept {
+  mixed v;
+  if (at('"') || !decode_scalar(v) || !v.is_int()) {
+    return false;
+  }
+  i = v.as_int();
+  return true;
+}
+
+bool JsonTypedDecoder::decode(double &d) noexcept {
+  mixed v;
+  if (at('"') || !decode_scalar(v) || !(v.is_int() || v.is_float())) {
+    return false;
+  }
+  d = v.to_float();
+  return true;
+}
+
+bool JsonTypedDecoder::decode(string &s) noexcept {
+  mixed v;
+  if (!at('"') || !decode_scalar(v)) {
+    return false;
+  }
+  s = std::move(v.as_string());
+  return true;
+}
+
+bool JsonTypedDecoder::decode(mixed &v) noexcept {
+  if (token_ == tokens_count_) {
+    return false;
+  }
+  if (!at('[') && !at('{')) {
+    return decode_scalar(v);
+  }
+  int i = static_cast<int>(positions_[token_]);
+  if (!do_json_decode(json_.c_str(), json_.size(), i, v)) {
+    return false;
+  }
+  // a nested array or object spans many tokens, resync with the first one after it
+  const uint32_t *next = std::lower_bound(positions_ + token_ + 1, positions_ + tokens_count_, static_cast<uint32_t>(i));
+  token_ = next - positions_;
+  json_skip_blanks(json_.c_str(), i);
+  return static_cast<size_t>(i) == current_position();
+}
+
+bool JsonTypedDecoder::read_member_key(Member &member) noexcept {
+  if (!at('"')) {
+    return false;
+  }
+  const char *begin = json_.c_str() + positions_[token_] + 1;
+  const char *end = json_.c_str() + json_.size();
+  const char *quote = static_cast<const char *>(memchr(begin, '"', end - begin));
+  if (quote == nullptr) {
+    return false;
+  }
+  if (memchr(begin, '\\', quote - begin) == nullptr) {
+    member.key = vk::string_view{begin, static_cast<size_t>(quote - begin)};
+    return skip_string();
+  }
+
+  mixed key;
+  if (!decode_scalar(key)) {
+    return false;
+  }
+  member.decoded_key = std::move(key.as_string());
+  member.key = vk::string_view{member.decoded_key.c_str(), member.decoded_key.size()};
+  return true;
+}
+
+bool JsonTypedDecoder::collect_object_members() noexcept {
+  if (!next_is('{')) {
+    return false;
+  }
+  if (next_is('}')) {
+    return true;
+  }
+  do {
+    Member member;
+    if (!read_member_key(member) || !next_is(':')) {
+      return false;
+    }
+    member.value_token = token_;
+    if (!skip_value()) {
+      return false;
+    }
+    members_.emplace_back(std::move(member));
+  } while (next_is(','));
+  return next_is('}');
+}
+
+// the string itself is not unescaped, only its closing quote is checked
+bool JsonTypedDecoder::skip_string() noexcept {
+  const size_t begin = positions_[token_];
+  ++token_;
+  size_t end = current_position();
+  while (end > begin + 1 && (json_[end - 1] == ' ' || json_[end - 1] == '\t' || json_[end - 1] == '\n' || json_[end - 1] == '\r')) {
+    --end;
+  }
+  if (end <= begin + 1 || json_[end - 1] != '"') {
+    return false;
+  }
+  size_t slashes = 0;
+  while (json_[end - 2 - slashes] == '\\') {
+    ++slashes;
+  }
+  return slashes % 2 == 0;
+}
+
+bool JsonTypedDecoder::skip_value() noexcept {
+  if (token_ == tokens_count_) {
+    return false;
+  }
+  switch (json_[positions_[token_]]) {
+    case '"':
+      return skip_string();
+    case '[':
+      ++token_;
+      if (next_is(']')) {
+        return true;
+      }
+      do {
+        if (!skip_value()) {
+          return false;
+        }
+      } while (next_is(','));
+      return next_is(']');
+    case '{':
+      ++token_;
+      if (next_is('}')) {
+        return true;
+      }
+      do {
+        if (!at('"') || !skip_string() || !next_is(':') || !skip_value()) {
+          return false;
+        }
+      } while (next_is(','));
+      return next_is('}');
+    case ']':
+    case '}':
+    case ':':
+    case ',':
+      return false;
+    default: {
+      mixed v;
+      return decode_scalar(v);
+    }
+  }
+}
+
+} // namespace impl_
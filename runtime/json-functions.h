@@ -0,0 +1,381 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+#include "common/string-kernels.h"
+#include "common/wrappers/string_view.h"
+
+#include "runtime/allocator.h"
+#include "runtime/interface.h"
+#include "runtime/kphp_core.h"
+
+constexpr int64_t JSON_UNESCAPED_UNICODE = 1;
+constexpr int64_t JSON_FORCE_OBJECT = 16;
+constexpr int64_t JSON_PARTIAL_OUTPUT_ON_ERROR = 512;
+constexpr int64_t JSON_AVAILABLE_OPTIONS = JSON_UNESCAPED_UNICODE | JSON_FORCE_OBJECT | JSON_PARTIAL_OUTPUT_ON_ERROR;
+
+namespace impl_ {
+
+// writes json straight into the given buffer;
+// typed values are encoded as they are, without converting them into mixed first
+class JsonEncoder : vk::not_copyable {
+public:
+  JsonEncoder(string_buffer &sb, int64_t options, bool simple_encode) noexcept;
+
+  bool encode(bool b) noexcept;
+  bool encode(int64_t i) noexcept;
+  bool encode(double d) noexcept;
+  bool encode(const string &s) noexcept;
+  bool encode(const mixed &v) noexcept;
+
+  template<class T>
+  bool encode(const array<T> &arr) noexcept;
+
+  template<class T>
+  bool encode(const Optional<T> &opt) noexcept;
+
+  // the rest of types are encoded as mixed
+  template<class T>
+  bool encode(const T &v) noexcept {
+    return encode(mixed{v});
+  }
+
+private:
+  bool encode_string_php(const char *s, int len) noexcept;
+  bool encode_string_vkext(const char *s, int len) noexcept;
+  void append_one_char(unsigned int c) noexcept;
+  bool append_char(unsigned int c) noexcept;
+
+  string_buffer &sb_;
+  const int64_t options_{0};
+  const bool simple_encode_{false};
+};
+
+template<class T>
+bool JsonEncoder::encode(const array<T> &arr) noexcept {
+  bool is_vector = arr.is_vector();
+  if (!is_vector && !(options_ & JSON_FORCE_OBJECT) && arr.size().string_size == 0) {
+    int64_t n = 0;
+    for (auto p = arr.begin(); p != arr.end(); ++p) {
+      if (p.get_key().to_int() != n) {
+        break;
+      }
+      n++;
+    }
+    if (n == arr.count()) {
+      if (arr.get_next_key() == arr.count()) {
+        is_vector = true;
+      } else {
+        php_warning("Corner case in json conversion, [] could be easy transformed to {}");
+      }
+    }
+  }
+  is_vector &= !(options_ & JSON_FORCE_OBJECT);
+
+  sb_ << "{["[is_vector];
+
+  for (auto p = arr.begin(); p != arr.end(); ++p) {
+    if (p != arr.begin()) {
+      sb_ << ',';
+    }
+
+    if (!is_vector) {
+      const auto key = p.get_key();
+      if (array<T>::is_int_key(key)) {
+        sb_ << '"' << key.to_int() << '"';
+      } else {
+        if (!encode(key)) {
+          if (!(options_ & JSON_PARTIAL_OUTPUT_ON_ERROR)) {
+            return false;
+          }
+        }
+      }
+      sb_ << ':';
+    }
+
+    if (!encode(p.get_value())) {
+      if (!(options_ & JSON_PARTIAL_OUTPUT_ON_ERROR)) {
+        return false;
+      }
+    }
+  }
+
+  sb_ << "}]"[is_vector];
+  return true;
+}
+
+template<class T>
+bool JsonEncoder::encode(const Optional<T> &opt) noexcept {
+  switch (opt.value_state()) {
+    case OptionalState::has_value:
+      return encode(opt.val());
+    case OptionalState::false_value:
+      return encode(false);
+    case OptionalState::null_value:
+      sb_.append("null", 4);
+      return true;
+  }
+  __builtin_unreachable();
+}
+
+bool check_json_encode_options(int64_t options) noexcept;
+
+} // namespace impl_
+
+template<class T>
+Optional<string> f$json_encode(const T &v, int64_t options = 0, bool simple_encode = false) {
+  if (!impl_::check_json_encode_options(options)) {
+    return false;
+  }
+
+  static_SB.clean();
+  if (!impl_::JsonEncoder(static_SB, options, simple_encode).encode(v)) {
+    return false;
+  }
+  return static_SB.str();
+}
+
+// 'echo json_encode(...)' is replaced with this function by the compiler:
+// json is written right into the output buffer without creating an intermediate string
+template<class T>
+void f$echo_json_encode(const T &v, int64_t options = 0) {
+  if (!impl_::check_json_encode_options(options)) {
+    return;
+  }
+
+  string_buffer *out = get_current_output_buffer();
+  if (out == nullptr) {
+    const Optional<string> json = f$json_encode(v, options);
+    if (json.has_value()) {
+      print(json.val());
+    }
+    return;
+  }
+
+  const string::size_type begin_pos = out->size();
+  if (!impl_::JsonEncoder(*out, options, false).encode(v)) {
+    out->set_pos(begin_pos);
+  }
+}
+
+string f$vk_json_encode_safe(const mixed &v, bool simple_encode = true);
+
+mixed f$json_decode(const string &v, bool assoc = false);
+
+namespace impl_ {
+
+// decodes json straight into typed values, walking over the tokens found by json_find_tokens();
+// members of objects are looked up by the fields of classes, values of the rest members are only validated
+class JsonTypedDecoder : vk::not_copyable {
+public:
+  JsonTypedDecoder(const string &json, const uint32_t *positions, size_t positions_count) noexcept;
+
+  bool decode(bool &b) noexcept;
+  bool decode(int64_t &i) noexcept;
+  bool decode(double &d) noexcept;
+  bool decode(string &s) noexcept;
+  bool decode(mixed &v) noexcept;
+
+  template<class T>
+  bool decode(array<T> &arr) noexcept;
+
+  template<class T>
+  bool decode(Optional<T> &opt) noexcept;
+
+  template<class T>
+  bool decode(class_instance<T> &instance) noexcept;
+
+  // tuples, shapes and the rest of types can't be decoded
+  template<class T>
+  bool decode(T &) noexcept {
+    php_warning("json_decode_to: can't decode a value into a field of unsupported type");
+    return false;
+  }
+
+  template<class T>
+  bool decode_member(vk::string_view field_name, size_t members_begin, T &value) noexcept;
+
+  bool finished() const noexcept {
+    return token_ == tokens_count_;
+  }
+
+  size_t failed_offset() const noexcept {
+    return current_position();
+  }
+
+private:
+  struct Member {
+    vk::string_view key;
+    // set only for keys with escape sequences
+    string decoded_key;
+    size_t value_token;
+  };
+
+  size_t current_position() const noexcept {
+    return token_ < tokens_count_ ? positions_[token_] : json_.size();
+  }
+
+  bool at(char c) const noexcept {
+    return token_ < tokens_count_ && json_[positions_[token_]] == c;
+  }
+
+  bool next_is(char c) noexcept {
+    if (at(c)) {
+      ++token_;
+      return true;
+    }
+    return false;
+  }
+
+  bool next_is_null() noexcept;
+  bool decode_scalar(mixed &v) noexcept;
+  bool read_member_key(Member &member) noexcept;
+  bool collect_object_members() noexcept;
+  bool skip_string() noexcept;
+  bool skip_value() noexcept;
+
+  const string &json_;
+  const uint32_t *positions_{nullptr};
+  const size_t tokens_count_{0};
+  size_t token_{0};
+  std::vector<Member> members_;
+};
+
+} // namespace impl_
+
+// the generated classes accept it, it assigns fields from the members of a json object being decoded
+class JsonDecodeVisitor : vk::not_copyable {
+public:
+  JsonDecodeVisitor(impl_::JsonTypedDecoder &decoder, size_t members_begin) noexcept:
+    decoder_(decoder),
+    members_begin_(members_begin) {}
+
+  template<class T>
+  void operator()(const char *field_name, T &value) noexcept {
+    is_ok_ = is_ok_ && decoder_.decode_member(vk::string_view{field_name}, members_begin_, value);
+  }
+
+  bool is_ok() const noexcept {
+    return is_ok_;
+  }
+
+private:
+  impl_::JsonTypedDecoder &decoder_;
+  const size_t members_begin_{0};
+  bool is_ok_{true};
+};
+
+namespace impl_ {
+
+template<class T>
+bool JsonTypedDecoder::decode(array<T> &arr) noexcept {
+  arr = array<T>();
+  if (next_is('[')) {
+    if (next_is(']')) {
+      return true;
+    }
+    do {
+      T value;
+      if (!decode(value)) {
+        return false;
+      }
+      arr.push_back(std::move(value));
+    } while (next_is(','));
+    return next_is(']');
+  }
+
+  if (!next_is('{')) {
+    return false;
+  }
+  if (next_is('}')) {
+    return true;
+  }
+  do {
+    mixed key;
+    // numeric keys are converted to ints the same way as in json_decode()
+    if (!at('"') || !decode_scalar(key) || !next_is(':') || !decode(arr[key])) {
+      return false;
+    }
+  } while (next_is(','));
+  return next_is('}');
+}
+
+template<class T>
+bool JsonTypedDecoder::decode(Optional<T> &opt) noexcept {
+  if (next_is_null()) {
+    opt = Optional<T>{};
+    return true;
+  }
+  T value;
+  if (!decode(value)) {
+    return false;
+  }
+  opt = std::move(value);
+  return true;
+}
+
+template<class T>
+bool JsonTypedDecoder::decode(class_instance<T> &instance) noexcept {
+  if (next_is_null()) {
+    instance = class_instance<T>{};
+    return true;
+  }
+
+  const size_t members_begin = members_.size();
+  if (!collect_object_members()) {
+    return false;
+  }
+  const size_t object_end = token_;
+
+  instance.alloc();
+  JsonDecodeVisitor visitor{*this, members_begin};
+  instance.get()->accept(visitor);
+
+  members_.erase(members_.begin() + members_begin, members_.end());
+  if (!visitor.is_ok()) {
+    return false;
+  }
+  token_ = object_end;
+  return true;
+}
+
+template<class T>
+bool JsonTypedDecoder::decode_member(vk::string_view field_name, size_t members_begin, T &value) noexcept {
+  // the last one of duplicated keys wins, as in json_decode()
+  for (size_t i = members_.size(); i > members_begin; --i) {
+    if (members_[i - 1].key == field_name) {
+      token_ = members_[i - 1].value_token;
+      return decode(value);
+    }
+  }
+  // fields that are absent in json keep their default values
+  return true;
+}
+
+} // namespace impl_
+
+// decodes a json object into a new instance of ResultClass, fields are matched with json members by names;
+// returns null if json is malformed or values don't match the types of fields
+template<class ResultClass>
+ResultClass f$json_decode_to(const string &json, const string &class_name) noexcept {
+  ResultClass result;
+  size_t failed_offset = 0;
+  {
+    const auto malloc_replacement_guard = make_malloc_replacement_with_script_allocator();
+    std::unique_ptr<uint32_t[]> positions{new uint32_t[json.size()]};
+    const size_t tokens_count = json_find_tokens(json.c_str(), json.size(), positions.get());
+    impl_::JsonTypedDecoder decoder{json, positions.get(), tokens_count};
+    if (decoder.decode(result) && decoder.finished()) {
+      return result;
+    }
+    failed_offset = decoder.failed_offset();
+  }
+  php_warning("json_decode_to: can't decode json into %s near offset %zu", class_name.c_str(), failed_offset);
+  return {};
+}
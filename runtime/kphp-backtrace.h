@@ -8,6 +8,7 @@
 #include <forward_list>
 
 #include "common/wrappers/iterator_range.h"
+#include "common/wrappers/string_view.h"
 
 #include "runtime/kphp_core.h"
 
@@ -42,6 +43,27 @@ private:
   static std::forward_list<char **> last_used_symbols_;
 };
 
+// appends the php name of a generated function, given without the f$ prefix: '$$' becomes '::', '$' becomes a backslash, 'C$' is dropped
+template<class Append>
+void append_php_function_name(vk::string_view func_name, Append &&append) noexcept {
+  for (auto it = func_name.begin(); it != func_name.end();) {
+    auto next = std::next(it);
+    if (*it == '$') {
+      if (next != func_name.end() && *next == '$') {
+        append("::", 2);
+        ++next;
+      } else {
+        append("\\", 1);
+      }
+    } else if (*it == 'C' && next != func_name.end() && *next == '$') {
+      ++next;
+    } else {
+      append(it, 1);
+    }
+    it = next;
+  }
+}
+
 array<string> f$kphp_backtrace(bool pretty = true) noexcept;
 
 void free_kphp_backtrace() noexcept;
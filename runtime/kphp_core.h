@@ -1348,9 +1348,10 @@ int64_t f$memory_get_total_usage() {
 
 array<int64_t> f$memory_get_detailed_stats() {
   const auto &stats = dl::get_script_memory_stats();
-  return array<int64_t>(
+  array<int64_t> result(
     {
       std::make_pair(string{"memory_limit"}, static_cast<int64_t>(stats.memory_limit)),
+      std::make_pair(string{"memory_arena_size"}, static_cast<int64_t>(stats.memory_arena_size)),
       std::make_pair(string{"real_memory_used"}, static_cast<int64_t>(stats.real_memory_used)),
       std::make_pair(string{"memory_used"}, static_cast<int64_t>(stats.memory_used)),
       std::make_pair(string{"max_real_memory_used"}, static_cast<int64_t>(stats.max_real_memory_used)),
@@ -1358,8 +1359,13 @@ array<int64_t> f$memory_get_detailed_stats() {
       std::make_pair(string{"defragmentation_calls"}, static_cast<int64_t>(stats.defragmentation_calls)),
       std::make_pair(string{"huge_memory_pieces"}, static_cast<int64_t>(stats.huge_memory_pieces)),
       std::make_pair(string{"small_memory_pieces"}, static_cast<int64_t>(stats.small_memory_pieces)),
-      std::make_pair(string{"heap_memory_used"}, static_cast<int64_t>(dl::get_heap_memory_used()))
+      std::make_pair(string{"heap_memory_used"}, static_cast<int64_t>(dl::get_heap_memory_used())),
+      std::make_pair(string{"huge_allocations"}, static_cast<int64_t>(stats.huge_allocations))
     });
+  for (size_t i = 1; i < stats.fast_allocations.size(); ++i) {
+    result.set_value(string{"allocations_"}.append(static_cast<int64_t>(i * 8)), static_cast<int64_t>(stats.fast_allocations[i]));
+  }
+  return result;
 }
 
 
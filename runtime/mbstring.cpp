@@ -4,6 +4,7 @@
 
 #include "runtime/mbstring.h"
 
+#include "common/string-kernels.h"
 #include "common/unicode/unicode-utils.h"
 #include "common/unicode/utf8-utils.h"
 
@@ -17,14 +18,16 @@ static int mb_detect_encoding(const string &encoding) {
   return -1;
 }
 
-static int64_t mb_UTF8_strlen(const char *s) {
-  int64_t res = 0;
-  for (int64_t i = 0; s[i]; i++) {
-    if ((((unsigned char)s[i]) & 0xc0) != 0x80) {
-      res++;
-    }
-  }
-  return res;
+// utf-8 functions treat strings as null-terminated
+static int64_t mb_UTF8_strlen(const string &str) {
+  const char *zero = static_cast<const char *>(memchr(str.c_str(), '\0', str.size()));
+  const size_t len = zero ? zero - str.c_str() : str.size();
+  return utf8_code_points_count(str.c_str(), len);
+}
+
+// ascii strings without zero bytes can be handled byte by byte
+static bool mb_is_plain_ascii(const string &str) {
+  return ascii_prefix_length(str.c_str(), str.size()) == str.size();
 }
 
 static int64_t mb_UTF8_advance(const char *s, int64_t cnt) {
@@ -52,46 +55,7 @@ static int64_t mb_UTF8_get_offset(const char *s, int64_t pos) {
 }
 
 bool mb_UTF8_check(const char *s) {
-  do {
-#define CHECK(condition) if (!(condition)) {return false;}
-    unsigned int a = (unsigned char)(*s++);
-    if ((a & 0x80) == 0) {
-      if (a == 0) {
-        return true;
-      }
-      continue;
-    }
-
-    CHECK ((a & 0x40) != 0);
-
-    unsigned int b = (unsigned char)(*s++);
-    CHECK((b & 0xc0) == 0x80);
-    if ((a & 0x20) == 0) {
-      CHECK((a & 0x1e) > 0);
-      continue;
-    }
-
-    unsigned int c = (unsigned char)(*s++);
-    CHECK((c & 0xc0) == 0x80);
-    if ((a & 0x10) == 0) {
-      int x = (((a & 0x0f) << 6) | (b & 0x20));
-      CHECK(x != 0 && x != 0x360);//surrogates
-      continue;
-    }
-
-    unsigned int d = (unsigned char)(*s++);
-    CHECK((d & 0xc0) == 0x80);
-    if ((a & 0x08) == 0) {
-      int t = (((a & 0x07) << 6) | (b & 0x30));
-      CHECK(0 < t && t < 0x110);//end of unicode
-      continue;
-    }
-
-    return false;
-#undef CHECK
-  } while (true);
-
-  php_assert (0);
+  return utf8_validate(s, strlen(s));
 }
 
 bool f$mb_check_encoding(const string &str, const string &encoding) {
@@ -120,7 +84,7 @@ int64_t f$mb_strlen(const string &str, const string &encoding) {
     return str.size();
   }
 
-  return mb_UTF8_strlen(str.c_str());
+  return mb_UTF8_strlen(str);
 }
 
 
@@ -275,7 +239,7 @@ Optional<int64_t> f$mb_strpos(const string &haystack, const string &needle, int6
     return false;
   }
 
-  if (encoding_num == 1251) {
+  if (encoding_num == 1251 || mb_is_plain_ascii(haystack)) {
     return f$strpos(haystack, needle, offset);
   }
 
@@ -319,7 +283,8 @@ string f$mb_substr(const string &str, int64_t start, const mixed &length_var, co
     return res.val();
   }
 
-  int64_t len = mb_UTF8_strlen(str.c_str());
+  const bool is_plain_ascii = mb_is_plain_ascii(str);
+  int64_t len = is_plain_ascii ? int64_t{str.size()} : mb_UTF8_strlen(str);
   if (start < 0) {
     start += len;
   }
@@ -336,6 +301,10 @@ string f$mb_substr(const string &str, int64_t start, const mixed &length_var, co
     length = len - start;
   }
 
+  if (is_plain_ascii) {
+    return string(str.c_str() + start, static_cast<string::size_type>(length));
+  }
+
   int64_t UTF8_start = mb_UTF8_advance(str.c_str(), start);
   int64_t UTF8_length = mb_UTF8_advance(str.c_str() + UTF8_start, length);
 
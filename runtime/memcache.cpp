@@ -4,8 +4,10 @@
 
 #include "runtime/memcache.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
+#include <openssl/md5.h>
 
 #include "common/tl/constants/engine.h"
 #include "common/wrappers/gnu-builtins.h"
@@ -37,6 +39,8 @@ const char *mc_method{nullptr};
 static const char *mc_last_key{nullptr};
 static int mc_last_key_len{0};
 static mixed mc_res;
+static bool mc_multiget_completed{false};
+static bool mc_get_completed{false};
 static bool mc_bool_res{false};
 
 mixed rpc_mc_run_increment(int op, const class_instance<C$RpcConnection> &conn, const string &key, const mixed &v, double timeout);
@@ -318,6 +322,7 @@ void mc_multiget_callback(const char *result, int result_len) {
       }
       case 'E':
         if (result_len == 5 && !strncmp(result, "END\r\n", 5)) {
+          mc_multiget_completed = true;
           return;
         }
         /* fallthrough */
@@ -358,6 +363,7 @@ void mc_get_callback(const char *result, int result_len) {
       /* fallthrough */
     case 'E':
       if (result_len == 5 && !strncmp(result, "END\r\n", 5)) {
+        mc_get_completed = true;
         return;
       }
       /* fallthrough */
@@ -425,11 +431,12 @@ C$McMemcache::host::host() :
   timeout_ms(200) {
 }
 
-C$McMemcache::host::host(int32_t host_num, int32_t host_port, int32_t host_weight, int32_t timeout_ms) :
+C$McMemcache::host::host(int32_t host_num, int32_t host_port, int32_t host_weight, int32_t timeout_ms, const string &host_name) :
   host_num(host_num),
   host_port(host_port),
   host_weight(host_weight),
-  timeout_ms(timeout_ms) {
+  timeout_ms(timeout_ms),
+  host_name(host_name) {
 }
 
 
@@ -439,6 +446,130 @@ C$McMemcache::host get_host(const array<C$McMemcache::host> &hosts) {
   return hosts.get_value(f$array_rand(hosts));
 }
 
+// the points of the ring are kept with the index of the host in the low bits
+static constexpr int KETAMA_HOST_BITS = 20;
+
+static uint32_t ketama_point(const unsigned char *digest, int i) {
+  return (static_cast<uint32_t>(digest[3 + i * 4]) << 24) | (static_cast<uint32_t>(digest[2 + i * 4]) << 16) |
+         (static_cast<uint32_t>(digest[1 + i * 4]) << 8) | digest[i * 4];
+}
+
+static uint32_t ketama_hash(const string &key) {
+  unsigned char digest[MD5_DIGEST_LENGTH];
+  MD5(reinterpret_cast<const unsigned char *>(key.c_str()), key.size(), digest);
+  return ketama_point(digest, 0);
+}
+
+// the same ring as the one of the ketama library: 160 points for a server of the average weight,
+// 4 points from the md5 of each "host:port-i"
+static void build_ketama_ring(const class_instance<C$McMemcache> &mc) {
+  const array<C$McMemcache::host> &hosts = mc->hosts;
+  const int64_t n = hosts.count();
+  if (n >= (1 << KETAMA_HOST_BITS)) {
+    php_warning("Too many servers for consistent hashing in Memcache, a random one is used for each key");
+    mc->ring = array<int64_t>();
+    return;
+  }
+  int64_t total_weight = 0;
+  for (const auto &it : hosts) {
+    total_weight += std::max(it.get_value().host_weight, 1);
+  }
+
+  array<int64_t> ring(array_size(n * 160, 0, true));
+  char name[1024];
+  unsigned char digest[MD5_DIGEST_LENGTH];
+  for (int64_t i = 0; i < n; i++) {
+    const C$McMemcache::host &h = hosts.get_value(i);
+    const double share = static_cast<double>(std::max(h.host_weight, 1)) / static_cast<double>(total_weight);
+    const auto points = static_cast<int64_t>(share * 40.0 * static_cast<double>(n));
+    for (int64_t k = 0; k < points; k++) {
+      const int len = snprintf(name, sizeof(name), "%s:%d-%ld", h.host_name.c_str(), h.host_port, k);
+      MD5(reinterpret_cast<const unsigned char *>(name), std::min(len, static_cast<int>(sizeof(name)) - 1), digest);
+      for (int j = 0; j < 4; j++) {
+        ring.push_back((static_cast<int64_t>(ketama_point(digest, j)) << KETAMA_HOST_BITS) | i);
+      }
+    }
+  }
+  ring.sort(sort_compare<int64_t>(), true);
+  mc->ring = std::move(ring);
+}
+
+// the ring must be built
+static int64_t get_host_index_for_key(const class_instance<C$McMemcache> &mc, const string &real_key) {
+  const array<int64_t> &ring = mc->ring;
+  const int64_t *begin = ring.get_const_vector_pointer();
+  const int64_t *end = begin + ring.count();
+  const int64_t *point = std::lower_bound(begin, end, static_cast<int64_t>(ketama_hash(real_key)) << KETAMA_HOST_BITS);
+  if (point == end) {
+    point = begin;
+  }
+  return *point & ((1 << KETAMA_HOST_BITS) - 1);
+}
+
+// by the ketama ring if it is built, otherwise any of the servers
+static C$McMemcache::host get_host_for_key(const class_instance<C$McMemcache> &mc, const string &real_key) {
+  php_assert (mc->hosts.count() > 0);
+  if (mc->ring.empty()) {
+    return get_host(mc->hosts);
+  }
+  return mc->hosts.get_value(get_host_index_for_key(mc, real_key));
+}
+
+
+static int64_t mc_request_cache_hits;
+static int64_t mc_request_cache_misses;
+
+// ini memcache.request_cache=1 keeps the values got during the request in the objects, like the prefetched ones
+static bool mc_request_cache_enabled() {
+  static int enabled = -1;
+  if (enabled < 0) {
+    // the ini variables are defined once at the start of the server
+    enabled = !strcmp(f$ini_get(string("memcache.request_cache")).val().c_str(), "1");
+  }
+  return enabled;
+}
+
+// ini memcache.noreply=1 sends the changes with noreply and doesn't wait for the answers,
+// the servers must be memcached-compatible ones which don't answer such commands at all
+static bool mc_noreply_enabled() {
+  static int enabled = -1;
+  if (enabled < 0) {
+    enabled = !strcmp(f$ini_get(string("memcache.noreply")).val().c_str(), "1");
+  }
+  return enabled;
+}
+
+static const mixed *find_prefetched(const array<mixed> &prefetched, const string &real_key) {
+  const mixed *value = prefetched.empty() ? nullptr : prefetched.find_value(real_key);
+  if (value) {
+    mc_request_cache_hits++;
+  } else if (mc_request_cache_enabled()) {
+    mc_request_cache_misses++;
+  }
+  return value;
+}
+
+// the found values of a multi-get, the missing keys are remembered as false only if the answer is complete
+static void remember_multiget(array<mixed> &prefetched, const array<mixed> &values, const array<string> &real_keys, bool completed) {
+  for (const auto &it : real_keys) {
+    const string &real_key = it.get_value();
+    if (mc_is_immediate_query(real_key)) {
+      continue;
+    }
+    if (const mixed *value = values.find_value(real_key)) {
+      prefetched.set_value(real_key, *value);
+    } else if (completed) {
+      prefetched.set_value(real_key, false);
+    }
+  }
+}
+
+// the prefetched value is dropped once the key is changed through the same object
+static void forget_prefetched(array<mixed> &prefetched, const string &real_key) {
+  if (!prefetched.empty()) {
+    prefetched.unset(real_key);
+  }
+}
 
 static bool run_set(const class_instance<C$McMemcache> &mc, const string &key, const mixed &value, int64_t flags, int64_t expire) {
   if (mc->hosts.count() <= 0) {
@@ -447,6 +578,7 @@ static bool run_set(const class_instance<C$McMemcache> &mc, const string &key, c
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(mc->prefetched, real_key);
 
   if (flags & ~MEMCACHE_COMPRESSED) {
     php_warning("Wrong parameter flags = %ld in Memcache::%s", flags, mc_method);
@@ -475,17 +607,21 @@ static bool run_set(const class_instance<C$McMemcache> &mc, const string &key, c
     return false;
   }
 
+  const bool noreply = mc_noreply_enabled() && !mc_is_immediate_query(real_key);
   drivers_SB.clean() << mc_method
                      << ' ' << real_key
                      << ' ' << flags
                      << ' ' << expire
-                     << ' ' << (int)string_value.size()
-                     << "\r\n" << string_value
-                     << "\r\n";
+                     << ' ' << (int)string_value.size();
+  if (noreply) {
+    drivers_SB << " noreply";
+  }
+  drivers_SB << "\r\n" << string_value
+             << "\r\n";
 
   mc_bool_res = false;
-  auto cur_host = get_host(mc->hosts);
-  if (mc_is_immediate_query(real_key)) {
+  auto cur_host = get_host_for_key(mc, real_key);
+  if (noreply || mc_is_immediate_query(real_key)) {
     mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, nullptr);
     return true;
   } else {
@@ -503,6 +639,7 @@ mixed run_increment(const class_instance<C$McMemcache> &mc, const string &key, c
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(mc->prefetched, real_key);
 
   drivers_SB.clean() << mc_method << ' ' << real_key << ' ';
 
@@ -525,7 +662,7 @@ mixed run_increment(const class_instance<C$McMemcache> &mc, const string &key, c
   drivers_SB << "\r\n";
 
   mc_res = false;
-  auto cur_host = get_host(mc->hosts);
+  auto cur_host = get_host_for_key(mc, real_key);
   if (mc_is_immediate_query(real_key)) {
     mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, nullptr);
     return 0;
@@ -537,6 +674,58 @@ mixed run_increment(const class_instance<C$McMemcache> &mc, const string &key, c
   }
 }
 
+static bool run_multiget_query(const C$McMemcache::host &cur_host, const array<string> &real_keys, int64_t begin, int64_t end) {
+  drivers_SB.clean() << "get";
+  bool is_immediate_query = true;
+  for (int64_t i = begin; i < end; i++) {
+    const string &real_key = real_keys.get_value(i);
+    drivers_SB << ' ' << real_key;
+    is_immediate_query = is_immediate_query && mc_is_immediate_query(real_key);
+  }
+  drivers_SB << "\r\n";
+
+  if (is_immediate_query) {
+    mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, nullptr); //TODO wrong if we have no mc_proxy
+    return true;
+  }
+  mc_multiget_completed = false;
+  mc_last_key = drivers_SB.c_str();
+  mc_last_key_len = (int)drivers_SB.size();
+  mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, mc_multiget_callback); //TODO wrong if we have no mc_proxy
+  return mc_multiget_completed;
+}
+
+// adds the found values to mc_res, one query for each of the servers of the keys,
+// returns whether all the servers answered completely
+static bool run_multiget(const class_instance<C$McMemcache> &mc, const array<string> &real_keys) {
+  if (mc->ring.empty()) {
+    return run_multiget_query(get_host(mc->hosts), real_keys, 0, real_keys.count());
+  }
+
+  array<int64_t> keys_by_host(array_size(real_keys.count(), 0, true));
+  for (const auto &it : real_keys) {
+    const int64_t host_index = get_host_index_for_key(mc, it.get_value());
+    keys_by_host.push_back((host_index << 32) | keys_by_host.count());
+  }
+  keys_by_host.sort(sort_compare<int64_t>(), true);
+
+  array<string> sorted_keys(array_size(real_keys.count(), 0, true));
+  for (const auto &it : keys_by_host) {
+    sorted_keys.push_back(real_keys.get_value(it.get_value() & 0xffffffff));
+  }
+
+  bool completed = true;
+  const int64_t n = keys_by_host.count();
+  for (int64_t begin = 0, end = 0; begin < n; begin = end) {
+    const int64_t host_index = keys_by_host.get_value(begin) >> 32;
+    while (end < n && (keys_by_host.get_value(end) >> 32) == host_index) {
+      end++;
+    }
+    completed &= run_multiget_query(mc->hosts.get_value(host_index), sorted_keys, begin, end);
+  }
+  return completed;
+}
+
 bool f$McMemcache$$addServer(const class_instance<C$McMemcache> & mc, const string &host_name, int64_t port,
                              bool persistent __attribute__((unused)), int64_t weight, double timeout, int64_t retry_interval __attribute__((unused)),
                              bool status __attribute__((unused)), const mixed &failure_callback __attribute__((unused)), int64_t timeoutms) {
@@ -551,7 +740,10 @@ bool f$McMemcache$$addServer(const class_instance<C$McMemcache> & mc, const stri
 
   int host_num = mc_connect_to(host_name.c_str(), static_cast<int32_t>(port));
   if (host_num >= 0) {
-    mc->hosts.push_back({host_num, static_cast<int32_t>(port), static_cast<int32_t>(weight), result_timeout});
+    mc->hosts.push_back({host_num, static_cast<int32_t>(port), static_cast<int32_t>(weight), result_timeout, host_name});
+    if (!strcmp(f$ini_get(string("memcache.hash_strategy")).val().c_str(), "consistent")) {
+      build_ketama_ring(mc);
+    }
   }
   return host_num >= 0;
 }
@@ -584,25 +776,16 @@ mixed f$McMemcache$$get(const class_instance<C$McMemcache> &v$this, const mixed
       return array<mixed>();
     }
 
-    drivers_SB.clean();
-    drivers_SB << "get";
-    bool is_immediate_query = true;
+    array<string> real_keys(array_size(key_var.count(), 0, true));
     for (array<mixed>::const_iterator p = key_var.begin(); p != key_var.end(); ++p) {
-      const string key = p.get_value().to_string();
-      const string real_key = mc_prepare_key(key);
-      drivers_SB << ' ' << real_key;
-      is_immediate_query = is_immediate_query && mc_is_immediate_query(real_key);
+      real_keys.push_back(mc_prepare_key(p.get_value().to_string()));
     }
-    drivers_SB << "\r\n";
 
     mc_res = array<mixed>(array_size(0, key_var.count(), false));
-    auto cur_host = get_host(v$this->hosts);
-    if (is_immediate_query) {
-      mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, nullptr); //TODO wrong if we have no mc_proxy
-    } else {
-      mc_last_key = drivers_SB.c_str();
-      mc_last_key_len = (int)drivers_SB.size();
-      mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, mc_multiget_callback); //TODO wrong if we have no mc_proxy
+    const bool completed = run_multiget(v$this, real_keys);
+    if (mc_request_cache_enabled()) {
+      mc_request_cache_misses += real_keys.count();
+      remember_multiget(v$this->prefetched, mc_res.as_array(), real_keys, completed);
     }
   } else {
     if (v$this->hosts.count() <= 0) {
@@ -612,23 +795,61 @@ mixed f$McMemcache$$get(const class_instance<C$McMemcache> &v$this, const mixed
 
     const string key = key_var.to_string();
     const string real_key = mc_prepare_key(key);
+    if (const mixed *prefetched = find_prefetched(v$this->prefetched, real_key)) {
+      return *prefetched;
+    }
 
     drivers_SB.clean() << "get " << real_key << "\r\n";
 
-    auto cur_host = get_host(v$this->hosts);
+    auto cur_host = get_host_for_key(v$this, real_key);
     if (mc_is_immediate_query(real_key)) {
       mc_res = true;
       mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, nullptr);
     } else {
       mc_res = false;
+      mc_get_completed = false;
       mc_last_key = real_key.c_str();
       mc_last_key_len = (int)real_key.size();
       mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, mc_get_callback);
+      if (mc_get_completed && mc_request_cache_enabled()) {
+        v$this->prefetched.set_value(real_key, mc_res);
+      }
     }
   }
   return mc_res;
 }
 
+void f$McMemcache$$prefetch(const class_instance<C$McMemcache> &v$this, const array<mixed> &keys) {
+  mc_method = "prefetch";
+  if (keys.empty()) {
+    return;
+  }
+  if (v$this->hosts.count() <= 0) {
+    php_warning("There is no available server to run Memcache::prefetch");
+    return;
+  }
+
+  array<string> real_keys(array_size(keys.count(), 0, true));
+  for (array<mixed>::const_iterator p = keys.begin(); p != keys.end(); ++p) {
+    const string real_key = mc_prepare_key(p.get_value().to_string());
+    if (mc_is_immediate_query(real_key) || v$this->prefetched.has_key(real_key)) {
+      continue;
+    }
+    real_keys.push_back(real_key);
+  }
+  if (real_keys.empty()) {
+    return;
+  }
+
+  mc_res = array<mixed>(array_size(0, real_keys.count(), false));
+  if (!run_multiget(v$this, real_keys)) {
+    // the missing keys are unknown, so get() asks the server again
+    return;
+  }
+
+  remember_multiget(v$this->prefetched, mc_res.as_array(), real_keys, true);
+}
+
 bool f$McMemcache$$delete(const class_instance<C$McMemcache> &v$this,const string &key) {
   mc_method = "delete";
   if (v$this->hosts.count() <= 0) {
@@ -637,12 +858,14 @@ bool f$McMemcache$$delete(const class_instance<C$McMemcache> &v$this,const strin
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(v$this->prefetched, real_key);
 
-  drivers_SB.clean() << "delete " << real_key << "\r\n";
+  const bool noreply = mc_noreply_enabled() && !mc_is_immediate_query(real_key);
+  drivers_SB.clean() << "delete " << real_key << (noreply ? " noreply\r\n" : "\r\n");
 
   mc_bool_res = false;
-  auto cur_host = get_host(v$this->hosts);
-  if (mc_is_immediate_query(real_key)) {
+  auto cur_host = get_host_for_key(v$this, real_key);
+  if (noreply || mc_is_immediate_query(real_key)) {
     mc_run_query(cur_host.host_num, drivers_SB.c_str(), drivers_SB.size(), cur_host.timeout_ms, 0, nullptr);
     return true;
   } else {
@@ -715,6 +938,7 @@ bool f$RpcMemcache$$add(const class_instance<C$RpcMemcache> &v$this, const strin
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(v$this->prefetched, real_key);
   auto cur_host = get_host(v$this->hosts);
   mc_method = "add";
   return catchException(rpc_mc_run_set(v$this->fake ? TL_ENGINE_MC_ADD_QUERY : MEMCACHE_ADD, cur_host.conn, real_key, value, flags, expire, -1), false);
@@ -727,6 +951,7 @@ bool f$RpcMemcache$$set(const class_instance<C$RpcMemcache> &v$this,const string
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(v$this->prefetched, real_key);
   auto cur_host = get_host(v$this->hosts);
   mc_method = "set";
   return catchException(rpc_mc_run_set(v$this->fake ? TL_ENGINE_MC_SET_QUERY : MEMCACHE_SET, cur_host.conn, real_key, value, flags, expire, -1), false);
@@ -739,6 +964,7 @@ bool f$RpcMemcache$$replace(const class_instance<C$RpcMemcache> &v$this, const s
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(v$this->prefetched, real_key);
   auto cur_host = get_host(v$this->hosts);
   mc_method = "replace";
   return catchException(rpc_mc_run_set(v$this->fake ? TL_ENGINE_MC_REPLACE_QUERY : MEMCACHE_REPLACE, cur_host.conn, real_key, value, flags, expire, -1.0), false);
@@ -754,7 +980,18 @@ mixed f$RpcMemcache$$get(const class_instance<C$RpcMemcache> &mc, const mixed &k
     auto cur_host = get_host(mc->hosts);
     mixed res = f$rpc_mc_multiget(cur_host.conn, key_var.to_array(), -1.0, mc->fake);
     php_assert(resumable_finished);
-    return catchException<mixed>(res, array<mixed>());
+    res = catchException<mixed>(res, array<mixed>());
+    if (mc_request_cache_enabled() && res.is_array()) {
+      // the found values only, the answer of the rpc multi-get doesn't tell the missing keys from the failed ones
+      mc_request_cache_misses += key_var.count();
+      for (const auto &it : res.as_array()) {
+        const string real_key = mc_prepare_key(it.get_key().to_string());
+        if (!mc_is_immediate_query(real_key)) {
+          mc->prefetched.set_value(real_key, it.get_value());
+        }
+      }
+    }
+    return res;
   } else {
     if (mc->hosts.count() <= 0) {
       php_warning("There is no available server to run RpcMemcache::get with key \"%s\"", key_var.to_string().c_str());
@@ -763,9 +1000,56 @@ mixed f$RpcMemcache$$get(const class_instance<C$RpcMemcache> &mc, const mixed &k
 
     const string key = key_var.to_string();
     const string real_key = mc_prepare_key(key);
+    if (const mixed *prefetched = find_prefetched(mc->prefetched, real_key)) {
+      return *prefetched;
+    }
 
     auto cur_host = get_host(mc->hosts);
-    return catchException<mixed>(f$rpc_mc_get(cur_host.conn, real_key, -1.0, mc->fake), false);
+    mixed res = catchException<mixed>(f$rpc_mc_get(cur_host.conn, real_key, -1.0, mc->fake), false);
+    if (mc_request_cache_enabled() && !res.is_bool() && !mc_is_immediate_query(real_key)) {
+      // a false answer may be a failure, so only the found values are kept
+      mc->prefetched.set_value(real_key, res);
+    }
+    return res;
+  }
+}
+
+void f$RpcMemcache$$prefetch(const class_instance<C$RpcMemcache> &mc, const array<mixed> &keys) {
+  if (keys.empty()) {
+    return;
+  }
+  if (mc->hosts.count() <= 0) {
+    php_warning("There is no available server to run RpcMemcache::prefetch");
+    return;
+  }
+
+  array<mixed> query_keys(array_size(keys.count(), 0, true));
+  array<string> real_keys(array_size(keys.count(), 0, true));
+  for (array<mixed>::const_iterator p = keys.begin(); p != keys.end(); ++p) {
+    const string key = p.get_value().to_string();
+    const string real_key = mc_prepare_key(key);
+    if (mc_is_immediate_query(real_key) || mc->prefetched.has_key(real_key)) {
+      continue;
+    }
+    query_keys.push_back(key);
+    real_keys.push_back(real_key);
+  }
+  if (real_keys.empty()) {
+    return;
+  }
+
+  auto cur_host = get_host(mc->hosts);
+  Optional<array<mixed>> res = f$rpc_mc_multiget(cur_host.conn, query_keys, -1.0, mc->fake);
+  php_assert(resumable_finished);
+  res = catchException(std::move(res), false);
+  if (!res.has_value()) {
+    return;
+  }
+
+  const array<mixed> &values = res.val();
+  for (int64_t i = 0; i < real_keys.count(); i++) {
+    const mixed *value = values.find_value(query_keys.get_value(i).to_string());
+    mc->prefetched.set_value(real_keys.get_value(i), value ? *value : mixed(false));
   }
 }
 
@@ -776,6 +1060,7 @@ bool f$RpcMemcache$$delete(const class_instance<C$RpcMemcache> &mc, const string
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(mc->prefetched, real_key);
   auto cur_host = get_host(mc->hosts);
   return catchException(f$rpc_mc_delete(cur_host.conn, real_key, -1.0, mc->fake), false);
 }
@@ -787,6 +1072,7 @@ mixed f$RpcMemcache$$decrement(const class_instance<C$RpcMemcache> &mc, const st
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(mc->prefetched, real_key);
   auto cur_host = get_host(mc->hosts);
   mc_method = "decrement";
   return catchException(rpc_mc_run_increment(mc->fake ? TL_ENGINE_MC_DECR_QUERY : MEMCACHE_DECR, cur_host.conn, real_key, count, -1), false);
@@ -799,6 +1085,7 @@ mixed f$RpcMemcache$$increment(const class_instance<C$RpcMemcache> &mc, const st
   }
 
   const string real_key = mc_prepare_key(key);
+  forget_prefetched(mc->prefetched, real_key);
   auto cur_host = get_host(mc->hosts);
   mc_method = "increment";
   return catchException(rpc_mc_run_increment(mc->fake ? TL_ENGINE_MC_INCR_QUERY : MEMCACHE_INCR, cur_host.conn, real_key, count, -1.0), false);
@@ -990,8 +1277,17 @@ static void reset_drivers_global_vars() {
   hard_reset_var(mc_res);
 }
 
+array<int64_t> f$memcache_request_cache_stats() {
+  array<int64_t> result(array_size(0, 2, false));
+  result.set_value(string("hits"), mc_request_cache_hits);
+  result.set_value(string("misses"), mc_request_cache_misses);
+  return result;
+}
+
 void init_memcache_lib() {
   reset_drivers_global_vars();
+  mc_request_cache_hits = 0;
+  mc_request_cache_misses = 0;
 }
 
 void free_memcache_lib() {
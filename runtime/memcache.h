@@ -24,6 +24,8 @@ mixed mc_get_value(const char *result_str, int32_t result_str_len, int64_t flags
 
 bool mc_is_immediate_query(const string &key);
 
+array<int64_t> f$memcache_request_cache_stats();
+
 
 constexpr int64_t MEMCACHE_SERIALIZED = 1;
 constexpr int64_t MEMCACHE_COMPRESSED = 2;
@@ -43,13 +45,16 @@ public:
     int32_t host_port;
     int32_t host_weight;
     int32_t timeout_ms;
+    string host_name;
 
     host();
-    host(int32_t host_num, int32_t host_port, int32_t host_weight, int32_t timeout_ms);
+    host(int32_t host_num, int32_t host_port, int32_t host_weight, int32_t timeout_ms, const string &host_name);
   };
 
   void accept(InstanceMemoryEstimateVisitor &visitor) final {
     visitor("", hosts);
+    visitor("", prefetched);
+    visitor("", ring);
   }
 
   const char *get_class() const final {
@@ -65,6 +70,11 @@ public:
   }
 
   array<host> hosts{array_size{1, 0, true}};
+  // the values of the keys fetched by prefetch() and, with memcache.request_cache, by get(),
+  // by their prepared keys, false for the missing ones
+  array<mixed> prefetched;
+  // the sorted points of the ketama ring with memcache.hash_strategy=consistent, (point << 32) | index of the host
+  array<int64_t> ring;
 };
 
 class C$RpcMemcache final : public refcountable_polymorphic_php_classes<C$Memcache> {
@@ -81,6 +91,7 @@ public:
   void accept(InstanceMemoryEstimateVisitor &visitor) final {
     visitor("", hosts);
     visitor("", fake);
+    visitor("", prefetched);
   }
 
   const char *get_class() const final {
@@ -97,6 +108,9 @@ public:
 
   array<host> hosts{array_size{1, 0, true}};
   bool fake{false};
+  // the values of the keys fetched by prefetch() and, with memcache.request_cache, by get(),
+  // by their prepared keys, false for the missing ones
+  array<mixed> prefetched;
 };
 
 class_instance<C$McMemcache> f$McMemcache$$__construct(const class_instance<C$McMemcache> &v$this);
@@ -107,6 +121,7 @@ bool f$McMemcache$$add(const class_instance<C$McMemcache> &v$this, const string
 bool f$McMemcache$$set(const class_instance<C$McMemcache> &v$this, const string &key, const mixed &value, int64_t flags = 0, int64_t expire = 0);
 bool f$McMemcache$$replace(const class_instance<C$McMemcache> &v$this, const string &key, const mixed &value, int64_t flags = 0, int64_t expire = 0);
 mixed f$McMemcache$$get(const class_instance<C$McMemcache> &v$this, const mixed &key_var);
+void f$McMemcache$$prefetch(const class_instance<C$McMemcache> &v$this, const array<mixed> &keys);
 bool f$McMemcache$$delete(const class_instance<C$McMemcache> &v$this, const string &key);
 mixed f$McMemcache$$decrement(const class_instance<C$McMemcache> &v$this, const string &key, const mixed &v = 1);
 mixed f$McMemcache$$increment(const class_instance<C$McMemcache> &v$this, const string &key, const mixed &v = 1);
@@ -121,6 +136,7 @@ bool f$RpcMemcache$$add(const class_instance<C$RpcMemcache> &v$this, const strin
 bool f$RpcMemcache$$set(const class_instance<C$RpcMemcache> &v$this,const string &key, const mixed &value, int64_t flags = 0, int64_t expire = 0);
 bool f$RpcMemcache$$replace(const class_instance<C$RpcMemcache> &v$this, const string &key, const mixed &value, int64_t flags = 0, int64_t expire = 0);
 mixed f$RpcMemcache$$get(const class_instance<C$RpcMemcache> &v$this, const mixed &key_var);
+void f$RpcMemcache$$prefetch(const class_instance<C$RpcMemcache> &v$this, const array<mixed> &keys);
 bool f$RpcMemcache$$delete(const class_instance<C$RpcMemcache> &v$this, const string &key);
 mixed f$RpcMemcache$$decrement(const class_instance<C$RpcMemcache> &v$this, const string &key, const mixed &count = 1);
 mixed f$RpcMemcache$$increment(const class_instance<C$RpcMemcache> &v$this, const string &key, const mixed &count = 1);
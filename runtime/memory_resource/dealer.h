@@ -3,7 +3,9 @@
 // Distributed under the GPL v3 License, see LICENSE.notice.txt
 
 #pragma once
+#include "runtime/memory_resource/global_const_memory.h"
 #include "runtime/memory_resource/heap_resource.h"
+#include "runtime/memory_resource/script_arena.h"
 #include "runtime/memory_resource/unsynchronized_pool_resource.h"
 
 namespace memory_resource {
@@ -46,9 +48,19 @@ public:
     return *current_script_resource_;
   }
 
+  script_arena &get_script_arena() noexcept {
+    return script_arena_;
+  }
+
+  global_const_memory &get_global_const_memory() noexcept {
+    return global_const_memory_;
+  }
+
 private:
   heap_resource heap_resource_;
   unsynchronized_pool_resource default_script_resource_;
+  script_arena script_arena_;
+  global_const_memory global_const_memory_;
 
   unsynchronized_pool_resource *current_script_resource_{nullptr};
   memory_resource::heap_resource *heap_replacer_{nullptr};
@@ -127,6 +127,14 @@ bool memory_chunk_tree::has_memory_for(size_t size) const noexcept {
   return search(size, true);
 }
 
+size_t memory_chunk_tree::get_largest_chunk_size() const noexcept {
+  const tree_node *v = root_;
+  while (v && v->right) {
+    v = v->right;
+  }
+  return v ? v->chunk_size : 0;
+}
+
 size_t memory_chunk_tree::get_chunk_size(tree_node *node) noexcept {
   return node->chunk_size;
 }
@@ -22,6 +22,7 @@ public:
   tree_node *extract(size_t size) noexcept;
   tree_node *extract_smallest() noexcept;
   bool has_memory_for(size_t size) const noexcept;
+  size_t get_largest_chunk_size() const noexcept;
 
   static size_t get_chunk_size(tree_node *node) noexcept;
 
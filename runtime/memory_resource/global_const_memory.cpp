@@ -0,0 +1,46 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/memory_resource/global_const_memory.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace memory_resource {
+
+constexpr size_t global_const_memory::RESERVED_SIZE;
+
+void global_const_memory::enter() noexcept {
+  if (!depth_++ && !begin_) {
+    void *mem = mmap(nullptr, RESERVED_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    php_assert(mem != MAP_FAILED);
+    begin_ = static_cast<char *>(mem);
+    pool_.init(begin_, RESERVED_SIZE);
+  }
+}
+
+void global_const_memory::leave() noexcept {
+  php_assert(depth_ > 0);
+  --depth_;
+}
+
+void global_const_memory::seal() noexcept {
+  php_assert(!depth_);
+  if (!begin_) {
+    return;
+  }
+  const auto page_size = static_cast<size_t>(getpagesize());
+  const size_t used = (pool_.get_memory_stats().max_real_memory_used + page_size - 1) / page_size * page_size;
+  if (used) {
+    php_assert(mprotect(begin_, used, PROT_READ) == 0);
+  }
+  if (used < RESERVED_SIZE) {
+    munmap(begin_ + used, RESERVED_SIZE - used);
+  }
+  sealed_size_ += used;
+  begin_ = nullptr;
+  pool_.init(nullptr, 0);
+}
+
+} // namespace memory_resource
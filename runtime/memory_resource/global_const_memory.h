@@ -0,0 +1,62 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "runtime/memory_resource/unsynchronized_pool_resource.h"
+
+namespace memory_resource {
+
+// The segment of the global constants, which are created during the global init (by the master before the fork).
+// It's separated from the heap, so the heap allocations of the workers don't dirty its pages,
+// and it is made read-only when the constants are initialized, so the workers keep sharing it.
+class global_const_memory {
+public:
+  // the address space is reserved at once, the pages are touched only on use
+  static constexpr size_t RESERVED_SIZE = 1024 * 1024 * 1024;
+
+  void enter() noexcept;
+  void leave() noexcept;
+  // makes the used part read-only and gives the rest of the reservation back,
+  // the next enter() starts a new segment
+  void seal() noexcept;
+
+  bool is_enabled() const noexcept {
+    return depth_ > 0;
+  }
+
+  bool owns(const void *mem) const noexcept {
+    return begin_ && begin_ <= mem && mem < begin_ + RESERVED_SIZE;
+  }
+
+  // nullptr if the segment is exhausted, the caller falls back to the heap
+  void *allocate(size_t size) noexcept {
+    return pool_.is_enough_memory_for(size) ? pool_.allocate(size) : nullptr;
+  }
+
+  void *allocate0(size_t size) noexcept {
+    return pool_.is_enough_memory_for(size) ? pool_.allocate0(size) : nullptr;
+  }
+
+  void *reallocate(void *mem, size_t new_size, size_t old_size) noexcept {
+    return pool_.is_enough_memory_for(new_size) ? pool_.reallocate(mem, new_size, old_size) : nullptr;
+  }
+
+  void deallocate(void *mem, size_t size) noexcept {
+    pool_.deallocate(mem, size);
+  }
+
+  size_t get_sealed_size() const noexcept {
+    return sealed_size_;
+  }
+
+private:
+  unsynchronized_pool_resource pool_;
+  char *begin_{nullptr};
+  int depth_{0};
+  // the total size of the sealed segments
+  size_t sealed_size_{0};
+};
+
+} // namespace memory_resource
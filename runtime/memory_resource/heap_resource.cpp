@@ -24,7 +24,7 @@ void *heap_resource::allocate(size_t size) noexcept {
   }
 
   memory_debug("heap allocate %zu at %p\n", size, mem);
-  memory_used_ += size;
+  register_allocation(size);
   return mem;
 }
 
@@ -38,7 +38,7 @@ void *heap_resource::allocate0(size_t size) noexcept {
   }
 
   memory_debug("heap allocate0 %zu at %p\n", size, mem);
-  memory_used_ += size;
+  register_allocation(size);
   return mem;
 }
 
@@ -51,7 +51,7 @@ void *heap_resource::reallocate(void *mem, size_t new_size, size_t old_size) noe
     raise(SIGUSR2);
     return nullptr;
   }
-  memory_used_ += (new_size - old_size);
+  register_allocation(new_size - old_size);
   return mem;
 }
 
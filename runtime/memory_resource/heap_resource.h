@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "runtime/memory_resource/memory_resource.h"
 
 namespace memory_resource {
@@ -16,9 +18,19 @@ public:
   void deallocate(void *mem, size_t size) noexcept;
 
   size_t memory_used() const noexcept { return memory_used_; }
+  size_t max_memory_used() const noexcept { return max_memory_used_; }
+
+  // starts the high-water mark of the next request
+  void reset_max_memory_used() noexcept { max_memory_used_ = memory_used_; }
 
 private:
+  void register_allocation(size_t size) noexcept {
+    memory_used_ += size;
+    max_memory_used_ = std::max(max_memory_used_, memory_used_);
+  }
+
   size_t memory_used_{0};
+  size_t max_memory_used_{0};
 };
 
 } // namespace memory_resource
@@ -21,6 +21,7 @@ namespace memory_resource {
 
 void MemoryStats::write_stats_to(stats_t *stats, const char *prefix) const noexcept {
   write_stat(stats, prefix, "memory.limit", memory_limit);
+  write_stat(stats, prefix, "memory.arena_size", memory_arena_size);
   write_stat(stats, prefix, "memory.used", memory_used);
   write_stat(stats, prefix, "memory.used_max", max_memory_used);
   write_stat(stats, prefix, "memory.real_used", real_memory_used);
@@ -28,6 +29,12 @@ void MemoryStats::write_stats_to(stats_t *stats, const char *prefix) const noexc
   write_stat(stats, prefix, "memory.defragmentation_calls", defragmentation_calls);
   write_stat(stats, prefix, "memory.huge_memory_pieces", huge_memory_pieces);
   write_stat(stats, prefix, "memory.small_memory_pieces", small_memory_pieces);
+  for (size_t i = 1; i < fast_allocations.size(); ++i) {
+    char suffix[64]{0};
+    snprintf(suffix, sizeof(suffix) - 1, "memory.allocations.size_%zu", i * 8);
+    write_stat(stats, prefix, suffix, fast_allocations[i]);
+  }
+  write_stat(stats, prefix, "memory.allocations.huge", huge_allocations);
 }
 
 } // namespace memory_resource
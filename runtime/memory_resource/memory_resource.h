@@ -3,6 +3,7 @@
 // Distributed under the GPL v3 License, see LICENSE.notice.txt
 
 #pragma once
+#include <array>
 #include <cinttypes>
 #include <cstdarg>
 #include <cstdio>
@@ -31,6 +32,11 @@ constexpr size_t memory_buffer_limit() noexcept {
   return std::numeric_limits<uint32_t>::max();
 }
 
+// allocations up to this size take the fast path of unsynchronized_pool_resource
+constexpr size_t fast_allocation_max_size() noexcept {
+  return 128;
+}
+
 class MemoryStats {
 public:
   size_t real_memory_used{0}; // currently used and dirty memory
@@ -40,6 +46,7 @@ public:
   size_t max_memory_used{0}; // maximum used memory
 
   size_t memory_limit{0}; // size of memory arena
+  size_t memory_arena_size{0}; // the part of the arena the pool has grown to, it's equal to the memory_limit if the pool doesn't grow
 
   size_t defragmentation_calls{0}; // the number of defragmentation process calls
 
@@ -49,6 +56,10 @@ public:
   size_t total_allocations{0}; // the total number of allocations
   size_t total_memory_allocated{0}; // the total amount of the memory allocated (doesn't take the freed memory into the account)
 
+  // the number of the fast path allocations per 8 byte size class: [i] is for allocations of i * 8 bytes
+  std::array<size_t, fast_allocation_max_size() / 8 + 1> fast_allocations{};
+  size_t huge_allocations{0}; // the number of allocations that don't fit into the small pieces lists
+
   void write_stats_to(stats_t *stats, const char *prefix) const noexcept;
 };
 
@@ -0,0 +1,105 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/memory_resource/script_arena.h"
+
+#include "runtime/memory_resource/unsynchronized_pool_resource.h"
+
+namespace memory_resource {
+
+namespace {
+
+constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+constexpr size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+} // namespace
+
+script_arena::mark script_arena::enter(unsynchronized_pool_resource &upstream) noexcept {
+  if (!depth_++) {
+    php_assert(!last_block_);
+    upstream_ = &upstream;
+  }
+  return mark{last_block_, memory_current_};
+}
+
+void script_arena::leave(const mark &scope_mark) noexcept {
+  php_assert(depth_ > 0);
+  while (last_block_ != scope_mark.block) {
+    free_last_block();
+  }
+  memory_current_ = scope_mark.current;
+  if (!--depth_) {
+    upstream_ = nullptr;
+  }
+}
+
+void *script_arena::reallocate(void *mem, size_t new_size, size_t old_size) noexcept {
+  const auto aligned_old_size = details::align_for_chunk(old_size);
+  const auto aligned_new_size = details::align_for_chunk(new_size);
+  if (static_cast<char *>(mem) + aligned_old_size == memory_current_ &&
+      static_cast<size_t>(memory_end_ - memory_current_) >= aligned_new_size - aligned_old_size) {
+    memory_current_ += aligned_new_size - aligned_old_size;
+    return mem;
+  }
+  void *new_mem = allocate(aligned_new_size);
+  if (likely(new_mem != nullptr)) {
+    memcpy(new_mem, mem, old_size);
+  }
+  return new_mem;
+}
+
+void script_arena::reset() noexcept {
+  upstream_ = nullptr;
+  last_block_ = nullptr;
+  depth_ = 0;
+  suspended_ = 0;
+  blocks_allocated_ = 0;
+  memory_begin_ = memory_current_ = memory_end_ = nullptr;
+}
+
+bool script_arena::owns_slow(const void *mem) const noexcept {
+  for (const block_header *block = last_block_; block; block = block->prev) {
+    const char *block_begin = reinterpret_cast<const char *>(block + 1);
+    const char *block_end = reinterpret_cast<const char *>(block) + block->size;
+    if (block_begin <= mem && mem < block_end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void *script_arena::allocate_in_new_block(size_t aligned_size) noexcept {
+  php_assert(upstream_);
+  size_t block_size = last_block_ ? std::min(last_block_->size * 2, MAX_BLOCK_SIZE) : MIN_BLOCK_SIZE;
+  block_size = std::max(block_size, aligned_size + sizeof(block_header));
+  auto *block = static_cast<block_header *>(upstream_->allocate(block_size));
+  if (unlikely(!block)) {
+    return nullptr;
+  }
+  block->prev = last_block_;
+  block->size = block_size;
+  block->prev_current = memory_current_;
+  last_block_ = block;
+  ++blocks_allocated_;
+
+  memory_begin_ = reinterpret_cast<char *>(block + 1);
+  memory_current_ = memory_begin_;
+  memory_end_ = reinterpret_cast<char *>(block) + block_size;
+  return get_from_pool(aligned_size, true);
+}
+
+void script_arena::free_last_block() noexcept {
+  block_header *block = last_block_;
+  last_block_ = block->prev;
+  if (last_block_) {
+    memory_begin_ = reinterpret_cast<char *>(last_block_ + 1);
+    memory_end_ = reinterpret_cast<char *>(last_block_) + last_block_->size;
+  } else {
+    memory_begin_ = memory_end_ = nullptr;
+  }
+  memory_current_ = block->prev_current;
+  upstream_->deallocate(block, block->size);
+}
+
+} // namespace memory_resource
@@ -0,0 +1,94 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "runtime/memory_resource/details/memory_chunk_list.h"
+#include "runtime/memory_resource/monotonic_buffer_resource.h"
+
+namespace memory_resource {
+
+class unsynchronized_pool_resource;
+
+// The memory of the nested scopes (@kphp-arena functions) whose temporaries can't outlive them.
+// It is bump-allocated from the blocks taken from the script memory resource, the pieces aren't put into the free lists,
+// and all the memory allocated since the scope entry is given back at once on the scope exit.
+class script_arena : private monotonic_buffer_resource {
+public:
+  // the position which the scope exit rewinds the arena to
+  struct mark {
+    void *block{nullptr};
+    char *current{nullptr};
+  };
+
+  mark enter(unsynchronized_pool_resource &upstream) noexcept;
+  void leave(const mark &scope_mark) noexcept;
+
+  // the runtime caches which live till the end of the request must not be allocated in the arena
+  void suspend() noexcept {
+    ++suspended_;
+  }
+
+  void resume() noexcept {
+    --suspended_;
+  }
+
+  bool is_enabled() const noexcept {
+    return depth_ && !suspended_;
+  }
+
+  bool owns(const void *mem) const noexcept {
+    return last_block_ && owns_slow(mem);
+  }
+
+  void *allocate(size_t size) noexcept {
+    const auto aligned_size = details::align_for_chunk(size);
+    void *mem = get_from_pool(aligned_size, true);
+    return likely(mem != nullptr) ? mem : allocate_in_new_block(aligned_size);
+  }
+
+  void *allocate0(size_t size) noexcept {
+    void *mem = allocate(size);
+    if (likely(mem != nullptr)) {
+      memset(mem, 0x00, size);
+    }
+    return mem;
+  }
+
+  void *reallocate(void *mem, size_t new_size, size_t old_size) noexcept;
+
+  void deallocate(void *mem, size_t size) noexcept {
+    // only the last piece can be reused, the others wait for the scope exit
+    if (static_cast<char *>(mem) + details::align_for_chunk(size) == memory_current_) {
+      memory_current_ = static_cast<char *>(mem);
+    }
+  }
+
+  // forgets the blocks without freeing them, the script memory is going to be reinitialized
+  void reset() noexcept;
+
+  size_t get_blocks_allocated() const noexcept {
+    return blocks_allocated_;
+  }
+
+private:
+  struct block_header {
+    block_header *prev;
+    size_t size;
+    // the position in the previous block, when this one was added
+    char *prev_current;
+  };
+
+  bool owns_slow(const void *mem) const noexcept;
+  void *allocate_in_new_block(size_t aligned_size) noexcept;
+  void free_last_block() noexcept;
+
+  unsynchronized_pool_resource *upstream_{nullptr};
+  block_header *last_block_{nullptr};
+  int depth_{0};
+  int suspended_{0};
+  size_t blocks_allocated_{0};
+};
+
+} // namespace memory_resource
@@ -12,8 +12,14 @@ namespace memory_resource {
 
 constexpr size_t unsynchronized_pool_resource::MAX_CHUNK_BLOCK_SIZE_;
 
-void unsynchronized_pool_resource::init(void *buffer, size_t buffer_size) noexcept {
+void unsynchronized_pool_resource::init(void *buffer, size_t buffer_size, size_t growth_step) noexcept {
   monotonic_buffer_resource::init(buffer, buffer_size);
+  memory_reserved_end_ = memory_end_;
+  growth_step_ = growth_step;
+  if (growth_step_ && growth_step_ < buffer_size) {
+    memory_end_ = memory_begin_ + growth_step_;
+  }
+  stats_.memory_arena_size = static_cast<size_t>(memory_end_ - memory_begin_);
 
   huge_pieces_.hard_reset();
   fallback_resource_.init(nullptr, 0);
@@ -52,6 +58,19 @@ void unsynchronized_pool_resource::perform_defragmentation() noexcept {
   ++stats_.defragmentation_calls;
 }
 
+void *unsynchronized_pool_resource::allocate_slow_piece(size_t aligned_size) noexcept {
+  if (aligned_size < MAX_CHUNK_BLOCK_SIZE_) {
+    void *mem = try_allocate_small_piece(aligned_size);
+    return mem ? mem : allocate_small_piece_from_fallback_resource(aligned_size);
+  }
+  ++stats_.huge_allocations;
+  void *mem = allocate_huge_piece(aligned_size, true);
+  if (!mem && try_grow(aligned_size)) {
+    mem = get_from_pool(aligned_size);
+  }
+  return mem ? mem : perform_defragmentation_and_allocate_huge_piece(aligned_size);
+}
+
 void *unsynchronized_pool_resource::allocate_small_piece_from_fallback_resource(size_t aligned_size) noexcept {
   void *mem = fallback_resource_.get_from_pool(aligned_size, true);
   if (likely(mem != nullptr)) {
@@ -60,6 +79,9 @@ void *unsynchronized_pool_resource::allocate_small_piece_from_fallback_resource(
   }
   details::memory_chunk_tree::tree_node *smallest_huge_piece = huge_pieces_.extract_smallest();
   if (!smallest_huge_piece) {
+    if (try_grow(aligned_size)) {
+      return get_from_pool(aligned_size);
+    }
     perform_defragmentation();
     if ((mem = try_allocate_small_piece(aligned_size))) {
       return mem;
@@ -83,4 +105,18 @@ void *unsynchronized_pool_resource::perform_defragmentation_and_allocate_huge_pi
   return allocate_huge_piece(aligned_size, false);
 }
 
+bool unsynchronized_pool_resource::try_grow(size_t aligned_size) noexcept {
+  // the caller has checked that the pool doesn't have enough memory
+  const size_t required = aligned_size - static_cast<size_t>(memory_end_ - memory_current_);
+  const size_t reserved_left = static_cast<size_t>(memory_reserved_end_ - memory_end_);
+  if (!growth_step_ || required > reserved_left) {
+    return false;
+  }
+  const size_t growth = std::min(reserved_left, (required + growth_step_ - 1) / growth_step_ * growth_step_);
+  memory_end_ += growth;
+  stats_.memory_arena_size = static_cast<size_t>(memory_end_ - memory_begin_);
+  memory_debug("pool grows by %zu, arena size is %zu\n", growth, stats_.memory_arena_size);
+  return true;
+}
+
 } // namespace memory_resource
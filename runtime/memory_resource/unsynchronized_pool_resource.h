@@ -19,23 +19,15 @@ public:
   using monotonic_buffer_resource::get_memory_stats;
   using monotonic_buffer_resource::memory_begin;
 
-  void init(void *buffer, size_t buffer_size) noexcept;
+  // the pool starts with growth_step bytes of the buffer and grows by them on demand,
+  // so the untouched tail of the buffer doesn't get dirty; 0 means the whole buffer at once
+  void init(void *buffer, size_t buffer_size, size_t growth_step = 0) noexcept;
 
   void *allocate(size_t size) noexcept {
-    void *mem = nullptr;
     const auto aligned_size = details::align_for_chunk(size);
-    if (aligned_size < MAX_CHUNK_BLOCK_SIZE_) {
-      mem = try_allocate_small_piece(aligned_size);
-      if (!mem) {
-        mem = allocate_small_piece_from_fallback_resource(aligned_size);
-      }
-    } else {
-      mem = allocate_huge_piece(aligned_size, true);
-      if (!mem) {
-        mem = perform_defragmentation_and_allocate_huge_piece(aligned_size);
-      }
-    }
-
+    void *mem = likely(aligned_size <= fast_allocation_max_size())
+                ? allocate_fast_piece(aligned_size)
+                : allocate_slow_piece(aligned_size);
     register_allocation(mem, aligned_size);
     return mem;
   }
@@ -63,13 +55,38 @@ public:
 
   void perform_defragmentation() noexcept;
 
+  // the biggest piece that can be allocated without the defragmentation
+  size_t get_largest_free_piece_size() const noexcept {
+    return std::max({static_cast<size_t>(memory_reserved_end_ - memory_current_), fallback_resource_.size(),
+                     huge_pieces_.get_largest_chunk_size()});
+  }
+
   bool is_enough_memory_for(size_t size) const noexcept {
     const auto aligned_size = details::align_for_chunk(size);
     // not using free_chunks_ here as the real size can be smaller
-    return static_cast<size_t>(memory_end_ - memory_current_) >= aligned_size || huge_pieces_.has_memory_for(aligned_size);
+    return static_cast<size_t>(memory_reserved_end_ - memory_current_) >= aligned_size || huge_pieces_.has_memory_for(aligned_size);
   }
 
 private:
+  // the hottest size classes: a free list pop or a pool bump, everything else is out of line
+  void *allocate_fast_piece(size_t aligned_size) noexcept {
+    const auto chunk_id = details::get_chunk_id(aligned_size);
+    ++stats_.fast_allocations[chunk_id];
+    void *mem = free_chunks_[chunk_id].get_mem();
+    if (likely(mem != nullptr)) {
+      --stats_.small_memory_pieces;
+      memory_debug("allocate %zu, chunk found, allocated address %p\n", aligned_size, mem);
+      return mem;
+    }
+    if (likely(static_cast<size_t>(memory_end_ - memory_current_) >= aligned_size)) {
+      mem = memory_current_;
+      memory_current_ += aligned_size;
+      memory_debug("allocate %zu, chunk not found, allocated address from pool %p\n", aligned_size, mem);
+      return mem;
+    }
+    return allocate_small_piece_from_fallback_resource(aligned_size);
+  }
+
   void *try_allocate_small_piece(size_t aligned_size) noexcept {
     const auto chunk_id = details::get_chunk_id(aligned_size);
     auto *mem = free_chunks_[chunk_id].get_mem();
@@ -100,8 +117,10 @@ private:
     return mem;
   }
 
+  void *allocate_slow_piece(size_t aligned_size) noexcept;
   void *allocate_small_piece_from_fallback_resource(size_t aligned_size) noexcept;
   void *perform_defragmentation_and_allocate_huge_piece(size_t aligned_size) noexcept;
+  bool try_grow(size_t aligned_size) noexcept;
 
   void put_memory_back(void *mem, size_t size) noexcept {
     if (!monotonic_buffer_resource::put_memory_back(mem, size)) {
@@ -119,7 +138,12 @@ private:
   details::memory_chunk_tree huge_pieces_;
   monotonic_buffer_resource fallback_resource_;
 
+  // the end of the whole buffer, memory_end_ is moved towards it by try_grow
+  char *memory_reserved_end_{nullptr};
+  size_t growth_step_{0};
+
   static constexpr size_t MAX_CHUNK_BLOCK_SIZE_{16u * 1024u};
+  static_assert(fast_allocation_max_size() < MAX_CHUNK_BLOCK_SIZE_, "fast allocations should use the small pieces lists");
   std::array<details::memory_chunk_list, details::get_chunk_id(MAX_CHUNK_BLOCK_SIZE_)> free_chunks_;
 };
 
@@ -58,27 +58,23 @@ int64_t f$estimate_memory_usage(const Optional<T> &value) {
 
 namespace impl_ {
 
-template<size_t Index = 0, typename ...Args>
-std::enable_if_t<Index == sizeof...(Args), int64_t> estimate_tuple_memory_usage(const std::tuple<Args...> &) {
-  return 0;
-}
-
-template<size_t Index = 0, typename ...Args>
-std::enable_if_t<Index != sizeof...(Args), int64_t> estimate_tuple_memory_usage(const std::tuple<Args...> &value) {
-  return estimate_tuple_memory_usage<Index + 1>(value) + f$estimate_memory_usage(std::get<Index>(value));
+template<typename ...Args, size_t ...Is>
+int64_t estimate_tuple_memory_usage(const std::tuple<Args...> &value, std::index_sequence<Is...>) {
+  int64_t memory[] = {0, f$estimate_memory_usage(std::get<Is>(value))...};
+  return std::accumulate(std::begin(memory), std::end(memory), int64_t{0});
 }
 
 } // namespace impl_
 
 template<typename ...Args>
 int64_t f$estimate_memory_usage(const std::tuple<Args...> &value) {
-  return impl_::estimate_tuple_memory_usage(value);
+  return impl_::estimate_tuple_memory_usage(value, std::index_sequence_for<Args...>{});
 }
 
 template<size_t ...Is, typename ...T>
 int64_t f$estimate_memory_usage(const shape<std::index_sequence<Is...>, T...> &value) {
-  int64_t memory[] = {f$estimate_memory_usage(value.template get<Is>())...};
-  return std::accumulate(std::begin(memory), std::end(memory), 0);
+  int64_t memory[] = {0, f$estimate_memory_usage(value.template get<Is>())...};
+  return std::accumulate(std::begin(memory), std::end(memory), int64_t{0});
 }
 
 class InstanceMemoryEstimateVisitor {
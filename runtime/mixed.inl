@@ -1056,32 +1056,47 @@ int64_t mixed::count() const {
 template<class T1, class T2>
 inline bool eq2(const array<T1> &lhs, const array<T2> &rhs);
 
+namespace impl_ {
+
+// the types of both operands as a single value, so the comparison is dispatched by one jump table
+constexpr int32_t mixed_types_pair(mixed::type lhs, mixed::type rhs) noexcept {
+  return static_cast<int32_t>(lhs) << 3 | static_cast<int32_t>(rhs);
+}
+
+} // namespace impl_
+
 int64_t mixed::compare(const mixed &rhs) const {
-  if (unlikely(is_string())) {
-    if (likely(rhs.is_string())) {
+  using impl_::mixed_types_pair;
+  switch (mixed_types_pair(get_type(), rhs.get_type())) {
+    case mixed_types_pair(type::INTEGER, type::INTEGER):
+      return three_way_comparison(as_int(), rhs.as_int());
+    case mixed_types_pair(type::INTEGER, type::FLOAT):
+      return three_way_comparison(static_cast<double>(as_int()), rhs.as_double());
+    case mixed_types_pair(type::FLOAT, type::INTEGER):
+      return three_way_comparison(as_double(), static_cast<double>(rhs.as_int()));
+    case mixed_types_pair(type::FLOAT, type::FLOAT):
+      return three_way_comparison(as_double(), rhs.as_double());
+    case mixed_types_pair(type::STRING, type::STRING):
       return compare_strings_php_order(as_string(), rhs.as_string());
-    } else if (unlikely(rhs.is_null())) {
+    case mixed_types_pair(type::STRING, type::NUL):
       return as_string().empty() ? 0 : 1;
-    }
-  } else if (unlikely(rhs.is_string())) {
-    if (unlikely(is_null())) {
+    case mixed_types_pair(type::NUL, type::STRING):
       return rhs.as_string().empty() ? 0 : -1;
-    }
-  }
-  if (is_bool() || rhs.is_bool() || is_null() || rhs.is_null()) {
-    return three_way_comparison(to_bool(), rhs.to_bool());
-  }
-
-  if (unlikely(is_array() || rhs.is_array())) {
-    if (likely(is_array() && rhs.is_array())) {
+    case mixed_types_pair(type::ARRAY, type::ARRAY):
       if (eq2(as_array(), rhs.as_array())) {
         return 0;
       }
-
       // TODO: Here is bug, but it was before. Fix it later
       return three_way_comparison(as_array().count(), rhs.as_array().count());
-    }
+    default:
+      break;
+  }
 
+  if (is_bool() || rhs.is_bool() || is_null() || rhs.is_null()) {
+    return three_way_comparison(to_bool(), rhs.to_bool());
+  }
+
+  if (unlikely(is_array() || rhs.is_array())) {
     php_warning("Unsupported operand types for operator < or <= (%s and %s)", get_type_c_str(), rhs.get_type_c_str());
     return is_array() ? 1 : -1;
   }
@@ -1415,6 +1430,10 @@ bool mixed::isset(const string &string_key) const {
   return as_array().isset(string_key);
 }
 
+bool mixed::isset(const string &string_key, int64_t precomuted_hash) const {
+  return get_type() == type::ARRAY ? as_array().isset(string_key, precomuted_hash) : isset(string_key);
+}
+
 bool mixed::isset(const mixed &v) const {
   switch (v.get_type()) {
     case type::NUL:
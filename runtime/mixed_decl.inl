@@ -108,6 +108,7 @@ public:
   inline bool isset(int64_t int_key) const;
   inline bool isset(int32_t key) const { return isset(int64_t{key}); }
   inline bool isset(const string &string_key) const;
+  inline bool isset(const string &string_key, int64_t precomuted_hash) const;
   inline bool isset(const mixed &v) const;
   inline bool isset(double double_key) const;
 
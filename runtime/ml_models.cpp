@@ -0,0 +1,227 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/ml_models.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+#include "common/vector-kernels.h"
+
+#include "runtime/critical_section.h"
+#include "runtime/files.h"
+
+namespace {
+
+enum class ModelType : uint32_t {
+  linear = 0,
+  trees = 1,
+};
+
+struct TreeNode {
+  int32_t feature;
+  uint32_t flags;
+  double value;
+  uint32_t left;
+  uint32_t right;
+};
+static_assert(sizeof(TreeNode) == 24, "unexpected TreeNode layout");
+
+constexpr uint32_t MISSING_GOES_LEFT = 1;
+
+class Model {
+public:
+  // returns an error message or nullptr
+  const char *parse(const std::string &data) noexcept {
+    const char *pos = data.data();
+    const char *end = pos + data.size();
+    auto read = [&pos, end](void *dst, size_t len) {
+      if (static_cast<size_t>(end - pos) < len) {
+        return false;
+      }
+      memcpy(dst, pos, len);
+      pos += len;
+      return true;
+    };
+
+    char magic[4];
+    uint32_t type = 0;
+    if (!read(magic, sizeof(magic)) || memcmp(magic, "KML1", sizeof(magic)) ||
+        !read(&type, sizeof(type)) || !read(&features_count_, sizeof(features_count_)) || !read(&base_, sizeof(base_))) {
+      return "wrong header";
+    }
+    type_ = static_cast<ModelType>(type);
+    if (type_ == ModelType::linear) {
+      weights_.resize(features_count_);
+      if (!read(weights_.data(), weights_.size() * sizeof(double))) {
+        return "truncated weights";
+      }
+    } else if (type_ == ModelType::trees) {
+      uint32_t trees_count = 0;
+      if (!read(&trees_count, sizeof(trees_count))) {
+        return "truncated trees";
+      }
+      for (uint32_t tree = 0; tree < trees_count; ++tree) {
+        uint32_t nodes_count = 0;
+        if (!read(&nodes_count, sizeof(nodes_count)) || nodes_count == 0 ||
+            static_cast<size_t>(end - pos) / sizeof(TreeNode) < nodes_count) {
+          return "truncated trees";
+        }
+        const size_t root = nodes_.size();
+        nodes_.resize(root + nodes_count);
+        read(&nodes_[root], nodes_count * sizeof(TreeNode));
+        for (uint32_t i = 0; i < nodes_count; ++i) {
+          TreeNode &node = nodes_[root + i];
+          if (node.feature < 0) {
+            continue;
+          }
+          // the children after their parent guarantee that the traversal stops
+          if (static_cast<uint32_t>(node.feature) >= features_count_ ||
+              node.left <= i || node.left >= nodes_count || node.right <= i || node.right >= nodes_count) {
+            return "wrong tree node";
+          }
+          node.left += static_cast<uint32_t>(root);
+          node.right += static_cast<uint32_t>(root);
+        }
+        roots_.push_back(static_cast<uint32_t>(root));
+      }
+    } else {
+      return "unknown model type";
+    }
+    return pos == end ? nullptr : "extra data at the end";
+  }
+
+  double predict(const array<double> &features) const noexcept {
+    const double *x = features.get_const_vector_pointer();
+    const size_t len = static_cast<size_t>(features.count());
+    if (type_ == ModelType::linear) {
+      return base_ + dot_product_f64(weights_.data(), x, std::min<size_t>(len, weights_.size()));
+    }
+
+    double result = base_;
+    for (uint32_t root : roots_) {
+      const TreeNode *node = &nodes_[root];
+      while (node->feature >= 0) {
+        const auto feature = static_cast<size_t>(node->feature);
+        const double value = feature < len ? x[feature] : NAN;
+        const bool go_left = std::isnan(value) ? (node->flags & MISSING_GOES_LEFT) : value < node->value;
+        node = &nodes_[go_left ? node->left : node->right];
+      }
+      result += node->value;
+    }
+    return result;
+  }
+
+private:
+  ModelType type_{ModelType::linear};
+  uint32_t features_count_{0};
+  double base_{0};
+  std::vector<double> weights_;
+  std::vector<TreeNode> nodes_;
+  std::vector<uint32_t> roots_;
+};
+
+// the models live through the whole worker life, a model is read again only if its file is changed
+class ModelsCache : vk::not_copyable {
+public:
+  static ModelsCache &get() noexcept {
+    static ModelsCache cache;
+    return cache;
+  }
+
+  const Model *get_model(const string &path, const char *function) noexcept {
+    dl::CriticalSectionGuard critical_section;
+    php_assert(!dl::is_malloc_replaced());
+    struct stat stat_buf;
+    if (stat(path.c_str(), &stat_buf) < 0) {
+      php_warning("%s: can't find the model \"%s\"", function, path.c_str());
+      return nullptr;
+    }
+    auto &entry = models_[std::string{path.c_str(), path.size()}];
+    if (entry.model && entry.dev == stat_buf.st_dev && entry.ino == stat_buf.st_ino && entry.size == stat_buf.st_size &&
+        entry.mtime.tv_sec == stat_buf.st_mtim.tv_sec && entry.mtime.tv_nsec == stat_buf.st_mtim.tv_nsec) {
+      return entry.model.get();
+    }
+
+    entry.model.reset();
+    std::string data;
+    if (!read_file(path.c_str(), stat_buf, data)) {
+      php_warning("%s: can't read the model \"%s\"", function, path.c_str());
+      return nullptr;
+    }
+    auto model = std::make_unique<Model>();
+    if (const char *error = model->parse(data)) {
+      php_warning("%s: can't load the model \"%s\": %s", function, path.c_str(), error);
+      return nullptr;
+    }
+    entry = CachedModel{stat_buf.st_dev, stat_buf.st_ino, stat_buf.st_size, stat_buf.st_mtim, std::move(model)};
+    return entry.model.get();
+  }
+
+private:
+  struct CachedModel {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    timespec mtime;
+    std::unique_ptr<Model> model;
+  };
+
+  ModelsCache() = default;
+
+  static bool read_file(const char *path, const struct stat &stat_buf, std::string &data) noexcept {
+    if (!S_ISREG(stat_buf.st_mode)) {
+      return false;
+    }
+    int32_t fd = open_safe(path, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    data.resize(static_cast<size_t>(stat_buf.st_size));
+    const bool is_read = read_safe(fd, &data[0], data.size()) == static_cast<ssize_t>(data.size());
+    close_safe(fd);
+    return is_read;
+  }
+
+  std::unordered_map<std::string, CachedModel> models_;
+};
+
+bool check_features(const array<double> &features, const char *function) noexcept {
+  if (unlikely(!features.is_vector())) {
+    php_warning("%s: the features are expected to be an array with the keys 0..n-1", function);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+Optional<double> f$vk_model_predict(const string &model_path, const array<double> &features) noexcept {
+  const Model *model = ModelsCache::get().get_model(model_path, "vk_model_predict");
+  if (!model || !check_features(features, "vk_model_predict")) {
+    return false;
+  }
+  return model->predict(features);
+}
+
+Optional<array<double>> f$vk_model_predict_batch(const string &model_path, const array<array<double>> &rows) noexcept {
+  const Model *model = ModelsCache::get().get_model(model_path, "vk_model_predict_batch");
+  if (!model) {
+    return false;
+  }
+  array<double> result(rows.size());
+  for (const auto &row : rows) {
+    if (!check_features(row.get_value(), "vk_model_predict_batch")) {
+      return false;
+    }
+    result.set_value(row.get_key(), model->predict(row.get_value()));
+  }
+  return result;
+}
@@ -0,0 +1,22 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "runtime/kphp_core.h"
+
+// The models are read from the files in the little-endian binary format:
+//   char magic[4] = "KML1", uint32 type, uint32 features_count, float64 base
+//   type 0, a linear model: float64 weights[features_count]; the prediction is base + sum of weights[i] * x[i]
+//   type 1, an ensemble of regression trees: uint32 trees_count, then for each tree uint32 nodes_count and its nodes
+//     { int32 feature, uint32 flags, float64 value, uint32 left, uint32 right }, the root is the first one;
+//     a node with feature -1 is a leaf with the value, otherwise x[feature] < value goes to the left child, else to the right one;
+//     a missing feature (NaN or out of the vector) goes to the left child if flags & 1 is set;
+//     the children indices are relative to the tree start and are greater than the node index;
+//     the prediction is base + sum of the values of the reached leaves
+// A model is loaded once per worker and is reloaded when its file changes.
+
+Optional<double> f$vk_model_predict(const string &model_path, const array<double> &features) noexcept;
+
+Optional<array<double>> f$vk_model_predict_batch(const string &model_path, const array<array<double>> &rows) noexcept;
@@ -56,11 +56,7 @@ struct convert<array<T>> {
     }
 
     if (obj.type == msgpack::type::MAP) {
-      array_size size(0, 0, false);
-      run_callbacks_on_map(obj.via.map,
-                           [&size](int64_t, msgpack::object &) { size.int_size++; },
-                           [&size](const string &, msgpack::object &) { size.string_size++; });
-
+      const array_size size = count_map_keys(obj.via.map);
       res_arr.reserve(size.int_size, size.string_size, size.is_vector);
       run_callbacks_on_map(obj.via.map,
                            [&res_arr](int64_t key, msgpack::object &value) { res_arr.set_value(key, value.as<T>()); },
@@ -73,6 +69,25 @@ struct convert<array<T>> {
   }
 
 private:
+  // string keys are not unpacked here, they are copied into the script memory only once while filling the array
+  static array_size count_map_keys(const msgpack::object_map &obj_map) {
+    array_size size(0, 0, false);
+    for (size_t i = 0; i < obj_map.size; ++i) {
+      switch (obj_map.ptr[i].key.type) {
+        case msgpack::type::POSITIVE_INTEGER:
+        case msgpack::type::NEGATIVE_INTEGER:
+          size.int_size++;
+          break;
+        case msgpack::type::STR:
+          size.string_size++;
+          break;
+        default:
+          throw msgpack::unpack_error("expected string or integer in array unpacking");
+      }
+    }
+    return size;
+  }
+
   template<class IntCallbackT, class StrCallbackT>
   static void run_callbacks_on_map(const msgpack::object_map &obj_map, const IntCallbackT &on_integer, const StrCallbackT &on_string) {
     for (size_t i = 0; i < obj_map.size; ++i) {
@@ -369,7 +384,10 @@ inline ResultType f$msgpack_deserialize(const string &buffer, string *out_err_ms
   string err_msg;
   try {
     size_t off{0};
-    msgpack::object_handle oh = msgpack::unpack(buffer.c_str(), buffer.size(), off);
+    // strings are referenced in the input buffer instead of being copied into the msgpack zone:
+    // the buffer outlives the unpacked object, so every string is copied only once, into the script memory
+    const msgpack::unpack_reference_func reference_input_buffer = [](msgpack::type::object_type, size_t, void *) { return true; };
+    msgpack::object_handle oh = msgpack::unpack(buffer.c_str(), buffer.size(), off, reference_input_buffer);
     msgpack::object obj = oh.get();
 
     if (off != buffer.size()) {
@@ -15,11 +15,49 @@ static int *errno_ptr;
 static int *affected_rows_ptr;
 static int *insert_id_ptr;
 static array<array<mixed>> *query_result_ptr;
+// the row packets of a MYSQLI_USE_RESULT query, nullptr for a buffered one
+static string *raw_query_result_ptr;
 static bool *query_id_ptr;
 
 static int *field_cnt_ptr;
 static array<string> *field_names_ptr;
 
+// the ids of the finished results of a multi-statement query, nullptr for a single statement
+static array<int64_t> *multi_query_ids_ptr;
+static C$mysqli *multi_query_db_ptr;
+
+constexpr int SERVER_MORE_RESULTS_EXISTS = 8;
+
+static int64_t mysql_store_result(C$mysqli *db, array<array<mixed>> &&query_result) {
+  php_assert(db->biggest_query_id < 2000000000);
+  db->query_results[++db->biggest_query_id] = std::move(query_result);
+  db->cur_pos[db->biggest_query_id] = 0;
+  return db->biggest_query_id;
+}
+
+static int64_t mysql_store_raw_result(C$mysqli *db, string &&raw_query_result) {
+  const int64_t query_id = mysql_store_result(db, array<array<mixed>>{});
+  db->raw_query_results[query_id] = std::move(raw_query_result);
+  db->raw_query_field_names[query_id] = db->field_names;
+  return query_id;
+}
+
+// a result of the query is finished, the next one follows if the server status says so
+static void mysql_finish_result(int server_status) {
+  if (multi_query_ids_ptr != nullptr && (server_status & SERVER_MORE_RESULTS_EXISTS)) {
+    if (raw_query_result_ptr != nullptr) {
+      multi_query_ids_ptr->push_back(mysql_store_raw_result(multi_query_db_ptr, std::move(*raw_query_result_ptr)));
+      *raw_query_result_ptr = string();
+    } else {
+      multi_query_ids_ptr->push_back(mysql_store_result(multi_query_db_ptr, std::move(*query_result_ptr)));
+      *query_result_ptr = array<array<mixed>>();
+    }
+    mysql_callback_state = 0;
+    return;
+  }
+  mysql_callback_state = 5;
+}
+
 static unsigned long long mysql_read_long_long(const unsigned char *&result, int &result_len, bool &is_null) {
   result_len--;
   if (result_len < 0) {
@@ -69,6 +107,26 @@ static string mysql_read_string(const unsigned char *&result, int &result_len, b
   return value;
 }
 
+// decodes the row packet payload of len bytes
+static bool mysql_decode_row(const unsigned char *result, int len, const array<string> &field_names, array<mixed> &row) {
+  const int field_cnt = static_cast<int>(field_names.count());
+  const unsigned char *result_end = result + len;
+  int result_len = len;
+  row = array<mixed>(array_size(field_cnt, field_cnt, false));
+  for (int i = 0; i < field_cnt; i++) {
+    bool is_null = false;
+    mixed value = mysql_read_string(result, result_len, is_null, true);
+    if (is_null) {
+      value = mixed();
+    }
+    if (result_len < 0 || result > result_end) {
+      return false;
+    }
+    row[field_names.get_value(i)] = value;
+  }
+  return result == result_end;
+}
+
 static void mysql_query_callback(const char *result_, int result_len) {
 //  fprintf (stderr, "%d %d\n", mysql_callback_state, result_len);
   if (!*query_id_ptr || !strcmp(result_, "ERROR\r\n")) {
@@ -96,8 +154,6 @@ static void mysql_query_callback(const char *result_, int result_len) {
   switch (mysql_callback_state) {
     case 0:
       if (result[0] == 0) {
-        mysql_callback_state = 5;
-
         ++result;
         result_len--;
         *affected_rows_ptr = (int)mysql_read_long_long(result, result_len, is_null);
@@ -105,6 +161,7 @@ static void mysql_query_callback(const char *result_, int result_len) {
         if (result_len < 0 || is_null) {
           *query_id_ptr = false;
         }
+        mysql_finish_result(result_len >= 2 ? result[0] + (result[1] << 8) : 0);
         break;
       }
       if (result[0] == 255) {
@@ -179,24 +236,13 @@ static void mysql_query_callback(const char *result_, int result_len) {
       break;
     case 3:
       if (result[0] != 254) {
-        array<mixed>
-        row(array_size(*field_cnt_ptr,
-        *field_cnt_ptr, false));
-        for (int i = 0; i < *field_cnt_ptr; i++) {
-          is_null = false;
-          mixed value = mysql_read_string(result, result_len, is_null, true);
-//          fprintf (stderr, "%p %p \"%s\" %d\n", result, result_end, value.to_string().c_str(), (int)is_null);
-          if (is_null) {
-            value = mixed();
-          }
-          if (result_len < 0 || result > result_end) {
-            *query_id_ptr = false;
-            return;
-          }
-//          row[i] = value;
-          row[field_names_ptr->get_value(i)] = value;
+        if (raw_query_result_ptr != nullptr) {
+          // the packet header is kept, it tells the length of the row
+          raw_query_result_ptr->append(result_, static_cast<string::size_type>(len + 4));
+          break;
         }
-        if (result != result_end) {
+        array<mixed> row;
+        if (!mysql_decode_row(result, len, *field_names_ptr, row)) {
           *query_id_ptr = false;
           return;
         }
@@ -211,10 +257,9 @@ static void mysql_query_callback(const char *result_, int result_len) {
         *query_id_ptr = false;
         return;
       }
+      mysql_finish_result(result[3] + (result[4] << 8));
       result += 5;
       result_len -= 5;
-
-      mysql_callback_state = 5;
       break;
     case 5:
       *query_id_ptr = false;
@@ -225,7 +270,7 @@ static void mysql_query_callback(const char *result_, int result_len) {
 
 static class_instance<C$mysqli> DB_Proxy;
 
-static bool mysql_query(const class_instance<C$mysqli> &db, const string &query) {
+static bool mysql_query(const class_instance<C$mysqli> &db, const string &query, bool use_result, array<int64_t> *multi_query_ids = nullptr) {
   if (query.size() > (1 << 24) - 10) {
     return false;
   }
@@ -236,6 +281,7 @@ static bool mysql_query(const class_instance<C$mysqli> &db, const string &query)
 
   db->insert_id = 0;
   array<array<mixed>> query_result;
+  string raw_query_result;
   bool query_id = true;
 
   int packet_len = query.size() + 1;
@@ -254,21 +300,28 @@ static bool mysql_query(const class_instance<C$mysqli> &db, const string &query)
   affected_rows_ptr = &db->affected_rows;
   insert_id_ptr = &db->insert_id;
   query_result_ptr = &query_result;
+  raw_query_result_ptr = use_result ? &raw_query_result : nullptr;
   query_id_ptr = &query_id;
 
   field_cnt_ptr = &db->field_cnt;
   field_names_ptr = &db->field_names;
+  multi_query_ids_ptr = multi_query_ids;
+  multi_query_db_ptr = db.get();
 
   mysql_callback_state = 0;
   db_run_query(db->connection_id, real_query.c_str(), len, DB_TIMEOUT_MS, mysql_query_callback);
+  multi_query_ids_ptr = nullptr;
+  raw_query_result_ptr = nullptr;
   if (mysql_callback_state != 5 || !query_id) {
     return false;
   }
 
-  php_assert(db->biggest_query_id < 2000000000);
-  db->query_results[++db->biggest_query_id] = query_result;
-  db->cur_pos[db->biggest_query_id] = 0;
-
+  const int64_t result_id = use_result
+                            ? mysql_store_raw_result(db.get(), std::move(raw_query_result))
+                            : mysql_store_result(db.get(), std::move(query_result));
+  if (multi_query_ids != nullptr) {
+    multi_query_ids->push_back(result_id);
+  }
   return true;
 }
 
@@ -287,6 +340,27 @@ int64_t f$mysqli_affected_rows(const class_instance<C$mysqli> &db) {
   return db->affected_rows;
 }
 
+static Optional<array<mixed>> mysql_fetch_raw_row(int64_t query_id, const string &raw_query_result) {
+  int &cur = DB_Proxy->cur_pos[query_id];
+  const auto *packet = reinterpret_cast<const unsigned char *>(raw_query_result.c_str()) + cur;
+  const int left = static_cast<int>(raw_query_result.size()) - cur;
+  array<mixed> row;
+  const int len = left >= 4 ? packet[0] + (packet[1] << 8) + (packet[2] << 16) : 0;
+  const bool decoded = left >= len + 4 && len > 0 && mysql_decode_row(packet + 4, len, DB_Proxy->raw_query_field_names[query_id], row);
+  if (decoded) {
+    cur += len + 4;
+  }
+  // the raw rows are freed as soon as all of them are fetched
+  if (!decoded || cur >= static_cast<int>(raw_query_result.size())) {
+    DB_Proxy->raw_query_results.unset(query_id);
+    DB_Proxy->raw_query_field_names.unset(query_id);
+  }
+  if (!decoded) {
+    return Optional<array<mixed>>{};
+  }
+  return Optional<array<mixed>>{std::move(row)};
+}
+
 Optional<array<mixed>> f$mysqli_fetch_array(int64_t query_id, int64_t result_type) {
   if (result_type != 1) {
     php_warning("Only MYSQL_ASSOC result_type supported in mysqli_fetch_array");
@@ -295,6 +369,10 @@ Optional<array<mixed>> f$mysqli_fetch_array(int64_t query_id, int64_t result_typ
     return Optional<array<mixed>>{};
   }
 
+  if (auto *raw_query_result = DB_Proxy->raw_query_results.find_value(query_id)) {
+    return mysql_fetch_raw_row(query_id, *raw_query_result);
+  }
+
   array<array<mixed>> &query_result = DB_Proxy->query_results[query_id];
   int &cur = DB_Proxy->cur_pos[query_id];
   if (cur >= (int)query_result.count()) {
@@ -327,21 +405,58 @@ int64_t f$mysqli_num_rows(int64_t query_id) {
   if (DB_Proxy->connected < 0) {
     return 0;
   }
+  if (const string *raw_query_result = DB_Proxy->raw_query_results.find_value(static_cast<int64_t>(DB_Proxy->last_query_id))) {
+    // the rows left to be fetched are counted by their packet headers
+    const auto *rows = reinterpret_cast<const unsigned char *>(raw_query_result->c_str());
+    int64_t rows_count = 0;
+    for (size_t pos = DB_Proxy->cur_pos[static_cast<int64_t>(DB_Proxy->last_query_id)]; pos + 4 <= raw_query_result->size(); ++rows_count) {
+      pos += 4 + (rows[pos] + (rows[pos + 1] << 8) + (rows[pos + 2] << 16));
+    }
+    return rows_count;
+  }
   return DB_Proxy->query_results[static_cast<int64_t>(DB_Proxy->last_query_id)].count();
 }
 
-mixed f$mysqli_query(const class_instance<C$mysqli> &db, const string &query) {
+mixed f$mysqli_query(const class_instance<C$mysqli> &db, const string &query, int64_t result_mode) {
   if (db.is_null()) {
     php_warning("DB object is NULL in mysql_query");
     return false;
   }
-  bool query_id = mysql_query(db, query);
+  if (result_mode != MYSQLI_STORE_RESULT && result_mode != MYSQLI_USE_RESULT) {
+    php_warning("Unknown result_mode %" PRIi64 " in mysqli_query", result_mode);
+  }
+  bool query_id = mysql_query(db, query, result_mode == MYSQLI_USE_RESULT);
   if (!query_id) {
     return false;
   }
   return db->last_query_id = db->biggest_query_id;
 }
 
+array<int64_t> f$mysqli_multi_query(const class_instance<C$mysqli> &db, const array<string> &queries) {
+  array<int64_t> query_ids(array_size(queries.count(), 0, true));
+  if (db.is_null()) {
+    php_warning("DB object is NULL in mysqli_multi_query");
+    return query_ids;
+  }
+  if (queries.empty()) {
+    return query_ids;
+  }
+
+  // the statements are sent in one packet and answered by one result each, in the same order
+  string query;
+  for (const auto &it : queries) {
+    if (!query.empty()) {
+      query.push_back(';');
+    }
+    query.append(it.get_value());
+  }
+  mysql_query(db, query, false, &query_ids);
+  if (!query_ids.empty()) {
+    db->last_query_id = static_cast<int32_t>(query_ids.get_value(query_ids.count() - 1));
+  }
+  return query_ids;
+}
+
 class_instance<C$mysqli> f$mysqli_connect(const string &host __attribute__((unused)), const string &username __attribute__((unused)), const string &password __attribute__((unused)), const string &db_name __attribute__((unused)), int64_t port __attribute__((unused))) {
   // though this function is named like PHP's mysqli_connect(), it doesn't use provided credentials for connection
   // instead, they are embedded to and managed by db proxy
@@ -377,6 +492,9 @@ bool f$mysqli_select_db(const class_instance<C$mysqli> &db __attribute__((unused
 
 static void reset_mysql_global_vars() {
   hard_reset_var(DB_Proxy);
+  raw_query_result_ptr = nullptr;
+  multi_query_ids_ptr = nullptr;
+  multi_query_db_ptr = nullptr;
 }
 
 void init_mysql_lib() {
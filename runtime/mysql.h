@@ -19,6 +19,10 @@ public:
   int32_t affected_rows = 0;
   int32_t insert_id = 0;
   array<array<array<mixed>>> query_results;
+  // the rows of the MYSQLI_USE_RESULT queries are kept as the raw packets and decoded one by one by mysqli_fetch_array(),
+  // cur_pos is the offset of the next packet for them
+  array<string> raw_query_results;
+  array<array<string>> raw_query_field_names;
   array<int32_t> cur_pos;
   int32_t field_cnt = 0;
   array<string> field_names;
@@ -26,6 +30,8 @@ public:
   void accept(InstanceMemoryEstimateVisitor &visitor) {
     visitor("", error);
     visitor("", query_results);
+    visitor("", raw_query_results);
+    visitor("", raw_query_field_names);
     visitor("", last_query_id);
     visitor("", cur_pos);
     visitor("", field_names);
@@ -44,7 +50,12 @@ int64_t f$mysqli_insert_id(const class_instance<C$mysqli> &db);
 
 int64_t f$mysqli_num_rows(int64_t query_id);
 
-mixed f$mysqli_query(const class_instance<C$mysqli> &dn, const string &query);
+constexpr int64_t MYSQLI_STORE_RESULT = 0;
+constexpr int64_t MYSQLI_USE_RESULT = 1;
+
+mixed f$mysqli_query(const class_instance<C$mysqli> &dn, const string &query, int64_t result_mode = MYSQLI_STORE_RESULT);
+
+array<int64_t> f$mysqli_multi_query(const class_instance<C$mysqli> &db, const array<string> &queries);
 
 class_instance<C$mysqli> f$mysqli_connect(const string &host, const string &username, const string &password, const string &db_name, int64_t port);
 
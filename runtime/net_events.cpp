@@ -7,6 +7,7 @@
 #include "common/precise-time.h"
 
 #include "runtime/allocator.h"
+#include "runtime/curl.h"
 #include "runtime/rpc.h"
 #include "server/php-queries.h"
 
@@ -42,6 +43,8 @@ static bool process_net_event(net_event_t *e) {
     process_rpc_answer(e->slot_id, e->result, e->result_len);
   } else if (e->type == ne_rpc_error) {
     process_rpc_error(e->slot_id, e->error_code, e->error_message);
+  } else if (e->type == ne_curl_socket) {
+    process_curl_socket_event(e->curl_fd, e->curl_events);
   } else {
     php_critical_error ("unsupported net event %d", e->type);
   }
@@ -113,6 +116,12 @@ event_timer *allocate_event_timer(double wakeup_time, int wakeup_callback_id, in
   et->wakeup_extra = wakeup_extra;
   et->wakeup_time = wakeup_time;
 
+  if (unlikely(event_timers_heap == nullptr)) {
+    // most of the requests have no timers, so the heap is allocated on the first one
+    event_timers_max_heap_size = 1023;
+    event_timers_heap = static_cast <event_timer **> (dl::allocate(sizeof(event_timer *) * event_timers_max_heap_size));
+  }
+
   int i = ++event_timers_heap_size;
   if (i == event_timers_max_heap_size) {
     event_timers_heap = static_cast <event_timer **> (dl::reallocate(event_timers_heap, sizeof(event_timer *) * 2 * event_timers_max_heap_size, sizeof(event_timer *) * event_timers_max_heap_size));
@@ -192,8 +201,8 @@ int wait_net(int timeout_ms) {
 
 void init_net_events_lib() {
   event_timers_heap_size = 0;
-  event_timers_max_heap_size = 1023;
-  event_timers_heap = static_cast <event_timer **> (dl::allocate(sizeof(event_timer *) * event_timers_max_heap_size));
+  event_timers_max_heap_size = 0;
+  event_timers_heap = nullptr;
 
   update_precise_now();
 }
@@ -42,6 +42,8 @@ void OnKphpWarningCallback::invoke_callback(const string &warning_message) {
     }
 
     in_registered_callback = true;
+    // the callback is an arbitrary php code, it may keep what it allocates
+    const auto arena_suspension = make_script_arena_suspension();
     callback(warning_message, arg_stacktrace);
     in_registered_callback = false;
   }
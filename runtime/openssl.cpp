@@ -5,6 +5,7 @@
 #include "runtime/openssl.h"
 
 #include <cerrno>
+#include <deque>
 #include <memory>
 #include <netdb.h>
 #include <openssl/asn1.h>
@@ -20,13 +21,17 @@
 #include <poll.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <unordered_map>
 
 #include "common/crc32.h"
+#include "common/crc32c.h"
+#include "common/mixin/not_copyable.h"
 #include "common/resolver.h"
 #include "common/smart_ptrs/unique_ptr_with_delete_function.h"
 #include "common/wrappers/openssl.h"
 #include "common/wrappers/string_view.h"
 
+#include "runtime/allocator.h"
 #include "runtime/critical_section.h"
 #include "runtime/datetime.h"
 #include "runtime/files.h"
@@ -39,7 +44,9 @@ array<string> f$hash_algos() {
   return array<string>::create(
     string("sha1", 4),
     string("sha256", 6),
-    string("md5", 3));
+    string("md5", 3),
+    string("crc32b", 6),
+    string("crc32c", 6));
 }
 
 bool f$hash_equals(const string &known_string, const string &user_string) noexcept {
@@ -54,6 +61,21 @@ bool f$hash_equals(const string &known_string, const string &user_string) noexce
   return !result;
 }
 
+// crc32b and crc32c hashes are written as big endian numbers, as in php
+static string crc32_hash_result(uint32_t crc, bool raw_output) {
+  string res(raw_output ? 4 : 8, false);
+  for (int i = 3; i >= 0; i--) {
+    const unsigned char c = static_cast<unsigned char>(crc >> (8 * (3 - i)));
+    if (raw_output) {
+      res[i] = c;
+    } else {
+      res[2 * i + 1] = lhex_digits[c & 15];
+      res[2 * i] = lhex_digits[(c >> 4) & 15];
+    }
+  }
+  return res;
+}
+
 string f$hash(const string &algo, const string &s, bool raw_output) {
   if (!strcmp(algo.c_str(), "sha256")) {
     string res;
@@ -76,6 +98,10 @@ string f$hash(const string &algo, const string &s, bool raw_output) {
     return f$md5(s, raw_output);
   } else if (!strcmp(algo.c_str(), "sha1")) {
     return f$sha1(s, raw_output);
+  } else if (!strcmp(algo.c_str(), "crc32b")) {
+    return crc32_hash_result(compute_crc32(s.c_str(), s.size()), raw_output);
+  } else if (!strcmp(algo.c_str(), "crc32c")) {
+    return crc32_hash_result(compute_crc32c(s.c_str(), s.size()), raw_output);
   }
 
   php_critical_error ("algo %s not supported in function hash", algo.c_str());
@@ -311,11 +337,51 @@ private:
 static EVPKeyResourceStorage public_keys{';'};
 static EVPKeyResourceStorage private_keys{':'};
 
+// The keys parsed from PEM strings live in the heap and are reused by all the following requests,
+// as scripts usually pass the same PEM constants to openssl_sign(), openssl_verify() and others on every request
+class PersistentEVPKeyCache : vk::not_copyable {
+public:
+  EVP_PKEY *find(const string &pem) const noexcept {
+    auto it = cache_.find(vk::string_view{pem.c_str(), pem.size()});
+    return it != cache_.end() ? it->second : nullptr;
+  }
+
+  // returns false if the cache is full, then the key is still owned by the caller
+  bool add(const string &pem, EVP_PKEY *pkey) noexcept {
+    if (dl::is_malloc_replaced() || cache_.size() >= MAX_CACHED_KEYS || total_pems_length_ + pem.size() > MAX_TOTAL_PEMS_LENGTH) {
+      return false;
+    }
+    total_pems_length_ += pem.size();
+    pems_.emplace_back(pem.c_str(), pem.size());
+    cache_.emplace(vk::string_view{pems_.back()}, pkey);
+    return true;
+  }
+
+private:
+  static constexpr size_t MAX_CACHED_KEYS = 1024;
+  static constexpr size_t MAX_TOTAL_PEMS_LENGTH = 1024 * 1024;
+
+  // std::deque never moves its elements, so the string views stay valid
+  std::deque<std::string> pems_;
+  std::unordered_map<vk::string_view, EVP_PKEY *> cache_;
+  size_t total_pems_length_{0};
+};
+
+static PersistentEVPKeyCache persistent_public_keys;
+// the keys protected by a passphrase are not cached, so the passphrase is not kept in the memory
+static PersistentEVPKeyCache persistent_private_keys;
+
 static EVP_PKEY *openssl_get_private_evp(const string &key, const string &passphrase, bool &from_cache) {
   if (EVP_PKEY *evp_pkey = private_keys.find_resource(key)) {
     from_cache = true;
     return evp_pkey;
   }
+  if (passphrase.empty()) {
+    if (EVP_PKEY *evp_pkey = persistent_private_keys.find(key)) {
+      from_cache = true;
+      return evp_pkey;
+    }
+  }
 
   from_cache = false;
   EVP_PKEY *evp_pkey = nullptr;
@@ -328,6 +394,9 @@ static EVP_PKEY *openssl_get_private_evp(const string &key, const string &passph
     }
     BIO_free(in);
   }
+  if (evp_pkey && passphrase.empty()) {
+    from_cache = persistent_private_keys.add(key, evp_pkey);
+  }
   dl::leave_critical_section();
   return evp_pkey;
 }
@@ -337,6 +406,10 @@ static EVP_PKEY *openssl_get_public_evp(const string &key, bool &from_cache) {
     from_cache = true;
     return evp_pkey;
   }
+  if (EVP_PKEY *evp_pkey = persistent_public_keys.find(key)) {
+    from_cache = true;
+    return evp_pkey;
+  }
 
   from_cache = false;
   EVP_PKEY *evp_pkey = nullptr;
@@ -356,6 +429,9 @@ static EVP_PKEY *openssl_get_public_evp(const string &key, bool &from_cache) {
     evp_pkey = PEM_read_bio_PUBKEY(key_in, nullptr, nullptr, nullptr);
     BIO_free(key_in);
   }
+  if (evp_pkey) {
+    from_cache = persistent_public_keys.add(key, evp_pkey);
+  }
 
   dl::leave_critical_section();
   return evp_pkey;
@@ -468,8 +544,14 @@ Optional<string> f$openssl_pkey_get_private(const string &key, const string &pas
   Optional<string> result = false;
   dl::enter_critical_section(); // NOT OK: openssl_pkey
   bool from_cache = false;
-  if (EVP_PKEY *pkey = openssl_get_private_evp(key, passphrase, from_cache)) {
-    result = from_cache ? key : private_keys.register_resource(pkey);
+  if (private_keys.find_resource(key)) {
+    result = key;
+  } else if (EVP_PKEY *pkey = openssl_get_private_evp(key, passphrase, from_cache)) {
+    // the resources are freed at the end of the request, while a cached key must outlive it
+    if (from_cache) {
+      EVP_PKEY_up_ref(pkey);
+    }
+    result = private_keys.register_resource(pkey);
   } else {
     php_warning("Parameter key is not a valid key or passphrase is not a valid password");
   }
@@ -481,8 +563,13 @@ Optional<string> f$openssl_pkey_get_public(const string &key) {
   Optional<string> result = false;
   dl::enter_critical_section(); // NOT OK: openssl_pkey
   bool from_cache = false;
-  if (EVP_PKEY *pkey = openssl_get_public_evp(key, from_cache)) {
-    result = from_cache ? key : public_keys.register_resource(pkey);
+  if (public_keys.find_resource(key)) {
+    result = key;
+  } else if (EVP_PKEY *pkey = openssl_get_public_evp(key, from_cache)) {
+    if (from_cache) {
+      EVP_PKEY_up_ref(pkey);
+    }
+    result = public_keys.register_resource(pkey);
   } else {
     php_warning("Parameter key is not a valid key");
   }
@@ -624,11 +711,22 @@ Optional<string> f$openssl_random_pseudo_bytes(int64_t length) {
   if (length <= 0 || length > string::max_size()) {
     return false;
   }
-  string buffer(static_cast<string::size_type>(length), ' ');
-  struct timeval tv;
+  string buffer(static_cast<string::size_type>(length), false);
 
-  gettimeofday(&tv, nullptr);
-  RAND_add(&tv, sizeof(tv), 0.0);
+  // the forked workers share the generator state of the master, the pid and the time make them diverge;
+  // it is done once per worker, as RAND_add() reseeds the generator from the os entropy in the newer versions of openssl
+  static pid_t seeded_pid = 0;
+  const pid_t cur_pid = getpid();
+  if (seeded_pid != cur_pid) {
+    struct {
+      struct timeval tv;
+      pid_t pid;
+    } seed{};
+    gettimeofday(&seed.tv, nullptr);
+    seed.pid = cur_pid;
+    RAND_add(&seed, sizeof(seed), 0.0);
+    seeded_pid = cur_pid;
+  }
 
   if (RAND_bytes(reinterpret_cast<unsigned char *>(buffer.buffer()), static_cast<int32_t>(length)) <= 0) {
     return false;
@@ -1618,7 +1716,7 @@ struct CipherCtx {
       aead_ivlen_flag_ = EVP_CTRL_CCM_SET_IVLEN;
     }
 
-    ctx_ = EVP_CIPHER_CTX_new();
+    ctx_ = get_reusable_ctx();
     if (!ctx_) {
       php_warning("Failed to create cipher context");
     }
@@ -1734,12 +1832,21 @@ struct CipherCtx {
 
   ~CipherCtx() {
     if (ctx_) {
-      EVP_CIPHER_CTX_cleanup(ctx_);
-      EVP_CIPHER_CTX_free(ctx_);
+      // wipes the key and the state, but keeps the context allocated for the next call
+      EVP_CIPHER_CTX_reset(ctx_);
     }
   }
 
 private:
+  // the ciphers are never evaluated recursively, so a single context is enough for a worker
+  static EVP_CIPHER_CTX *get_reusable_ctx() {
+    static EVP_CIPHER_CTX *ctx = nullptr;
+    if (!ctx) {
+      ctx = EVP_CIPHER_CTX_new();
+    }
+    return ctx;
+  }
+
   bool align_iv(string &iv, size_t iv_required_len) {
     if (iv.size() == iv_required_len) {
       return true;
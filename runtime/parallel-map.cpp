@@ -0,0 +1,126 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/parallel-map.h"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "server/php-engine-vars.h"
+
+int64_t ParallelMapChildren::fork_children(int64_t count) noexcept {
+  php_assert(count <= MAX_CHILDREN);
+  // the server workers must not fork, there the requests are parallelized by the workers themselves
+  if (!run_once) {
+    return CANT_FORK;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  for (int64_t i = 0; i != count; ++i) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+      php_warning("Can't create a pipe for parallel_map: %s", strerror(errno));
+      break;
+    }
+    const pid_t pid = fork();
+    if (pid == -1) {
+      php_warning("Can't fork for parallel_map: %s", strerror(errno));
+      close(fds[0]);
+      close(fds[1]);
+      break;
+    }
+    if (pid == 0) {
+      close(fds[0]);
+      for (int64_t j = 0; j != children_count_; ++j) {
+        close(pipe_fds_[j]);
+      }
+      children_count_ = 0;
+      write_fd_ = fds[1];
+      return i;
+    }
+    close(fds[1]);
+    pipe_fds_[i] = fds[0];
+    pids_[i] = pid;
+    children_count_ = i + 1;
+  }
+
+  // the chunks of the children which weren't forked are mapped by the parent, as the ones of the failed children
+  return children_count_ ? PARENT : CANT_FORK;
+}
+
+void ParallelMapChildren::finish_child(const Optional<string> &result) noexcept {
+  int exit_code = 1;
+  if (result.has_value() && !result.val().empty()) {
+    const char *data = result.val().c_str();
+    size_t left = result.val().size();
+    while (left) {
+      const ssize_t written = write(write_fd_, data, left);
+      if (written == -1 && errno == EINTR) {
+        continue;
+      }
+      if (written <= 0) {
+        break;
+      }
+      data += written;
+      left -= written;
+    }
+    exit_code = left ? 1 : 0;
+  }
+  close(write_fd_);
+  // nothing of the parent must be flushed or destroyed by the child
+  _exit(exit_code);
+}
+
+array<string> ParallelMapChildren::wait_results() noexcept {
+  array<string> results(array_size(children_count_, 0, true));
+  struct pollfd fds[MAX_CHILDREN];
+  for (int64_t i = 0; i != children_count_; ++i) {
+    results.push_back(string{});
+    fds[i].fd = pipe_fds_[i];
+    fds[i].events = POLLIN;
+  }
+
+  // the children are read simultaneously, so a child never waits for the pipe while the parent reads another one
+  char buffer[64 * 1024];
+  for (int64_t open_pipes = children_count_; open_pipes;) {
+    if (poll(fds, children_count_, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      php_warning("poll failed in parallel_map: %s", strerror(errno));
+      break;
+    }
+    for (int64_t i = 0; i != children_count_; ++i) {
+      if (fds[i].fd == -1 || !fds[i].revents) {
+        continue;
+      }
+      const ssize_t read_bytes = read(fds[i].fd, buffer, sizeof(buffer));
+      if (read_bytes > 0) {
+        results[i].append(buffer, static_cast<string::size_type>(read_bytes));
+      } else if (read_bytes == 0 || errno != EINTR) {
+        close(fds[i].fd);
+        fds[i].fd = -1;
+        --open_pipes;
+      }
+    }
+  }
+
+  for (int64_t i = 0; i != children_count_; ++i) {
+    if (fds[i].fd != -1) {
+      close(fds[i].fd);
+    }
+    int status = 0;
+    while (waitpid(pids_[i], &status, 0) == -1 && errno == EINTR) {
+    }
+    // a result of a child, which failed after writing something, is incomplete
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      results[i] = string{};
+    }
+  }
+  children_count_ = 0;
+  return results;
+}
@@ -0,0 +1,91 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <algorithm>
+#include <sys/types.h>
+
+#include "common/mixin/not_copyable.h"
+
+#include "runtime/array_functions.h"
+#include "runtime/exception.h"
+#include "runtime/kphp_core.h"
+#include "runtime/msgpack-serialization.h"
+
+// Forks the children of parallel_map() and collects their results through the pipes.
+// Only the CLI mode can fork: the children share the script memory of the parent with copy-on-write.
+class ParallelMapChildren : vk::not_copyable {
+public:
+  static constexpr int64_t CANT_FORK = -2;
+  static constexpr int64_t PARENT = -1;
+  static constexpr int64_t MAX_CHILDREN = 256;
+
+  // returns the index of the child in a child process, PARENT in the parent process, or CANT_FORK
+  int64_t fork_children(int64_t count) noexcept;
+  // in a child: sends the result to the parent and exits, an empty result means the failure
+  [[noreturn]] void finish_child(const Optional<string> &result) noexcept;
+  // in the parent: waits for all the children, the results of the failed ones are empty
+  array<string> wait_results() noexcept;
+
+private:
+  int64_t children_count_{0};
+  int pipe_fds_[MAX_CHILDREN]{};
+  pid_t pids_[MAX_CHILDREN]{};
+  int write_fd_{-1};
+};
+
+// Maps the array by the callback in the forked children, each of them takes a contiguous chunk of the array.
+// The results are sent back with msgpack and assembled in the order of the array.
+// The callback must be pure: a chunk of a failed child is mapped once more by the parent,
+// and outside of the CLI mode everything is mapped by the parent as array_map() does.
+template<class T, class CallbackT, class R = typename std::result_of<std::decay_t<CallbackT>(T)>::type>
+array<R> f$parallel_map(const array<T> &a, const CallbackT &callback, int64_t processes = 4) {
+  const int64_t count = a.count();
+  const int64_t children_count = std::min({processes, count, ParallelMapChildren::MAX_CHILDREN});
+  ParallelMapChildren children;
+  const int64_t child = children_count > 1 ? children.fork_children(children_count) : ParallelMapChildren::CANT_FORK;
+  if (child == ParallelMapChildren::CANT_FORK) {
+    return f$array_map(callback, a);
+  }
+
+  auto map_chunk = [&a, &callback, count, children_count](int64_t chunk, array<R> &result) {
+    const int64_t begin = chunk * count / children_count;
+    const int64_t end = (chunk + 1) * count / children_count;
+    int64_t i = 0;
+    for (const auto &it : a) {
+      if (i >= begin) {
+        result.set_value(it.get_key(), callback(it.get_value()));
+        CHECK_EXCEPTION(return);
+      }
+      if (++i == end) {
+        break;
+      }
+    }
+  };
+
+  if (child != ParallelMapChildren::PARENT) {
+    array<R> part;
+    map_chunk(child, part);
+    children.finish_child(CurException.is_null() ? f$msgpack_serialize(part) : Optional<string>{});
+  }
+
+  const array<string> parts = children.wait_results();
+  array<R> result(a.size());
+  for (int64_t chunk = 0; chunk != children_count; ++chunk) {
+    string err_msg;
+    const string &packed_part = parts.get_value(chunk);
+    const auto part = packed_part.empty() ? array<R>{} : f$msgpack_deserialize<array<R>>(packed_part, &err_msg);
+    if (packed_part.empty() || !err_msg.empty()) {
+      php_warning("parallel_map child %ld failed, its chunk is mapped by the parent", chunk);
+      map_chunk(chunk, result);
+      CHECK_EXCEPTION(return result);
+      continue;
+    }
+    for (const auto &it : part) {
+      result.set_value(it.get_key(), it.get_value());
+    }
+  }
+  return result;
+}
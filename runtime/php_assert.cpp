@@ -5,6 +5,7 @@
 #include "runtime/php_assert.h"
 
 #include <algorithm>
+#include <cerrno>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
@@ -16,6 +17,7 @@
 #include <wait.h>
 
 #include "common/fast-backtrace.h"
+#include "common/php-functions.h"
 
 #include "runtime/critical_section.h"
 #include "runtime/datetime.h"
@@ -46,10 +48,116 @@ static bool is_address_inside_run_scheduler(void *address) {
 
 void write_json_error_to_log(int version, char *msg, int type, int nptrs, void** buffer);
 
+namespace {
+
+// a warning with its backtrace is collected here and written to stderr by a single write(),
+// instead of a syscall per fprintf of the unbuffered stderr
+char warning_record[16384];
+size_t warning_record_size = 0;
+
+void flush_warning_record() {
+  const char *data = warning_record;
+  while (warning_record_size > 0) {
+    const ssize_t written = write(2, data, warning_record_size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    data += written;
+    warning_record_size -= written;
+  }
+  warning_record_size = 0;
+}
+
+void append_to_warning_record(const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+
+void append_to_warning_record(const char *format, ...) {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    const size_t left = sizeof(warning_record) - warning_record_size;
+    va_list args;
+    va_start(args, format);
+    const int len = vsnprintf(warning_record + warning_record_size, left, format, args);
+    va_end(args);
+    if (len < 0) {
+      return;
+    }
+    if (static_cast<size_t>(len) < left) {
+      warning_record_size += len;
+      return;
+    }
+    if (attempt == 0 && warning_record_size > 0) {
+      flush_warning_record();
+      continue;
+    }
+    // a single line doesn't fit the whole buffer, it is truncated
+    warning_record_size = sizeof(warning_record) - 1;
+    warning_record[warning_record_size - 1] = '\n';
+    return;
+  }
+}
+
+// Limits the warnings of every call site (a format string or the text of the '%s'-formatted warning),
+// so that a single warning in a hot loop doesn't evict the other ones from the global limit
+class WarningCallsitesLimiter {
+public:
+  static constexpr int LIMIT_PER_PERIOD = 100;
+
+  bool should_skip(const char *format, const char *text) {
+    const uint64_t key = strcmp(format, "%s") == 0
+                         ? static_cast<uint64_t>(string_hash(text, strlen(text)))
+                         : reinterpret_cast<uintptr_t>(format);
+    for (size_t i = 0; i < CALLSITES_COUNT; ++i) {
+      Callsite &callsite = callsites_[(key + i) % CALLSITES_COUNT];
+      if (callsite.printed == 0) {
+        callsite.key = key;
+        snprintf(callsite.sample, sizeof(callsite.sample), "%s", text);
+      } else if (callsite.key != key) {
+        continue;
+      }
+      if (callsite.printed >= LIMIT_PER_PERIOD) {
+        ++callsite.skipped;
+        return true;
+      }
+      ++callsite.printed;
+      return false;
+    }
+    // too many different warnings, only the global limit is applied to them
+    return false;
+  }
+
+  void reset_period(int cur_time) {
+    for (Callsite &callsite : callsites_) {
+      if (callsite.skipped > 0) {
+        append_to_warning_record("[time=%d] Warning \"%s\" was suppressed %d times\n", cur_time, callsite.sample, callsite.skipped);
+      }
+      callsite = Callsite{};
+    }
+    flush_warning_record();
+  }
+
+private:
+  static constexpr size_t CALLSITES_COUNT = 256;
+
+  struct Callsite {
+    uint64_t key{0};
+    int printed{0};
+    int skipped{0};
+    char sample[128]{};
+  };
+
+  Callsite callsites_[CALLSITES_COUNT];
+};
+
+WarningCallsitesLimiter warning_callsites_limiter;
+
+} // namespace
+
 static void print_demangled_adresses(void **buffer, int nptrs, int num_shift, bool allow_gdb) {
   if (php_warning_level == 1) {
     for (int i = 0; i < nptrs; i++) {
-      fprintf(stderr, "%p\n", buffer[i]);
+      append_to_warning_record("%p\n", buffer[i]);
     }
   } else if (php_warning_level == 2) {
     KphpBacktrace demangler{buffer, nptrs};
@@ -57,13 +165,15 @@ static void print_demangled_adresses(void **buffer, int nptrs, int num_shift, bo
     auto demangled_range  = demangler.make_demangled_backtrace_range(true);
     for (const char *line : demangled_range) {
       if (line) {
-        fprintf(stderr, "(%d) %s", index++, line);
+        append_to_warning_record("(%d) %s", index++, line);
       }
     }
     if (index == num_shift) {
+      flush_warning_record();
       backtrace_symbols_fd(buffer, nptrs, 2);
     }
   } else if (php_warning_level == 3 && allow_gdb) {
+    flush_warning_record();
     char pid_buf[30];
     sprintf(pid_buf, "%d", getpid());
     char name_buf[512];
@@ -109,31 +219,37 @@ static void php_warning_impl(bool out_of_memory, int error_type, char const *mes
     warnings_printed = 0;
     warnings_count_time = cur_time;
     if (skipped > 0) {
-      fprintf(stderr, "[time=%d] Resuming writing warnings: %d skipped\n", (int)time(nullptr), skipped);
+      append_to_warning_record("[time=%d] Resuming writing warnings: %d skipped\n", (int)time(nullptr), skipped);
       skipped = 0;
     }
+    warning_callsites_limiter.reset_period(cur_time);
   }
 
-  if (++warnings_printed >= warnings_time_limit) {
-    if (warnings_printed == warnings_time_limit) {
-      fprintf(stderr, "[time=%d] Warnings limit reached. No more will be printed till %d\n", cur_time, warnings_count_time + warnings_time_period);
+  if (warnings_printed + 1 >= warnings_time_limit) {
+    if (++warnings_printed == warnings_time_limit) {
+      append_to_warning_record("[time=%d] Warnings limit reached. No more will be printed till %d\n", cur_time, warnings_count_time + warnings_time_period);
+      flush_warning_record();
     }
     ++skipped;
     return;
   }
 
+  vsnprintf(buf, BUF_SIZE, message, args);
+  if (warning_callsites_limiter.should_skip(message, buf)) {
+    return;
+  }
+  ++warnings_printed;
+
   const bool allocations_allowed = !out_of_memory && !dl::in_critical_section;
   dl::enter_critical_section();//OK
 
-  fprintf(stderr, "%s%d%sWarning: ", engine_tag, cur_time, engine_pid);
-  vsnprintf(buf, BUF_SIZE, message, args);
-  fprintf(stderr, "%s\n", buf);
+  append_to_warning_record("%s%d%sWarning: %s\n", engine_tag, cur_time, engine_pid, buf);
 
   bool need_stacktrace = php_warning_level >= 1;
   int nptrs = 0;
   void *buffer[64];
   if (need_stacktrace) {
-    fprintf(stderr, "------- Stack Backtrace -------\n");
+    append_to_warning_record("------- Stack Backtrace -------\n");
     nptrs = fast_backtrace(buffer, sizeof(buffer) / sizeof(buffer[0]));
     if (php_warning_level == 1) {
       nptrs -= 2;
@@ -153,8 +269,9 @@ static void php_warning_impl(bool out_of_memory, int error_type, char const *mes
       print_demangled_adresses(buffer + scheduler_id, nptrs - scheduler_id, scheduler_id + res_ptrs, false);
     }
 
-    fprintf(stderr, "-------------------------------\n\n");
+    append_to_warning_record("-------------------------------\n\n");
   }
+  flush_warning_record();
 
   dl::leave_critical_section();
   if (allocations_allowed) {
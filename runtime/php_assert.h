@@ -20,13 +20,14 @@ extern int php_disable_warnings;
 extern int php_warning_level;
 extern int php_warning_minimum_level;
 
-void php_notice(char const *message, ...) __attribute__ ((format (printf, 1, 2)));
-void php_warning(char const *message, ...) __attribute__ ((format (printf, 1, 2)));
-void php_error(char const *message, ...) __attribute__ ((format (printf, 1, 2)));
-void php_out_of_memory_warning(char const *message, ...) __attribute__ ((format (printf, 1, 2)));
-
-void php_assert__(const char *msg, const char *file, int line) __attribute__((noreturn));
-void raise_php_assert_signal__();
+// the errors are rare, so the branches calling them are laid out away from the hot code
+void php_notice(char const *message, ...) __attribute__ ((format (printf, 1, 2), cold));
+void php_warning(char const *message, ...) __attribute__ ((format (printf, 1, 2), cold));
+void php_error(char const *message, ...) __attribute__ ((format (printf, 1, 2), cold));
+void php_out_of_memory_warning(char const *message, ...) __attribute__ ((format (printf, 1, 2), cold));
+
+void php_assert__(const char *msg, const char *file, int line) __attribute__((noreturn, cold));
+void raise_php_assert_signal__() __attribute__((cold));
 
 #define php_assert(EX) do {                          \
   if (unlikely(!(EX))) {                             \
@@ -5,9 +5,12 @@
 #include "runtime/regexp.h"
 
 #include <cstddef>
+#include <deque>
 #include <re2/re2.h>
+#include <unordered_map>
 
 #include "common/containers/final_action.h"
+#include "common/wrappers/string_view.h"
 
 #include "runtime/critical_section.h"
 
@@ -21,6 +24,56 @@ static re2::StringPiece RE2_submatch[MAX_SUBPATTERNS];
 int32_t regexp::submatch[3 * MAX_SUBPATTERNS];
 pcre_extra regexp::extra;
 
+static bool pcre_jit_enabled = true;
+static RegexpExecStats regexp_exec_stats;
+
+static pcre_jit_stack *get_pcre_jit_stack() noexcept {
+  // the stack memory is private, therefore each worker has its own copy after the fork
+  static pcre_jit_stack *jit_stack = pcre_jit_stack_alloc(32 * 1024, 1024 * 1024);
+  return jit_stack;
+}
+
+namespace {
+
+// Non constant regexps are compiled in the heap memory, so they can be reused by subsequent requests
+// (constant ones are compiled once on the worker start, see const_regexp vars)
+class PersistentRegexpCache : vk::not_copyable {
+public:
+  static PersistentRegexpCache &get() noexcept {
+    static PersistentRegexpCache cache;
+    return cache;
+  }
+
+  const regexp *find(const string &regexp_string) const noexcept {
+    auto it = cache_.find(vk::string_view{regexp_string.c_str(), regexp_string.size()});
+    return it != cache_.end() ? it->second.get() : nullptr;
+  }
+
+  bool is_full() const noexcept {
+    return cache_.size() >= MAX_CACHED_REGEXPS || total_regexps_length_ >= MAX_TOTAL_REGEXPS_LENGTH;
+  }
+
+  const regexp *add(const string &regexp_string, std::unique_ptr<regexp> &&compiled) noexcept {
+    php_assert(!dl::is_malloc_replaced());
+    total_regexps_length_ += regexp_string.size();
+    keys_.emplace_back(regexp_string.c_str(), regexp_string.size());
+    return cache_.emplace(vk::string_view{keys_.back()}, std::move(compiled)).first->second.get();
+  }
+
+private:
+  PersistentRegexpCache() = default;
+
+  static constexpr size_t MAX_CACHED_REGEXPS = 8192;
+  static constexpr size_t MAX_TOTAL_REGEXPS_LENGTH = 4 * 1024 * 1024;
+
+  // std::deque never moves its elements, so the string views stay valid
+  std::deque<std::string> keys_;
+  std::unordered_map<vk::string_view, std::unique_ptr<regexp>> cache_;
+  size_t total_regexps_length_{0};
+};
+
+} // namespace
+
 
 regexp::regexp(const string &regexp_string) {
   init(regexp_string);
@@ -291,10 +344,29 @@ void regexp::init(const string &regexp_string, const char *function, const char
   static char regexp_cache_storage[sizeof(array<regexp *>)];
   static array<regexp *> *regexp_cache = (array<regexp *> *)regexp_cache_storage;
   static long long regexp_last_query_num = -1;
+  // the compiled regexps are cached till the end of the request
+  const auto arena_suspension = make_script_arena_suspension();
 
   use_heap_memory = (dl::get_script_memory_stats().memory_limit == 0);
 
   if (!use_heap_memory) {
+    auto &persistent_regexp_cache = PersistentRegexpCache::get();
+    if (const regexp *cached = persistent_regexp_cache.find(regexp_string)) {
+      init_from_cached(*cached);
+      return;
+    }
+    if (!persistent_regexp_cache.is_full()) {
+      auto compiled = std::make_unique<regexp>();
+      // it must be compiled in the heap memory as it outlives the script
+      compiled->use_heap_memory = true;
+      compiled->init(regexp_string.c_str(), regexp_string.size(), function, file);
+      // failed regexps are not shared, so the compilation warning is reported once per request as before
+      if (compiled->pcre_regexp || compiled->RE2_regexp) {
+        init_from_cached(*persistent_regexp_cache.add(regexp_string, std::move(compiled)));
+      }
+      return;
+    }
+
     if (dl::query_num != regexp_last_query_num) {
       new(regexp_cache_storage) array<regexp *>();
       regexp_last_query_num = dl::query_num;
@@ -389,7 +461,8 @@ void regexp::init(const char *regexp_string, int64_t regexp_len, const char *fun
 
   static_SB.clean().append(regexp_string + 1, static_cast<size_t>(regexp_end - 1));
 
-  use_heap_memory = (dl::get_script_memory_stats().memory_limit == 0);
+  // regexps from the persistent cache are compiled in the heap memory even while the script is running
+  use_heap_memory = use_heap_memory || (dl::get_script_memory_stats().memory_limit == 0);
 
   auto malloc_replacement_guard = make_malloc_replacement_with_script_allocator(!use_heap_memory);
 
@@ -496,6 +569,9 @@ void regexp::init(const char *regexp_string, int64_t regexp_len, const char *fun
   }
 
   //compile has finished
+  if (pcre_regexp) {
+    pcre_jit_compile();
+  }
 
   named_subpatterns_count = 0;
   if (RE2_regexp) {
@@ -517,7 +593,13 @@ void regexp::init(const char *regexp_string, int64_t regexp_len, const char *fun
 
         for (int64_t i = 0; i < named_subpatterns_count; i++) {
           int64_t name_id = (((unsigned char)name_table[0]) << 8) + (unsigned char)name_table[1];
-          string name(name_table + 2);
+          string name;
+          {
+            // the names of the regexp compiled in the heap memory must outlive the script as well
+            auto heap_replacement_guard = make_script_allocator_replacement_with_heap(
+              use_heap_memory && !dl::is_script_allocator_replaced_with_heap());
+            name = string(name_table + 2);
+          }
 
           if (use_heap_memory) {
             name.set_reference_counter_to(ExtraRefCnt::for_global_const);
@@ -549,9 +631,51 @@ void regexp::init(const char *regexp_string, int64_t regexp_len, const char *fun
   }
 }
 
+void regexp::pcre_jit_compile() noexcept {
+  // the JIT code and the study data outlive the script, so only the regexps compiled in the heap memory are JITted
+  if (!pcre_jit_enabled || !use_heap_memory) {
+    return;
+  }
+  php_assert(!dl::is_malloc_replaced());
+
+  const char *error = nullptr;
+  pcre_extra *study_extra = pcre_study(pcre_regexp, PCRE_STUDY_JIT_COMPILE, &error);
+  int32_t is_jit_compiled = 0;
+  if (!study_extra || pcre_fullinfo(pcre_regexp, study_extra, PCRE_INFO_JIT, &is_jit_compiled) != 0 || !is_jit_compiled) {
+    if (study_extra) {
+      pcre_free_study(study_extra);
+    }
+    return;
+  }
+
+  study_extra->flags |= PCRE_EXTRA_MATCH_LIMIT | PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+  study_extra->match_limit = extra.match_limit;
+  study_extra->match_limit_recursion = extra.match_limit_recursion;
+  if (pcre_jit_stack *jit_stack = get_pcre_jit_stack()) {
+    pcre_assign_jit_stack(study_extra, nullptr, jit_stack);
+  }
+  pcre_jit_extra = study_extra;
+}
+
+void regexp::init_from_cached(const regexp &cached) noexcept {
+  subpatterns_count = cached.subpatterns_count;
+  named_subpatterns_count = cached.named_subpatterns_count;
+  is_utf8 = cached.is_utf8;
+  use_heap_memory = cached.use_heap_memory;
+  is_persistent_cache_copy = true;
+
+  subpattern_names = cached.subpattern_names;
+
+  pcre_regexp = cached.pcre_regexp;
+  pcre_jit_extra = cached.pcre_jit_extra;
+  RE2_regexp = cached.RE2_regexp;
+
+  regex_compilation_warning = cached.regex_compilation_warning;
+}
+
 void regexp::clean() {
-  if (!use_heap_memory) {
-    // Regexp is stored inside a static cache, see regexp_cache_storage
+  if (!use_heap_memory || is_persistent_cache_copy) {
+    // Regexp is stored inside a static cache, see regexp_cache_storage and PersistentRegexpCache
     return;
   }
 
@@ -562,6 +686,11 @@ void regexp::clean() {
   is_utf8 = false;
   use_heap_memory = false;
 
+  if (pcre_jit_extra != nullptr) {
+    pcre_free_study(pcre_jit_extra);
+    pcre_jit_extra = nullptr;
+  }
+
   if (pcre_regexp != nullptr) {
     pcre_free(pcre_regexp);
     pcre_regexp = nullptr;
@@ -576,7 +705,9 @@ void regexp::clean() {
 
 regexp::~regexp() {
   clean();
-  free(regex_compilation_warning);
+  if (!is_persistent_cache_copy) {
+    free(regex_compilation_warning);
+  }
 }
 
 
@@ -588,6 +719,7 @@ int64_t regexp::exec(const string &subject, int64_t offset, bool second_try) con
       dl::CriticalSectionGuard critical_section;
       auto malloc_replacement_guard = make_malloc_replacement_with_script_allocator(!use_heap_memory);
 
+      ++regexp_exec_stats.re2_executions;
       re2::StringPiece text(subject.c_str(), subject.size());
       bool matched = RE2_regexp->Match(text, static_cast<int32_t>(offset), subject.size(), RE2::UNANCHORED, RE2_submatch, subpatterns_count);
       if (!matched) {
@@ -614,8 +746,13 @@ int64_t regexp::exec(const string &subject, int64_t offset, bool second_try) con
   php_assert (pcre_regexp);
 
   int32_t options = second_try ? PCRE_NO_UTF8_CHECK | PCRE_NOTEMPTY_ATSTART : PCRE_NO_UTF8_CHECK;
+  if (pcre_jit_extra) {
+    ++regexp_exec_stats.pcre_jit_executions;
+  } else {
+    ++regexp_exec_stats.pcre_interpreted_executions;
+  }
   dl::enter_critical_section();//OK
-  int64_t count = pcre_exec(pcre_regexp, &extra, subject.c_str(), subject.size(),
+  int64_t count = pcre_exec(pcre_regexp, pcre_jit_extra ? pcre_jit_extra : &extra, subject.c_str(), subject.size(),
                             static_cast<int32_t>(offset), options, submatch, 3 * subpatterns_count);
   dl::leave_critical_section();
 
@@ -979,7 +1116,8 @@ Optional<array<mixed>> regexp::split(const string &subject, int64_t limit, int64
   }
 
   if (last_match < int64_t{subject.size()} || !no_empty) {
-    string match_str(subject.c_str() + last_match, static_cast<string::size_type>(subject.size() - last_match));
+    // shares the subject if nothing was split off
+    string match_str = subject.substr(static_cast<string::size_type>(last_match), static_cast<string::size_type>(subject.size() - last_match));
 
     if (offset_capture) {
       result.push_back(array<mixed>::create(match_str, last_match));
@@ -1005,6 +1143,8 @@ int64_t regexp::last_error() {
       return PHP_PCRE_RECURSION_LIMIT_ERROR;
     case PCRE_ERROR_BADUTF8:
       return PHP_PCRE_BAD_UTF8_ERROR;
+    case PCRE_ERROR_JIT_STACKLIMIT:
+      return PHP_PCRE_JIT_STACKLIMIT_ERROR;
     default:
       php_assert (0);
       exit(1);
@@ -1070,3 +1210,11 @@ void global_init_regexp_lib() {
   regexp::global_init();
 }
 
+void set_pcre_jit_enabled(bool enabled) noexcept {
+  pcre_jit_enabled = enabled;
+}
+
+const RegexpExecStats &regexp_get_exec_stats() noexcept {
+  return regexp_exec_stats;
+}
+
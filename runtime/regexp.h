@@ -38,6 +38,14 @@ enum {
   PHP_PCRE_BACKTRACK_LIMIT_ERROR,
   PHP_PCRE_RECURSION_LIMIT_ERROR,
   PHP_PCRE_BAD_UTF8_ERROR,
+  PHP_PCRE_BAD_UTF8_OFFSET_ERROR,
+  PHP_PCRE_JIT_STACKLIMIT_ERROR,
+};
+
+struct RegexpExecStats {
+  uint64_t pcre_jit_executions{0};
+  uint64_t pcre_interpreted_executions{0};
+  uint64_t re2_executions{0};
 };
 
 class regexp : vk::not_copyable {
@@ -46,16 +54,22 @@ private:
   int32_t named_subpatterns_count{0};
   bool is_utf8{false};
   bool use_heap_memory{false};
+  // the compiled data is owned by the regexp shared between requests, see persistent_regexp_cache
+  bool is_persistent_cache_copy{false};
 
   string *subpattern_names{nullptr};
 
   pcre *pcre_regexp{nullptr};
+  // is set only for the regexps compiled in the heap memory, if they were compiled by PCRE JIT successfully
+  pcre_extra *pcre_jit_extra{nullptr};
   re2::RE2 *RE2_regexp{nullptr};
 
   char *regex_compilation_warning{nullptr};
 
   void clean();
 
+  void init_from_cached(const regexp &cached) noexcept;
+
   int64_t exec(const string &subject, int64_t offset, bool second_try) const;
 
   bool is_valid_RE2_regexp(const char *regexp_string, int64_t regexp_len, bool is_utf8, const char *function, const char *file) noexcept;
@@ -73,6 +87,8 @@ private:
 
   void check_pattern_compilation_warning() const noexcept;
 
+  void pcre_jit_compile() noexcept;
+
 public:
   regexp() = default;
 
@@ -102,6 +118,10 @@ public:
 
 void global_init_regexp_lib();
 
+// these function should be called before the workers start
+void set_pcre_jit_enabled(bool enabled) noexcept;
+const RegexpExecStats &regexp_get_exec_stats() noexcept;
+
 inline void preg_add_match(array<mixed> &v, const mixed &match, const string &name);
 inline void preg_add_match(array<string> &v, const string &match, const string &name);
 
@@ -8,6 +8,7 @@
 
 #include "common/kprintf.h"
 
+#include "runtime/memory_resource/details/memory_chunk_list.h"
 #include "runtime/net_events.h"
 
 bool resumable_finished;
@@ -21,6 +22,54 @@ void debug_print_resumables();
 Storage *Resumable::input_;
 Storage *Resumable::output_;
 
+namespace {
+
+// The freed resumable frames, a list per 8 byte size class.
+// Forks and waits create and destroy frames of the same few generated classes over and over again,
+// so a frame is reused without a trip through the script allocator and its bookkeeping.
+class ResumableFramePool {
+public:
+  void *allocate(size_t size) noexcept {
+    const size_t aligned_size = memory_resource::details::align_for_chunk(size);
+    if (aligned_size <= MAX_POOLED_FRAME_SIZE) {
+      if (void *mem = free_frames_[memory_resource::details::get_chunk_id(aligned_size)].get_mem()) {
+        return mem;
+      }
+    }
+    return dl::allocate(aligned_size);
+  }
+
+  void deallocate(void *mem, size_t size) noexcept {
+    const size_t aligned_size = memory_resource::details::align_for_chunk(size);
+    if (aligned_size <= MAX_POOLED_FRAME_SIZE) {
+      free_frames_[memory_resource::details::get_chunk_id(aligned_size)].put_mem(mem);
+    } else {
+      dl::deallocate(mem, aligned_size);
+    }
+  }
+
+  // the pooled frames belong to the script memory, which is reset between the requests
+  void reset() noexcept {
+    free_frames_.fill(memory_resource::details::memory_chunk_list{});
+  }
+
+private:
+  static constexpr size_t MAX_POOLED_FRAME_SIZE{1024};
+  std::array<memory_resource::details::memory_chunk_list, memory_resource::details::get_chunk_id(MAX_POOLED_FRAME_SIZE) + 1> free_frames_;
+};
+
+ResumableFramePool resumable_frame_pool;
+
+} // namespace
+
+void *Resumable::operator new(size_t size) noexcept {
+  return resumable_frame_pool.allocate(size);
+}
+
+void Resumable::operator delete(void *ptr, size_t size) noexcept {
+  resumable_frame_pool.deallocate(ptr, size);
+}
+
 Resumable::Resumable() :
   pos__(nullptr) {
 }
@@ -73,6 +122,8 @@ struct forked_resumable_info {
   int64_t son;
   const char *name;
   double running_time;
+  int64_t priority;// the ready resumables of the forks with a higher priority are resumed first, 0 by default
+  int64_t parent_fork_id;// the fork which was running when this one was created, 0 for the main thread
 };
 
 struct started_resumable_info {
@@ -118,6 +169,18 @@ static uint32_t yielded_resumables_l;
 static uint32_t yielded_resumables_r;
 static uint32_t yielded_resumables_size;
 
+// while no fork has got a priority, the scheduler keeps the plain order and doesn't look at the priorities at all
+static bool has_prioritized_forks;
+// a ready resumable can be bypassed by the higher priority ones at most this many times in a row
+static constexpr uint32_t MAX_PRIORITY_PICKS_IN_ROW = 16;
+static uint32_t priority_picks_in_row;
+
+static struct {
+  int64_t scheduled;
+  int64_t scheduled_by_priority;
+  int64_t scheduled_against_starvation;
+} scheduler_stats;
+
 bool in_main_thread() {
   return runned_resumable_id == 0;
 }
@@ -198,6 +261,8 @@ int64_t register_forked_resumable(Resumable *resumable) {
   res->queue_id = 0;
   res->son = 0;
   res->running_time = 0;
+  res->priority = 0;
+  res->parent_fork_id = f$get_running_fork_id();
   res->name = resumable ? typeid(*resumable).name() : "(null)";
 
   return res_id;
@@ -233,6 +298,39 @@ int64_t f$get_running_fork_id() {
   return 0;
 }
 
+bool f$set_fork_priority(int64_t fork_id, int64_t priority) {
+  if (!is_forked_resumable_id(fork_id)) {
+    php_warning("Wrong fork id %ld in function set_fork_priority", fork_id);
+    return false;
+  }
+  forked_resumable_info *info = get_forked_resumable_info(fork_id);
+  if (info->queue_id < 0) {
+    return false;
+  }
+  info->priority = priority;
+  has_prioritized_forks |= priority != 0;
+  return true;
+}
+
+bool is_fork_in_scope(int64_t fork_id, int64_t scope_fork_id) {
+  if (!is_forked_resumable_id(fork_id) || !is_forked_resumable_id(scope_fork_id)) {
+    return false;
+  }
+  // a parent is always created before its sons, so the walk goes strictly down
+  while (fork_id > scope_fork_id && is_forked_resumable_id(fork_id)) {
+    fork_id = get_forked_resumable_info(fork_id)->parent_fork_id;
+  }
+  return fork_id == scope_fork_id;
+}
+
+array<int64_t> f$get_fork_scheduler_stats() {
+  array<int64_t> result(array_size(0, 3, false));
+  result.set_value(string("scheduled"), scheduler_stats.scheduled);
+  result.set_value(string("scheduled_by_priority"), scheduler_stats.scheduled_by_priority);
+  result.set_value(string("scheduled_against_starvation"), scheduler_stats.scheduled_against_starvation);
+  return result;
+}
+
 Optional<array<mixed>> f$get_fork_stat(int64_t fork_id) {
   auto info = get_forked_resumable_info(fork_id);
   if (!info) {
@@ -257,6 +355,7 @@ Optional<array<mixed>> f$get_fork_stat(int64_t fork_id) {
     running_time += get_precise_now();
   }
   result.set_value(string("work_time"), running_time);
+  result.set_value(string("priority"), info->priority);
   return result;
 }
 
@@ -411,6 +510,43 @@ static bool resumable_has_finished() {
   return finished_resumables_count > 0 || yielded_resumables_l != yielded_resumables_r;
 }
 
+static int64_t get_started_resumable_priority(int64_t resumable_id) {
+  const int64_t fork_id = get_started_resumable_info(resumable_id)->fork_id;
+  return fork_id ? get_forked_resumable_info(fork_id)->priority : 0;
+}
+
+// moves the resumable with the highest priority to the position the scheduler takes the next one from
+template<typename PositionToId>
+static void reorder_by_priority(uint32_t positions_count, const PositionToId &position_to_id) {
+  ++scheduler_stats.scheduled;
+  if (!has_prioritized_forks || positions_count < 2) {
+    return;
+  }
+  if (priority_picks_in_row >= MAX_PRIORITY_PICKS_IN_ROW) {
+    priority_picks_in_row = 0;
+    ++scheduler_stats.scheduled_against_starvation;
+    return;
+  }
+  int64_t &next_id = position_to_id(0);
+  int64_t *best_id = &next_id;
+  int64_t best_priority = get_started_resumable_priority(next_id);
+  for (uint32_t i = 1; i < positions_count; i++) {
+    int64_t &id = position_to_id(i);
+    const int64_t priority = get_started_resumable_priority(id);
+    if (priority > best_priority) {
+      best_priority = priority;
+      best_id = &id;
+    }
+  }
+  if (best_id == &next_id) {
+    priority_picks_in_row = 0;
+    return;
+  }
+  std::swap(next_id, *best_id);
+  ++priority_picks_in_row;
+  ++scheduler_stats.scheduled_by_priority;
+}
+
 static void yielded_resumables_push(int64_t id) {
   yielded_resumables[yielded_resumables_r] = id;
   yielded_resumables_r++;
@@ -455,9 +591,16 @@ static void resumable_add_finished(int64_t resumable_id) {
 static void resumable_get_finished(int64_t *resumable_id, bool *is_yielded) {
   php_assert (resumable_has_finished());
   if (finished_resumables_count) {
+    reorder_by_priority(finished_resumables_count, [](uint32_t position) -> int64_t & {
+      return finished_resumables[finished_resumables_count - 1 - position];
+    });
     *resumable_id = finished_resumables[--finished_resumables_count];
     *is_yielded = false;
   } else {
+    const uint32_t yielded_count = (yielded_resumables_r + yielded_resumables_size - yielded_resumables_l) % yielded_resumables_size;
+    reorder_by_priority(yielded_count, [](uint32_t position) -> int64_t & {
+      return yielded_resumables[(yielded_resumables_l + position) % yielded_resumables_size];
+    });
     *resumable_id = yielded_resumables_pop();
     *is_yielded = true;
   }
@@ -987,6 +1130,34 @@ bool f$wait_queue_empty(int64_t queue_id) {
   return q->left_functions == 0 && q->first_finished_function == -2;
 }
 
+array<int64_t> f$wait_queue_next_batch(int64_t queue_id, int64_t limit) {
+  if (!is_wait_queue_id(queue_id)) {
+    if (queue_id != -1) {
+      php_warning("Wrong queue_id %ld in function wait_queue_next_batch", queue_id);
+    }
+    return {};
+  }
+
+  wait_queue *q = get_wait_queue(queue_id);
+  wait_queue_skip_gotten(q);
+  array<int64_t> result;
+  // walk the list of the finished functions, unlinking the ones whose results have been already gotten
+  int64_t *link = &q->first_finished_function;
+  while (*link != -2 && result.count() < limit) {
+    const int64_t resumable_id = -*link;
+    forked_resumable_info *resumable = get_forked_resumable_info(resumable_id);
+    if (resumable->output.tag == 0) {
+      *link = resumable->queue_id;
+      resumable->queue_id = -1;
+      php_assert (*link != -1);
+      continue;
+    }
+    result.push_back(resumable_id);
+    link = &resumable->queue_id;
+  }
+  return result;
+}
+
 static void wait_queue_next(int64_t queue_id, double timeout) {
   php_assert (timeout > get_precise_now());//TODO remove asserts
   php_assert (in_main_thread());//TODO remove asserts
@@ -1210,7 +1381,11 @@ void init_resumable_lib() {
   php_assert (wait_timeout_wakeup_id != -1);
   php_assert (wait_queue_timeout_wakeup_id != -1);
 
+  resumable_frame_pool.reset();
   resumable_finished = true;
+  has_prioritized_forks = false;
+  priority_picks_in_row = 0;
+  scheduler_stats = {};
 
   runned_resumable_id = 0;
   Resumable::update_output();
@@ -1249,6 +1424,8 @@ void init_resumable_lib() {
   new(&gotten_forked_resumable_info.output) Storage;
   gotten_forked_resumable_info.queue_id = -1;
   gotten_forked_resumable_info.continuation = nullptr;
+  gotten_forked_resumable_info.priority = 0;
+  gotten_forked_resumable_info.parent_fork_id = 0;
 }
 
 int32_t get_resumable_stack(void **buffer, int32_t limit) {
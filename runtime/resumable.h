@@ -55,6 +55,12 @@ protected:
   virtual bool run() = 0;
 
 public:
+  using ManagedThroughDlAllocator::operator new;
+
+  // the frames are taken from the per size free lists, that are dropped at the request end with the script memory
+  static void *operator new(size_t size) noexcept;
+  static void operator delete(void *ptr, size_t size) noexcept;
+
   Resumable();
 
   virtual ~Resumable();
@@ -132,6 +138,8 @@ bool f$wait_queue_empty(int64_t queue_id);
 Optional<int64_t> f$wait_queue_next(int64_t queue_id, double timeout = -1.0);
 Optional<int64_t> wait_queue_next_synchronously(int64_t queue_id);
 Optional<int64_t> f$wait_queue_next_synchronously(int64_t queue_id);
+// the already finished functions of the queue, at most limit of them; they stay in the queue until their results are gotten
+array<int64_t> f$wait_queue_next_batch(int64_t queue_id, int64_t limit);
 
 void global_init_resumable_lib();
 
@@ -139,6 +147,11 @@ void init_resumable_lib();
 
 int64_t f$get_running_fork_id();
 Optional<array<mixed>> f$get_fork_stat(int64_t fork_id);
+bool f$set_fork_priority(int64_t fork_id, int64_t priority);
+array<int64_t> f$get_fork_scheduler_stats();
+
+// is fork_id the scope_fork_id itself or was it forked (transitively) from it
+bool is_fork_in_scope(int64_t fork_id, int64_t scope_fork_id);
 
 /*
  *
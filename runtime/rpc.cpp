@@ -5,7 +5,9 @@
 #include "runtime/rpc.h"
 
 #include <cstdarg>
+#include <limits>
 
+#include "common/precise-time.h"
 #include "common/rpc-error-codes.h"
 #include "common/tl/constants/common.h"
 
@@ -23,6 +25,8 @@
 #include "runtime/tl/tl_builtins.h"
 #include "runtime/zlib.h"
 #include "server/php-queries.h"
+#include "server/php-queries-stats.h"
+#include "server/php-tracing.h"
 
 static const int GZIP_PACKED = 0x3072cfa1;
 
@@ -349,6 +353,30 @@ void f$fetch_raw_vector_double(array<double> &out, int64_t n_elems) {
   rpc_data += rpc_data_buf_offset;
 }
 
+void fetch_raw_vector_long(array<int64_t> &out, int64_t n_elems) {
+  static_assert(sizeof(int64_t) == sizeof(long long), "tl long is stored as is");
+  int64_t rpc_data_buf_offset = static_cast<int64_t>(sizeof(int64_t) * n_elems / 4);
+  TRY_CALL_VOID(void, (check_rpc_data_len(rpc_data_buf_offset)));
+  out.memcpy_vector(n_elems, rpc_data);
+  rpc_data += rpc_data_buf_offset;
+}
+
+void fetch_raw_vector_int(array<int64_t> &out, int64_t n_elems) {
+  TRY_CALL_VOID(void, (check_rpc_data_len(n_elems)));
+  for (int64_t i = 0; i < n_elems; ++i) {
+    out.push_back(rpc_data[i]);
+  }
+  rpc_data += n_elems;
+}
+
+const int32_t *rpc_fetch_raw_words(int64_t n_words) {
+  CHECK_EXCEPTION(return nullptr);
+  TRY_CALL_VOID_(check_rpc_data_len(n_words), return nullptr);
+  const int32_t *words = rpc_data;
+  rpc_data += n_words;
+  return words;
+}
+
 static inline const char *f$fetch_string_raw(int *string_len) {
   TRY_CALL_VOID_(check_rpc_data_len(1), return nullptr);
   const char *str = reinterpret_cast <const char *> (rpc_data);
@@ -508,6 +536,15 @@ void f$store_raw_vector_double(const array<double> &vector) {
                   sizeof(double) * vector.count());
 }
 
+void store_raw_vector_long(const array<int64_t> &vector) {
+  data_buf.append(reinterpret_cast<const char *>(vector.get_const_vector_pointer()),
+                  sizeof(int64_t) * vector.count());
+}
+
+void store_raw_words(const int32_t *words, int64_t n_words) {
+  data_buf.append(reinterpret_cast<const char *>(words), sizeof(int32_t) * n_words);
+}
+
 bool store_header(long long cluster_id, int64_t flags) {
   if (flags) {
     store_int(TL_RPC_DEST_ACTOR_FLAGS);
@@ -730,6 +767,7 @@ static slot_id_t rpc_first_unfinished_request_id;
 static rpc_request gotten_rpc_request;
 
 static int timeout_wakeup_id = -1;
+static int hedge_wakeup_id = -1;
 
 static inline rpc_request *get_rpc_request(slot_id_t request_id) {
   php_assert (rpc_first_request_id <= request_id && request_id < rpc_next_request_id);
@@ -810,9 +848,257 @@ static void process_rpc_timeout(int request_id) {
 }
 
 static void process_rpc_timeout(event_timer *timer) {
+  Tracing::get().finish_span(Tracing::SpanKind::rpc, timer->wakeup_extra, TL_ERROR_QUERY_TIMEOUT, 0, get_utime_monotonic());
   return process_rpc_timeout(timer->wakeup_extra);
 }
 
+static rpc_request *register_rpc_request(slot_id_t result) {
+  if (dl::query_num != rpc_requests_last_query_num) {
+    rpc_requests_last_query_num = dl::query_num;
+    rpc_requests_size = 170;
+    rpc_requests = static_cast<rpc_request *>(dl::allocate(sizeof(rpc_request) * rpc_requests_size));
+
+    rpc_first_request_id = result;
+    rpc_first_array_request_id = result;
+    rpc_next_request_id = result + 1;
+    rpc_first_unfinished_request_id = result;
+    gotten_rpc_request.resumable_id = -3;
+    gotten_rpc_request.answer = nullptr;
+  } else {
+    php_assert (rpc_next_request_id == result);
+    rpc_next_request_id++;
+  }
+
+  if (result - rpc_first_array_request_id >= rpc_requests_size) {
+    php_assert (result - rpc_first_array_request_id == rpc_requests_size);
+    if (rpc_first_unfinished_request_id > rpc_first_array_request_id + rpc_requests_size / 2) {
+      memcpy(rpc_requests,
+             rpc_requests + rpc_first_unfinished_request_id - rpc_first_array_request_id,
+             sizeof(rpc_request) * (rpc_requests_size - (rpc_first_unfinished_request_id - rpc_first_array_request_id)));
+      rpc_first_array_request_id = rpc_first_unfinished_request_id;
+    } else {
+      rpc_requests = static_cast <rpc_request *> (dl::reallocate(rpc_requests, sizeof(rpc_request) * 2 * rpc_requests_size, sizeof(rpc_request) * rpc_requests_size));
+      rpc_requests_size *= 2;
+    }
+  }
+
+  return get_rpc_request(result);
+}
+
+struct rpc_hedge {
+  int32_t host_num;
+  int32_t backup_host_num;
+  int32_t hedge_request_id;// 0 until the duplicate is sent
+  int32_t timeout_ms;
+  char *request;
+  int32_t request_size;
+  double send_time;
+  double min_delay;
+  double percentile;
+  event_timer *timer;
+};
+
+// queries sent to the connections with hedging enabled, by request id
+static array<rpc_hedge> rpc_hedges;
+// request id of a duplicate -> request id of the original query
+static array<int64_t> rpc_hedge_origins;
+
+struct rpc_host_hedge_stat {
+  double latency_estimate;
+  uint64_t queries;
+  uint64_t hedged;
+  uint64_t won;
+};
+
+// lives between the script runs, indexed by host_num, the limit matches the number of the engine connection targets
+static constexpr int32_t RPC_MAX_HEDGED_HOSTS = 65536;
+static rpc_host_hedge_stat rpc_host_hedge_stats[RPC_MAX_HEDGED_HOSTS];
+
+static void update_latency_estimate(int32_t host_num, double latency, double percentile) {
+  double &estimate = rpc_host_hedge_stats[host_num].latency_estimate;
+  if (estimate <= 0) {
+    estimate = latency;
+    return;
+  }
+  // stochastic approximation of the percentile: it settles where P(latency > estimate) == 1 - percentile
+  const double step = 0.05 * estimate;
+  estimate += latency > estimate ? step * percentile : -step * (1 - percentile);
+}
+
+static void arm_rpc_hedge(int32_t request_id, double timeout) {
+  rpc_hedge &hedge = rpc_hedges[request_id];
+  rpc_host_hedge_stat &host_stat = rpc_host_hedge_stats[hedge.host_num];
+  host_stat.queries++;
+  hedge.send_time = get_precise_now();
+  const double delay = std::max(hedge.min_delay, host_stat.latency_estimate);
+  if (delay < timeout) {
+    hedge.timer = allocate_event_timer(hedge.send_time + delay, hedge_wakeup_id, request_id);
+  }
+}
+
+static void send_rpc_hedge(event_timer *timer) {
+  const int32_t request_id = timer->wakeup_extra;
+  remove_event_timer(timer);
+  rpc_hedge &hedge = rpc_hedges[request_id];
+  hedge.timer = nullptr;
+  php_assert (get_rpc_request(request_id)->resumable_id > 0);
+
+  void *p = dl::allocate(static_cast<size_t>(hedge.request_size));
+  memcpy(p, hedge.request, static_cast<size_t>(hedge.request_size));
+  const slot_id_t hedge_request_id = rpc_send_query(hedge.backup_host_num, static_cast<char *>(p), hedge.request_size, hedge.timeout_ms);
+  if (hedge_request_id <= 0) {
+    return;
+  }
+  // the duplicate has no fork of its own, its answer is given to the original query
+  rpc_request *cur = register_rpc_request(hedge_request_id);
+  cur->resumable_id = -3;
+  cur->answer = nullptr;
+
+  Tracing::get().start_span(Tracing::SpanKind::rpc, hedge_request_id, hedge.backup_host_num, static_cast<uint32_t>(hedge.request_size), get_utime_monotonic());
+  hedge.hedge_request_id = hedge_request_id;
+  rpc_hedge_origins.set_value(hedge_request_id, request_id);
+  rpc_host_hedge_stats[hedge.host_num].hedged++;
+  PhpQueriesStats::get_rpc_queries_stat().register_hedged_query();
+}
+
+// called when the original query gets its result, the duplicate is cancelled
+static void finish_rpc_hedge(int32_t request_id, bool is_answer) {
+  const rpc_hedge *found = rpc_hedges.find_value(request_id);
+  if (found == nullptr) {
+    return;
+  }
+  const rpc_hedge hedge = *found;
+  rpc_hedges.unset(request_id);
+
+  if (hedge.timer) {
+    remove_event_timer(hedge.timer);
+  }
+  if (hedge.hedge_request_id > 0) {
+    rpc_cancel_query(hedge.hedge_request_id);
+    rpc_hedge_origins.unset(hedge.hedge_request_id);
+  }
+  if (is_answer) {
+    update_latency_estimate(hedge.host_num, get_precise_now() - hedge.send_time, hedge.percentile);
+  }
+}
+
+// returns the request which the answer belongs to: the first answer of a duplicate wins the original query
+static int32_t resolve_hedged_answer(int32_t request_id) {
+  const int64_t *origin = rpc_hedge_origins.find_value(request_id);
+  if (origin == nullptr) {
+    return request_id;
+  }
+  const auto origin_id = static_cast<int32_t>(*origin);
+  rpc_hedge_origins.unset(request_id);
+  rpc_hedge &hedge = rpc_hedges[origin_id];
+  hedge.hedge_request_id = 0;
+  rpc_cancel_query(origin_id);
+  rpc_host_hedge_stats[hedge.host_num].won++;
+  PhpQueriesStats::get_rpc_queries_stat().register_hedge_win();
+  return origin_id;
+}
+
+static void forget_hedged_error(int32_t request_id) {
+  const int64_t *origin = rpc_hedge_origins.find_value(request_id);
+  if (origin == nullptr) {
+    return;
+  }
+  // the original query is still pending and is limited by its own timeout
+  rpc_hedges[*origin].hedge_request_id = 0;
+  rpc_hedge_origins.unset(request_id);
+}
+
+bool f$rpc_enable_hedging(const class_instance<C$RpcConnection> &conn, const class_instance<C$RpcConnection> &backup_conn,
+                          double min_delay, double percentile) {
+  if (unlikely (conn.is_null() || conn.get()->host_num < 0 || backup_conn.is_null() || backup_conn.get()->host_num < 0)) {
+    php_warning("Wrong RpcConnection specified");
+    return false;
+  }
+  if (unlikely (conn.get()->host_num >= RPC_MAX_HEDGED_HOSTS || conn.get()->host_num == backup_conn.get()->host_num)) {
+    php_warning("Can't hedge the queries of rpc connection to port %d", conn.get()->port);
+    return false;
+  }
+  if (unlikely (percentile <= 0 || percentile >= 1 || min_delay < 0)) {
+    php_warning("Wrong hedging parameters: min_delay %.3f, percentile %.3f", min_delay, percentile);
+    return false;
+  }
+  conn.get()->hedge_host_num = backup_conn.get()->host_num;
+  conn.get()->hedge_min_delay = min_delay;
+  conn.get()->hedge_percentile = percentile;
+  return true;
+}
+
+array<int64_t> f$rpc_get_hedging_stats(const class_instance<C$RpcConnection> &conn) {
+  array<int64_t> result(array_size(0, 4, false));
+  if (conn.is_null() || conn.get()->host_num < 0 || conn.get()->host_num >= RPC_MAX_HEDGED_HOSTS) {
+    return result;
+  }
+  const rpc_host_hedge_stat &stat = rpc_host_hedge_stats[conn.get()->host_num];
+  result.set_value(string("queries"), static_cast<int64_t>(stat.queries));
+  result.set_value(string("hedged"), static_cast<int64_t>(stat.hedged));
+  result.set_value(string("won"), static_cast<int64_t>(stat.won));
+  result.set_value(string("delay_us"), static_cast<int64_t>(stat.latency_estimate * 1e6));
+  return result;
+}
+
+class_instance<C$RpcConnectionPool> f$new_rpc_connection_pool(const array<class_instance<C$RpcConnection>> &connections) {
+  auto pool = make_instance<C$RpcConnectionPool>();
+  for (const auto &it : connections) {
+    const class_instance<C$RpcConnection> &conn = it.get_value();
+    if (unlikely (conn.is_null() || conn.get()->host_num < 0)) {
+      php_warning("Wrong RpcConnection specified");
+      continue;
+    }
+    pool.get()->connections.push_back(conn);
+  }
+  return pool;
+}
+
+class_instance<C$RpcConnection> f$rpc_pool_pick_connection(const class_instance<C$RpcConnectionPool> &pool) {
+  if (unlikely (pool.is_null() || pool.get()->connections.empty())) {
+    php_warning("Can't pick a connection from an empty RpcConnectionPool");
+    return {};
+  }
+  const array<class_instance<C$RpcConnection>> &connections = pool.get()->connections;
+  const int64_t size = connections.count();
+  // the targets which are over the rpc queue limits are picked only if all of them are
+  auto in_flight = [&connections](int64_t index) {
+    const int host_num = connections.get_value(index).get()->host_num;
+    return is_rpc_target_busy(host_num) ? std::numeric_limits<int>::max() : get_rpc_in_flight_queries(host_num);
+  };
+  register_balanced_rpc_query();
+
+  // small pools are scanned entirely, starting from a random one to spread the ties
+  const int64_t small_pool_size = 4;
+  if (size <= small_pool_size) {
+    const int64_t start = lrand48() % size;
+    int64_t best = start;
+    for (int64_t i = 1; i < size; i++) {
+      const int64_t index = (start + i) % size;
+      if (in_flight(index) < in_flight(best)) {
+        best = index;
+      }
+    }
+    return connections.get_value(best);
+  }
+
+  const int64_t first = lrand48() % size;
+  int64_t second = lrand48() % (size - 1);
+  second += second >= first;
+  return connections.get_value(in_flight(second) < in_flight(first) ? second : first);
+}
+
+array<int64_t> f$rpc_pool_get_in_flight(const class_instance<C$RpcConnectionPool> &pool) {
+  if (pool.is_null()) {
+    return {};
+  }
+  array<int64_t> result(array_size(pool.get()->connections.count(), 0, true));
+  for (const auto &it : pool.get()->connections) {
+    result.push_back(get_rpc_in_flight_queries(it.get_value().get()->host_num));
+  }
+  return result;
+}
+
 int64_t rpc_send(const class_instance<C$RpcConnection> &conn, double timeout, bool ignore_answer) {
   if (unlikely (conn.is_null() || conn.get()->host_num < 0)) {
     php_warning("Wrong RpcConnection specified");
@@ -838,45 +1124,41 @@ int64_t rpc_send(const class_instance<C$RpcConnection> &conn, double timeout, bo
     }
   }
 
-  const auto request_size = static_cast<size_t>(data_buf.size() - reserved);
-  void *p = dl::allocate(request_size);
-  memcpy(p, data_buf.c_str() + reserved, request_size);
-
-  slot_id_t result = rpc_send_query(conn.get()->host_num, (char *)p, (int)request_size, timeout_convert_to_ms(timeout));
-  if (result <= 0) {
-    return -1;
+  auto &tracing = Tracing::get();
+  uint64_t span_id = 0;
+  size_t trace_header_size = 0;
+  if (unlikely(tracing.should_propagate())) {
+    span_id = tracing.new_span_id();
+    trace_header_size = 2 * sizeof(int) + 2 * sizeof(long long);
   }
 
-  if (dl::query_num != rpc_requests_last_query_num) {
-    rpc_requests_last_query_num = dl::query_num;
-    rpc_requests_size = 170;
-    rpc_requests = static_cast<rpc_request *>(dl::allocate(sizeof(rpc_request) * rpc_requests_size));
-
-    rpc_first_request_id = result;
-    rpc_first_array_request_id = result;
-    rpc_next_request_id = result + 1;
-    rpc_first_unfinished_request_id = result;
-    gotten_rpc_request.resumable_id = -3;
-    gotten_rpc_request.answer = nullptr;
+  const auto request_size = static_cast<size_t>(data_buf.size() - reserved) + trace_header_size;
+  void *p = dl::allocate(request_size);
+  if (likely(trace_header_size == 0)) {
+    memcpy(p, data_buf.c_str() + reserved, request_size);
   } else {
-    php_assert (rpc_next_request_id == result);
-    rpc_next_request_id++;
+    // the trace context goes after the packet header and the actor, the engine fetches the header blocks in any order
+    const char *src = data_buf.c_str() + reserved;
+    size_t head_size = data_buf_header_size - data_buf_header_reserved_size;
+    if (*reinterpret_cast<const int *>(src + head_size) == TL_RPC_DEST_ACTOR) {
+      head_size += sizeof(int) + sizeof(long long);
+    }
+    char *dst = static_cast<char *>(p);
+    memcpy(dst, src, head_size);
+    int header[2] = {static_cast<int>(TL_RPC_DEST_FLAGS), static_cast<int>(vk::tl::common::rpc_invoke_req_extra_flags::trace_id)};
+    long long context[2] = {static_cast<long long>(tracing.trace_id()), static_cast<long long>(span_id)};
+    memcpy(dst + head_size, header, sizeof(header));
+    memcpy(dst + head_size + sizeof(header), context, sizeof(context));
+    memcpy(dst + head_size + trace_header_size, src + head_size, request_size - trace_header_size - head_size);
   }
 
-  if (result - rpc_first_array_request_id >= rpc_requests_size) {
-    php_assert (result - rpc_first_array_request_id == rpc_requests_size);
-    if (rpc_first_unfinished_request_id > rpc_first_array_request_id + rpc_requests_size / 2) {
-      memcpy(rpc_requests,
-             rpc_requests + rpc_first_unfinished_request_id - rpc_first_array_request_id,
-             sizeof(rpc_request) * (rpc_requests_size - (rpc_first_unfinished_request_id - rpc_first_array_request_id)));
-      rpc_first_array_request_id = rpc_first_unfinished_request_id;
-    } else {
-      rpc_requests = static_cast <rpc_request *> (dl::reallocate(rpc_requests, sizeof(rpc_request) * 2 * rpc_requests_size, sizeof(rpc_request) * rpc_requests_size));
-      rpc_requests_size *= 2;
-    }
+  slot_id_t result = rpc_send_query(conn.get()->host_num, (char *)p, (int)request_size, timeout_convert_to_ms(timeout));
+  if (result <= 0) {
+    return -1;
   }
+  tracing.start_span(Tracing::SpanKind::rpc, result, conn.get()->host_num, static_cast<uint32_t>(request_size), get_utime_monotonic(), span_id);
 
-  rpc_request *cur = get_rpc_request(result);
+  rpc_request *cur = register_rpc_request(result);
 
   cur->resumable_id = register_forked_resumable(new rpc_resumable(result, conn.get()->port, conn.get()->default_actor_id));
   cur->timer = nullptr;
@@ -886,6 +1168,11 @@ int64_t rpc_send(const class_instance<C$RpcConnection> &conn, double timeout, bo
     get_forked_storage(resumable_id)->load<rpc_request>();
     return resumable_id;
   } else {
+    if (conn.get()->hedge_host_num >= 0) {
+      rpc_hedges.set_value(result, rpc_hedge{conn.get()->host_num, conn.get()->hedge_host_num, 0, timeout_convert_to_ms(timeout),
+                                             static_cast<char *>(p), static_cast<int32_t>(request_size), 0,
+                                             conn.get()->hedge_min_delay, conn.get()->hedge_percentile, nullptr});
+    }
     rpc_request_need_timer.set_value(result, timeout);
     return cur->resumable_id;
   }
@@ -901,6 +1188,9 @@ void f$rpc_flush() {
     if (cur->resumable_id > 0) {
       php_assert (cur->timer == nullptr);
       cur->timer = allocate_event_timer(iter.get_value() + get_precise_now(), timeout_wakeup_id, id);
+      if (unlikely (!rpc_hedges.empty()) && rpc_hedges.has_key(id)) {
+        arm_rpc_hedge(id, iter.get_value());
+      }
     }
   }
   rpc_request_need_timer.clear();
@@ -927,6 +1217,9 @@ int64_t f$rpc_send_noflush(const class_instance<C$RpcConnection> &conn, double t
 
 
 void process_rpc_answer(int32_t request_id, char *result, int32_t result_len __attribute__((unused))) {
+  if (unlikely (!rpc_hedge_origins.empty())) {
+    request_id = resolve_hedged_answer(request_id);
+  }
   rpc_request *request = get_rpc_request(request_id);
 
   if (request->resumable_id < 0) {
@@ -941,6 +1234,9 @@ void process_rpc_answer(int32_t request_id, char *result, int32_t result_len __a
   if (request->timer) {
     remove_event_timer(request->timer);
   }
+  if (unlikely (!rpc_hedges.empty())) {
+    finish_rpc_hedge(request_id, true);
+  }
 
   php_assert (result != nullptr);
   request->answer = result;
@@ -951,6 +1247,9 @@ void process_rpc_answer(int32_t request_id, char *result, int32_t result_len __a
 }
 
 void process_rpc_error(int32_t request_id, int32_t error_code __attribute__((unused)), const char *error_message) {
+  if (unlikely (!rpc_hedge_origins.empty())) {
+    forget_hedged_error(request_id);
+  }
   rpc_request *request = get_rpc_request(request_id);
 
   if (request->resumable_id < 0) {
@@ -963,6 +1262,9 @@ void process_rpc_error(int32_t request_id, int32_t error_code __attribute__((unu
   if (request->timer) {
     remove_event_timer(request->timer);
   }
+  if (unlikely (!rpc_hedges.empty())) {
+    finish_rpc_hedge(request_id, false);
+  }
 
   request->error = error_message;
 
@@ -1361,6 +1663,26 @@ array<int64_t> f$rpc_tl_query(const class_instance<C$RpcConnection> &c, const ar
   return result;
 }
 
+array<int64_t> f$rpc_tl_query_multi(const array<class_instance<C$RpcConnection>> &connections, const array<mixed> &tl_objects, double timeout, bool ignore_answer) {
+  array<int64_t> result(tl_objects.size());
+  size_t bytes_sent = 0;
+  for (auto it = tl_objects.begin(); it != tl_objects.end(); ++it) {
+    const class_instance<C$RpcConnection> *conn = connections.find_value(it.get_key());
+    if (unlikely (conn == nullptr)) {
+      php_warning("No RpcConnection specified for rpc query");
+      result.set_value(it.get_key(), 0);
+      continue;
+    }
+    int64_t query_id = rpc_tl_query_impl(*conn, it.get_value(), timeout, ignore_answer, true, bytes_sent, false);
+    result.set_value(it.get_key(), query_id);
+  }
+  if (bytes_sent > 0) {
+    f$rpc_flush();
+  }
+
+  return result;
+}
+
 
 class rpc_tl_query_result_one_resumable : public Resumable {
   using ReturnT = array<mixed>;
@@ -1525,6 +1847,7 @@ void global_init_rpc_lib() {
   php_assert (timeout_wakeup_id == -1);
 
   timeout_wakeup_id = register_wakeup_callback(&process_rpc_timeout);
+  hedge_wakeup_id = register_wakeup_callback(&send_rpc_hedge);
 }
 
 static void reset_rpc_global_vars() {
@@ -1532,6 +1855,8 @@ static void reset_rpc_global_vars() {
   hard_reset_var(rpc_data_copy);
   hard_reset_var(rpc_data_copy_backup);
   hard_reset_var(rpc_request_need_timer);
+  hard_reset_var(rpc_hedges);
+  hard_reset_var(rpc_hedge_origins);
   fail_rpc_on_int32_overflow = false;
 }
 
@@ -1592,3 +1917,19 @@ bool f$rpc_wait(int64_t request_id) {
 bool f$rpc_wait_concurrently(int64_t request_id) {
   return f$wait_concurrently(request_id);
 }
+
+int64_t f$fork_cancel(int64_t fork_id) {
+  if (dl::query_num != rpc_requests_last_query_num) {
+    return 0;
+  }
+  int64_t cancelled = 0;
+  for (slot_id_t request_id = rpc_first_unfinished_request_id; request_id < rpc_next_request_id; request_id++) {
+    rpc_request *request = get_rpc_request(request_id);
+    if (request->resumable_id > 0 && is_fork_in_scope(request->resumable_id, fork_id)) {
+      rpc_cancel_query(request_id);
+      process_rpc_error(request_id, TL_ERROR_QUERY_INCORRECT, "Cancelled by fork_cancel");
+      cancelled++;
+    }
+  }
+  return cancelled;
+}
@@ -83,6 +83,10 @@ bool f$fetch_eof();
 bool f$fetch_end();
 
 void f$fetch_raw_vector_double(array<double> &out, int64_t n_elems);
+void fetch_raw_vector_long(array<int64_t> &out, int64_t n_elems);
+void fetch_raw_vector_int(array<int64_t> &out, int64_t n_elems);
+// the fixed size fields of a combinator are fetched with one bounds check, nullptr if there is not enough data
+const int32_t *rpc_fetch_raw_words(int64_t n_words);
 
 void estimate_and_flush_overflow(size_t &bytes_sent);
 
@@ -108,12 +112,21 @@ struct C$RpcConnection final : public refcountable_php_classes<C$RpcConnection>
   long long default_actor_id{-1};
   int32_t connect_timeout{-1};
   int32_t reconnect_timeout{-1};
+  int32_t hedge_host_num{-1};// a duplicate of a slow query is sent there, -1 if hedging is disabled
+  double hedge_min_delay{0};
+  double hedge_percentile{0};
 
   C$RpcConnection(int32_t host_num, int32_t port, int32_t tmeout_ms, long long default_actor_id, int32_t connect_timeout, int32_t reconnect_timeout);
 
   void accept(InstanceMemoryEstimateVisitor &) {}
 };
 
+struct C$RpcConnectionPool final : public refcountable_php_classes<C$RpcConnectionPool> {
+  array<class_instance<C$RpcConnection>> connections;
+
+  void accept(InstanceMemoryEstimateVisitor &) {}
+};
+
 class_instance<C$RpcConnection> f$new_rpc_connection(const string &host_name, int64_t port, const mixed &default_actor_id = 0, double timeout = 0.3, double connect_timeout = 0.3, double reconnect_timeout = 17);
 
 void f$store_gzip_pack_threshold(int64_t pack_threshold_bytes);
@@ -129,6 +142,8 @@ bool f$store_error(int64_t error_code, const string &error_text);
 bool f$store_raw(const string &data);
 
 void f$store_raw_vector_double(const array<double> &vector);
+void store_raw_vector_long(const array<int64_t> &vector);
+void store_raw_words(const int32_t *words, int64_t n_words);
 
 bool f$set_fail_rpc_on_int32_overflow(bool fail_rpc); // TODO: remove when all RPC errors will be fixed
 
@@ -167,6 +182,18 @@ int64_t rpc_send(const class_instance<C$RpcConnection> &conn, double timeout, bo
 
 int64_t f$rpc_send_noflush(const class_instance<C$RpcConnection> &conn, double timeout = -1.0);
 
+bool f$rpc_enable_hedging(const class_instance<C$RpcConnection> &conn, const class_instance<C$RpcConnection> &backup_conn,
+                          double min_delay = 0.005, double percentile = 0.95);
+
+array<int64_t> f$rpc_get_hedging_stats(const class_instance<C$RpcConnection> &conn);
+
+class_instance<C$RpcConnectionPool> f$new_rpc_connection_pool(const array<class_instance<C$RpcConnection>> &connections);
+
+// the connection with the least number of outstanding queries, for large pools the best of two random ones
+class_instance<C$RpcConnection> f$rpc_pool_pick_connection(const class_instance<C$RpcConnectionPool> &pool);
+
+array<int64_t> f$rpc_pool_get_in_flight(const class_instance<C$RpcConnectionPool> &pool);
+
 void f$rpc_flush();
 
 Optional<string> f$rpc_get(int64_t request_id, double timeout = -1.0);
@@ -195,6 +222,9 @@ bool f$rpc_wait(int64_t request_id);
 
 bool f$rpc_wait_concurrently(int64_t request_id);
 
+// fails all the pending rpc queries of the fork and of the forks started from it, returns their number
+int64_t f$fork_cancel(int64_t fork_id);
+
 bool f$store_long(const mixed &v);
 
 bool f$store_long(int64_t v);
@@ -218,6 +248,10 @@ bool f$rpc_mc_parse_raw_wildcard_with_flags_to_array(const string &raw_result, a
 
 array<int64_t> f$rpc_tl_query(const class_instance<C$RpcConnection> &c, const array<mixed> &tl_objects, double timeout = -1.0, bool ignore_answer = false);
 
+// sends every query to the connection with the same key and flushes once, so each connection gets one write
+array<int64_t> f$rpc_tl_query_multi(const array<class_instance<C$RpcConnection>> &connections, const array<mixed> &tl_objects,
+                                    double timeout = -1.0, bool ignore_answer = false);
+
 array<mixed> f$rpc_tl_query_result_one(int64_t query_id);
 
 array<array<mixed>> f$rpc_tl_query_result(const array<int64_t> &query_ids);
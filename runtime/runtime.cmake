@@ -2,13 +2,16 @@ prepend(KPHP_RUNTIME_MEMORY_RESOURCE_SOURCES memory_resource/
         dealer.cpp
         details/memory_chunk_tree.cpp
         details/memory_ordered_chunk_list.cpp
+        global_const_memory.cpp
         heap_resource.cpp
         memory_resource.cpp
         monotonic_buffer_resource.cpp
+        script_arena.cpp
         unsynchronized_pool_resource.cpp)
 
 prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
         ${KPHP_RUNTIME_MEMORY_RESOURCE_SOURCES}
+        allocations_sampler.cpp
         allocator.cpp
         array_functions.cpp
         bcmath.cpp
@@ -20,9 +23,11 @@ prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
         datetime.cpp
         exception.cpp
         files.cpp
+        http_compression.cpp
         instance_cache.cpp
         inter-process-mutex.cpp
         interface.cpp
+        json-functions.cpp
         kphp-backtrace.cpp
         mail.cpp
         math_functions.cpp
@@ -30,10 +35,12 @@ prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
         memcache.cpp
         memory_usage.cpp
         misc.cpp
+        ml_models.cpp
         msgpack-serialization.cpp
         mysql.cpp
         net_events.cpp
         on_kphp_warning_callback.cpp
+        parallel-map.cpp
         openssl.cpp
         php_assert.cpp
         profiler.cpp
@@ -45,6 +52,7 @@ prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
         string_buffer.cpp
         string_cache.cpp
         string_functions.cpp
+        strtr-matcher.cpp
         tl/rpc_tl_query.cpp
         tl/rpc_response.cpp
         tl/rpc_server.cpp
@@ -52,9 +60,11 @@ prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
         uber-h3.cpp
         udp.cpp
         url.cpp
+        vector_math.cpp
         vkext.cpp
         vkext_stats.cpp
-        zlib.cpp)
+        zlib.cpp
+        zstd.cpp)
 
 set_source_files_properties(
         ${BASE_DIR}/server/php-runner.cpp
@@ -90,11 +100,15 @@ file(GLOB_RECURSE KPHP_RUNTIME_ALL_HEADERS
      "${BASE_DIR}/runtime/*.h")
 list(TRANSFORM KPHP_RUNTIME_ALL_HEADERS REPLACE "^(.+)$" [[#include "\1"]])
 list(JOIN KPHP_RUNTIME_ALL_HEADERS "\n" MERGED_RUNTIME_HEADERS)
+# the generated code must see the same array layout as the runtime it is linked with
+if(KPHP_ARRAY_COMPACT_MAP)
+    set(MERGED_RUNTIME_DEFINES "#define KPHP_ARRAY_COMPACT_MAP\n")
+endif()
 file(WRITE ${AUTO_DIR}/runtime/runtime-headers.h "\
 #ifndef MERGED_RUNTIME_HEADERS_H
 #define MERGED_RUNTIME_HEADERS_H
 
-${MERGED_RUNTIME_HEADERS}
+${MERGED_RUNTIME_DEFINES}${MERGED_RUNTIME_HEADERS}
 
 #endif
 ")
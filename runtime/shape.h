@@ -9,6 +9,9 @@
 #include <type_traits>
 #include <utility>
 
+// the fields of a shape which are not passed to its constructor
+struct shape_node_default_value {};
+
 template<size_t tag, typename T>
 class shape_node {
 public:
@@ -21,9 +24,11 @@ public:
   shape_node &operator=(const shape_node &) = default;
   shape_node &operator=(shape_node &&) noexcept = default;
 
-  template<typename T1, typename = std::is_constructible<T, T1 &&>>
-  explicit shape_node(T1 value) :
-    value(std::move(value)) {}
+  explicit shape_node(shape_node_default_value) noexcept {}
+
+  template<typename T1, typename = std::enable_if_t<std::is_constructible<T, T1 &&>{} && !std::is_same<std::decay_t<T1>, shape_node>{}>>
+  explicit shape_node(T1 &&value) :
+    value(std::forward<T1>(value)) {}
 };
 
 template<typename Is, typename ...T>
@@ -44,13 +49,32 @@ class shape<std::index_sequence<Is...>, T...> : public shape_node<Is, T> ... {
   template<size_t tag>
   decltype(auto) get_node() const { return get_node_impl<tag>(this); }
 
-  template<size_t tag, typename T2>
-  void set(const shape_node<tag, T2> &other) {
-    get_node<tag>().value = other.value;
+  template<size_t tag, size_t ...Is2>
+  using has_tag = std::integral_constant<bool, vk::any_of_equal(tag, Is2...)>;
+
+  template<size_t tag, typename T1>
+  static const T1 &get_node_value(const shape_node<tag, T1> &node) { return node.value; }
+  template<size_t tag, typename T1>
+  static T1 &&get_node_value(shape_node<tag, T1> &&node) { return std::move(node.value); }
+
+  // the fields of a shape converted from a narrower one are constructed directly, the missing ones are value initialized
+  template<size_t tag, typename Other>
+  static decltype(auto) take_node_value(Other &&other, std::true_type) {
+    return get_node_value<tag>(std::forward<Other>(other));
   }
-  template<size_t tag, typename T2>
-  void set(shape_node<tag, T2> &&other) {
-    get_node<tag>().value = std::move(other.value);
+  template<size_t tag, typename Other>
+  static shape_node_default_value take_node_value(Other &&, std::false_type) {
+    return {};
+  }
+
+  template<size_t tag, typename Other>
+  void assign_node(Other &&other, std::true_type) {
+    get_node<tag>().value = get_node_value<tag>(std::forward<Other>(other));
+  }
+  template<size_t tag, typename Other>
+  void assign_node(Other &&, std::false_type) {
+    auto &value = get_node<tag>().value;
+    value = std::decay_t<decltype(value)>{};
   }
 
   template<bool eq_sizes, typename ...Args>
@@ -91,20 +115,24 @@ public:
   // TODO: not SFINAE-friendly
   template<size_t ...Is2, typename ...T2, typename = enable_if_sequence_is_subset<Is2...>>
   explicit shape(shape<std::index_sequence<Is2...>, T2...> &&other) noexcept :
-    shape_node<Is, T>()... {
-    std::initializer_list<int>{(set(std::forward<shape_node<Is2, T2>>(other)), 0)...};
+    shape_node<Is, T>(take_node_value<Is>(std::move(other), has_tag<Is, Is2...>{}))... {
   }
 
   template<size_t ...Is2, typename ...T2, typename = enable_if_sequence_is_subset<Is2...>>
   shape(const shape<std::index_sequence<Is2...>, T2...> &other) noexcept :
-    shape_node<Is, T>()... {
-    std::initializer_list<int>{(set(static_cast<const shape_node<Is2, T2> &>(other)), 0)...};
+    shape_node<Is, T>(take_node_value<Is>(other, has_tag<Is, Is2...>{}))... {
+  }
+
+  // the fields are assigned in place, without a temporary shape
+  template<size_t ...Is2, typename ...T2, typename = enable_if_sequence_is_subset<Is2...>>
+  shape &operator=(shape<std::index_sequence<Is2...>, T2...> &&other) {
+    std::initializer_list<int>{(assign_node<Is>(std::move(other), has_tag<Is, Is2...>{}), 0)...};
+    return *this;
   }
 
   template<size_t ...Is2, typename ...T2, typename = enable_if_sequence_is_subset<Is2...>>
-  shape &operator=(shape<std::index_sequence<Is2...>, T2...> other) {
-    shape nv(std::move(other));
-    std::swap(nv, *this);
+  shape &operator=(const shape<std::index_sequence<Is2...>, T2...> &other) {
+    std::initializer_list<int>{(assign_node<Is>(other, has_tag<Is, Is2...>{}), 0)...};
     return *this;
   }
 };
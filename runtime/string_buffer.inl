@@ -64,7 +64,9 @@ string_buffer &operator<<(string_buffer &sb, const char *s) {
 }
 
 string_buffer &operator<<(string_buffer &sb, double f) {
-  return sb << string(f);
+  sb.reserve_at_least(STRLEN_FLOAT);
+  sb.buffer_end += impl_::php_double_to_chars(f, sb.buffer_end);
+  return sb;
 }
 
 string_buffer &operator<<(string_buffer &sb, const string &s) {
@@ -191,6 +193,12 @@ void string_buffer::copy_raw_data(const string_buffer &other) {
   append(other.str().c_str(), other.size());
 }
 
+void string_buffer::swap(string_buffer &other) noexcept {
+  std::swap(buffer_begin, other.buffer_begin);
+  std::swap(buffer_end, other.buffer_end);
+  std::swap(buffer_len, other.buffer_len);
+}
+
 bool operator==(const string_buffer &lhs, const string_buffer &rhs) {
   size_t len_l = lhs.buffer_end - lhs.buffer_begin;
   size_t len_r = rhs.buffer_end - rhs.buffer_begin;
@@ -63,6 +63,8 @@ public:
   inline void debug_print() const;
 
   inline void copy_raw_data(const string_buffer &other);
+  // exchanges the memory of the buffers without copying the data
+  inline void swap(string_buffer &other) noexcept;
 
   friend inline bool operator==(const string_buffer &lhs, const string_buffer &rhs);
   friend inline bool operator!=(const string_buffer &lhs, const string_buffer &rhs);
@@ -7,6 +7,7 @@
 #include <clocale>
 #include <endian.h>
 
+#include "common/string-kernels.h"
 #include "common/unicode/unicode-utils.h"
 
 #include "runtime/integer_types.h"
@@ -98,36 +99,36 @@ string f$addcslashes(const string &str, const string &what) {
 }
 
 string f$addslashes(const string &str) {
-  int len = str.size();
+  static constexpr char special_chars[] = {'\0', '\'', '\"', '\\'};
+  const size_t len = str.size();
+  const char *s = str.c_str();
+
+  size_t i = find_first_of_chars(s, len, special_chars, sizeof(special_chars));
+  if (i == len) {
+    return str;
+  }
 
   static_SB.clean().reserve(2 * len);
-  for (int i = 0; i < len; i++) {
-    switch (str[i]) {
-      case '\0':
-        static_SB.append_char('\\');
-        static_SB.append_char('0');
-        break;
-      case '\'':
-      case '\"':
-      case '\\':
-        static_SB.append_char('\\');
-        /* fallthrough */
-      default:
-        static_SB.append_char(str[i]);
+  static_SB.append_unsafe(s, static_cast<int>(i));
+  while (i < len) {
+    if (s[i] == '\0') {
+      static_SB.append_char('\\');
+      static_SB.append_char('0');
+    } else {
+      static_SB.append_char('\\');
+      static_SB.append_char(s[i]);
     }
+    ++i;
+    const size_t next = i + find_first_of_chars(s + i, len - i, special_chars, sizeof(special_chars));
+    static_SB.append_unsafe(s + i, static_cast<int>(next - i));
+    i = next;
   }
   return static_SB.str();
 }
 
 string f$bin2hex(const string &str) {
-  int len = str.size();
-  string result(2 * len, false);
-
-  for (int i = 0; i < len; i++) {
-    result[2 * i] = lhex_digits[(str[i] >> 4) & 15];
-    result[2 * i + 1] = lhex_digits[str[i] & 15];
-  }
-
+  string result(2 * str.size(), false);
+  hex_encode(str.c_str(), str.size(), result.buffer());
   return result;
 }
 
@@ -463,57 +464,48 @@ string f$htmlspecialchars(const string &str, int64_t flags) {
     php_critical_error ("unsupported parameter flags = %ld in function htmlspecialchars", flags);
   }
 
-  const string::size_type len = str.size();
-  static_SB.clean().reserve(6 * len);
+  char special_chars[5] = {'&', '<', '>'};
+  size_t special_chars_count = 3;
+  if (!(flags & ENT_NOQUOTES)) {
+    special_chars[special_chars_count++] = '"';
+  }
+  if (flags & ENT_QUOTES) {
+    special_chars[special_chars_count++] = '\'';
+  }
 
-  for (string::size_type i = 0; i < len; i++) {
-    switch (str[i]) {
+  const size_t len = str.size();
+  const char *s = str.c_str();
+  size_t i = find_first_of_chars(s, len, special_chars, special_chars_count);
+  if (i == len) {
+    return str;
+  }
+
+  static_SB.clean().reserve(6 * len);
+  static_SB.append_unsafe(s, static_cast<int>(i));
+  while (i < len) {
+    switch (s[i]) {
       case '&':
-        static_SB.append_char('&');
-        static_SB.append_char('a');
-        static_SB.append_char('m');
-        static_SB.append_char('p');
-        static_SB.append_char(';');
+        static_SB.append_unsafe("&amp;", 5);
         break;
       case '"':
-        if (!(flags & ENT_NOQUOTES)) {
-          static_SB.append_char('&');
-          static_SB.append_char('q');
-          static_SB.append_char('u');
-          static_SB.append_char('o');
-          static_SB.append_char('t');
-          static_SB.append_char(';');
-        } else {
-          static_SB.append_char('"');
-        }
+        static_SB.append_unsafe("&quot;", 6);
         break;
       case '\'':
-        if (flags & ENT_QUOTES) {
-          static_SB.append_char('&');
-          static_SB.append_char('#');
-          static_SB.append_char('0');
-          static_SB.append_char('3');
-          static_SB.append_char('9');
-          static_SB.append_char(';');
-        } else {
-          static_SB.append_char('\'');
-        }
+        static_SB.append_unsafe("&#039;", 6);
         break;
       case '<':
-        static_SB.append_char('&');
-        static_SB.append_char('l');
-        static_SB.append_char('t');
-        static_SB.append_char(';');
+        static_SB.append_unsafe("&lt;", 4);
         break;
       case '>':
-        static_SB.append_char('&');
-        static_SB.append_char('g');
-        static_SB.append_char('t');
-        static_SB.append_char(';');
+        static_SB.append_unsafe("&gt;", 4);
         break;
       default:
-        static_SB.append_char(str[i]);
+        php_assert(0);
     }
+    ++i;
+    const size_t next = i + find_first_of_chars(s + i, len - i, special_chars, special_chars_count);
+    static_SB.append_unsafe(s + i, static_cast<int>(next - i));
+    i = next;
   }
 
   return static_SB.str();
@@ -969,11 +961,24 @@ string f$rtrim(const string &s, const string &what) {
   return string(s.c_str(), len);
 }
 
+// setlocale() loads the locale and takes the global locale lock, so the default one is set again only if the script has changed it
+static bool ctype_locale_is_default = false;
+
+void reset_ctype_locale() noexcept {
+  if (!ctype_locale_is_default) {
+    setlocale(LC_CTYPE, "ru_RU.CP1251");
+    ctype_locale_is_default = true;
+  }
+}
+
 Optional<string> f$setlocale(int64_t category, const string &locale) {
   const char *loc = locale.c_str();
   if (locale[0] == '0' && locale.size() == 1) {
     loc = nullptr;
   }
+  if (loc != nullptr && (category == LC_CTYPE || category == LC_ALL)) {
+    ctype_locale_is_default = false;
+  }
   char *res = setlocale(static_cast<int32_t>(category), loc);
   if (res == nullptr) {
     return false;
@@ -1813,22 +1818,36 @@ Optional<string> f$strstr(const string &haystack, const string &needle, bool bef
 }
 
 string f$strtolower(const string &str) {
-  int n = str.size();
+  const size_t n = str.size();
+  const char *s = str.c_str();
 
-  string res(n, false);
-  for (int i = 0; i < n; i++) {
-    res[i] = (char)tolower(str[i]);
+  string res(static_cast<string::size_type>(n), false);
+  char *dst = res.buffer();
+  // ascii runs are converted by the vectorized kernel, other bytes depend on the current locale
+  for (size_t i = 0; i < n;) {
+    i += ascii_to_lower(dst + i, s + i, n - i);
+    if (i < n) {
+      dst[i] = (char)tolower(s[i]);
+      ++i;
+    }
   }
 
   return res;
 }
 
 string f$strtoupper(const string &str) {
-  int n = str.size();
-
-  string res(n, false);
-  for (int i = 0; i < n; i++) {
-    res[i] = (char)toupper(str[i]);
+  const size_t n = str.size();
+  const char *s = str.c_str();
+
+  string res(static_cast<string::size_type>(n), false);
+  char *dst = res.buffer();
+  // ascii runs are converted by the vectorized kernel, other bytes depend on the current locale
+  for (size_t i = 0; i < n;) {
+    i += ascii_to_upper(dst + i, s + i, n - i);
+    if (i < n) {
+      dst[i] = (char)toupper(s[i]);
+      ++i;
+    }
   }
 
   return res;
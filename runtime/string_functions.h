@@ -5,7 +5,9 @@
 #pragma once
 
 #include <type_traits>
+#include "runtime/allocator.h"
 #include "runtime/kphp_core.h"
+#include "runtime/strtr-matcher.h"
 
 extern const string COLON;
 extern const string CP1251;
@@ -89,6 +91,8 @@ int64_t f$printf(const string &format, const array<mixed> &a);
 string f$rtrim(const string &s, const string &what = WHAT);
 
 Optional<string> f$setlocale(int64_t category, const string &locale);
+// sets LC_CTYPE back to the default one at the request start
+void reset_ctype_locale() noexcept;
 
 string f$sprintf(const string &format, const array<mixed> &a);
 
@@ -345,39 +349,45 @@ Optional<string> f$strstr(const string &haystack, const mixed &needle, bool befo
   }
 }
 
+template<class T>
+void fill_strtr_matcher(StrtrMatcher &matcher, const array<T> &replace_pairs) {
+  for (typename array<T>::const_iterator p = replace_pairs.begin(); p != replace_pairs.end(); ++p) {
+    const string search = f$strval(p.get_key());
+    const string replace = f$strval(p.get_value());
+    matcher.add_pair(vk::string_view{search.c_str(), search.size()}, vk::string_view{replace.c_str(), replace.size()});
+  }
+}
+
 template<class T>
 string f$strtr(const string &subject, const array<T> &replace_pairs) {
-  const char *piece = subject.c_str(), *piece_end = subject.c_str() + subject.size();
-  string result;
-  while (1) {
-    const char *best_pos = nullptr;
-    int64_t best_len = -1;
-    string replace;
-    for (typename array<T>::const_iterator p = replace_pairs.begin(); p != replace_pairs.end(); ++p) {
-      const string search = f$strval(p.get_key());
-      int64_t search_len = search.size();
-      if (search_len == 0) {
-        return subject;
-      }
-      const char *pos = static_cast <const char *> (memmem(static_cast <const void *> (piece), (size_t)(piece_end - piece), static_cast <const void *> (search.c_str()), (size_t)search_len));
-      if (pos != nullptr && (best_pos == nullptr || best_pos > pos || (best_pos == pos && search_len > best_len))) {
-        best_pos = pos;
-        best_len = search_len;
-        replace = f$strval(p.get_value());
-      }
+  if (subject.empty() || replace_pairs.empty()) {
+    return subject;
+  }
+
+  const bool use_heap_memory = dl::get_script_memory_stats().memory_limit == 0;
+  // the constant replace pairs never change, so their matcher is built once in the heap memory and shared by the requests
+  if (!use_heap_memory && replace_pairs.is_reference_counter(ExtraRefCnt::for_global_const)) {
+    if (const StrtrMatcher *cached = find_persistent_strtr_matcher(replace_pairs.get_inner_pointer())) {
+      return cached->replace(subject);
     }
-    if (best_pos == nullptr) {
-      result.append(piece, static_cast<string::size_type>(piece_end - piece));
-      break;
+    const auto malloc_replacement_rollback = temporary_rollback_malloc_replacement();
+    auto matcher = std::make_unique<StrtrMatcher>();
+    fill_strtr_matcher(*matcher, replace_pairs);
+    if (!matcher->build()) {
+      return subject;
     }
-
-    result.append(piece, static_cast<string::size_type>(best_pos - piece));
-    result.append(replace);
-
-    piece = best_pos + best_len;
+    const StrtrMatcher *cached = add_persistent_strtr_matcher(replace_pairs.get_inner_pointer(), std::move(matcher));
+    // the matcher isn't taken if the cache is full
+    return cached ? cached->replace(subject) : matcher->replace(subject);
   }
 
-  return result;
+  const auto malloc_replacement_guard = make_malloc_replacement_with_script_allocator(!use_heap_memory);
+  StrtrMatcher matcher;
+  fill_strtr_matcher(matcher, replace_pairs);
+  if (!matcher.build()) {
+    return subject;
+  }
+  return matcher.replace(subject);
 }
 
 inline string f$strtr(const string &subject, const mixed &from, const mixed &to) {
@@ -0,0 +1,179 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/strtr-matcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+#include "runtime/allocator.h"
+
+void StrtrMatcher::add_pair(vk::string_view search, vk::string_view replace) noexcept {
+  total_length_ += search.size() + replace.size();
+  pairs_.emplace_back(std::string{search.data(), search.size()}, std::string{replace.data(), replace.size()});
+}
+
+bool StrtrMatcher::build() noexcept {
+  std::vector<int32_t> sorted(pairs_.size());
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::stable_sort(sorted.begin(), sorted.end(), [this](int32_t lhs, int32_t rhs) {
+    return pairs_[lhs].first < pairs_[rhs].first;
+  });
+  if (!sorted.empty() && pairs_[sorted.front()].first.empty()) {
+    return false;
+  }
+
+  struct pending_node {
+    uint32_t node_id;
+    size_t depth;
+    size_t first;
+    size_t last;
+  };
+
+  // all the searched strings in [first, last) have the same prefix of depth length, which leads to the node,
+  // the children of a node are stored contiguously and sorted by their bytes
+  nodes_.emplace_back();
+  std::vector<pending_node> pending{{0, 0, 0, sorted.size()}};
+  while (!pending.empty()) {
+    pending_node cur = pending.back();
+    pending.pop_back();
+    while (cur.first < cur.last && pairs_[sorted[cur.first]].first.size() == cur.depth) {
+      // the first of the equal strings wins as in the old implementation
+      if (nodes_[cur.node_id].pair == -1) {
+        nodes_[cur.node_id].pair = sorted[cur.first];
+      }
+      ++cur.first;
+    }
+
+    const auto children_begin = static_cast<uint32_t>(child_bytes_.size());
+    for (size_t group_first = cur.first; group_first < cur.last;) {
+      const auto c = static_cast<unsigned char>(pairs_[sorted[group_first]].first[cur.depth]);
+      size_t group_last = group_first + 1;
+      while (group_last < cur.last && static_cast<unsigned char>(pairs_[sorted[group_last]].first[cur.depth]) == c) {
+        ++group_last;
+      }
+      const auto child_id = static_cast<uint32_t>(nodes_.size());
+      nodes_.emplace_back();
+      child_bytes_.push_back(c);
+      child_nodes_.push_back(child_id);
+      if (cur.node_id == 0) {
+        root_children_[c] = child_id;
+      }
+      pending.push_back(pending_node{child_id, cur.depth + 1, group_first, group_last});
+      group_first = group_last;
+    }
+    nodes_[cur.node_id].children_begin = children_begin;
+    nodes_[cur.node_id].children_count = static_cast<uint32_t>(child_bytes_.size()) - children_begin;
+  }
+
+  if (nodes_[0].children_count == 1) {
+    single_first_byte_ = child_bytes_[0];
+  }
+  return true;
+}
+
+uint32_t StrtrMatcher::find_child(uint32_t node_id, unsigned char c) const noexcept {
+  const node &n = nodes_[node_id];
+  const unsigned char *first = child_bytes_.data() + n.children_begin;
+  const unsigned char *last = first + n.children_count;
+  const unsigned char *it = std::lower_bound(first, last, c);
+  return it != last && *it == c ? child_nodes_[it - child_bytes_.data()] : 0;
+}
+
+const char *StrtrMatcher::find_first_byte(const char *pos, const char *end) const noexcept {
+  if (single_first_byte_ >= 0) {
+    const void *found = memchr(pos, single_first_byte_, end - pos);
+    return found ? static_cast<const char *>(found) : end;
+  }
+  while (pos != end && !root_children_[static_cast<unsigned char>(*pos)]) {
+    ++pos;
+  }
+  return pos;
+}
+
+string StrtrMatcher::replace(const string &subject) const noexcept {
+  const char *const begin = subject.c_str();
+  const char *const end = begin + subject.size();
+  const char *copied = begin;
+  string result;
+  for (const char *pos = find_first_byte(begin, end); pos != end; pos = find_first_byte(pos, end)) {
+    uint32_t node_id = root_children_[static_cast<unsigned char>(*pos)];
+    int32_t best_pair = nodes_[node_id].pair;
+    const char *best_end = pos + 1;
+    for (const char *cur = pos + 1; cur != end && nodes_[node_id].children_count; ++cur) {
+      node_id = find_child(node_id, static_cast<unsigned char>(*cur));
+      if (!node_id) {
+        break;
+      }
+      if (nodes_[node_id].pair != -1) {
+        best_pair = nodes_[node_id].pair;
+        best_end = cur + 1;
+      }
+    }
+    if (best_pair == -1) {
+      ++pos;
+      continue;
+    }
+
+    if (copied == begin) {
+      result.reserve_at_least(subject.size());
+    }
+    const std::string &replace = pairs_[best_pair].second;
+    result.append(copied, static_cast<string::size_type>(pos - copied));
+    result.append(replace.data(), static_cast<string::size_type>(replace.size()));
+    pos = copied = best_end;
+  }
+
+  if (copied == begin) {
+    return subject;
+  }
+  result.append(copied, static_cast<string::size_type>(end - copied));
+  return result;
+}
+
+namespace {
+
+class PersistentStrtrMatchers : vk::not_copyable {
+public:
+  static PersistentStrtrMatchers &get() noexcept {
+    static PersistentStrtrMatchers cache;
+    return cache;
+  }
+
+  const StrtrMatcher *find(const void *replace_pairs) const noexcept {
+    auto it = cache_.find(replace_pairs);
+    return it != cache_.end() ? it->second.get() : nullptr;
+  }
+
+  const StrtrMatcher *add(const void *replace_pairs, std::unique_ptr<StrtrMatcher> &&matcher) noexcept {
+    php_assert(!dl::is_malloc_replaced());
+    if (cache_.size() >= MAX_CACHED_MATCHERS || total_length_ >= MAX_TOTAL_LENGTH) {
+      return nullptr;
+    }
+    total_length_ += matcher->get_total_length();
+    return cache_.emplace(replace_pairs, std::move(matcher)).first->second.get();
+  }
+
+private:
+  PersistentStrtrMatchers() = default;
+
+  static constexpr size_t MAX_CACHED_MATCHERS = 4096;
+  static constexpr size_t MAX_TOTAL_LENGTH = 16 * 1024 * 1024;
+
+  // the keys are the inner pointers of the constant arrays, they are never freed
+  std::unordered_map<const void *, std::unique_ptr<StrtrMatcher>> cache_;
+  size_t total_length_{0};
+};
+
+} // namespace
+
+const StrtrMatcher *find_persistent_strtr_matcher(const void *replace_pairs) noexcept {
+  return PersistentStrtrMatchers::get().find(replace_pairs);
+}
+
+const StrtrMatcher *add_persistent_strtr_matcher(const void *replace_pairs, std::unique_ptr<StrtrMatcher> &&matcher) noexcept {
+  return PersistentStrtrMatchers::get().add(replace_pairs, std::move(matcher));
+}
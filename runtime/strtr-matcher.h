@@ -0,0 +1,57 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+#include "common/wrappers/string_view.h"
+
+#include "runtime/kphp_core.h"
+
+// Finds all the searched strings of strtr($subject, $replace_pairs) in a single pass over the subject:
+// the searched strings are put into a trie, and at each position of the subject the longest of them is taken.
+// Only the positions starting with the first byte of some searched string are checked.
+class StrtrMatcher : vk::not_copyable {
+public:
+  void add_pair(vk::string_view search, vk::string_view replace) noexcept;
+  // returns false if some of the searched strings is empty
+  bool build() noexcept;
+
+  string replace(const string &subject) const noexcept;
+
+  size_t get_total_length() const noexcept {
+    return total_length_;
+  }
+
+private:
+  struct node {
+    uint32_t children_begin{0};
+    uint32_t children_count{0};
+    int32_t pair{-1};
+  };
+
+  uint32_t find_child(uint32_t node_id, unsigned char c) const noexcept;
+  const char *find_first_byte(const char *pos, const char *end) const noexcept;
+
+  std::vector<std::pair<std::string, std::string>> pairs_;
+  size_t total_length_{0};
+
+  std::vector<node> nodes_;
+  std::vector<unsigned char> child_bytes_;
+  std::vector<uint32_t> child_nodes_;
+  // the children of the root, 0 means there is no searched string starting with the byte
+  std::array<uint32_t, 256> root_children_{};
+  // if all the searched strings start with the same byte, it is looked up with memchr
+  int32_t single_first_byte_{-1};
+};
+
+// The matchers of the constant replace pairs are built once and live till the end of the worker
+const StrtrMatcher *find_persistent_strtr_matcher(const void *replace_pairs) noexcept;
+// returns nullptr if the cache is full
+const StrtrMatcher *add_persistent_strtr_matcher(const void *replace_pairs, std::unique_ptr<StrtrMatcher> &&matcher) noexcept;
@@ -76,26 +76,6 @@ inline void fetch_magic_if_not_bare(unsigned int inner_magic, const char *error_
   }
 }
 
-template<class T>
-inline void fetch_raw_vector_T(array<T> &out __attribute__ ((unused)), int64_t n_elems __attribute__ ((unused))) {
-  php_assert(0 && "never called in runtime");
-}
-
-template<>
-inline void fetch_raw_vector_T<double>(array<double> &out, int64_t n_elems) {
-  f$fetch_raw_vector_double(out, n_elems);
-}
-
-template<class T>
-inline void store_raw_vector_T(const array<T> &v __attribute__ ((unused))) {
-  php_assert(0 && "never called in runtime");
-}
-
-template<>
-inline void store_raw_vector_T<double>(const array<double> &v) {
-  f$store_raw_vector_double(v);
-}
-
 // Wrap into Optional that TL types which PhpType is:
 //  1. int, double, string, bool
 //  2. array<T>
@@ -138,6 +118,20 @@ get_serialization_target_from_optional_field(OptionalFieldT &v) {
   return v;
 }
 
+// the consecutive fixed size fields of a combinator are packed to the words of one buffer,
+// which is stored or fetched at once, see CombinatorGen::gen_fixed_size_args_processing()
+template<typename T>
+inline T tl_packed_get(const int32_t *packed, int word) {
+  T value;
+  memcpy(&value, packed + word, sizeof(T));
+  return value;
+}
+
+template<typename T>
+inline void tl_packed_set(int32_t *packed, int word, T value) {
+  memcpy(packed + word, &value, sizeof(T));
+}
+
 struct t_Int {
   void store(const mixed &tl_object) {
     int32_t v32 = prepare_int_for_storing(f$intval(tl_object));
@@ -318,6 +312,77 @@ struct t_True {
   }
 };
 
+// Vectors of these element types are fetched and stored in one pass over the raw rpc buffer,
+// instead of the per element typed_fetch_to/typed_store calls
+template<class T>
+struct tl_raw_vector {
+  static constexpr bool fetchable = false;
+  static constexpr bool storable = false;
+
+  template<class PhpT>
+  static void fetch(array<PhpT> &out __attribute__ ((unused)), int64_t n_elems __attribute__ ((unused))) {
+    php_assert(0 && "never called in runtime");
+  }
+
+  template<class PhpT>
+  static void store(const array<PhpT> &v __attribute__ ((unused))) {
+    php_assert(0 && "never called in runtime");
+  }
+};
+
+template<>
+struct tl_raw_vector<t_Double> : tl_raw_vector<void> {
+  static constexpr bool fetchable = true;
+  static constexpr bool storable = true;
+
+  static void fetch(array<double> &out, int64_t n_elems) {
+    f$fetch_raw_vector_double(out, n_elems);
+  }
+
+  static void store(const array<double> &v) {
+    f$store_raw_vector_double(v);
+  }
+};
+
+template<>
+struct tl_raw_vector<tl_Long_impl<true>> : tl_raw_vector<void> {
+  static constexpr bool fetchable = true;
+  static constexpr bool storable = true;
+
+  static void fetch(array<int64_t> &out, int64_t n_elems) {
+    fetch_raw_vector_long(out, n_elems);
+  }
+
+  static void store(const array<int64_t> &v) {
+    store_raw_vector_long(v);
+  }
+};
+
+// ints are widened on fetching; storing is left per element because of the int32 overflow checks
+template<>
+struct tl_raw_vector<t_Int> : tl_raw_vector<void> {
+  static constexpr bool fetchable = true;
+  static constexpr bool storable = true;
+
+  static void fetch(array<int64_t> &out, int64_t n_elems) {
+    fetch_raw_vector_int(out, n_elems);
+  }
+
+  // the ints are narrowed with the overflow check, so they are stored by chunks instead of a single memcpy
+  static void store(const array<int64_t> &v) {
+    constexpr int64_t chunk_size = 256;
+    int32_t chunk[chunk_size];
+    const int64_t *values = v.get_const_vector_pointer();
+    for (int64_t from = 0, n = v.count(); from < n; from += chunk_size) {
+      const int64_t len = std::min(chunk_size, n - from);
+      for (int64_t i = 0; i < len; ++i) {
+        chunk[i] = t_Int::prepare_int_for_storing(values[from + i]);
+      }
+      store_raw_words(chunk, len);
+    }
+  }
+};
+
 template<typename T, unsigned int inner_magic>
 struct t_Vector {
   T elem_state;
@@ -367,8 +432,8 @@ struct t_Vector {
     int64_t n = v.count();
     f$store_int(n);
 
-    if (std::is_same<T, t_Double>{} && inner_magic == 0 && v.is_vector()) {
-      store_raw_vector_T<typename T::PhpType>(v);
+    if (tl_raw_vector<T>::storable && inner_magic == 0 && v.is_vector()) {
+      tl_raw_vector<T>::store(v);
       return;
     }
 
@@ -391,8 +456,8 @@ struct t_Vector {
     }
     out.reserve(n, 0, true);
 
-    if (std::is_same<T, t_Double>{} && inner_magic == 0) {
-      fetch_raw_vector_T<typename T::PhpType>(out, n);
+    if (tl_raw_vector<T>::fetchable && inner_magic == 0) {
+      tl_raw_vector<T>::fetch(out, n);
       return;
     }
 
@@ -600,8 +665,8 @@ struct t_Tuple {
   using PhpType = array<typename T::PhpType>;
 
   void typed_store(const PhpType &v) {
-    if (std::is_same<T, t_Double>{} && inner_magic == 0 && v.is_vector() && v.count() == size) {
-      store_raw_vector_T<typename T::PhpType>(v);
+    if (tl_raw_vector<T>::storable && inner_magic == 0 && v.is_vector() && v.count() == size) {
+      tl_raw_vector<T>::store(v);
       return;
     }
 
@@ -619,8 +684,8 @@ struct t_Tuple {
     CHECK_EXCEPTION(return);
     out.reserve(size, 0, true);
 
-    if (std::is_same<T, t_Double>{} && inner_magic == 0) {
-      fetch_raw_vector_T<typename T::PhpType>(out, size);
+    if (tl_raw_vector<T>::fetchable && inner_magic == 0) {
+      tl_raw_vector<T>::fetch(out, size);
       return;
     }
 
@@ -673,8 +738,8 @@ struct tl_array {
   using PhpType = array<typename T::PhpType>;
 
   void typed_store(const PhpType &v) {
-    if (std::is_same<T, t_Double>{} && inner_magic == 0 && v.is_vector() && v.count() == size) {
-      store_raw_vector_T<typename T::PhpType>(v);
+    if (tl_raw_vector<T>::storable && inner_magic == 0 && v.is_vector() && v.count() == size) {
+      tl_raw_vector<T>::store(v);
       return;
     }
 
@@ -692,8 +757,8 @@ struct tl_array {
     CHECK_EXCEPTION(return);
     out.reserve(size, 0, true);
 
-    if (std::is_same<T, t_Double>{} && inner_magic == 0) {
-      fetch_raw_vector_T<typename T::PhpType>(out, size);
+    if (tl_raw_vector<T>::fetchable && inner_magic == 0) {
+      tl_raw_vector<T>::fetch(out, size);
       return;
     }
 
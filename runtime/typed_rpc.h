@@ -60,6 +60,33 @@ array<int64_t> f$typed_rpc_tl_query(const class_instance<C$RpcConnection> &conne
   return queries;
 }
 
+template<typename F, typename R = KphpRpcRequest>
+array<int64_t> f$typed_rpc_tl_query_multi(const array<class_instance<C$RpcConnection>> &connections,
+                                          const array<class_instance<F>> &query_functions,
+                                          double timeout = -1.0,
+                                          bool ignore_answer = false) {
+  static_assert(std::is_base_of<C$VK$TL$RpcFunction, F>::value, "Unexpected type");
+  static_assert(std::is_same<KphpRpcRequest, R>::value, "Unexpected type");
+
+  array<int64_t> queries(query_functions.size());
+  size_t bytes_sent = 0;
+  for (auto it = query_functions.begin(); it != query_functions.end(); ++it) {
+    const class_instance<C$RpcConnection> *connection = connections.find_value(it.get_key());
+    if (unlikely(connection == nullptr)) {
+      php_warning("No RpcConnection specified for rpc query");
+      queries.set_value(it.get_key(), 0);
+      continue;
+    }
+    int64_t rpc_query = typed_rpc_tl_query_impl(*connection, R{it.get_value()}, timeout, ignore_answer, true, bytes_sent, false);
+    queries.set_value(it.get_key(), rpc_query);
+  }
+  if (bytes_sent > 0) {
+    f$rpc_flush();
+  }
+
+  return queries;
+}
+
 template<typename I, typename F = rpcResponseErrorFactory>
 class_instance<C$VK$TL$RpcResponse> f$typed_rpc_tl_query_result_one(I query_id) {
   static_assert(std::is_same<int64_t, I>::value, "Unexpected type");
@@ -130,6 +130,29 @@ array<std::tuple<double, double>> f$UberH3$$h3ToGeoBoundary(int64_t h3_index) no
   return result;
 }
 
+array<int64_t> f$UberH3$$geoToH3Batch(const array<std::tuple<double, double>> &coordinates, int64_t resolution) noexcept {
+  const int32_t checked_resolution = check_resolution_param(resolution);
+  if (unlikely(checked_resolution != resolution)) {
+    return make_zeros_vector<int64_t>(coordinates.count());
+  }
+  array<int64_t> result{array_size{coordinates.count(), 0, true}};
+  for (const auto &coordinate : coordinates) {
+    const auto geo_cord = deg2coord(coordinate.get_value());
+    result.emplace_back(static_cast<int64_t>(geoToH3(&geo_cord, checked_resolution)));
+  }
+  return result;
+}
+
+array<std::tuple<double, double>> f$UberH3$$h3ToGeoBatch(const array<int64_t> &h3_indexes) noexcept {
+  array<std::tuple<double, double>> result{array_size{h3_indexes.count(), 0, true}};
+  for (const auto &h3_index : h3_indexes) {
+    GeoCoord geo_coord{};
+    h3ToGeo(h3_index.get_value(), &geo_coord);
+    result.emplace_back(coord2deg(geo_coord));
+  }
+  return result;
+}
+
 
 int64_t f$UberH3$$h3GetResolution(int64_t h3_index) noexcept {
   return h3GetResolution(static_cast<H3Index>(h3_index));
@@ -191,6 +214,27 @@ Optional<array<int64_t>> f$UberH3$$kRing(int64_t h3_index_origin, int64_t k) noe
   return std::move(neighbor_indexes);
 }
 
+// the neighbors of each origin take maxKringSize(k) elements of the result, the missing ones are zeros
+Optional<array<int64_t>> f$UberH3$$kRings(const array<int64_t> &h3_indexes, int64_t k) noexcept {
+  const int32_t checked_k = check_k_param(k);
+  if (unlikely(checked_k != k)) {
+    return false;
+  }
+
+  const int32_t neighbors_count = maxKringSize(checked_k);
+  auto neighbor_indexes = make_zeros_vector<int64_t>(neighbors_count * h3_indexes.count());
+  if (!neighbor_indexes.empty()) {
+    // kRing() uses malloc
+    auto malloc_replacer = make_malloc_replacement_with_script_allocator();
+    auto *neighbors = reinterpret_cast<H3Index *>(&neighbor_indexes[0]);
+    for (const auto &h3_index : h3_indexes) {
+      kRing(h3_index.get_value(), checked_k, neighbors);
+      neighbors += neighbors_count;
+    }
+  }
+  return std::move(neighbor_indexes);
+}
+
 int64_t f$UberH3$$maxKringSize(int64_t k) noexcept {
   const int32_t checked_k = check_k_param(k);
   return checked_k != k ? 0 : maxKringSize(checked_k);
@@ -9,6 +9,8 @@
 int64_t f$UberH3$$geoToH3(double latitude, double longitude, int64_t resolution) noexcept;
 std::tuple<double, double> f$UberH3$$h3ToGeo(int64_t h3_index) noexcept;
 array<std::tuple<double, double>> f$UberH3$$h3ToGeoBoundary(int64_t h3_index) noexcept;
+array<int64_t> f$UberH3$$geoToH3Batch(const array<std::tuple<double, double>> &coordinates, int64_t resolution) noexcept;
+array<std::tuple<double, double>> f$UberH3$$h3ToGeoBatch(const array<int64_t> &h3_indexes) noexcept;
 
 int64_t f$UberH3$$h3GetResolution(int64_t h3_index) noexcept;
 int64_t f$UberH3$$h3GetBaseCell(int64_t h3_index) noexcept;
@@ -21,6 +23,7 @@ array<int64_t> f$UberH3$$h3GetFaces(int64_t h3_index) noexcept;
 int64_t f$UberH3$$maxFaceCount(int64_t h3_index) noexcept;
 
 Optional<array<int64_t>> f$UberH3$$kRing(int64_t h3_index_origin, int64_t k) noexcept;
+Optional<array<int64_t>> f$UberH3$$kRings(const array<int64_t> &h3_indexes, int64_t k) noexcept;
 int64_t f$UberH3$$maxKringSize(int64_t k) noexcept;
 Optional<array<std::tuple<int64_t, int64_t>>> f$UberH3$$kRingDistances(int64_t h3_index_origin, int64_t k) noexcept;
 Optional<array<int64_t>> f$UberH3$$hexRange(int64_t h3_index_origin, int64_t k) noexcept;
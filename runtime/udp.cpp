@@ -7,6 +7,7 @@
 #include <cerrno>
 #include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include "common/resolver.h"
 
@@ -23,6 +24,17 @@ static char opened_udp_sockets_storage[sizeof(array<int>)];
 static array<int> *opened_udp_sockets = reinterpret_cast <array<int> *> (opened_udp_sockets_storage);
 static long long opened_udp_sockets_last_query_num = -1;
 
+// stream_set_write_buffer() makes fwrite() queue the datagrams of the socket,
+// they are sent by sendmmsg() when the queue is full, on fflush(), fclose() and at the end of the script
+struct UdpWriteBuffer {
+  int64_t limit{0};
+  int64_t size{0};
+  array<string> datagrams;
+};
+
+static char udp_write_buffers_storage[sizeof(array<UdpWriteBuffer>)];
+static array<UdpWriteBuffer> *udp_write_buffers = reinterpret_cast <array<UdpWriteBuffer> *> (udp_write_buffers_storage);
+
 static Stream udp_stream_socket_client(const string &url, int64_t &error_number, string &error_description, double timeout,
                                        int64_t flags __attribute__((unused)), const mixed &options __attribute__((unused))) {
 #define RETURN                                          \
@@ -118,6 +130,7 @@ static Stream udp_stream_socket_client(const string &url, int64_t &error_number,
 
   if (dl::query_num != opened_udp_sockets_last_query_num) {
     new(opened_udp_sockets_storage) array<int>();
+    new(udp_write_buffers_storage) array<UdpWriteBuffer>();
     opened_udp_sockets_last_query_num = dl::query_num;
   }
   string stream_key = url;
@@ -155,6 +168,56 @@ static int udp_get_fd(const Stream &stream) {
   return opened_udp_sockets->get_value(stream_key);
 }
 
+static bool udp_send_datagrams(int sock_fd, const array<string> &datagrams) {
+  constexpr int64_t MAX_BATCH_SIZE = 64;
+  mmsghdr messages[MAX_BATCH_SIZE];
+  iovec vectors[MAX_BATCH_SIZE];
+
+  auto it = datagrams.begin();
+  int64_t left = datagrams.count();
+  while (left > 0) {
+    const int64_t batch_size = std::min(left, MAX_BATCH_SIZE);
+    auto batch_it = it;
+    for (int64_t i = 0; i < batch_size; ++i, ++batch_it) {
+      const string &datagram = batch_it.get_value();
+      vectors[i] = iovec{const_cast<char *>(datagram.c_str()), datagram.size()};
+      messages[i] = mmsghdr{};
+      messages[i].msg_hdr.msg_iov = &vectors[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    dl::enter_critical_section(); // OK
+    const int sent = sendmmsg(sock_fd, messages, static_cast<unsigned int>(batch_size), 0);
+    dl::leave_critical_section();
+    if (sent == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      php_warning("An error occurred while sending UPD-packages");
+      return false;
+    }
+    for (int i = 0; i < sent; ++i) {
+      ++it;
+    }
+    left -= sent;
+  }
+  return true;
+}
+
+static bool udp_flush_write_buffer(const string &stream_key, int sock_fd) {
+  if (!udp_write_buffers->has_key(stream_key)) {
+    return true;
+  }
+  UdpWriteBuffer &buffer = (*udp_write_buffers)[stream_key];
+  if (buffer.datagrams.empty()) {
+    return true;
+  }
+  const array<string> datagrams = std::move(buffer.datagrams);
+  buffer.datagrams = array<string>();
+  buffer.size = 0;
+  return udp_send_datagrams(sock_fd, datagrams);
+}
+
 static Optional<int64_t> udp_fwrite(const Stream &stream, const string &data) {
   int sock_fd = udp_get_fd(stream);
   if (sock_fd == -1) {
@@ -165,6 +228,20 @@ static Optional<int64_t> udp_fwrite(const Stream &stream, const string &data) {
   if (data_len == 0) {
     return 0;
   }
+
+  const string stream_key = stream.to_string();
+  if (udp_write_buffers->has_key(stream_key)) {
+    UdpWriteBuffer &buffer = (*udp_write_buffers)[stream_key];
+    if (buffer.size + static_cast<int64_t>(data_len) > buffer.limit && !udp_flush_write_buffer(stream_key, sock_fd)) {
+      return false;
+    }
+    if (static_cast<int64_t>(data_len) <= buffer.limit) {
+      buffer.datagrams.push_back(data);
+      buffer.size += static_cast<int64_t>(data_len);
+      return static_cast<int64_t>(data_len);
+    }
+  }
+
   dl::enter_critical_section(); // OK
   ssize_t res = send(sock_fd, data_ptr, data_len, 0);
   dl::leave_critical_section();
@@ -175,6 +252,14 @@ static Optional<int64_t> udp_fwrite(const Stream &stream, const string &data) {
   return res;
 }
 
+static bool udp_fflush(const Stream &stream) {
+  int sock_fd = udp_get_fd(stream);
+  if (sock_fd == -1) {
+    return false;
+  }
+  return udp_flush_write_buffer(stream.to_string(), sock_fd);
+}
+
 static bool udp_fclose(const Stream &stream) {
   string stream_key = stream.to_string();
 
@@ -182,13 +267,46 @@ static bool udp_fclose(const Stream &stream) {
     return false;
   }
 
+  udp_flush_write_buffer(stream_key, opened_udp_sockets->get_value(stream_key));
   dl::enter_critical_section();
   int result = close(opened_udp_sockets->get_value(stream_key));
   opened_udp_sockets->unset(stream_key);
+  udp_write_buffers->unset(stream_key);
   dl::leave_critical_section();
   return result == 0;
 }
 
+static bool udp_stream_set_option(const Stream &stream, int64_t option, int64_t value) {
+  int sock_fd = udp_get_fd(stream);
+  if (sock_fd == -1) {
+    return false;
+  }
+
+  switch (option) {
+    case STREAM_SET_WRITE_BUFFER_OPTION: {
+      const string stream_key = stream.to_string();
+      if (!udp_flush_write_buffer(stream_key, sock_fd)) {
+        return false;
+      }
+      if (value > 0) {
+        (*udp_write_buffers)[stream_key].limit = value;
+      } else {
+        udp_write_buffers->unset(stream_key);
+      }
+      return true;
+    }
+    case STREAM_SET_BLOCKING_OPTION:
+      php_warning("UDP wrapper doesn't support function stream_set_blocking");
+      return false;
+    case STREAM_SET_READ_BUFFER_OPTION:
+      php_warning("UDP wrapper doesn't support function stream_set_read_buffer");
+      return false;
+    default:
+      php_assert (0);
+  }
+  return false;
+}
+
 void global_init_udp_lib() {
   static stream_functions udp_stream_functions;
 
@@ -201,7 +319,7 @@ void global_init_udp_lib() {
   udp_stream_functions.fgetc = nullptr;
   udp_stream_functions.fgets = nullptr;
   udp_stream_functions.fpassthru = nullptr;
-  udp_stream_functions.fflush = nullptr;
+  udp_stream_functions.fflush = udp_fflush;
   udp_stream_functions.feof = nullptr;
   udp_stream_functions.fclose = udp_fclose;
 
@@ -210,13 +328,20 @@ void global_init_udp_lib() {
 
   udp_stream_functions.stream_socket_client = udp_stream_socket_client;
   udp_stream_functions.context_set_option = nullptr;
-  udp_stream_functions.stream_set_option = nullptr;
+  udp_stream_functions.stream_set_option = udp_stream_set_option;
   udp_stream_functions.get_fd = udp_get_fd;
 
   register_stream_functions(&udp_stream_functions, false);
 }
 
 void free_udp_lib() {
+  if (dl::query_num == opened_udp_sockets_last_query_num) {
+    const array<int> *const_opened_udp_sockets = opened_udp_sockets;
+    for (array<int>::const_iterator p = const_opened_udp_sockets->begin(); p != const_opened_udp_sockets->end(); ++p) {
+      udp_flush_write_buffer(p.get_key().to_string(), p.get_value());
+    }
+  }
+
   dl::enter_critical_section();//OK
   if (dl::query_num == opened_udp_sockets_last_query_num) {
     const array<int> *const_opened_udp_sockets = opened_udp_sockets;
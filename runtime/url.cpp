@@ -4,6 +4,8 @@
 
 #include "runtime/url.h"
 
+#include "common/string-kernels.h"
+
 #include "runtime/array_functions.h"
 #include "runtime/regexp.h"
 
@@ -49,11 +51,13 @@ Optional<string> f$base64_decode(const string &s, bool strict) {
   /* run through the whole string, converting as we go */
   string::size_type result_len = (s.size() + 3) / 4 * 3;
   string result(result_len, false);
-  int i = 0;
-  string::size_type j = 0;
+  // the plain groups without paddings and whitespaces are decoded by the vectorized kernel, the rest goes as in php
+  string::size_type pos = base64_decode_groups(s.c_str(), s.size(), result.buffer());
+  int i = static_cast<int>(pos);
+  string::size_type j = pos / 4 * 3;
   int padding = 0;
-  for (string::size_type pos = 0; pos < s.size(); pos++) {
-    int ch = s[pos];
+  for (; pos < s.size(); pos++) {
+    int ch = static_cast<unsigned char>(s[pos]);
     if (ch == '=') {
       padding++;
       continue;
@@ -110,58 +114,21 @@ Optional<string> f$base64_decode(const string &s, bool strict) {
   return result;
 }
 
-int base64_encode(const unsigned char *const input, int ilen, char *output, int olen) {
-  static const char* const symbols64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
-
-  auto next_input_uchar = [input, ilen](int &i) {
-    if (i >= ilen) return static_cast<unsigned char>(0);
-    return input[i++];
-  };
-
-  int i, j = 0;
-  char buf[4];
-  for (i = 0; i < ilen; ) {
-    int old_i = i;
-    int o = next_input_uchar(i);
-    o <<= 8;
-    o |= next_input_uchar(i);
-    o <<= 8;
-    o |= next_input_uchar(i);
-    int l = i - old_i;
-    assert (l > 0 && l <= 3);
-    int u;
-    for (u = 3; u >= 0; u--) {
-      buf[u] = symbols64[o & 63];
-      o >>= 6;
-    }
-    if (l == 1) {
-      buf[2] = buf[3] = '=';
-    }
-    else if (l == 2) {
-      buf[3] = '=';
-    }
-    if (j + 3 >= olen) {
-      return -1;
-    }
-    memcpy (&output[j], buf, 4);
-    j += 4;
-  }
-  if (j >= olen) {
-    return -1;
-  }
-  output[j++] = 0;
-  return 0;
-}
-
 string f$base64_encode(const string &s) {
-  int result_len = (s.size() + 2) / 3 * 4;
-  string res(result_len, false);
-  result_len = base64_encode(reinterpret_cast <const unsigned char *> (s.c_str()), (int)s.size(), res.buffer(), result_len + 1);
-
-  if (result_len != 0) {
-    return string();
+  const string::size_type len = s.size();
+  string res((len + 2) / 3 * 4, false);
+  const size_t encoded = base64_encode_groups(s.c_str(), len, res.buffer());
+  if (encoded < len) {
+    // the last incomplete group is encoded with zero bytes and the extra symbols are replaced by paddings
+    char last_group[3] = {0, 0, 0};
+    memcpy(last_group, s.c_str() + encoded, len - encoded);
+    char *dst = res.buffer() + encoded / 3 * 4;
+    base64_encode_groups_generic(last_group, 3, dst);
+    dst[3] = '=';
+    if (len - encoded == 1) {
+      dst[2] = '=';
+    }
   }
-
   return res;
 }
 
@@ -201,19 +168,26 @@ void parse_str_set_value(mixed &arr, const string &key, const string &value) {
 void f$parse_str(const string &str, mixed &arr) {
   arr = array<mixed>();
 
-  array<string> par = explode('&', str, INT_MAX);
-  int64_t len = par.count();
-  for (int64_t i = 0; i < len; i++) {
-    const char *cur = par.get_value(i).c_str();
-    const char *eq_pos = strchrnul(cur, '=');
+  // the keys and the values are decoded right from the pieces of str
+  const char *cur = str.c_str();
+  const char *str_end = cur + str.size();
+  while (true) {
+    const char *piece_end = static_cast<const char *>(memchr(cur, '&', str_end - cur));
+    if (piece_end == nullptr) {
+      piece_end = str_end;
+    }
+    const char *eq_pos = static_cast<const char *>(memchr(cur, '=', piece_end - cur));
     string value;
-    if (*eq_pos) {
-      value = f$urldecode(string(eq_pos + 1));
+    if (eq_pos != nullptr) {
+      value = url_decode(eq_pos + 1, static_cast<size_t>(piece_end - eq_pos - 1), false);
+    } else {
+      eq_pos = piece_end;
     }
-
-    string key(cur, static_cast<string::size_type>(eq_pos - cur));
-    key = f$urldecode(key);
-    parse_str_set_value(arr, key, value);
+    parse_str_set_value(arr, url_decode(cur, static_cast<size_t>(eq_pos - cur), false), value);
+    if (piece_end == str_end) {
+      break;
+    }
+    cur = piece_end + 1;
   }
 }
 
@@ -446,84 +420,108 @@ mixed f$parse_url(const string &s, int64_t component) {
   return url_as_array;
 }
 
-string f$rawurldecode(const string &s) {
-  static_SB.clean().reserve(s.size());
-  for (int i = 0; i < (int)s.size(); i++) {
-    if (s[i] == '%') {
-      int num_high = hex_to_int(s[i + 1]);
-      if (num_high < 16) {
-        int num_low = hex_to_int(s[i + 2]);
-        if (num_low < 16) {
-          static_SB.append_char(static_cast<char>((num_high << 4) + num_low));
-          i += 2;
-          continue;
-        }
+string url_decode(const char *s, size_t len, bool raw) {
+  const char *special_chars = raw ? "%" : "%+";
+  const size_t special_chars_count = raw ? 1 : 2;
+  size_t i = find_first_of_chars(s, len, special_chars, special_chars_count);
+  if (i == len) {
+    return string(s, static_cast<string::size_type>(len));
+  }
+
+  // the decoded string is never longer
+  string result(static_cast<string::size_type>(len), false);
+  char *dst = result.buffer();
+  memcpy(dst, s, i);
+  dst += i;
+  while (i < len) {
+    if (s[i] == '+') {
+      *dst++ = ' ';
+      ++i;
+    } else {
+      const uint8_t num_high = i + 2 < len ? hex_to_int(s[i + 1]) : 16;
+      const uint8_t num_low = i + 2 < len ? hex_to_int(s[i + 2]) : 16;
+      if (num_high < 16 && num_low < 16) {
+        *dst++ = static_cast<char>((num_high << 4) + num_low);
+        i += 3;
+      } else {
+        *dst++ = '%';
+        ++i;
       }
     }
-    static_SB.append_char(s[i]);
+    const size_t plain_len = find_first_of_chars(s + i, len - i, special_chars, special_chars_count);
+    memcpy(dst, s + i, plain_len);
+    dst += plain_len;
+    i += plain_len;
   }
-  return static_SB.str();
+  result.shrink(static_cast<string::size_type>(dst - result.c_str()));
+  return result;
 }
 
+static string url_decode(const string &s, bool raw) {
+  if (find_first_of_chars(s.c_str(), s.size(), raw ? "%" : "%+", raw ? 1 : 2) == s.size()) {
+    return s;
+  }
+  return url_decode(s.c_str(), s.size(), raw);
+}
 
-static const char *good_url_symbols =
-  "00000000000000000000000000000000"
-  "00000000000001101111111111000000"
-  "01111111111111111111111111100001"
-  "01111111111111111111111111100000"
-  "00000000000000000000000000000000"
-  "00000000000000000000000000000000"
-  "00000000000000000000000000000000"
-  "00000000000000000000000000000000";//[0-9a-zA-Z-_.]
-
-string f$rawurlencode(const string &s) {
-  static_SB.clean().reserve(3 * s.size());
-  for (int i = 0; i < (int)s.size(); i++) {
-    if (good_url_symbols[(unsigned char)s[i]] == '1') {
-      static_SB.append_char(s[i]);
-    } else {
-      static_SB.append_char('%');
-      static_SB.append_char(uhex_digits[(s[i] >> 4) & 15]);
-      static_SB.append_char(uhex_digits[s[i] & 15]);
+size_t url_encoded_length(const char *s, size_t len, bool raw) {
+  size_t encoded_len = 0;
+  for (size_t i = 0; i < len;) {
+    const size_t plain_len = url_unreserved_prefix_length(s + i, len - i);
+    encoded_len += plain_len;
+    i += plain_len;
+    if (i < len) {
+      encoded_len += !raw && s[i] == ' ' ? 1 : 3;
+      ++i;
     }
   }
-  return static_SB.str();
+  return encoded_len;
 }
 
-string f$urldecode(const string &s) {
-  static_SB.clean().reserve(s.size());
-  for (int i = 0; i < (int)s.size(); i++) {
-    if (s[i] == '%') {
-      int num_high = hex_to_int(s[i + 1]);
-      if (num_high < 16) {
-        int num_low = hex_to_int(s[i + 2]);
-        if (num_low < 16) {
-          static_SB.append_char(static_cast<char>((num_high << 4) + num_low));
-          i += 2;
-          continue;
-        }
+char *url_encode(const char *s, size_t len, bool raw, char *dst) {
+  for (size_t i = 0; i < len;) {
+    const size_t plain_len = url_unreserved_prefix_length(s + i, len - i);
+    memcpy(dst, s + i, plain_len);
+    dst += plain_len;
+    i += plain_len;
+    if (i < len) {
+      if (!raw && s[i] == ' ') {
+        *dst++ = '+';
+      } else {
+        dst[0] = '%';
+        dst[1] = uhex_digits[(s[i] >> 4) & 15];
+        dst[2] = uhex_digits[s[i] & 15];
+        dst += 3;
       }
-    } else if (s[i] == '+') {
-      static_SB.append_char(' ');
-      continue;
+      ++i;
     }
-    static_SB.append_char(s[i]);
   }
-  return static_SB.str();
+  return dst;
 }
 
-string f$urlencode(const string &s) {
-  static_SB.clean().reserve(3 * s.size());
-  for (int i = 0; i < (int)s.size(); i++) {
-    if (good_url_symbols[(unsigned char)s[i]] == '1') {
-      static_SB.append_char(s[i]);
-    } else if (s[i] == ' ') {
-      static_SB.append_char('+');
-    } else {
-      static_SB.append_char('%');
-      static_SB.append_char(uhex_digits[(s[i] >> 4) & 15]);
-      static_SB.append_char(uhex_digits[s[i] & 15]);
-    }
+// the encoded length is counted first, so the result is allocated once, and a string without special chars is shared
+static string url_encode(const string &s, bool raw) {
+  const size_t len = s.size();
+  if (url_unreserved_prefix_length(s.c_str(), len) == len) {
+    return s;
   }
-  return static_SB.str();
+  string result(static_cast<string::size_type>(url_encoded_length(s.c_str(), len, raw)), false);
+  url_encode(s.c_str(), len, raw, result.buffer());
+  return result;
+}
+
+string f$rawurldecode(const string &s) {
+  return url_decode(s, true);
+}
+
+string f$rawurlencode(const string &s) {
+  return url_encode(s, true);
+}
+
+string f$urldecode(const string &s) {
+  return url_decode(s, false);
+}
+
+string f$urlencode(const string &s) {
+  return url_encode(s, false);
 }
@@ -33,6 +33,12 @@ string f$urldecode(const string &s);
 
 string f$urlencode(const string &s);
 
+// raw is for rfc 3986, where a space is encoded as %20 and a plus is not decoded into a space
+string url_decode(const char *s, size_t len, bool raw);
+size_t url_encoded_length(const char *s, size_t len, bool raw);
+// writes url_encoded_length() bytes into dst and returns the pointer after them
+char *url_encode(const char *s, size_t len, bool raw, char *dst);
+
 /*
  *
  *     IMPLEMENTATION
@@ -67,16 +73,15 @@ string http_build_query_get_param(const string &key, const T &a,
   if (f$is_array(a)) {
     return http_build_query_get_param_array(key, f$arrayval(a), arg_separator, enc_type);
   } else {
-    auto encode = [&](string s) {
-      if (enc_type == PHP_QUERY_RFC1738) {
-        return f$urlencode(s);
-      } else {
-        return f$rawurlencode(s);
-      }
-    };
-    string key_encoded = encode(key);
-    string value_encoded = encode(f$strval(a));
-    return (static_SB.clean() << key_encoded << '=' << value_encoded).str();
+    // key=value is encoded right into the result
+    const bool raw = enc_type != PHP_QUERY_RFC1738;
+    const string value = f$strval(a);
+    const size_t key_len = url_encoded_length(key.c_str(), key.size(), raw);
+    string result(static_cast<string::size_type>(key_len + 1 + url_encoded_length(value.c_str(), value.size(), raw)), false);
+    char *dst = url_encode(key.c_str(), key.size(), raw, result.buffer());
+    *dst++ = '=';
+    url_encode(value.c_str(), value.size(), raw, dst);
+    return result;
   }
 }
 
@@ -0,0 +1,129 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "common/vector-kernels.h"
+
+namespace {
+
+bool check_vector(const array<double> &a, const char *function) noexcept {
+  if (unlikely(!a.is_vector())) {
+    php_warning("%s: the arrays with the keys 0..n-1 are expected", function);
+    return false;
+  }
+  return true;
+}
+
+bool check_vectors(const array<double> &a, const array<double> &b, const char *function) noexcept {
+  if (!check_vector(a, function) || !check_vector(b, function)) {
+    return false;
+  }
+  if (unlikely(a.count() != b.count())) {
+    php_warning("%s: the vectors of the same length are expected, %" PRIi64 " and %" PRIi64 " are given", function, a.count(), b.count());
+    return false;
+  }
+  return true;
+}
+
+double dot_product(const array<double> &a, const array<double> &b) noexcept {
+  return dot_product_f64(a.get_const_vector_pointer(), b.get_const_vector_pointer(), static_cast<size_t>(a.count()));
+}
+
+struct TopValue {
+  double value;
+  int64_t order;
+  array<double>::const_iterator it;
+
+  // NaN is less than any number
+  bool operator>(const TopValue &other) const noexcept {
+    if (value != other.value) {
+      return std::isnan(other.value) || value > other.value;
+    }
+    return order < other.order;
+  }
+};
+
+} // namespace
+
+double f$vk_vector_norm(const array<double> &a) noexcept {
+  if (!check_vector(a, "vk_vector_norm")) {
+    return 0.0;
+  }
+  return std::sqrt(dot_product(a, a));
+}
+
+double f$vk_vector_l2_distance(const array<double> &a, const array<double> &b) noexcept {
+  if (!check_vectors(a, b, "vk_vector_l2_distance")) {
+    return 0.0;
+  }
+  return std::sqrt(squared_l2_distance_f64(a.get_const_vector_pointer(), b.get_const_vector_pointer(), static_cast<size_t>(a.count())));
+}
+
+double f$vk_vector_cosine_similarity(const array<double> &a, const array<double> &b) noexcept {
+  if (!check_vectors(a, b, "vk_vector_cosine_similarity")) {
+    return 0.0;
+  }
+  const double norms = std::sqrt(dot_product(a, a)) * std::sqrt(dot_product(b, b));
+  return norms == 0.0 ? 0.0 : dot_product(a, b) / norms;
+}
+
+array<double> f$vk_vector_axpy(double alpha, const array<double> &x, const array<double> &y) noexcept {
+  if (!check_vectors(x, y, "vk_vector_axpy")) {
+    return {};
+  }
+  array<double> result = y;
+  result.mutate_if_shared();
+  axpy_f64(alpha, x.get_const_vector_pointer(), const_cast<double *>(result.get_const_vector_pointer()), static_cast<size_t>(x.count()));
+  return result;
+}
+
+array<mixed> f$vk_vector_top_k(const array<double> &a, int64_t k) noexcept {
+  if (k <= 0) {
+    return {};
+  }
+  k = std::min(k, a.count());
+
+  // the min-heap of the k greatest values seen so far, the least of them is on the top
+  std::vector<TopValue> heap;
+  heap.reserve(static_cast<size_t>(k));
+  const auto greater = [](const TopValue &lhs, const TopValue &rhs) { return lhs > rhs; };
+  int64_t order = 0;
+  for (auto it = a.begin(); it != a.end(); ++it, ++order) {
+    TopValue candidate{it.get_value(), order, it};
+    if (heap.size() < static_cast<size_t>(k)) {
+      heap.emplace_back(candidate);
+      std::push_heap(heap.begin(), heap.end(), greater);
+    } else if (candidate > heap.front()) {
+      std::pop_heap(heap.begin(), heap.end(), greater);
+      heap.back() = candidate;
+      std::push_heap(heap.begin(), heap.end(), greater);
+    }
+  }
+  std::sort_heap(heap.begin(), heap.end(), greater);
+
+  array<mixed> result(array_size(k, 0, true));
+  for (const auto &top : heap) {
+    result.push_back(top.it.get_key());
+  }
+  return result;
+}
+
+array<double> f$vk_matrix_vector_product(const array<array<double>> &matrix, const array<double> &v) noexcept {
+  if (!check_vector(v, "vk_matrix_vector_product")) {
+    return {};
+  }
+  array<double> result(matrix.size());
+  for (const auto &row : matrix) {
+    if (!check_vectors(row.get_value(), v, "vk_matrix_vector_product")) {
+      return {};
+    }
+    result.set_value(row.get_key(), dot_product(row.get_value(), v));
+  }
+  return result;
+}
@@ -0,0 +1,25 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "runtime/kphp_core.h"
+
+// the vectors are the arrays with the keys 0..n-1 of the same length
+
+double f$vk_vector_norm(const array<double> &a) noexcept;
+
+double f$vk_vector_l2_distance(const array<double> &a, const array<double> &b) noexcept;
+
+// returns 0 if one of the vectors is zero
+double f$vk_vector_cosine_similarity(const array<double> &a, const array<double> &b) noexcept;
+
+// returns $alpha * $x + $y
+array<double> f$vk_vector_axpy(double alpha, const array<double> &x, const array<double> &y) noexcept;
+
+// returns the keys of the k greatest values in the descending order of the values, the equal values are taken in the array order
+array<mixed> f$vk_vector_top_k(const array<double> &a, int64_t k) noexcept;
+
+// returns the dot products of each row of the matrix with the vector, the keys of the rows are preserved
+array<double> f$vk_matrix_vector_product(const array<array<double>> &matrix, const array<double> &v) noexcept;
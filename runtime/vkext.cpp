@@ -6,9 +6,11 @@
 
 #include <sys/time.h>
 
+#include "common/string-kernels.h"
 #include "common/string-processing.h"
 #include "flex/vk-flex-data.h"
 
+#include "runtime/json-functions.h"
 #include "runtime/misc.h"
 
 static int utf8_to_win_convert_0x400[256] = {-1, 0xa8, 0x80, 0x81, 0xaa, 0xbd, 0xb2, 0xaf, 0xa3, 0x8a, 0x8c, 0x8e, 0x8d, -1, 0xa1, 0x8f, 0xc0, 0xc1, 0xc2, 0xc3,
@@ -254,6 +256,15 @@ int utf8_to_win(const char *s, int len, int64_t max_len, bool exit_on_error) {
       }
       write_buff_char((char)c);
       st = 0;
+      // the ascii chars after it are copied at once
+      int ascii_len = static_cast<int>(ascii_prefix_length(s + i + 1, len - i - 1));
+      if (max_len) {
+        ascii_len = static_cast<int>(std::min<int64_t>(ascii_len, max_len - cur_buff_len));
+      }
+      if (ascii_len > 0) {
+        write_buff(s + i + 1, ascii_len);
+        i += ascii_len;
+      }
     } else if ((c & 0xc0) == 0x80) {
       if (!st) {
         if (exit_on_error) {
@@ -401,6 +412,13 @@ static int win_to_utf8(const char *s, int len, bool escape) {
     if (state == 3) {
       state = 0;
     }
+    if (state == 0 && (unsigned char)s[i] < 0x80) {
+      // the ascii chars up to the next entity are copied at once
+      size_t ascii_len = ascii_prefix_length(s + i + 1, len - i - 1);
+      ascii_len = find_first_of_chars(s + i + 1, ascii_len, "&", 1);
+      write_buff(s + i + 1, static_cast<int>(ascii_len));
+      i += static_cast<int>(ascii_len);
+    }
   }
   return cur_buff_len;
 }
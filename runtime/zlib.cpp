@@ -84,48 +84,61 @@ string f$gzencode(const string &s, int64_t level) {
   return zlib_encode(s.c_str(), s.size(), static_cast<int32_t>(level), ZLIB_ENCODE)->str();
 }
 
+// the inflate state and its window are allocated once and live through the whole worker life,
+// inflateReset2() switches the stream to the requested encoding before each use
+static z_stream *get_inflate_stream(int encoding) {
+  static z_stream strm;
+  static bool is_inited = false;
+  if (!is_inited) {
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.avail_in = 0;
+    strm.next_in = Z_NULL;
+    if (inflateInit2(&strm, encoding) != Z_OK) {
+      return nullptr;
+    }
+    is_inited = true;
+  } else if (inflateReset2(&strm, encoding) != Z_OK) {
+    return nullptr;
+  }
+  return &strm;
+}
+
 static string::size_type zlib_decode_raw(vk::string_view s, int encoding) {
   dl::enter_critical_section();//OK
 
-  z_stream strm;
-  strm.zalloc = Z_NULL;
-  strm.zfree = Z_NULL;
-  strm.opaque = Z_NULL;
-  strm.avail_in = s.size();
-  strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(s.data()));
-  strm.avail_out = PHP_BUF_LEN;
-  strm.next_out = reinterpret_cast <Bytef *> (php_buf);
-
-  int ret = inflateInit2 (&strm, encoding);
-  if (ret != Z_OK) {
+  z_stream *strm = get_inflate_stream(encoding);
+  if (strm == nullptr) {
     dl::leave_critical_section();
     return -1;
   }
+  strm->avail_in = s.size();
+  strm->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(s.data()));
+  strm->avail_out = PHP_BUF_LEN;
+  strm->next_out = reinterpret_cast <Bytef *> (php_buf);
 
-  ret = inflate(&strm, Z_NO_FLUSH);
+  int ret = inflate(strm, Z_NO_FLUSH);
   switch (ret) {
     case Z_NEED_DICT:
     case Z_DATA_ERROR:
     case Z_MEM_ERROR:
     case Z_STREAM_ERROR:
-      inflateEnd(&strm);
       dl::leave_critical_section();
 
       php_assert (ret != Z_STREAM_ERROR);
       return -1;
   }
 
-  int res_len = PHP_BUF_LEN - strm.avail_out;
+  int res_len = PHP_BUF_LEN - strm->avail_out;
 
-  if (strm.avail_out == 0 && ret != Z_STREAM_END) {
-    inflateEnd(&strm);
+  if (strm->avail_out == 0 && ret != Z_STREAM_END) {
     dl::leave_critical_section();
 
     php_critical_error ("size of unpacked data is greater then %d. Can't decode.", PHP_BUF_LEN);
     return -1;
   }
 
-  inflateEnd(&strm);
   dl::leave_critical_section();
   return res_len;
 }
@@ -0,0 +1,195 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/zstd.h"
+
+#include <cinttypes>
+#include <string>
+#include <zstd.h>
+
+#include "common/mixin/not_copyable.h"
+
+#include "runtime/critical_section.h"
+#include "runtime/string_functions.h"
+
+namespace {
+
+constexpr int32_t OUTPUT_CHUNK_SIZE = 64 * 1024;
+
+// the contexts live through the whole worker life, so their internal buffers are allocated once
+ZSTD_CCtx *get_compress_context() noexcept {
+  static ZSTD_CCtx *ctx = nullptr;
+  if (ctx == nullptr) {
+    ctx = ZSTD_createCCtx();
+  } else {
+    ZSTD_CCtx_reset(ctx, ZSTD_reset_session_and_parameters);
+  }
+  return ctx;
+}
+
+ZSTD_DCtx *get_decompress_context() noexcept {
+  static ZSTD_DCtx *ctx = nullptr;
+  if (ctx == nullptr) {
+    ctx = ZSTD_createDCtx();
+  } else {
+    ZSTD_DCtx_reset(ctx, ZSTD_reset_session_and_parameters);
+  }
+  return ctx;
+}
+
+// Digesting a dictionary costs much more than compressing a small payload with it,
+// while a script usually passes the same dictionary on every call, so the last digested one is kept
+class ZstdDictCache : vk::not_copyable {
+public:
+  static ZstdDictCache &get() noexcept {
+    static ZstdDictCache cache;
+    return cache;
+  }
+
+  const ZSTD_CDict *get_cdict(const string &dict) noexcept {
+    if (cdict_ == nullptr || !is_same(cdict_source_, dict)) {
+      ZSTD_freeCDict(cdict_);
+      cdict_ = ZSTD_createCDict(dict.c_str(), dict.size(), ZSTD_DEFAULT_LEVEL);
+      cdict_source_.assign(dict.c_str(), dict.size());
+    }
+    return cdict_;
+  }
+
+  const ZSTD_DDict *get_ddict(const string &dict) noexcept {
+    if (ddict_ == nullptr || !is_same(ddict_source_, dict)) {
+      ZSTD_freeDDict(ddict_);
+      ddict_ = ZSTD_createDDict(dict.c_str(), dict.size());
+      ddict_source_.assign(dict.c_str(), dict.size());
+    }
+    return ddict_;
+  }
+
+private:
+  ZstdDictCache() = default;
+
+  static bool is_same(const std::string &source, const string &dict) noexcept {
+    return source.size() == dict.size() && !memcmp(source.data(), dict.c_str(), dict.size());
+  }
+
+  std::string cdict_source_;
+  ZSTD_CDict *cdict_{nullptr};
+  std::string ddict_source_;
+  ZSTD_DDict *ddict_{nullptr};
+};
+
+Optional<string> zstd_compress_impl(const string &data, int64_t level, const string *dict) noexcept {
+  const size_t bound = ZSTD_compressBound(data.size());
+  if (ZSTD_isError(bound) || bound > string::max_size()) {
+    php_warning("zstd_compress: data is too large");
+    return false;
+  }
+
+  dl::CriticalSectionGuard critical_section;
+  ZSTD_CCtx *ctx = get_compress_context();
+  if (ctx == nullptr) {
+    php_warning("zstd_compress: can't create the compression context");
+    return false;
+  }
+  if (dict) {
+    const ZSTD_CDict *cdict = ZstdDictCache::get().get_cdict(*dict);
+    if (cdict == nullptr || ZSTD_isError(ZSTD_CCtx_refCDict(ctx, cdict))) {
+      php_warning("zstd_compress_dict: can't load the dictionary");
+      return false;
+    }
+  } else {
+    const size_t result = ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, static_cast<int>(level));
+    if (ZSTD_isError(result)) {
+      php_warning("zstd_compress: can't set the compression level %" PRIi64 ": %s", level, ZSTD_getErrorName(result));
+      return false;
+    }
+  }
+
+  string res(static_cast<string::size_type>(bound), false);
+  const size_t res_len = ZSTD_compress2(ctx, res.buffer(), bound, data.c_str(), data.size());
+  if (ZSTD_isError(res_len)) {
+    php_warning("zstd_compress: %s", ZSTD_getErrorName(res_len));
+    return false;
+  }
+  res.shrink(static_cast<string::size_type>(res_len));
+  return res;
+}
+
+Optional<string> zstd_uncompress_impl(const string &data, const string *dict) noexcept {
+  dl::CriticalSectionGuard critical_section;
+  ZSTD_DCtx *ctx = get_decompress_context();
+  if (ctx == nullptr) {
+    php_warning("zstd_uncompress: can't create the decompression context");
+    return false;
+  }
+  if (dict) {
+    const ZSTD_DDict *ddict = ZstdDictCache::get().get_ddict(*dict);
+    if (ddict == nullptr || ZSTD_isError(ZSTD_DCtx_refDDict(ctx, ddict))) {
+      php_warning("zstd_uncompress_dict: can't load the dictionary");
+      return false;
+    }
+  }
+
+  const unsigned long long size = ZSTD_getFrameContentSize(data.c_str(), data.size());
+  if (size == ZSTD_CONTENTSIZE_ERROR) {
+    php_warning("zstd_uncompress: it was not compressed by zstd");
+    return false;
+  }
+  if (size != ZSTD_CONTENTSIZE_UNKNOWN) {
+    if (size > string::max_size()) {
+      php_warning("zstd_uncompress: the uncompressed data is too large");
+      return false;
+    }
+    string res(static_cast<string::size_type>(size), false);
+    const size_t res_len = ZSTD_decompressDCtx(ctx, res.buffer(), size, data.c_str(), data.size());
+    if (ZSTD_isError(res_len) || res_len != size) {
+      php_warning("zstd_uncompress: %s", ZSTD_isError(res_len) ? ZSTD_getErrorName(res_len) : "wrong content size");
+      return false;
+    }
+    return res;
+  }
+
+  // the frames written in the streaming mode don't know their size, they are read by chunks
+  static_SB.clean();
+  ZSTD_inBuffer input{data.c_str(), data.size(), 0};
+  size_t remaining = 0;
+  bool is_output_full = false;
+  do {
+    static_SB.reserve(OUTPUT_CHUNK_SIZE);
+    ZSTD_outBuffer output{static_SB.buffer() + static_SB.size(), OUTPUT_CHUNK_SIZE, 0};
+    remaining = ZSTD_decompressStream(ctx, &output, &input);
+    if (ZSTD_isError(remaining)) {
+      php_warning("zstd_uncompress: %s", ZSTD_getErrorName(remaining));
+      return false;
+    }
+    static_SB.set_pos(static_SB.size() + output.pos);
+    is_output_full = output.pos == output.size;
+  } while (input.pos < input.size || is_output_full);
+  if (remaining != 0) {
+    php_warning("zstd_uncompress: the data is truncated");
+    return false;
+  }
+  return static_SB.str();
+}
+
+} // namespace
+
+Optional<string> f$zstd_compress(const string &data, int64_t level) noexcept {
+  if (level < ZSTD_minCLevel() || level > ZSTD_maxCLevel()) {
+    php_warning("zstd_compress: compression level (%" PRIi64 ") must be within %d..%d", level, ZSTD_minCLevel(), ZSTD_maxCLevel());
+    return false;
+  }
+  return zstd_compress_impl(data, level, nullptr);
+}
+
+Optional<string> f$zstd_uncompress(const string &data) noexcept {
+  return zstd_uncompress_impl(data, nullptr);
+}
+
+Optional<string> f$zstd_compress_dict(const string &data, const string &dict) noexcept {
+  return zstd_compress_impl(data, ZSTD_DEFAULT_LEVEL, &dict);
+}
+
+Optional<string> f$zstd_uncompress_dict(const string &data, const string &dict) noexcept {
+  return zstd_uncompress_impl(data, &dict);
+}
@@ -0,0 +1,18 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "runtime/kphp_core.h"
+
+constexpr int64_t ZSTD_DEFAULT_LEVEL = 3;
+
+Optional<string> f$zstd_compress(const string &data, int64_t level = ZSTD_DEFAULT_LEVEL) noexcept;
+
+Optional<string> f$zstd_uncompress(const string &data) noexcept;
+
+// the dictionaries are usually trained by `zstd --train` on the samples of the payloads
+Optional<string> f$zstd_compress_dict(const string &data, const string &dict) noexcept;
+
+Optional<string> f$zstd_uncompress_dict(const string &data, const string &dict) noexcept;
@@ -9,6 +9,11 @@
 #include <cinttypes>
 #include <forward_list>
 #include <map>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
 
 #include "common/binlog/binlog-replayer.h"
 #include "common/precise-time.h"
@@ -17,6 +22,7 @@
 #include "common/server/init-snapshot.h"
 #include "common/wrappers/string_view.h"
 #include "common/kfs/kfs.h"
+#include "common/mixin/not_copyable.h"
 
 #include "runtime/allocator.h"
 #include "runtime/confdata-global-manager.h"
@@ -26,6 +32,52 @@
 
 namespace {
 
+// The binary data of the snapshot records. A plain snapshot file is mapped, so the records are parsed
+// right from the page cache instead of being copied into the heap; an encrypted one is read and decrypted.
+class SnapshotBinaryData : vk::not_copyable {
+public:
+  SnapshotBinaryData(kfs_file_handle_t snapshot, int64_t size) noexcept {
+    const off_t offset = snapshot->info && !snapshot->info->iv ? lseek(snapshot->fd, 0, SEEK_CUR) : -1;
+    if (offset >= 0 && size > 0) {
+      const off_t page_offset = offset & ~static_cast<off_t>(sysconf(_SC_PAGESIZE) - 1);
+      mapped_size_ = static_cast<size_t>(size + (offset - page_offset));
+      mapped_ = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, snapshot->fd, page_offset);
+      if (mapped_ != MAP_FAILED) {
+        madvise(mapped_, mapped_size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(mapped_) + (offset - page_offset);
+        // the records are consumed, as they would be read
+        assert(lseek(snapshot->fd, offset + size, SEEK_SET) == offset + size);
+        return;
+      }
+      vkprintf(1, "can't mmap confdata snapshot, it is read: %m\n");
+    }
+    buffer_ = std::make_unique<char[]>(size);
+    assert(buffer_);
+    kfs_read_file_assert (snapshot, buffer_.get(), size);
+    data_ = buffer_.get();
+  }
+
+  const char *data() const noexcept {
+    return data_;
+  }
+
+  bool is_mapped() const noexcept {
+    return mapped_ != MAP_FAILED;
+  }
+
+  ~SnapshotBinaryData() {
+    if (is_mapped()) {
+      munmap(mapped_, mapped_size_);
+    }
+  }
+
+private:
+  void *mapped_{MAP_FAILED};
+  size_t mapped_size_{0};
+  std::unique_ptr<char[]> buffer_;
+  const char *data_{nullptr};
+};
+
 class ConfdataBinlogReplayer : vk::binlog::replayer {
 public:
   enum class OperationStatus {
@@ -89,23 +141,47 @@ public:
     kfs_read_file_assert (Snapshot, index_offset.get(), sizeof(index_offset[0]) * (nrecords + 1));
     vkprintf(1, "index_offset[%d]=%" PRId64 "\n", nrecords, index_offset[nrecords]);
 
-    auto index_binary_data = std::make_unique<char[]>(index_offset[nrecords]);
-    assert (index_binary_data);
-    kfs_read_file_assert (Snapshot, index_binary_data.get(), index_offset[nrecords]);
+    const SnapshotBinaryData snapshot_data{Snapshot, index_offset[nrecords]};
+    const char *index_binary_data = snapshot_data.data();
+    vkprintf(1, "confdata snapshot records are %s\n", snapshot_data.is_mapped() ? "mapped" : "read");
 
     using entry_type = lev_confdata_store_wrapper<index_entry, pmct_set>;
 
+    const auto get_key = [&](int i) {
+      const auto &element = reinterpret_cast<const entry_type &>(index_binary_data[index_offset[i]]);
+      return vk::string_view{element.data, static_cast<size_t>(std::max(element.key_len, short{0}))};
+    };
+    // the blacklist matching is the most expensive part of the keys checking, and it is independent for every key,
+    // so the records are split into the chunks checked by several threads
+    const auto filter_records = [&](int begin, int end) {
+      for (int i = begin; i < end; i++) {
+        const auto key = get_key(i);
+        if (key.empty() || key_blacklist_.is_blacklisted(key)) {
+          index_offset[i] = -1;
+        }
+      }
+    };
+    const int threads = std::max(std::min(snapshot_load_threads_, nrecords / MIN_RECORDS_PER_THREAD), 1);
+    std::vector<std::thread> filter_threads;
+    for (int t = 1; t < threads; t++) {
+      filter_threads.emplace_back(filter_records, static_cast<int>(int64_t{nrecords} * t / threads),
+                                  static_cast<int>(int64_t{nrecords} * (t + 1) / threads));
+    }
+    filter_records(0, static_cast<int>(int64_t{nrecords} / threads));
+    for (auto &thread : filter_threads) {
+      thread.join();
+    }
+    vkprintf(1, "%d snapshot records checked by %d threads\n", nrecords, threads);
+
     vk::string_view last_one_dot_key;
     vk::string_view last_two_dots_key;
     array_size one_dot_elements_counter;
     array_size two_dots_elements_counter;
     for (int i = 0; i < nrecords; i++) {
-      const auto &element = reinterpret_cast<const entry_type &>(index_binary_data[index_offset[i]]);
-      const vk::string_view key{element.data, static_cast<size_t>(std::max(element.key_len, short{0}))};
-      if (key.empty() || key_blacklist_.is_blacklisted(key)) {
-        index_offset[i] = -1;
+      if (index_offset[i] < 0) {
         ++event_counters_.snapshot_entry.blacklisted;
       } else {
+        const auto key = get_key(i);
         const auto first_dot = try_reserve_for_snapshot(key, 0, last_one_dot_key, one_dot_elements_counter);
         if (first_dot != std::string::npos) {
           try_reserve_for_snapshot(key, first_dot + 1, last_two_dots_key, two_dots_elements_counter);
@@ -145,6 +221,10 @@ public:
     kprintf("Confdata binlog reading error: got unsupported operation '%s' with key '%.*s'\n", operation_name, std::max(key_len, 0), key);
   }
 
+  void set_snapshot_load_threads(int threads) noexcept {
+    snapshot_load_threads_ = threads;
+  }
+
   void init(memory_resource::unsynchronized_pool_resource &memory_pool) noexcept {
     assert(!updating_confdata_storage_);
     updating_confdata_storage_ = new(&confdata_mem_)confdata_sample_storage{confdata_sample_storage::allocator_type{memory_pool}};
@@ -157,16 +237,22 @@ public:
   };
 
   ConfdataUpdateResult finish_confdata_update() noexcept {
-    for (auto &confdata_section: *updating_confdata_storage_) {
-      // save into the separate variable to avoid the const_cast
-      string key = confdata_section.first;
-      mark_string_as_confdata_const(key);
-      if (confdata_section.second.is_array()) {
-        mark_array_as_confdata_const(confdata_section.second.as_array());
-      } else if (confdata_section.second.is_string()) {
-        mark_string_as_confdata_const(confdata_section.second.as_string());
+    // the sections which are not updated are marked already, so only the updated ones are visited,
+    // unless they are a noticeable part of the confdata, as during the loading
+    if (updated_sections_.size() * 8 >= updating_confdata_storage_->size()) {
+      for (auto &confdata_section: *updating_confdata_storage_) {
+        mark_section_as_confdata_const(confdata_section);
+      }
+    } else {
+      for (const auto &section_key : updated_sections_) {
+        auto it = updating_confdata_storage_->find(string{section_key.c_str(), static_cast<string::size_type>(section_key.size())});
+        // the section may be deleted after the update
+        if (it != updating_confdata_storage_->end()) {
+          mark_section_as_confdata_const(*it);
+        }
       }
     }
+    updated_sections_.clear();
 
     ConfdataUpdateResult result{
       std::move(*updating_confdata_storage_),
@@ -197,6 +283,15 @@ public:
     return confdata_has_any_updates_;
   }
 
+  // While the coalescing is on, the sets and the deletes are not applied right away but collected,
+  // so that only the last of them is applied for every key; any other event applies the collected ones first.
+  void set_coalescing(bool coalescing) noexcept {
+    if (!coalescing) {
+      apply_deferred_events();
+    }
+    coalescing_ = coalescing;
+  }
+
   void delete_expired_elements() noexcept {
     assert(expiration_trace_.size() == element_delays_.size());
 
@@ -226,29 +321,40 @@ private:
     key_blacklist_(ConfdataGlobalManager::get().get_key_blacklist()),
     predefined_wildcards_(ConfdataGlobalManager::get().get_predefined_wildcards()) {
     add_handler([this](const lev_confdata_delete &E) {
-      update_event_stat(this->delete_element(E.key, E.key_len), event_counters_.delete_events);
+      if (!this->try_defer_event(E, DeferredEvent::Type::delete_event, E.key, E.key_len)) {
+        update_event_stat(this->delete_element(E.key, E.key_len), event_counters_.delete_events);
+      }
     });
     add_handler([this](const lev_confdata_touch &E) {
+      this->apply_deferred_events();
       update_event_stat(this->touch_element(E), event_counters_.touch_events);
     });
 
     add_handler([this](const lev_confdata_store_wrapper<lev_pmemcached_store, pmct_add> &E) {
+      this->apply_deferred_events();
       update_event_stat(this->store_element(E), event_counters_.add_events);
     });
     add_handler([this](const lev_confdata_store_wrapper<lev_pmemcached_store, pmct_set> &E) {
-      update_event_stat(this->store_element(E), event_counters_.set_events);
+      if (!this->try_defer_event(E, DeferredEvent::Type::set_event, E.data, E.key_len)) {
+        update_event_stat(this->store_element(E), event_counters_.set_events);
+      }
     });
     add_handler([this](const lev_confdata_store_wrapper<lev_pmemcached_store, pmct_replace> &E) {
+      this->apply_deferred_events();
       update_event_stat(this->store_element(E), event_counters_.replace_events);
     });
 
     add_handler([this](const lev_confdata_store_wrapper<lev_pmemcached_store_forever, pmct_add> &E) {
+      this->apply_deferred_events();
       update_event_stat(this->store_element(E), event_counters_.add_forever_events);
     });
     add_handler([this](const lev_confdata_store_wrapper<lev_pmemcached_store_forever, pmct_set> &E) {
-      update_event_stat(this->store_element(E), event_counters_.set_forever_events);
+      if (!this->try_defer_event(E, DeferredEvent::Type::set_forever_event, E.data, E.key_len)) {
+        update_event_stat(this->store_element(E), event_counters_.set_forever_events);
+      }
     });
     add_handler([this](const lev_confdata_store_wrapper<lev_pmemcached_store_forever, pmct_replace> &E) {
+      this->apply_deferred_events();
       update_event_stat(this->store_element(E), event_counters_.replace_forever_events);
     });
 
@@ -270,6 +376,79 @@ private:
     });
   }
 
+  struct DeferredEvent {
+    enum class Type {
+      delete_event,
+      set_event,
+      set_forever_event
+    };
+    Type type;
+    size_t offset;
+    size_t key_offset;
+    short key_len;
+  };
+
+  template<class T>
+  bool try_defer_event(const T &E, DeferredEvent::Type type, const char *key, short key_len) noexcept {
+    if (!coalescing_) {
+      return false;
+    }
+    const auto size = static_cast<size_t>(vk::binlog::detail::get_size_helper::get_size(E));
+    const size_t offset = deferred_events_data_.size();
+    // the events are kept aligned as in the binlog
+    deferred_events_data_.resize(offset + ((size + 7) & ~size_t{7}));
+    std::memcpy(&deferred_events_data_[offset], &E, size);
+    deferred_events_.push_back(DeferredEvent{type, offset, offset + (key - reinterpret_cast<const char *>(&E)), key_len});
+    if (deferred_events_data_.size() >= MAX_DEFERRED_EVENTS_BYTES) {
+      apply_deferred_events();
+    }
+    return true;
+  }
+
+  template<class T>
+  const T &get_deferred_event(const DeferredEvent &event) const noexcept {
+    return *reinterpret_cast<const T *>(&deferred_events_data_[event.offset]);
+  }
+
+  void apply_deferred_events() noexcept {
+    if (deferred_events_.empty()) {
+      return;
+    }
+    std::unordered_map<vk::string_view, size_t> last_event_for_key;
+    for (size_t i = 0; i < deferred_events_.size(); ++i) {
+      const auto &event = deferred_events_[i];
+      if (event.key_len >= 0) {
+        last_event_for_key[vk::string_view{&deferred_events_data_[event.key_offset], static_cast<size_t>(event.key_len)}] = i;
+      }
+    }
+
+    for (size_t i = 0; i < deferred_events_.size(); ++i) {
+      const auto &event = deferred_events_[i];
+      // the set or the delete which is followed by another one for the same key is overwritten anyway
+      const bool overwritten = event.key_len >= 0 &&
+        last_event_for_key[vk::string_view{&deferred_events_data_[event.key_offset], static_cast<size_t>(event.key_len)}] != i;
+      switch (event.type) {
+        case DeferredEvent::Type::delete_event: {
+          const auto &E = get_deferred_event<lev_confdata_delete>(event);
+          update_event_stat(overwritten ? OperationStatus::no_update : delete_element(E.key, E.key_len), event_counters_.delete_events);
+          break;
+        }
+        case DeferredEvent::Type::set_event: {
+          const auto &E = get_deferred_event<lev_confdata_store_wrapper<lev_pmemcached_store, pmct_set>>(event);
+          update_event_stat(overwritten ? OperationStatus::no_update : store_element(E), event_counters_.set_events);
+          break;
+        }
+        case DeferredEvent::Type::set_forever_event: {
+          const auto &E = get_deferred_event<lev_confdata_store_wrapper<lev_pmemcached_store_forever, pmct_set>>(event);
+          update_event_stat(overwritten ? OperationStatus::no_update : store_element(E), event_counters_.set_forever_events);
+          break;
+        }
+      }
+    }
+    deferred_events_.clear();
+    deferred_events_data_.clear();
+  }
+
   template<typename F>
   OperationStatus generic_operation(const char *key, short key_len, int delay, const F &operation) noexcept {
     // TODO assert?
@@ -285,12 +464,21 @@ private:
     assert(processing_value_.is_null());
     static_assert(std::is_same<short, int16_t>{}, "short is expected to be int16_t");
 
+    auto operation_with_tracking = [this, &operation] {
+      const auto operation_status = operation();
+      if (operation_status == OperationStatus::full_update) {
+        const auto &first_key = processing_key_.get_first_key();
+        updated_sections_.emplace(first_key.c_str(), first_key.size());
+      }
+      return operation_status;
+    };
+
     OperationStatus last_operation_status{OperationStatus::no_update};
     const auto predefined_wildcard_lengths = predefined_wildcards_.make_predefined_wildcard_len_range_by_key(key_view);
     for (size_t wildcard_len : predefined_wildcard_lengths) {
       assert(wildcard_len <= std::numeric_limits<int16_t>::max());
       processing_key_.update_with_predefined_wildcard(key, key_len, static_cast<int16_t>(wildcard_len));
-      const auto operation_status = operation();
+      const auto operation_status = operation_with_tracking();
       assert(last_operation_status != OperationStatus::full_update ||
              operation_status == OperationStatus::full_update);
       last_operation_status = operation_status;
@@ -304,13 +492,13 @@ private:
       const auto first_key_type = processing_key_.update(key, key_len);
       if (predefined_wildcard_lengths.empty() ||
           first_key_type != ConfdataFirstKeyType::simple_key) {
-        const auto operation_status = operation();
+        const auto operation_status = operation_with_tracking();
         assert(last_operation_status != OperationStatus::full_update ||
                operation_status == OperationStatus::full_update);
         if (operation_status == OperationStatus::full_update &&
             first_key_type == ConfdataFirstKeyType::two_dots_wildcard) {
           processing_key_.forcibly_change_first_key_wildcard_dots_from_two_to_one();
-          const auto should_be_full = operation();
+          const auto should_be_full = operation_with_tracking();
           assert(should_be_full == OperationStatus::full_update);
         }
         last_operation_status = operation_status;
@@ -513,6 +701,18 @@ private:
     assert(refcnt > 0 && refcnt <= 2 + predefined_wildcards_.get_max_wildcards_for_element());
   }
 
+  template<class Section>
+  void mark_section_as_confdata_const(Section &confdata_section) const noexcept {
+    // save into the separate variable to avoid the const_cast
+    string key = confdata_section.first;
+    mark_string_as_confdata_const(key);
+    if (confdata_section.second.is_array()) {
+      mark_array_as_confdata_const(confdata_section.second.as_array());
+    } else if (confdata_section.second.is_string()) {
+      mark_string_as_confdata_const(confdata_section.second.as_string());
+    }
+  }
+
   void mark_string_as_confdata_const(string &str) const noexcept {
     if (str.is_reference_counter(ExtraRefCnt::for_confdata) ||
         str.is_reference_counter(ExtraRefCnt::for_global_const)) {
@@ -636,6 +836,8 @@ private:
   mixed last_element_in_garbage_;
   bool confdata_has_any_updates_{false};
   std::unordered_map<vk::string_view, array_size> size_hints_;
+  // the first keys of the sections updated since the last finish_confdata_update()
+  std::unordered_set<std::string> updated_sections_;
   ConfdataStats::EventCounters event_counters_;
 
   ConfdataKeyMaker processing_key_;
@@ -644,7 +846,14 @@ private:
   std::unordered_map<vk::string_view, int> element_delays_;
   std::multimap<int, std::string> expiration_trace_;
 
+  static constexpr int MIN_RECORDS_PER_THREAD = 65536;
+  static constexpr size_t MAX_DEFERRED_EVENTS_BYTES = 16 * 1024 * 1024;
+
   bool blacklist_enabled_{true};
+  int snapshot_load_threads_{1};
+  bool coalescing_{false};
+  std::vector<DeferredEvent> deferred_events_;
+  std::vector<char> deferred_events_data_;
   const ConfdataKeyBlacklist &key_blacklist_;
   const ConfdataPredefinedWildcards &predefined_wildcards_;
 };
@@ -654,6 +863,7 @@ struct {
   size_t memory_limit{2u * 1024u * 1024u * 1024u};
   std::unique_ptr<re2::RE2> key_blacklist_pattern;
   std::unordered_set<vk::string_view> predefined_wildcards;
+  int snapshot_load_threads{1};
 
   bool is_enabled() const noexcept {
     return binlog_mask;
@@ -684,6 +894,11 @@ void clear_confdata_predefined_wildcards() noexcept {
   confdata_settings.predefined_wildcards.clear();
 }
 
+void set_confdata_snapshot_load_threads(int threads) noexcept {
+  assert(threads > 0);
+  confdata_settings.snapshot_load_threads = threads;
+}
+
 void init_confdata_binlog_reader() noexcept {
   if (!confdata_settings.is_enabled()) {
     return;
@@ -725,6 +940,7 @@ void init_confdata_binlog_reader() noexcept {
 
   auto &confdata_binlog_replayer = ConfdataBinlogReplayer::get();
   confdata_binlog_replayer.init(confdata_manager.get_resource());
+  confdata_binlog_replayer.set_snapshot_load_threads(confdata_settings.snapshot_load_threads);
   engine_default_load_index(confdata_settings.binlog_mask);
   engine_default_read_binlog();
   confdata_binlog_replayer.delete_expired_elements();
@@ -759,7 +975,9 @@ void confdata_binlog_update_cron() noexcept {
   auto &confdata_binlog_replayer = ConfdataBinlogReplayer::get();
   confdata_binlog_replayer.try_use_previous_confdata_storage_as_init(previous_confdata_sample.get_confdata());
 
+  confdata_binlog_replayer.set_coalescing(true);
   binlog_try_read_events();
+  confdata_binlog_replayer.set_coalescing(false);
   confdata_binlog_replayer.delete_expired_elements();
 
   if (confdata_binlog_replayer.has_new_confdata()){
@@ -777,17 +995,20 @@ void confdata_binlog_update_cron() noexcept {
   }
 
   confdata_manager.clear_unused_samples();
+  confdata_manager.compact_memory_if_fragmented();
 
   dl::restore_default_script_allocator(true);
   confdata_stats.total_updating_time += std::chrono::steady_clock::now().time_since_epoch();
 }
 
-void write_confdata_stats_to(stats_t *stats) noexcept {
+void write_confdata_stats_to(stats_t *stats, uint64_t worker_cache_hits, uint64_t worker_cache_misses) noexcept {
   if (confdata_settings.is_enabled()) {
     auto &confdata_stats = ConfdataStats::get();
+    confdata_stats.worker_cache_hits = worker_cache_hits;
+    confdata_stats.worker_cache_misses = worker_cache_misses;
     auto &binlog_replayer = ConfdataBinlogReplayer::get();
     confdata_stats.elements_with_delay = binlog_replayer.get_elements_with_delay_count();
     confdata_stats.event_counters = binlog_replayer.get_event_counters();
-    confdata_stats.write_stats_to(stats, ConfdataGlobalManager::get().get_resource().get_memory_stats());
+    confdata_stats.write_stats_to(stats, ConfdataGlobalManager::get().get_resource());
   }
 }
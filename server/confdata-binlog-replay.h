@@ -15,9 +15,11 @@ void set_confdata_memory_limit(size_t memory_limit) noexcept;
 void set_confdata_blacklist_pattern(std::unique_ptr<re2::RE2> &&key_blacklist_pattern) noexcept;
 void add_confdata_predefined_wildcard(const char *wildcard) noexcept;
 void clear_confdata_predefined_wildcards() noexcept;
+void set_confdata_snapshot_load_threads(int threads) noexcept;
 
 void init_confdata_binlog_reader() noexcept;
 
 void confdata_binlog_update_cron() noexcept;
 
-void write_confdata_stats_to(stats_t *stats) noexcept;
+// the lookups of the worker local caches are summed by the master over the workers
+void write_confdata_stats_to(stats_t *stats, uint64_t worker_cache_hits, uint64_t worker_cache_misses) noexcept;
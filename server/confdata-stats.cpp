@@ -82,9 +82,18 @@ void ConfdataStats::on_update(const confdata_sample_storage &new_confdata,
   last_update_time_point = std::chrono::steady_clock::now();
 }
 
-void ConfdataStats::write_stats_to(stats_t *stats, const memory_resource::MemoryStats &memory_stats) noexcept {
+void ConfdataStats::write_stats_to(stats_t *stats, const memory_resource::unsynchronized_pool_resource &memory_resource) noexcept {
+  const auto &memory_stats = memory_resource.get_memory_stats();
   memory_stats.write_stats_to(stats, "confdata");
 
+  // the share of the free memory that can't be allocated as one piece without the defragmentation
+  const size_t free_memory = memory_stats.memory_limit - memory_stats.memory_used;
+  const size_t largest_free_piece = memory_resource.get_largest_free_piece_size();
+  add_histogram_stat_long(stats, "confdata.memory.free", free_memory);
+  add_histogram_stat_long(stats, "confdata.memory.largest_free_piece", largest_free_piece);
+  add_histogram_stat_double(stats, "confdata.memory.fragmentation",
+                            free_memory ? 1.0 - static_cast<double>(largest_free_piece) / static_cast<double>(free_memory) : 0.0);
+
   add_histogram_stat_double(stats, "confdata.initial_loading_duration", to_seconds(initial_loading_time));
   add_histogram_stat_double(stats, "confdata.total_updating_time", to_seconds(total_updating_time));
   add_histogram_stat_double(stats, "confdata.seconds_since_last_update",
@@ -104,6 +113,12 @@ void ConfdataStats::write_stats_to(stats_t *stats, const memory_resource::Memory
   add_histogram_stat_long(stats, "confdata.wildcards.two_dots", two_dots_wildcards);
   add_histogram_stat_long(stats, "confdata.wildcards.predefined", predefined_wildcards);
 
+  add_histogram_stat_long(stats, "confdata.worker_cache.hits", worker_cache_hits);
+  add_histogram_stat_long(stats, "confdata.worker_cache.misses", worker_cache_misses);
+  const uint64_t worker_cache_lookups = worker_cache_hits + worker_cache_misses;
+  add_histogram_stat_double(stats, "confdata.worker_cache.hit_rate",
+                            worker_cache_lookups ? static_cast<double>(worker_cache_hits) / static_cast<double>(worker_cache_lookups) : 0.0);
+
   size_t last_100_garbage_max = 0;
   double last_100_garbage_avg = 0;
   auto garbage_last = garbage_statistic_.cbegin() + std::min(garbage_statistic_.size(), total_updates);
@@ -35,6 +35,9 @@ struct ConfdataStats : private vk::not_copyable {
   size_t predefined_wildcard_elements{0};
   size_t elements_with_delay{0};
 
+  uint64_t worker_cache_hits{0};
+  uint64_t worker_cache_misses{0};
+
   struct EventCounters {
     struct Event {
       size_t total{0};
@@ -67,7 +70,7 @@ struct ConfdataStats : private vk::not_copyable {
   void on_update(const confdata_sample_storage &new_confdata,
                  size_t previous_garbage_size,
                  const ConfdataPredefinedWildcards &predefined_wildcards) noexcept;
-  void write_stats_to(stats_t *stats, const memory_resource::MemoryStats &memory_stats) noexcept;
+  void write_stats_to(stats_t *stats, const memory_resource::unsynchronized_pool_resource &memory_resource) noexcept;
 
 private:
   ConfdataStats() = default;
@@ -0,0 +1,78 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-admission-control.h"
+
+#include <cmath>
+
+void AdmissionControl::set_delays(double target_delay, double interval) noexcept {
+  target_delay_ = target_delay;
+  interval_ = interval;
+}
+
+uint64_t AdmissionControl::http_endpoint(const char *uri, int uri_len) noexcept {
+  // FNV-1a of the path
+  uint64_t hash = 14695981039346656037ULL;
+  for (int i = 0; i < uri_len; i++) {
+    hash = (hash ^ static_cast<unsigned char>(uri[i])) * 1099511628211ULL;
+  }
+  return hash & ~RPC_ENDPOINT_BIT;
+}
+
+uint64_t AdmissionControl::rpc_endpoint(int function_magic) noexcept {
+  return RPC_ENDPOINT_BIT | static_cast<uint32_t>(function_magic);
+}
+
+AdmissionControl::EndpointState &AdmissionControl::get_state(uint64_t endpoint) noexcept {
+  auto it = endpoints_.find(endpoint);
+  if (it != endpoints_.end()) {
+    return it->second;
+  }
+  if (endpoints_.size() >= MAX_ENDPOINTS) {
+    endpoint &= RPC_ENDPOINT_BIT;
+  }
+  return endpoints_[endpoint];
+}
+
+double AdmissionControl::control_law(double t, uint32_t count) const noexcept {
+  return t + interval_ / std::sqrt(static_cast<double>(count));
+}
+
+bool AdmissionControl::admit(uint64_t endpoint, bool is_queue_empty, double now) noexcept {
+  if (!enabled() || is_queue_empty) {
+    return true;
+  }
+  EndpointState &state = get_state(endpoint);
+  if (!state.dropping || now < state.drop_next) {
+    return true;
+  }
+  state.drop_count++;
+  state.drop_next = control_law(state.drop_next, state.drop_count);
+  if (endpoint & RPC_ENDPOINT_BIT) {
+    shed_rpc_queries_++;
+  } else {
+    shed_http_queries_++;
+  }
+  return false;
+}
+
+void AdmissionControl::on_script_start(uint64_t endpoint, double queueing_delay, double now) noexcept {
+  if (!enabled()) {
+    return;
+  }
+  EndpointState &state = get_state(endpoint);
+  if (queueing_delay < target_delay_) {
+    state.first_above_time = 0;
+    state.dropping = false;
+    return;
+  }
+  if (state.first_above_time == 0) {
+    state.first_above_time = now + interval_;
+  } else if (!state.dropping && now >= state.first_above_time) {
+    state.dropping = true;
+    // continue with the previous drop rate if the endpoint has just left the dropping state
+    state.drop_count = state.drop_count > 2 && now - state.drop_next < 16 * interval_ ? state.drop_count - 2 : 1;
+    state.drop_next = control_law(now, state.drop_count);
+  }
+}
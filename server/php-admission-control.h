@@ -0,0 +1,58 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "common/mixin/not_copyable.h"
+
+// CoDel-like admission control of a worker: if the requests of an endpoint wait for the script longer than
+// the target delay during the whole interval, new requests of this endpoint are rejected with a growing frequency,
+// until the waiting goes below the target again
+class AdmissionControl : vk::not_copyable {
+public:
+  static AdmissionControl &get() noexcept {
+    static AdmissionControl admission_control;
+    return admission_control;
+  }
+
+  void set_delays(double target_delay, double interval) noexcept;
+  bool enabled() const noexcept { return target_delay_ > 0; }
+
+  static uint64_t http_endpoint(const char *uri, int uri_len) noexcept;
+  static uint64_t rpc_endpoint(int function_magic) noexcept;
+
+  // decides if a new request may be queued to the worker, is_queue_empty means it would be started immediately
+  bool admit(uint64_t endpoint, bool is_queue_empty, double now) noexcept;
+  // the request of the endpoint has waited queueing_delay for the start of its script
+  void on_script_start(uint64_t endpoint, double queueing_delay, double now) noexcept;
+
+  uint64_t shed_http_queries() const noexcept { return shed_http_queries_; }
+  uint64_t shed_rpc_queries() const noexcept { return shed_rpc_queries_; }
+
+private:
+  struct EndpointState {
+    double first_above_time{0};
+    double drop_next{0};
+    uint32_t drop_count{0};
+    bool dropping{false};
+  };
+
+  // the states of the rarest endpoints are merged into one when there are too many of them
+  static constexpr size_t MAX_ENDPOINTS = 1024;
+  static constexpr uint64_t RPC_ENDPOINT_BIT = 1ULL << 63;
+
+  AdmissionControl() = default;
+
+  EndpointState &get_state(uint64_t endpoint) noexcept;
+  double control_law(double t, uint32_t count) const noexcept;
+
+  double target_delay_{0};
+  double interval_{0.1};
+  std::unordered_map<uint64_t, EndpointState> endpoints_;
+  uint64_t shed_http_queries_{0};
+  uint64_t shed_rpc_queries_{0};
+};
@@ -24,7 +24,10 @@ int pid = -1;
 int no_sql = 0;
 
 int master_flag = 0; // 1 -- master, 0 -- single process, -1 -- child
+int master_slot_id = 0; // 0 or 1 -- which of the two masters running on the graceful restart this one is
 int workers_n = 0;
+int workers_autoscale_min = 0;
+int workers_autoscale_max = 0; // workers autoscaling is off when 0
 
 int run_once = 0;
 int run_once_return_code = 0;
@@ -37,6 +40,9 @@ double load_time;
 /** http **/
 int http_port = -1;
 int http_sfd = -1;
+int http_reuseport_sfd = -1;
+int http_reuseport = 0;
+int http_reuseport_cpu_steering = 0;
 
 /** rpc **/
 long long rpc_failed, rpc_sent, rpc_received, rpc_received_news_subscr, rpc_received_news_redirect;
@@ -69,6 +75,9 @@ int force_clear_sql_connection = 0;
 long long static_buffer_length_limit = -1;
 int use_madvise_dontneed = 0;
 long long memory_used_to_recreate_script = LLONG_MAX;
+long long script_memory_to_prefault = 0;
+long long script_memory_growth_step = 0;
+huge_pages_mode script_memory_huge_pages = huge_pages_mode::off;
 vk::optional<QueueTypesLeaseWorkerMode> cur_lease_mode;
 
 /***
@@ -7,6 +7,7 @@
 // for: struct in_addr
 #include <netinet/in.h>
 
+#include "common/huge-pages.h"
 #include "common/kphp-tasks-lease/lease-worker-mode.h"
 #include "common/version-string.h"
 
@@ -33,7 +34,10 @@ extern int pid;
 extern int no_sql;
 
 extern int master_flag;
+extern int master_slot_id;
 extern int workers_n;
+extern int workers_autoscale_min;
+extern int workers_autoscale_max;
 
 extern int run_once;
 extern int run_once_return_code;
@@ -47,6 +51,9 @@ extern double load_time;
 /** http **/
 extern int http_port;
 extern int http_sfd;
+extern int http_reuseport_sfd;
+extern int http_reuseport;
+extern int http_reuseport_cpu_steering;
 
 /** rpc **/
 extern long long rpc_failed, rpc_sent, rpc_received, rpc_received_news_subscr, rpc_received_news_redirect;
@@ -81,6 +88,8 @@ struct php_immediate_stats_t {
   int port;
   long long actor_id;
   double rpc_timestamp;
+
+  double idle_percent;
 };
 
 
@@ -95,6 +104,9 @@ extern int force_clear_sql_connection;
 extern long long static_buffer_length_limit;
 extern int use_madvise_dontneed;
 extern long long memory_used_to_recreate_script;
+extern long long script_memory_to_prefault;
+extern long long script_memory_growth_step;
+extern huge_pages_mode script_memory_huge_pages;
 extern vk::optional<QueueTypesLeaseWorkerMode> cur_lease_mode;
 
 #define RPC_PHP_IMMEDIATE_STATS 0x3d27a21b
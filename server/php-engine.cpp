@@ -8,6 +8,7 @@
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <malloc.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <poll.h>
@@ -17,10 +18,13 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "common/allocators/lockfree-slab.h"
 #include "common/crc32c.h"
 #include "common/cycleclock.h"
 #include "common/dl-utils-lite.h"
 #include "common/kprintf.h"
+#include "common/mixin/not_copyable.h"
+#include "common/numa.h"
 #include "common/options.h"
 #include "common/pipe-utils.h"
 #include "common/precise-time.h"
@@ -34,31 +38,44 @@
 #include "common/tl/constants/kphp.h"
 #include "common/tl/methods/rwm.h"
 #include "common/tl/parse.h"
+#include "common/tl/query-header.h"
 #include "net/net-buffers.h"
 #include "net/net-connections.h"
 #include "net/net-crypto-aes.h"
 #include "net/net-dc.h"
 #include "net/net-http-server.h"
+#include "net/net-http2-server.h"
 #include "net/net-memcache-client.h"
 #include "net/net-memcache-server.h"
 #include "net/net-mysql-client.h"
 #include "net/net-sockaddr-storage.h"
+#include "net/net-socket-options.h"
 #include "net/net-socket.h"
 #include "net/net-tcp-connections.h"
 #include "net/net-tcp-rpc-client.h"
 #include "net/net-tcp-rpc-server.h"
 
+#include "runtime/allocator.h"
+#include "runtime/confdata-functions.h"
+#include "runtime/http_compression.h"
 #include "runtime/interface.h"
 #include "runtime/profiler.h"
+#include "runtime/regexp.h"
 #include "server/confdata-binlog-replay.h"
 #include "server/lease-config-parser.h"
+#include "server/php-admission-control.h"
 #include "server/php-engine-vars.h"
 #include "server/php-lease.h"
 #include "server/php-master.h"
 #include "server/php-mc-connections.h"
+#include "server/php-memory-releaser.h"
+#include "server/php-pgo-profile.h"
 #include "server/php-queries.h"
 #include "server/php-runner.h"
+#include "server/php-sampling-profiler.h"
 #include "server/php-sql-connections.h"
+#include "server/php-tracing.h"
+#include "server/php-warmup.h"
 #include "server/php-worker-stats.h"
 #include "server/php-worker.h"
 
@@ -141,6 +158,51 @@ connection *get_target_connection(conn_target_t *S, int force_flag) {
   return d;
 }
 
+static uint64_t rpc_busy_rejects;
+static int rpc_target_queue_bytes_peak;
+static int rpc_target_queue_packets_peak;
+
+// as get_target_connection, but the ready connections over the rpc queue limits are skipped;
+// busy is set if there are ready connections and all of them are over the limits
+static connection *get_target_rpc_connection(conn_target_t *S, bool *busy) {
+  connection *ready = nullptr, *stopped = nullptr;
+  int u = 10000;
+  int queued_bytes = 0;
+  int pending_answers = 0;
+  *busy = false;
+  for (connection *c = S->first_conn; c != (connection *)S; c = c->next) {
+    const int r = S->type->check_ready(c);
+    if (r == cr_ok) {
+      queued_bytes += tcp_rpcc_queued_bytes(c);
+      pending_answers += tcp_rpcc_pending_answers(c);
+      if (tcp_rpcc_is_busy(c)) {
+        *busy = true;
+      } else if (ready == nullptr) {
+        ready = c;
+      }
+    } else if (r == cr_stopped && c->unreliability < u) {
+      u = c->unreliability;
+      stopped = c;
+    }
+  }
+  rpc_target_queue_bytes_peak = std::max(rpc_target_queue_bytes_peak, queued_bytes);
+  rpc_target_queue_packets_peak = std::max(rpc_target_queue_packets_peak, pending_answers);
+  if (ready != nullptr) {
+    *busy = false;
+    return ready;
+  }
+  return *busy ? nullptr : stopped;
+}
+
+bool is_rpc_target_busy(int host_num) {
+  if (host_num < 0 || host_num >= MAX_TARGETS) {
+    return false;
+  }
+  bool busy = false;
+  get_target_rpc_connection(&Targets[host_num], &busy);
+  return busy;
+}
+
 connection *get_target_connection_force(conn_target_t *S) {
   connection *res = get_target_connection(S, 0);
 
@@ -192,6 +254,65 @@ double fix_timeout(double timeout) {
   return timeout;
 }
 
+/***
+  SLABS
+ ***/
+
+namespace {
+
+// conn_query and net writer objects are created and freed for every outgoing query,
+// they are taken from the slab caches of the network thread instead of malloc
+class EngineSlab : vk::not_copyable {
+public:
+  explicit EngineSlab(uint32_t object_size) noexcept {
+    lockfree_slab_cache_init(&cache_, object_size);
+  }
+
+  void *alloc() noexcept {
+    if (cache_tls_.cache == nullptr) {
+      lockfree_slab_cache_register_thread(&cache_, &cache_tls_);
+    }
+    const uint32_t blocks_before = lockfree_slab_cache_count_used_blocks(&cache_tls_);
+    void *object = lockfree_slab_cache_alloc(&cache_tls_);
+    if (lockfree_slab_cache_count_used_blocks(&cache_tls_) != blocks_before) {
+      ++stats_.block_refills;
+    }
+    ++stats_.allocs;
+    ++stats_.used;
+    return object;
+  }
+
+  void free(void *object) noexcept {
+    --stats_.used;
+    lockfree_slab_cache_free(&cache_tls_, object);
+  }
+
+  PhpWorkerStats::SlabStats get_stats() noexcept {
+    PhpWorkerStats::SlabStats result = stats_;
+    result.blocks = cache_tls_.cache ? lockfree_slab_cache_count_used_blocks(&cache_tls_) : 0;
+    result.objects_in_block = cache_.objects_in_block;
+    return result;
+  }
+
+private:
+  lockfree_slab_cache_t cache_{};
+  lockfree_slab_cache_tls_t cache_tls_{};
+  PhpWorkerStats::SlabStats stats_;
+};
+
+EngineSlab conn_queries_slab{sizeof(conn_query)};
+EngineSlab net_writers_slab{sizeof(command_net_write_t)};
+
+} // namespace
+
+conn_query *alloc_conn_query() {
+  return static_cast<conn_query *>(conn_queries_slab.alloc());
+}
+
+void free_conn_query(conn_query *q) {
+  conn_queries_slab.free(q);
+}
+
 /***
   HTTP INTERFACE
  ***/
@@ -201,7 +322,7 @@ int delete_pending_query(conn_query *q) {
   vkprintf (1, "delete_pending_query(%p,%p)\n", q, q->requester);
 
   delete_conn_query(q);
-  free(q);
+  free_conn_query(q);
   return 0;
 }
 
@@ -256,7 +377,7 @@ void command_net_write_free(command_t *base_command) {
     command->data = nullptr;
     command->len = 0;
   }
-  free(command);
+  net_writers_slab.free(command);
 }
 
 command_t command_net_write_rpc_base = {
@@ -266,7 +387,7 @@ command_t command_net_write_rpc_base = {
 
 
 command_t *create_command_net_writer(const char *data, int data_len, command_t *base, long long extra) {
-  auto command = reinterpret_cast<command_net_write_t *>(malloc(sizeof(command_net_write_t)));
+  auto command = static_cast<command_net_write_t *>(net_writers_slab.alloc());
   command->base.run = base->run;
   command->base.free = base->free;
 
@@ -311,6 +432,11 @@ php_worker *php_worker_create(php_worker_mode_t mode, connection *c, http_query_
   worker->wakeup_time = 0;
 
   worker->req_id = req_id;
+  worker->admission_endpoint = 0;
+  worker->trace_id = 0;
+  worker->parent_span_id = 0;
+  worker->http_streamed = false;
+  worker->http_post_unread = http_data != nullptr && http_data->post == nullptr ? http_data->post_len : 0;
 
   if (worker->conn->target) {
     worker->target_fd = static_cast<int>(worker->conn->target - Targets);
@@ -349,7 +475,7 @@ void php_worker_try_start(php_worker *worker) {
   if (php_worker_run_flag) { // put connection into pending_http_query
     vkprintf (2, "php script [req_id = %016llx] is waiting\n", worker->req_id);
 
-    auto pending_q = reinterpret_cast<conn_query *>(malloc(sizeof(conn_query)));
+    auto pending_q = alloc_conn_query();
 
     pending_q->custom_type = 0;
     pending_q->outbound = (connection *)&pending_http_queue;
@@ -392,6 +518,8 @@ void php_worker_init_script(php_worker *worker) {
 
   get_utime_monotonic();
   worker->start_time = precise_now;
+  AdmissionControl::get().on_script_start(worker->admission_endpoint, worker->start_time - worker->init_time, precise_now);
+  Tracing::get().start_request(worker->trace_id, worker->parent_span_id, precise_now);
   vkprintf (1, "START php script [req_id = %016llx]\n", worker->req_id);
   assert (active_worker == nullptr);
   active_worker = worker;
@@ -477,11 +605,16 @@ void php_worker_run_rpc_send_query(net_query_t *query) {
     return;
   }
   conn_target_t *target = &Targets[connection_id];
-  connection *conn = get_target_connection(target, 0);
+  bool busy = false;
+  connection *conn = get_target_rpc_connection(target, &busy);
 
   if (conn != nullptr) {
     send_rpc_query(conn, TL_RPC_INVOKE_REQ, slot_id, (int *)query->request, query->request_size);
+    tcp_rpcc_query_sent(conn);
     conn->last_query_sent_time = precise_now;
+  } else if (busy) {
+    rpc_busy_rejects++;
+    on_net_event(create_rpc_error_event(slot_id, TL_ERROR_FLOOD_CONTROL, "All connections to the target are busy [rpc queue limits are exceeded], retry later", nullptr));
   } else {
     int new_conn_cnt = create_new_connections(target);
     if (new_conn_cnt <= 0 && get_target_connection(target, 1) == nullptr) {
@@ -646,6 +779,9 @@ void php_worker_http_load_post(php_worker *worker, php_query_http_load_post_t *q
   static php_query_http_load_post_answer_t res;
   res.loaded_bytes = php_worker_http_load_post_impl(worker, query->buf, query->min_len, query->max_len);
   query->base.ans = &res;
+  if (res.loaded_bytes > 0) {
+    worker->http_post_unread -= res.loaded_bytes;
+  }
 
   php_script_query_answered(php_script);
 
@@ -655,6 +791,26 @@ void php_worker_http_load_post(php_worker *worker, php_query_http_load_post_t *q
   }
 }
 
+void php_worker_http_send_chunk(php_worker *worker, php_query_http_send_chunk_t *query) {
+  php_script_query_readed(php_script);
+
+  static php_query_http_send_chunk_answer_t res;
+  connection *c = worker->conn;
+  // HTTP/1.0 clients don't know the chunked encoding, they get the whole response at the end
+  res.is_sent = worker->mode == http_worker && c != nullptr && !c->error && HTS_DATA(c)->http_ver >= HTTP_V11;
+  if (res.is_sent) {
+    if (!worker->http_streamed) {
+      write_http_response_headers(c, query->headers, query->headers_len);
+      worker->http_streamed = true;
+    }
+    write_http_chunk(c, query->data, query->data_len);
+    flush_connection_output(c);
+  }
+  query->base.ans = &res;
+
+  php_script_query_answered(php_script);
+}
+
 void php_worker_answer_query(php_worker *worker, void *ans) {
   assert (worker != nullptr && ans != nullptr);
   auto q_base = (php_query_base_t *)php_script_get_query(php_script);
@@ -697,6 +853,26 @@ void on_net_event(int event_status) {
   }
 }
 
+// the values of CURL_POLL_IN, CURL_POLL_OUT and CURL_CSELECT_IN, CURL_CSELECT_OUT, CURL_CSELECT_ERR, curl.h is not included here
+static int curl_socket_ready(int fd, void *data __attribute__((unused)), event_t *ev) {
+  const int events = (ev->ready & EVT_READ ? 1 : 0) | (ev->ready & EVT_WRITE ? 2 : 0) | (ev->ready & EVT_SPEC ? 4 : 0);
+  on_net_event(create_curl_socket_event(fd, events));
+  return EVA_REMOVE;
+}
+
+void curl_watch_socket(int fd, int curl_poll_events) {
+  const int flags = (curl_poll_events & 1 ? EVT_READ : 0) | (curl_poll_events & 2 ? EVT_WRITE : 0);
+  if (!flags) {
+    // drops the pending readiness of the socket too, so the handler won't run after that
+    epoll_close(fd);
+    return;
+  }
+  // the exclusive epoll registration can't be modified, so the socket is added anew
+  epoll_remove(fd);
+  epoll_sethandler(fd, 0, curl_socket_ready, nullptr);
+  epoll_insert(fd, flags | EVT_LEVEL);
+}
+
 void php_worker_wait(php_worker *worker, int timeout_ms) {
   if (worker->waiting) { // first timeout is used!!
     return;
@@ -756,6 +932,10 @@ void php_worker_run_query(php_worker *worker) {
       query_stats.desc = "HTTP_LOAD_POST";
       php_worker_http_load_post(worker, (php_query_http_load_post_t *)q_base);
       break;
+    case PHPQ_HTTP_SEND_CHUNK:
+      query_stats.desc = "HTTP_SEND_CHUNK";
+      php_worker_http_send_chunk(worker, (php_query_http_send_chunk_t *)q_base);
+      break;
     default:
       assert ("unknown php_query type" && 0);
   }
@@ -811,14 +991,28 @@ void client_rpc_error(connection *c, long long req_id, int code, const char *str
   TCP_RPCC_FUNC(c)->flush_packet(c);
 }
 
+// the next query of the connection can't be parsed while a part of the body of the current one is still there
+static void php_worker_http_check_unread_post(php_worker *worker) {
+  if (worker->http_post_unread > 0) {
+    vkprintf (1, "%d bytes of POST are not read by the script, closing the connection\n", worker->http_post_unread);
+    HTS_DATA(worker->conn)->query_flags &= ~QF_KEEPALIVE;
+  }
+}
+
 void php_worker_set_result(php_worker *worker, script_result *res) {
   if (worker->conn != nullptr) {
     if (worker->mode == http_worker) {
-      if (res == nullptr) {
+      php_worker_http_check_unread_post(worker);
+      if (worker->http_streamed) {
+        // the headers are already sent, the rest of the body is the last chunk
+        if (res != nullptr) {
+          write_http_chunk(worker->conn, res->body, res->body_len);
+        }
+        write_http_last_chunk(worker->conn);
+      } else if (res == nullptr) {
         http_return(worker->conn, "OK", 2);
       } else {
-        write_out(&worker->conn->Out, res->headers, res->headers_len);
-        write_out(&worker->conn->Out, res->body, res->body_len);
+        write_http_response(worker->conn, res->headers, res->headers_len, res->body, res->body_len);
       }
     } else if (worker->mode == rpc_worker) {
       if (!rpc_stored) {
@@ -835,7 +1029,9 @@ void php_worker_run_net_queue(php_worker *worker __attribute__((unused))) {
   net_query_t *query;
   while ((query = pop_net_query()) != nullptr) {
     //no other types of query are currently supported
-    php_worker_run_rpc_send_query(query);
+    if (!is_cancelled_slot(query->slot_id)) {
+      php_worker_run_rpc_send_query(query);
+    }
     free_net_query(query);
   }
 }
@@ -892,7 +1088,11 @@ void php_worker_run(php_worker *worker) {
         php_script_finish(php_script);
 
         if (worker->conn != nullptr) {
-          if (worker->mode == http_worker) {
+          if (worker->mode == http_worker && worker->http_streamed) {
+            // it is too late for an error page, the client sees the response cut by the closed connection or the reset stream
+            hts_abort_response(worker->conn);
+          } else if (worker->mode == http_worker) {
+            php_worker_http_check_unread_post(worker);
             http_return(worker->conn, "ERROR", 5);
           } else if (worker->mode == rpc_worker) {
             if (!rpc_stored) {
@@ -953,8 +1153,11 @@ void php_worker_free_script(php_worker *worker) {
     delete_pending_query(q);
   }
 
+  // the answer is already sent
+  Tracing::get().finish_request(waited, precise_now);
   php_queries_finish();
   php_script_clear(php_script);
+  MemoryReleaser::get().on_request_finish(dl::get_script_memory_stats().max_real_memory_used, dl::get_heap_memory_used_max());
 
   static int finished_queries = 0;
   if ((++finished_queries) % queries_to_recreate_script == 0
@@ -967,10 +1170,42 @@ void php_worker_free_script(php_worker *worker) {
   worker->state = phpq_finish;
 }
 
+// creates the script of the worker in advance while there are no requests, instead of doing it on the first request
+static void warm_up_php_script() {
+  if (php_script != nullptr || script_memory_to_prefault <= 0 || php_worker_run_flag ||
+      pending_http_queue.first_query != (conn_query *)&pending_http_queue) {
+    return;
+  }
+  const double warm_up_start = get_utime_monotonic();
+  php_script = php_script_create((size_t)max_memory, (size_t)(8 << 20));
+  php_script_prefault(php_script, (size_t)script_memory_to_prefault);
+  vkprintf (1, "php script is warmed up in %.3lf seconds\n", get_utime_monotonic() - warm_up_start);
+}
+
+// gives the memory, which the last requests haven't needed, back to the system while there are no requests
+static void release_unused_memory() {
+  auto &releaser = MemoryReleaser::get();
+  if (!releaser.enabled() || php_worker_run_flag || pending_http_queue.first_query != (conn_query *)&pending_http_queue) {
+    return;
+  }
+  if (releaser.should_release_script_memory()) {
+    if (php_script != nullptr) {
+      // the prefaulted memory is kept for the next request anyway
+      php_script_release_memory_above(php_script, std::max(releaser.script_memory_to_keep(), static_cast<size_t>(script_memory_to_prefault)));
+    }
+    releaser.on_script_memory_released();
+  }
+  if (releaser.should_trim_heap()) {
+    malloc_trim(0);
+    releaser.on_heap_trimmed();
+  }
+}
+
 void php_worker_finish(php_worker *worker) {
   vkprintf (2, "free php script [req_id = %016llx]\n", worker->req_id);
   lease_on_worker_finish(worker);
   php_worker_free(worker);
+  sql_reset_sessions();
 }
 
 double php_worker_get_timeout(php_worker *worker) {
@@ -1090,12 +1325,15 @@ void http_return(connection *c, const char *str, int len) {
     len = (int)strlen(str);
   }
   write_basic_http_header(c, 500, 0, len, no_cache_headers, "text/plain; charset=UTF-8");
-  write_out(&c->Out, str, len);
+  write_http_body(c, str, len);
 }
 
 #define MAX_POST_SIZE (1 << 18)
+static_assert(HTTP2_MAX_REQUEST_BODY < MAX_POST_SIZE, "http/2 request bodies are read at once");
 
 int hts_stopped = 0;
+// the loopback socket accepting the replayed requests while the worker warms up
+static int http_warmup_sfd = -1;
 
 void hts_stop() {
   if (hts_stopped) {
@@ -1106,6 +1344,16 @@ void hts_stop() {
     close(http_sfd);
     http_sfd = -1;
   }
+  if (http_reuseport_sfd != -1) {
+    epoll_close(http_reuseport_sfd);
+    close(http_reuseport_sfd);
+    http_reuseport_sfd = -1;
+  }
+  if (http_warmup_sfd != -1) {
+    epoll_close(http_warmup_sfd);
+    close(http_warmup_sfd);
+    http_warmup_sfd = -1;
+  }
   sigterm_time = get_utime_monotonic() + SIGTERM_WAIT_TIMEOUT;
   hts_stopped = 1;
 }
@@ -1117,6 +1365,7 @@ void hts_at_query_end(connection *c, int check_keep_alive) {
   c->generation = ++conn_generation;
   c->pending_queries = 0;
   D->extra = nullptr;
+  http2_finish_query(c);
   if (check_keep_alive && !(D->query_flags & QF_KEEPALIVE)) {
     c->status = conn_write_close;
     c->parse_state = -1;
@@ -1147,7 +1396,6 @@ int do_hts_func_wakeup(connection *c, int flag) {
 int hts_func_execute(connection *c, int op) {
   hts_data *D = HTS_DATA(c);
   static char ReqHdr[MAX_HTTP_HEADER_SIZE];
-  static char Post[MAX_POST_SIZE];
 
   if (sigterm_on && sigterm_time < precise_now) {
     return -501;
@@ -1162,7 +1410,7 @@ int hts_func_execute(connection *c, int op) {
   }
 
   if (D->data_size > 0) {
-    int have_bytes = get_total_ready_bytes(&c->In);
+    int have_bytes = hts_query_ready_bytes(c);
     if (have_bytes < D->data_size + D->header_size && D->data_size < MAX_POST_SIZE) {
       vkprintf (1, "-- need %d more bytes, waiting\n", D->data_size + D->header_size - have_bytes);
       return D->data_size + D->header_size - have_bytes;
@@ -1170,7 +1418,7 @@ int hts_func_execute(connection *c, int op) {
   }
 
   assert (D->header_size <= MAX_HTTP_HEADER_SIZE);
-  assert (read_in(&c->In, &ReqHdr, D->header_size) == D->header_size);
+  assert (hts_read_query(c, &ReqHdr, D->header_size) == D->header_size);
 
   qHeaders = ReqHdr + D->first_line_size;
   qHeadersLen = D->header_size - D->first_line_size;
@@ -1185,10 +1433,12 @@ int hts_func_execute(connection *c, int op) {
 //  D->query_flags &= ~QF_KEEPALIVE;
 
   if (0 < D->data_size && D->data_size < MAX_POST_SIZE) {
-    assert (read_in(&c->In, Post, D->data_size) == D->data_size);
-    Post[D->data_size] = 0;
-    vkprintf (1, "have %d POST bytes: `%.80s`\n", D->data_size, Post);
-    qPost = Post;
+    // the body is read once into the buffer owned by the query data, the script reads it from there
+    qPost = static_cast<char *>(malloc(D->data_size + 1));
+    assert (qPost != nullptr);
+    assert (hts_read_query(c, qPost, D->data_size) == D->data_size);
+    qPost[D->data_size] = 0;
+    vkprintf (1, "have %d POST bytes: `%.80s`\n", D->data_size, qPost);
     qPostLen = D->data_size;
   } else {
     qPost = nullptr;
@@ -1213,11 +1463,19 @@ int hts_func_execute(connection *c, int op) {
   }
 
   if (qUriLen >= 200) {
+    free(qPost);
     return -418;
   }
 
   vkprintf (1, "OK, lets do something\n");
 
+  const uint64_t admission_endpoint = AdmissionControl::http_endpoint(qUri, qUriLen);
+  if (!AdmissionControl::get().admit(admission_endpoint, !has_pending_scripts(), precise_now)) {
+    vkprintf (1, "shed http query: the requests of '%.*s' are waiting for too long\n", qUriLen, qUri);
+    free(qPost);
+    return -503;
+  }
+
   const char *query_type_str = nullptr;
   switch (D->query_type) {
     case htqt_get: query_type_str = "GET"; break;
@@ -1226,6 +1484,10 @@ int hts_func_execute(connection *c, int op) {
     default: assert(0);
   }
 
+  if (qPost != nullptr || D->data_size == 0) {
+    HttpWarmup::get().record(ReqHdr, D->header_size, qPost, qPostLen);
+  }
+
   /** save query here **/
   http_query_data *http_data = http_query_data_create(qUri, qUriLen, qGet, qGetLen, qHeaders, qHeadersLen, qPost,
                                                       qPostLen, query_type_str, D->query_flags & QF_KEEPALIVE,
@@ -1234,6 +1496,7 @@ int hts_func_execute(connection *c, int op) {
 
   static long long http_script_req_id = 0;
   php_worker *worker = php_worker_create(http_worker, c, http_data, nullptr, script_timeout, ++http_script_req_id);
+  worker->admission_endpoint = admission_endpoint;
   D->extra = worker;
 
   set_connection_timeout(c, script_timeout);
@@ -1398,9 +1661,12 @@ int rpcc_func_ready(connection *c) {
   c->last_response_time = precise_now;
 
   auto target_fd = c->target - Targets;
-  if (target_fd == get_current_target() && !has_pending_scripts()) {
-    lease_set_ready();
-    run_rpc_lease();
+  if (target_fd == get_current_target()) {
+    lease_on_connection_ready();
+    if (!has_pending_scripts()) {
+      lease_set_ready();
+      run_rpc_lease();
+    }
   }
   return 0;
 }
@@ -1577,24 +1843,51 @@ int rpcx_execute(connection *c, int op, raw_message *raw) {
       auto custom_settings = try_fetch_lookup_custom_worker_settings();
       double actual_script_timeout = custom_settings.has_timeout() ? normalize_script_timeout(custom_settings.php_timeout_ms / 1000.0) : script_timeout;
       set_connection_timeout(c, actual_script_timeout);
+      tl_query_header_t trace_header;
+      if (Tracing::get().enabled()) {
+        // the header stays in the query, the script fetches it by itself
+        tl_fetch_mark();
+        if (!tl_fetch_query_extra_header(&trace_header)) {
+          trace_header.trace_id = 0;
+          tl_fetch_reset_error();
+        }
+        tl_fetch_mark_restore();
+      }
 
-      char buf[len + 1];
+      // the query is fetched from the message parts right into the buffer the script parses it from
+      auto *buf = static_cast<int *>(malloc(len + 1));
       auto fetched_bytes = tl_fetch_data(buf, len);
       if (fetched_bytes == -1) {
+        free(buf);
         client_rpc_error(c, req_id, tl_fetch_error_code(), tl_fetch_error_string());
         return 0;
       }
       assert(fetched_bytes == len);
+      const uint64_t admission_endpoint = AdmissionControl::rpc_endpoint(len >= sizeof(int) ? *buf : 0);
+      if (!AdmissionControl::get().admit(admission_endpoint, !has_pending_scripts(), precise_now)) {
+        free(buf);
+        const char *msg = "Query is shed: the worker is overloaded";
+        if (c->type == &ct_php_engine_rpc_server) {
+          server_rpc_error(c, req_id, TL_ERROR_FLOOD_CONTROL, msg);
+        } else {
+          client_rpc_error(c, req_id, TL_ERROR_FLOOD_CONTROL, msg);
+        }
+        return 0;
+      }
       auto D = TCP_RPC_DATA(c);
-      rpc_query_data *rpc_data = rpc_query_data_create(reinterpret_cast<int *>(buf), len / static_cast<int>(sizeof(int)),
+      rpc_query_data *rpc_data = rpc_query_data_create(buf, len / static_cast<int>(sizeof(int)),
                                                        req_id, D->remote_pid.ip, D->remote_pid.port,
                                                        D->remote_pid.pid, D->remote_pid.utime);
 
       php_worker *worker = php_worker_create(run_once ? once_worker : rpc_worker, c, nullptr, rpc_data,
                                              actual_script_timeout, req_id);
+      worker->admission_endpoint = admission_endpoint;
+      worker->trace_id = static_cast<uint64_t>(trace_header.trace_id);
+      worker->parent_span_id = static_cast<uint64_t>(trace_header.parent_span_id);
       D->extra = worker;
 
       c->status = conn_wait_net;
+      lease_on_task_received(c);
       rpcx_func_wakeup(c);
       break;
     }
@@ -1610,6 +1903,7 @@ int rpcx_execute(connection *c, int op, raw_message *raw) {
       assert(op_from_tl == op);
 
       auto id = tl_fetch_long();
+      tcp_rpcc_answer_received(c);
       if (op == TL_RPC_REQ_ERROR) {
         //FIXME: error code, error string
         //almost never happens
@@ -1664,7 +1958,7 @@ void pnet_query_delete(conn_query *q) {
   q->extra = nullptr;
 
   delete_conn_query(q);
-  free(q);
+  free_conn_query(q);
 }
 
 int pnet_query_timeout(conn_query *q) {
@@ -1716,7 +2010,7 @@ int delayed_send_term(conn_query *q) {
   }
 
   delete_conn_query(q);
-  free(q);
+  free_conn_query(q);
   return 0;
 }
 
@@ -1758,7 +2052,7 @@ conn_query_functions delayed_send_cq_func = [] {
 
 
 void create_pnet_delayed_query(connection *http_conn, conn_target_t *t, net_ansgen_t *gen, double finish_time) {
-  auto q = reinterpret_cast<conn_query *>(malloc(sizeof(conn_query)));
+  auto q = alloc_conn_query();
 
   q->custom_type = 0;
   q->outbound = nullptr;
@@ -1775,7 +2069,7 @@ void create_pnet_delayed_query(connection *http_conn, conn_target_t *t, net_ansg
 
 void create_delayed_send_query(conn_target_t *t, command_t *command,
                                double finish_time) {
-  auto q = reinterpret_cast<conn_query *>(malloc(sizeof(conn_query)));
+  auto q = alloc_conn_query();
 
   q->custom_type = 0;
   q->start_time = precise_now;
@@ -1791,7 +2085,7 @@ void create_delayed_send_query(conn_target_t *t, command_t *command,
 }
 
 conn_query *create_pnet_query(connection *http_conn, connection *conn, net_ansgen_t *gen, double finish_time) {
-  auto q = reinterpret_cast<conn_query *>(malloc(sizeof(conn_query)));
+  auto q = alloc_conn_query();
 
   q->custom_type = 0;
   q->outbound = conn;
@@ -1910,7 +2204,7 @@ int rpcc_send_query(connection *c) {
     command->free(command);
     q->extra = nullptr;
     delete_conn_query(q);
-    free(q);
+    free_conn_query(q);
   }
   return 0;
 }
@@ -1924,6 +2218,20 @@ void prepare_full_stats() {
 
   PhpWorkerStats::get_local().update_idle_time(epoll_total_idle_time(), get_uptime(),
                                                epoll_average_idle_time(), epoll_average_idle_quotient());
+  const auto &regexp_stats = regexp_get_exec_stats();
+  PhpWorkerStats::get_local().update_regexp_executions(regexp_stats.pcre_jit_executions,
+                                                       regexp_stats.pcre_interpreted_executions,
+                                                       regexp_stats.re2_executions);
+  PhpWorkerStats::get_local().update_shed_queries(AdmissionControl::get().shed_http_queries(), AdmissionControl::get().shed_rpc_queries());
+  PhpWorkerStats::get_local().update_memory_releases(MemoryReleaser::get().script_memory_releases(), MemoryReleaser::get().heap_trims());
+  PhpWorkerStats::get_local().update_http2(http2_connections_total, http2_streams_total, http2_streams_refused);
+  PhpWorkerStats::get_local().update_busy_poll(epoll_total_spin_time(), epoll_spin_wakeups(), epoll_spin_sleeps());
+  const auto &confdata_cache_stats = confdata_get_worker_cache_stats();
+  PhpWorkerStats::get_local().update_confdata_cache(confdata_cache_stats.hits, confdata_cache_stats.misses);
+  const auto rpc_in_flight_stats = get_rpc_in_flight_stats();
+  PhpWorkerStats::get_local().update_rpc_in_flight(rpc_in_flight_stats.max_per_host, rpc_in_flight_stats.balanced_queries);
+  PhpWorkerStats::get_local().update_rpc_queues(rpc_target_queue_bytes_peak, rpc_target_queue_packets_peak, rpc_busy_rejects);
+  PhpWorkerStats::get_local().update_slabs(conn_queries_slab.get_stats(), net_writers_slab.get_stats());
   PhpWorkerStats::get_local().recalc_worker_percentiles();
   const int stats_size = PhpWorkerStats::get_local().write_into(s, s_left);
   s += stats_size;
@@ -2036,8 +2344,12 @@ void write_immediate_stats_to_pipe() {
     int qsize = QSIZE;
 #undef QSIZE
 
+    php_immediate_stats_t istats = *get_imm_stats();
+    const double idle_quotient = epoll_average_idle_quotient();
+    istats.idle_percent = idle_quotient > 0 ? epoll_average_idle_time() / idle_quotient * 100 : 100;
+
     q[2] = RPC_PHP_IMMEDIATE_STATS;
-    memcpy(q + 3, get_imm_stats(), sizeof(php_immediate_stats_t));
+    memcpy(q + 3, &istats, sizeof(php_immediate_stats_t));
 
     prepare_rpc_query_raw(pipe_fast_packet_id++, q, qsize, crc32c_partial);
     int err = (int)write(master_pipe_fast_write, q, (size_t)qsize);
@@ -2070,7 +2382,65 @@ void cron() {
 }
 
 int try_get_http_fd() {
-  return server_socket(http_port, settings_addr, backlog, 0);
+  const int sfd = server_socket(http_port, settings_addr, backlog, http_reuseport ? SM_REUSEPORT : 0);
+  // the master socket is the first one in the SO_REUSEPORT group, workers' sockets follow it
+  if (sfd >= 0 && http_reuseport_cpu_steering && workers_n > 0 && !socket_attach_reuseport_cpu_steering(sfd, 1, workers_n)) {
+    kprintf("failed to attach the cpu steering program to the http socket: %m\n");
+  }
+  return sfd;
+}
+
+static void open_worker_http_reuseport_socket() {
+  // the shared socket is kept too: connections hashed to the master socket are accepted from it
+  http_reuseport_sfd = server_socket(http_port, settings_addr, backlog, SM_REUSEPORT);
+  if (http_reuseport_sfd < 0) {
+    kprintf("cannot open own SO_REUSEPORT http socket at port %d, accept on the shared one only: %m\n", http_port);
+  }
+}
+
+static void start_accepting_http() {
+  if (http_sfd >= 0) {
+    init_listening_tcpv6_connection(http_sfd, &ct_php_engine_http_server, &http_methods, SM_SPECIAL);
+  }
+  if (http_reuseport_sfd >= 0) {
+    init_listening_tcpv6_connection(http_reuseport_sfd, &ct_php_engine_http_server, &http_methods, SM_SPECIAL);
+  }
+}
+
+// the recorded requests are sent to a loopback socket of the worker, the real ones are accepted after them
+static bool start_http_warmup() {
+  auto &warmup = HttpWarmup::get();
+  if (warmup.requests_count() == 0 || http_sfd < 0 || run_once) {
+    return false;
+  }
+  struct in_addr loopback_addr{};
+  loopback_addr.s_addr = htonl(INADDR_LOOPBACK);
+  http_warmup_sfd = server_socket(0, loopback_addr, backlog, 0);
+  if (http_warmup_sfd < 0) {
+    kprintf("cannot open the warmup http socket, the warmup is skipped: %m\n");
+    return false;
+  }
+  struct sockaddr_in addr{};
+  socklen_t addr_len = sizeof(addr);
+  if (getsockname(http_warmup_sfd, reinterpret_cast<struct sockaddr *>(&addr), &addr_len) < 0) {
+    kprintf("cannot get the port of the warmup http socket, the warmup is skipped: %m\n");
+    close(http_warmup_sfd);
+    http_warmup_sfd = -1;
+    return false;
+  }
+  init_listening_tcpv6_connection(http_warmup_sfd, &ct_php_engine_http_server, &http_methods, SM_SPECIAL);
+  return warmup.start(ntohs(addr.sin_port), precise_now);
+}
+
+static void finish_http_warmup() {
+  if (http_warmup_sfd >= 0) {
+    epoll_close(http_warmup_sfd);
+    close(http_warmup_sfd);
+    http_warmup_sfd = -1;
+  }
+  if (!hts_stopped) {
+    start_accepting_http();
+  }
 }
 
 void open_json_log() {
@@ -2114,6 +2484,10 @@ void start_server() {
   init_epoll();
   if (master_flag) {
     start_master(http_port > 0 ? &http_sfd : nullptr, &try_get_http_fd, http_port);
+    // start_master returns in workers only
+    if (http_reuseport && http_sfd >= 0) {
+      open_worker_http_reuseport_socket();
+    }
 
     if (logname_pattern != nullptr) {
       reopen_logs();
@@ -2148,8 +2522,8 @@ void start_server() {
     vkprintf (-1, "created listening socket at %s:%d, fd=%d\n", ip_to_print(settings_addr.s_addr), http_port, http_sfd);
   }
 
-  if (http_sfd >= 0) {
-    init_listening_tcpv6_connection(http_sfd, &ct_php_engine_http_server, &http_methods, SM_SPECIAL);
+  if (!start_http_warmup()) {
+    start_accepting_http();
   }
 
   if (rpc_sfd >= 0) {
@@ -2211,7 +2585,17 @@ void start_server() {
       vkprintf (1, "epoll_work(): %d out of %d connections, network buffers: %d used, %d out of %d allocated\n",
                 active_connections, maxconn, NB_used, NB_alloc, NB_max);
     }
+    // the busy poll is for the answers which a paused script is waiting for
+    epoll_set_busy_poll(active_worker != nullptr && active_worker->waiting);
     epoll_work(57);
+    if (HttpWarmup::get().in_progress() && HttpWarmup::get().run(precise_now)) {
+      finish_http_warmup();
+    }
+    warm_up_php_script();
+    release_unused_memory();
+    if (!php_worker_run_flag) {
+      Tracing::get().flush(precise_now);
+    }
 
     if (precise_now > next_create_outbound) {
       create_all_outbound_connections();
@@ -2261,14 +2645,21 @@ void start_server() {
   if (verbosity > 0 && pending_signals) {
     vkprintf (1, "Quitting because of pending signals = %llx\n", pending_signals);
   }
+  pgo_profile_dump();
+  Tracing::get().flush(precise_now, true);
 
   if (http_sfd >= 0) {
     epoll_close(http_sfd);
     assert (close(http_sfd) >= 0);
   }
+  if (http_reuseport_sfd >= 0) {
+    epoll_close(http_reuseport_sfd);
+    assert (close(http_reuseport_sfd) >= 0);
+  }
 }
 
 void set_instance_cache_memory_limit(size_t limit);
+void set_instance_cache_handover(bool enabled);
 void init_php_scripts() noexcept;
 void global_init_php_scripts() noexcept;
 const char *get_php_scripts_version() noexcept;
@@ -2290,6 +2681,7 @@ void init_all() {
 
   global_init_runtime_libs();
   global_init_php_scripts();
+  vkprintf(1, "global constants take %zu bytes of the read-only memory\n", dl::get_global_const_memory_size());
   global_init_script_allocator();
 
   init_handlers();
@@ -2586,6 +2978,203 @@ int main_args_handler(int i) {
       kprintf("couldn't set net-dc-mask '%s'\n", optarg);
       return -1;
     }
+    case 2013: {
+      set_pcre_jit_enabled(false);
+      return 0;
+    }
+    case 2014: {
+      script_memory_to_prefault = parse_memory_limit(optarg);
+      if (script_memory_to_prefault <= 0) {
+        kprintf("couldn't parse warm-up-script-memory argument\n");
+        return -1;
+      }
+      return 0;
+    }
+    case 2016: {
+      http_reuseport = 1;
+      return 0;
+    }
+    case 2017: {
+      http_reuseport = 1;
+      http_reuseport_cpu_steering = 1;
+      return 0;
+    }
+    case 2018: {
+      if (!set_workers_cpu_affinity_policy(optarg)) {
+        kprintf("unknown workers-cpu-affinity policy '%s', expected none, core, spread or numa\n", optarg);
+        return -1;
+      }
+      return 0;
+    }
+    case 2019: {
+      set_shared_memory_numa_interleave(true);
+      return 0;
+    }
+    case 2020: {
+      if (!parse_huge_pages_mode(optarg, &script_memory_huge_pages)) {
+        kprintf("unknown script-memory-huge-pages mode '%s', expected off, transparent or hugetlb\n", optarg);
+        return -1;
+      }
+      return 0;
+    }
+    case 2021: {
+      huge_pages_mode mode = huge_pages_mode::off;
+      if (!parse_huge_pages_mode(optarg, &mode)) {
+        kprintf("unknown shared-memory-huge-pages mode '%s', expected off, transparent or hugetlb\n", optarg);
+        return -1;
+      }
+      set_shared_memory_huge_pages_mode(mode);
+      return 0;
+    }
+    case 2022: {
+      double target_ms = 0;
+      double interval_ms = 100;
+      if (sscanf(optarg, "%lf:%lf", &target_ms, &interval_ms) < 1 || target_ms <= 0 || interval_ms <= 0) {
+        kprintf("couldn't parse admission-control argument, expected <target delay ms>[:<interval ms>]\n");
+        return -1;
+      }
+      AdmissionControl::get().set_delays(target_ms / 1000, interval_ms / 1000);
+      return 0;
+    }
+    case 2023: {
+      if (!set_http_compression_encodings(optarg)) {
+        kprintf("couldn't parse http-compression argument, expected a comma separated list of gzip and zstd\n");
+        return -1;
+      }
+      return 0;
+    }
+    case 2024: {
+      if (!set_http_compression_level(atoi(optarg))) {
+        kprintf("wrong http-compression-level '%s'\n", optarg);
+        return -1;
+      }
+      return 0;
+    }
+    case 2025: {
+      set_http_compression_min_size(parse_memory_limit(optarg));
+      return 0;
+    }
+    case 2026: {
+      http_methods.allow_http2 = 1;
+      return 0;
+    }
+    case 2027: {
+      if (set_sql_connections_limit(atoi(optarg))) {
+        return 0;
+      }
+      kprintf("couldn't set sql-connections '%s'\n", optarg);
+      return -1;
+    }
+    case 2028: {
+      if (set_sql_ping_interval(atof(optarg))) {
+        return 0;
+      }
+      kprintf("couldn't set sql-ping-interval '%s'\n", optarg);
+      return -1;
+    }
+    case 2029: {
+      set_sql_reset_session();
+      return 0;
+    }
+    case 2030: {
+      const int threads = atoi(optarg);
+      if (threads <= 0 || threads > 256) {
+        kprintf("couldn't parse confdata-snapshot-load-threads argument, expected a number from 1 to 256\n");
+        return -1;
+      }
+      set_confdata_snapshot_load_threads(threads);
+      return 0;
+    }
+    case 2031: {
+      const int hz = atoi(optarg);
+      if (hz < 0 || hz > 1000) {
+        kprintf("couldn't parse sampling-profiler-hz argument, expected a number from 0 to 1000\n");
+        return -1;
+      }
+      SamplingProfiler::get().set_frequency(hz);
+      return 0;
+    }
+    case 2032: {
+      if (set_lease_prefetch_depth(atoi(optarg))) {
+        return 0;
+      }
+      kprintf("couldn't parse lease-prefetch-depth argument, expected a number from 0 to 64\n");
+      return -1;
+    }
+    case 2033: {
+      script_memory_growth_step = parse_memory_limit(optarg);
+      if (script_memory_growth_step < 0 || script_memory_growth_step > memory_resource::memory_buffer_limit()) {
+        kprintf("couldn't parse script-memory-growth-step argument\n");
+        return -1;
+      }
+      return 0;
+    }
+    case 2034: {
+      const int requests = atoi(optarg);
+      if (requests < 0 || !MemoryReleaser::get().set_requests_window(static_cast<size_t>(requests))) {
+        kprintf("couldn't parse release-unused-memory-after argument, expected a number from 0 to %zu\n", MemoryReleaser::MAX_REQUESTS_WINDOW);
+        return -1;
+      }
+      return 0;
+    }
+    case 2035: {
+      if (!Tracing::get().set_sample_rate(atof(optarg))) {
+        kprintf("couldn't parse tracing-sample-rate argument, expected a number from 0 to 1\n");
+        return -1;
+      }
+      return 0;
+    }
+    case 2036: {
+      if (!Tracing::get().set_export_file(optarg)) {
+        kprintf("couldn't open tracing file %s: %m\n", optarg);
+        return -1;
+      }
+      return 0;
+    }
+    case 2037: {
+      Tracing::get().set_propagation(true);
+      return 0;
+    }
+    case 2038: {
+      set_instance_cache_handover(true);
+      return 0;
+    }
+    case 2039: {
+      if (!HttpWarmup::get().set_record_file(optarg)) {
+        kprintf("couldn't open warmup record file %s: %m\n", optarg);
+        return -1;
+      }
+      return 0;
+    }
+    case 2040: {
+      if (!HttpWarmup::get().set_record_rate(atof(optarg))) {
+        kprintf("couldn't parse warmup-record-rate argument, expected a number greater than 0 and up to 1\n");
+        return -1;
+      }
+      return 0;
+    }
+    case 2041: {
+      if (!HttpWarmup::get().load(optarg)) {
+        kprintf("couldn't read warmup file %s: %m\n", optarg);
+        return -1;
+      }
+      return 0;
+    }
+    case 2042: {
+      if (!HttpWarmup::get().set_timeout(atof(optarg))) {
+        kprintf("couldn't parse warmup-timeout argument, expected a positive number of seconds\n");
+        return -1;
+      }
+      return 0;
+    }
+    case 2015: {
+      if (sscanf(optarg, "%d:%d", &workers_autoscale_min, &workers_autoscale_max) != 2 ||
+          workers_autoscale_min <= 0 || workers_autoscale_min > workers_autoscale_max || workers_autoscale_max > MAX_WORKERS) {
+        kprintf("couldn't parse workers-autoscale argument, expected <min>:<max> with 0 < min <= max <= %d\n", MAX_WORKERS);
+        return -1;
+      }
+      return 0;
+    }
 
     default:
       return -1;
@@ -2651,6 +3240,36 @@ void parse_main_args(int argc, char *argv[]) {
   parse_option("profiler-log-prefix", required_argument, 2010, "set profier log path perfix");
   parse_option("mysql-db-name", required_argument, 2011, "database name of MySQL to connect");
   parse_option("net-dc-mask", required_argument, 2012, "a string formatted like '8=1.2.3.4/12' to detect a datacenter by ipv4");
+  parse_option("disable-pcre-jit", no_argument, 2013, "disable PCRE JIT compilation of the regexps shared between requests");
+  parse_option("warm-up-script-memory", required_argument, 2014, "create the script of a worker before its first request, prefaulting <memory> of the script memory; done after each script reload too");
+  parse_option("workers-autoscale", required_argument, 2015, "<min>:<max>, let the master adjust the number of workers between min and max by the accept queue length and the workers load; --workers-num is the initial number");
+  parse_option("http-reuseport", no_argument, 2016, "each worker also listens on its own SO_REUSEPORT http socket, so the kernel spreads new connections between workers");
+  parse_option("http-reuseport-cpu-steering", no_argument, 2017, "implies --http-reuseport, steer new http connections to the worker socket by the cpu which received them");
+  parse_option("workers-cpu-affinity", required_argument, 2018, "pin workers to cpus: 'core' (worker i to cpu i), 'spread' (single cpus round the numa nodes) or 'numa' (worker i to the cpus of node i % nodes)");
+  parse_option("shared-memory-numa-interleave", no_argument, 2019, "interleave pages of the confdata and instance cache shared memory over the numa nodes");
+  parse_option("admission-control", required_argument, 2022, "<target delay ms>[:<interval ms>], reject new http/rpc queries of an endpoint early with 503/flood control error while its queries wait for the script start longer than the target delay (100ms interval by default)");
+  parse_option("http-compression", required_argument, 2023, "compress http responses by the engine with the first of the comma separated encodings (gzip, zstd) accepted by the client, unless a script sets Content-Encoding itself");
+  parse_option("http-compression-level", required_argument, 2024, "the level of --http-compression, by default 6 for gzip and 3 for zstd");
+  parse_option("http-compression-min-size", required_argument, 2025, "don't compress http responses smaller than this size, 1024 bytes by default");
+  parse_option("http2", no_argument, 2026, "accept HTTP/2 without TLS (h2c) with prior knowledge on the http port, streams of a connection are served one by one by its worker");
+  parse_option("sql-connections", required_argument, 2027, "maximal number of sql connections kept by a worker (default: 3)");
+  parse_option("sql-ping-interval", required_argument, 2028, "ping the sql connections idle for that many seconds, disabled by default");
+  parse_option("sql-reset-session", no_argument, 2029, "reset the session state of the sql connections after every script run");
+  parse_option("confdata-snapshot-load-threads", required_argument, 2030, "the number of threads checking the keys of the confdata snapshot on loading");
+  parse_option("sampling-profiler-hz", required_argument, 2031, "sample the stacks of the running scripts of each worker that many times per second of its cpu time, the master serves them as collapsed stacks at /profile of the master http interface; 0 (default) disables it");
+  parse_option("script-memory-growth-step", required_argument, 2033, "the script memory of a worker starts with that many bytes and grows by them on demand up to the memory limit, the grown part is given back to the system after the request; 0 (default) uses the whole memory limit at once");
+  parse_option("release-unused-memory-after", required_argument, 2034, "a worker gives the script memory and the heap memory, which haven't been needed by that many last requests, back to the system while it is idle; 0 (default) disables it");
+  parse_option("tracing-sample-rate", required_argument, 2035, "the part of the requests, which spans of the outgoing queries are traced, from 0 (default) to 1; the requests sampled by the callers are traced anyway");
+  parse_option("tracing-file", required_argument, 2036, "the file the traced spans are appended to as json lines, the tracing is off without it");
+  parse_option("tracing-propagate", no_argument, 2037, "send the trace context in the headers of the outgoing rpc queries, the engines which don't support it reject such queries");
+  parse_option("instance-cache-handover", no_argument, 2038, "hand the instance cache over to the next master on the graceful restart, if it runs the same binary; the constant strings and arrays are copied into the cache then");
+  parse_option("warmup-record-file", required_argument, 2039, "the file a sample of the http requests is appended to, to replay it with --warmup-file later; it isn't appended to after 64MB");
+  parse_option("warmup-record-rate", required_argument, 2040, "the part of the http requests which are recorded to --warmup-record-file, 0.001 by default");
+  parse_option("warmup-file", required_argument, 2041, "the recorded http requests, which every started worker runs before it accepts the real ones");
+  parse_option("warmup-timeout", required_argument, 2042, "the worker stops replaying the recorded requests after that many seconds, 10 by default");
+  parse_option("lease-prefetch-depth", required_argument, 2032, "in the lease mode, request up to that many next tasks from the tasks engine while a task is running; the depth is reduced for long tasks, 0 (default) disables it");
+  parse_option("script-memory-huge-pages", required_argument, 2020, "back the script memory of workers with huge pages: off, transparent (madvise) or hugetlb (falls back to transparent)");
+  parse_option("shared-memory-huge-pages", required_argument, 2021, "back the confdata and instance cache shared memory with huge pages: off, transparent (madvise) or hugetlb (falls back to transparent)");
   parse_engine_options_long(argc, argv, main_args_handler);
   parse_main_args_till_option(argc, argv);
 }
@@ -26,6 +26,8 @@ struct command_net_write_t {
 };
 
 void net_error(net_ansgen_t *ansgen, php_query_base_t *query, const char *err);
+conn_query *alloc_conn_query();
+void free_conn_query(conn_query *q);
 conn_query *create_pnet_query(connection *http_conn, connection *conn, net_ansgen_t *gen, double finish_time);
 void pnet_query_delete(conn_query *q);
 extern void *php_script;
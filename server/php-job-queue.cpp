@@ -0,0 +1,192 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-job-queue.h"
+
+#include <cassert>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "common/cacheline.h"
+#include "common/huge-pages.h"
+
+namespace {
+
+size_t align_up(size_t size, size_t alignment) noexcept {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+// Bounded multi-producer multi-consumer queue by D. Vyukov:
+// each cell has a sequence number telling whether it is ready for the next push or the next pop
+class JobQueue::index_queue : vk::not_copyable {
+public:
+  explicit index_queue(size_t capacity) noexcept :
+    mask_(capacity - 1) {
+    for (size_t i = 0; i != capacity; ++i) {
+      new(&cells_[i]) cell{};
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  static size_t memory_size(size_t capacity) noexcept {
+    return sizeof(index_queue) + capacity * sizeof(cell);
+  }
+
+  bool push(uint32_t value) noexcept {
+    size_t pos = push_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell &c = cells_[pos & mask_];
+      const size_t sequence = c.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (push_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          c.value = value;
+          c.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = push_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool pop(uint32_t &value) noexcept {
+    size_t pos = pop_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell &c = cells_[pos & mask_];
+      const size_t sequence = c.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (pop_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          value = c.value;
+          c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = pop_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  size_t size() const noexcept {
+    const size_t push_pos = push_pos_.load(std::memory_order_relaxed);
+    const size_t pop_pos = pop_pos_.load(std::memory_order_relaxed);
+    return push_pos > pop_pos ? push_pos - pop_pos : 0;
+  }
+
+private:
+  struct cell {
+    std::atomic<size_t> sequence{0};
+    uint32_t value{0};
+  };
+
+  const size_t mask_;
+  alignas(KDB_CACHELINE_SIZE) std::atomic<size_t> push_pos_{0};
+  alignas(KDB_CACHELINE_SIZE) std::atomic<size_t> pop_pos_{0};
+  alignas(KDB_CACHELINE_SIZE) cell cells_[0];
+};
+
+bool JobQueue::init(size_t messages_count, size_t payload_size) noexcept {
+  assert(!is_initialized());
+  size_t capacity = 1;
+  while (capacity < messages_count) {
+    capacity <<= 1;
+  }
+  const size_t queue_size = align_up(index_queue::memory_size(capacity), KDB_CACHELINE_SIZE);
+  const size_t message_size = align_up(sizeof(JobMessage) + payload_size, KDB_CACHELINE_SIZE);
+  const size_t memory_size = align_up(2 * queue_size + capacity * message_size, getpagesize());
+
+  void *memory = mmap_shared_memory(memory_size);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+
+  shared_memory_ = memory;
+  shared_memory_size_ = memory_size;
+  messages_count_ = capacity;
+  message_size_ = message_size;
+  char *pos = static_cast<char *>(memory);
+  free_messages_ = new(pos) index_queue{capacity};
+  jobs_ = new(pos + queue_size) index_queue{capacity};
+  messages_ = pos + 2 * queue_size;
+  for (uint32_t i = 0; i != capacity; ++i) {
+    new(message_at(i)) JobMessage{};
+    free_messages_->push(i);
+  }
+  return true;
+}
+
+void JobQueue::destroy() noexcept {
+  if (is_initialized()) {
+    munmap(shared_memory_, shared_memory_size_);
+    shared_memory_ = nullptr;
+    shared_memory_size_ = messages_count_ = message_size_ = 0;
+    free_messages_ = jobs_ = nullptr;
+    messages_ = nullptr;
+  }
+}
+
+uint32_t JobQueue::message_index(const JobMessage *message) const noexcept {
+  const auto offset = static_cast<size_t>(reinterpret_cast<const char *>(message) - messages_);
+  assert(offset % message_size_ == 0 && offset / message_size_ < messages_count_);
+  return static_cast<uint32_t>(offset / message_size_);
+}
+
+JobMessage *JobQueue::message_at(uint32_t index) const noexcept {
+  return reinterpret_cast<JobMessage *>(messages_ + index * message_size_);
+}
+
+JobMessage *JobQueue::acquire_message() noexcept {
+  uint32_t index = 0;
+  if (!free_messages_->pop(index)) {
+    return nullptr;
+  }
+  JobMessage *message = message_at(index);
+  message->sender_pid = getpid();
+  message->payload_size = 0;
+  message->job_state.store(JobMessage::state::acquired, std::memory_order_relaxed);
+  return message;
+}
+
+void JobQueue::release_message(JobMessage *message) noexcept {
+  message->job_state.store(JobMessage::state::free, std::memory_order_relaxed);
+  // there is a place for each message, so it can't fail
+  const bool pushed = free_messages_->push(message_index(message));
+  assert(pushed);
+}
+
+bool JobQueue::send_job(JobMessage *message) noexcept {
+  message->job_state.store(JobMessage::state::queued, std::memory_order_relaxed);
+  if (!jobs_->push(message_index(message))) {
+    message->job_state.store(JobMessage::state::acquired, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+JobMessage *JobQueue::take_job() noexcept {
+  uint32_t index = 0;
+  if (!jobs_->pop(index)) {
+    return nullptr;
+  }
+  JobMessage *message = message_at(index);
+  message->job_state.store(JobMessage::state::running, std::memory_order_relaxed);
+  return message;
+}
+
+void JobQueue::finish_job(JobMessage *message) noexcept {
+  // the result written into the payload is visible to the sender, which sees the done state
+  message->job_state.store(JobMessage::state::done, std::memory_order_release);
+}
+
+size_t JobQueue::get_queued_jobs() const noexcept {
+  return jobs_ ? jobs_->size() : 0;
+}
@@ -0,0 +1,79 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "common/mixin/not_copyable.h"
+
+// A job sent by a worker to the job workers, the arguments and then the result are written into the payload
+struct JobMessage {
+  enum class state : uint32_t {
+    free,
+    acquired,
+    queued,
+    running,
+    done,
+  };
+
+  std::atomic<state> job_state{state::free};
+  pid_t sender_pid{0};
+  uint32_t payload_size{0};
+  // the payload memory follows the header
+  char *payload() noexcept { return reinterpret_cast<char *>(this + 1); }
+};
+
+// The shared memory channel between the workers and the job workers, it's mapped by master before the fork.
+// There is a pool of fixed size messages and two lock-free queues of their indices: the free messages
+// and the jobs waiting for a job worker. The result is returned in the message of the job,
+// the sender takes it when the job is done and gives the message back to the pool.
+class JobQueue : vk::not_copyable {
+public:
+  static JobQueue &get() noexcept {
+    static JobQueue job_queue;
+    return job_queue;
+  }
+
+  // the sizes are rounded up: the messages count to a power of 2, the payload size to the cache line
+  bool init(size_t messages_count, size_t payload_size) noexcept;
+  bool is_initialized() const noexcept { return shared_memory_ != nullptr; }
+  void destroy() noexcept;
+
+  size_t get_payload_size() const noexcept { return message_size_ - sizeof(JobMessage); }
+
+  // returns nullptr if all the messages are in use
+  JobMessage *acquire_message() noexcept;
+  void release_message(JobMessage *message) noexcept;
+
+  // returns false if the job can't be queued, the message stays acquired
+  bool send_job(JobMessage *message) noexcept;
+  // returns nullptr if there are no jobs
+  JobMessage *take_job() noexcept;
+  void finish_job(JobMessage *message) noexcept;
+  static bool is_job_done(const JobMessage *message) noexcept {
+    return message->job_state.load(std::memory_order_acquire) == JobMessage::state::done;
+  }
+
+  size_t get_queued_jobs() const noexcept;
+
+private:
+  class index_queue;
+
+  JobQueue() = default;
+
+  uint32_t message_index(const JobMessage *message) const noexcept;
+  JobMessage *message_at(uint32_t index) const noexcept;
+
+  void *shared_memory_{nullptr};
+  size_t shared_memory_size_{0};
+  size_t messages_count_{0};
+  size_t message_size_{0};
+  index_queue *free_messages_{nullptr};
+  index_queue *jobs_{nullptr};
+  char *messages_{nullptr};
+};
@@ -4,6 +4,8 @@
 
 #include "server/php-lease.h"
 
+#include <algorithm>
+
 #include "common/options.h"
 #include "common/precise-time.h"
 #include "common/tl/constants/common.h"
@@ -34,6 +36,14 @@ static double lease_stats_time;
 static long long lease_stats_cnt;
 static int ready_cnt = 0;
 
+// A busy worker may ask the tasks engine for the next tasks in advance, they wait in the input buffer of the lease connection
+// and are started right after the current one without a round trip to the tasks engine.
+// The prefetched task waits for the tasks before it, so the depth is limited by the average task time.
+static int lease_prefetch_max_depth = 0;
+static constexpr double LEASE_PREFETCHED_TASK_MAX_WAIT = 0.1;
+// kphp.ready sent by a busy worker, for which the tasks haven't been started yet
+static int lease_prefetched_tasks = 0;
+
 enum lease_state_t {
   lst_off,            // connect to rpc-proxy, wait kphp.startLease from it, connect to target
   lst_start,          // if !has_pending_scripts -> change state to lst_on, wait for connection to target ready, do lease_set_ready() && run_rpc_lease();
@@ -71,6 +81,7 @@ static void lease_change_state(lease_state_t new_state) {
   if (lease_state != new_state) {
     lease_state = new_state;
     lease_ready_flag = 0;
+    lease_prefetched_tasks = 0;
   }
 }
 
@@ -226,6 +237,27 @@ static int lease_off() {
   return 0;
 }
 
+static int get_lease_prefetch_depth() {
+  if (!lease_prefetch_max_depth) {
+    return 0;
+  }
+  if (!lease_stats_cnt) {
+    return 1;
+  }
+  const double average_task_time = lease_stats_time / static_cast<double>(lease_stats_cnt);
+  return std::min(lease_prefetch_max_depth, static_cast<int>(LEASE_PREFETCHED_TASK_MAX_WAIT / std::max(average_task_time, 1e-6)));
+}
+
+static void lease_prefetch_tasks() {
+  if (lease_state != lst_on) {
+    return;
+  }
+  const int depth = get_lease_prefetch_depth();
+  while (lease_prefetched_tasks < depth && rpct_ready(rpc_lease_target) >= 0) {
+    ++lease_prefetched_tasks;
+  }
+}
+
 static int lease_on() {
   assert(lease_state == lst_on);
   if (!lease_ready_flag) {
@@ -234,6 +266,11 @@ static int lease_on() {
   if (has_pending_scripts()) {
     return 0;
   }
+  // the prefetched task is already on its way or in the input buffer
+  if (lease_prefetched_tasks) {
+    lease_ready_flag = 0;
+    return 0;
+  }
   // query the tasks engine to get new tasks
   if (rpct_ready(rpc_lease_target) >= 0) {
     lease_ready_flag = 0;
@@ -352,6 +389,29 @@ void lease_set_ready() {
   lease_ready_flag = 1;
 }
 
+void lease_on_task_received(connection *c) {
+  if (lease_state != lst_on || c->target != &Targets[rpc_lease_target]) {
+    return;
+  }
+  if (lease_prefetched_tasks) {
+    --lease_prefetched_tasks;
+  }
+  lease_prefetch_tasks();
+}
+
+void lease_on_connection_ready() {
+  // the tasks prefetched by the previous connection won't come
+  lease_prefetched_tasks = 0;
+}
+
+bool set_lease_prefetch_depth(int depth) {
+  if (depth < 0 || depth > 64) {
+    return false;
+  }
+  lease_prefetch_max_depth = depth;
+  return true;
+}
+
 void lease_on_stop() {
   if (rpc_proxy_target != -1) {
     conn_target_t *target = &Targets[rpc_proxy_target];
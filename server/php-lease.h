@@ -14,6 +14,9 @@
 
 void lease_on_worker_finish(php_worker *worker);
 void lease_set_ready();
+void lease_on_task_received(connection *c);
+void lease_on_connection_ready();
+bool set_lease_prefetch_depth(int depth);
 void lease_on_stop();
 void run_rpc_lease();
 void do_rpc_stop_lease();
@@ -11,6 +11,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -30,8 +32,10 @@
 #include "common/crc32c.h"
 #include "common/dl-utils-lite.h"
 #include "common/kprintf.h"
+#include "common/numa.h"
 #include "common/pipe-utils.h"
 #include "common/precise-time.h"
+#include "common/resolver.h"
 #include "common/server/limits.h"
 #include "common/server/signals.h"
 #include "common/server/stats.h"
@@ -50,8 +54,12 @@
 #include "server/confdata-binlog-replay.h"
 #include "server/php-engine-vars.h"
 #include "server/php-engine.h"
+#include "server/php-warmup.h"
 #include "server/php-worker-stats.h"
+#include "server/php-worker-metrics.h"
 #include "server/php-master-tl-handlers.h"
+#include "server/php-pgo-profile.h"
+#include "server/php-sampling-profiler.h"
 
 extern const char *engine_tag;
 
@@ -85,7 +93,12 @@ struct master_data_t {
   int ask_http_fd_generation;
   int sent_http_fd_generation;
 
-  int reserved[50];
+  // the fields are taken from the reserved ones, the masters which don't know them see zeros
+  int own_instance_cache_handover;
+  int ask_instance_cache_generation;
+  int sent_instance_cache_generation;
+
+  int reserved[47];
 };
 
 struct shared_data_t {
@@ -120,6 +133,8 @@ void mem_info_add(mem_info_t *dst, const mem_info_t &other) {
   dst->vm += other.vm;
   dst->rss_peak += other.rss_peak;
   dst->rss += other.rss;
+  dst->hugetlb += other.hugetlb;
+  dst->anon_huge += other.anon_huge;
   // do not accumulate rss_file and rss_shmem,
   // because they are about shared memory and accumulated value will show strange stat
 }
@@ -342,6 +357,10 @@ struct Stats {
     res += buffer;
     sprintf(buffer, "RSS_max%s\t%lluKb\n", pid_s.c_str(), mem_info.rss_peak);
     res += buffer;
+    sprintf(buffer, "HugetlbPages%s\t%lluKb\n", pid_s.c_str(), mem_info.hugetlb);
+    res += buffer;
+    sprintf(buffer, "AnonHugePages%s\t%lluKb\n", pid_s.c_str(), mem_info.anon_huge);
+    res += buffer;
 
     if (is_main) {
       std::string running_workers_max_vals;
@@ -602,9 +621,74 @@ static int socket_fd = -1;
 static int to_kill = 0, to_run = 0, to_exit = 0;
 static long long generation;
 static int receive_fd_attempts_cnt = 0;
+// the instance cache is asked from the previous master once, before the workers are started
+static bool need_instance_cache = false;
+static int receive_instance_cache_attempts_cnt = 0;
+static bool instance_cache_attached = false;
 
 static worker_info_t *free_workers = nullptr;
 
+static workers_cpu_affinity_policy cpu_affinity_policy = workers_cpu_affinity_policy::none;
+
+bool set_workers_cpu_affinity_policy(const char *policy) {
+  if (!strcmp(policy, "none")) {
+    cpu_affinity_policy = workers_cpu_affinity_policy::none;
+  } else if (!strcmp(policy, "core")) {
+    cpu_affinity_policy = workers_cpu_affinity_policy::core;
+  } else if (!strcmp(policy, "spread")) {
+    cpu_affinity_policy = workers_cpu_affinity_policy::spread;
+  } else if (!strcmp(policy, "numa")) {
+    cpu_affinity_policy = workers_cpu_affinity_policy::numa;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static int nth_cpu(const cpu_set_t &cpus, int n) {
+  n %= CPU_COUNT(&cpus);
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &cpus) && n-- == 0) {
+      return cpu;
+    }
+  }
+  return -1;
+}
+
+// called in a new worker, the worker id is stable across worker restarts
+static void set_worker_cpu_affinity(int worker_id) {
+  if (cpu_affinity_policy == workers_cpu_affinity_policy::none) {
+    return;
+  }
+  const int nodes_count = numa_nodes_count();
+  cpu_set_t cpus;
+  cpu_set_t result;
+  CPU_ZERO(&result);
+  bool ok = false;
+  switch (cpu_affinity_policy) {
+    case workers_cpu_affinity_policy::core:
+      ok = sched_getaffinity(0, sizeof(cpus), &cpus) == 0;
+      if (ok) {
+        CPU_SET(nth_cpu(cpus, worker_id), &result);
+      }
+      break;
+    case workers_cpu_affinity_policy::spread:
+      ok = numa_node_cpus(worker_id % nodes_count, &cpus);
+      if (ok) {
+        CPU_SET(nth_cpu(cpus, worker_id / nodes_count), &result);
+      }
+      break;
+    case workers_cpu_affinity_policy::numa:
+      ok = numa_node_cpus(worker_id % nodes_count, &result);
+      break;
+    default:
+      dl_unreachable("unknown cpu affinity policy");
+  }
+  if (!ok || sched_setaffinity(0, sizeof(result), &result) != 0) {
+    kprintf("failed to set cpu affinity of worker %d: %m\n", worker_id);
+  }
+}
+
 void worker_init(worker_info_t *w) {
   w->stats = new Stats();
   w->valid_my_info = 0;
@@ -659,6 +743,8 @@ void start_master(int *new_http_fd, int (*new_try_get_http_fd)(), int new_http_f
   for (int i = MAX_WORKERS - 1; i >= 0; i--) {
     add_logname_id(i);
   }
+  WorkerMetrics::get().init(MAX_WORKERS);
+  SamplingProfiler::get().init(MAX_WORKERS);
 
   std::string s = cluster_name;
   std::replace_if(s.begin(), s.end(), [](unsigned char c) { return !isalpha(c); }, '_');
@@ -676,6 +762,8 @@ void start_master(int *new_http_fd, int (*new_try_get_http_fd)(), int new_http_f
 
   vkprintf(1, "start master: begin\n");
 
+  kdb_resolver_cache_init();
+
   sigemptyset(&empty_mask);
 
   //currently all signals are blocked
@@ -713,6 +801,7 @@ void start_master(int *new_http_fd, int (*new_try_get_http_fd)(), int new_http_f
 
     if (me != nullptr) {
       master_init(me, other);
+      master_slot_id = static_cast<int>(me - shared_data->masters);
       is_inited = 1;
     }
 
@@ -752,6 +841,13 @@ void terminate_worker(worker_info_t *w) {
 
 int kill_worker() {
   int i;
+  // prefer a worker that isn't serving a request right now
+  for (i = 0; i < me_workers_n; i++) {
+    if (!workers[i]->is_dying && !workers[i]->stats->istats.is_running) {
+      terminate_worker(workers[i]);
+      return 1;
+    }
+  }
   for (i = 0; i < me_workers_n; i++) {
     if (!workers[i]->is_dying) {
       terminate_worker(workers[i]);
@@ -762,6 +858,17 @@ int kill_worker() {
   return 0;
 }
 
+// the workers which are replaying the recorded requests and don't accept the real ones yet
+static int count_warming_up_workers() {
+  int res = 0;
+  for (int i = 0; i < me_workers_n; i++) {
+    if (!workers[i]->is_dying && WorkerMetrics::get().is_warming_up(workers[i]->logname_id)) {
+      res++;
+    }
+  }
+  return res;
+}
+
 #define MAX_HANGING_TIME 65.0
 
 void kill_hanging_workers() {
@@ -994,6 +1101,10 @@ int run_worker() {
 
     signal_fd = -1;
     logname_id = worker_logname_id;
+    set_worker_cpu_affinity(worker_logname_id);
+    WorkerMetrics::get().on_worker_start(worker_logname_id, pid);
+    SamplingProfiler::get().on_worker_start(worker_logname_id);
+    pgo_profile_on_worker_start();
     if (logname_pattern) {
       char buf[100];
       snprintf(buf, 100, logname_pattern, worker_logname_id);
@@ -1101,7 +1212,11 @@ static const sockaddr_un *get_socket_addr() {
   return &unix_socket_addr;
 }
 
-static int send_fd_via_socket(int fd) {
+// the byte sent with the fd tells what it is
+static constexpr char HTTP_FD_TAG = 'x';
+static constexpr char INSTANCE_CACHE_FD_TAG = 'c';
+
+static int send_fd_via_socket(int fd, char tag = HTTP_FD_TAG) {
   int unix_socket_fd = socket(AF_LOCAL, SOCK_DGRAM, 0);
   dl_passert (fd >= 0, "failed to create socket");
 
@@ -1109,7 +1224,7 @@ static int send_fd_via_socket(int fd) {
   char ccmsg[CMSG_SPACE(sizeof(fd))];
   cmsghdr *cmsg;
   iovec vec;  /* stupidity: must send/receive at least one byte */
-  const char *str = "x";
+  char str[1] = {tag};
   int rv;
 
   msg.msg_name = (sockaddr *)get_socket_addr();
@@ -1140,6 +1255,7 @@ static int send_fd_via_socket(int fd) {
   } else {
     perror("failed to send http_fd (sendmsg)");
   }
+  close(unix_socket_fd);
   return rv;
 }
 
@@ -1156,7 +1272,7 @@ static int sock_dgram(const char *path) {
 }
 
 /* receive a file descriptor over file descriptor fd */
-static int receive_fd(int fd) {
+static int receive_fd(int fd, char tag = HTTP_FD_TAG) {
   msghdr msg;
   iovec iov;
   char buf[1];
@@ -1189,7 +1305,13 @@ static int receive_fd(int fd) {
             cmsg->cmsg_type);
     return -1;
   }
-  return *(int *)CMSG_DATA (cmsg);
+  const int received_fd = *(int *)CMSG_DATA (cmsg);
+  if (buf[0] != tag) {
+    // the old master sends the http fd while it's asked for, so the extra ones are skipped
+    close(received_fd);
+    return receive_fd(fd, tag);
+  }
+  return received_fd;
 }
 
 
@@ -1415,6 +1537,15 @@ std::string php_master_prepare_stats(bool full_flag, int worker_pid) {
 
   if (full_flag) {
     header += worker_stats.to_string();
+
+    std::string latency_stats(4096, 0);
+    stats_t stats;
+    stats.type = STATS_TYPE_TL;
+    stats.statsd_prefix = nullptr;
+    sb_init(&stats.sb, &latency_stats[0], static_cast<int>(latency_stats.size()));
+    WorkerMetrics::get().write_latency_stats_to(&stats, my_now);
+    latency_stats.resize(stats.sb.pos);
+    header += latency_stats;
   }
   if (!full_flag && worker_pid == -2) {
     header += " pid \t  state time\t  port  actor time\tcustom_server_status time\n";
@@ -1495,7 +1626,7 @@ int php_master_get(connection *c, const char *old_key, int old_key_len) {
   //workers_pids
   if (key_len == 12 && strncmp(key, "workers_pids", 12) == 0) {
     std::string res;
-    for (int i = 0; i < workers_n; i++) {
+    for (int i = 0; i < me_workers_n; i++) {
       if (!workers[i]->is_dying) {
         char buf[30];
         sprintf(buf, "%d", workers[i]->pid);
@@ -1588,6 +1719,149 @@ struct WorkerStats {
   }
 };
 
+/*** workers autoscaling ***/
+class WorkersAutoscaler {
+public:
+  static WorkersAutoscaler &get() {
+    static WorkersAutoscaler autoscaler;
+    return autoscaler;
+  }
+
+  bool enabled() const {
+    return workers_autoscale_max > 0;
+  }
+
+  int target_workers_n() {
+    if (!enabled()) {
+      return workers_n;
+    }
+    if (target_ == 0) {
+      target_ = std::min(std::max(workers_n, workers_autoscale_min), workers_autoscale_max);
+    }
+    return target_;
+  }
+
+  // called once a second from the master cron
+  void update(const WorkerStats &worker_stats, bool in_graceful_restart) {
+    if (!enabled()) {
+      return;
+    }
+    accept_queue_len_ = get_accept_queue_len();
+    const int total = worker_stats.total_workers_n;
+    if (total == 0) {
+      return;
+    }
+    double idle_percent = 0;
+    for (int i = 0; i < me_workers_n; i++) {
+      if (!workers[i]->is_dying) {
+        idle_percent += workers[i]->stats->istats.idle_percent;
+      }
+    }
+    idle_percent_avg_ = idle_percent / total;
+    const double busy_ratio = static_cast<double>(worker_stats.running_workers_n) / total;
+    busy_ratio_avg_ = busy_ratio_avg_ * (1 - SMOOTHING) + busy_ratio * SMOOTHING;
+
+    const bool overloaded = accept_queue_len_ > 0 || busy_ratio_avg_ > BUSY_RATIO_HIGH || idle_percent_avg_ < IDLE_PERCENT_LOW;
+    const bool underloaded = accept_queue_len_ == 0 && busy_ratio_avg_ < BUSY_RATIO_LOW && idle_percent_avg_ > IDLE_PERCENT_HIGH;
+    overloaded_ticks_ = overloaded ? overloaded_ticks_ + 1 : 0;
+    underloaded_ticks_ = underloaded ? underloaded_ticks_ + 1 : 0;
+
+    // don't decide while the workers are replaced or the previous decision isn't applied yet
+    if (in_graceful_restart || total != target_workers_n() || last_decision_time_ + DECISION_COOLDOWN > my_now) {
+      return;
+    }
+
+    const int target = target_workers_n();
+    if (overloaded_ticks_ >= SCALE_UP_TICKS && target < workers_autoscale_max) {
+      decide(std::min(target + std::max(target / 10, 1), workers_autoscale_max), scale_ups_);
+    } else if (underloaded_ticks_ >= SCALE_DOWN_TICKS && target > workers_autoscale_min) {
+      decide(target - 1, scale_downs_);
+    }
+  }
+
+  void write_stats_html(std::string &html) const {
+    if (!enabled()) {
+      return;
+    }
+    char buf[256];
+    sprintf(buf, "autoscale_workers\t%d [%d, %d]\n", target_, workers_autoscale_min, workers_autoscale_max);
+    html += buf;
+    sprintf(buf, "autoscale_accept_queue\t%d\n", accept_queue_len_);
+    html += buf;
+    sprintf(buf, "autoscale_busy_ratio_avg\t%7.3lf\n", busy_ratio_avg_);
+    html += buf;
+    sprintf(buf, "autoscale_idle_percent_avg\t%7.3lf\n", idle_percent_avg_);
+    html += buf;
+    sprintf(buf, "autoscale_decisions\t%ld up, %ld down\n", scale_ups_, scale_downs_);
+    html += buf;
+    sprintf(buf, "autoscale_last_decision\t%s\n", last_decision_);
+    html += buf;
+  }
+
+  void write_stats(stats_t *stats) const {
+    if (!enabled()) {
+      return;
+    }
+    add_histogram_stat_long(stats, "workers.autoscale.target", target_);
+    add_histogram_stat_long(stats, "workers.autoscale.min", workers_autoscale_min);
+    add_histogram_stat_long(stats, "workers.autoscale.max", workers_autoscale_max);
+    add_histogram_stat_long(stats, "workers.autoscale.accept_queue", accept_queue_len_);
+    add_histogram_stat_double(stats, "workers.autoscale.busy_ratio_avg", busy_ratio_avg_);
+    add_histogram_stat_double(stats, "workers.autoscale.idle_percent_avg", idle_percent_avg_);
+    add_histogram_stat_long(stats, "workers.autoscale.scale_ups", scale_ups_);
+    add_histogram_stat_long(stats, "workers.autoscale.scale_downs", scale_downs_);
+  }
+
+private:
+  static constexpr double SMOOTHING = 0.2;
+  static constexpr double BUSY_RATIO_HIGH = 0.85;
+  static constexpr double BUSY_RATIO_LOW = 0.5;
+  static constexpr double IDLE_PERCENT_LOW = 10;
+  static constexpr double IDLE_PERCENT_HIGH = 50;
+  // scale up quickly, scale down slowly: that is the hysteresis
+  static constexpr int SCALE_UP_TICKS = 3;
+  static constexpr int SCALE_DOWN_TICKS = 60;
+  static constexpr double DECISION_COOLDOWN = 10;
+
+  WorkersAutoscaler() = default;
+
+  static int get_accept_queue_len() {
+    if (http_fd == nullptr || *http_fd == -1) {
+      return 0;
+    }
+    // for a listening socket tcpi_unacked is the number of connections waiting in the accept queue
+    tcp_info info{};
+    socklen_t info_len = sizeof(info);
+    if (getsockopt(*http_fd, IPPROTO_TCP, TCP_INFO, &info, &info_len) != 0) {
+      return 0;
+    }
+    return static_cast<int>(info.tcpi_unacked);
+  }
+
+  void decide(int new_target, long &counter) {
+    snprintf(last_decision_, sizeof(last_decision_),
+             "%d -> %d at %.0lf: accept queue %d, busy ratio %.3lf, idle %.1lf%%",
+             target_, new_target, my_now, accept_queue_len_, busy_ratio_avg_, idle_percent_avg_);
+    vkprintf(0, "workers autoscale: %s\n", last_decision_);
+    target_ = new_target;
+    counter++;
+    last_decision_time_ = my_now;
+    overloaded_ticks_ = 0;
+    underloaded_ticks_ = 0;
+  }
+
+  int target_{0};
+  int accept_queue_len_{0};
+  double busy_ratio_avg_{0};
+  double idle_percent_avg_{100};
+  int overloaded_ticks_{0};
+  int underloaded_ticks_{0};
+  double last_decision_time_{0};
+  long scale_ups_{0};
+  long scale_downs_{0};
+  char last_decision_[160]{"none"};
+};
+
 std::string get_master_stats_html() {
   const auto worker_stats = WorkerStats::collect();
 
@@ -1605,6 +1879,7 @@ std::string get_master_stats_html() {
     sprintf(buf, "running_workers_avg_%s\t%7.3lf\n", periods_desc[i], server_stats.misc[i].get_stat().running_workers_avg);
     html += buf;
   }
+  WorkersAutoscaler::get().write_stats_html(html);
 
   return html;
 }
@@ -1664,6 +1939,7 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, STATS_TAG_KPHP_SERVER) {
   add_histogram_stat_long(stats, "workers.current.working", worker_stats.running_workers_n);
   add_histogram_stat_long(stats, "workers.current.working_but_waiting", worker_stats.paused_workers_n);
   add_histogram_stat_long(stats, "workers.current.ready_for_accept", worker_stats.ready_for_accept_workers_n);
+  WorkersAutoscaler::get().write_stats(stats);
 
   add_histogram_stat_long(stats, "workers.total.started", tot_workers_started);
   add_histogram_stat_long(stats, "workers.total.dead", tot_workers_dead);
@@ -1673,6 +1949,14 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, STATS_TAG_KPHP_SERVER) {
   add_histogram_stat_long(stats, "workers.total.terminated", workers_terminated);
   add_histogram_stat_long(stats, "workers.total.failed", workers_failed);
 
+  numa_stats_t numa_stats;
+  if (numa_nodes_count() > 1 && read_numa_stats(&numa_stats)) {
+    add_histogram_stat_long(stats, "numa.nodes", numa_nodes_count());
+    add_histogram_stat_long(stats, "numa.local_node_allocations", numa_stats.local_node);
+    add_histogram_stat_long(stats, "numa.other_node_allocations", numa_stats.other_node);
+    add_histogram_stat_long(stats, "numa.miss_allocations", numa_stats.numa_miss);
+  }
+
   const auto workers_stats = server_stats.misc[1].get_stat();
   add_histogram_stat_double(stats, "workers.running.avg_1m", workers_stats.running_workers_avg);
   add_histogram_stat_long(stats, "workers.running.max_1m", workers_stats.running_workers_max);
@@ -1694,6 +1978,10 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, STATS_TAG_KPHP_SERVER) {
                           instance_cache_element_stats.elements_storing_skipped_due_recent_update.load(std::memory_order_relaxed));
   add_histogram_stat_long(stats, "instance_cache.elements.storing_delayed_due_mutex",
                           instance_cache_element_stats.elements_storing_delayed_due_mutex.load(std::memory_order_relaxed));
+  add_histogram_stat_long(stats, "instance_cache.elements.storing_deferred",
+                          instance_cache_element_stats.elements_storing_deferred.load(std::memory_order_relaxed));
+  add_histogram_stat_long(stats, "instance_cache.elements.stored_deferred",
+                          instance_cache_element_stats.elements_stored_deferred.load(std::memory_order_relaxed));
   add_histogram_stat_long(stats, "instance_cache.elements.fetched",
                           instance_cache_element_stats.elements_fetched.load(std::memory_order_relaxed));
   add_histogram_stat_long(stats, "instance_cache.elements.missed",
@@ -1702,6 +1990,8 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, STATS_TAG_KPHP_SERVER) {
                           instance_cache_element_stats.elements_missed_earlier.load(std::memory_order_relaxed));
   add_histogram_stat_long(stats, "instance_cache.elements.expired",
                           instance_cache_element_stats.elements_expired.load(std::memory_order_relaxed));
+  add_histogram_stat_long(stats, "instance_cache.elements.evicted",
+                          instance_cache_element_stats.elements_evicted.load(std::memory_order_relaxed));
   add_histogram_stat_long(stats, "instance_cache.elements.created",
                           instance_cache_element_stats.elements_created.load(std::memory_order_relaxed));
   add_histogram_stat_long(stats, "instance_cache.elements.destroyed",
@@ -1713,9 +2003,20 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, STATS_TAG_KPHP_SERVER) {
   add_histogram_stat_long(stats, "instance_cache.elements.logically_expired_but_fetched",
                           instance_cache_element_stats.elements_logically_expired_but_fetched.load(std::memory_order_relaxed));
 
-  write_confdata_stats_to(stats);
+  const auto instance_cache_shards_stats = instance_cache_get_shards_stats();
+  add_histogram_stat_long(stats, "instance_cache.shards.count", instance_cache_shards_stats.shards_count);
+  add_histogram_stat_long(stats, "instance_cache.shards.contended", instance_cache_shards_stats.contended_shards);
+  add_histogram_stat_long(stats, "instance_cache.shards.lock_contentions.total", instance_cache_shards_stats.total_lock_contentions);
+  add_histogram_stat_long(stats, "instance_cache.shards.lock_contentions.max", instance_cache_shards_stats.max_shard_lock_contentions);
+  add_histogram_stat_long(stats, "instance_cache.shards.lock_acquisitions", instance_cache_shards_stats.total_lock_acquisitions);
+  add_histogram_stat_long(stats, "instance_cache.shards.lock_wait_time_us", instance_cache_shards_stats.total_lock_wait_time_ns / 1000);
+
+  write_confdata_stats_to(stats, server_stats.worker_stats.confdata_cache_hits(), server_stats.worker_stats.confdata_cache_misses());
   server_stats.worker_stats.recalc_master_percentiles();
   server_stats.worker_stats.to_stats(stats);
+  WorkerMetrics::get().write_latency_stats_to(stats, my_now);
+  WorkerMetrics::get().write_warmup_stats_to(stats);
+  add_gauge_stat_long(stats, "warmup.sample_requests", HttpWarmup::get().requests_count());
 
   static QPSCalculator qps_calculator{FULL_STATS_PERIOD * 2};
   qps_calculator.update(my_now, server_stats.worker_stats);
@@ -1739,6 +2040,8 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, STATS_TAG_KPHP_SERVER) {
   add_histogram_stat_long(stats, "memory.vms_max", max_vms * 1024);
   add_histogram_stat_long(stats, "memory.rss_max", max_rss * 1024);
   add_histogram_stat_long(stats, "memory.shared_max", max_shared * 1024);
+  add_histogram_stat_long(stats, "memory.hugetlb_total", server_stats.mem_info.hugetlb * 1024);
+  add_histogram_stat_long(stats, "memory.anon_huge_pages_total", server_stats.mem_info.anon_huge * 1024);
 }
 
 int php_master_http_execute(struct connection *c, int op) {
@@ -1772,6 +2075,22 @@ int php_master_http_execute(struct connection *c, int op) {
     return 0;
   }
 
+  const char *metrics_query = "/metrics";
+  if (D->uri_size == strlen(metrics_query) && strncmp(ReqHdr + D->uri_offset, metrics_query, static_cast<size_t>(D->uri_size)) == 0) {
+    std::string metrics = WorkerMetrics::get().to_prometheus();
+    write_basic_http_header(c, 200, 0, static_cast<int>(metrics.length()), nullptr, "text/plain; version=0.0.4; charset=utf-8");
+    write_out(&c->Out, metrics.c_str(), static_cast<int>(metrics.length()));
+    return 0;
+  }
+
+  const char *profile_query = "/profile";
+  if (D->uri_size == strlen(profile_query) && strncmp(ReqHdr + D->uri_offset, profile_query, static_cast<size_t>(D->uri_size)) == 0) {
+    std::string stacks = SamplingProfiler::get().to_collapsed_stacks();
+    write_basic_http_header(c, 200, 0, static_cast<int>(stacks.length()), nullptr, "text/plain; charset=UTF-8");
+    write_out(&c->Out, stacks.c_str(), static_cast<int>(stacks.length()));
+    return 0;
+  }
+
   D->query_flags |= QF_ERROR;
   return -404;
 }
@@ -1802,6 +2121,16 @@ void run_master_off_in_graceful_restart() {
     changed = 1;
   }
 
+  if (other->valid_flag && other->ask_instance_cache_generation > me->generation && me->sent_instance_cache_generation == 0) {
+    vkprintf(1, "send instance cache fd\n");
+    if (send_fd_via_socket(instance_cache_get_handover_fd(), INSTANCE_CACHE_FD_TAG)) {
+      // the workers of this master keep using the cache, but the new master maintains it from now on
+      instance_cache_hand_over();
+    }
+    me->sent_instance_cache_generation = static_cast<int>(generation);
+    changed = 1;
+  }
+
   if (other->to_kill_generation > me->generation) {
     // old master kills as many workers as new master told
     to_kill = other->to_kill;
@@ -1814,6 +2143,31 @@ void run_master_off_in_graceful_restart() {
   }
 }
 
+// the instance cache is asked after the http fd, so the answers don't mix up
+static void run_master_on_ask_instance_cache() {
+  if (!other->valid_flag || !other->own_instance_cache_handover) {
+    need_instance_cache = false;
+    return;
+  }
+  if (me->ask_instance_cache_generation != 0 && other->sent_instance_cache_generation > me->generation) {
+    vkprintf(1, "read instance cache fd\n");
+    const int instance_cache_fd = receive_fd(socket_fd, INSTANCE_CACHE_FD_TAG);
+    instance_cache_attached = instance_cache_fd != -1 && instance_cache_attach_handed_over(instance_cache_fd);
+    vkprintf(0, "%s\n", instance_cache_attached ? "instance cache is attached" : "instance cache can't be attached, start with the empty one");
+    need_instance_cache = false;
+  } else if (receive_instance_cache_attempts_cnt++ < 5) {
+    vkprintf(1, "ask for instance cache fd\n");
+    if (socket_fd == -1) {
+      socket_fd = sock_dgram(socket_name.c_str());
+    }
+    me->ask_instance_cache_generation = static_cast<int>(generation);
+    changed = 1;
+  } else {
+    vkprintf(0, "the previous master doesn't hand the instance cache over, start with the empty one\n");
+    need_instance_cache = false;
+  }
+}
+
 void run_master_on() {
   vkprintf(2, "state: master_state::on\n");
 
@@ -1885,14 +2239,24 @@ void run_master_on() {
     }
   }
 
-  if (!need_http_fd) {
+  if (!need_http_fd && need_instance_cache) {
+    run_master_on_ask_instance_cache();
+  }
+
+  if (!need_http_fd && !need_instance_cache) {
     int total_workers = me_running_workers_n + me_dying_workers_n + (other->valid_flag ? other->running_workers_n + other->dying_workers_n : 0);
-    to_run = std::max(0, workers_n - total_workers);
+    const int target_workers_n = WorkersAutoscaler::get().target_workers_n();
+    to_run = std::max(0, target_workers_n - total_workers);
+    if (!other->valid_flag && me_dying_workers_n == 0 && me_running_workers_n > target_workers_n) {
+      // the autoscaler has lowered the target, retire the extra workers one at a time
+      to_kill = 1;
+    }
 
     if (other->valid_flag) {
       int set_to_kill = std::max(std::min(MAX_KILL - other->dying_workers_n, other->running_workers_n), 0);
 
-      if (set_to_kill > 0) {
+      // the old workers serve the requests until the new ones are warmed up
+      if (set_to_kill > 0 && count_warming_up_workers() == 0) {
         // new master tells to old master how many workers it must kill
         vkprintf(1, "[set_to_kill = %d]\n", set_to_kill);
         me->to_kill = set_to_kill;
@@ -1987,6 +2351,8 @@ static void cron() {
   MiscStatTimestamp misc_timestamp{my_now, running_workers};
   server_stats.update(misc_timestamp);
 
+  WorkersAutoscaler::get().update(WorkerStats::collect(), other->valid_flag || state != master_state::on);
+
   utime += dead_utime;
   stime += dead_stime;
   CpuStatTimestamp cpu_timestamp{my_now, utime, stime, cpu_total};
@@ -1999,9 +2365,15 @@ static void cron() {
     create_stats_queries(nullptr, SPOLL_SEND_STATS | SPOLL_SEND_FULL_STATS, -1);
   }
 
+  if (instance_cache_attached && !other->valid_flag) {
+    // the workers of the previous master are gone, but they might have been killed with the cache buffers acquired
+    instance_cache_release_resources_of_previous_master();
+    instance_cache_attached = false;
+  }
   instance_cache_purge_expired_elements();
   check_and_instance_cache_try_swap_memory();
   confdata_binlog_update_cron();
+  kdb_resolver_cache_refresh();
 }
 
 auto get_steady_tp_ms_now() noexcept {
@@ -2042,6 +2414,8 @@ void run_master() {
   cpu_cnt = (int)sysconf(_SC_NPROCESSORS_ONLN);
   me->http_fd_port = http_fd_port;
   me->own_http_fd = http_fd != nullptr && *http_fd != -1;
+  me->own_instance_cache_handover = instance_cache_get_handover_fd() != -1;
+  need_instance_cache = me->own_instance_cache_handover;
 
   epoll_sethandler(signal_fd, 0, signal_epoll_handler, nullptr);
   const int err = epoll_insert(signal_fd, EVT_READ);
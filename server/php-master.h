@@ -7,3 +7,12 @@
 #include "net/net-connections.h"
 
 void start_master(int *http_fd, int (*try_get_http_fd)(), int http_fd_port);
+
+enum class workers_cpu_affinity_policy {
+  none,
+  core,   // worker i is pinned to the i-th allowed cpu
+  spread, // workers are pinned to single cpus with going round the numa nodes
+  numa,   // worker i may run on any cpu of the numa node i % nodes_count
+};
+
+bool set_workers_cpu_affinity_policy(const char *policy);
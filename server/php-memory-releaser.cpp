@@ -0,0 +1,43 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-memory-releaser.h"
+
+#include <algorithm>
+
+bool MemoryReleaser::set_requests_window(size_t requests) noexcept {
+  if (requests > MAX_REQUESTS_WINDOW) {
+    return false;
+  }
+  script_high_waters_.assign(requests, 0);
+  heap_high_waters_.assign(requests, 0);
+  next_request_ = 0;
+  script_window_max_ = heap_window_max_ = 0;
+  script_dirty_ = heap_dirty_ = 0;
+  return true;
+}
+
+void MemoryReleaser::on_request_finish(size_t script_memory_high_water, size_t heap_memory_high_water) noexcept {
+  if (!enabled()) {
+    return;
+  }
+  script_high_waters_[next_request_] = script_memory_high_water;
+  heap_high_waters_[next_request_] = heap_memory_high_water;
+  next_request_ = (next_request_ + 1) % script_high_waters_.size();
+
+  script_window_max_ = *std::max_element(script_high_waters_.begin(), script_high_waters_.end());
+  heap_window_max_ = *std::max_element(heap_high_waters_.begin(), heap_high_waters_.end());
+  script_dirty_ = std::max(script_dirty_, script_memory_high_water);
+  heap_dirty_ = std::max(heap_dirty_, heap_memory_high_water);
+}
+
+void MemoryReleaser::on_script_memory_released() noexcept {
+  script_dirty_ = script_window_max_;
+  ++script_memory_releases_;
+}
+
+void MemoryReleaser::on_heap_trimmed() noexcept {
+  heap_dirty_ = heap_window_max_;
+  ++heap_trims_;
+}
@@ -0,0 +1,57 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+
+// Gives the memory of a worker, which the last requests haven't needed, back to the system.
+// The high-water marks of the script memory and the heap are kept for a window of the last requests,
+// the memory dirtied above the highest of them is released while the worker is idle
+class MemoryReleaser : vk::not_copyable {
+public:
+  static MemoryReleaser &get() noexcept {
+    static MemoryReleaser memory_releaser;
+    return memory_releaser;
+  }
+
+  static constexpr size_t MAX_REQUESTS_WINDOW = 10000;
+  // the less is not worth a syscall
+  static constexpr size_t MIN_RELEASE_SIZE = 1024 * 1024;
+
+  bool set_requests_window(size_t requests) noexcept;
+  bool enabled() const noexcept { return !script_high_waters_.empty(); }
+
+  void on_request_finish(size_t script_memory_high_water, size_t heap_memory_high_water) noexcept;
+
+  // the script memory above that offset hasn't been used by the last requests
+  size_t script_memory_to_keep() const noexcept { return script_window_max_; }
+  bool should_release_script_memory() const noexcept { return script_dirty_ >= script_window_max_ + MIN_RELEASE_SIZE; }
+  void on_script_memory_released() noexcept;
+
+  bool should_trim_heap() const noexcept { return heap_dirty_ >= heap_window_max_ + MIN_RELEASE_SIZE; }
+  void on_heap_trimmed() noexcept;
+
+  size_t script_memory_releases() const noexcept { return script_memory_releases_; }
+  size_t heap_trims() const noexcept { return heap_trims_; }
+
+private:
+  MemoryReleaser() = default;
+
+  std::vector<size_t> script_high_waters_;
+  std::vector<size_t> heap_high_waters_;
+  size_t next_request_{0};
+
+  size_t script_window_max_{0};
+  size_t heap_window_max_{0};
+  // the high-water marks since the last release
+  size_t script_dirty_{0};
+  size_t heap_dirty_{0};
+
+  size_t script_memory_releases_{0};
+  size_t heap_trims_{0};
+};
@@ -0,0 +1,41 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-pgo-profile.h"
+
+#include "common/kprintf.h"
+
+extern "C" {
+// libgcov
+void __gcov_reset() __attribute__((weak));
+void __gcov_dump() __attribute__((weak));
+// compiler-rt profile
+void __llvm_profile_reset_counters() __attribute__((weak));
+int __llvm_profile_write_file() __attribute__((weak));
+void __llvm_profile_set_dumped() __attribute__((weak));
+}
+
+void pgo_profile_on_worker_start() noexcept {
+  if (__gcov_reset) {
+    __gcov_reset();
+  }
+  if (__llvm_profile_reset_counters) {
+    __llvm_profile_reset_counters();
+  }
+}
+
+void pgo_profile_dump() noexcept {
+  // both runtimes don't dump the profile once more at exit after that
+  if (__gcov_dump) {
+    vkprintf(1, "dump the pgo profile\n");
+    __gcov_dump();
+  }
+  if (__llvm_profile_write_file) {
+    vkprintf(1, "dump the pgo profile\n");
+    __llvm_profile_write_file();
+    if (__llvm_profile_set_dumped) {
+      __llvm_profile_set_dumped();
+    }
+  }
+}
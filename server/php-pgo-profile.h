@@ -0,0 +1,13 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+// The binaries built with kphp2cpp --pgo-instrument carry the gcc or clang profile runtime,
+// otherwise these calls do nothing: its symbols are weak and resolve to nullptr
+
+// called from the worker just after the fork: the counters inherited from the master don't belong to the worker
+void pgo_profile_on_worker_start() noexcept;
+// called on the graceful shutdown of the worker, the profile runtime merges the counters of all the workers into the files
+void pgo_profile_dump() noexcept;
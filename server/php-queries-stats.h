@@ -18,10 +18,20 @@ struct QueriesStat {
     incoming_bytes_ += std::max(0, size);
   }
 
+  void register_hedged_query() noexcept {
+    ++hedged_queries_count_;
+  }
+
+  void register_hedge_win() noexcept {
+    ++hedge_wins_count_;
+  }
+
   QueriesStat &operator+=(const QueriesStat &other) noexcept {
     queries_count_ += other.queries_count_;
     incoming_bytes_ += other.incoming_bytes_;
     outgoing_bytes_ += other.outgoing_bytes_;
+    hedged_queries_count_ += other.hedged_queries_count_;
+    hedge_wins_count_ += other.hedge_wins_count_;
     return *this;
   }
 
@@ -29,6 +39,8 @@ struct QueriesStat {
     queries_count_ -= other.queries_count_;
     incoming_bytes_ -= other.incoming_bytes_;
     outgoing_bytes_ -= other.outgoing_bytes_;
+    hedged_queries_count_ -= other.hedged_queries_count_;
+    hedge_wins_count_ -= other.hedge_wins_count_;
     return *this;
   }
 
@@ -41,11 +53,15 @@ struct QueriesStat {
   uint64_t queries_count() const noexcept { return queries_count_; }
   uint64_t incoming_bytes() const noexcept { return incoming_bytes_; }
   uint64_t outgoing_bytes() const noexcept { return outgoing_bytes_; }
+  uint64_t hedged_queries_count() const noexcept { return hedged_queries_count_; }
+  uint64_t hedge_wins_count() const noexcept { return hedge_wins_count_; }
 
 private:
   uint64_t queries_count_{0};
   uint64_t incoming_bytes_{0};
   uint64_t outgoing_bytes_{0};
+  uint64_t hedged_queries_count_{0};
+  uint64_t hedge_wins_count_{0};
 };
 
 class PhpQueriesStats : vk::not_copyable {
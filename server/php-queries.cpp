@@ -8,6 +8,8 @@
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <unordered_set>
+#include <vector>
 
 #include "common/precise-time.h"
 
@@ -16,6 +18,8 @@
 #include "server/php-queries-stats.h"
 #include "server/php-runner.h"
 #include "server/php-script.h"
+#include "server/php-tracing.h"
+#include "server/php-worker-metrics.h"
 
 #define MAX_NET_ERROR_LEN 128
 
@@ -59,6 +63,22 @@ int http_load_long_query(char *buf, int min_len, int max_len) {
   return ans->loaded_bytes;
 }
 
+bool http_send_chunk(const char *headers, int headers_len, const char *data, int data_len) {
+  assert (PHPScriptBase::is_running);
+
+  //DO NOT use query after script is terminated!!!
+  php_query_http_send_chunk_t q;
+  q.base.type = PHPQ_HTTP_SEND_CHUNK;
+  q.headers = headers;
+  q.headers_len = headers_len;
+  q.data = data;
+  q.data_len = data_len;
+
+  PHPScriptBase::current_script->ask_query((void *)&q);
+
+  return ((php_query_http_send_chunk_answer_t *)q.base.ans)->is_sent;
+}
+
 
 /***
  QUERY MEMORY ALLOCATOR
@@ -66,6 +86,7 @@ int http_load_long_query(char *buf, int min_len, int max_len) {
 
 #include <map>
 
+#include <algorithm>
 #include <cassert>
 
 long long qmem_generation = 0;
@@ -693,6 +714,15 @@ sql_ansgen_t *sql_ansgen_packet_create() {
 /** new rpc interface **/
 static slot_id_t end_slot_id, begin_slot_id;
 static const slot_id_t max_slot_id = 1000000000;
+// slots whose answers must be dropped on arrival without copying them to the script
+static std::unordered_set<slot_id_t> cancelled_slots;
+// the host of every rpc query of the current script by slot_id - begin_slot_id, -1 if it is not in flight
+static std::vector<int> in_flight_slot_hosts;
+// the send time of every rpc query in flight, by the same index
+static std::vector<double> in_flight_slot_send_times;
+static std::vector<int> in_flight_per_host;
+static int in_flight_per_host_peak;
+static uint64_t balanced_rpc_queries;
 
 void init_slots() {
   end_slot_id = begin_slot_id = static_cast<slot_id_t>(lrand48() % (max_slot_id / 4) + 1);
@@ -709,7 +739,57 @@ bool is_valid_slot(slot_id_t slot_id) {
   return begin_slot_id <= slot_id && slot_id < end_slot_id;
 }
 
+static void register_in_flight_query(slot_id_t slot_id, int host_num) {
+  if (host_num < 0) {
+    return;
+  }
+  const auto index = static_cast<size_t>(slot_id - begin_slot_id);
+  if (in_flight_slot_hosts.size() <= index) {
+    in_flight_slot_hosts.resize(index + 1, -1);
+  }
+  if (in_flight_slot_send_times.size() <= index) {
+    in_flight_slot_send_times.resize(index + 1, 0);
+  }
+  in_flight_slot_hosts[index] = host_num;
+  in_flight_slot_send_times[index] = get_utime_monotonic();
+  if (in_flight_per_host.size() <= static_cast<size_t>(host_num)) {
+    in_flight_per_host.resize(host_num + 1, 0);
+  }
+  in_flight_per_host_peak = std::max(in_flight_per_host_peak, ++in_flight_per_host[host_num]);
+}
+
+// returns the send time of the query, or 0 if it was not in flight
+static double finish_in_flight_query(slot_id_t slot_id) {
+  const auto index = static_cast<size_t>(slot_id - begin_slot_id);
+  if (index < in_flight_slot_hosts.size() && in_flight_slot_hosts[index] >= 0) {
+    --in_flight_per_host[in_flight_slot_hosts[index]];
+    in_flight_slot_hosts[index] = -1;
+    return in_flight_slot_send_times[index];
+  }
+  return 0;
+}
+
+int get_rpc_in_flight_queries(int host_num) {
+  return 0 <= host_num && static_cast<size_t>(host_num) < in_flight_per_host.size() ? in_flight_per_host[host_num] : 0;
+}
+
+void register_balanced_rpc_query() {
+  ++balanced_rpc_queries;
+}
+
+rpc_in_flight_stats_t get_rpc_in_flight_stats() {
+  return rpc_in_flight_stats_t{static_cast<uint64_t>(in_flight_per_host_peak), balanced_rpc_queries};
+}
+
+bool is_cancelled_slot(slot_id_t slot_id) {
+  return !cancelled_slots.empty() && cancelled_slots.count(slot_id);
+}
+
 void clear_slots() {
+  cancelled_slots.clear();
+  in_flight_slot_hosts.clear();
+  in_flight_slot_send_times.clear();
+  std::fill(in_flight_per_host.begin(), in_flight_per_host.end(), 0);
   begin_slot_id = end_slot_id;
   if (begin_slot_id > max_slot_id / 2) {
     init_slots();
@@ -806,6 +886,13 @@ int alloc_net_event(slot_id_t slot_id, net_event_type_t type, net_event_t **res)
   if (!is_valid_slot(slot_id)) {
     return 0;
   }
+  const double send_time = finish_in_flight_query(slot_id);
+  if (send_time > 0) {
+    WorkerMetrics::get().add_latency(WorkerMetrics::Latency::rpc_query, get_utime_monotonic() - send_time);
+  }
+  if (!cancelled_slots.empty() && cancelled_slots.erase(slot_id)) {
+    return 0;
+  }
 
   net_event_t *event = net_events.create();
   if (event == nullptr) {
@@ -822,6 +909,7 @@ void unalloc_net_event(net_event_t *event) {
 }
 
 int create_rpc_error_event(slot_id_t slot_id, int error_code, const char *error_message, net_event_t **res) {
+  Tracing::get().finish_span(Tracing::SpanKind::rpc, slot_id, error_code, 0, get_utime_monotonic());
   net_event_t *event;
   int status = alloc_net_event(slot_id, ne_rpc_error, &event);
   if (status <= 0) {
@@ -837,6 +925,7 @@ int create_rpc_error_event(slot_id_t slot_id, int error_code, const char *error_
 
 int create_rpc_answer_event(slot_id_t slot_id, int len, net_event_t **res) {
   PhpQueriesStats::get_rpc_queries_stat().register_answer(len);
+  Tracing::get().finish_span(Tracing::SpanKind::rpc, slot_id, 0, len, get_utime_monotonic());
   net_event_t *event;
   int status = alloc_net_event(slot_id, ne_rpc_answer, &event);
   if (status <= 0) {
@@ -858,6 +947,18 @@ int create_rpc_answer_event(slot_id_t slot_id, int len, net_event_t **res) {
   return 1;
 }
 
+int create_curl_socket_event(int fd, int events) {
+  net_event_t *event = net_events.create();
+  if (event == nullptr) {
+    return -2;
+  }
+  event->type = ne_curl_socket;
+  event->slot_id = -1;
+  event->curl_fd = fd;
+  event->curl_events = events;
+  return 1;
+}
+
 int net_events_empty() {
   return net_events.empty();
 }
@@ -886,7 +987,14 @@ void free_net_query(net_query_t *query) {
 /*** main functions ***/
 void mc_run_query(int host_num, const char *request, int request_len, int timeout_ms, int query_type, void (*callback)(const char *result, int result_len)) {
   PhpQueriesStats::get_mc_queries_stat().register_query(request_len);
+  const double start_time = get_utime_monotonic();
   php_net_query_packet_answer_t *res = php_net_query_packet(host_num, request, request_len, timeout_ms * 0.001, p_memcached, query_type | (PNETF_IMMEDIATE * (callback == nullptr)));
+  if (callback != nullptr) {
+    // immediate queries do not wait for the answer
+    WorkerMetrics::get().add_latency(WorkerMetrics::Latency::mc_query, get_utime_monotonic() - start_time);
+    Tracing::get().add_span(Tracing::SpanKind::memcache, host_num, request_len, res->state == nq_error ? 0 : res->res_len,
+                            res->state == nq_error ? -1 : 0, start_time, precise_now);
+  }
   if (res->state == nq_error) {
     if (callback != nullptr) {
       fprintf(stderr, "mc_run_query error: %s [%s]\n", res->desc ? res->desc : "", res->res);
@@ -903,7 +1011,18 @@ void mc_run_query(int host_num, const char *request, int request_len, int timeou
 
 void db_run_query(int host_num, const char *request, int request_len, int timeout_ms, void (*callback)(const char *result, int result_len)) {
   PhpQueriesStats::get_sql_queries_stat().register_query(request_len);
+  const double start_time = get_utime_monotonic();
   php_net_query_packet_answer_t *res = php_net_query_packet(host_num, request, request_len, timeout_ms * 0.001, p_sql, 0);
+  WorkerMetrics::get().add_latency(WorkerMetrics::Latency::sql_query, get_utime_monotonic() - start_time);
+  if (unlikely(Tracing::get().sampled())) {
+    uint32_t answer_len = 0;
+    if (res->state != nq_error) {
+      for (chain_t *cur = res->chain->next; cur != res->chain; cur = cur->next) {
+        answer_len += cur->len;
+      }
+    }
+    Tracing::get().add_span(Tracing::SpanKind::mysql, host_num, request_len, answer_len, res->state == nq_error ? -1 : 0, start_time, precise_now);
+  }
   if (res->state == nq_error) {
     fprintf(stderr, "db_run_query error: %s [%s]\n", res->desc ? res->desc : "", res->res);
     save_last_net_error(res->res);
@@ -935,9 +1054,19 @@ slot_id_t rpc_send_query(int host_num, char *request, int request_size, int time
   query->request = request;
   query->request_size = request_size;
   query->timeout_ms = timeout_ms;
+  register_in_flight_query(query->slot_id, host_num);
   return query->slot_id;
 }
 
+void rpc_cancel_query(slot_id_t slot_id) {
+  if (is_valid_slot(slot_id)) {
+    finish_in_flight_query(slot_id);
+    // -1 is the status of the cancelled queries
+    Tracing::get().finish_span(Tracing::SpanKind::rpc, slot_id, -1, 0, get_utime_monotonic());
+    cancelled_slots.insert(slot_id);
+  }
+}
+
 void wait_net_events(int timeout_ms) {
   assert (PHPScriptBase::is_running);
   php_query_wait_t q;
@@ -5,12 +5,14 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 using slot_id_t = int;
 
 enum net_event_type_t {
   ne_rpc_answer,
-  ne_rpc_error
+  ne_rpc_error,
+  ne_curl_socket
 };
 
 struct net_event_t {
@@ -29,6 +31,11 @@ struct net_event_t {
       int error_code;
       const char *error_message;
     };
+    struct { //ne_curl_socket
+      int curl_fd;
+      // CURL_CSELECT_* bits of the socket readiness
+      int curl_events;
+    };
   };
 };
 
@@ -85,6 +92,7 @@ struct chain_t {
 #define PHPQ_NETQ 0x3d780000
 #define PHPQ_WAIT 0x728a0000
 #define PHPQ_HTTP_LOAD_POST 0x5ac20000
+#define PHPQ_HTTP_SEND_CHUNK 0x6e1a0000
 #define NETQ_PACKET 1234
 
 #define PNETF_IMMEDIATE 16
@@ -150,6 +158,20 @@ struct php_query_http_load_post_t {
   int max_len;
 };
 
+/** http send chunk query **/
+struct php_query_http_send_chunk_answer_t {
+  bool is_sent;
+};
+
+struct php_query_http_send_chunk_t {
+  php_query_base_t base;
+
+  const char *headers;
+  int headers_len;
+  const char *data;
+  int data_len;
+};
+
 
 /** net query **/
 struct data_reader_t {
@@ -331,6 +353,7 @@ void free_net_query(net_query_t *query);
 
 int create_rpc_error_event(slot_id_t slot_id, int error_code, const char *error_message, net_event_t **res);
 int create_rpc_answer_event(slot_id_t slot_id, int len, net_event_t **res);
+int create_curl_socket_event(int fd, int events);
 int net_events_empty();
 
 void php_queries_start();
@@ -350,6 +373,9 @@ int get_net_queries_count();
 int get_engine_uptime();
 const char *get_engine_version();
 int http_load_long_query(char *buf, int min_len, int max_len);
+// sends a part of the response with the chunked transfer encoding, the headers are passed with the first part only;
+// returns false if the response can't be streamed, then nothing is sent
+bool http_send_chunk(const char *headers, int headers_len, const char *data, int data_len);
 void http_set_result(const char *headers, int headers_len, const char *body, int body_len, int exit_code);
 void rpc_answer(const char *res, int res_len);
 void rpc_set_result(const char *body, int body_len, int exit_code);
@@ -357,7 +383,24 @@ void script_error();
 void finish_script(int exit_code);
 int rpc_connect_to(const char *host_name, int port);
 slot_id_t rpc_send_query(int host_num, char *request, int request_len, int timeout_ms);
+// the query is not sent if it is still queued, and its answer is dropped by the engine on arrival
+void rpc_cancel_query(slot_id_t slot_id);
+bool is_cancelled_slot(slot_id_t slot_id);
+// the number of not yet answered rpc queries of the current script to the host
+int get_rpc_in_flight_queries(int host_num);
+void register_balanced_rpc_query();
+// whether all the ready connections to the host are over the rpc queue limits
+bool is_rpc_target_busy(int host_num);
+
+struct rpc_in_flight_stats_t {
+  uint64_t max_per_host;
+  uint64_t balanced_queries;
+};
+rpc_in_flight_stats_t get_rpc_in_flight_stats();
 void wait_net_events(int timeout_ms);
+// watches the socket of a curl transfer in the engine reactor for CURL_POLL_* events, 0 stops watching;
+// a watch fires once with the ne_curl_socket event and has to be renewed by the script
+void curl_watch_socket(int fd, int curl_poll_events);
 net_event_t *pop_net_event();
 int query_x2(int x);
 
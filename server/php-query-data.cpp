@@ -23,7 +23,7 @@ http_query_data *http_query_data_create(
             const char *qUri, int qUriLen,
             const char *qGet, int qGetLen,
             const char *qHeaders, int qHeadersLen,
-            const char *qPost, int qPostLen,
+            char *qPost, int qPostLen,
             const char *request_method, int keep_alive, unsigned int ip, unsigned int port) {
   http_query_data *d = (http_query_data *)malloc(sizeof(http_query_data));
 
@@ -31,11 +31,7 @@ http_query_data *http_query_data_create(
   d->uri = (char *)memdup(qUri, qUriLen);
   d->get = (char *)memdup(qGet, qGetLen);
   d->headers = (char *)memdup(qHeaders, qHeadersLen);
-  if (qPost != nullptr) {
-    d->post = (char *)memdup(qPost, qPostLen);
-  } else {
-    d->post = nullptr;
-  }
+  d->post = qPost;
 
   d->uri_len = qUriLen;
   d->get_len = qGetLen;
@@ -71,7 +67,7 @@ void http_query_data_free(http_query_data *d) {
 rpc_query_data *rpc_query_data_create(int *data, int len, long long req_id, unsigned int ip, short port, short pid, int utime) {
   rpc_query_data *d = (rpc_query_data *)malloc(sizeof(rpc_query_data));
 
-  d->data = (int *)memdup(data, sizeof(int) * len);
+  d->data = data;
   d->len = len;
 
   d->req_id = req_id;
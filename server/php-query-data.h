@@ -13,8 +13,9 @@ struct http_query_data {
   unsigned int port;
 };
 
+// takes the ownership of qPost, which is allocated by malloc or is nullptr for a body left in the connection
 http_query_data *http_query_data_create(const char *qUri, int qUriLen, const char *qGet, int qGetLen, const char *qHeaders,
-                                        int qHeadersLen, const char *qPost, int qPostLen, const char *request_method, int keep_alive, unsigned int ip, unsigned int port);
+                                        int qHeadersLen, char *qPost, int qPostLen, const char *request_method, int keep_alive, unsigned int ip, unsigned int port);
 void http_query_data_free(http_query_data *d);
 
 /** rpc_query_data **/
@@ -30,6 +31,7 @@ struct rpc_query_data {
   int utime;
 };
 
+// takes the ownership of data, which is allocated by malloc
 rpc_query_data *rpc_query_data_create(int *data, int len, long long req_id, unsigned int ip, short port, short pid, int utime);
 void rpc_query_data_free(rpc_query_data *d);
 
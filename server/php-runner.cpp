@@ -4,6 +4,7 @@
 
 #include "server/php-runner.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdlib>
@@ -15,19 +16,24 @@
 #include <unistd.h>
 
 #include "common/fast-backtrace.h"
+#include "common/huge-pages.h"
 #include "common/kernel-version.h"
 #include "common/kprintf.h"
 #include "common/server/crash-dump.h"
 #include "common/server/signals.h"
 #include "common/wrappers/madvise.h"
 #include "net/net-connections.h"
+#include "net/net-io-thread.h"
 
+#include "runtime/allocations_sampler.h"
 #include "runtime/allocator.h"
 #include "runtime/critical_section.h"
 #include "runtime/exception.h"
 #include "runtime/interface.h"
 #include "runtime/profiler.h"
 #include "server/php-engine-vars.h"
+#include "server/php-tracing.h"
+#include "server/php-worker-metrics.h"
 #include "server/php-worker-stats.h"
 
 query_stats_t query_stats;
@@ -45,12 +51,15 @@ void PHPScriptBase::error(const char *error_message, script_error_t error_type)
   current_script->state = run_state_t::error;
   current_script->error_message = error_message;
   current_script->error_type = error_type;
-  stack_end = reinterpret_cast<char *>(exit_context.uc_stack.ss_sp) + exit_context.uc_stack.ss_size;
+  // the net loop runs on the main stack, fast-backtrace bounds it by __libc_stack_end
+  stack_end = nullptr;
 #if ASAN7_ENABLED
   __sanitizer_finish_switch_fiber(nullptr, nullptr, nullptr);
-  __sanitizer_start_switch_fiber(nullptr, exit_context.uc_stack.ss_sp, exit_context.uc_stack.ss_size);
+  __sanitizer_start_switch_fiber(nullptr, nullptr, 0);
 #endif
-  setcontext(&exit_context);
+  // the error may come from a signal handler, setcontext used to restore the mask of the net loop for us
+  sigprocmask(SIG_SETMASK, &exit_sigmask, nullptr);
+  fiber_context_jump(&exit_context);
 }
 
 void PHPScriptBase::check_tl() {
@@ -88,6 +97,8 @@ PHPScriptBase::PHPScriptBase(size_t mem_size, size_t stack_size) :
   run_mem(nullptr),
   mem_size(mem_size),
   stack_size(stack_size),
+  run_mem_is_hugetlb(false),
+  run_mem_dirty_end(0),
   run_context(),
   run_main(nullptr),
   data(nullptr),
@@ -99,7 +110,8 @@ PHPScriptBase::PHPScriptBase(size_t mem_size, size_t stack_size) :
   protected_end = run_stack + getpagesize();
   run_stack_end = run_stack + stack_size;
 
-  run_mem = static_cast<char *>(mmap(nullptr, mem_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+  run_mem = static_cast<char *>(mmap_anonymous_memory(&this->mem_size, MAP_PRIVATE, script_memory_huge_pages, &run_mem_is_hugetlb));
+  assert (run_mem != MAP_FAILED);
   //fprintf (stderr, "[%p -> %p] [%p -> %p]\n", run_stack, run_stack_end, run_mem, run_mem + mem_size);
 }
 
@@ -114,6 +126,31 @@ PHPScriptBase::~PHPScriptBase() {
   munmap(run_mem, mem_size);
 }
 
+// touches the stack and the beginning of the script memory, so the next request doesn't page fault on them
+void PHPScriptBase::prefault(size_t memory_size) {
+  const auto page_size = static_cast<size_t>(getpagesize());
+  for (char *page = protected_end; page < run_stack_end; page += page_size) {
+    *reinterpret_cast<volatile char *>(page) = 0;
+  }
+  memory_size = std::min(memory_size, mem_size);
+  for (size_t offset = 0; offset < memory_size; offset += page_size) {
+    *reinterpret_cast<volatile char *>(run_mem + offset) = 0;
+  }
+  run_mem_dirty_end = std::max(run_mem_dirty_end, memory_size);
+}
+
+// gives the script memory above memory_size, dirtied by the previous requests, back to the system
+void PHPScriptBase::release_memory_above(size_t memory_size) {
+  const auto page_size = static_cast<size_t>(getpagesize());
+  memory_size = (memory_size + page_size - 1) / page_size * page_size;
+  if (run_mem_is_hugetlb || memory_size >= run_mem_dirty_end) {
+    return;
+  }
+  const int advice = madvise_madv_free_supported() ? MADV_FREE : MADV_DONTNEED;
+  our_madvise(&run_mem[memory_size], run_mem_dirty_end - memory_size, advice);
+  run_mem_dirty_end = memory_size;
+}
+
 void PHPScriptBase::init(script_t *script, php_query_data *data_to_set) {
   assert (script != nullptr);
   assert (state == run_state_t::empty);
@@ -123,11 +160,8 @@ void PHPScriptBase::init(script_t *script, php_query_data *data_to_set) {
 
   assert (state == run_state_t::before_init);
 
-  getcontext(&run_context);
-  run_context.uc_stack.ss_sp = run_stack;
-  run_context.uc_stack.ss_size = stack_size;
-  run_context.uc_link = nullptr;
-  makecontext(&run_context, &cur_run, 0);
+  fiber_context_make(&run_context, run_stack, stack_size, &cur_run);
+  sigprocmask(SIG_BLOCK, nullptr, &exit_sigmask);
 
   run_main = script;
   data = data_to_set;
@@ -147,29 +181,29 @@ void PHPScriptBase::init(script_t *script, php_query_data *data_to_set) {
   PHPScriptBase::ml_flag = false;
 }
 
-int PHPScriptBase::swapcontext_helper(ucontext_t *oucp, const ucontext_t *ucp) {
-  stack_end = reinterpret_cast<char *>(ucp->uc_stack.ss_sp) + ucp->uc_stack.ss_size;
+void PHPScriptBase::switch_context_helper(fiber_context *from, const fiber_context *to, void *to_stack, size_t to_stack_size) {
+  stack_end = static_cast<char *>(to_stack) + to_stack_size;
 #if ASAN7_ENABLED
   if (fiber_is_started) {
     __sanitizer_finish_switch_fiber(nullptr, nullptr, nullptr);
   }
   fiber_is_started = true;
-  __sanitizer_start_switch_fiber(nullptr, ucp->uc_stack.ss_sp, ucp->uc_stack.ss_size);
+  __sanitizer_start_switch_fiber(nullptr, to_stack, to_stack_size);
 #endif
 
-  return swapcontext(oucp, ucp);
+  fiber_context_switch(from, to);
 }
 void PHPScriptBase::pause() {
   //fprintf (stderr, "pause: \n");
   is_running = false;
-  assert (swapcontext_helper(&run_context, &exit_context) == 0);
+  switch_context_helper(&run_context, &exit_context, nullptr, 0);
   is_running = true;
   check_tl();
   //fprintf (stderr, "pause: ended\n");
 }
 
 void PHPScriptBase::resume() {
-  assert (swapcontext_helper(&exit_context, &run_context) == 0);
+  switch_context_helper(&exit_context, &run_context, run_stack, stack_size);
 }
 
 void dump_query_stats() {
@@ -231,7 +265,10 @@ run_state_t PHPScriptBase::iterate() {
   update_net_time();
   notify_profiler_stop_waiting();
 
+  // the connections aren't touched by the main thread till the script asks for the next query
+  net_io_thread_begin();
   resume();
+  net_io_thread_end();
 
   notify_profiler_start_waiting();
   update_script_time();
@@ -253,6 +290,8 @@ void PHPScriptBase::finish() {
   update_net_time();
   PhpWorkerStats::get_local().add_stats(script_time, net_time, queries_cnt,
                                         script_mem_stats.max_memory_used, script_mem_stats.max_real_memory_used, save_error_type);
+  WorkerMetrics::get().add_query(script_time, net_time, queries_cnt, script_mem_stats.max_memory_used, save_error_type);
+  Tracing::get().on_script_finish(script_time, net_time, save_error_type);
   if (save_state == run_state_t::error) {
     assert (error_message != nullptr);
     kprintf("Critical error during script execution: %s\n", error_message);
@@ -296,12 +335,23 @@ void PHPScriptBase::clear() {
   run_main->clear();
   free_runtime_environment();
   state = run_state_t::empty;
-  if (use_madvise_dontneed) {
+  run_mem_dirty_end = std::min(mem_size, std::max(run_mem_dirty_end, dl::get_script_memory_stats().max_real_memory_used));
+  // hugetlb pages can't be given back partially, they are reserved for the script anyway
+  if (use_madvise_dontneed && !run_mem_is_hugetlb) {
     if (dl::get_script_memory_stats().real_memory_used > memory_used_to_recreate_script) {
       const int advice = madvise_madv_free_supported() ? MADV_FREE : MADV_DONTNEED;
       our_madvise(&run_mem[memory_used_to_recreate_script], mem_size - memory_used_to_recreate_script, advice);
+      run_mem_dirty_end = std::min(run_mem_dirty_end, static_cast<size_t>(memory_used_to_recreate_script));
     }
   }
+  // the next request starts with the first growth step again, so the memory a heavy request has grown to is given back
+  const size_t growth_step = static_cast<size_t>(script_memory_growth_step);
+  const size_t arena_size = dl::get_script_memory_stats().memory_arena_size;
+  if (growth_step && !run_mem_is_hugetlb && arena_size > growth_step) {
+    const int advice = madvise_madv_free_supported() ? MADV_FREE : MADV_DONTNEED;
+    our_madvise(&run_mem[growth_step], arena_size - growth_step, advice);
+    run_mem_dirty_end = std::min(run_mem_dirty_end, growth_step);
+  }
 }
 
 void PHPScriptBase::ask_query(void *q) {
@@ -358,7 +408,7 @@ void PHPScriptBase::run() {
   }
   assert (run_main->run != nullptr);
 
-  init_runtime_environment(data, run_mem, mem_size);
+  init_runtime_environment(data, run_mem, mem_size, static_cast<size_t>(script_memory_growth_step));
   CurException = Optional<bool>{};
   run_main->run();
   if (CurException.is_null()) {
@@ -396,7 +446,8 @@ int PHPScriptBase::get_net_queries_count() const {
 
 
 PHPScriptBase *volatile PHPScriptBase::current_script;
-ucontext_t PHPScriptBase::exit_context;
+fiber_context PHPScriptBase::exit_context;
+sigset_t PHPScriptBase::exit_sigmask;
 volatile bool PHPScriptBase::is_running = false;
 volatile bool PHPScriptBase::tl_flag = false;
 volatile bool PHPScriptBase::ml_flag = false;
@@ -459,6 +510,7 @@ static void sigalrm_handler(int signum) {
 static void sigusr2_handler(int signum) {
   kwrite_str(2, "in sigusr2_handler\n");
   if (check_signal_critical_section(signum, "SIGUSR2")) {
+    dl::dump_allocations_samples();
     PHPScriptBase::ml_flag = true;
     perform_error_if_running("memory limit exit\n", script_error_t::memory_limit);
   }
@@ -616,6 +668,14 @@ void *php_script_create(size_t mem_size, size_t stack_size) {
   return (void *)(new PHPScriptBase(mem_size, stack_size));
 }
 
+void php_script_prefault(void *ptr, size_t memory_size) {
+  ((PHPScriptBase *)ptr)->prefault(memory_size);
+}
+
+void php_script_release_memory_above(void *ptr, size_t memory_size) {
+  ((PHPScriptBase *)ptr)->release_memory_above(memory_size);
+}
+
 void php_script_terminate(void *ptr, const char *error_message, script_error_t error_type) {
   ((PHPScriptBase *)ptr)->state = run_state_t::error;
   ((PHPScriptBase *)ptr)->error_type = error_type;
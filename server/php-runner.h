@@ -4,9 +4,10 @@
 
 #pragma once
 
-#include <ucontext.h>
+#include <csignal>
 
 #include "common/dl-utils-lite.h"
+#include "common/fiber-context.h"
 #include "common/sanitizer.h"
 
 #include "server/php-engine-vars.h"
@@ -86,6 +87,8 @@ void php_script_query_readed(void *ptr);
 void php_script_query_answered(void *ptr);
 run_state_t php_script_get_state(void *ptr);
 void *php_script_create(size_t mem_size, size_t stack_size);
+void php_script_prefault(void *ptr, size_t memory_size);
+void php_script_release_memory_above(void *ptr, size_t memory_size);
 void php_script_terminate(void *ptr, const char *error_message, script_error_t error_type);
 void php_script_set_timeout(double t);
 const char *php_script_get_error(void *ptr);
@@ -110,12 +113,14 @@ private:
 #if ASAN7_ENABLED
   bool fiber_is_started = false;
 #endif
-  int swapcontext_helper(ucontext_t *oucp, const ucontext_t *ucp);
+  void switch_context_helper(fiber_context *from, const fiber_context *to, void *to_stack, size_t to_stack_size);
 
 public:
 
   static PHPScriptBase *volatile current_script;
-  static ucontext_t exit_context;
+  static fiber_context exit_context;
+  // the signal mask of the net loop, the fiber switches don't save it
+  static sigset_t exit_sigmask;
   volatile static bool is_running;
   volatile static bool tl_flag;
   volatile static bool ml_flag;
@@ -126,7 +131,10 @@ public:
   void *query;
   char *run_stack, *protected_end, *run_stack_end, *run_mem;
   size_t mem_size, stack_size;
-  ucontext_t run_context;
+  bool run_mem_is_hugetlb;
+  // the script memory above it is untouched since the mmap or the last madvise
+  size_t run_mem_dirty_end;
+  fiber_context run_context;
 
   script_t *run_main;
   php_query_data *data;
@@ -144,6 +152,8 @@ public:
   virtual ~PHPScriptBase();
 
   void init(script_t *script, php_query_data *data_to_set);
+  void prefault(size_t memory_size);
+  void release_memory_above(size_t memory_size);
 
   //in php script
   void pause();
@@ -0,0 +1,218 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-sampling-profiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <new>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unordered_map>
+#include <vector>
+
+#include "common/dl-utils-lite.h"
+#include "common/fast-backtrace.h"
+#include "common/kprintf.h"
+
+#include "runtime/kphp-backtrace.h"
+#include "server/php-runner.h"
+
+namespace {
+void add_relaxed(std::atomic<uint64_t> &counter, uint64_t value) noexcept {
+  // a table is written by the signal handler of its worker only
+  counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+std::string make_frame_name(const char *symbol) {
+  if (symbol == nullptr || *symbol == '\0') {
+    return "??";
+  }
+  vk::string_view name{symbol, strlen(symbol)};
+  // the arguments of the demangled name may contain spaces, which are not allowed in the collapsed stacks
+  const size_t args_pos = name.find('(');
+  if (args_pos != vk::string_view::npos && args_pos > 0) {
+    name = name.substr(0, args_pos);
+  }
+  std::string res;
+  if (name.starts_with("f$")) {
+    name.remove_prefix(2);
+    append_php_function_name(name, [&res](const char *data, size_t len) { res.append(data, len); });
+  } else {
+    res.assign(name.data(), name.size());
+  }
+  for (char &c : res) {
+    if (c == ';' || c == ' ') {
+      c = '_';
+    }
+  }
+  return res;
+}
+} // namespace
+
+void SamplingProfiler::init(int slots_count) noexcept {
+  if (!enabled() || tables_ != nullptr) {
+    return;
+  }
+  const size_t size = sizeof(Table) * slots_count;
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    kprintf("Can't mmap %zu bytes for the sampling profiler: %m\n", size);
+    return;
+  }
+  // the anonymous memory is zeroed, all the stacks are empty
+  tables_ = new(memory) Table[slots_count];
+  tables_count_ = slots_count;
+}
+
+void SamplingProfiler::on_worker_start(int logname_id) noexcept {
+  if (tables_ == nullptr || logname_id < 0 || logname_id >= tables_count_) {
+    return;
+  }
+  own_table_ = &tables_[logname_id];
+  dl_sigaction(SIGPROF, nullptr, dl_get_empty_sigset(), SA_SIGINFO | SA_ONSTACK | SA_RESTART, sigprof_handler);
+
+  const long period_us = 1000000 / hz_;
+  itimerval timer{};
+  timer.it_interval.tv_sec = period_us / 1000000;
+  timer.it_interval.tv_usec = period_us % 1000000;
+  timer.it_value = timer.it_interval;
+  setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+void SamplingProfiler::sigprof_handler(int sig __attribute__((unused)), siginfo_t *info __attribute__((unused)), void *ucontext) noexcept {
+  SamplingProfiler &profiler = get();
+  if (profiler.own_table_ == nullptr) {
+    return;
+  }
+  if (!PHPScriptBase::is_running) {
+    add_relaxed(profiler.own_table_->samples_outside_script, 1);
+    return;
+  }
+
+  std::array<void *, MAX_DEPTH> pcs;
+  uint32_t depth = 0;
+  const auto *context = static_cast<const ucontext_t *>(ucontext);
+#if defined(__x86_64__)
+  pcs[depth++] = reinterpret_cast<void *>(context->uc_mcontext.gregs[REG_RIP]);
+  // the same walk as fast_backtrace, but from the frame of the interrupted function
+  const char *sp = reinterpret_cast<const char *>(context->uc_mcontext.gregs[REG_RSP]);
+  const char *end = stack_end ? stack_end : static_cast<const char *>(__libc_stack_end);
+  auto *const *bp = reinterpret_cast<void *const *>(context->uc_mcontext.gregs[REG_RBP]);
+  while (depth < MAX_DEPTH && reinterpret_cast<const char *>(bp) >= sp && reinterpret_cast<const char *>(bp + 2) <= end &&
+         !(reinterpret_cast<uintptr_t>(bp) & (sizeof(void *) - 1))) {
+    pcs[depth++] = bp[1];
+    auto *const *next = static_cast<void *const *>(bp[0]);
+    if (next <= bp) {
+      break;
+    }
+    bp = next;
+  }
+#elif defined(__aarch64__)
+  // backtrace() is not async signal safe, only the interrupted function is sampled
+  pcs[depth++] = reinterpret_cast<void *>(context->uc_mcontext.pc);
+#else
+#error "Unsupported arch"
+#endif
+  profiler.add_sample(pcs.data(), depth);
+}
+
+void SamplingProfiler::add_sample(void *const *pcs, uint32_t depth) noexcept {
+  uint64_t hash = 14695981039346656037ULL;
+  for (uint32_t i = 0; i < depth; ++i) {
+    hash = (hash ^ reinterpret_cast<uintptr_t>(pcs[i])) * 1099511628211ULL;
+  }
+  // 0 marks an empty stack
+  hash = hash ?: 1;
+
+  for (size_t probe = 0; probe < STACKS_PER_WORKER; ++probe) {
+    Stack &stack = own_table_->stacks[(hash + probe) % STACKS_PER_WORKER];
+    const uint64_t stack_hash = stack.hash.load(std::memory_order_relaxed);
+    if (stack_hash == 0) {
+      stack.depth = depth;
+      std::copy(pcs, pcs + depth, stack.pcs.begin());
+      // the master reads the stack only after it sees the hash
+      stack.hash.store(hash, std::memory_order_release);
+      add_relaxed(stack.samples, 1);
+      return;
+    }
+    if (stack_hash == hash && stack.depth == depth && std::equal(pcs, pcs + depth, stack.pcs.begin())) {
+      add_relaxed(stack.samples, 1);
+      return;
+    }
+  }
+  add_relaxed(own_table_->samples_dropped, 1);
+}
+
+std::string SamplingProfiler::to_collapsed_stacks() const noexcept {
+  std::string res;
+  if (tables_ == nullptr) {
+    return res;
+  }
+
+  std::map<std::vector<void *>, uint64_t> stacks;
+  uint64_t samples_outside_script = 0;
+  uint64_t samples_dropped = 0;
+  for (int i = 0; i < tables_count_; ++i) {
+    const Table &table = tables_[i];
+    samples_outside_script += table.samples_outside_script.load(std::memory_order_relaxed);
+    samples_dropped += table.samples_dropped.load(std::memory_order_relaxed);
+    for (const Stack &stack : table.stacks) {
+      if (stack.hash.load(std::memory_order_acquire) == 0) {
+        continue;
+      }
+      std::vector<void *> pcs{stack.pcs.begin(), stack.pcs.begin() + stack.depth};
+      // the outer frames hold the return addresses, which may belong to the next function
+      for (size_t frame = 1; frame < pcs.size(); ++frame) {
+        pcs[frame] = static_cast<char *>(pcs[frame]) - 1;
+      }
+      stacks[std::move(pcs)] += stack.samples.load(std::memory_order_relaxed);
+    }
+  }
+
+  std::unordered_map<void *, std::string> frame_names;
+  for (const auto &stack : stacks) {
+    for (void *pc : stack.first) {
+      frame_names.emplace(pc, std::string{});
+    }
+  }
+  std::vector<void *> unique_pcs;
+  unique_pcs.reserve(frame_names.size());
+  for (const auto &frame : frame_names) {
+    unique_pcs.push_back(frame.first);
+  }
+  {
+    KphpBacktrace symbols{unique_pcs.data(), static_cast<int32_t>(unique_pcs.size())};
+    size_t frame = 0;
+    for (const char *symbol : symbols.make_demangled_backtrace_range()) {
+      frame_names[unique_pcs[frame++]] = make_frame_name(symbol);
+    }
+  }
+
+  char buf[32];
+  for (const auto &stack : stacks) {
+    for (auto it = stack.first.rbegin(); it != stack.first.rend(); ++it) {
+      const std::string &name = frame_names[*it];
+      res += name.empty() ? "??" : name;
+      res += it + 1 != stack.first.rend() ? ";" : " ";
+    }
+    snprintf(buf, sizeof(buf), "%" PRIu64 "\n", stack.second);
+    res += buf;
+  }
+  if (samples_outside_script) {
+    snprintf(buf, sizeof(buf), "%" PRIu64 "\n", samples_outside_script);
+    res += "[outside_script] ";
+    res += buf;
+  }
+  if (samples_dropped) {
+    snprintf(buf, sizeof(buf), "%" PRIu64 "\n", samples_dropped);
+    res += "[dropped] ";
+    res += buf;
+  }
+  return res;
+}
@@ -0,0 +1,65 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <string>
+
+#include "common/mixin/not_copyable.h"
+
+// Signal based sampling profiler of the scripts: ITIMER_PROF sends SIGPROF to a worker every 1/hz of its cpu time,
+// the handler walks the frame pointers of the running script and counts the stack in the table of the worker.
+// The tables live in an anonymous shared memory segment mapped by the master before the workers are forked,
+// so the master symbolizes the stacks of all the workers into collapsed stacks (the flamegraph.pl input) on demand
+class SamplingProfiler : vk::not_copyable {
+public:
+  static SamplingProfiler &get() noexcept {
+    static SamplingProfiler sampling_profiler;
+    return sampling_profiler;
+  }
+
+  void set_frequency(int hz) noexcept { hz_ = hz; }
+  bool enabled() const noexcept { return hz_ > 0; }
+
+  // called from the master once, before the first worker is forked
+  void init(int slots_count) noexcept;
+  // called from the worker just after the fork, the timer starts when the signals are allowed
+  void on_worker_start(int logname_id) noexcept;
+
+  // the stacks of all the workers, the root frame first: "main;foo;bar <samples>\n"
+  std::string to_collapsed_stacks() const noexcept;
+
+private:
+  static constexpr size_t MAX_DEPTH = 32;
+  static constexpr size_t STACKS_PER_WORKER = 256;
+
+  struct Stack {
+    std::atomic<uint64_t> hash;
+    std::atomic<uint64_t> samples;
+    uint32_t depth;
+    // the innermost frame first
+    std::array<void *, MAX_DEPTH> pcs;
+  };
+
+  // the stacks of a worker, written from its signal handler only
+  struct Table {
+    std::atomic<uint64_t> samples_outside_script;
+    std::atomic<uint64_t> samples_dropped;
+    std::array<Stack, STACKS_PER_WORKER> stacks;
+  };
+
+  SamplingProfiler() = default;
+
+  static void sigprof_handler(int sig, siginfo_t *info, void *ucontext) noexcept;
+  void add_sample(void *const *pcs, uint32_t depth) noexcept;
+
+  int hz_{0};
+  Table *tables_{nullptr};
+  int tables_count_{0};
+  Table *own_table_{nullptr};
+};
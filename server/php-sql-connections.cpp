@@ -4,6 +4,8 @@
 
 #include "server/php-sql-connections.h"
 
+#include <algorithm>
+
 #include "net/net-connections.h"
 #include "net/net-mysql-client.h"
 
@@ -14,6 +16,12 @@
 
 #define RESPONSE_FAIL_TIMEOUT 30.0
 
+// the answer to a ping or a session reset is expected, not to a query
+#define SQL_SERVICE_COMMAND 4
+
+#define COM_PING 0x0e
+#define COM_RESET_CONNECTION 0x1f
+
 void command_net_write_run_sql(command_t *base_command, void *data);
 
 command_t command_net_write_sql_base = {
@@ -22,6 +30,8 @@ command_t command_net_write_sql_base = {
 };
 
 static const char *mysql_db_name = "dbname_not_set";
+static double sql_ping_interval = 0;
+static bool sql_reset_session = false;
 
 
 int proxy_client_execute(connection *c, int op);
@@ -35,6 +45,51 @@ bool set_mysql_db_name(const char *db_name) {
   return true;
 }
 
+bool set_sql_connections_limit(int limit) {
+  if (limit <= 0) {
+    return false;
+  }
+  db_ct.max_connections = limit;
+  db_ct.min_connections = std::min(db_ct.min_connections, limit);
+  return true;
+}
+
+bool set_sql_ping_interval(double interval) {
+  if (interval < 0) {
+    return false;
+  }
+  sql_ping_interval = interval;
+  return true;
+}
+
+void set_sql_reset_session() {
+  sql_reset_session = true;
+}
+
+static void sqlp_send_service_command(connection *c, unsigned char command) {
+  const unsigned char packet[5] = {1, 0, 0, 0, command};
+  assert (write_out(&c->Out, packet, 5) == 5);
+  SQLC_FUNC (c)->sql_flush_packet(c, 1);
+  flush_connection_output(c);
+  c->last_query_sent_time = precise_now;
+  c->status = conn_wait_answer;
+  SQLC_DATA(c)->response_state = resp_first;
+  SQLC_DATA(c)->extra_flags |= SQL_SERVICE_COMMAND;
+}
+
+void sql_reset_sessions() {
+  if (!sql_reset_session || sql_target_id == -1) {
+    return;
+  }
+  conn_target_t *target = &Targets[sql_target_id];
+  for (connection *c = target->first_conn; c != (connection *)target; c = c->next) {
+    // the connections which are still busy with a query of the finished script are left as is
+    if (c->status == conn_ready && SQLC_DATA(c)->auth_state == sql_auth_ok) {
+      sqlp_send_service_command(c, COM_RESET_CONNECTION);
+    }
+  }
+}
+
 mysql_client_functions db_client_outbound = [] {
   auto res = mysql_client_functions();
   res.execute = proxy_client_execute;
@@ -187,7 +242,7 @@ int sqlp_becomes_ready(connection *c) {
       create_pnet_query(q->requester, c, net_ansgen, q->timer.wakeup_time);
 
       delete_conn_query(q);
-      free(q);
+      free_conn_query(q);
 
       auto ansgen = (sql_ansgen_t *)net_ansgen;
       ansgen->func->ready(ansgen, c);
@@ -213,6 +268,11 @@ int sqlp_check_ready(connection *c) {
     fail_connection(c, -4);
     return c->ready = cr_failed;
   }
+  if (sql_ping_interval > 0 && c->status == conn_ready && SQLC_DATA(c)->auth_state == sql_auth_ok
+      && std::max(c->last_response_time, c->last_query_sent_time) < precise_now - sql_ping_interval) {
+    // an idle connection may have been closed by the server or a firewall meanwhile
+    sqlp_send_service_command(c, COM_PING);
+  }
   if (c->status == conn_wait_answer || c->status == conn_reading_answer) {
     if (!(c->flags & C_FAILED) && c->last_query_sent_time < precise_now - RESPONSE_FAIL_TIMEOUT - c->last_query_time && c->last_response_time < precise_now - RESPONSE_FAIL_TIMEOUT - c
       ->last_query_time && !(SQLC_DATA(c)->extra_flags & 1)) {
@@ -259,21 +319,54 @@ int sqlp_authorized(connection *c) {
   return 0;
 }
 
+// SERVER_MORE_RESULTS_EXISTS in the status of the OK or EOF packet, which ends a result of a multi-statement query
+static bool sql_more_results(const unsigned char *packet, int len) {
+  constexpr int SERVER_MORE_RESULTS_EXISTS = 8;
+  int pos = 1;
+  if (packet[0] == 0) {
+    for (int i = 0; i < 2 && pos < len; i++) {
+      // affected rows and insert id
+      const int lengths[4] = {3, 4, 9, 1};
+      pos += packet[pos] < 251 ? 1 : lengths[std::min(packet[pos] - 252, 3)];
+    }
+  } else {
+    // warnings
+    pos += 2;
+  }
+  return pos + 2 <= len && (packet[pos] & SERVER_MORE_RESULTS_EXISTS);
+}
+
 int proxy_client_execute(connection *c, int op) {
   sqlc_data *D = SQLC_DATA(c);
-  static char buffer[8];
+  static char buffer[32];
   int b_len, field_cnt = -1;
   nb_iterator_t it;
 
   nbit_set(&it, &c->In);
-  b_len = nbit_read_in(&it, buffer, 8);
+  b_len = nbit_read_in(&it, buffer, std::min(D->packet_len + 4, static_cast<int>(sizeof(buffer))));
 
   if (b_len >= 5) {
     field_cnt = buffer[4] & 0xff;
   }
+  const bool more_results = (field_cnt == 0 || field_cnt == 0xfe) && sql_more_results(reinterpret_cast<unsigned char *>(buffer) + 4, b_len - 4);
 
   vkprintf (1, "proxy_db_client: op=%d, packet_len=%d, response_state=%d, field_num=%d\n", op, D->packet_len, D->response_state, field_cnt);
 
+  if (D->extra_flags & SQL_SERVICE_COMMAND) {
+    D->extra_flags &= ~SQL_SERVICE_COMMAND;
+    c->last_response_time = precise_now;
+    if (field_cnt != 0) {
+      // a fresh connection is as good as a reset one
+      vkprintf (1, "outbound sql connection %d: error in answer to a service command, closing connection\n", c->fd);
+      fail_connection(c, -10);
+      c->ready = cr_failed;
+      return SKIP_ALL_BYTES;
+    }
+    c->status = conn_ready;
+    sqlp_becomes_ready(c);
+    return SKIP_ALL_BYTES;
+  }
+
   if (c->first_query == (conn_query *)c) {
     vkprintf (-1, "response received for empty query list? op=%d\n", op);
     return SKIP_ALL_BYTES;
@@ -307,6 +400,8 @@ int proxy_client_execute(connection *c, int op) {
           vkprintf (1, "outbound connection %d: nowhere to forward replication stream, closing\n", c->fd);
           c->status = conn_error;
         }
+      } else if (field_cnt == 0 && more_results) {
+        // the next result of the multi-statement query follows
       } else if (field_cnt == 0 || field_cnt == 0xff) {
         D->response_state = resp_done;
       } else if (field_cnt < 0 || field_cnt >= 0xfe) {
@@ -344,7 +439,7 @@ int proxy_client_execute(connection *c, int op) {
         return 0;
       }
       if (field_cnt == 0xfe) {
-        D->response_state = resp_done;
+        D->response_state = more_results ? resp_first : resp_done;
       }
       break;
     case resp_done:
@@ -11,4 +11,9 @@
 
 void php_worker_run_sql_query_packet(php_worker *worker, php_net_query_packet_t *query);
 bool set_mysql_db_name(const char *db_name);
+bool set_sql_connections_limit(int limit);
+bool set_sql_ping_interval(double interval);
+void set_sql_reset_session();
+// sends the session reset to the idle sql connections once the script is finished, if enabled
+void sql_reset_sessions();
 extern conn_target_t db_ct;
@@ -0,0 +1,167 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-tracing.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common/precise-time.h"
+
+constexpr size_t Tracing::MAX_SPANS;
+constexpr size_t Tracing::FLUSH_SIZE;
+
+static const char *span_kind_names[] = {"script", "rpc", "memcache", "mysql", "curl"};
+static_assert(sizeof(span_kind_names) / sizeof(span_kind_names[0]) == static_cast<size_t>(Tracing::SpanKind::count), "");
+
+bool Tracing::set_sample_rate(double rate) noexcept {
+  if (!(0 <= rate && rate <= 1)) {
+    return false;
+  }
+  sample_threshold_ = rate >= 1 ? UINT64_MAX : static_cast<uint64_t>(rate * 18446744073709551616.0);
+  return true;
+}
+
+bool Tracing::set_export_file(const char *path) noexcept {
+  // the file is opened before the workers are forked, so they append to it through the same description
+  const int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  if (export_fd_ >= 0) {
+    close(export_fd_);
+  }
+  export_fd_ = fd;
+  return true;
+}
+
+uint64_t Tracing::next_random() noexcept {
+  if (unlikely(random_state_ == 0)) {
+    // the state is seeded lazily, after the worker is forked
+    random_state_ = (get_ntime_mono_fast() ^ (static_cast<uint64_t>(getpid()) << 32U)) | 1;
+  }
+  random_state_ ^= random_state_ >> 12U;
+  random_state_ ^= random_state_ << 25U;
+  random_state_ ^= random_state_ >> 27U;
+  return random_state_ * 0x2545f4914f6cdd1dULL;
+}
+
+uint64_t Tracing::new_span_id() noexcept {
+  uint64_t id = 0;
+  while (id == 0) {
+    id = next_random();
+  }
+  return id;
+}
+
+void Tracing::start_request(uint64_t trace_id, uint64_t parent_span_id, double now) noexcept {
+  sampled_ = enabled() && (trace_id != 0 || (sample_threshold_ != 0 && next_random() < sample_threshold_));
+  if (likely(!sampled_)) {
+    return;
+  }
+  trace_id_ = trace_id ? trace_id : new_span_id();
+  parent_span_id_ = parent_span_id;
+  script_span_id_ = new_span_id();
+  script_start_time_ = now;
+  real_start_time_ = static_cast<double>(get_ntime_real_fast()) * 1e-9;
+  script_time_ = net_time_ = 0;
+  script_error_ = script_error_t::no_error;
+  spans_started_ = 0;
+}
+
+void Tracing::on_script_finish(double script_time, double net_time, script_error_t error) noexcept {
+  if (sampled_) {
+    script_time_ = script_time;
+    net_time_ = net_time;
+    script_error_ = error;
+  }
+}
+
+void Tracing::start_span_slow(SpanKind kind, int64_t key, int32_t target, uint32_t bytes_out, double now, uint64_t span_id) noexcept {
+  if (spans_started_ >= MAX_SPANS) {
+    ++spans_dropped_;
+  }
+  Span &span = spans_[spans_started_++ % MAX_SPANS];
+  span.span_id = span_id ? span_id : new_span_id();
+  span.key = key;
+  span.start_time = now;
+  span.finish_time = 0;
+  span.bytes_out = bytes_out;
+  span.bytes_in = 0;
+  span.target = target;
+  span.status = 0;
+  span.kind = kind;
+}
+
+void Tracing::finish_span_slow(SpanKind kind, int64_t key, int32_t status, uint32_t bytes_in, double now) noexcept {
+  // the answers usually come in the order of the queries, so the search starts from the newest spans
+  for (size_t i = spans_count(); i-- > 0;) {
+    Span &span = spans_[(spans_started_ - spans_count() + i) % MAX_SPANS];
+    if (span.kind == kind && span.key == key && span.finish_time == 0) {
+      span.finish_time = now;
+      span.bytes_in = bytes_in;
+      span.status = status;
+      return;
+    }
+  }
+}
+
+void Tracing::finish_request(double queue_time, double now) noexcept {
+  if (likely(!sampled_)) {
+    return;
+  }
+  sampled_ = false;
+
+  if (export_buffer_.empty()) {
+    buffer_start_time_ = now;
+  }
+  const double mono_to_real = real_start_time_ - script_start_time_;
+  char line[512];
+  int len = snprintf(line, sizeof(line),
+                     R"({"trace_id":"%016)" PRIx64 R"(","span_id":"%016)" PRIx64 R"(","parent_id":"%016)" PRIx64 R"(","kind":"script",)"
+                     R"("start_us":%.0f,"duration_us":%.0f,"queue_us":%.0f,"script_us":%.0f,"net_us":%.0f,"error":%d})" "\n",
+                     trace_id_, script_span_id_, parent_span_id_, real_start_time_ * 1e6, (now - script_start_time_) * 1e6,
+                     queue_time * 1e6, script_time_ * 1e6, net_time_ * 1e6, static_cast<int>(script_error_));
+  export_buffer_.append(line, std::min(static_cast<size_t>(len), sizeof(line) - 1));
+
+  for (size_t i = 0; i < spans_count(); ++i) {
+    const Span &s = span(i);
+    // the queries which are still in flight, e.g. the ones without an answer awaited, are cut by the request end
+    const bool finished = s.finish_time != 0;
+    len = snprintf(line, sizeof(line),
+                   R"({"trace_id":"%016)" PRIx64 R"(","span_id":"%016)" PRIx64 R"(","parent_id":"%016)" PRIx64 R"(","kind":"%s",)"
+                   R"("target":%d,"start_us":%.0f,"duration_us":%.0f,"bytes_out":%u,"bytes_in":%u,"status":%d%s})" "\n",
+                   trace_id_, s.span_id, script_span_id_, span_kind_names[static_cast<size_t>(s.kind)],
+                   s.target, (s.start_time + mono_to_real) * 1e6, ((finished ? s.finish_time : now) - s.start_time) * 1e6,
+                   s.bytes_out, s.bytes_in, s.status, finished ? "" : R"(,"unfinished":true)");
+    export_buffer_.append(line, std::min(static_cast<size_t>(len), sizeof(line) - 1));
+  }
+  spans_exported_ += spans_count() + 1;
+}
+
+void Tracing::flush(double now, bool force) noexcept {
+  if (likely(export_buffer_.empty())) {
+    return;
+  }
+  if (!force && export_buffer_.size() < FLUSH_SIZE && now - buffer_start_time_ < 1.0) {
+    return;
+  }
+  size_t written = 0;
+  while (written < export_buffer_.size()) {
+    const ssize_t res = write(export_fd_, export_buffer_.data() + written, export_buffer_.size() - written);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      // the spans are not worth blocking the worker
+      spans_dropped_ += std::count(export_buffer_.begin() + written, export_buffer_.end(), '\n');
+      break;
+    }
+    written += static_cast<size_t>(res);
+  }
+  export_buffer_.clear();
+}
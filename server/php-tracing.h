@@ -0,0 +1,136 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "common/mixin/not_copyable.h"
+#include "common/wrappers/likely.h"
+
+#include "server/php-runner.h"
+
+// The spans of the outgoing queries of a sampled request: the script itself, rpc, memcache, mysql and curl.
+// The spans of the request are kept in a fixed ring, so a request with too many queries keeps only the last ones.
+// They are formatted as json lines after the answer is sent and written to the file while the worker is idle.
+// An unsampled request costs a branch per query
+class Tracing : vk::not_copyable {
+public:
+  enum class SpanKind : uint8_t {
+    script,
+    rpc,
+    memcache,
+    mysql,
+    curl,
+    count
+  };
+
+  struct Span {
+    uint64_t span_id;
+    int64_t key;
+    double start_time;
+    // 0 while the span is not finished
+    double finish_time;
+    uint32_t bytes_out;
+    uint32_t bytes_in;
+    int32_t target;
+    int32_t status;
+    SpanKind kind;
+  };
+
+  static Tracing &get() noexcept {
+    static Tracing tracing;
+    return tracing;
+  }
+
+  static constexpr size_t MAX_SPANS = 256;
+  // the buffered spans are written out when there are that many bytes of them, or in a second
+  static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+  bool set_sample_rate(double rate) noexcept;
+  bool set_export_file(const char *path) noexcept;
+  void set_propagation(bool propagate) noexcept { propagate_ = propagate; }
+  bool enabled() const noexcept { return export_fd_ >= 0; }
+
+  // the request is sampled if the caller has sampled the trace, or with the sample rate otherwise
+  void start_request(uint64_t trace_id, uint64_t parent_span_id, double now) noexcept;
+  void on_script_finish(double script_time, double net_time, script_error_t error) noexcept;
+  // formats the spans of the request to the export buffer
+  void finish_request(double queue_time, double now) noexcept;
+
+  bool sampled() const noexcept { return sampled_; }
+  // the trace context is put into the headers of the outgoing rpc queries
+  bool should_propagate() const noexcept { return sampled_ && propagate_; }
+  uint64_t trace_id() const noexcept { return trace_id_; }
+  uint64_t new_span_id() noexcept;
+
+  // span_id is 0 unless it has been already sent in the trace context
+  void start_span(SpanKind kind, int64_t key, int32_t target, uint32_t bytes_out, double now, uint64_t span_id = 0) noexcept {
+    if (unlikely(sampled_)) {
+      start_span_slow(kind, key, target, bytes_out, now, span_id);
+    }
+  }
+
+  void finish_span(SpanKind kind, int64_t key, int32_t status, uint32_t bytes_in, double now) noexcept {
+    if (unlikely(sampled_)) {
+      finish_span_slow(kind, key, status, bytes_in, now);
+    }
+  }
+
+  // the spans of a synchronous query
+  void add_span(SpanKind kind, int32_t target, uint32_t bytes_out, uint32_t bytes_in, int32_t status, double start_time, double now) noexcept {
+    if (unlikely(sampled_)) {
+      start_span_slow(kind, 0, target, bytes_out, start_time, 0);
+      finish_span_slow(kind, 0, status, bytes_in, now);
+    }
+  }
+
+  // writes the buffered spans out, it's called while there are no requests
+  void flush(double now, bool force = false) noexcept;
+
+  size_t spans_count() const noexcept { return std::min(spans_started_, MAX_SPANS); }
+  // 0 is the oldest of the kept spans
+  const Span &span(size_t i) const noexcept { return spans_[(spans_started_ - spans_count() + i) % MAX_SPANS]; }
+  const std::string &export_buffer() const noexcept { return export_buffer_; }
+  uint64_t spans_exported() const noexcept { return spans_exported_; }
+  uint64_t spans_dropped() const noexcept { return spans_dropped_; }
+
+private:
+  Tracing() = default;
+
+  void start_span_slow(SpanKind kind, int64_t key, int32_t target, uint32_t bytes_out, double now, uint64_t span_id) noexcept;
+  void finish_span_slow(SpanKind kind, int64_t key, int32_t status, uint32_t bytes_in, double now) noexcept;
+  uint64_t next_random() noexcept;
+
+  // the probability is compared with a random 64-bit number
+  uint64_t sample_threshold_{0};
+  int export_fd_{-1};
+  bool propagate_{false};
+
+  bool sampled_{false};
+  uint64_t trace_id_{0};
+  uint64_t parent_span_id_{0};
+  uint64_t script_span_id_{0};
+  double script_start_time_{0};
+  // the time of the real clock at the request start, to convert the monotonic times of the spans
+  double real_start_time_{0};
+  double script_time_{0};
+  double net_time_{0};
+  script_error_t script_error_{script_error_t::no_error};
+
+  std::array<Span, MAX_SPANS> spans_{};
+  size_t spans_started_{0};
+
+  uint64_t random_state_{0};
+
+  std::string export_buffer_;
+  // the buffered spans wait for a second at most
+  double buffer_start_time_{0};
+  uint64_t spans_exported_{0};
+  uint64_t spans_dropped_{0};
+};
@@ -0,0 +1,240 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-warmup.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "common/kprintf.h"
+#include "net/net-events.h"
+
+#include "server/php-worker-metrics.h"
+
+constexpr size_t HttpWarmup::MAX_RECORD_FILE_SIZE;
+constexpr double HttpWarmup::DEFAULT_TIMEOUT;
+
+// a record of the file is the lengths of the head and the body followed by them
+struct RecordHeader {
+  uint32_t head_len;
+  uint32_t body_len;
+};
+
+bool HttpWarmup::set_record_file(const char *path) noexcept {
+  // the file is opened before the workers are forked, so they append to it through the same description
+  const int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  if (record_fd_ >= 0) {
+    close(record_fd_);
+  }
+  record_fd_ = fd;
+  return true;
+}
+
+bool HttpWarmup::set_record_rate(double rate) noexcept {
+  if (!(0 < rate && rate <= 1)) {
+    return false;
+  }
+  record_rate_ = rate;
+  return true;
+}
+
+void HttpWarmup::record_slow(const char *head, size_t head_len, const char *body, size_t body_len) noexcept {
+  if (drand48() >= record_rate_) {
+    return;
+  }
+  struct stat file_stat{};
+  if (fstat(record_fd_, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) >= MAX_RECORD_FILE_SIZE) {
+    return;
+  }
+  RecordHeader header{static_cast<uint32_t>(head_len), static_cast<uint32_t>(body_len)};
+  iovec parts[3] = {{&header, sizeof(header)}, {const_cast<char *>(head), head_len}, {const_cast<char *>(body), body_len}};
+  // a single appending write, so the records of the workers don't interleave
+  if (writev(record_fd_, parts, 3) < 0) {
+    vkprintf(1, "can't record the request for the warmup: %m\n");
+  }
+}
+
+bool HttpWarmup::load(const char *path) noexcept {
+  const int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  std::string content;
+  char buffer[1 << 16];
+  ssize_t read_len = 0;
+  while ((read_len = read(fd, buffer, sizeof(buffer))) > 0) {
+    content.append(buffer, static_cast<size_t>(read_len));
+  }
+  close(fd);
+  if (read_len < 0) {
+    return false;
+  }
+
+  requests_.clear();
+  size_t pos = 0;
+  RecordHeader header{};
+  while (pos + sizeof(header) <= content.size()) {
+    std::memcpy(&header, content.data() + pos, sizeof(header));
+    pos += sizeof(header);
+    if (content.size() - pos < static_cast<size_t>(header.head_len) + header.body_len) {
+      // the last record may be cut, if the file has been copied while it was written
+      break;
+    }
+    const char *head = content.data() + pos;
+    requests_.emplace_back(prepare_request(head, header.head_len, head + header.head_len, header.body_len));
+    pos += static_cast<size_t>(header.head_len) + header.body_len;
+  }
+  return true;
+}
+
+bool HttpWarmup::set_timeout(double seconds) noexcept {
+  if (!(seconds > 0)) {
+    return false;
+  }
+  timeout_ = seconds;
+  return true;
+}
+
+static bool is_header(const char *line, size_t line_len, const char *name) noexcept {
+  const size_t name_len = std::strlen(name);
+  return line_len > name_len && strncasecmp(line, name, name_len) == 0 && line[name_len] == ':';
+}
+
+std::string HttpWarmup::prepare_request(const char *head, size_t head_len, const char *body, size_t body_len) noexcept {
+  std::string request;
+  request.reserve(head_len + body_len + 64);
+  size_t pos = 0;
+  bool is_first_line = true;
+  while (pos < head_len) {
+    const char *line = head + pos;
+    const auto *line_end = static_cast<const char *>(std::memchr(line, '\n', head_len - pos));
+    const size_t line_size = line_end ? line_end - line + 1 : head_len - pos;
+    pos += line_size;
+    size_t line_len = line_size;
+    while (line_len > 0 && (line[line_len - 1] == '\n' || line[line_len - 1] == '\r')) {
+      --line_len;
+    }
+    if (line_len == 0) {
+      // the empty line ends the head
+      break;
+    }
+    if (!is_first_line && (is_header(line, line_len, "Connection") || is_header(line, line_len, "X-KPHP-Warmup"))) {
+      continue;
+    }
+    request.append(line, line_len).append("\r\n");
+    is_first_line = false;
+  }
+  request.append("Connection: close\r\nX-KPHP-Warmup: 1\r\n\r\n");
+  request.append(body, body_len);
+  return request;
+}
+
+bool HttpWarmup::start(int port, double now) noexcept {
+  if (requests_.empty()) {
+    return false;
+  }
+  port_ = port;
+  start_time_ = now;
+  next_request_ = 0;
+  replayed_ = 0;
+  in_progress_ = true;
+  WorkerMetrics::get().on_warmup_start();
+  return true;
+}
+
+bool HttpWarmup::run(double now) noexcept {
+  if (!in_progress_) {
+    return false;
+  }
+  if (now - start_time_ < timeout_) {
+    while (client_fd_ < 0 && next_request_ < requests_.size()) {
+      connect_next();
+    }
+    if (client_fd_ >= 0) {
+      return false;
+    }
+  }
+  finish(now);
+  return true;
+}
+
+void HttpWarmup::connect_next() noexcept {
+  ++next_request_;
+  const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port_));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 && errno != EINPROGRESS) {
+    vkprintf(1, "can't connect to the warmup socket: %m\n");
+    close(fd);
+    return;
+  }
+  client_fd_ = fd;
+  written_ = 0;
+  epoll_sethandler(fd, 0, client_event_handler, this);
+  epoll_insert(fd, EVT_RW | EVT_LEVEL);
+}
+
+int HttpWarmup::client_event_handler(int fd __attribute__((unused)), void *data, event_t *ev __attribute__((unused))) {
+  return static_cast<HttpWarmup *>(data)->on_client_event();
+}
+
+int HttpWarmup::on_client_event() noexcept {
+  const std::string &request = requests_[next_request_ - 1];
+  if (written_ < request.size()) {
+    const ssize_t res = write(client_fd_, request.data() + written_, request.size() - written_);
+    if (res > 0) {
+      written_ += static_cast<size_t>(res);
+    } else if (res < 0 && errno != EAGAIN && errno != EINTR) {
+      client_fd_ = -1;
+      return EVA_DESTROY;
+    }
+    if (written_ < request.size()) {
+      return EVA_CONTINUE;
+    }
+  }
+
+  // the answer isn't parsed, the server closes the connection after it
+  static char answer[1 << 16];
+  ssize_t res = 0;
+  while ((res = read(client_fd_, answer, sizeof(answer))) > 0) {
+  }
+  if (res < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return EVT_READ | EVT_LEVEL;
+  }
+  if (res == 0) {
+    ++replayed_;
+    WorkerMetrics::get().add_warmup_query();
+  }
+  client_fd_ = -1;
+  return EVA_DESTROY;
+}
+
+void HttpWarmup::finish(double now) noexcept {
+  if (client_fd_ >= 0) {
+    epoll_close(client_fd_);
+    close(client_fd_);
+    client_fd_ = -1;
+  }
+  in_progress_ = false;
+  WorkerMetrics::get().on_warmup_finish(now - start_time_);
+  vkprintf(1, "warmup is finished: %zu of %zu requests are replayed in %.3lf seconds\n", replayed_, requests_.size(), now - start_time_);
+}
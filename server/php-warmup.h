@@ -0,0 +1,81 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+#include "common/wrappers/likely.h"
+
+// Replays a recorded sample of http requests in a freshly started worker before it accepts the real ones,
+// so the first real requests don't pay for the cold caches and the lazily built structures of the worker.
+// The sample is appended to a file by the workers of a running server and loaded by the master on start.
+// A worker sends the requests to its own loopback listening socket, a connection per request,
+// so they are parsed and run by the same code as the real ones; the answers are read and dropped.
+// The replayed requests carry the X-KPHP-Warmup header, by which the scripts may skip their side effects
+class HttpWarmup : vk::not_copyable {
+public:
+  static HttpWarmup &get() noexcept {
+    static HttpWarmup warmup;
+    return warmup;
+  }
+
+  // the recording stops when the file grows that big
+  static constexpr size_t MAX_RECORD_FILE_SIZE = 64 * 1024 * 1024;
+  static constexpr double DEFAULT_TIMEOUT = 10;
+
+  bool set_record_file(const char *path) noexcept;
+  bool set_record_rate(double rate) noexcept;
+
+  // the head is the request line with the headers
+  void record(const char *head, size_t head_len, const char *body, size_t body_len) noexcept {
+    if (unlikely(record_fd_ >= 0) && !in_progress_) {
+      record_slow(head, head_len, body, body_len);
+    }
+  }
+
+  // called by the master before the workers are started
+  bool load(const char *path) noexcept;
+  bool set_timeout(double seconds) noexcept;
+  size_t requests_count() const noexcept { return requests_.size(); }
+  const std::string &request(size_t i) const noexcept { return requests_[i]; }
+
+  // returns false if there is nothing to replay
+  bool start(int port, double now) noexcept;
+  bool in_progress() const noexcept { return in_progress_; }
+  // sends the next request when the previous one is answered;
+  // returns true when the warmup is finished, i.e. all the requests are replayed or the time is out
+  bool run(double now) noexcept;
+  size_t replayed_count() const noexcept { return replayed_; }
+
+  // the connection is closed after the answer, and the warmup header is added
+  static std::string prepare_request(const char *head, size_t head_len, const char *body, size_t body_len) noexcept;
+
+private:
+  HttpWarmup() = default;
+
+  void record_slow(const char *head, size_t head_len, const char *body, size_t body_len) noexcept;
+  void connect_next() noexcept;
+  int on_client_event() noexcept;
+  void finish(double now) noexcept;
+
+  static int client_event_handler(int fd, void *data, struct event_descr *ev);
+
+  int record_fd_{-1};
+  double record_rate_{0.001};
+
+  std::vector<std::string> requests_;
+  double timeout_{DEFAULT_TIMEOUT};
+
+  bool in_progress_{false};
+  int port_{0};
+  double start_time_{0};
+  size_t next_request_{0};
+  size_t replayed_{0};
+  int client_fd_{-1};
+  size_t written_{0};
+};
@@ -0,0 +1,274 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-worker-metrics.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cstdio>
+#include <new>
+#include <sys/mman.h>
+
+#include "common/kprintf.h"
+
+namespace {
+const char *error_label(script_error_t error) noexcept {
+  switch (error) {
+    case script_error_t::no_error:
+      return "no_error";
+    case script_error_t::memory_limit:
+      return "memory_limit_exceeded";
+    case script_error_t::timeout:
+      return "timeout";
+    case script_error_t::exception:
+      return "exception";
+    case script_error_t::stack_overflow:
+      return "stack_overflow";
+    case script_error_t::php_assert:
+      return "php_assert";
+    case script_error_t::http_connection_close:
+      return "http_connection_close";
+    case script_error_t::rpc_connection_close:
+      return "rpc_connection_close";
+    case script_error_t::net_event_error:
+      return "net_event_error";
+    case script_error_t::post_data_loading_error:
+      return "post_data_loading_error";
+    default:
+      return "unclassified";
+  }
+}
+
+void add_relaxed(std::atomic<uint64_t> &counter, uint64_t value) noexcept {
+  // the only writer of a slot is its worker, so a plain load and store is enough and cheaper than fetch_add
+  counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+} // namespace
+
+void WorkerMetrics::init(int slots_count) noexcept {
+  assert(slots_ == nullptr);
+  const size_t size = sizeof(Slot) * slots_count;
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    kprintf("Can't mmap %zu bytes for the worker metrics: %m\n", size);
+    return;
+  }
+  // the anonymous memory is zeroed, the atomics are just started in place
+  slots_ = new(memory) Slot[slots_count];
+  slots_count_ = slots_count;
+}
+
+void WorkerMetrics::on_worker_start(int logname_id, int worker_pid) noexcept {
+  if (slots_ == nullptr || logname_id < 0 || logname_id >= slots_count_) {
+    return;
+  }
+  own_slot_ = &slots_[logname_id];
+  own_slot_->pid.store(worker_pid, std::memory_order_relaxed);
+  own_slot_->workers_started.fetch_add(1, std::memory_order_relaxed);
+  // the previous worker of the slot may have died in the middle of its warmup
+  own_slot_->warming_up.store(0, std::memory_order_relaxed);
+}
+
+void WorkerMetrics::add_query(double script_time, double net_time, long script_queries, long max_memory_used, script_error_t error) noexcept {
+  if (own_slot_ == nullptr || own_slot_->warming_up.load(std::memory_order_relaxed)) {
+    return;
+  }
+  add_relaxed(own_slot_->queries, 1);
+  add_relaxed(own_slot_->script_queries, script_queries);
+  add_relaxed(own_slot_->script_time_us, static_cast<uint64_t>(script_time * 1e6));
+  add_relaxed(own_slot_->net_time_us, static_cast<uint64_t>(net_time * 1e6));
+  add_relaxed(own_slot_->errors[static_cast<size_t>(error)], 1);
+  add_latency(Latency::working_time, script_time + net_time);
+  add_latency(Latency::script_time, script_time);
+  add_latency(Latency::net_time, net_time);
+  if (static_cast<uint64_t>(max_memory_used) > own_slot_->script_max_memory_used.load(std::memory_order_relaxed)) {
+    own_slot_->script_max_memory_used.store(max_memory_used, std::memory_order_relaxed);
+  }
+}
+
+void WorkerMetrics::add_latency(Latency latency, double seconds) noexcept {
+  if (own_slot_ == nullptr) {
+    return;
+  }
+  const uint64_t us = seconds > 0 ? static_cast<uint64_t>(seconds * 1e6) : 0;
+  add_relaxed(own_slot_->latencies[static_cast<size_t>(latency)][latency_bucket(us)], 1);
+}
+
+void WorkerMetrics::on_warmup_start() noexcept {
+  if (own_slot_ != nullptr) {
+    own_slot_->warming_up.store(1, std::memory_order_relaxed);
+  }
+}
+
+void WorkerMetrics::add_warmup_query() noexcept {
+  if (own_slot_ != nullptr) {
+    add_relaxed(own_slot_->warmup_queries, 1);
+  }
+}
+
+void WorkerMetrics::on_warmup_finish(double seconds) noexcept {
+  if (own_slot_ == nullptr) {
+    return;
+  }
+  add_relaxed(own_slot_->warmup_time_us, static_cast<uint64_t>(seconds * 1e6));
+  own_slot_->warmups_finished.fetch_add(1, std::memory_order_relaxed);
+  own_slot_->warming_up.store(0, std::memory_order_relaxed);
+}
+
+bool WorkerMetrics::is_warming_up(int logname_id) const noexcept {
+  if (slots_ == nullptr || logname_id < 0 || logname_id >= slots_count_) {
+    return false;
+  }
+  return slots_[logname_id].warming_up.load(std::memory_order_relaxed) != 0;
+}
+
+void WorkerMetrics::write_warmup_stats_to(stats_t *stats) const noexcept {
+  if (slots_ == nullptr) {
+    return;
+  }
+  uint64_t in_progress = 0;
+  uint64_t finished = 0;
+  uint64_t queries = 0;
+  uint64_t time_us = 0;
+  for (int i = 0; i < slots_count_; ++i) {
+    const Slot &slot = slots_[i];
+    in_progress += slot.warming_up.load(std::memory_order_relaxed);
+    finished += slot.warmups_finished.load(std::memory_order_relaxed);
+    queries += slot.warmup_queries.load(std::memory_order_relaxed);
+    time_us += slot.warmup_time_us.load(std::memory_order_relaxed);
+  }
+  add_gauge_stat_long(stats, "warmup.workers_in_progress", in_progress);
+  add_gauge_stat_long(stats, "warmup.workers_finished", finished);
+  add_gauge_stat_long(stats, "warmup.requests_replayed", queries);
+  add_histogram_stat_double(stats, "warmup.avg_duration", finished ? time_us * 1e-6 / finished : 0);
+}
+
+size_t WorkerMetrics::latency_bucket(uint64_t us) noexcept {
+  constexpr uint64_t sub_buckets = 1 << LATENCY_SUB_BUCKETS_BITS;
+  if (us < sub_buckets) {
+    return us;
+  }
+  const size_t power = 63 - __builtin_clzll(us);
+  const size_t sub_bucket = (us >> (power - LATENCY_SUB_BUCKETS_BITS)) & (sub_buckets - 1);
+  return std::min((power - LATENCY_SUB_BUCKETS_BITS + 1) * sub_buckets + sub_bucket, LATENCY_BUCKETS - 1);
+}
+
+uint64_t WorkerMetrics::latency_bucket_lower_bound(size_t bucket) noexcept {
+  constexpr uint64_t sub_buckets = 1 << LATENCY_SUB_BUCKETS_BITS;
+  if (bucket < sub_buckets) {
+    return bucket;
+  }
+  const size_t power = bucket / sub_buckets + LATENCY_SUB_BUCKETS_BITS - 1;
+  return (sub_buckets + bucket % sub_buckets) << (power - LATENCY_SUB_BUCKETS_BITS);
+}
+
+WorkerMetrics::LatencySnapshot WorkerMetrics::collect_latencies() const noexcept {
+  LatencySnapshot snapshot{};
+  for (int i = 0; i < slots_count_; ++i) {
+    const Slot &slot = slots_[i];
+    if (slot.workers_started.load(std::memory_order_relaxed) == 0) {
+      continue;
+    }
+    for (size_t latency = 0; latency < snapshot.size(); ++latency) {
+      for (size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+        snapshot[latency][bucket] += slot.latencies[latency][bucket].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return snapshot;
+}
+
+void WorkerMetrics::write_latency_stats_to(stats_t *stats, double now) noexcept {
+  if (slots_ == nullptr) {
+    return;
+  }
+  const LatencySnapshot current = collect_latencies();
+  if (now - latencies_newer_time_ >= 60) {
+    latencies_older_ = latencies_newer_;
+    latencies_newer_ = current;
+    latencies_newer_time_ = now;
+  }
+
+  static constexpr std::array<const char *, static_cast<size_t>(Latency::count)> names{
+    {"requests.latency.working_time", "requests.latency.script_time", "requests.latency.net_time",
+     "requests.latency.rpc_query", "requests.latency.memcached_query", "requests.latency.sql_query"}};
+  static constexpr std::array<std::pair<const char *, double>, 3> percentiles{
+    {{".percentile_50", 0.5}, {".percentile_99", 0.99}, {".percentile_999", 0.999}}};
+
+  for (size_t latency = 0; latency < names.size(); ++latency) {
+    std::array<uint64_t, LATENCY_BUCKETS> window{};
+    uint64_t total = 0;
+    for (size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+      window[bucket] = current[latency][bucket] - latencies_older_[latency][bucket];
+      total += window[bucket];
+    }
+    for (const auto &percentile : percentiles) {
+      // the middle of the bucket holding the percentile, in seconds
+      double value = 0;
+      const auto rank = static_cast<uint64_t>(percentile.second * total);
+      uint64_t seen = 0;
+      for (size_t bucket = 0; bucket < LATENCY_BUCKETS && total > 0; ++bucket) {
+        seen += window[bucket];
+        if (seen > rank) {
+          const uint64_t upper = bucket + 1 < LATENCY_BUCKETS ? latency_bucket_lower_bound(bucket + 1) : latency_bucket_lower_bound(bucket);
+          value = (latency_bucket_lower_bound(bucket) + upper) * 0.5e-6;
+          break;
+        }
+      }
+      std::string key = std::string{names[latency]} + percentile.first;
+      add_histogram_stat_double(stats, key.c_str(), value);
+    }
+  }
+}
+
+std::string WorkerMetrics::to_prometheus() const noexcept {
+  std::string res;
+  if (slots_ == nullptr) {
+    return res;
+  }
+  char buf[256];
+  auto write_counter = [&](const char *name, const char *type, const char *help, auto get_value) {
+    snprintf(buf, sizeof(buf), "# HELP kphp_worker_%s %s\n# TYPE kphp_worker_%s %s\n", name, help, name, type);
+    res += buf;
+    for (int i = 0; i < slots_count_; ++i) {
+      const Slot &slot = slots_[i];
+      if (slot.workers_started.load(std::memory_order_relaxed) == 0) {
+        continue;
+      }
+      snprintf(buf, sizeof(buf), "kphp_worker_%s{worker=\"%d\"} %" PRIu64 "\n", name, i, static_cast<uint64_t>(get_value(slot)));
+      res += buf;
+    }
+  };
+
+  write_counter("pid", "gauge", "Pid of the current worker of the slot.",
+                [](const Slot &slot) { return slot.pid.load(std::memory_order_relaxed); });
+  write_counter("started_total", "counter", "Workers started in the slot.",
+                [](const Slot &slot) { return slot.workers_started.load(std::memory_order_relaxed); });
+  write_counter("queries_total", "counter", "Finished script queries.",
+                [](const Slot &slot) { return slot.queries.load(std::memory_order_relaxed); });
+  write_counter("script_net_queries_total", "counter", "Net queries made by the scripts.",
+                [](const Slot &slot) { return slot.script_queries.load(std::memory_order_relaxed); });
+  write_counter("script_time_microseconds_total", "counter", "Time spent running the scripts.",
+                [](const Slot &slot) { return slot.script_time_us.load(std::memory_order_relaxed); });
+  write_counter("net_time_microseconds_total", "counter", "Time the scripts spent waiting for the net.",
+                [](const Slot &slot) { return slot.net_time_us.load(std::memory_order_relaxed); });
+  write_counter("script_max_memory_used_bytes", "gauge", "Max memory used by a script.",
+                [](const Slot &slot) { return slot.script_max_memory_used.load(std::memory_order_relaxed); });
+
+  res += "# HELP kphp_worker_script_errors_total Finished script queries by the error.\n"
+         "# TYPE kphp_worker_script_errors_total counter\n";
+  for (int i = 0; i < slots_count_; ++i) {
+    const Slot &slot = slots_[i];
+    if (slot.workers_started.load(std::memory_order_relaxed) == 0) {
+      continue;
+    }
+    for (size_t error = 0; error < slot.errors.size(); ++error) {
+      snprintf(buf, sizeof(buf), "kphp_worker_script_errors_total{worker=\"%d\",error=\"%s\"} %" PRIu64 "\n",
+               i, error_label(static_cast<script_error_t>(error)), slot.errors[error].load(std::memory_order_relaxed));
+      res += buf;
+    }
+  }
+  return res;
+}
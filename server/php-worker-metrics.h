@@ -0,0 +1,95 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "common/mixin/not_copyable.h"
+#include "common/stats/provider.h"
+
+#include "server/php-runner.h"
+
+// Binary per-worker counters in an anonymous shared memory segment, mapped by the master before the workers are forked.
+// A worker updates the slot of its logname id in place with relaxed atomics, the master reads all the slots directly
+// to serve the Prometheus text format and the latency percentiles, without the text stats sent through the pipes
+class WorkerMetrics : vk::not_copyable {
+public:
+  enum class Latency : uint8_t {
+    working_time,
+    script_time,
+    net_time,
+    rpc_query,
+    mc_query,
+    sql_query,
+    count
+  };
+
+  static WorkerMetrics &get() noexcept {
+    static WorkerMetrics worker_metrics;
+    return worker_metrics;
+  }
+
+  // called from the master once, before the first worker is forked
+  void init(int slots_count) noexcept;
+  // called from the worker just after the fork
+  void on_worker_start(int logname_id, int worker_pid) noexcept;
+
+  void add_query(double script_time, double net_time, long script_queries, long max_memory_used, script_error_t error) noexcept;
+  void add_latency(Latency latency, double seconds) noexcept;
+
+  // the replayed warmup requests are counted apart, they don't get into the query counters and the latencies
+  void on_warmup_start() noexcept;
+  void add_warmup_query() noexcept;
+  void on_warmup_finish(double seconds) noexcept;
+  bool is_warming_up(int logname_id) const noexcept;
+  void write_warmup_stats_to(stats_t *stats) const noexcept;
+
+  // the counters of a slot survive the restarts of its workers, so they stay monotonic for the scraper
+  std::string to_prometheus() const noexcept;
+  // percentiles of the latencies of all the workers over the last one or two minutes
+  void write_latency_stats_to(stats_t *stats, double now) noexcept;
+
+private:
+  // log-linear buckets of microseconds: 4 buckets per power of two, the last one takes everything above ~70 minutes
+  static constexpr size_t LATENCY_SUB_BUCKETS_BITS = 2;
+  static constexpr size_t LATENCY_BUCKETS = 128;
+  using LatencyHistogram = std::array<std::atomic<uint64_t>, LATENCY_BUCKETS>;
+  using LatencySnapshot = std::array<std::array<uint64_t, LATENCY_BUCKETS>, static_cast<size_t>(Latency::count)>;
+
+  static size_t latency_bucket(uint64_t us) noexcept;
+  static uint64_t latency_bucket_lower_bound(size_t bucket) noexcept;
+  LatencySnapshot collect_latencies() const noexcept;
+
+  // a slot is written by one worker only, cache line alignment keeps the workers from sharing lines
+  struct alignas(64) Slot {
+    std::atomic<int32_t> pid;
+    std::atomic<uint32_t> workers_started;
+    std::atomic<uint64_t> queries;
+    std::atomic<uint64_t> script_queries;
+    std::atomic<uint64_t> script_time_us;
+    std::atomic<uint64_t> net_time_us;
+    std::atomic<uint64_t> script_max_memory_used;
+    std::atomic<uint32_t> warming_up;
+    std::atomic<uint32_t> warmups_finished;
+    std::atomic<uint64_t> warmup_queries;
+    std::atomic<uint64_t> warmup_time_us;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(script_error_t::errors_count)> errors;
+    std::array<LatencyHistogram, static_cast<size_t>(Latency::count)> latencies;
+  };
+
+  WorkerMetrics() = default;
+
+  Slot *slots_{nullptr};
+  int slots_count_{0};
+  Slot *own_slot_{nullptr};
+
+  // master side: the percentiles are taken over the difference with the snapshot of one to two minutes ago
+  LatencySnapshot latencies_older_{};
+  LatencySnapshot latencies_newer_{};
+  double latencies_newer_time_{0};
+};
@@ -29,6 +29,24 @@ void write_percentile(stats_t *stats, const char *prefix, std::array<int64_t, 3>
   add_histogram_stat_long(stats, concat_stat(buffer, prefix, ".percentile_99"), value[2]);
 }
 
+void write_slab_stats(stats_t *stats, const char *prefix, const PhpWorkerStats::SlabStats &slab) noexcept {
+  std::array<char, 256> buffer{};
+  const uint64_t capacity = slab.blocks * slab.objects_in_block;
+  add_histogram_stat_long(stats, concat_stat(buffer, prefix, ".allocs"), slab.allocs);
+  add_histogram_stat_long(stats, concat_stat(buffer, prefix, ".used"), slab.used);
+  add_histogram_stat_long(stats, concat_stat(buffer, prefix, ".blocks"), slab.blocks);
+  add_histogram_stat_long(stats, concat_stat(buffer, prefix, ".block_refills"), slab.block_refills);
+  add_histogram_stat_double(stats, concat_stat(buffer, prefix, ".utilization"), capacity ? static_cast<double>(slab.used) / capacity : 0.0);
+}
+
+void add_slab_stats(PhpWorkerStats::SlabStats &to, const PhpWorkerStats::SlabStats &from) noexcept {
+  to.allocs += from.allocs;
+  to.used += from.used;
+  to.blocks += from.blocks;
+  to.block_refills += from.block_refills;
+  to.objects_in_block = std::max(to.objects_in_block, from.objects_in_block);
+}
+
 template<size_t P1, size_t P2, size_t P3, class T, size_t N>
 std::array<T, 3> calc_percentiles(std::array<T, N> &samples) {
   const auto last = std::remove(samples.begin(), samples.end(), 0);
@@ -84,6 +102,55 @@ void PhpWorkerStats::update_idle_time(double tot_idle_time, int uptime, double a
   internal_.a_idle_percent_ = average_idle_quotient > 0 ? average_idle_time / average_idle_quotient * 100 : 0;
 }
 
+void PhpWorkerStats::update_regexp_executions(uint64_t pcre_jit, uint64_t pcre_interpreted, uint64_t re2) noexcept {
+  internal_.regexp_pcre_jit_executions_ = pcre_jit;
+  internal_.regexp_pcre_interpreted_executions_ = pcre_interpreted;
+  internal_.regexp_re2_executions_ = re2;
+}
+
+void PhpWorkerStats::update_rpc_in_flight(uint64_t max_per_host, uint64_t balanced_queries) noexcept {
+  internal_.rpc_in_flight_max_per_host_ = max_per_host;
+  internal_.rpc_balanced_queries_ = balanced_queries;
+}
+
+void PhpWorkerStats::update_rpc_queues(uint64_t max_queued_bytes, uint64_t max_pending_answers, uint64_t busy_rejects) noexcept {
+  internal_.rpc_queue_max_bytes_per_target_ = max_queued_bytes;
+  internal_.rpc_queue_max_pending_per_target_ = max_pending_answers;
+  internal_.rpc_busy_rejects_ = busy_rejects;
+}
+
+void PhpWorkerStats::update_shed_queries(uint64_t shed_http_queries, uint64_t shed_rpc_queries) noexcept {
+  internal_.shed_http_queries_ = shed_http_queries;
+  internal_.shed_rpc_queries_ = shed_rpc_queries;
+}
+
+void PhpWorkerStats::update_memory_releases(uint64_t script_memory_releases, uint64_t heap_trims) noexcept {
+  internal_.script_memory_releases_ = script_memory_releases;
+  internal_.heap_trims_ = heap_trims;
+}
+
+void PhpWorkerStats::update_busy_poll(double spin_time, uint64_t spin_wakeups, uint64_t spin_sleeps) noexcept {
+  internal_.busy_poll_spin_time_ = spin_time;
+  internal_.busy_poll_spin_wakeups_ = spin_wakeups;
+  internal_.busy_poll_spin_sleeps_ = spin_sleeps;
+}
+
+void PhpWorkerStats::update_confdata_cache(uint64_t hits, uint64_t misses) noexcept {
+  internal_.confdata_cache_hits_ = hits;
+  internal_.confdata_cache_misses_ = misses;
+}
+
+void PhpWorkerStats::update_slabs(const SlabStats &conn_queries, const SlabStats &net_writers) noexcept {
+  internal_.conn_queries_slab_ = conn_queries;
+  internal_.net_writers_slab_ = net_writers;
+}
+
+void PhpWorkerStats::update_http2(uint64_t connections, uint64_t streams, uint64_t refused_streams) noexcept {
+  internal_.http2_connections_ = connections;
+  internal_.http2_streams_ = streams;
+  internal_.http2_refused_streams_ = refused_streams;
+}
+
 void PhpWorkerStats::recalc_worker_percentiles() noexcept {
   const auto now_tp = std::chrono::steady_clock::now();
   internal_.working_time_percentiles_ = calc_timed_50_95_99_percentiles(working_time_samples_, samples_tp_, now_tp);
@@ -117,6 +184,28 @@ void PhpWorkerStats::add_from(const PhpWorkerStats &from) noexcept {
   internal_.a_idle_percent_ += from.internal_.a_idle_percent_;
   internal_.script_max_memory_used_ = std::max(internal_.script_max_memory_used_, from.internal_.script_max_memory_used_);
   internal_.script_max_real_memory_used_ = std::max(internal_.script_max_real_memory_used_, from.internal_.script_max_real_memory_used_);
+  internal_.regexp_pcre_jit_executions_ += from.internal_.regexp_pcre_jit_executions_;
+  internal_.regexp_pcre_interpreted_executions_ += from.internal_.regexp_pcre_interpreted_executions_;
+  internal_.regexp_re2_executions_ += from.internal_.regexp_re2_executions_;
+  internal_.rpc_in_flight_max_per_host_ = std::max(internal_.rpc_in_flight_max_per_host_, from.internal_.rpc_in_flight_max_per_host_);
+  internal_.rpc_balanced_queries_ += from.internal_.rpc_balanced_queries_;
+  internal_.rpc_queue_max_bytes_per_target_ = std::max(internal_.rpc_queue_max_bytes_per_target_, from.internal_.rpc_queue_max_bytes_per_target_);
+  internal_.rpc_queue_max_pending_per_target_ = std::max(internal_.rpc_queue_max_pending_per_target_, from.internal_.rpc_queue_max_pending_per_target_);
+  internal_.rpc_busy_rejects_ += from.internal_.rpc_busy_rejects_;
+  internal_.shed_http_queries_ += from.internal_.shed_http_queries_;
+  internal_.shed_rpc_queries_ += from.internal_.shed_rpc_queries_;
+  internal_.script_memory_releases_ += from.internal_.script_memory_releases_;
+  internal_.heap_trims_ += from.internal_.heap_trims_;
+  internal_.http2_connections_ += from.internal_.http2_connections_;
+  internal_.http2_streams_ += from.internal_.http2_streams_;
+  internal_.http2_refused_streams_ += from.internal_.http2_refused_streams_;
+  internal_.busy_poll_spin_time_ += from.internal_.busy_poll_spin_time_;
+  internal_.busy_poll_spin_wakeups_ += from.internal_.busy_poll_spin_wakeups_;
+  internal_.busy_poll_spin_sleeps_ += from.internal_.busy_poll_spin_sleeps_;
+  internal_.confdata_cache_hits_ += from.internal_.confdata_cache_hits_;
+  internal_.confdata_cache_misses_ += from.internal_.confdata_cache_misses_;
+  add_slab_stats(internal_.conn_queries_slab_, from.internal_.conn_queries_slab_);
+  add_slab_stats(internal_.net_writers_slab_, from.internal_.net_writers_slab_);
 
   internal_.accumulated_stats_++;
   for (size_t i = 0; i < internal_.errors_.size(); ++i) {
@@ -160,6 +249,8 @@ std::string PhpWorkerStats::to_string(const std::string &pid_s) const noexcept {
   res += buf;
   sprintf(buf, "recent_idle_percent%s\t%.3lf%%\n", pid_s.c_str(), internal_.a_idle_percent_ / cnt);
   res += buf;
+  sprintf(buf, "tot_spin_time%s\t%.3lf\n", pid_s.c_str(), internal_.busy_poll_spin_time_);
+  res += buf;
 
   return res;
 }
@@ -188,6 +279,28 @@ void PhpWorkerStats::to_stats(stats_t *stats) const noexcept {
   write_percentile(stats, "memory.script_usage", internal_.script_memory_used_percentiles_);
   add_histogram_stat_long(stats, "memory.script_real_usage.max", internal_.script_max_real_memory_used_);
   write_percentile(stats, "memory.script_real_usage", internal_.script_real_memory_used_percentiles_);
+
+  add_histogram_stat_long(stats, "regexp.pcre_jit_executions", internal_.regexp_pcre_jit_executions_);
+  add_histogram_stat_long(stats, "regexp.pcre_interpreted_executions", internal_.regexp_pcre_interpreted_executions_);
+  add_histogram_stat_long(stats, "regexp.re2_executions", internal_.regexp_re2_executions_);
+
+  add_histogram_stat_long(stats, "rpc.in_flight.max_per_target", internal_.rpc_in_flight_max_per_host_);
+  add_histogram_stat_long(stats, "rpc.pool.balanced_queries", internal_.rpc_balanced_queries_);
+  add_histogram_stat_long(stats, "rpc.queue.max_bytes_per_target", internal_.rpc_queue_max_bytes_per_target_);
+  add_histogram_stat_long(stats, "rpc.queue.max_pending_per_target", internal_.rpc_queue_max_pending_per_target_);
+  add_histogram_stat_long(stats, "rpc.queue.busy_rejects", internal_.rpc_busy_rejects_);
+  add_histogram_stat_long(stats, "requests.shed.http", internal_.shed_http_queries_);
+  add_histogram_stat_long(stats, "requests.shed.rpc", internal_.shed_rpc_queries_);
+  add_histogram_stat_long(stats, "memory.released.script", internal_.script_memory_releases_);
+  add_histogram_stat_long(stats, "memory.released.heap_trims", internal_.heap_trims_);
+  add_histogram_stat_long(stats, "http2.connections", internal_.http2_connections_);
+  add_histogram_stat_long(stats, "http2.streams", internal_.http2_streams_);
+  add_histogram_stat_long(stats, "http2.refused_streams", internal_.http2_refused_streams_);
+  add_histogram_stat_double(stats, "net.busy_poll.spin_time", internal_.busy_poll_spin_time_);
+  add_histogram_stat_long(stats, "net.busy_poll.spin_wakeups", internal_.busy_poll_spin_wakeups_);
+  add_histogram_stat_long(stats, "net.busy_poll.spin_sleeps", internal_.busy_poll_spin_sleeps_);
+  write_slab_stats(stats, "net.slab.conn_queries", internal_.conn_queries_slab_);
+  write_slab_stats(stats, "net.slab.net_writers", internal_.net_writers_slab_);
 }
 
 int PhpWorkerStats::write_into(char *buffer, int buffer_len) const noexcept {
@@ -14,10 +14,27 @@
 
 class PhpWorkerStats {
 public:
+  struct SlabStats {
+    uint64_t allocs{0};
+    uint64_t used{0};
+    uint64_t blocks{0};
+    uint64_t block_refills{0};
+    uint64_t objects_in_block{0};
+  };
+
   void add_stats(double script_time, double net_time, long script_queries,
                  long max_memory_used, long max_real_memory_used, script_error_t error) noexcept;
 
   void update_idle_time(double tot_idle_time, int uptime, double average_idle_time, double average_idle_quotient) noexcept;
+  void update_regexp_executions(uint64_t pcre_jit, uint64_t pcre_interpreted, uint64_t re2) noexcept;
+  void update_rpc_in_flight(uint64_t max_per_host, uint64_t balanced_queries) noexcept;
+  void update_rpc_queues(uint64_t max_queued_bytes, uint64_t max_pending_answers, uint64_t busy_rejects) noexcept;
+  void update_shed_queries(uint64_t shed_http_queries, uint64_t shed_rpc_queries) noexcept;
+  void update_memory_releases(uint64_t script_memory_releases, uint64_t heap_trims) noexcept;
+  void update_http2(uint64_t connections, uint64_t streams, uint64_t refused_streams) noexcept;
+  void update_busy_poll(double spin_time, uint64_t spin_wakeups, uint64_t spin_sleeps) noexcept;
+  void update_confdata_cache(uint64_t hits, uint64_t misses) noexcept;
+  void update_slabs(const SlabStats &conn_queries, const SlabStats &net_writers) noexcept;
   void recalc_worker_percentiles() noexcept;
   void recalc_master_percentiles() noexcept;
 
@@ -37,6 +54,9 @@ public:
 
   long total_queries() const noexcept { return internal_.tot_queries_; }
   long total_script_queries() const noexcept { return internal_.tot_script_queries_; }
+  // the confdata cache lookups are written by the confdata stats
+  uint64_t confdata_cache_hits() const noexcept { return internal_.confdata_cache_hits_; }
+  uint64_t confdata_cache_misses() const noexcept { return internal_.confdata_cache_misses_; }
 
   void reset_memory_and_percentiles_stats() noexcept;
 
@@ -73,6 +93,37 @@ private:
     int64_t script_max_memory_used_{0};
     int64_t script_max_real_memory_used_{0};
 
+    uint64_t regexp_pcre_jit_executions_{0};
+    uint64_t regexp_pcre_interpreted_executions_{0};
+    uint64_t regexp_re2_executions_{0};
+
+    uint64_t rpc_in_flight_max_per_host_{0};
+    uint64_t rpc_balanced_queries_{0};
+
+    uint64_t rpc_queue_max_bytes_per_target_{0};
+    uint64_t rpc_queue_max_pending_per_target_{0};
+    uint64_t rpc_busy_rejects_{0};
+
+    uint64_t shed_http_queries_{0};
+    uint64_t shed_rpc_queries_{0};
+
+    uint64_t script_memory_releases_{0};
+    uint64_t heap_trims_{0};
+
+    uint64_t http2_connections_{0};
+    uint64_t http2_streams_{0};
+    uint64_t http2_refused_streams_{0};
+
+    double busy_poll_spin_time_{0};
+    uint64_t busy_poll_spin_wakeups_{0};
+    uint64_t busy_poll_spin_sleeps_{0};
+
+    uint64_t confdata_cache_hits_{0};
+    uint64_t confdata_cache_misses_{0};
+
+    SlabStats conn_queries_slab_;
+    SlabStats net_writers_slab_;
+
     uint32_t accumulated_stats_{0};
     std::array<uint32_t, static_cast<size_t>(script_error_t::errors_count)> errors_{{0}};
 
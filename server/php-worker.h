@@ -45,5 +45,13 @@ struct php_worker {
 
   long long req_id;
   int target_fd;
+  uint64_t admission_endpoint;
+  // the trace context of the caller from the rpc query header
+  uint64_t trace_id;
+  uint64_t parent_span_id;
+  // the headers and a part of the body are already sent with the chunked transfer encoding
+  bool http_streamed;
+  // bytes of a big POST body which are still in the connection
+  int http_post_unread;
 };
 
@@ -3,17 +3,25 @@ prepend(KPHP_SERVER_SOURCES ${BASE_DIR}/server/
         confdata-stats.cpp
         lease-config-parser.cpp
         lease-rpc-client.cpp
+        php-admission-control.cpp
         php-engine-vars.cpp
         php-engine.cpp
+        php-job-queue.cpp
         php-lease.cpp
         php-master.cpp
         php-master-tl-handlers.cpp
         php-mc-connections.cpp
+        php-memory-releaser.cpp
+        php-pgo-profile.cpp
         php-queries.cpp
         php-query-data.cpp
         php-runner.cpp
+        php-sampling-profiler.cpp
         php-script.cpp
         php-sql-connections.cpp
+        php-tracing.cpp
+        php-warmup.cpp
+        php-worker-metrics.cpp
         php-worker-stats.cpp)
 
 vk_add_library(kphp_server OBJECT ${KPHP_SERVER_SOURCES})
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "compiler/threading/hash-table.h"
+
+TEST(hash_table_test, test_at_and_find) {
+  TSHashTable<int> ht;
+  ASSERT_EQ(ht.find(42), nullptr);
+
+  auto *node = ht.at(42);
+  node->data = 1;
+  ASSERT_EQ(ht.at(42), node);
+  ASSERT_EQ(*ht.find(42), 1);
+
+  // the same lower bits, different upper ones: the nodes go to the nested levels
+  for (unsigned long long i = 1; i <= 100; i++) {
+    ht.at(42 + (i << 16))->data = static_cast<int>(i + 1);
+  }
+  ASSERT_EQ(ht.at(42), node);
+  for (unsigned long long i = 0; i <= 100; i++) {
+    ASSERT_EQ(*ht.find(42 + (i << 16)), static_cast<int>(i + 1));
+  }
+  ASSERT_EQ(ht.find(42 + (101ULL << 16)), nullptr);
+  ASSERT_EQ(ht.get_all().size(), 101);
+  ASSERT_EQ(ht.get_all_if([](int x) { return x % 2 == 0; }).size(), 50);
+}
+
+TEST(hash_table_test, test_concurrent_at) {
+  TSHashTable<int> ht;
+  constexpr unsigned long long keys_count = 2000000;
+  constexpr int threads_count = 8;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threads_count; t++) {
+    threads.emplace_back([&ht] {
+      for (unsigned long long key = 1; key <= keys_count; key++) {
+        auto *node = ht.at(key * 0x9E3779B97F4A7C15ULL);
+        AutoLocker<Lockable *> locker{node};
+        node->data++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // more keys than the fixed capacity of the old table
+  const auto all = ht.get_all();
+  ASSERT_EQ(all.size(), keys_count);
+  for (int x : all) {
+    ASSERT_EQ(x, threads_count);
+  }
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
 
+#include "runtime/array_functions.h"
 #include "runtime/kphp_core.h"
 
 TEST(array_test, find_no_mutate_in_empy_array) {
@@ -132,3 +135,199 @@ TEST(array_test, test_mutate_shared_map) {
   ASSERT_EQ(arr_copy.get_reference_counter(), 1);
   ASSERT_FALSE(arr_copy.is_equal_inner_pointer(arr));
 }
+
+TEST(array_test, map_insert_unset_and_order) {
+  array<int64_t> arr;
+  std::vector<std::pair<mixed, int64_t>> expected;
+  uint64_t seed = 42;
+  auto next_random = [&seed] {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return seed >> 33;
+  };
+
+  for (int64_t i = 0; i < 20000; ++i) {
+    const uint64_t r = next_random();
+    const mixed key = r % 3 ? mixed{static_cast<int64_t>(r % 3000) - 100} : mixed{string{"key_"}.append(static_cast<int64_t>(r % 1000))};
+    auto it = std::find_if(expected.begin(), expected.end(), [&key](const std::pair<mixed, int64_t> &e) { return equals(e.first, key); });
+    ASSERT_EQ(arr.isset(key), it != expected.end());
+    if (r % 5 < 2) {
+      arr.unset(key);
+      if (it != expected.end()) {
+        expected.erase(it);
+      }
+    } else {
+      arr.set_value(key, i);
+      if (it != expected.end()) {
+        it->second = i;
+      } else {
+        expected.emplace_back(key, i);
+      }
+    }
+  }
+
+  ASSERT_FALSE(arr.is_vector());
+  ASSERT_EQ(arr.count(), expected.size());
+  size_t pos = 0;
+  for (const auto &it : arr) {
+    ASSERT_TRUE(equals(it.get_key(), expected[pos].first));
+    ASSERT_EQ(it.get_value(), expected[pos].second);
+    ++pos;
+  }
+  for (const auto &e : expected) {
+    ASSERT_EQ(arr.get_value(e.first), e.second);
+  }
+  ASSERT_FALSE(arr.isset(string{"missing"}));
+  ASSERT_FALSE(arr.isset(100000));
+}
+
+TEST(array_test, map_pop_and_reinsert) {
+  array<int64_t> arr;
+  for (int64_t round = 0; round < 3; ++round) {
+    for (int64_t i = 0; i < 1000; ++i) {
+      arr.set_value(i * 7 + 1, i);
+      arr.set_value(string{"s"}.append(i), -i);
+    }
+    ASSERT_EQ(arr.count(), 2000);
+    for (int64_t i = 999; i >= 500; --i) {
+      ASSERT_EQ(arr.pop(), -i);
+      ASSERT_EQ(arr.pop(), i);
+    }
+    ASSERT_EQ(arr.count(), 1000);
+    for (int64_t i = 0; i < 500; ++i) {
+      ASSERT_EQ(arr.get_value(i * 7 + 1), i);
+      ASSERT_EQ(arr.get_value(string{"s"}.append(i)), -i);
+      ASSERT_FALSE(arr.isset((i + 500) * 7 + 1));
+    }
+  }
+}
+
+namespace {
+
+std::vector<std::vector<int64_t>> sort_test_inputs() {
+  std::vector<std::vector<int64_t>> inputs;
+  uint64_t seed = 7;
+  auto next_random = [&seed] {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<int64_t>(seed >> 1);
+  };
+  for (int64_t size : {0, 1, 2, 5, 23, 24, 100, 129, 1000, 50000}) {
+    std::vector<int64_t> random, few_unique, sorted, reversed, organ_pipe, equal;
+    for (int64_t i = 0; i < size; ++i) {
+      random.push_back(next_random() - (std::numeric_limits<int64_t>::max() / 2));
+      few_unique.push_back(next_random() % 4);
+      sorted.push_back(i);
+      reversed.push_back(size - i);
+      organ_pipe.push_back(i < size / 2 ? i : size - i);
+      equal.push_back(42);
+    }
+    inputs.insert(inputs.end(), {random, few_unique, sorted, reversed, organ_pipe, equal});
+  }
+  return inputs;
+}
+
+array<int64_t> to_array(const std::vector<int64_t> &values) {
+  array<int64_t> arr{array_size{static_cast<int64_t>(values.size()), 0, true}};
+  for (int64_t v : values) {
+    arr.push_back(v);
+  }
+  return arr;
+}
+
+} // namespace
+
+TEST(array_test, sort_vectors) {
+  for (const auto &input : sort_test_inputs()) {
+    auto expected = input;
+    std::sort(expected.begin(), expected.end());
+
+    // the radix sort and the comparison sort
+    auto ascending = to_array(input);
+    ascending.sort(std::greater<int64_t>{}, true);
+    auto by_lambda = to_array(input);
+    by_lambda.sort([](int64_t lhs, int64_t rhs) { return lhs > rhs; }, true);
+    auto descending = to_array(input);
+    descending.sort(std::less<int64_t>{}, true);
+
+    ASSERT_EQ(ascending.count(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_EQ(ascending.get_value(static_cast<int64_t>(i)), expected[i]);
+      ASSERT_EQ(by_lambda.get_value(static_cast<int64_t>(i)), expected[i]);
+      ASSERT_EQ(descending.get_value(static_cast<int64_t>(i)), expected[expected.size() - 1 - i]);
+    }
+  }
+}
+
+TEST(array_test, sort_keeps_keys) {
+  for (const auto &input : sort_test_inputs()) {
+    auto arr = to_array(input);
+    arr.sort([](int64_t lhs, int64_t rhs) { return lhs > rhs; }, false);
+
+    ASSERT_EQ(arr.count(), input.size());
+    int64_t prev = std::numeric_limits<int64_t>::min();
+    for (const auto &it : arr) {
+      ASSERT_EQ(it.get_value(), input[it.get_key().to_int()]);
+      ASSERT_LE(prev, it.get_value());
+      prev = it.get_value();
+    }
+  }
+}
+
+TEST(array_test, sort_with_inconsistent_comparator) {
+  uint64_t seed = 1;
+  auto random_compare = [&seed](int64_t, int64_t) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<int64_t>(seed >> 62) - 1;
+  };
+  for (const auto &input : sort_test_inputs()) {
+    auto arr = to_array(input);
+    arr.sort(random_compare, true);
+
+    std::vector<int64_t> result;
+    for (const auto &it : arr) {
+      result.push_back(it.get_value());
+    }
+    auto expected = input;
+    std::sort(expected.begin(), expected.end());
+    std::sort(result.begin(), result.end());
+    ASSERT_EQ(result, expected);
+  }
+}
+
+TEST(array_test, search_and_sum_numeric_vectors) {
+  auto ints = array<int64_t>::create(3, 1, 4, 1, 5);
+  ASSERT_TRUE(ints.is_vector());
+  ASSERT_TRUE(f$in_array(int64_t{4}, ints));
+  ASSERT_FALSE(f$in_array(int64_t{2}, ints, true));
+  ASSERT_TRUE(equals(f$array_search(int64_t{1}, ints), int64_t{1}));
+  ASSERT_TRUE(equals(f$array_search(int64_t{9}, ints), false));
+  ASSERT_EQ((f$array_sum<int64_t, int64_t>(ints)), 14);
+
+  auto floats = array<double>::create(0.5, 1.5, 2.0);
+  ASSERT_TRUE(f$in_array(1.5, floats));
+  ASSERT_FALSE(f$in_array(std::numeric_limits<double>::quiet_NaN(), floats));
+  ASSERT_EQ((f$array_sum<double, double>(floats)), 4.0);
+
+  // the maps are searched by the iterators, their keys are returned
+  ints.set_value(string{"key"}, 7);
+  ASSERT_FALSE(ints.is_vector());
+  ASSERT_TRUE(equals(f$array_search(int64_t{7}, ints), string{"key"}));
+  ASSERT_EQ((f$array_sum<int64_t, int64_t>(ints)), 21);
+}
+
+TEST(array_test, isset_with_precomputed_hash) {
+  const string key{"key"};
+  const string missing{"missing"};
+  array<mixed> arr;
+  ASSERT_FALSE(arr.isset(key, key.hash()));
+
+  arr.set_value(key, mixed{1});
+  arr.set_value(string{"null"}, mixed{});
+  ASSERT_TRUE(arr.isset(key, key.hash()));
+  ASSERT_FALSE(arr.isset(missing, missing.hash()));
+  ASSERT_FALSE(arr.isset(string{"null"}, string{"null"}.hash()));
+
+  const mixed m{arr};
+  ASSERT_TRUE(m.isset(key, key.hash()));
+  ASSERT_FALSE(m.isset(missing, missing.hash()));
+  ASSERT_FALSE(mixed{}.isset(key, key.hash()));
+}
@@ -0,0 +1,34 @@
+#include <array>
+#include <benchmark/benchmark.h>
+
+#include "runtime/interface.h"
+#include "server/php-engine-vars.h"
+
+namespace {
+
+// the benchmarks allocate much more than the tests, but free everything between the iterations
+std::array<uint8_t, 256 * 1024 * 1024> script_memory;
+
+} // namespace
+
+int main(int argc, char **argv) {
+  pid = 0;
+  logname_id = 0;
+  workers_n = 1;
+
+  global_init_runtime_libs();
+  global_init_script_allocator();
+  init_runtime_environment(nullptr, script_memory.data(), script_memory.size());
+
+  php_disable_warnings = true;
+  php_warning_level = 0;
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+
+  free_runtime_environment();
+  return 0;
+}
@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "runtime/allocator.h"
+
+static void BM_allocate_deallocate(benchmark::State &state) {
+  const auto size = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    void *mem = dl::allocate(size);
+    benchmark::DoNotOptimize(mem);
+    dl::deallocate(mem, size);
+  }
+}
+BENCHMARK(BM_allocate_deallocate)->RangeMultiplier(4)->Range(8, 64 << 10);
+
+// many live blocks of the mixed sizes freed in the reverse order, like the script variables
+static void BM_allocate_batch_lifo(benchmark::State &state) {
+  std::vector<std::pair<void *, size_t>> blocks(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      const size_t size = 16 + (i * 37) % 1024;
+      blocks[i] = {dl::allocate(size), size};
+    }
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+      dl::deallocate(it->first, it->second);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_allocate_batch_lifo)->Range(64, 16 << 10);
+
+// the same blocks freed in the allocation order, which fragments the free lists
+static void BM_allocate_batch_fifo(benchmark::State &state) {
+  std::vector<std::pair<void *, size_t>> blocks(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      const size_t size = 16 + (i * 37) % 1024;
+      blocks[i] = {dl::allocate(size), size};
+    }
+    for (const auto &block : blocks) {
+      dl::deallocate(block.first, block.second);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_allocate_batch_fifo)->Range(64, 16 << 10);
+
+static void BM_reallocate_growing(benchmark::State &state) {
+  for (auto _ : state) {
+    size_t size = 16;
+    void *mem = dl::allocate(size);
+    while (size < static_cast<size_t>(state.range(0))) {
+      mem = dl::reallocate(mem, size * 2, size);
+      size *= 2;
+    }
+    dl::deallocate(mem, size);
+  }
+}
+BENCHMARK(BM_reallocate_growing)->Range(1 << 10, 1 << 20);
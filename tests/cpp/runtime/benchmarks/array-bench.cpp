@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/kphp_core.h"
+
+namespace {
+
+array<int64_t> make_vector(int64_t size) {
+  array<int64_t> arr;
+  for (int64_t i = 0; i < size; ++i) {
+    arr.push_back(i);
+  }
+  return arr;
+}
+
+array<int64_t> make_int_map(int64_t size) {
+  array<int64_t> arr;
+  for (int64_t i = 0; i < size; ++i) {
+    arr.set_value(i * 7919, i);
+  }
+  return arr;
+}
+
+array<string> make_string_keys(int64_t size) {
+  array<string> keys;
+  for (int64_t i = 0; i < size; ++i) {
+    keys.push_back(string{"key_"}.append(i));
+  }
+  return keys;
+}
+
+} // namespace
+
+static void BM_array_vector_push_back(benchmark::State &state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(make_vector(state.range(0)));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_array_vector_push_back)->Range(8, 64 << 10);
+
+static void BM_array_vector_iterate(benchmark::State &state) {
+  const auto arr = make_vector(state.range(0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto &it : arr) {
+      sum += it.get_value();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_array_vector_iterate)->Range(8, 64 << 10);
+
+static void BM_array_int_map_insert(benchmark::State &state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(make_int_map(state.range(0)));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_array_int_map_insert)->Range(8, 64 << 10);
+
+static void BM_array_int_map_lookup(benchmark::State &state) {
+  const auto arr = make_int_map(state.range(0));
+  for (auto _ : state) {
+    int64_t found = 0;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      found += arr.isset(i * 7919);
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_array_int_map_lookup)->Range(8, 64 << 10);
+
+static void BM_array_int_map_iterate(benchmark::State &state) {
+  const auto arr = make_int_map(state.range(0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto &it : arr) {
+      sum += it.get_int_key();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_array_int_map_iterate)->Range(8, 64 << 10);
+
+static void BM_array_string_map_insert(benchmark::State &state) {
+  const auto keys = make_string_keys(state.range(0));
+  for (auto _ : state) {
+    array<int64_t> arr;
+    for (const auto &key : keys) {
+      arr.set_value(key.get_value(), key.get_int_key());
+    }
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_array_string_map_insert)->Range(8, 64 << 10);
+
+static void BM_array_string_map_lookup(benchmark::State &state) {
+  const auto keys = make_string_keys(state.range(0));
+  array<int64_t> arr;
+  for (const auto &key : keys) {
+    arr.set_value(key.get_value(), key.get_int_key());
+  }
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto &key : keys) {
+      sum += arr.get_value(key.get_value());
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_array_string_map_lookup)->Range(8, 64 << 10);
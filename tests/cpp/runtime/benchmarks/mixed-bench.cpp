@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/kphp_core.h"
+
+static void BM_mixed_int_to_string(benchmark::State &state) {
+  const mixed value{int64_t{1234567890}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value.to_string());
+  }
+}
+BENCHMARK(BM_mixed_int_to_string);
+
+static void BM_mixed_float_to_string(benchmark::State &state) {
+  const mixed value{3.14159265358979};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value.to_string());
+  }
+}
+BENCHMARK(BM_mixed_float_to_string);
+
+static void BM_mixed_string_to_int(benchmark::State &state) {
+  const mixed value{string{"1234567890"}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value.to_int());
+  }
+}
+BENCHMARK(BM_mixed_string_to_int);
+
+static void BM_mixed_string_to_float(benchmark::State &state) {
+  const mixed value{string{"12345.6789"}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value.to_float());
+  }
+}
+BENCHMARK(BM_mixed_string_to_float);
+
+static void BM_mixed_compare(benchmark::State &state) {
+  const mixed lhs{string{"12345"}};
+  const mixed rhs{int64_t{12345}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(eq2(lhs, rhs));
+    benchmark::DoNotOptimize(equals(lhs, rhs));
+  }
+}
+BENCHMARK(BM_mixed_compare);
+
+static void BM_mixed_array_set_get(benchmark::State &state) {
+  for (auto _ : state) {
+    mixed arr{array<mixed>{}};
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      arr.set_value(i, i);
+    }
+    int64_t sum = 0;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      sum += arr.get_value(i).to_int();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_mixed_array_set_get)->Range(8, 8 << 10);
@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/kphp_core.h"
+#include "runtime/regexp.h"
+
+namespace {
+
+string make_text(int64_t size) {
+  string text;
+  for (int64_t i = 0; text.size() < size; ++i) {
+    text.append("lorem ipsum dolor sit amet, user").append(i).append("@example.com, ");
+  }
+  return text;
+}
+
+} // namespace
+
+static void BM_preg_match(benchmark::State &state) {
+  const regexp re{string{"/(\\w+)@example\\.com/"}};
+  const string text = make_text(state.range(0));
+  mixed matches;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$preg_match(re, text, matches));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_preg_match)->Range(64, 64 << 10);
+
+static void BM_preg_match_all(benchmark::State &state) {
+  const regexp re{string{"/(\\w+)@example\\.com/"}};
+  const string text = make_text(state.range(0));
+  mixed matches;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$preg_match_all(re, text, matches));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_preg_match_all)->Range(64, 64 << 10);
+
+static void BM_preg_replace(benchmark::State &state) {
+  const regexp re{string{"/\\d+/"}};
+  const string replacement{"N"};
+  const string text = make_text(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$preg_replace(re, replacement, text));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_preg_replace)->Range(64, 64 << 10);
+
+static void BM_preg_split(benchmark::State &state) {
+  const regexp re{string{"/,\\s*/"}};
+  const string text = make_text(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$preg_split(re, text));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_preg_split)->Range(64, 64 << 10);
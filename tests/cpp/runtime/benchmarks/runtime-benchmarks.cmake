@@ -0,0 +1,21 @@
+prepend(RUNTIME_BENCHMARKS_SOURCES ${BASE_DIR}/tests/cpp/runtime/
+        _runtime-link-stubs.cpp
+        benchmarks/_runtime-bench-main.cpp
+        benchmarks/allocator-bench.cpp
+        benchmarks/array-bench.cpp
+        benchmarks/mixed-bench.cpp
+        benchmarks/regexp-bench.cpp
+        benchmarks/serialization-bench.cpp
+        benchmarks/sort-bench.cpp
+        benchmarks/string-bench.cpp)
+
+add_executable(kphp-runtime-bench ${RUNTIME_BENCHMARKS_SOURCES})
+target_link_libraries(kphp-runtime-bench PRIVATE benchmark::benchmark ${RUNTIME_LIBS} ${RUNTIME_LINK_TEST_LIBS} vk::popular_common)
+target_link_options(kphp-runtime-bench PRIVATE ${NO_PIE})
+set_target_properties(kphp-runtime-bench PROPERTIES FOLDER tests)
+
+# the json report can be compared with the report of another release by tools/compare.py of google benchmark
+add_custom_target(run-kphp-runtime-bench
+                  COMMAND kphp-runtime-bench --benchmark_out=${CMAKE_BINARY_DIR}/kphp-runtime-bench.json --benchmark_out_format=json
+                  DEPENDS kphp-runtime-bench
+                  USES_TERMINAL)
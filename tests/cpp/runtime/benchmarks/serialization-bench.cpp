@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/json-functions.h"
+#include "runtime/kphp_core.h"
+#include "runtime/misc.h"
+#include "runtime/msgpack-serialization.h"
+
+namespace {
+
+// resembles a typical api response: the list of the objects with a few scalar fields
+mixed make_payload(int64_t size) {
+  array<mixed> items;
+  for (int64_t i = 0; i < size; ++i) {
+    array<mixed> item;
+    item.set_value(string{"id"}, i);
+    item.set_value(string{"name"}, string{"user "}.append(i));
+    item.set_value(string{"rating"}, static_cast<double>(i) / 7.0);
+    item.set_value(string{"is_active"}, i % 2 == 0);
+    item.set_value(string{"tags"}, array<mixed>::create(string{"a"}, string{"b"}, int64_t{42}));
+    items.push_back(item);
+  }
+  return items;
+}
+
+} // namespace
+
+static void BM_serialize(benchmark::State &state) {
+  const mixed payload = make_payload(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$serialize(payload));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_serialize)->Range(8, 1 << 10);
+
+static void BM_unserialize(benchmark::State &state) {
+  const string serialized = f$serialize(make_payload(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$unserialize(serialized));
+  }
+  state.SetBytesProcessed(state.iterations() * serialized.size());
+}
+BENCHMARK(BM_unserialize)->Range(8, 1 << 10);
+
+static void BM_json_encode(benchmark::State &state) {
+  const mixed payload = make_payload(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$json_encode(payload));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_json_encode)->Range(8, 1 << 10);
+
+static void BM_json_decode(benchmark::State &state) {
+  const string json = f$json_encode(make_payload(state.range(0))).val();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$json_decode(json, true));
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_json_decode)->Range(8, 1 << 10);
+
+static void BM_msgpack_serialize(benchmark::State &state) {
+  const mixed payload = make_payload(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$msgpack_serialize(payload));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_msgpack_serialize)->Range(8, 1 << 10);
+
+static void BM_msgpack_deserialize(benchmark::State &state) {
+  const string packed = f$msgpack_serialize(make_payload(state.range(0))).val();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$msgpack_deserialize(packed));
+  }
+  state.SetBytesProcessed(state.iterations() * packed.size());
+}
+BENCHMARK(BM_msgpack_deserialize)->Range(8, 1 << 10);
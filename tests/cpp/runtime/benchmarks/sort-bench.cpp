@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/array_functions.h"
+#include "runtime/kphp_core.h"
+
+namespace {
+
+// a deterministic shuffle, so that the runs are comparable
+int64_t shuffled(int64_t i) {
+  return (i * 2654435761) % 1000003;
+}
+
+} // namespace
+
+static void BM_sort_ints(benchmark::State &state) {
+  array<int64_t> source;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    source.push_back(shuffled(i));
+  }
+  for (auto _ : state) {
+    // the copy is separated from the source by the sort itself, it is cheap comparing to the sort
+    array<int64_t> arr = source;
+    f$sort(arr);
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_sort_ints)->Range(8, 64 << 10);
+
+static void BM_sort_strings(benchmark::State &state) {
+  array<string> source;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    source.push_back(string{"item_"}.append(shuffled(i)));
+  }
+  for (auto _ : state) {
+    array<string> arr = source;
+    f$sort(arr);
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_sort_strings)->Range(8, 64 << 10);
+
+static void BM_asort_mixed(benchmark::State &state) {
+  array<mixed> source;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    source.set_value(string{"key_"}.append(i), i % 3 ? mixed{shuffled(i)} : mixed{string{shuffled(i)}});
+  }
+  for (auto _ : state) {
+    array<mixed> arr = source;
+    f$asort(arr);
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_asort_mixed)->Range(8, 64 << 10);
@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/array_functions.h"
+#include "runtime/kphp_core.h"
+#include "runtime/string_functions.h"
+
+static void BM_string_append(benchmark::State &state) {
+  const string part{"some string part, "};
+  for (auto _ : state) {
+    string s;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      s.append(part).append(i);
+    }
+    benchmark::DoNotOptimize(s);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_string_append)->Range(8, 8 << 10);
+
+static void BM_string_concat(benchmark::State &state) {
+  const string lhs{"the left part of the string"};
+  const string rhs{"the right part of the string"};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs + rhs);
+  }
+}
+BENCHMARK(BM_string_concat);
+
+static void BM_string_buffer_append(benchmark::State &state) {
+  const string part{"some string part, "};
+  for (auto _ : state) {
+    static_SB.clean();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      static_SB << part << i << ' ' << 0.25;
+    }
+    benchmark::DoNotOptimize(static_SB.str());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_string_buffer_append)->Range(8, 8 << 10);
+
+static void BM_string_hash(benchmark::State &state) {
+  const string s{static_cast<string::size_type>(state.range(0)), 'x'};
+  for (auto _ : state) {
+    // a copy doesn't cache the hash
+    benchmark::DoNotOptimize(string{s.c_str(), s.size()}.hash());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_string_hash)->Range(8, 4 << 10);
+
+static void BM_string_implode(benchmark::State &state) {
+  array<string> parts;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    parts.push_back(string{i});
+  }
+  const string glue{", "};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$implode(glue, parts));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_string_implode)->Range(8, 8 << 10);
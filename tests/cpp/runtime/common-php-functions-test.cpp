@@ -1,3 +1,4 @@
+#include <cmath>
 #include <gtest/gtest.h>
 
 #include "common/php-functions.h"
@@ -147,3 +148,33 @@ TEST(test_php_try_to_integer, long_strings) {
   ASSERT_FALSE(php_try_to_int_wrapper("-784894841981984984891498", x));
   ASSERT_FALSE(php_try_to_int_wrapper("-9223372036854775809", x));
 }
+
+TEST(test_php_try_parse_8_digits, digits) {
+  uint32_t value = 0;
+  ASSERT_TRUE(php_try_parse_8_digits("12345678", &value));
+  ASSERT_EQ(value, 12345678);
+  ASSERT_TRUE(php_try_parse_8_digits("00000000", &value));
+  ASSERT_EQ(value, 0);
+  ASSERT_TRUE(php_try_parse_8_digits("99999999", &value));
+  ASSERT_EQ(value, 99999999);
+  ASSERT_FALSE(php_try_parse_8_digits("1234567:", &value));
+  ASSERT_FALSE(php_try_parse_8_digits("/2345678", &value));
+  ASSERT_FALSE(php_try_parse_8_digits("1234 678", &value));
+  ASSERT_FALSE(php_try_parse_8_digits("123456e8", &value));
+}
+
+TEST(test_php_strtod, same_as_strtod) {
+  for (const char *s : {"0", "-0", "1.5", "-.5", "1e10", "1.5E-7", "12abc", "1e", "1e+", "1e400", "-1e-400", "0x1A", "inf", "-nan",
+                        " 12", "+12", "-", ".", "", "123456789012345678901234567890", "2.2250738585072011e-308"}) {
+    char *strtod_end = nullptr;
+    char *php_strtod_end = nullptr;
+    const double expected = strtod(s, &strtod_end);
+    const double result = php_strtod(s, s + strlen(s), &php_strtod_end);
+    ASSERT_EQ(strtod_end, php_strtod_end) << s;
+    if (std::isnan(expected)) {
+      ASSERT_TRUE(std::isnan(result)) << s;
+    } else {
+      ASSERT_EQ(expected, result) << s;
+    }
+  }
+}
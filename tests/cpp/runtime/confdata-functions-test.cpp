@@ -42,6 +42,14 @@ void init_global_confdata_confdata() {
     std::make_pair(mixed{string{"b.two_2b"}}, mixed{string{"b_one_value_2"}}),
   };
 
+  confdata_sample_storage[string{"_ids."}] = array<mixed>{
+    std::make_pair(mixed{30}, mixed{string{"id_30"}}),
+    std::make_pair(mixed{-5}, mixed{string{"id_-5"}}),
+    std::make_pair(mixed{string{"name"}}, mixed{string{"not_an_id"}}),
+    std::make_pair(mixed{10}, mixed{string{"id_10"}}),
+    std::make_pair(mixed{20}, mixed{string{"id_20"}}),
+  };
+
   global_manager.get_current().reset(std::move(confdata_sample_storage));
 
   init_confdata_functions_lib();
@@ -69,6 +77,34 @@ TEST(confdata_functions_test, test_confdata_get_value) {
   ASSERT_TRUE(equals(f$confdata_get_value(string{"_two dot.b.two_2b"}), string{"b_one_value_2"}));
 }
 
+TEST(confdata_functions_test, test_confdata_get_int_and_string) {
+  init_global_confdata_confdata();
+
+  ASSERT_EQ(f$confdata_get_int(string{"unknown_key"}, 42), 42);
+  ASSERT_EQ(f$confdata_get_int(string{"_one dot.one_2"}), 0);
+  ASSERT_TRUE(f$confdata_get_string(string{"_one dot.3"}) == string{"one_value_3"});
+  ASSERT_TRUE(f$confdata_get_string(string{"_two dot.a.two_1a"}, string{"default"}) == string{"a_one_value_1"});
+  ASSERT_TRUE(f$confdata_get_string(string{"_two dot.c.one_1c"}, string{"default"}) == string{"default"});
+}
+
+TEST(confdata_functions_test, test_confdata_worker_cache) {
+  init_global_confdata_confdata();
+
+  const auto stats_before = confdata_get_worker_cache_stats();
+  ASSERT_TRUE(equals(f$confdata_get_value(string{"_two dot.a.two_2a"}), string{"a_one_value_2"}));
+  ASSERT_TRUE(equals(f$confdata_get_value(string{"_two dot.a.two_2a"}), string{"a_one_value_2"}));
+  ASSERT_TRUE(f$confdata_get_string(string{"_two dot.a.two_2a"}) == string{"a_one_value_2"});
+  // the misses are not cached
+  ASSERT_TRUE(f$confdata_get_value(string{"_two dot.a.two_3a"}).is_null());
+  ASSERT_TRUE(f$confdata_get_value(string{"_two dot.a.two_3a"}).is_null());
+  // the long keys bypass the cache
+  ASSERT_TRUE(f$confdata_get_value(string{"_one dot.a_key_that_is_too_long_to_be_kept_in_the_cache"}).is_null());
+
+  const auto &stats_after = confdata_get_worker_cache_stats();
+  ASSERT_EQ(stats_after.hits - stats_before.hits, 2U);
+  ASSERT_EQ(stats_after.misses - stats_before.misses, 3U);
+}
+
 TEST(confdata_functions_test, test_confdata_get_values_by_unknown_wildcard) {
   init_global_confdata_confdata();
 
@@ -128,3 +164,33 @@ TEST(confdata_functions_test, test_confdata_get_values_by_bad_wildcard) {
     ASSERT_EQ(f$confdata_get_values_by_any_wildcard(string{bad_wildcard}).count(), 0);
   }
 }
+
+TEST(confdata_functions_test, test_confdata_get_values_by_key_range) {
+  init_global_confdata_confdata();
+
+  // the int keys only, in the ascending order
+  const auto all = f$confdata_get_values_by_key_range(string{"_ids."}, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+  ASSERT_EQ(all.count(), 4);
+  int64_t prev_key = std::numeric_limits<int64_t>::min();
+  for (const auto &element : all) {
+    ASSERT_FALSE(element.is_string_key());
+    ASSERT_LT(prev_key, element.get_key().as_int());
+    prev_key = element.get_key().as_int();
+  }
+
+  ASSERT_TRUE(equals(f$confdata_get_values_by_key_range(string{"_ids."}, 10, 20), array<mixed>{
+    std::make_pair(mixed{10}, mixed{string{"id_10"}}),
+    std::make_pair(mixed{20}, mixed{string{"id_20"}})
+  }));
+  ASSERT_TRUE(equals(f$confdata_get_values_by_key_range(string{"_ids."}, -100, 0), array<mixed>{
+    std::make_pair(mixed{-5}, mixed{string{"id_-5"}})
+  }));
+  ASSERT_TRUE(equals(f$confdata_get_values_by_key_range(string{"_one dot."}, 0, 3), array<mixed>{
+    std::make_pair(mixed{3}, mixed{string{"one_value_3"}})
+  }));
+
+  ASSERT_EQ(f$confdata_get_values_by_key_range(string{"_ids."}, 11, 19).count(), 0);
+  ASSERT_EQ(f$confdata_get_values_by_key_range(string{"_ids."}, 20, 10).count(), 0);
+  ASSERT_EQ(f$confdata_get_values_by_key_range(string{"_unknown."}, 0, 100).count(), 0);
+  ASSERT_EQ(f$confdata_get_values_by_key_range(string{"_ids"}, 0, 100).count(), 0);
+}
@@ -94,3 +94,45 @@ TEST(inter_process_mutex_test, test_try_lock_unlock_with_thread) {
 
   t.join();
 }
+
+TEST(inter_process_mutex_test, test_stats) {
+  inter_process_mutex mutex;
+  mutex.lock();
+  mutex.unlock();
+  ASSERT_TRUE(mutex.try_lock());
+  mutex.unlock();
+  ASSERT_EQ(mutex.get_stats().acquisitions.load(), 2);
+  ASSERT_EQ(mutex.get_stats().contentions.load(), 0);
+
+  std::thread t{[&mutex] {
+    with_this_pid([&mutex] { mutex.lock(); });
+
+    std::thread t2{[&mutex] {
+      with_this_pid([&mutex] { mutex.lock(); });
+      with_this_pid([&mutex] { mutex.unlock(); });
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    with_this_pid([&mutex] { mutex.unlock(); });
+    t2.join();
+  }};
+  t.join();
+
+  ASSERT_EQ(mutex.get_stats().acquisitions.load(), 4);
+  ASSERT_EQ(mutex.get_stats().contentions.load(), 1);
+  ASSERT_GT(mutex.get_stats().wait_time_ns.load(), 0);
+}
+
+TEST(inter_process_seqlock_test, test_read_retry) {
+  inter_process_seqlock seqlock;
+  uint32_t seq = seqlock.read_begin();
+  ASSERT_FALSE(seqlock.read_retry(seq));
+
+  seqlock.write_begin();
+  seqlock.write_end();
+  ASSERT_TRUE(seqlock.read_retry(seq));
+  ASSERT_EQ(seqlock.get_read_retries(), 1);
+
+  seq = seqlock.read_begin();
+  ASSERT_FALSE(seqlock.read_retry(seq));
+}
@@ -79,6 +79,24 @@ TEST(inter_process_resource_control_test, test_force_release_all_resources) {
   }
 }
 
+TEST(inter_process_resource_control_test, test_slots_of_other_master) {
+  InterProcessResourceControl<2> resource_control;
+
+  set_pid_and_user_id(1);
+  master_slot_id = 1;
+  ASSERT_EQ(resource_control.acquire_active_resource_id(), 0);
+
+  // the worker with the same logname_id of the other master has its own slot
+  master_slot_id = 0;
+  ASSERT_FALSE(resource_control.is_resource_unused(0));
+  ASSERT_EQ(resource_control.acquire_active_resource_id(), 0);
+  resource_control.release(0);
+  ASSERT_FALSE(resource_control.is_resource_unused(0));
+
+  resource_control.force_release_resources_of_other_master();
+  ASSERT_TRUE(resource_control.is_resource_unused(0));
+}
+
 TEST(inter_process_resource_manager_test, test_constructor_destructor) {
   set_pid_and_user_id(1);
   InterProcessResourceManager<ResourceStub, 3> resource_manager;
@@ -223,3 +241,34 @@ TEST(inter_process_resource_manager_test, acquire_force_release_clear_scenario)
   ASSERT_EQ(r21->value, 0);
   ASSERT_EQ(r22->value, 0);
 }
+
+TEST(inter_process_resource_manager_test, test_attach_in_next_master) {
+  using Manager = InterProcessResourceManager<ResourceStub, 2>;
+  alignas(Manager::ControlBlock) static char control_block_memory[sizeof(Manager::ControlBlock)];
+  const auto init_resource = [](ResourceStub &resource, uint32_t resource_id) { resource.init(static_cast<int>(resource_id) + 1); };
+
+  set_pid_and_user_id(1);
+  master_slot_id = 0;
+  Manager previous_master;
+  previous_master.init_in_memory(control_block_memory, false, init_resource);
+  ASSERT_TRUE(previous_master.try_switch_to_next_unused_resource(222));
+
+  set_pid_and_user_id(2);
+  ASSERT_EQ(previous_master.acquire_current_resource()->value, 222);
+
+  set_pid_and_user_id(3);
+  master_slot_id = 1;
+  Manager next_master;
+  next_master.init_in_memory(control_block_memory, true, init_resource);
+  // the active resource is kept
+  ASSERT_EQ(next_master.get_current_resource().value, 2);
+
+  // the worker of the previous master still uses the active resource
+  ASSERT_TRUE(next_master.try_switch_to_next_unused_resource(333));
+  ASSERT_FALSE(next_master.is_next_resource_unused());
+  next_master.force_release_resources_of_other_master();
+  ASSERT_TRUE(next_master.is_next_resource_unused());
+
+  next_master.destroy();
+  master_slot_id = 0;
+}
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+
+#include "common/string-kernels.h"
+#include "runtime/mbstring.h"
+
+namespace {
+
+const string UTF8{"UTF-8"};
+
+// mostly ascii text with some cyrillic words, like our usual api responses
+std::string make_realistic_text(size_t len) {
+  const char *words[] = {"id", "name", "\"", "user", ":", "12345", ", ", "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", "https://vk.com/", " ", "{", "}"};
+  std::string text;
+  for (size_t i = 0; text.size() < len; ++i) {
+    const size_t word = (i * 7 + i / 3) % 12;
+    // one cyrillic word per ~20
+    text += words[word == 7 && i % 20 != 0 ? 0 : word];
+  }
+  return text;
+}
+
+template<class F>
+double measure_ns_per_byte(size_t len, size_t iterations, const F &f) {
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    f();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations * len);
+}
+
+} // namespace
+
+TEST(mbstring_test, test_mb_check_encoding) {
+  ASSERT_TRUE(f$mb_check_encoding(string{"hello"}, UTF8));
+  ASSERT_TRUE(f$mb_check_encoding(string{"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82"}, UTF8));
+  ASSERT_FALSE(f$mb_check_encoding(string{"\xd0\xbf\xd1"}, UTF8));
+  ASSERT_FALSE(f$mb_check_encoding(string{"\xed\xa0\x80"}, UTF8));
+  // everything after a zero byte is ignored
+  ASSERT_TRUE(f$mb_check_encoding(string{"ok\0\xff", 4}, UTF8));
+}
+
+TEST(mbstring_test, test_mb_strlen) {
+  ASSERT_EQ(f$mb_strlen(string{}, UTF8), 0);
+  ASSERT_EQ(f$mb_strlen(string{"hello world, hello world"}, UTF8), 24);
+  ASSERT_EQ(f$mb_strlen(string{"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 hello"}, UTF8), 12);
+  ASSERT_EQ(f$mb_strlen(string{"abc\0def", 7}, UTF8), 3);
+}
+
+TEST(mbstring_test, test_mb_substr) {
+  const string ascii{"hello world, hello world"};
+  ASSERT_STREQ(f$mb_substr(ascii, 6, 5, UTF8).c_str(), "world");
+  ASSERT_STREQ(f$mb_substr(ascii, -5, mixed{}, UTF8).c_str(), "world");
+  ASSERT_STREQ(f$mb_substr(ascii, 0, -7, UTF8).c_str(), "hello world, hello");
+  ASSERT_TRUE(f$mb_substr(ascii, -100, 5, UTF8).empty());
+  ASSERT_TRUE(f$mb_substr(ascii, 100, 5, UTF8).empty());
+
+  const string cyrillic{"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 hello"};
+  ASSERT_STREQ(f$mb_substr(cyrillic, 1, 3, UTF8).c_str(), "\xd1\x80\xd0\xb8\xd0\xb2");
+  ASSERT_STREQ(f$mb_substr(cyrillic, -5, mixed{}, UTF8).c_str(), "hello");
+}
+
+TEST(mbstring_test, test_mb_strpos) {
+  ASSERT_EQ(f$mb_strpos(string{"hello world"}, string{"world"}, 0, UTF8).val(), 6);
+  ASSERT_FALSE(f$mb_strpos(string{"hello world"}, string{"world"}, 7, UTF8).has_value());
+  ASSERT_EQ(f$mb_strpos(string{"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 world"}, string{"world"}, 0, UTF8).val(), 7);
+}
+
+// run with --gtest_also_run_disabled_tests to compare the scalar and the vectorized utf-8 kernels
+TEST(mbstring_test, DISABLED_benchmark_utf8_kernels) {
+  for (size_t len : {64, 1024, 64 * 1024}) {
+    const std::string text = make_realistic_text(len);
+    const size_t iterations = 64 * 1024 * 1024 / len;
+    size_t sink = 0;
+
+    const double validate_old = measure_ns_per_byte(len, iterations, [&] { sink += utf8_validate_generic(text.data(), text.size()); });
+    const double validate_new = measure_ns_per_byte(len, iterations, [&] { sink += utf8_validate(text.data(), text.size()); });
+    const double count_old = measure_ns_per_byte(len, iterations, [&] { sink += utf8_code_points_count_generic(text.data(), text.size()); });
+    const double count_new = measure_ns_per_byte(len, iterations, [&] { sink += utf8_code_points_count(text.data(), text.size()); });
+
+    fprintf(stderr, "len %6zu: validate %.3f -> %.3f ns/byte, count %.3f -> %.3f ns/byte (%zu)\n",
+            len, validate_old, validate_new, count_old, count_new, sink);
+  }
+}
@@ -17,6 +17,20 @@ TEST(memory_chunk_tree_test, empty) {
   ASSERT_FALSE(mem_list.flush());
 }
 
+TEST(memory_chunk_tree_test, largest_chunk_size) {
+  memory_resource::details::memory_chunk_tree mem_chunk_tree;
+  ASSERT_EQ(mem_chunk_tree.get_largest_chunk_size(), 0);
+
+  char some_memory[1024];
+  mem_chunk_tree.insert(some_memory, 100);
+  mem_chunk_tree.insert(some_memory + 200, 300);
+  mem_chunk_tree.insert(some_memory + 600, 150);
+  ASSERT_EQ(mem_chunk_tree.get_largest_chunk_size(), 300);
+
+  ASSERT_TRUE(mem_chunk_tree.extract(300));
+  ASSERT_EQ(mem_chunk_tree.get_largest_chunk_size(), 150);
+}
+
 TEST(memory_chunk_tree_test, hard_reset) {
   memory_resource::details::memory_chunk_tree mem_chunk_tree;
 
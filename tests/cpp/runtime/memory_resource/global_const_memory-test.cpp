@@ -0,0 +1,45 @@
+#include <cstring>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "runtime/memory_resource/global_const_memory.h"
+
+TEST(global_const_memory_test, allocate_and_seal) {
+  memory_resource::global_const_memory const_memory;
+  ASSERT_FALSE(const_memory.is_enabled());
+
+  const_memory.enter();
+  ASSERT_TRUE(const_memory.is_enabled());
+  auto *mem1 = static_cast<char *>(const_memory.allocate(100));
+  void *mem2 = const_memory.allocate0(5000);
+  ASSERT_TRUE(mem1);
+  ASSERT_TRUE(mem2);
+  ASSERT_TRUE(const_memory.owns(mem1));
+  ASSERT_TRUE(const_memory.owns(mem2));
+  std::memset(mem1, 'x', 100);
+
+  // the temporaries of the init are reused
+  const_memory.deallocate(mem2, 5000);
+  ASSERT_EQ(const_memory.allocate(5000), mem2);
+
+  int x = 0;
+  ASSERT_FALSE(const_memory.owns(&x));
+  const_memory.leave();
+  ASSERT_FALSE(const_memory.is_enabled());
+
+  const_memory.seal();
+  const auto page_size = static_cast<size_t>(getpagesize());
+  ASSERT_EQ(const_memory.get_sealed_size(), (5000 + 104 + page_size - 1) / page_size * page_size);
+  ASSERT_FALSE(const_memory.owns(mem1));
+  // the sealed memory is still readable
+  ASSERT_EQ(mem1[99], 'x');
+
+  // the next init starts a new segment
+  const_memory.enter();
+  void *mem3 = const_memory.allocate(8);
+  ASSERT_TRUE(const_memory.owns(mem3));
+  ASSERT_NE(mem3, mem1);
+  const_memory.leave();
+  const_memory.seal();
+  ASSERT_EQ(const_memory.get_sealed_size(), (5000 + 104 + page_size - 1) / page_size * page_size + page_size);
+}
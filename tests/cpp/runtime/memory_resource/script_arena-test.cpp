@@ -0,0 +1,118 @@
+#include <array>
+#include <cstring>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "runtime/memory_resource/script_arena.h"
+#include "runtime/memory_resource/unsynchronized_pool_resource.h"
+
+TEST(script_arena_test, disabled_outside_of_scope) {
+  memory_resource::script_arena arena;
+  ASSERT_FALSE(arena.is_enabled());
+
+  int x = 0;
+  ASSERT_FALSE(arena.owns(&x));
+}
+
+TEST(script_arena_test, bulk_free_on_leave) {
+  std::array<char, 1024 * 1024> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+  resource.init(some_memory.data(), some_memory.size());
+  memory_resource::script_arena arena;
+
+  const auto scope_mark = arena.enter(resource);
+  ASSERT_TRUE(arena.is_enabled());
+
+  void *mem1 = arena.allocate(10);
+  void *mem2 = arena.allocate(100);
+  ASSERT_TRUE(mem1);
+  ASSERT_TRUE(mem2);
+  ASSERT_EQ(static_cast<char *>(mem2) - static_cast<char *>(mem1), 16);
+  ASSERT_TRUE(arena.owns(mem1));
+  ASSERT_TRUE(arena.owns(mem2));
+  ASSERT_EQ(arena.get_blocks_allocated(), 1);
+  const size_t memory_used_in_scope = resource.get_memory_stats().memory_used;
+  ASSERT_GT(memory_used_in_scope, 0);
+
+  // the pieces in the middle are not reused
+  arena.deallocate(mem1, 10);
+  ASSERT_NE(arena.allocate(8), mem1);
+
+  arena.leave(scope_mark);
+  ASSERT_FALSE(arena.is_enabled());
+  ASSERT_FALSE(arena.owns(mem1));
+  ASSERT_EQ(resource.get_memory_stats().memory_used, 0);
+}
+
+TEST(script_arena_test, last_piece_is_reused) {
+  std::array<char, 1024 * 1024> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+  resource.init(some_memory.data(), some_memory.size());
+  memory_resource::script_arena arena;
+
+  const auto scope_mark = arena.enter(resource);
+  void *mem1 = arena.allocate(24);
+  arena.deallocate(mem1, 24);
+  ASSERT_EQ(arena.allocate(32), mem1);
+
+  // the last piece is expanded in place
+  std::memset(mem1, 'x', 32);
+  void *mem2 = arena.reallocate(mem1, 64, 32);
+  ASSERT_EQ(mem2, mem1);
+
+  void *mem3 = arena.allocate(8);
+  void *mem4 = arena.reallocate(mem2, 128, 64);
+  ASSERT_NE(mem4, mem2);
+  ASSERT_GT(mem4, mem3);
+  ASSERT_EQ(std::memcmp(mem4, std::string(32, 'x').c_str(), 32), 0);
+
+  arena.leave(scope_mark);
+  ASSERT_EQ(resource.get_memory_stats().memory_used, 0);
+}
+
+TEST(script_arena_test, nested_scopes) {
+  std::array<char, 4 * 1024 * 1024> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+  resource.init(some_memory.data(), some_memory.size());
+  memory_resource::script_arena arena;
+
+  const auto outer_mark = arena.enter(resource);
+  void *outer_mem = arena.allocate(1000);
+  const size_t memory_used_by_outer = resource.get_memory_stats().memory_used;
+
+  const auto inner_mark = arena.enter(resource);
+  void *inner_mem = arena.allocate(1000);
+  ASSERT_GT(inner_mem, outer_mem);
+  // doesn't fit into the first block
+  void *big_mem = arena.allocate(200 * 1024);
+  ASSERT_TRUE(big_mem);
+  ASSERT_TRUE(arena.owns(big_mem));
+  ASSERT_EQ(arena.get_blocks_allocated(), 2);
+  arena.leave(inner_mark);
+
+  ASSERT_TRUE(arena.is_enabled());
+  ASSERT_TRUE(arena.owns(outer_mem));
+  ASSERT_FALSE(arena.owns(big_mem));
+  ASSERT_EQ(resource.get_memory_stats().memory_used, memory_used_by_outer);
+  // the inner scope memory is reused by the outer scope
+  ASSERT_EQ(arena.allocate(8), inner_mem);
+
+  arena.leave(outer_mark);
+  ASSERT_EQ(resource.get_memory_stats().memory_used, 0);
+}
+
+TEST(script_arena_test, suspension) {
+  std::array<char, 1024 * 1024> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+  resource.init(some_memory.data(), some_memory.size());
+  memory_resource::script_arena arena;
+
+  const auto scope_mark = arena.enter(resource);
+  void *mem = arena.allocate(8);
+  arena.suspend();
+  ASSERT_FALSE(arena.is_enabled());
+  ASSERT_TRUE(arena.owns(mem));
+  arena.resume();
+  ASSERT_TRUE(arena.is_enabled());
+  arena.leave(scope_mark);
+}
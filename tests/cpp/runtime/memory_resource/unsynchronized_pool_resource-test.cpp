@@ -1,4 +1,5 @@
 #include <array>
+#include <numeric>
 #include <gtest/gtest.h>
 
 #include "runtime/memory_resource/unsynchronized_pool_resource.h"
@@ -292,4 +293,95 @@ TEST(unsynchronized_pool_resource_test, test_auto_defragmentation_small_piece) {
   ASSERT_EQ(mem_stats.small_memory_pieces, 0);
 
   resource.deallocate(mem64, 64);
-}
\ No newline at end of file
+}
+TEST(unsynchronized_pool_resource_test, test_allocations_histogram) {
+  std::array<char, 1024*64> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+
+  resource.init(some_memory.data(), some_memory.size());
+
+  void *mem16 = resource.allocate(13);
+  void *mem128 = resource.allocate(128);
+  void *mem136 = resource.allocate(129);
+  void *mem_huge = resource.allocate(1024*16);
+  resource.deallocate(mem16, 13);
+  void *mem16_reused = resource.allocate(16);
+  ASSERT_EQ(mem16_reused, mem16);
+
+  auto mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.total_allocations, 5);
+  ASSERT_EQ(mem_stats.fast_allocations[2], 2);
+  ASSERT_EQ(mem_stats.fast_allocations[16], 1);
+  ASSERT_EQ(std::accumulate(mem_stats.fast_allocations.begin(), mem_stats.fast_allocations.end(), size_t{0}), 3);
+  ASSERT_EQ(mem_stats.huge_allocations, 1);
+  ASSERT_EQ(mem_stats.small_memory_pieces, 0);
+
+  resource.deallocate(mem_huge, 1024*16);
+  resource.deallocate(mem136, 129);
+  resource.deallocate(mem128, 128);
+  resource.deallocate(mem16_reused, 16);
+  mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.memory_used, 0);
+}
+
+TEST(unsynchronized_pool_resource_test, test_largest_free_piece) {
+  std::array<char, 1024*64> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+
+  resource.init(some_memory.data(), some_memory.size());
+  ASSERT_EQ(resource.get_largest_free_piece_size(), some_memory.size());
+
+  std::array<void *, 4> pieces{};
+  for (auto &mem: pieces) {
+    mem = resource.allocate(1024*16);
+  }
+  ASSERT_EQ(resource.get_largest_free_piece_size(), 0);
+
+  resource.deallocate(pieces[0], 1024*16);
+  resource.deallocate(pieces[1], 1024*16);
+  ASSERT_EQ(resource.get_largest_free_piece_size(), 1024*16);
+
+  resource.perform_defragmentation();
+  ASSERT_EQ(resource.get_largest_free_piece_size(), 1024*32);
+
+  resource.deallocate(pieces[3], 1024*16);
+  resource.deallocate(pieces[2], 1024*16);
+  resource.perform_defragmentation();
+  ASSERT_EQ(resource.get_largest_free_piece_size(), some_memory.size());
+}
+
+TEST(unsynchronized_pool_resource_test, test_growth_on_demand) {
+  std::array<char, 1024 * 128> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+  resource.init(some_memory.data(), some_memory.size(), 1024 * 16);
+
+  auto mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.memory_limit, some_memory.size());
+  ASSERT_EQ(mem_stats.memory_arena_size, 1024 * 16);
+  ASSERT_TRUE(resource.is_enough_memory_for(1024 * 100));
+  ASSERT_EQ(resource.get_largest_free_piece_size(), some_memory.size());
+
+  // small pieces fill the first step, then the pool grows by one step
+  for (size_t i = 0; i < 1024 * 16 / 128; ++i) {
+    ASSERT_TRUE(resource.allocate(128));
+  }
+  ASSERT_EQ(resource.get_memory_stats().memory_arena_size, 1024 * 16);
+  ASSERT_TRUE(resource.allocate(128));
+  ASSERT_EQ(resource.get_memory_stats().memory_arena_size, 1024 * 32);
+
+  // a huge piece grows the pool by several steps without the defragmentation
+  void *huge_mem = resource.allocate(1024 * 40);
+  ASSERT_TRUE(huge_mem);
+  mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.memory_arena_size, 1024 * 64);
+  ASSERT_EQ(mem_stats.defragmentation_calls, 0);
+
+  // the pool doesn't grow beyond the buffer
+  ASSERT_TRUE(resource.allocate(1024 * 60));
+  ASSERT_EQ(resource.get_memory_stats().memory_arena_size, some_memory.size());
+  ASSERT_FALSE(resource.is_enough_memory_for(1024 * 16));
+
+  // the next init starts with the first step again
+  resource.init(some_memory.data(), some_memory.size(), 1024 * 16);
+  ASSERT_EQ(resource.get_memory_stats().memory_arena_size, 1024 * 16);
+}
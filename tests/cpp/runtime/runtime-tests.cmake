@@ -1,4 +1,5 @@
 prepend(RUNTIME_TESTS_SOURCES ${BASE_DIR}/tests/cpp/runtime/
+        _runtime-link-stubs.cpp
         _runtime-tests-env.cpp
         allocator-malloc-replacement-test.cpp
         array-test.cpp
@@ -8,10 +9,14 @@ prepend(RUNTIME_TESTS_SOURCES ${BASE_DIR}/tests/cpp/runtime/
         confdata-predefined-wildcards-test.cpp
         inter-process-mutex-test.cpp
         inter-process-resource-test.cpp
+        mbstring-test.cpp
         memory_resource/details/memory_chunk_list-test.cpp
         memory_resource/details/memory_chunk_tree-test.cpp
         memory_resource/details/memory_ordered_chunk_list-test.cpp
+        memory_resource/global_const_memory-test.cpp
+        memory_resource/script_arena-test.cpp
         memory_resource/unsynchronized_pool_resource-test.cpp
+        serialize-test.cpp
         string-test.cpp)
 
 vk_add_unittest(runtime "${RUNTIME_LIBS};${RUNTIME_LINK_TEST_LIBS}" ${RUNTIME_TESTS_SOURCES})
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "runtime/kphp_core.h"
+#include "runtime/misc.h"
+
+TEST(serialize_test, typed_arrays_as_mixed) {
+  const auto ints = array<int64_t>::create(0, -1, 42, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), 10000, 9999);
+  ASSERT_EQ(f$serialize(ints), f$serialize(mixed{ints}));
+  ASSERT_EQ(f$serialize(ints), string{"a:7:{i:0;i:0;i:1;i:-1;i:2;i:42;i:3;i:-9223372036854775808;i:4;i:9223372036854775807;i:5;i:10000;i:6;i:9999;}"});
+
+  array<string> strings;
+  strings.set_value(string{"key"}, string{"value"});
+  strings.set_value(-5, string{});
+  strings.set_value(string{"empty"}, string{"\"quoted\""});
+  ASSERT_EQ(f$serialize(strings), f$serialize(mixed{strings}));
+
+  const auto floats = array<double>::create(0.5, -1e100, 3.0);
+  ASSERT_EQ(f$serialize(floats), f$serialize(mixed{floats}));
+
+  const auto bools = array<bool>::create(true, false);
+  ASSERT_EQ(f$serialize(bools), string{"a:2:{i:0;b:1;i:1;b:0;}"});
+
+  ASSERT_EQ(f$serialize(array<int64_t>{}), string{"a:0:{}"});
+}
+
+TEST(serialize_test, unserialize_vectors) {
+  const auto ints = array<int64_t>::create(5, -7, 0, 123456789012345678);
+  const mixed result = f$unserialize(f$serialize(ints));
+  ASSERT_TRUE(result.is_array());
+  ASSERT_TRUE(result.as_array().is_vector());
+  ASSERT_TRUE(equals(result, mixed{ints}));
+
+  // values that are not ints, long ints and keys out of order go through the general path
+  const string mixed_vector{"a:4:{i:0;s:1:\"a\";i:1;i:12345678901234567890;i:2;i:-9223372036854775808;i:5;d:0.5;}"};
+  const mixed parsed = f$unserialize(mixed_vector);
+  ASSERT_TRUE(parsed.is_array());
+  ASSERT_EQ(parsed.as_array().count(), 4);
+  ASSERT_TRUE(equals(parsed.get_value(0), mixed{string{"a"}}));
+  ASSERT_TRUE(parsed.get_value(1).is_string());
+  ASSERT_TRUE(equals(parsed.get_value(2), mixed{std::numeric_limits<int64_t>::min()}));
+  ASSERT_TRUE(equals(parsed.get_value(5), mixed{0.5}));
+
+  ASSERT_TRUE(equals(f$unserialize(string{"a:2:{i:0;i:1;i:1;i:2;"}), mixed{false}));
+  ASSERT_TRUE(equals(f$unserialize(string{"a:2:{i:0;i:01;i:1;i:2;}"}).get_value(0), mixed{string{"01"}}));
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "runtime/kphp_core.h"
+#include "runtime/array_functions.h"
 #include "runtime/string_functions.h"
 
 TEST(string_test, test_empty) {
@@ -98,4 +99,87 @@ TEST(string_test, test_hex_to_int) {
   ASSERT_EQ(hex_to_int('D'), 13);
   ASSERT_EQ(hex_to_int('E'), 14);
   ASSERT_EQ(hex_to_int('F'), 15);
-}
\ No newline at end of file
+}
+TEST(string_test, test_short_string_uses_allocation_slack) {
+  string str{"hello"};
+  ASSERT_EQ((string::inner_sizeof() + str.capacity() + 1) % 8, 0);
+
+  const char *data = str.c_str();
+  while (str.size() < str.capacity()) {
+    str.push_back('!');
+  }
+  ASSERT_EQ(str.c_str(), data);
+  ASSERT_EQ(string(str.c_str(), 5), string{"hello"});
+}
+
+TEST(string_test, test_double_to_string) {
+  const std::pair<double, const char *> cases[] = {
+    {0.0, "0"}, {-0.0, "-0"}, {0.1 + 0.2, "0.3"}, {1.0 / 3, "0.33333333333333"}, {123.456, "123.456"},
+    {-2.5, "-2.5"}, {1e14, "1.0E+14"}, {99999999999999.0, "99999999999999"}, {1e25, "1.0E+25"},
+    {1.5e25, "1.5E+25"}, {1e-5, "1.0E-5"}, {-1e-7, "-1.0E-7"}, {1.25e-10, "1.25E-10"}, {0.0001, "0.0001"},
+    {-1.7976931348623157e308, "-1.7976931348623E+308"}, {std::numeric_limits<double>::infinity(), "INF"},
+    {-std::numeric_limits<double>::infinity(), "-INF"}, {std::numeric_limits<double>::quiet_NaN(), "NAN"},
+  };
+  for (const auto &test : cases) {
+    ASSERT_STREQ(string(test.first).c_str(), test.second);
+
+    string appended{"x"};
+    appended.append(test.first);
+    ASSERT_EQ(appended, string("x").append(string(test.second)));
+
+    static_SB.clean() << test.first;
+    ASSERT_STREQ(static_SB.c_str(), test.second);
+  }
+}
+
+TEST(string_test, test_strtr_replace_pairs) {
+  array<string> trans;
+  trans.set_value(string{"h"}, string{"-"});
+  trans.set_value(string{"hello"}, string{"hi"});
+  trans.set_value(string{"hi"}, string{"hello"});
+  ASSERT_EQ(f$strtr(string{"hi all, I said hello world"}, trans), string{"hello all, I said hi world"});
+  ASSERT_EQ(f$strtr(string{"oh, hell"}, trans), string{"o-, -ell"});
+  ASSERT_EQ(f$strtr(string{"nothing to replace"}, trans), string{"nothing to replace"});
+
+  array<int64_t> digits;
+  digits.set_value(1, 2);
+  digits.set_value(12, 3);
+  ASSERT_EQ(f$strtr(string{"1121x12"}, digits), string{"232x3"});
+
+  trans.set_value(string{}, string{"x"});
+  ASSERT_EQ(f$strtr(string{"hi"}, trans), string{"hi"});
+}
+
+TEST(string_test, test_strtr_const_replace_pairs) {
+  array<string> trans;
+  trans.set_value(string{"ab"}, string{"0"});
+  trans.set_value(string{"abc"}, string{"1"});
+  trans.set_value(string{"bc"}, string{"2"});
+  trans.set_reference_counter_to(ExtraRefCnt::for_global_const);
+
+  // the second call uses the cached matcher
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(f$strtr(string{"abcabxbcab"}, trans), string{"10x20"});
+  }
+  // the constant arrays are never freed, otherwise the cached matcher could be found by another array
+}
+
+TEST(string_test, test_explode) {
+  const string line{"a,bc,,def"};
+  const array<string> pieces = f$explode(string{","}, line);
+  ASSERT_EQ(pieces.count(), 4);
+  ASSERT_EQ(pieces.get_value(0), string{"a"});
+  ASSERT_EQ(pieces.get_value(1), string{"bc"});
+  ASSERT_EQ(pieces.get_value(2), string{});
+  ASSERT_EQ(pieces.get_value(3), string{"def"});
+
+  const array<string> limited = f$explode(string{",,"}, string{"x,,y,,z"}, 2);
+  ASSERT_EQ(limited.count(), 2);
+  ASSERT_EQ(limited.get_value(1), string{"y,,z"});
+
+  // nothing to split, the string is shared
+  const array<string> whole = f$explode(string{";"}, line);
+  ASSERT_EQ(whole.count(), 1);
+  ASSERT_EQ(whole.get_value(0).c_str(), line.c_str());
+  ASSERT_EQ(line.substr(0, line.size()).c_str(), line.c_str());
+}
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include "server/php-admission-control.h"
+
+TEST(php_admission_control_test, test_shed_after_interval) {
+  auto &admission = AdmissionControl::get();
+  admission.set_delays(0.005, 0.1);
+  const uint64_t endpoint = AdmissionControl::http_endpoint("/slow", 5);
+  const uint64_t shed_before = admission.shed_http_queries();
+
+  // the delay must stay above the target for the whole interval
+  admission.on_script_start(endpoint, 0.05, 10.0);
+  ASSERT_TRUE(admission.admit(endpoint, false, 10.05));
+  admission.on_script_start(endpoint, 0.05, 10.11);
+  ASSERT_TRUE(admission.admit(endpoint, false, 10.12));
+  ASSERT_FALSE(admission.admit(endpoint, false, 10.25));
+  ASSERT_EQ(admission.shed_http_queries(), shed_before + 1);
+
+  // an idle worker takes everything
+  ASSERT_TRUE(admission.admit(endpoint, true, 10.5));
+
+  // other endpoints are not affected
+  const uint64_t other_endpoint = AdmissionControl::rpc_endpoint(0x12345678);
+  ASSERT_TRUE(admission.admit(other_endpoint, false, 10.5));
+
+  admission.on_script_start(endpoint, 0.001, 10.6);
+  ASSERT_TRUE(admission.admit(endpoint, false, 11.0));
+  ASSERT_EQ(admission.shed_rpc_queries(), 0U);
+
+  admission.set_delays(0, 0.1);
+}
@@ -0,0 +1,84 @@
+#include <cstring>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "server/php-job-queue.h"
+
+TEST(php_job_queue_test, test_job_round_trip) {
+  auto &job_queue = JobQueue::get();
+  ASSERT_TRUE(job_queue.init(5, 100));
+  ASSERT_GE(job_queue.get_payload_size(), 100);
+
+  // rounded up to 8 messages
+  std::vector<JobMessage *> messages;
+  while (JobMessage *message = job_queue.acquire_message()) {
+    messages.push_back(message);
+  }
+  ASSERT_EQ(messages.size(), 8);
+  for (JobMessage *message : messages) {
+    job_queue.release_message(message);
+  }
+
+  JobMessage *job = job_queue.acquire_message();
+  ASSERT_TRUE(job);
+  std::strcpy(job->payload(), "args");
+  job->payload_size = 5;
+  ASSERT_TRUE(job_queue.send_job(job));
+  ASSERT_EQ(job_queue.get_queued_jobs(), 1);
+  ASSERT_FALSE(JobQueue::is_job_done(job));
+
+  JobMessage *taken = job_queue.take_job();
+  ASSERT_EQ(taken, job);
+  ASSERT_STREQ(taken->payload(), "args");
+  ASSERT_FALSE(job_queue.take_job());
+  std::strcpy(taken->payload(), "result");
+  job_queue.finish_job(taken);
+
+  ASSERT_TRUE(JobQueue::is_job_done(job));
+  ASSERT_STREQ(job->payload(), "result");
+  job_queue.release_message(job);
+  job_queue.destroy();
+}
+
+TEST(php_job_queue_test, test_concurrent_jobs) {
+  auto &job_queue = JobQueue::get();
+  ASSERT_TRUE(job_queue.init(64, 8));
+
+  constexpr int jobs_per_sender = 2000;
+  std::atomic<int> sum{0};
+  std::atomic<int> taken{0};
+  std::vector<std::thread> threads;
+  for (int sender = 0; sender < 2; ++sender) {
+    threads.emplace_back([&job_queue] {
+      for (int i = 1; i <= jobs_per_sender;) {
+        JobMessage *job = job_queue.acquire_message();
+        if (!job) {
+          continue;
+        }
+        std::memcpy(job->payload(), &i, sizeof(i));
+        ASSERT_TRUE(job_queue.send_job(job));
+        ++i;
+      }
+    });
+  }
+  for (int worker = 0; worker < 2; ++worker) {
+    threads.emplace_back([&] {
+      while (taken.load() < 2 * jobs_per_sender) {
+        if (JobMessage *job = job_queue.take_job()) {
+          int value = 0;
+          std::memcpy(&value, job->payload(), sizeof(value));
+          sum += value;
+          ++taken;
+          job_queue.finish_job(job);
+          job_queue.release_message(job);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(sum.load(), jobs_per_sender * (jobs_per_sender + 1));
+  job_queue.destroy();
+}
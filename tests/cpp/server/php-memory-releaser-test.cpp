@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include "server/php-memory-releaser.h"
+
+TEST(php_memory_releaser_test, test_release_above_window) {
+  auto &releaser = MemoryReleaser::get();
+  ASSERT_FALSE(releaser.set_requests_window(MemoryReleaser::MAX_REQUESTS_WINDOW + 1));
+  ASSERT_TRUE(releaser.set_requests_window(3));
+  ASSERT_TRUE(releaser.enabled());
+
+  const size_t mb = 1024 * 1024;
+  releaser.on_request_finish(100 * mb, 10 * mb);
+  releaser.on_request_finish(4 * mb, 2 * mb);
+  // the heavy request is still in the window
+  ASSERT_EQ(releaser.script_memory_to_keep(), 100 * mb);
+  ASSERT_FALSE(releaser.should_release_script_memory());
+  ASSERT_FALSE(releaser.should_trim_heap());
+
+  releaser.on_request_finish(4 * mb, 2 * mb);
+  releaser.on_request_finish(5 * mb, 2 * mb);
+  ASSERT_EQ(releaser.script_memory_to_keep(), 5 * mb);
+  ASSERT_TRUE(releaser.should_release_script_memory());
+  ASSERT_TRUE(releaser.should_trim_heap());
+
+  const size_t script_releases_before = releaser.script_memory_releases();
+  releaser.on_script_memory_released();
+  releaser.on_heap_trimmed();
+  ASSERT_EQ(releaser.script_memory_releases(), script_releases_before + 1);
+  ASSERT_FALSE(releaser.should_release_script_memory());
+  ASSERT_FALSE(releaser.should_trim_heap());
+
+  // the differences smaller than MIN_RELEASE_SIZE are not released
+  releaser.on_request_finish(4 * mb + mb / 2, 2 * mb);
+  releaser.on_request_finish(4 * mb + mb / 2, 2 * mb);
+  releaser.on_request_finish(4 * mb + mb / 2, 2 * mb);
+  ASSERT_EQ(releaser.script_memory_to_keep(), 4 * mb + mb / 2);
+  ASSERT_FALSE(releaser.should_release_script_memory());
+
+  ASSERT_TRUE(releaser.set_requests_window(0));
+  ASSERT_FALSE(releaser.enabled());
+}
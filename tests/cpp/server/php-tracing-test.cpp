@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <unistd.h>
+
+#include "server/php-tracing.h"
+
+static std::string read_file(const std::string &path) {
+  std::ifstream file(path);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+TEST(php_tracing_test, test_spans_of_sampled_request) {
+  auto &tracing = Tracing::get();
+  const std::string path = "php_tracing_test_" + std::to_string(getpid()) + ".jsonl";
+  ASSERT_FALSE(tracing.set_sample_rate(1.5));
+  ASSERT_TRUE(tracing.set_sample_rate(0));
+
+  // nothing is sampled until the spans have somewhere to go
+  tracing.start_request(0x1234, 0x10, 1.0);
+  ASSERT_FALSE(tracing.sampled());
+  ASSERT_TRUE(tracing.set_export_file(path.c_str()));
+
+  tracing.start_request(0, 0, 1.0);
+  ASSERT_FALSE(tracing.sampled());
+
+  // the caller has sampled the trace
+  tracing.start_request(0x1234, 0x10, 1.0);
+  ASSERT_TRUE(tracing.sampled());
+  ASSERT_EQ(tracing.trace_id(), 0x1234);
+  tracing.start_span(Tracing::SpanKind::rpc, 7, 3, 100, 1.1);
+  tracing.start_span(Tracing::SpanKind::rpc, 8, 4, 200, 1.2, 0x99);
+  tracing.add_span(Tracing::SpanKind::mysql, 1, 50, 500, 0, 1.25, 1.3);
+  tracing.finish_span(Tracing::SpanKind::rpc, 7, 0, 1000, 1.4);
+  // not started
+  tracing.finish_span(Tracing::SpanKind::rpc, 9, 0, 1000, 1.4);
+
+  ASSERT_EQ(tracing.spans_count(), 3);
+  ASSERT_EQ(tracing.span(0).finish_time, 1.4);
+  ASSERT_EQ(tracing.span(0).bytes_in, 1000);
+  ASSERT_EQ(tracing.span(1).span_id, 0x99);
+  ASSERT_EQ(tracing.span(1).finish_time, 0);
+  ASSERT_EQ(tracing.span(2).kind, Tracing::SpanKind::mysql);
+  ASSERT_EQ(tracing.span(2).bytes_out, 50);
+
+  tracing.on_script_finish(0.3, 0.2, script_error_t::no_error);
+  tracing.finish_request(0.01, 1.5);
+  ASSERT_FALSE(tracing.sampled());
+  const std::string exported = tracing.export_buffer();
+  ASSERT_NE(exported.find(R"("trace_id":"0000000000001234")"), std::string::npos);
+  ASSERT_NE(exported.find(R"("parent_id":"0000000000000010","kind":"script")"), std::string::npos);
+  ASSERT_NE(exported.find(R"("span_id":"0000000000000099")"), std::string::npos);
+  ASSERT_NE(exported.find(R"("unfinished":true)"), std::string::npos);
+  ASSERT_NE(exported.find(R"("kind":"mysql","target":1)"), std::string::npos);
+
+  // the buffer waits for more spans
+  tracing.flush(1.6);
+  ASSERT_EQ(tracing.export_buffer(), exported);
+  tracing.flush(1.6, true);
+  ASSERT_TRUE(tracing.export_buffer().empty());
+  ASSERT_EQ(read_file(path), exported);
+
+  // the ring keeps the last spans
+  ASSERT_TRUE(tracing.set_sample_rate(1));
+  tracing.start_request(0, 0, 2.0);
+  ASSERT_TRUE(tracing.sampled());
+  ASSERT_NE(tracing.trace_id(), 0);
+  const uint64_t dropped_before = tracing.spans_dropped();
+  for (size_t i = 0; i < Tracing::MAX_SPANS + 10; ++i) {
+    tracing.start_span(Tracing::SpanKind::memcache, static_cast<int64_t>(i), 0, 0, 2.0);
+  }
+  ASSERT_EQ(tracing.spans_count(), Tracing::MAX_SPANS);
+  ASSERT_EQ(tracing.span(0).key, 10);
+  ASSERT_EQ(tracing.spans_dropped(), dropped_before + 10);
+  tracing.finish_request(0, 2.1);
+  tracing.flush(2.1, true);
+
+  ASSERT_TRUE(tracing.set_sample_rate(0));
+  std::remove(path.c_str());
+}
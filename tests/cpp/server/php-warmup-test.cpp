@@ -0,0 +1,49 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "server/php-warmup.h"
+
+TEST(php_warmup_test, test_prepare_request) {
+  const std::string head = "GET /index.php?a=1 HTTP/1.1\r\nHost: example.com\r\nconnection: keep-alive\r\nX-KPHP-Warmup: 0\r\nConnection-Id: 7\r\n\r\n";
+  ASSERT_EQ(HttpWarmup::prepare_request(head.data(), head.size(), nullptr, 0),
+            "GET /index.php?a=1 HTTP/1.1\r\nHost: example.com\r\nConnection-Id: 7\r\nConnection: close\r\nX-KPHP-Warmup: 1\r\n\r\n");
+
+  // bare line feeds are accepted by the parser too
+  const std::string post_head = "POST /api HTTP/1.0\nContent-Length: 4\n\n";
+  ASSERT_EQ(HttpWarmup::prepare_request(post_head.data(), post_head.size(), "a=12", 4),
+            "POST /api HTTP/1.0\r\nContent-Length: 4\r\nConnection: close\r\nX-KPHP-Warmup: 1\r\n\r\na=12");
+}
+
+TEST(php_warmup_test, test_record_and_load) {
+  auto &warmup = HttpWarmup::get();
+  const std::string path = "php_warmup_test_" + std::to_string(getpid()) + ".bin";
+  ASSERT_FALSE(warmup.set_record_rate(0));
+  ASSERT_FALSE(warmup.set_record_rate(1.5));
+  ASSERT_TRUE(warmup.set_record_rate(1));
+  ASSERT_FALSE(warmup.set_timeout(0));
+  ASSERT_FALSE(warmup.load(path.c_str()));
+
+  ASSERT_TRUE(warmup.set_record_file(path.c_str()));
+  const std::string get_head = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+  const std::string post_head = "POST /p HTTP/1.1\r\nContent-Length: 3\r\n\r\n";
+  warmup.record(get_head.data(), get_head.size(), nullptr, 0);
+  warmup.record(post_head.data(), post_head.size(), "xyz", 3);
+
+  ASSERT_TRUE(warmup.load(path.c_str()));
+  ASSERT_EQ(warmup.requests_count(), 2);
+  ASSERT_EQ(warmup.request(0), "GET / HTTP/1.1\r\nHost: a\r\nConnection: close\r\nX-KPHP-Warmup: 1\r\n\r\n");
+  ASSERT_EQ(warmup.request(1), "POST /p HTTP/1.1\r\nContent-Length: 3\r\nConnection: close\r\nX-KPHP-Warmup: 1\r\n\r\nxyz");
+
+  // a cut last record is skipped
+  FILE *file = fopen(path.c_str(), "ab");
+  ASSERT_NE(file, nullptr);
+  const uint32_t lengths[2] = {100, 0};
+  fwrite(lengths, sizeof(lengths), 1, file);
+  fwrite("GET", 3, 1, file);
+  fclose(file);
+  ASSERT_TRUE(warmup.load(path.c_str()));
+  ASSERT_EQ(warmup.requests_count(), 2);
+
+  std::remove(path.c_str());
+}
@@ -1,6 +1,11 @@
 prepend(SERVER_TESTS_SOURCES ${BASE_DIR}/tests/cpp/server/
         confdata-binlog-events-test.cpp
-        php-engine-test.cpp)
+        php-admission-control-test.cpp
+        php-engine-test.cpp
+        php-job-queue-test.cpp
+        php-memory-releaser-test.cpp
+        php-tracing-test.cpp
+        php-warmup-test.cpp)
 
 if(COMPILER_GCC)
     set_source_files_properties(${BASE_DIR}/tests/cpp/server/confdata-binlog-events-test.cpp PROPERTIES COMPILE_FLAGS -Wno-stringop-overflow)
@@ -0,0 +1,169 @@
+#!/usr/bin/python3
+import argparse
+import json
+import multiprocessing
+import os
+import sys
+import time
+
+from python.lib.colors import red, green, blue
+from python.lib.kphp_builder import KphpBuilder
+from python.lib.php_corpus_generator import PhpCorpusGenerator
+
+
+def parse_compilation_metrics(metrics_file):
+    """
+    Parses the file written by kphp2cpp --compilation-metrics-file (see Stats::write_to)
+    """
+    metrics = {}
+    with open(metrics_file) as f:
+        for line in f:
+            key, sep, value = line.strip().partition(": ")
+            if not sep:
+                continue
+            try:
+                metrics[key] = float(value) if "." in value else int(value)
+            except ValueError:
+                metrics[key] = value
+    return metrics
+
+
+def make_build_report(metrics, wall_time):
+    pipes = {}
+    for key, value in metrics.items():
+        if key.startswith("pipes."):
+            pipe, _, metric = key[len("pipes."):].rpartition(".")
+            pipes.setdefault(pipe, {})[metric] = value
+    return {
+        "wall_time": wall_time,
+        "transpilation_time": metrics.get("compilation.transpilation_time"),
+        "total_time": metrics.get("compilation.total_time"),
+        "rss_peak_bytes": metrics.get("memory.rss_peak"),
+        "classes": metrics.get("classes.total"),
+        "functions": metrics.get("functions.total"),
+        "pipes": pipes,
+    }
+
+
+def run_build(builder, name, metrics_file, kphp_env):
+    print("Running {} build...".format(blue(name)))
+    if os.path.exists(metrics_file):
+        os.remove(metrics_file)
+    env = dict(kphp_env)
+    env["KPHP_COMPILATION_METRICS_FILE"] = metrics_file
+    start = time.monotonic()
+    ok = builder.compile_with_kphp(env)
+    wall_time = time.monotonic() - start
+    if not ok:
+        artifact = builder.kphp_build_stderr_artifact
+        print(red("{} build failed{}".format(name, ", see " + artifact.file if artifact else "")))
+        sys.exit(1)
+    report = make_build_report(parse_compilation_metrics(metrics_file), wall_time)
+    print_build_report(report)
+    return report
+
+
+def print_build_report(report, top_pipes=10):
+    print("  wall time:          {:.2f}s".format(report["wall_time"]))
+    print("  transpilation time: {}s".format(report["transpilation_time"]))
+    print("  total time:         {}s".format(report["total_time"]))
+    print("  rss peak:           {:.1f} MB".format((report["rss_peak_bytes"] or 0) / 1024 / 1024))
+    pipes = sorted(report["pipes"].items(), key=lambda p: p[1].get("working_time", 0), reverse=True)
+    for pipe, pipe_metrics in pipes[:top_pipes]:
+        print("  {:<40} working {:8.3f}s  duration {:8.3f}s".format(
+            pipe, pipe_metrics.get("working_time", 0), pipe_metrics.get("duration", 0)))
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter,
+        description="Compiles a generated big php project by kphp2cpp and reports the time of the compiler pipes "
+                    "and the peak memory for the cold and the incremental builds")
+    parser.add_argument(
+        "-d",
+        type=str,
+        dest="working_dir",
+        default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "kphp_compile_benchmark_tmp"),
+        help="working dir, it is cleared before the cold build")
+    parser.add_argument(
+        "-o",
+        type=str,
+        dest="output",
+        default=None,
+        help="save the json report to file")
+    parser.add_argument("--classes", type=int, default=2000, help="number of the generated classes")
+    parser.add_argument("--call-depth", type=int, default=30, help="length of the call chains between the classes")
+    parser.add_argument("--const-arrays", type=int, default=20, help="number of the big const arrays")
+    parser.add_argument("--const-array-size", type=int, default=2000, help="number of elements in a const array")
+    parser.add_argument(
+        "--threads",
+        type=int,
+        default=multiprocessing.cpu_count(),
+        help="number of the kphp2cpp transpiling threads")
+    parser.add_argument(
+        "--jobs",
+        type=int,
+        default=multiprocessing.cpu_count(),
+        help="number of the parallel c++ compilation jobs")
+    parser.add_argument(
+        "--no-make",
+        action='store_true',
+        default=False,
+        help="measure the transpilation only, without the c++ compilation")
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+    working_dir = os.path.abspath(args.working_dir)
+    KphpBuilder._clear_working_dir(working_dir)
+
+    corpus_dir = os.path.join(working_dir, "corpus")
+    os.makedirs(corpus_dir)
+    generator = PhpCorpusGenerator(
+        classes=args.classes,
+        call_depth=args.call_depth,
+        const_arrays=args.const_arrays,
+        const_array_size=args.const_array_size)
+    main_file = generator.generate(corpus_dir)
+    print("Generated the corpus of {} classes in {}".format(args.classes, blue(corpus_dir)))
+
+    builder = KphpBuilder(
+        php_script_path=main_file,
+        artifacts_dir=os.path.join(working_dir, "artifacts"),
+        working_dir=working_dir)
+    kphp_env = {
+        "KPHP_THREADS_COUNT": str(args.threads),
+        "KPHP_JOBS_COUNT": str(args.jobs),
+        # the instrumentation of the tests changes the generated code, so it's turned off to measure the production mode
+        "KPHP_PROFILER": "0",
+        "KPHP_ENABLE_GLOBAL_VARS_MEMORY_STATS": "0",
+    }
+    if args.no_make:
+        kphp_env["KPHP_NO_MAKE"] = "1"
+
+    metrics_file = os.path.join(working_dir, "compilation_metrics.txt")
+    report = {
+        "corpus": {
+            "classes": args.classes,
+            "call_depth": args.call_depth,
+            "const_arrays": args.const_arrays,
+            "const_array_size": args.const_array_size,
+        },
+        "threads": args.threads,
+        "jobs": args.jobs,
+        "no_make": args.no_make,
+    }
+    report["cold"] = run_build(builder, "cold", metrics_file, kphp_env)
+    # the same dest dir is reused, so only the changed c++ files are recompiled
+    generator.touch_model(corpus_dir)
+    report["incremental"] = run_build(builder, "incremental", metrics_file, kphp_env)
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+        print("Report is saved to {}".format(green(args.output)))
+
+
+if __name__ == "__main__":
+    main()
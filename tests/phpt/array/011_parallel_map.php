@@ -0,0 +1,20 @@
+@ok
+<?php
+#ifndef KPHP
+function parallel_map($a, $callback, $processes = 4) {
+  return array_map($callback, $a);
+}
+#endif
+
+function test_parallel_map() {
+  $squares = parallel_map(range(1, 100), function(int $x) { return $x * $x; }, 3);
+  var_dump(count($squares), array_sum($squares), $squares[0], $squares[99]);
+
+  $words = parallel_map(['a' => 'one', 'b' => 'two', 7 => 'three'], function(string $s) { return [$s, strlen($s)]; });
+  var_dump($words);
+
+  var_dump(parallel_map([], function(int $x) { return $x; }));
+  var_dump(parallel_map([5], function(int $x) { return $x + 1; }, 8));
+}
+
+test_parallel_map();
@@ -0,0 +1,24 @@
+@ok
+<?php
+#ifndef KPHP
+if (!function_exists('zstd_compress')) {
+  function zstd_compress($data, $level = 3) { return "z" . $data; }
+  function zstd_uncompress($data) { return substr($data, 1); }
+  function zstd_compress_dict($data, $dict) { return "d" . $data; }
+  function zstd_uncompress_dict($data, $dict) { return substr($data, 1); }
+}
+#endif
+
+function test_zstd() {
+  $dict = str_repeat('{"user_id":,"name":"","photo":"https://example.com/"}', 10);
+  $payloads = ["", "hello", str_repeat("hello world ", 1000), '{"user_id":42,"name":"Ivan","photo":"https://example.com/1.jpg"}'];
+  foreach ($payloads as $payload) {
+    foreach ([1, 3, 19] as $level) {
+      var_dump(zstd_uncompress(zstd_compress($payload, $level)) === $payload);
+    }
+    var_dump(zstd_uncompress(zstd_compress($payload)) === $payload);
+    var_dump(zstd_uncompress_dict(zstd_compress_dict($payload, $dict), $dict) === $payload);
+  }
+}
+
+test_zstd();
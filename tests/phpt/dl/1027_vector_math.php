@@ -0,0 +1,83 @@
+@ok
+<?php
+#ifndef KPHP
+function vk_vector_norm($a) {
+  return sqrt(array_sum(array_map(function($x) { return $x * $x; }, $a)));
+}
+function vk_vector_l2_distance($a, $b) {
+  $sum = 0.0;
+  foreach ($a as $i => $x) {
+    $sum += ($x - $b[$i]) * ($x - $b[$i]);
+  }
+  return sqrt($sum);
+}
+function vk_vector_cosine_similarity($a, $b) {
+  $norms = vk_vector_norm($a) * vk_vector_norm($b);
+  if ($norms == 0.0) {
+    return 0.0;
+  }
+  $dot = 0.0;
+  foreach ($a as $i => $x) {
+    $dot += $x * $b[$i];
+  }
+  return $dot / $norms;
+}
+function vk_vector_axpy($alpha, $x, $y) {
+  foreach ($x as $i => $v) {
+    $y[$i] += $alpha * $v;
+  }
+  return $y;
+}
+function vk_vector_top_k($a, $k) {
+  $order = array_flip(array_keys($a));
+  uksort($a, function($lhs, $rhs) use ($a, $order) {
+    if ($a[$lhs] != $a[$rhs]) {
+      return $a[$lhs] < $a[$rhs] ? 1 : -1;
+    }
+    return $order[$lhs] - $order[$rhs];
+  });
+  return $k <= 0 ? [] : array_slice(array_keys($a), 0, $k);
+}
+function vk_matrix_vector_product($matrix, $v) {
+  $result = [];
+  foreach ($matrix as $key => $row) {
+    $dot = 0.0;
+    foreach ($row as $i => $x) {
+      $dot += $x * $v[$i];
+    }
+    $result[$key] = $dot;
+  }
+  return $result;
+}
+#endif
+
+function make_vector($n, $seed) {
+  $v = [];
+  for ($i = 0; $i < $n; ++$i) {
+    $v[] = (($i * 7919 + $seed * 104729) % 2001 - 1000) / 100.0;
+  }
+  return $v;
+}
+
+function test_vector_math() {
+  foreach ([0, 1, 3, 4, 17, 100] as $n) {
+    $a = make_vector($n, 1);
+    $b = make_vector($n, 2);
+    var_dump(round(vk_vector_norm($a), 6));
+    var_dump(round(vk_vector_l2_distance($a, $b), 6));
+    var_dump(round(vk_vector_cosine_similarity($a, $b), 6));
+    var_dump(array_map(function($x) { return round($x, 6); }, vk_vector_axpy(0.5, $a, $b)));
+  }
+  var_dump(vk_vector_cosine_similarity([0.0, 0.0], [1.0, 2.0]));
+
+  $scores = ['a' => 0.5, 'b' => 2.5, 'c' => -1.0, 'd' => 2.5, 'e' => 1.0];
+  var_dump(vk_vector_top_k($scores, 3));
+  var_dump(vk_vector_top_k($scores, 10));
+  var_dump(vk_vector_top_k($scores, 0));
+  var_dump(vk_vector_top_k(make_vector(50, 3), 5));
+
+  $matrix = ['x' => make_vector(8, 4), 'y' => make_vector(8, 5), 'z' => make_vector(8, 6)];
+  var_dump(array_map(function($x) { return round($x, 6); }, vk_matrix_vector_product($matrix, make_vector(8, 7))));
+}
+
+test_vector_math();
@@ -0,0 +1,64 @@
+@ok
+<?php
+#ifndef KPHP
+function vk_model_predict_batch($model_path, $rows) {
+  $data = file_get_contents($model_path);
+  $header = unpack('Vtype/Vfeatures/dbase', substr($data, 4, 16));
+  $pos = 20;
+  $result = [];
+  foreach ($rows as $key => $x) {
+    $prediction = $header['base'];
+    if ($header['type'] == 0) {
+      for ($i = 0; $i < $header['features'] && $i < count($x); ++$i) {
+        $prediction += unpack('d', substr($data, $pos + 8 * $i, 8))[1] * $x[$i];
+      }
+    } else {
+      $trees = unpack('V', substr($data, $pos, 4))[1];
+      $tree_pos = $pos + 4;
+      for ($t = 0; $t < $trees; ++$t) {
+        $nodes = unpack('V', substr($data, $tree_pos, 4))[1];
+        $node = 0;
+        while (true) {
+          $n = unpack('lfeature/Vflags/dvalue/Vleft/Vright', substr($data, $tree_pos + 4 + 24 * $node, 24));
+          if ($n['feature'] < 0) {
+            $prediction += $n['value'];
+            break;
+          }
+          $value = isset($x[$n['feature']]) ? $x[$n['feature']] : NAN;
+          $go_left = is_nan($value) ? ($n['flags'] & 1) : $value < $n['value'];
+          $node = $go_left ? $n['left'] : $n['right'];
+        }
+        $tree_pos += 4 + 24 * $nodes;
+      }
+    }
+    $result[$key] = $prediction;
+  }
+  return $result;
+}
+function vk_model_predict($model_path, $features) {
+  return vk_model_predict_batch($model_path, [$features])[0];
+}
+#endif
+
+function node($feature, $flags, $value, $left, $right) {
+  return pack('VVdVV', $feature, $flags, $value, $left, $right);
+}
+
+function test_models() {
+  $linear = tempnam(sys_get_temp_dir(), 'model');
+  file_put_contents($linear, 'KML1' . pack('VVd', 0, 3, 0.5) . pack('ddd', 1.0, -2.0, 0.25));
+  var_dump(vk_model_predict($linear, [1.0, 2.0, 4.0]));
+  var_dump(vk_model_predict($linear, [3.0]));
+  var_dump(vk_model_predict_batch($linear, ['a' => [1.0, 1.0, 1.0], 'b' => [0.0, 0.0, 8.0]]));
+
+  $trees = tempnam(sys_get_temp_dir(), 'model');
+  $tree1 = pack('V', 3) . node(0, 1, 10.0, 1, 2) . node(-1, 0, 1.5, 0, 0) . node(-1, 0, -1.5, 0, 0);
+  $tree2 = pack('V', 5) . node(1, 0, 0.0, 1, 2) . node(-1, 0, 0.25, 0, 0) . node(0, 0, 20.0, 3, 4) . node(-1, 0, 2.0, 0, 0) . node(-1, 0, 4.0, 0, 0);
+  file_put_contents($trees, 'KML1' . pack('VVd', 1, 2, 1.0) . pack('V', 2) . $tree1 . $tree2);
+  var_dump(vk_model_predict_batch($trees, [[5.0, -1.0], [15.0, 1.0], [25.0, 1.0], [5.0], []]));
+
+  unlink($linear);
+  unlink($trees);
+}
+
+test_models();
@@ -0,0 +1,29 @@
+@ok benchmark
+<?php
+
+function bench_implode_ints() {
+  $ints = [];
+  for ($i = 0; $i < 1000000; $i++) {
+    $ints[] = ($i * 7919) % 2000003 - 1000000;
+  }
+  $ints[] = PHP_INT_MAX;
+  $ints[] = -PHP_INT_MAX - 1;
+
+  $s = implode(',', $ints);
+  echo strlen($s), " ", md5($s), "\n";
+}
+
+function bench_implode_floats() {
+  $floats = [];
+  for ($i = 0; $i < 200000; $i++) {
+    $floats[] = $i / 7.0;
+    $floats[] = -$i * 1.5e-7;
+    $floats[] = $i * 3.3e17;
+  }
+
+  $s = implode(',', $floats);
+  echo strlen($s), " ", md5($s), "\n";
+}
+
+bench_implode_ints();
+bench_implode_floats();
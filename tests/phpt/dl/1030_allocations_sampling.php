@@ -0,0 +1,33 @@
+@ok
+<?php
+#ifndef KPHP
+function memory_set_allocations_sampling($interval_bytes) {}
+function memory_get_allocations_samples() { return ['make_strings' => 1024]; }
+#endif
+
+function make_strings($n) {
+  $res = [];
+  for ($i = 0; $i < $n; $i++) {
+    $res[] = str_repeat("x", 100 + $i % 10) . $i;
+  }
+  return $res;
+}
+
+function test_allocations_sampling() {
+  memory_set_allocations_sampling(1024);
+  $strings = make_strings(10000);
+  $samples = memory_get_allocations_samples();
+  var_dump(count($strings));
+  var_dump(count($samples) > 0);
+
+  $total = 0;
+  foreach ($samples as $callsite => $bytes) {
+    $total += $bytes;
+  }
+  var_dump($total > 0);
+
+  memory_set_allocations_sampling(0);
+  var_dump(count(memory_get_allocations_samples()));
+}
+
+test_allocations_sampling();
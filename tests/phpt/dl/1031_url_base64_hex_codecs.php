@@ -0,0 +1,35 @@
+@ok
+<?php
+
+function test_codecs(string $s) {
+  var_dump(urlencode($s));
+  var_dump(rawurlencode($s));
+  var_dump(urldecode($s));
+  var_dump(rawurldecode($s));
+  var_dump(bin2hex($s));
+  var_dump(base64_encode($s));
+  var_dump(base64_decode(base64_encode($s)) === $s);
+  var_dump(base64_decode($s));
+  var_dump(urldecode(urlencode($s)) === $s);
+  var_dump(rawurldecode(rawurlencode($s)) === $s);
+}
+
+$long_plain = str_repeat("abcXYZ019-_.", 10);
+test_codecs($long_plain);
+test_codecs($long_plain . " ");
+test_codecs($long_plain . "%4");
+test_codecs($long_plain . "%41%zz+%%" . $long_plain);
+test_codecs(str_repeat("\xd0\xbf\x00\xff=&?/", 9));
+for ($len = 0; $len < 70; ++$len) {
+  $s = substr(str_repeat("Many hands make light work. ", 3), 0, $len);
+  var_dump(base64_encode($s));
+  var_dump(base64_decode(base64_encode($s), true) === $s);
+}
+var_dump(base64_decode(str_repeat("QUJD", 10) . "\nRE\nVG", true));
+var_dump(base64_decode(str_repeat("QUJD", 10) . "RE=VG", true));
+var_dump(base64_decode(str_repeat("QUJD", 10) . "RE==", true));
+
+var_dump(http_build_query(["a b" => $long_plain . " +", "c" => ["d&" => "é"]]));
+var_dump(http_build_query(["a b" => $long_plain . " +"], "", "&", PHP_QUERY_RFC3986));
+parse_str("a+b=" . $long_plain . "%20x&arr[]=1%2B1&arr[]=&novalue&=empty", $vars);
+var_dump($vars);
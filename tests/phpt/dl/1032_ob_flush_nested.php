@@ -0,0 +1,27 @@
+@ok
+<?php
+  ob_start();
+  ob_start();
+  echo "inner";
+  ob_flush();
+  echo "+after";
+  var_dump(ob_get_length());
+  ob_end_flush();
+  var_dump(ob_get_clean());
+
+  ob_start();
+  echo "outer:";
+  ob_start();
+  echo "inner";
+  var_dump(ob_get_flush());
+  var_dump(ob_get_level());
+  var_dump(ob_get_clean());
+
+  ob_start();
+  ob_start();
+  ob_start();
+  echo "deep";
+  ob_end_flush();
+  ob_end_flush();
+  echo "!";
+  var_dump(ob_get_clean());
@@ -0,0 +1,5 @@
+@kphp_should_fail
+/Unknown modifier 'q' found in regexp/
+<?php
+
+preg_match('/abc/q', 'abc');
@@ -0,0 +1,29 @@
+@ok
+<?php
+require_once 'kphp_tester_include.php';
+
+#ifndef KPHP
+for ($i = 0; $i < 3; $i++) {
+  echo "high $i\n";
+}
+for ($i = 0; $i < 3; $i++) {
+  echo "low $i\n";
+}
+echo "priority 10\n";
+return;
+#endif
+
+function f(string $name) {
+  for ($i = 0; $i < 3; $i++) {
+    sched_yield();
+    echo "$name $i\n";
+  }
+}
+
+$low = fork(f("low"));
+$high = fork(f("high"));
+set_fork_priority($high, 10);
+$stat = get_fork_stat($high);
+wait($high);
+wait($low);
+echo "priority {$stat["priority"]}\n";
@@ -0,0 +1,34 @@
+@ok
+<?php
+require_once 'kphp_tester_include.php';
+
+#ifndef KPHP
+echo "seen 20 sum 210\n";
+return;
+#endif
+
+function g(int $x) {
+  sched_yield();
+  return $x;
+}
+
+$q = wait_queue_create();
+for ($i = 1; $i <= 20; $i++) {
+  wait_queue_push($q, fork(g($i)));
+}
+
+$seen = 0;
+$sum = 0;
+while (!wait_queue_empty($q)) {
+  wait_queue_next($q);
+  // the batch starts with the function returned by wait_queue_next(), its result is not gotten yet
+  $batch = wait_queue_next_batch($q, 3);
+  if (count($batch) == 0 || count($batch) > 3) {
+    echo "unexpected batch size " . count($batch) . "\n";
+  }
+  foreach ($batch as $f) {
+    $sum += wait($f);
+    $seen++;
+  }
+}
+echo "seen $seen sum $sum\n";
@@ -0,0 +1,70 @@
+@ok
+<?php
+
+class Point {
+  /** @var float */
+  public $x;
+  /** @var float */
+  public $y;
+
+  public function __construct(float $x, float $y) {
+    $this->x = $x;
+    $this->y = $y;
+  }
+}
+
+/**
+ * @kphp-arena
+ * @param string[] $words
+ */
+function count_long_words(array $words, int $min_len): int {
+  $long = array_filter($words, function(string $w) use ($min_len) { return strlen($w) >= $min_len; });
+  $joined = implode(",", array_map('strtoupper', $long));
+  return count(explode(",", $joined)) + (preg_match('/[A-Z]+/', $joined) ? 1000 : 0);
+}
+
+/** @kphp-arena */
+function sum_of_squares(int $n): float {
+  $points = [];
+  for ($i = 0; $i < $n; ++$i) {
+    $points[] = new Point((float)$i, (float)($i * 2));
+  }
+  $sum = 0.0;
+  foreach ($points as $p) {
+    $sum += $p->x * $p->x + $p->y * $p->y;
+  }
+  return $sum;
+}
+
+/** @kphp-arena */
+function nested(int $n): int {
+  $total = 0;
+  for ($i = 0; $i < $n; ++$i) {
+    $words = explode(" ", str_repeat("ab abc abcd ", $i + 1));
+    $total += count_long_words($words, 3);
+    $total += (int)sum_of_squares($i);
+  }
+  return $total;
+}
+
+/** @kphp-arena */
+function build_keys(string $prefix): bool {
+  $map = [];
+  for ($i = 0; $i < 1000; ++$i) {
+    $map[$prefix . $i] = str_repeat($prefix, $i % 7);
+  }
+  return isset($map[$prefix . "999"]);
+}
+
+$words = ["a", "bbb", "cccc", "dd", "eeeee"];
+var_dump(count_long_words($words, 3));
+var_dump($words);
+var_dump(sum_of_squares(100));
+var_dump(nested(20));
+
+$outer = [];
+for ($i = 0; $i < 100; ++$i) {
+  $outer[] = "s" . $i;
+  var_dump(build_keys($outer[$i]));
+}
+var_dump(implode(",", $outer));
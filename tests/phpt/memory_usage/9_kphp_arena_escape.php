@@ -0,0 +1,36 @@
+@kphp_should_fail
+/@kphp-arena function append_to can't modify the param \$arr/
+/@kphp-arena function make_string must return a primitive type/
+/@kphp-arena function remember uses the global \$cache in store/
+<?php
+
+/**
+ * @kphp-arena
+ * @param int[] $arr
+ */
+function append_to(array $arr): int {
+  $arr[] = 1;
+  return count($arr);
+}
+
+/** @kphp-arena */
+function make_string(int $n): string {
+  return str_repeat("x", $n);
+}
+
+$cache = [];
+
+function store(string $s) {
+  global $cache;
+  $cache[] = $s;
+}
+
+/** @kphp-arena */
+function remember(int $n): int {
+  store(str_repeat("y", $n));
+  return $n;
+}
+
+var_dump(append_to([1, 2]));
+var_dump(make_string(3));
+var_dump(remember(3));
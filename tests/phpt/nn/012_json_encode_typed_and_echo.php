@@ -0,0 +1,31 @@
+@ok
+<?php
+
+function test_typed() {
+  $ints = [1, 2, 3];
+  $floats = [1.5, -2.25];
+  $strings = ["a" => "b/c", "d" => "\"e\""];
+  $nested = [[1, 2], [3]];
+  $optionals = [1, false];
+  var_dump(json_encode($ints));
+  var_dump(json_encode($floats));
+  var_dump(json_encode($strings));
+  var_dump(json_encode($nested));
+  var_dump(json_encode($optionals));
+  var_dump(json_encode($ints, JSON_FORCE_OBJECT));
+  var_dump(json_encode(true));
+  var_dump(json_encode(42));
+}
+
+function test_echo() {
+  echo json_encode(["x" => [1, 2], "y" => "z"]), "\n";
+  echo json_encode([1, 2], JSON_FORCE_OBJECT);
+  echo "\n";
+  ob_start();
+  echo json_encode(["in" => "buffer"]);
+  $out = ob_get_clean();
+  var_dump($out);
+}
+
+test_typed();
+test_echo();
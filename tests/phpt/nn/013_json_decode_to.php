@@ -0,0 +1,104 @@
+@ok
+<?php
+
+class Address {
+  /** @var string */
+  public $city = "";
+  /** @var int */
+  public $zip = 0;
+}
+
+class User {
+  /** @var int */
+  public $id = 0;
+  /** @var string */
+  public $name = "default";
+  /** @var float */
+  public $score = 0.0;
+  /** @var bool */
+  public $active = false;
+  /** @var ?string */
+  public $nick = null;
+  /** @var int[] */
+  public $tags = [];
+  /** @var ?Address */
+  public $address = null;
+  /** @var Address[] */
+  public $history = [];
+}
+
+#ifndef KPHP
+function address_from_array($a) {
+  if ($a === null) {
+    return null;
+  }
+  $address = new Address;
+  foreach ($a as $k => $v) {
+    $address->$k = $v;
+  }
+  return $address;
+}
+
+function user_from_json($json) {
+  $a = json_decode($json, true);
+  if (!is_array($a)) {
+    return null;
+  }
+  $user = new User;
+  foreach ($a as $k => $v) {
+    if ($k === 'address') {
+      $user->address = address_from_array($v);
+    } else if ($k === 'history') {
+      $user->history = array_map('address_from_array', $v);
+    } else if ($k === 'score') {
+      $user->score = (float)$v;
+    } else if (property_exists($user, $k)) {
+      $user->$k = $v;
+    }
+  }
+  return $user;
+}
+#endif
+
+function decode_user(string $json) {
+#ifndef KPHP
+  return user_from_json($json);
+#endif
+  return json_decode_to($json, User::class);
+}
+
+function dump_address(?Address $address) {
+  if (!$address) {
+    echo "no address\n";
+    return;
+  }
+  echo "address: ", $address->city, " ", $address->zip, "\n";
+}
+
+function dump_user(?User $user) {
+  if (!$user) {
+    echo "null\n";
+    return;
+  }
+  var_dump($user->id, $user->name, $user->score, $user->active, $user->nick, $user->tags);
+  dump_address($user->address);
+  echo "history: ", count($user->history), "\n";
+  foreach ($user->history as $address) {
+    dump_address($address);
+  }
+}
+
+function test_json_decode_to() {
+  dump_user(decode_user('{"id": 42, "name": "Alice", "score": 1.5, "active": true, "nick": "al", "tags": [1, 2, 3],
+                          "address": {"city": "Saint-Petersburg", "zip": 190000},
+                          "history": [{"city": "Moscow", "zip": 101000}, {"city": "Kazan"}]}'));
+  dump_user(decode_user('{"id": 7}'));
+  dump_user(decode_user(' {"score": 2, "nick": null, "address": null, "id": 1, "id": 3} '));
+  dump_user(decode_user('{"unknown": {"deep": [1, {"x": "y\"z"}], "n": null, "s": "]}"}, "name": "Bob", "tags": {"5": 10}}'));
+  dump_user(decode_user('{"name": "привет \\\\ \/"}'));
+  dump_user(decode_user('{"id": 1,}'));
+  dump_user(decode_user('{"id": 1, "tags": [1, 2]'));
+  dump_user(decode_user('null'));
+}
+
+test_json_decode_to();
@@ -8,7 +8,7 @@
 
 function test_hash_basic() {
   hash_algos();
-  $algos = array ("md5", "sha1", "sha256");
+  $algos = array ("md5", "sha1", "sha256", "crc32b", "crc32c");
 
 
   $a = array("", "asdasd", "abacaba", "1", NULL, false, true, "asdasdasdasdasd42n3jb23jkb2k3vb2hj3v41hj 13hj j23hbr j42hb j42hb jh43b rjh1hb 12jb 3jh4 b32 b24");
@@ -0,0 +1,20 @@
+@ok
+<?php
+
+const ROUTES = ['users.get', 'users.set', 'wall.post', 'Aa', 'BB'];
+const NUMERIC = ['10', '1e1', 'abc'];
+
+/**
+ * @param string $method
+ */
+function route($method) {
+  var_dump(in_array($method, ROUTES, true));
+  var_dump(in_array($method, ROUTES));
+  var_dump(in_array($method, ['users.get', 'photos.get' => 'photos.get', ''], true));
+  var_dump(in_array($method, NUMERIC));
+  var_dump(in_array($method, NUMERIC, true));
+}
+
+foreach (['users.get', 'wall.post', 'wall.pos', 'Aa', 'BB', 'AaBB', '', 'photos.get', '10', '1e1', '10.0', 'abc'] as $method) {
+  route($method);
+}
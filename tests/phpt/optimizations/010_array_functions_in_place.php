@@ -0,0 +1,51 @@
+@ok
+<?php
+#ifndef KPHP
+function array_filter_by_key($a, $callback) {
+  return array_filter($a, $callback, ARRAY_FILTER_USE_KEY);
+}
+#endif
+
+function filter_in_place() {
+  $a = [1, 0, 2, 0, 3];
+  $a = array_filter($a);
+  var_dump($a);
+
+  $b = ['x' => 1, 'y' => 2];
+  $b = array_filter($b, function($v) { return $v > 0; });
+  var_dump($b);
+
+  $keys = [5 => 'a', 'k' => 'b', 7 => 'c'];
+  $keys = array_filter_by_key($keys, function($k) { return is_int($k); });
+  var_dump($keys);
+}
+
+function map_in_place() {
+  $a = [1, 2, 3];
+  $copy = $a;
+  $a = array_map(function($x) { return $x * 2; }, $a);
+  var_dump($a);
+  var_dump($copy);
+
+  $m = ['a' => 'x', 5 => 'y'];
+  $m = array_map('strtoupper', $m);
+  var_dump($m);
+}
+
+function merge_in_place() {
+  $v = [1, 2];
+  $v = array_merge($v, [3, 'k' => 4]);
+  var_dump($v);
+
+  $m = [10 => 'a', 'key' => 'b'];
+  $m = array_merge($m, [20 => 'c']);
+  var_dump($m);
+
+  $single = [3 => 'x', 5 => 'y'];
+  $single = array_merge($single);
+  var_dump($single);
+}
+
+filter_in_place();
+map_in_place();
+merge_in_place();
@@ -0,0 +1,37 @@
+@ok
+<?php
+#ifndef KPHP
+function array_filter_by_key($a, $callback) {
+  return array_filter($a, $callback, ARRAY_FILTER_USE_KEY);
+}
+#endif
+
+function test_pipelines() {
+  $ints = [3 => 1, 5 => 0, 'k' => 2, 7 => -3];
+  $strings = ['a' => 'x', 'b' => '', 4 => '0', 6 => '1.5'];
+
+  var_dump(count(array_filter($ints)));
+  var_dump(count(array_filter($ints, function($x) { return $x > 0; })));
+  var_dump(count(array_filter_by_key($ints, function($k) { return is_int($k); })));
+
+  var_dump(array_sum(array_filter($ints)));
+  var_dump(array_sum(array_filter($strings)));
+  var_dump(array_sum(array_filter($ints, function($x) { return $x < 2; })));
+  var_dump(array_sum(array_filter_by_key($ints, function($k) { return is_string($k); })));
+  var_dump(array_sum(array_map(function($x) { return $x * 2; }, $ints)));
+  var_dump(array_sum(array_map(function($x) { return $x / 2; }, $ints)));
+
+  var_dump(array_values(array_filter($strings)));
+  var_dump(array_values(array_filter($ints, function($x) { return $x != 0; })));
+  var_dump(array_values(array_filter_by_key($strings, function($k) { return is_int($k); })));
+  var_dump(array_values(array_map('strtoupper', $strings)));
+
+  var_dump(array_keys(array_filter($strings)));
+  var_dump(array_keys(array_filter($ints, function($x) { return $x > 0; })));
+  var_dump(array_keys(array_filter_by_key($ints, function($k) { return is_int($k); })));
+
+  var_dump(count(array_filter([])));
+  var_dump(array_keys(array_map(function($x) { echo $x, "\n"; return $x; }, $ints)));
+}
+
+test_pipelines();
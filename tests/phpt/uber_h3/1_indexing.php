@@ -59,7 +59,24 @@ function test_h3ToGeoBoundary() {
   assert_lat_lon($boundary[5], tuple(-1.8554926185477, -0.13368891259165));
 }
 
+function test_batches() {
+  $coordinates = [tuple(0.0, 0.0), tuple(30.0, 50.0), tuple(70.0, 120.0), tuple(90.0, 90.0)];
+  $h3_indexes = \UberH3::geoToH3Batch($coordinates, 7);
+  assert_int_eq3(count($h3_indexes), 4);
+  foreach ($coordinates as $i => $coordinate) {
+    assert_int_eq3($h3_indexes[$i], \UberH3::geoToH3($coordinate[0], $coordinate[1], 7));
+  }
+  assert_array_int_eq3(\UberH3::geoToH3Batch($coordinates, 16), [0, 0, 0, 0]);
+  assert_int_eq3(count(\UberH3::geoToH3Batch([], 7)), 0);
+
+  $centers = \UberH3::h3ToGeoBatch($h3_indexes);
+  assert_int_eq3(count($centers), 4);
+  foreach ($h3_indexes as $i => $h3_index) {
+    assert_lat_lon($centers[$i], \UberH3::h3ToGeo($h3_index));
+  }
+}
 
 test_geoToH3();
 test_h3ToGeo();
 test_h3ToGeoBoundary();
+test_batches();
@@ -18,6 +18,23 @@ function test_kRing() {
   ]);
 }
 
+function test_kRings() {
+  assert_true(\UberH3::kRings([603537747495354367], -1) === false);
+  assert_array_int_eq3(\UberH3::kRings([], 1), []);
+
+  $neighbors = [
+    603537747495354367,
+    603537753803587583,
+    603537753266716671,
+    603537746958483455,
+    603537746690047999,
+    603537747226918911,
+    603537751387668479
+  ];
+  assert_array_int_eq3(\UberH3::kRings([603537747495354367], 1), $neighbors);
+  assert_array_int_eq3(\UberH3::kRings([603537747495354367, 603537747495354367], 1), array_merge($neighbors, $neighbors));
+}
+
 function test_maxKringSize() {
   assert_int_eq3(\UberH3::maxKringSize(-1),0);
 
@@ -154,6 +171,7 @@ function test_h3Distance() {
 }
 
 test_kRing();
+test_kRings();
 test_maxKringSize();
 test_kRingDistances();
 test_hexRange();
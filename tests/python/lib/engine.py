@@ -57,6 +57,13 @@ class Engine:
         """
         return self._rpc_port
 
+    @property
+    def process(self):
+        """
+        :return: psutil процесс движка
+        """
+        return self._engine_process
+
     @property
     def binlog_path(self):
         """
@@ -28,6 +28,13 @@ class KphpServer(Engine):
         if auto_start:
             self.start()
 
+    @property
+    def http_port(self):
+        """
+        :return: port listened by workers for http
+        """
+        return self._http_port
+
     @property
     def master_port(self):
         """
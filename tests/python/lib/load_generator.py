@@ -0,0 +1,299 @@
+import http.client
+import json
+import math
+import threading
+import time
+from queue import Queue
+
+import psutil
+
+from .colors import blue, red
+from .tl_client import send_rpc_request
+
+
+class LatencyRecorder:
+    """
+    Collects the latencies of the requests sent by the load generator
+    """
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._latencies = []
+        self._errors = 0
+
+    def add(self, latency, ok):
+        with self._lock:
+            self._latencies.append(latency)
+            if not ok:
+                self._errors += 1
+
+    @property
+    def count(self):
+        return len(self._latencies)
+
+    @property
+    def errors(self):
+        return self._errors
+
+    def percentile(self, p):
+        if not self._latencies:
+            return 0.0
+        latencies = sorted(self._latencies)
+        index = min(len(latencies) - 1, int(math.ceil(p / 100.0 * len(latencies))) - 1)
+        return latencies[max(index, 0)]
+
+    def to_dict(self):
+        return {
+            "p50": self.percentile(50),
+            "p90": self.percentile(90),
+            "p99": self.percentile(99),
+            "p999": self.percentile(99.9),
+            "max": max(self._latencies, default=0.0),
+            "mean": sum(self._latencies) / len(self._latencies) if self._latencies else 0.0,
+        }
+
+
+class ProcessSampler:
+    """
+    Samples the cpu time and the memory of the engine processes (master and workers) while the load is running
+    """
+
+    def __init__(self, process, period=0.5):
+        self._process = process
+        self._period = period
+        self._stop = threading.Event()
+        self._thread = None
+        self._start_cpu = None
+        self._finish_cpu = None
+        self._max_rss = 0
+
+    def _processes(self):
+        try:
+            return [self._process] + self._process.children(recursive=True)
+        except psutil.NoSuchProcess:
+            return []
+
+    def _cpu_times(self):
+        user, system = 0.0, 0.0
+        for proc in self._processes():
+            try:
+                times = proc.cpu_times()
+            except psutil.NoSuchProcess:
+                continue
+            user += times.user + times.children_user
+            system += times.system + times.children_system
+        return user, system
+
+    def _sample_memory(self):
+        rss = 0
+        for proc in self._processes():
+            try:
+                rss += proc.memory_info().rss
+            except psutil.NoSuchProcess:
+                continue
+        self._max_rss = max(self._max_rss, rss)
+
+    def _run(self):
+        while not self._stop.wait(self._period):
+            self._sample_memory()
+
+    def start(self):
+        self._start_cpu = self._cpu_times()
+        self._sample_memory()
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        self._stop.set()
+        self._thread.join()
+        self._sample_memory()
+        self._finish_cpu = self._cpu_times()
+
+    def to_dict(self, requests):
+        user = self._finish_cpu[0] - self._start_cpu[0]
+        system = self._finish_cpu[1] - self._start_cpu[1]
+        return {
+            "cpu": {
+                "user": user,
+                "system": system,
+                "per_request_ms": (user + system) * 1000.0 / requests if requests else 0.0,
+            },
+            "memory": {
+                "max_rss_bytes": self._max_rss,
+            },
+        }
+
+
+def run_open_loop(send, make_connection, rate, duration, concurrency):
+    """
+    Sends the requests with the fixed rate, independently of the responses (open loop).
+    The latency of a request is counted from the moment it had to be sent, so a server which doesn't keep up
+    gets the queueing time into its latency, instead of slowing the load down
+    :param send: Функция, которая отправляет один запрос в соединение и возвращает True в случае успеха
+    :param make_connection: Функция, которая создает соединение для одного потока нагрузки
+    :param rate: Количество запросов в секунду
+    :param duration: Длительность нагрузки в секундах
+    :param concurrency: Количество потоков, отправляющих запросы
+    :return: LatencyRecorder и фактическая длительность нагрузки
+    """
+    recorder = LatencyRecorder()
+    scheduled = Queue()
+
+    def sender():
+        connection = make_connection()
+        while True:
+            intended_time = scheduled.get()
+            if intended_time is None:
+                break
+            try:
+                ok = send(connection)
+            except Exception:
+                ok = False
+                connection = make_connection()
+            recorder.add(time.monotonic() - intended_time, ok)
+
+    threads = [threading.Thread(target=sender, daemon=True) for _ in range(concurrency)]
+    for thread in threads:
+        thread.start()
+
+    start = time.monotonic()
+    for i in range(int(rate * duration)):
+        intended_time = start + i / rate
+        delay = intended_time - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        scheduled.put(intended_time)
+
+    for _ in threads:
+        scheduled.put(None)
+    for thread in threads:
+        thread.join()
+    return recorder, time.monotonic() - start
+
+
+class LoadGenerator:
+    """
+    Runs a sustained load against a kphp server and collects a report:
+    the latency distribution, the throughput, the cpu and the memory of the server processes and its stats
+    """
+
+    def __init__(self, kphp_server):
+        """
+        :param kphp_server: Запущенный KphpServer
+        """
+        self._kphp_server = kphp_server
+
+    def run_http(self, uri='/', method='GET', body=None, headers=None,
+                 rate=100, duration=10, concurrency=8, expected_status=200):
+        """
+        Нагрузить kphp сервер http запросами, каждый поток использует keep-alive соединение
+        :return: Словарь с отчетом
+        """
+        port = self._kphp_server.http_port
+
+        def make_connection():
+            return http.client.HTTPConnection('127.0.0.1', port, timeout=30)
+
+        def send(connection):
+            connection.request(method, uri, body=body, headers=headers or {})
+            response = connection.getresponse()
+            response.read()
+            return response.status == expected_status
+
+        return self._run("http {} {}".format(method, uri), send, make_connection, rate, duration, concurrency)
+
+    def run_rpc(self, request, rate=20, duration=10, concurrency=4):
+        """
+        Нагрузить kphp сервер rpc запросами.
+        Каждый запрос отправляется отдельным процессом tl-client, поэтому достижимый rate ограничен сотнями запросов в секунду
+        :return: Словарь с отчетом
+        """
+        port = self._kphp_server.rpc_port
+
+        def send(_):
+            send_rpc_request(request, port, verbose=False)
+            return True
+
+        return self._run("rpc {}".format(request[0]), send, lambda: None, rate, duration, concurrency)
+
+    def _run(self, name, send, make_connection, rate, duration, concurrency):
+        print("\nRunning load [{}]: rate={} duration={}s concurrency={}".format(blue(name), rate, duration, concurrency))
+        sampler = ProcessSampler(self._kphp_server.process)
+        sampler.start()
+        recorder, elapsed = run_open_loop(send, make_connection, rate, duration, concurrency)
+        sampler.stop()
+
+        report = {
+            "name": name,
+            "rate": rate,
+            "duration": elapsed,
+            "concurrency": concurrency,
+            "requests": recorder.count,
+            "errors": recorder.errors,
+            "throughput": recorder.count / elapsed if elapsed else 0.0,
+            "latency": recorder.to_dict(),
+            "stats": self._kphp_server.get_stats(prefix="kphp_server."),
+        }
+        report.update(sampler.to_dict(recorder.count))
+        print("Load report: {}".format(json.dumps({k: v for k, v in report.items() if k != "stats"}, indent=2)))
+        return report
+
+
+# the metrics which are compared with the baseline: (path in the report, True if the bigger value is worse)
+_COMPARED_METRICS = [
+    (("throughput",), False),
+    (("latency", "p50"), True),
+    (("latency", "p99"), True),
+    (("latency", "p999"), True),
+    (("cpu", "per_request_ms"), True),
+    (("memory", "max_rss_bytes"), True),
+]
+
+
+def _get_metric(report, path):
+    for key in path:
+        report = report[key]
+    return report
+
+
+def compare_with_baseline(report, baseline, tolerance=0.2):
+    """
+    Сравнить отчет нагрузки с сохраненным отчетом
+    :param report: Отчет текущего запуска
+    :param baseline: Отчет, с которым производится сравнение
+    :param tolerance: Допустимое относительное ухудшение метрики
+    :return: Список строк с описанием регрессий
+    """
+    regressions = []
+    if report["errors"] > baseline["errors"]:
+        regressions.append("errors: {} -> {}".format(baseline["errors"], report["errors"]))
+    for path, bigger_is_worse in _COMPARED_METRICS:
+        old = _get_metric(baseline, path)
+        new = _get_metric(report, path)
+        if not old:
+            continue
+        change = (new - old) / old
+        if (change if bigger_is_worse else -change) > tolerance:
+            regressions.append("{}: {:.6g} -> {:.6g} ({:+.1%})".format(".".join(path), old, new, change))
+    for regression in regressions:
+        print(red("Load regression [{}]: {}".format(report["name"], regression)))
+    return regressions
+
+
+def save_load_reports(path, reports):
+    """
+    Сохранить отчеты нагрузки, например, в качестве нового baseline
+    :param path: Путь до json файла
+    :param reports: Словарь отчетов по именам сценариев
+    """
+    with open(path, "w") as f:
+        json.dump(reports, f, indent=2, sort_keys=True)
+
+
+def load_load_reports(path):
+    """
+    :param path: Путь до json файла с отчетами
+    :return: Словарь отчетов по именам сценариев
+    """
+    with open(path) as f:
+        return json.load(f)
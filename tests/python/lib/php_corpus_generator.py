@@ -0,0 +1,198 @@
+import os
+import random
+
+
+class PhpCorpusGenerator:
+    """
+    Generates a synthetic php project which looks like a big real codebase for kphp2cpp:
+    thousands of classes implementing interfaces, long call chains between them and big const arrays
+    """
+
+    def __init__(self, classes=2000, classes_per_group=100, call_depth=30, const_arrays=20, const_array_size=2000, seed=1):
+        """
+        :param classes: Количество классов моделей
+        :param classes_per_group: Количество классов, которые вызываются из одной функции группы
+        :param call_depth: Глубина цепочек вызовов между классами
+        :param const_arrays: Количество больших константных массивов
+        :param const_array_size: Количество элементов в одном константном массиве
+        :param seed: Seed генератора, корпус с одинаковыми параметрами всегда одинаковый
+        """
+        self._classes = classes
+        self._classes_per_group = classes_per_group
+        self._call_depth = call_depth
+        self._const_arrays = const_arrays
+        self._const_array_size = const_array_size
+        self._random = random.Random(seed)
+
+    @property
+    def main_file_name(self):
+        return "index.php"
+
+    def generate(self, corpus_dir):
+        """
+        Записать корпус в директорию
+        :return: Путь до главного файла корпуса
+        """
+        for subdir in ("Models", "Consts", "Groups"):
+            os.makedirs(os.path.join(corpus_dir, "Corpus", subdir), exist_ok=True)
+
+        self._write(corpus_dir, "Corpus/Models/IModel.php", self._gen_interface())
+        for i in range(self._classes):
+            self._write(corpus_dir, "Corpus/Models/Model{}.php".format(i), self._gen_model(i))
+        for i in range(self._const_arrays):
+            self._write(corpus_dir, "Corpus/Consts/Table{}.php".format(i), self._gen_const_table(i))
+        groups = (self._classes + self._classes_per_group - 1) // self._classes_per_group
+        for i in range(groups):
+            self._write(corpus_dir, "Corpus/Groups/Group{}.php".format(i), self._gen_group(i))
+        return self._write(corpus_dir, self.main_file_name, self._gen_main(groups))
+
+    def touch_model(self, corpus_dir, index=0):
+        """
+        Изменить тело одного класса, чтобы замерить инкрементальную сборку
+        """
+        path = os.path.join(corpus_dir, "Corpus/Models/Model{}.php".format(index))
+        with open(path) as f:
+            content = f.read()
+        with open(path, "w") as f:
+            f.write(content.replace("$this->counter += 1;", "$this->counter += 2;", 1))
+
+    @staticmethod
+    def _write(corpus_dir, rel_path, content):
+        path = os.path.join(corpus_dir, rel_path)
+        with open(path, "w") as f:
+            f.write(content)
+        return path
+
+    @staticmethod
+    def _gen_interface():
+        return """<?php
+
+namespace Corpus\\Models;
+
+interface IModel {
+  public function getName(): string;
+
+  /** @param int[] $values */
+  public function process(array $values, int $depth): int;
+
+  /** @return mixed[] */
+  public function toArray(): array;
+}
+"""
+
+    def _gen_model(self, i):
+        # the models form call chains of call_depth length: Model(i) calls Model(i + 1) unless it ends a chain
+        next_call = ""
+        if (i + 1) % self._call_depth and i + 1 < self._classes:
+            next_call = "    $result += (new Model{})->process($filtered, $depth + 1);\n".format(i + 1)
+        table = self._random.randrange(self._const_arrays) if self._const_arrays else None
+        table_lookup = ""
+        if table is not None:
+            table_lookup = "    $result += (int)(\\Corpus\\Consts\\Table{t}::VALUES[$depth % {n}] ?? 0);\n".format(
+                t=table, n=self._const_array_size)
+        return """<?php
+
+namespace Corpus\\Models;
+
+class Model{i} implements IModel {{
+  /** @var int */
+  public $counter = 0;
+  /** @var string */
+  public $name = "model{i}";
+  /** @var ?Model{i} */
+  public $parent = null;
+  /** @var float[] */
+  public $weights = [{w1}, {w2}, {w3}];
+
+  public function getName(): string {{
+    return $this->name . "#" . $this->counter;
+  }}
+
+  /** @param int[] $values */
+  public function process(array $values, int $depth): int {{
+    $this->counter += 1;
+    $filtered = array_filter($values, function(int $v) use ($depth) {{ return ($v + $depth) % {m} != 0; }});
+    $result = count($filtered);
+    foreach ($filtered as $k => $v) {{
+      $result += $k * $v + (int)($this->weights[$k % 3] * $v);
+    }}
+{table_lookup}{next_call}    return $result;
+  }}
+
+  /** @return mixed[] */
+  public function toArray(): array {{
+    return ["name" => $this->getName(), "counter" => $this->counter, "weights" => $this->weights];
+  }}
+
+  public static function create(string $name): self {{
+    $model = new self;
+    $model->name = $name;
+    return $model;
+  }}
+}}
+""".format(i=i, w1=self._random.random(), w2=self._random.random(), w3=self._random.random(),
+           m=self._random.randint(2, 7), table_lookup=table_lookup, next_call=next_call)
+
+    def _gen_const_table(self, i):
+        items = []
+        for j in range(self._const_array_size):
+            if j % 3 == 0:
+                items.append("    {} => {},".format(j, self._random.randint(0, 1 << 30)))
+            elif j % 3 == 1:
+                items.append("    {} => {},".format(j, self._random.random()))
+            else:
+                items.append("    {} => [\"id\" => {}, \"tag\" => \"t{}\"],".format(j, j, self._random.randint(0, 1000)))
+        return """<?php
+
+namespace Corpus\\Consts;
+
+class Table{i} {{
+  const VALUES = [
+{items}
+  ];
+}}
+""".format(i=i, items="\n".join(items))
+
+    def _gen_group(self, i):
+        first = i * self._classes_per_group
+        last = min(first + self._classes_per_group, self._classes)
+        calls = "\n".join(
+            "    $models[] = \\Corpus\\Models\\Model{j}::create(\"m{j}\");".format(j=j) for j in range(first, last))
+        return """<?php
+
+namespace Corpus\\Groups;
+
+class Group{i} {{
+  /** @return \\Corpus\\Models\\IModel[] */
+  public static function createModels(): array {{
+    $models = [];
+{calls}
+    return $models;
+  }}
+
+  /** @param int[] $values */
+  public static function run(array $values): int {{
+    $result = 0;
+    foreach (self::createModels() as $model) {{
+      $result += $model->process($values, 0);
+      $result += count($model->toArray());
+    }}
+    return $result;
+  }}
+}}
+""".format(i=i, calls=calls)
+
+    @staticmethod
+    def _gen_main(groups):
+        calls = "\n".join("$result += \\Corpus\\Groups\\Group{}::run($values);".format(i) for i in range(groups))
+        return """<?php
+
+$values = [];
+for ($i = 0; $i < 16; ++$i) {{
+  $values[] = $i * 7 + 1;
+}}
+
+$result = 0;
+{calls}
+echo $result, "\\n";
+""".format(calls=calls)
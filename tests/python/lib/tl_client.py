@@ -28,11 +28,12 @@ def _tl_serialize_struct(request):
     return " ".join(encoded)
 
 
-def send_rpc_request(request, port):
+def send_rpc_request(request, port, verbose=True):
     tl_client_bin = search_tl_client()
     encoded_request = _tl_serialize_struct(request)
 
-    print("\nSending rpc request to port {}: {}".format(port, blue(encoded_request)))
+    if verbose:
+        print("\nSending rpc request to port {}: {}".format(port, blue(encoded_request)))
     cmd = [tl_client_bin, "--stdin", "--json-encoded", "--port", str(port)]
     if not os.getuid():
         cmd += ["--user", "root", "--group", "root"]
@@ -52,5 +53,6 @@ def send_rpc_request(request, port):
     stdout_data = stdout_data.strip().decode()
     if stdout_data == "Can't serialize":
         raise RuntimeError("Can't serialize request")
-    print("\nGot rpc response: {}".format(green(stdout_data)))
+    if verbose:
+        print("\nGot rpc response: {}".format(green(stdout_data)))
     return json.loads(stdout_data)
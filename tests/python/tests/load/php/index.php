@@ -0,0 +1,11 @@
+<?php
+
+if ($_SERVER["PHP_SELF"] === "/json") {
+  $items = [];
+  for ($i = 0; $i < 100; ++$i) {
+    $items[] = ["id" => $i, "name" => "item $i", "rating" => $i / 7, "tags" => ["a", "b", $i]];
+  }
+  echo json_encode($items);
+} else {
+  echo "Hello world!";
+}
@@ -0,0 +1,56 @@
+import os
+
+import pytest
+
+from python.lib.testcase import KphpServerAutoTestCase
+from python.lib.load_generator import LoadGenerator, compare_with_baseline, save_load_reports, load_load_reports
+
+# the load tests take minutes and their numbers depend on the machine, so they are run on demand:
+#   KPHP_LOAD_TESTS=1 - run them
+#   KPHP_LOAD_BASELINE=<path> - compare the results with the reports saved there, or save them there if the file doesn't exist
+#   KPHP_LOAD_TOLERANCE=<ratio> - allowed relative degradation of a metric, 0.2 by default
+_LOAD_DURATION = int(os.environ.get("KPHP_LOAD_DURATION", 30))
+
+
+@pytest.mark.skipif(not os.environ.get("KPHP_LOAD_TESTS"), reason="KPHP_LOAD_TESTS is not set")
+class TestLoad(KphpServerAutoTestCase):
+    reports = {}
+
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": 4
+        })
+
+    @classmethod
+    def extra_class_teardown(cls):
+        baseline_path = os.environ.get("KPHP_LOAD_BASELINE")
+        if baseline_path and not os.path.exists(baseline_path):
+            save_load_reports(baseline_path, cls.reports)
+        save_load_reports(os.path.join(cls.artifacts_dir, "load_reports.json"), cls.reports)
+
+    def _check_report(self, report):
+        self.assertEqual(report["errors"], 0)
+        self.assertGreater(report["throughput"], report["rate"] * 0.9)
+        self.reports[report["name"]] = report
+
+        baseline_path = os.environ.get("KPHP_LOAD_BASELINE")
+        if baseline_path and os.path.exists(baseline_path):
+            baseline = load_load_reports(baseline_path).get(report["name"])
+            if baseline:
+                tolerance = float(os.environ.get("KPHP_LOAD_TOLERANCE", 0.2))
+                self.assertEqual(compare_with_baseline(report, baseline, tolerance), [])
+
+    def test_http_hello_world(self):
+        report = LoadGenerator(self.kphp_server).run_http("/", rate=1000, duration=_LOAD_DURATION, concurrency=16)
+        self._check_report(report)
+        self.assertKphpNoTerminatedRequests()
+
+    def test_http_json(self):
+        report = LoadGenerator(self.kphp_server).run_http("/json", rate=500, duration=_LOAD_DURATION, concurrency=16)
+        self._check_report(report)
+        self.assertKphpNoTerminatedRequests()
+
+    def test_rpc_engine_pid(self):
+        report = LoadGenerator(self.kphp_server).run_rpc(("engine.pid", []), rate=50, duration=_LOAD_DURATION, concurrency=4)
+        self._check_report(report)
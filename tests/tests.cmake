@@ -16,3 +16,15 @@ if(KPHP_TESTS)
     include(tests/cpp/runtime/runtime-tests.cmake)
     include(tests/cpp/server/server-tests.cmake)
 endif()
+
+if(KPHP_BENCHMARKS)
+    include(tests/cpp/runtime/benchmarks/runtime-benchmarks.cmake)
+
+    # compiles a generated php project, the json report contains the time of the compiler pipes and the peak memory
+    add_custom_target(run-kphp-compile-bench
+                      COMMAND python3 ${BASE_DIR}/tests/kphp_compile_benchmark.py
+                              -d ${CMAKE_BINARY_DIR}/kphp-compile-bench -o ${CMAKE_BINARY_DIR}/kphp-compile-bench.json
+                      DEPENDS kphp
+                      WORKING_DIRECTORY ${BASE_DIR}/tests
+                      USES_TERMINAL)
+endif()
@@ -6,6 +6,8 @@
 
 #include <stdbool.h>
 
+#include "common/string-kernels.h"
+
 #include "vkext/vkext.h"
 
 static void json_escape_string(const char *s, size_t len);
@@ -118,6 +120,12 @@ static void json_escape_string(const char *s, size_t len) {
   write_buff_char('"');
 
   for (size_t pos = 0; pos < len; pos++) {
+    const size_t unescaped_len = json_unescaped_prefix_length(s + pos, len - pos);
+    write_buff(s + pos, static_cast<int>(unescaped_len));
+    pos += unescaped_len;
+    if (pos == len) {
+      break;
+    }
     char c = s[pos];
     switch (c) {
       case '"':
@@ -198,6 +198,18 @@ static inline struct rpc_buffer *buffer_create_data(void *data, int len) {
   return buf;
 }
 
+// the answers are parsed one after another, the buffer struct is reused for each of them
+static inline struct rpc_buffer *buffer_replace_data(struct rpc_buffer *buf, void *data, int len) UNUSED;
+static inline struct rpc_buffer *buffer_replace_data(struct rpc_buffer *buf, void *data, int len) {
+  if (!buf) {
+    return buffer_create_data(data, len);
+  }
+  zzefree(buf->sptr, buf->eptr - buf->sptr);
+  buf->rptr = buf->sptr = static_cast<char *>(data);
+  buf->wptr = buf->eptr = buf->sptr + len;
+  return buf;
+}
+
 static inline void buffer_check_len_wptr(struct rpc_buffer *buf, int x) UNUSED;
 static inline void buffer_check_len_wptr(struct rpc_buffer *buf, int x) {
   if (buf->wptr + x > buf->eptr) {
@@ -8,6 +8,7 @@
 
 #include "vkext/vkext-rpc.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <fcntl.h>
 #include <netdb.h>
@@ -43,6 +44,9 @@ int *server_fds_tmp = 0;
 
 struct rpc_buffer *inbuf = 0;
 struct rpc_buffer *outbuf = 0;
+// outbuf lives in the request memory, so it is created at the size reached by the previous request instead of growing again
+static int outbuf_start_len = 0;
+static const int OUTBUF_MAX_START_LEN = 1 << 20;
 
 char *global_error = 0;
 int global_errnum = 0;
@@ -2497,12 +2501,9 @@ int do_rpc_get_and_parse(long long qid, double timeout) { /* {{{ */
     END_TIMER (rpc_get_and_parse);
     return -1;
   } else {
-    if (inbuf) {
-      inbuf = buffer_delete(inbuf);
-    }
     //struct rpc_query *q = rpc_query_get (qid);
     assert (q);
-    inbuf = buffer_create_data(q->answer, q->answer_len);
+    inbuf = buffer_replace_data(inbuf, q->answer, q->answer_len);
     rpc_query_delete_nobuf(q);
     END_TIMER (rpc_get_and_parse);
     return 1;
@@ -2545,10 +2546,7 @@ int do_rpc_get(long long qid, double timeout, char **value) { /* {{{ */
 void do_rpc_parse(const char *s, int len) { /* {{{ */
   char *ans = static_cast<char *>(zzemalloc(len));
   memcpy(ans, s, len);
-  if (inbuf) {
-    inbuf = buffer_delete(inbuf);
-  }
-  inbuf = buffer_create_data(ans, len);
+  inbuf = buffer_replace_data(inbuf, ans, len);
 }
 
 /* }}} */
@@ -3424,7 +3422,7 @@ void rpc_on_rinit(int module_number) { /* {{{ */
   if (outbuf) {
     outbuf = buffer_delete(outbuf);
   }
-  outbuf = buffer_create(0);
+  outbuf = buffer_create(outbuf_start_len);
   first_qid = last_qid;
   max_query_id = 0;
   int i;
@@ -3470,6 +3468,7 @@ void rpc_on_rshutdown(int module_number) { /* {{{ */
     inbuf = buffer_delete(inbuf);
   }
   if (outbuf) {
+    outbuf_start_len = std::min(static_cast<int>(outbuf->eptr - outbuf->sptr), OUTBUF_MAX_START_LEN);
     outbuf = buffer_delete(outbuf);
   }
   //tree_act_query (query_tree, rpc_query_free);
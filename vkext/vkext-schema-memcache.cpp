@@ -117,6 +117,8 @@ struct tl_config {
   struct hash_table_tl_fun_id *ht_fid;
   struct hash_table_tl_type_name *ht_tname;
   struct hash_table_tl_type_id *ht_tid;
+  // resolved once the config is read, as it wraps the result of every stored function
+  struct tl_type *req_result_type;
   int working_queries;
 };
 
@@ -1045,7 +1047,7 @@ struct tl_tree *store_function(VK_ZVAL_API_P arr) {
     T->self.flags = 0;
     T->self.ref_cnt = 1;
     T->self.methods = &tl_type_methods;
-    T->type = tl_type_get_by_id("ReqResult");
+    T->type = cur_config->req_result_type;
     T->children_num = 1;
     T->children = reinterpret_cast<tl_tree **>(zzemalloc(sizeof(*T->children)));
     *T->children = reinterpret_cast<tl_tree *>(res);
@@ -1824,14 +1826,8 @@ void *tlcomb_store_type(void **IP, void **Data, zval **arr, struct tl_tree **var
   int n = -1;
   if (t->constructors_num > 1) {
     if (t->name == TYPE_NAME_MAYBE && Z_TYPE_P(*arr) != IS_ARRAY) {
-      // hack for getting name of maybe constructor in typed mode
-      const char *ctor_name;
-      if (Z_TYPE_P(*arr) == IS_NULL) {
-        ctor_name = "resultFalse";
-      } else {
-        ctor_name = "resultTrue";
-      }
-      n = get_constructor(t, ctor_name);
+      // hack for getting maybe constructor in typed mode
+      n = get_constructor_by_name(t, Z_TYPE_P(*arr) == IS_NULL ? TL_MAYBE_FALSE : TL_MAYBE_TRUE);
     } else {
       // IN PHP5 v == &dst => lifetime is limited by scope of this function
       zval *dst;
@@ -5219,6 +5215,7 @@ int renew_tl_config(const char *name) {
       return -2;
     }
   }
+  cur_config->req_result_type = tl_type_get_by_id("ReqResult");
 
   if (name != tl_config_name) {
     if (tl_config_name) {
@@ -31,6 +31,8 @@ endfunction()
 prepend(VKEXT_COMMON_SOURCES ${COMMON_DIR}/
         crc32.cpp
         crc32_x86_64.cpp
+        string-kernels.cpp
+        string-kernels_x86_64.cpp
         string-processing.cpp
         unicode/utf8-utils.cpp
         cpuid.cpp
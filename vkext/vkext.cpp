@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "common/string-kernels.h"
 #include "common/version-string.h"
 
 #include "vkext/vkext-errors.h"
@@ -359,6 +360,15 @@ int utf8_to_win(const char *s, int len, int max_len, int exit_on_error) {
       }
       write_buff_char(c);
       st = 0;
+      // the ascii chars after it are copied at once
+      int ascii_len = static_cast<int>(ascii_prefix_length(s + i + 1, len - i - 1));
+      if (max_len) {
+        ascii_len = min (ascii_len, max_len + 1 - cur_buff_len);
+      }
+      if (ascii_len > 0) {
+        write_buff(s + i + 1, ascii_len);
+        i += ascii_len;
+      }
       continue;
     }
     if ((c & 0xc0) == 0x80) {
@@ -518,6 +528,13 @@ int win_to_utf8(const char *s, int len) {
     if (state == 3) {
       state = 0;
     }
+    if (state == 0 && (unsigned char)(s[i]) < 0x80) {
+      // the ascii chars up to the next entity are copied at once
+      size_t ascii_len = ascii_prefix_length(s + i + 1, len - i - 1);
+      ascii_len = find_first_of_chars(s + i + 1, ascii_len, "&", 1);
+      write_buff(s + i + 1, static_cast<int>(ascii_len));
+      i += static_cast<int>(ascii_len);
+    }
   }
   return cur_buff_len;
 }